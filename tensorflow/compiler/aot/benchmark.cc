@@ -109,6 +109,25 @@ void DumpStatsToStdout(const Stats& stats) {
   }
 }
 
+double ItemsPerSecond(const Stats& stats, int64 items_per_iter) {
+  if (stats.total_us <= 0) {
+    return 0;
+  }
+  return 1e6 * items_per_iter * stats.per_iter_us.size() / stats.total_us;
+}
+
+void DumpThroughputToStdout(const Stats& stats, int64 items_per_iter,
+                            int num_threads) {
+  const double mean_us =
+      stats.per_iter_us.empty()
+          ? 0
+          : static_cast<double>(stats.total_us) / stats.per_iter_us.size();
+  // NOLINTNEXTLINE
+  printf("  batch %5lld  threads %3d: %12.3f us/iter %14.1f items/s\n",
+         static_cast<long long>(items_per_iter), num_threads,  // NOLINT
+         mean_us, ItemsPerSecond(stats, items_per_iter));
+}
+
 void Benchmark(const Options& options, const BenchmarkFn& fn, Stats* stats) {
   // If neither max_seconds or max_iters is set, stop at kDefaultMicros.
   const int64 max_us = (options.max_micros <= 0 && options.max_iters <= 0)
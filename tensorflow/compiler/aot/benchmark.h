@@ -56,6 +56,15 @@ struct Stats {
 // form.
 void DumpStatsToStdout(const Stats& stats);
 
+// ItemsPerSecond returns the throughput of a benchmark which processed
+// `items_per_iter` items, e.g. the batch size, in each iteration.
+double ItemsPerSecond(const Stats& stats, int64 items_per_iter);
+
+// DumpThroughputToStdout printfs to stdout a one-line summary of stats for a
+// benchmark of `items_per_iter` items per iteration on `num_threads` threads.
+void DumpThroughputToStdout(const Stats& stats, int64 items_per_iter,
+                            int num_threads);
+
 // BenchmarkFn is the signature of the function generated by tfcompile.
 typedef std::function<void()> BenchmarkFn;
 
@@ -40,6 +40,16 @@ TEST(Benchmark, Benchmark) {
   EXPECT_EQ(stats5.per_iter_us.size(), 5);
 }
 
+TEST(Benchmark, ItemsPerSecond) {
+  Stats stats;
+  stats.per_iter_us = {500000, 500000, 1000000};
+  stats.total_us = 2000000;
+  EXPECT_DOUBLE_EQ(ItemsPerSecond(stats, 8), 12);
+
+  Stats empty;
+  EXPECT_DOUBLE_EQ(ItemsPerSecond(empty, 8), 0);
+}
+
 }  // namespace
 }  // namespace benchmark
 }  // namespace tfcompile
@@ -730,6 +730,164 @@ class {{CLASS}} final : public tensorflow::XlaCompiledCpuFunction {
   return Status::OK();
 }
 
+CodegenOpts BatchVariantCodegenOpts(const CodegenOpts& opts, int64 batch_size) {
+  CodegenOpts variant_opts = opts;
+  absl::StrAppend(&variant_opts.class_name, "Batch", batch_size);
+  return variant_opts;
+}
+
+Status GenerateBatchedHeader(const CodegenOpts& opts, const string& entry_point,
+                             absl::Span<const BatchVariant> variants,
+                             string* header) {
+  if (variants.empty()) {
+    return errors::InvalidArgument("no batch sizes to generate a header for");
+  }
+  // Each variant header is self-contained, with its own header guard, so they
+  // are simply concatenated ahead of the dispatching class.
+  string variant_headers;
+  std::vector<int64> batch_sizes;
+  string dispatch;
+  for (const BatchVariant& variant : variants) {
+    if (!batch_sizes.empty() && variant.batch_size <= batch_sizes.back()) {
+      return errors::InvalidArgument(
+          "batch sizes must be increasing, got ", variant.batch_size,
+          " after ", batch_sizes.back());
+    }
+    batch_sizes.push_back(variant.batch_size);
+    const CodegenOpts variant_opts =
+        BatchVariantCodegenOpts(opts, variant.batch_size);
+    string variant_header;
+    TF_RETURN_IF_ERROR(GenerateHeader(variant_opts, variant.config,
+                                      variant.compile_result,
+                                      variant.metadata_result,
+                                      &variant_header));
+    absl::StrAppend(&variant_headers, variant_header, "\n");
+    absl::StrAppend(&dispatch, "    if (batch_size <= ", variant.batch_size,
+                    ") {\n      return &", variant_opts.class_name,
+                    "::StaticData();\n    }\n");
+  }
+
+  string ns_start;
+  for (const string& n : opts.namespaces) {
+    ns_start += absl::StrCat("namespace ", n, " {\n");
+  }
+  ns_start += "\n";
+  string ns_end("\n");
+  for (int i = opts.namespaces.size() - 1; i >= 0; --i) {
+    const string& n = opts.namespaces[i];
+    ns_end += absl::StrCat("}  // end namespace ", n, "\n");
+  }
+
+  // With a thread pool, the dispatching class owns it and passes it to each
+  // instance it creates, so the header needs the Eigen thread pool types.
+  string thread_pool_includes;
+  string thread_pool_members;
+  string set_thread_pool;
+  if (opts.thread_pool_size > 0) {
+    thread_pool_includes = R"(
+#ifndef EIGEN_USE_THREADS
+#define EIGEN_USE_THREADS
+#endif
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+)";
+    thread_pool_members = absl::StrCat(
+        R"(
+  // Number of threads of the pool the instances returned by Create run on.
+  static constexpr int kThreadPoolSize = )",
+        opts.thread_pool_size, R"(;
+
+  // Returns the pool the instances returned by Create run on, which is created
+  // on first use and shared by all of them.
+  static const Eigen::ThreadPoolDevice* ThreadPool() {
+    static Eigen::ThreadPool* pool = new Eigen::ThreadPool(kThreadPoolSize);
+    static Eigen::ThreadPoolDevice* device =
+        new Eigen::ThreadPoolDevice(pool, kThreadPoolSize);
+    return device;
+  }
+)");
+    set_thread_pool = "    function->set_thread_pool(ThreadPool());\n";
+  }
+
+  string dispatcher =
+      R"(// clang-format off
+
+#ifndef TFCOMPILE_GENERATED_{{ENTRY}}_H_  // NOLINT(build/header_guard)
+#define TFCOMPILE_GENERATED_{{ENTRY}}_H_  // NOLINT(build/header_guard)
+
+#include <memory>
+{{THREAD_POOL_INCLUDES}}
+{{NS_START}}
+// {{CLASS}} dispatches to the variants of a computation previously specified
+// in a TensorFlow graph, compiled for batch sizes {{BATCH_SIZES}}.  The
+// {{CLASS}}Batch<N> class above is the variant for batch size N.  Usage
+// example:
+//
+//   std::unique_ptr<tensorflow::XlaCompiledCpuFunction> computation =
+//       {{CLASS}}::Create(batch_size);
+//   // ...set args using computation->arg_data(N), padded up to the batch size
+//   // of the variant
+//   CHECK(computation->Run());
+//   // ...inspect results using computation->result_data(N)
+class {{CLASS}} final {
+ public:
+  // Number of batch sizes the computation was compiled for.
+  static constexpr size_t kNumBatchSizes = {{NUM_BATCH_SIZES}};
+
+  // The batch sizes the computation was compiled for, in increasing order.
+  static const ::tensorflow::int64* BatchSizes() {
+    static constexpr ::tensorflow::int64 kBatchSizes[kNumBatchSizes] = {
+      {{BATCH_SIZES}}
+    };
+    return kBatchSizes;
+  }
+{{THREAD_POOL_MEMBERS}}
+  // Returns the static data of the variant compiled for the smallest batch
+  // size which is at least `batch_size`, or nullptr if `batch_size` is larger
+  // than all of them.
+  static const tensorflow::XlaCompiledCpuFunction::StaticData*
+  StaticDataForBatchSize(::tensorflow::int64 batch_size) {
+{{DISPATCH}}    return nullptr;
+  }
+
+  // Returns a new instance of the variant picked by StaticDataForBatchSize, or
+  // nullptr if there is none.
+  static std::unique_ptr<tensorflow::XlaCompiledCpuFunction> Create(
+      ::tensorflow::int64 batch_size,
+      tensorflow::XlaCompiledCpuFunction::AllocMode alloc_mode =
+          tensorflow::XlaCompiledCpuFunction::AllocMode::
+              ARGS_VARIABLES_RESULTS_PROFILES_AND_TEMPS) {
+    const tensorflow::XlaCompiledCpuFunction::StaticData* static_data =
+        StaticDataForBatchSize(batch_size);
+    if (static_data == nullptr) {
+      return nullptr;
+    }
+    std::unique_ptr<tensorflow::XlaCompiledCpuFunction> function(
+        new tensorflow::XlaCompiledCpuFunction(*static_data, alloc_mode));
+{{SET_THREAD_POOL}}    return function;
+  }
+};
+{{NS_END}}
+
+#endif  // TFCOMPILE_GENERATED_{{ENTRY}}_H_
+
+// clang-format on
+)";
+  const std::vector<std::pair<string, string>> rewrites = {
+      {"{{BATCH_SIZES}}", absl::StrJoin(batch_sizes, ", ")},
+      {"{{CLASS}}", opts.class_name},
+      {"{{DISPATCH}}", dispatch},
+      {"{{ENTRY}}", entry_point},
+      {"{{NS_END}}\n", ns_end},
+      {"{{NS_START}}\n", ns_start},
+      {"{{NUM_BATCH_SIZES}}", absl::StrCat(batch_sizes.size())},
+      {"{{SET_THREAD_POOL}}", set_thread_pool},
+      {"{{THREAD_POOL_INCLUDES}}", thread_pool_includes},
+      {"{{THREAD_POOL_MEMBERS}}", thread_pool_members}};
+  absl::StrReplaceAll(rewrites, &dispatcher);
+  *header = absl::StrCat(variant_headers, dispatcher);
+  return Status::OK();
+}
+
 static string CreateUniqueIdentifier(const CodegenOpts& opts,
                                      absl::string_view suffix) {
   string result = "__tfcompile";
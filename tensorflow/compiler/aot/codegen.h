@@ -20,6 +20,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tensorflow/compiler/aot/compile.h"
 #include "tensorflow/compiler/tf2xla/tf2xla.pb.h"
 
@@ -48,6 +49,11 @@ struct CodegenOpts {
   // If true, emit a serialized HloProfilePrinterData protobuf that can be used
   // to pretty print HLO profile counters.
   bool gen_hlo_profile_printer_data = false;
+
+  // If greater than 0, the dispatching class generated by
+  // GenerateBatchedHeader owns a thread pool of this many threads, which the
+  // instances it creates run on.
+  int thread_pool_size = 0;
 };
 
 // Describes a generated metadata object file.
@@ -87,6 +93,35 @@ Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
                       const CompileResult& compile_result,
                       const MetadataResult& metadata_result, string* header);
 
+// Describes the compilation of the graph for one of several batch sizes.
+struct BatchVariant {
+  int64 batch_size = 0;
+
+  // The config the variant was compiled with, whose batched feeds have a
+  // leading dimension of batch_size.
+  tf2xla::Config config;
+
+  CompileResult compile_result;
+
+  // Obtained by a previous invocation of GenerateMetadata with the options
+  // returned by BatchVariantCodegenOpts.
+  MetadataResult metadata_result;
+};
+
+// Returns the code generation options for the variant compiled for
+// `batch_size`, whose class name has a Batch<batch_size> suffix.
+CodegenOpts BatchVariantCodegenOpts(const CodegenOpts& opts, int64 batch_size);
+
+// GenerateBatchedHeader generates a C++ header giving access to the functions
+// compiled for each of `variants`, which must be sorted by increasing batch
+// size.  The header holds the class GenerateHeader generates for each variant,
+// and a class named opts.class_name that dispatches a batch size to the
+// variant compiled for the smallest batch size that holds it.  `entry_point`
+// names the header guard.
+Status GenerateBatchedHeader(const CodegenOpts& opts, const string& entry_point,
+                             absl::Span<const BatchVariant> variants,
+                             string* header);
+
 // ParseCppClass parses `cpp_class` into its `class_name` and `namespaces`
 // components.  The syntax is [[<optional_namespace>::],...]<class_name>.  This
 // mirrors the C++ syntax for referring to a class, where multiple namespaces
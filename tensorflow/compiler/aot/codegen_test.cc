@@ -20,6 +20,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "llvm/Support/TargetSelect.h"
 #include "tensorflow/compiler/xla/cpu_function_runtime.h"
@@ -264,6 +265,89 @@ TEST(CodegenTest, Golden) {
   CompareWithGoldenFile("tensorflow/compiler/aot/codegen_test_h.golden", header,
                         true);
 }
+
+// Returns a variant of a computation from f32[batch_size,2] to
+// (f32[batch_size]), as compiled for `batch_size`.
+BatchVariant MakeBatchVariant(int64 batch_size) {
+  BatchVariant variant;
+  variant.batch_size = batch_size;
+  tf2xla::Feed* feed = variant.config.add_feed();
+  feed->mutable_id()->set_node_name("feed0");
+  feed->mutable_shape()->add_dim()->set_size(batch_size);
+  feed->mutable_shape()->add_dim()->set_size(2);
+  variant.config.add_fetch()->mutable_id()->set_node_name("fetch0");
+  variant.compile_result.aot.reset(new xla::cpu::CpuAotCompilationResult(
+      {},
+      {BufferInfo::MakeEntryParameter(/*size=*/batch_size * 8,
+                                      /*param_number=*/0),
+       BufferInfo::MakeTempBuffer(batch_size * 4),
+       BufferInfo::MakeTempBuffer(8)},
+      2, {}));
+  variant.compile_result.program_shape =
+      xla::ShapeUtil::MakeProgramShape(
+          {xla::ShapeUtil::MakeShape(xla::F32, {batch_size, 2})},
+          xla::ShapeUtil::MakeTupleShape(
+              {xla::ShapeUtil::MakeShape(xla::F32, {batch_size})}))
+          .ToProto();
+  variant.compile_result.entry_point =
+      absl::StrCat("entry_point_batch", batch_size);
+  variant.compile_result.pointer_size = 8;
+  variant.metadata_result.program_shape_access_shim = "nullptr";
+  variant.metadata_result.hlo_profile_printer_data_access_shim = "nullptr";
+  return variant;
+}
+
+TEST(CodegenTest, BatchedHeader) {
+  CodegenOpts opts;
+  opts.class_name = "MyClass";
+  opts.namespaces = {"foo"};
+  std::vector<BatchVariant> variants;
+  variants.push_back(MakeBatchVariant(1));
+  variants.push_back(MakeBatchVariant(8));
+
+  string header;
+  TF_ASSERT_OK(GenerateBatchedHeader(opts, "entry_point", variants, &header));
+  EXPECT_TRUE(absl::StrContains(header, "class MyClassBatch1 final"));
+  EXPECT_TRUE(absl::StrContains(header, "class MyClassBatch8 final"));
+  EXPECT_TRUE(absl::StrContains(header, "class MyClass final"));
+  EXPECT_TRUE(absl::StrContains(header, "kNumBatchSizes = 2;"));
+  EXPECT_TRUE(absl::StrContains(header, "entry_point_batch8("));
+  EXPECT_TRUE(
+      absl::StrContains(header, "TFCOMPILE_GENERATED_entry_point_H_"));
+  // The smallest variant which holds the batch size is picked.
+  const size_t dispatch_1 = header.find(
+      "if (batch_size <= 1) {\n      return &MyClassBatch1::StaticData();");
+  const size_t dispatch_8 = header.find(
+      "if (batch_size <= 8) {\n      return &MyClassBatch8::StaticData();");
+  ASSERT_NE(dispatch_1, string::npos);
+  ASSERT_NE(dispatch_8, string::npos);
+  EXPECT_LT(dispatch_1, dispatch_8);
+  // Without a thread pool, the header does not include Eigen.
+  EXPECT_FALSE(absl::StrContains(header, "Eigen/CXX11/Tensor"));
+  EXPECT_FALSE(absl::StrContains(header, "ThreadPool()"));
+
+  std::reverse(variants.begin(), variants.end());
+  ExpectErrorContains(
+      GenerateBatchedHeader(opts, "entry_point", variants, &header),
+      "batch sizes must be increasing");
+}
+
+TEST(CodegenTest, BatchedHeaderWithThreadPool) {
+  CodegenOpts opts;
+  opts.class_name = "MyClass";
+  opts.thread_pool_size = 4;
+  std::vector<BatchVariant> variants;
+  variants.push_back(MakeBatchVariant(1));
+
+  string header;
+  TF_ASSERT_OK(GenerateBatchedHeader(opts, "entry_point", variants, &header));
+  EXPECT_TRUE(absl::StrContains(header, "Eigen/CXX11/Tensor\""));
+  EXPECT_TRUE(absl::StrContains(header, "kThreadPoolSize = 4;"));
+  EXPECT_TRUE(absl::StrContains(
+      header, "static const Eigen::ThreadPoolDevice* ThreadPool()"));
+  EXPECT_TRUE(
+      absl::StrContains(header, "function->set_thread_pool(ThreadPool());"));
+}
 }  // namespace
 }  // namespace tfcompile
 }  // namespace tensorflow
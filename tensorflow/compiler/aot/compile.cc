@@ -15,12 +15,17 @@ limitations under the License.
 
 #include "tensorflow/compiler/aot/compile.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/base/call_once.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "llvm-c/Target.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "tensorflow/compiler/aot/codegen.h"
@@ -147,6 +152,7 @@ Status CompileGraph(GraphDef graph_def, const tf2xla::Config& config,
       flags.target_triple, flags.target_cpu, flags.target_features,
       flags.entry_point,
       xla::cpu::CpuAotCompilationOptions::RelocationModel::BigPic);
+  aot_opts.set_parallelism(flags.num_threads);
 
   return CompileXla(client, computation, aot_opts, compile_result);
 }
@@ -206,6 +212,125 @@ static std::string InterpolateErrorMessage(std::string message) {
   return message;
 }
 
+// Parses the comma-separated `batch_sizes` flag into increasing batch sizes.
+static Status ParseBatchSizes(const string& batch_sizes,
+                              std::vector<int64>* result) {
+  result->clear();
+  if (batch_sizes.empty()) {
+    return Status::OK();
+  }
+  for (absl::string_view batch_size : absl::StrSplit(batch_sizes, ',')) {
+    int64 value;
+    if (!absl::SimpleAtoi(batch_size, &value) || value <= 0) {
+      return errors::InvalidArgument("Invalid batch size in --batch_sizes: '",
+                                     batch_size, "'");
+    }
+    result->push_back(value);
+  }
+  std::sort(result->begin(), result->end());
+  result->erase(std::unique(result->begin(), result->end()), result->end());
+  return Status::OK();
+}
+
+// Returns true if the leading dimension of `feed` is unknown, i.e. -1, which
+// marks it as batched.
+static bool IsBatchedFeed(const tf2xla::Feed& feed) {
+  return feed.shape().dim_size() > 0 && feed.shape().dim(0).size() == -1;
+}
+
+// Returns a copy of `config` where the leading dimension of each batched feed
+// is `batch_size`.
+static tf2xla::Config ConfigForBatchSize(const tf2xla::Config& config,
+                                         int64 batch_size) {
+  tf2xla::Config result = config;
+  for (tf2xla::Feed& feed : *result.mutable_feed()) {
+    if (IsBatchedFeed(feed)) {
+      feed.mutable_shape()->mutable_dim(0)->set_size(batch_size);
+    }
+  }
+  return result;
+}
+
+// Returns `file_name` with a _batch<batch_size> suffix inserted before its
+// extension, if any.
+static string BatchVariantFileName(const string& file_name, int64 batch_size) {
+  const string suffix = absl::StrCat("_batch", batch_size);
+  const size_t dot = file_name.rfind('.');
+  const size_t slash = file_name.rfind('/');
+  if (dot == string::npos || (slash != string::npos && dot < slash)) {
+    return absl::StrCat(file_name, suffix);
+  }
+  return absl::StrCat(file_name.substr(0, dot), suffix, file_name.substr(dot));
+}
+
+// Sets the code generation options given by `flags` in `opts`.
+static Status MakeCodegenOpts(const MainFlags& flags, CodegenOpts* opts) {
+  opts->gen_name_to_index = flags.gen_name_to_index;
+  opts->gen_program_shape = flags.gen_program_shape;
+  opts->target_triple = flags.target_triple;
+  if (flags.cpp_class.empty()) {
+    return errors::InvalidArgument("Must specify --cpp_class");
+  }
+  opts->gen_hlo_profile_printer_data =
+      xla::GetDebugOptionsFromFlags().xla_hlo_profile();
+  if (flags.thread_pool_size < 0) {
+    return errors::InvalidArgument("Invalid --thread_pool_size: ",
+                                   flags.thread_pool_size);
+  }
+  opts->thread_pool_size = flags.thread_pool_size;
+  return ParseCppClass(flags.cpp_class, &opts->class_name, &opts->namespaces);
+}
+
+// Compiles `graph_def` once for each of `batch_sizes`, writes the object files
+// of each variant, and a header which dispatches between them.
+static Status CompileBatchVariants(const GraphDef& graph_def,
+                                   const tf2xla::Config& config,
+                                   const std::vector<int64>& batch_sizes,
+                                   const MainFlags& flags) {
+  Env* env = Env::Default();
+  std::vector<BatchVariant> variants(batch_sizes.size());
+  for (size_t i = 0; i < batch_sizes.size(); ++i) {
+    BatchVariant& variant = variants[i];
+    variant.batch_size = batch_sizes[i];
+    variant.config = ConfigForBatchSize(config, variant.batch_size);
+    MainFlags variant_flags = flags;
+    variant_flags.entry_point =
+        absl::StrCat(flags.entry_point, "_batch", variant.batch_size);
+    if (!flags.out_session_module.empty()) {
+      variant_flags.out_session_module =
+          BatchVariantFileName(flags.out_session_module, variant.batch_size);
+    }
+    Status status = CompileGraph(graph_def, variant.config, variant_flags,
+                                 &variant.compile_result);
+    if (!status.ok()) {
+      return Status(status.code(),
+                    InterpolateErrorMessage(status.error_message()));
+    }
+    const std::vector<char>& obj =
+        variant.compile_result.aot->object_file_data();
+    TF_RETURN_IF_ERROR(WriteStringToFile(
+        env,
+        BatchVariantFileName(flags.out_function_object, variant.batch_size),
+        absl::string_view(obj.data(), obj.size())));
+  }
+
+  CodegenOpts codegen_opts;
+  TF_RETURN_IF_ERROR(MakeCodegenOpts(flags, &codegen_opts));
+  for (BatchVariant& variant : variants) {
+    TF_RETURN_IF_ERROR(GenerateMetadata(
+        BatchVariantCodegenOpts(codegen_opts, variant.batch_size),
+        variant.compile_result, &variant.metadata_result));
+    TF_RETURN_IF_ERROR(WriteStringToFile(
+        env,
+        BatchVariantFileName(flags.out_metadata_object, variant.batch_size),
+        variant.metadata_result.object_file_data));
+  }
+  string header;
+  TF_RETURN_IF_ERROR(GenerateBatchedHeader(codegen_opts, flags.entry_point,
+                                           variants, &header));
+  return WriteStringToFile(env, flags.out_header, header);
+}
+
 Status Main(const MainFlags& flags) {
   absl::call_once(targets_init, &InitializeTargets);
 
@@ -215,7 +340,23 @@ Status Main(const MainFlags& flags) {
     return errors::InvalidArgument("Must specify --config");
   }
   TF_RETURN_IF_ERROR(ReadProtoFile(flags.config, &config));
-  TF_RETURN_IF_ERROR(ValidateConfig(config));
+  std::vector<int64> batch_sizes;
+  TF_RETURN_IF_ERROR(ParseBatchSizes(flags.batch_sizes, &batch_sizes));
+  if (batch_sizes.empty()) {
+    if (flags.thread_pool_size > 0) {
+      return errors::InvalidArgument(
+          "--thread_pool_size requires --batch_sizes");
+    }
+    TF_RETURN_IF_ERROR(ValidateConfig(config));
+  } else {
+    if (absl::c_none_of(config.feed(), IsBatchedFeed)) {
+      return errors::InvalidArgument(
+          "--batch_sizes requires a feed whose leading dimension is -1");
+    }
+    // The batched feeds only have a valid shape once their batch size is set.
+    TF_RETURN_IF_ERROR(
+        ValidateConfig(ConfigForBatchSize(config, batch_sizes.front())));
+  }
   if (flags.dump_fetch_nodes) {
     std::set<string> nodes;
     for (const tf2xla::Fetch& fetch : config.fetch()) {
@@ -231,6 +372,9 @@ Status Main(const MainFlags& flags) {
   }
   GraphDef graph_def;
   TF_RETURN_IF_ERROR(ReadProtoFile(flags.graph, &graph_def));
+  if (!batch_sizes.empty()) {
+    return CompileBatchVariants(graph_def, config, batch_sizes, flags);
+  }
   CompileResult compile_result;
 
   Status status =
@@ -247,16 +391,7 @@ Status Main(const MainFlags& flags) {
       WriteStringToFile(env, flags.out_function_object,
                         absl::string_view(obj.data(), obj.size())));
   CodegenOpts codegen_opts;
-  codegen_opts.gen_name_to_index = flags.gen_name_to_index;
-  codegen_opts.gen_program_shape = flags.gen_program_shape;
-  codegen_opts.target_triple = flags.target_triple;
-  if (flags.cpp_class.empty()) {
-    return errors::InvalidArgument("Must specify --cpp_class");
-  }
-  codegen_opts.gen_hlo_profile_printer_data =
-      xla::GetDebugOptionsFromFlags().xla_hlo_profile();
-  TF_RETURN_IF_ERROR(ParseCppClass(flags.cpp_class, &codegen_opts.class_name,
-                                   &codegen_opts.namespaces));
+  TF_RETURN_IF_ERROR(MakeCodegenOpts(flags, &codegen_opts));
 
   MetadataResult metadata_result;
   TF_RETURN_IF_ERROR(
@@ -59,6 +59,25 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
        "Name of the generated function.  If multiple generated object files "
        "will be linked into the same binary, each will need a unique entry "
        "point."},
+      {"num_threads", &flags->num_threads,
+       "Number of threads the generated function is partitioned for.  If "
+       "greater than 1, large operations are split into partitions which run "
+       "on the thread pool passed to set_thread_pool, or on the calling "
+       "thread if none is set."},
+      {"batch_sizes", &flags->batch_sizes,
+       "Comma-separated list of batch sizes, e.g. \"1,8,32\".  If set, the "
+       "graph is compiled once per batch size, with the leading dimension of "
+       "each feed whose leading dimension is -1 set to the batch size.  The "
+       "generated header holds a class per batch size, suffixed with "
+       "Batch<N>, and a --cpp_class class which picks the one for a given "
+       "batch size.  The object files of the function compiled for batch "
+       "size N are written to --out_function_object and "
+       "--out_metadata_object with _batch<N> inserted before the extension."},
+      {"thread_pool_size", &flags->thread_pool_size,
+       "If greater than 0, the --cpp_class class generated with --batch_sizes "
+       "owns a thread pool of this many threads, which the instances returned "
+       "by its Create method run on.  Callers may still pass another pool to "
+       "set_thread_pool."},
       {"cpp_class", &flags->cpp_class,
        "Name of the generated C++ class, wrapping the generated function.  The "
        "syntax of this flag is [[<optional_namespace>::],...]<class_name>.  "
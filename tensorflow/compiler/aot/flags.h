@@ -36,6 +36,9 @@ struct MainFlags {
   string target_cpu;
   string target_features;
   string entry_point;
+  int32 num_threads = 1;
+  string batch_sizes;
+  int32 thread_pool_size = 0;
   string cpp_class;
   string out_function_object;
   string out_metadata_object;
@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/compiler/aot/tests/test_graph_tfcond_mlir_bridge.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tffunction_mlir_bridge.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfgather_mlir_bridge.h"
+#include "tensorflow/compiler/aot/tests/test_graph_tfmatmul_batched_mlir_bridge.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfmatmul_mlir_bridge.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfmatmulandadd_mlir_bridge.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfmatmulandadd_with_profiling_mlir_bridge.h"
@@ -51,6 +52,7 @@ limitations under the License.
 #include "tensorflow/compiler/aot/tests/test_graph_tffunction.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfgather.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfmatmul.h"
+#include "tensorflow/compiler/aot/tests/test_graph_tfmatmul_batched.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfmatmulandadd.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfmatmulandadd_with_profiling.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfsplits.h"
@@ -339,6 +341,48 @@ TEST(TFCompileTest, MatMul2_SetArg) {
   EXPECT_EQ(matmul.result0_data(), matmul.results()[0]);
 }
 
+TEST(TFCompileTest, MatMulBatched) {
+  Eigen::ThreadPool tp(2);
+  Eigen::ThreadPoolDevice device(&tp, tp.NumThreads());
+
+  ASSERT_EQ(foo::bar::BatchedMatMulComp::kNumBatchSizes, 2);
+  EXPECT_EQ(foo::bar::BatchedMatMulComp::BatchSizes()[0], 1);
+  EXPECT_EQ(foo::bar::BatchedMatMulComp::BatchSizes()[1], 4);
+  EXPECT_EQ(foo::bar::BatchedMatMulComp::Create(5), nullptr);
+  ASSERT_EQ(foo::bar::BatchedMatMulComp::kThreadPoolSize, 2);
+  EXPECT_EQ(foo::bar::BatchedMatMulComp::ThreadPool()->numThreads(), 2);
+
+  // A batch of 3 runs on the variant for a batch of 4, padded with zeros, on
+  // the thread pool the dispatching class owns.
+  std::unique_ptr<XlaCompiledCpuFunction> matmul =
+      foo::bar::BatchedMatMulComp::Create(3);
+  ASSERT_NE(matmul, nullptr);
+  EXPECT_EQ(matmul->arg_size(0), static_cast<int>(4 * 3 * sizeof(float)));
+  const float arg0[4][3] = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}, {0, 0, 0}};
+  const float arg1[3][2] = {{7, 8}, {9, 10}, {11, 12}};
+  std::copy(&arg0[0][0], &arg0[0][0] + 12,
+            static_cast<float*>(matmul->arg_data(0)));
+  std::copy(&arg1[0][0], &arg1[0][0] + 6,
+            static_cast<float*>(matmul->arg_data(1)));
+  EXPECT_TRUE(matmul->Run());
+  EXPECT_EQ(matmul->error_msg(), "");
+  const float results[6] = {58, 64, 139, 154, 220, 244};
+  const float* result0 = static_cast<const float*>(matmul->result_data(0));
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(result0[i], results[i]);
+  }
+
+  // Each variant has the typed arg and result methods.
+  foo::bar::BatchedMatMulCompBatch1 matmul1;
+  matmul1.set_thread_pool(&device);
+  std::copy(&arg0[0][0], &arg0[0][0] + 3, matmul1.arg0_data());
+  std::copy(&arg1[0][0], &arg1[0][0] + 6, matmul1.arg1_data());
+  EXPECT_TRUE(matmul1.Run());
+  EXPECT_EQ(matmul1.error_msg(), "");
+  EXPECT_EQ(matmul1.result0(0, 0), 58);
+  EXPECT_EQ(matmul1.result0(0, 1), 64);
+}
+
 TEST(TFCompileTest, MatMulAndAdd1) {
   Eigen::ThreadPool tp(1);
   Eigen::ThreadPoolDevice device(&tp, tp.NumThreads());
@@ -40,6 +40,8 @@ def tf_library(
         enable_xla_hlo_profiling = False,
         enable_tracemes = False,
         mlir_components = "None",
+        batch_sizes = None,
+        thread_pool_size = 0,
         deps = None,
         tags = []):
     """Runs tfcompile to compile a TensorFlow graph into executable code with fast
@@ -57,6 +59,13 @@ def tf_library(
                      gen_benchmark=True.
     The output header is called <name>.h.
 
+    If batch_sizes is given, the graph is compiled once per batch size, and the
+    header holds a <cpp_class>Batch<N> class for each batch size N, next to a
+    cpp_class class which dispatches between them.  The generated test runs the
+    variant for the largest batch size.  If thread_pool_size is also given, the
+    cpp_class class owns a thread pool of that many threads, which the
+    instances returned by its Create method run on.
+
     Args:
       name: The name of the build rule.
       graph: The TensorFlow GraphDef to compile.  If the file ends in '.pbtxt'
@@ -96,6 +105,11 @@ def tf_library(
         Xprof to construct profiler timelines.
       mlir_components: When the value is "None", no components use MLIR. When
         the value is "Bridge", use MLIR to translate GraphDef to HLO.
+      batch_sizes: A list of batch sizes to compile the graph for.  The
+        leading dimension of each feed whose leading dimension is -1 in the
+        config is set to each of them in turn.
+      thread_pool_size: If greater than 0, the size of the thread pool owned by
+        the class dispatching between batch_sizes.
       deps: a list of deps to include on the build rules for the generated
         library, added to the standard deps if standard_runtime_deps is True.
       tags: tags to apply to subsidiary build rules.
@@ -172,6 +186,31 @@ def tf_library(
     metadata_object_file = name + "_tfcompile_metadata.o"
     function_object_file = name + "_tfcompile_function.o"
 
+    # With batch sizes, tfcompile writes the object files of each batch size
+    # with a _batch<N> suffix instead.
+    if batch_sizes:
+        batch_sizes = sorted(batch_sizes)
+        batch_suffixes = ["_batch" + str(b) for b in batch_sizes]
+        metadata_object_files = [
+            name + "_tfcompile_metadata" + suffix + ".o"
+            for suffix in batch_suffixes
+        ]
+        function_object_files = [
+            name + "_tfcompile_function" + suffix + ".o"
+            for suffix in batch_suffixes
+        ]
+        batch_sizes_flag = (" --batch_sizes=" +
+                            ",".join([str(b) for b in batch_sizes]))
+        if thread_pool_size:
+            batch_sizes_flag += " --thread_pool_size=" + str(thread_pool_size)
+    else:
+        batch_suffixes = [""]
+        metadata_object_files = [metadata_object_file]
+        function_object_files = [function_object_file]
+        if thread_pool_size:
+            fail("thread_pool_size requires batch_sizes")
+        batch_sizes_flag = ""
+
     # The XLA backends morph kernal name prefix __ that is not in the form of
     # __xla_.
     ep = ("__xla_" + native.package_name() + "__" + name).replace("/", "_")
@@ -222,11 +261,7 @@ def tf_library(
     native.genrule(
         name = ("gen_" + name),
         srcs = srcs,
-        outs = [
-            header_file,
-            metadata_object_file,
-            function_object_file,
-        ],
+        outs = [header_file] + metadata_object_files + function_object_files,
         cmd = (
             default_fast_math_xla_flags +
             "CUDA_VISIBLE_DEVICES='' " +
@@ -240,6 +275,7 @@ def tf_library(
             " --out_header=$(@D)/" + header_file +
             " --out_metadata_object=$(@D)/" + metadata_object_file +
             " --out_function_object=$(@D)/" + function_object_file +
+            batch_sizes_flag +
             " " + flags + " " + profiling_flag + " " + mlir_flag + " " + traceme_flag
         ),
         exec_tools = [tfcompile_tool],
@@ -266,7 +302,8 @@ def tf_library(
         name = (name + "_session_module"),
         srcs = srcs,
         outs = [
-            session_module_pb,
+            name + "_session_module" + suffix + ".pb"
+            for suffix in batch_suffixes
         ],
         cmd = (
             default_fast_math_xla_flags +
@@ -279,6 +316,7 @@ def tf_library(
             " --cpp_class=" + cpp_class +
             " --target_triple=" + target_llvm_triple() +
             " --out_session_module=$(@D)/" + session_module_pb +
+            batch_sizes_flag +
             " " + flags
         ),
         exec_tools = [tfcompile_tool],
@@ -292,7 +330,7 @@ def tf_library(
     # kernel implementations.
     native.cc_library(
         name = name,
-        srcs = [function_object_file, metadata_object_file],
+        srcs = function_object_files + metadata_object_files,
         hdrs = [header_file],
         visibility = visibility,
         testonly = testonly,
@@ -312,11 +350,15 @@ def tf_library(
             # TODO(cwhipkey): only depend on kernel code that the model actually
             # needed.
             "//tensorflow/compiler/xla/service/cpu:runtime_conv2d",
+            "//tensorflow/compiler/xla/service/cpu:runtime_fork_join",
             "//tensorflow/compiler/xla/service/cpu:runtime_key_value_sort",
             "//tensorflow/compiler/xla/service/cpu:runtime_matmul",
             "//tensorflow/compiler/xla/service/cpu:runtime_single_threaded_conv2d",
             "//tensorflow/compiler/xla/service/cpu:runtime_single_threaded_matmul",
             "//third_party/eigen3",
+        ] or []) + (thread_pool_size and not include_standard_runtime_deps and [
+            # The class owning the thread pool constructs the Eigen pool.
+            "//third_party/eigen3",
         ] or []) + (deps or []),
         tags = tags,
     )
@@ -329,10 +371,25 @@ def tf_library(
         no_ns_name = cpp_class_split[1]
     sed_replace = (
         "-e \"s|{{TFCOMPILE_HEADER}}|$(location " + header_file + ")|g\" " +
-        "-e \"s|{{TFCOMPILE_CPP_CLASS}}|" + cpp_class + "|g\" " +
         "-e \"s|{{TFCOMPILE_NAME}}|" + no_ns_name + "|g\" "
     )
 
+    # The test runs the variant for the largest batch size, while the
+    # benchmark runs all of them through the dispatching class.
+    test_cpp_class = cpp_class
+    if batch_sizes:
+        test_cpp_class = cpp_class + "Batch" + str(batch_sizes[-1])
+    test_sed_replace = (
+        sed_replace +
+        "-e \"s|{{TFCOMPILE_CPP_CLASS}}|" + test_cpp_class + "|g\" "
+    )
+    benchmark_sed_replace = (
+        sed_replace +
+        "-e \"s|{{TFCOMPILE_CPP_CLASS}}|" + cpp_class + "|g\" " +
+        "-e \"s|{{TFCOMPILE_BATCHED}}|" + ("1" if batch_sizes else "0") +
+        "|g\" "
+    )
+
     if gen_test:
         test_name = name + "_test"
         test_file = test_name + ".cc"
@@ -347,7 +404,7 @@ def tf_library(
             ],
             outs = [test_file],
             cmd = (
-                "sed " + sed_replace +
+                "sed " + test_sed_replace +
                 " $(location //tensorflow/compiler/aot:test.cc) " +
                 "> $(OUTS)"
             ),
@@ -388,7 +445,7 @@ def tf_library(
             ],
             testonly = testonly,
             outs = [benchmark_file],
-            cmd = ("sed " + sed_replace +
+            cmd = ("sed " + benchmark_sed_replace +
                    " $(location " + benchmark_main + ") " +
                    "> $(OUTS)"),
             tags = tags,
@@ -163,6 +163,9 @@ void AllocateAndParseFlags() {
 
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
+  ops_flags->tf_xla_async_compilation = false;
+  ops_flags->tf_xla_persistent_cache_directory = "";
+  ops_flags->tf_xla_shape_buckets = "";
 
   jitter_flags = new IntroduceFloatingPointJitterPassFlags;
   jitter_flags->jitter_amount = 1e-5;
@@ -215,6 +218,19 @@ void AllocateAndParseFlags() {
 
        Flag("tf_xla_always_defer_compilation",
             &ops_flags->tf_xla_always_defer_compilation, ""),
+       Flag("tf_xla_async_compilation",
+            &ops_flags->tf_xla_async_compilation,
+            "When lazy compilation is enabled, compile clusters with new "
+            "shapes in the background and run them with TensorFlow until "
+            "their compilation is done."),
+       Flag("tf_xla_persistent_cache_directory",
+            &ops_flags->tf_xla_persistent_cache_directory,
+            "If not empty, the directory in which XLA:CPU persists the object "
+            "code of compiled clusters across processes."),
+       Flag("tf_xla_shape_buckets", &ops_flags->tf_xla_shape_buckets,
+            "If not empty, XLA:CPU pads the batch dimension of cluster inputs "
+            "up to these buckets and compiles once per bucket: either "
+            "\"pow2\" or a comma-separated list of increasing sizes."),
 
        Flag("tf_introduce_floating_point_jitter_to_tensors",
             setter_for_jitter_tensor_names, "",
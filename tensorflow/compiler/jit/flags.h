@@ -98,6 +98,25 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile always refuses to compile the cluster, which means the
   // XLA clusters always run in the TF executor.  Defaults to false.
   bool tf_xla_always_defer_compilation;
+
+  // If true, _XlaCompile compiles clusters with new shapes in the background
+  // and runs them with TensorFlow until their compilation is done, instead of
+  // blocking the step on the compilation. Only affects clusters that are
+  // allowed to fall back to TensorFlow (i.e. with lazy compilation).
+  bool tf_xla_async_compilation;
+
+  // If not empty, XLA:CPU stores the object code of the clusters it compiles
+  // in this directory, and loads it from there when compiling the same
+  // cluster again, e.g. in another process.
+  string tf_xla_persistent_cache_directory;
+
+  // If not empty, XLA:CPU compiles clusters once per bucket of batch sizes
+  // instead of once per batch size: the leading dimension of the inputs is
+  // padded up to the next bucket, and the outputs are sliced back to the
+  // actual batch size. Either "pow2" for powers of two, or a comma-separated
+  // list of increasing bucket sizes, e.g. "1,8,32,128,512". Batches larger
+  // than the last bucket aren't padded.
+  string tf_xla_shape_buckets;
 };
 
 // Flags for the build_xla_ops pass.
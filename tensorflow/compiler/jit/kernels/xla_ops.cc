@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/compiler/jit/defs.h"
 #include "tensorflow/compiler/jit/encapsulate_subgraphs_pass.h"
 #include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/jit/shape_bucketing.h"
 #include "tensorflow/compiler/jit/xla_activity_listener.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
 #include "tensorflow/compiler/jit/xla_platform_info.h"
@@ -77,12 +78,14 @@ class XlaExecutableClosure {
   explicit XlaExecutableClosure(
       xla::LocalClient* client, xla::LocalExecutable* executable,
       const XlaCompiler::CompilationResult* compilation_result,
-      ResourceVarsSnapshot resource_var_snapshots, int num_constant_args)
+      ResourceVarsSnapshot resource_var_snapshots, int num_constant_args,
+      absl::optional<BucketedArguments> bucketed_arguments)
       : client_(client),
         executable_(executable),
         compilation_result_(compilation_result),
         resource_var_snapshots_(std::move(resource_var_snapshots)),
-        num_constant_args_(num_constant_args) {}
+        num_constant_args_(num_constant_args),
+        bucketed_arguments_(std::move(bucketed_arguments)) {}
 
   XlaExecutableClosure(XlaExecutableClosure&&) = default;
   XlaExecutableClosure& operator=(XlaExecutableClosure&&) = default;
@@ -96,6 +99,9 @@ class XlaExecutableClosure {
     return resource_var_snapshots_;
   }
   int num_constant_args() const { return num_constant_args_; }
+  const absl::optional<BucketedArguments>& bucketed_arguments() const {
+    return bucketed_arguments_;
+  }
 
  private:
   xla::LocalClient* client_;
@@ -103,6 +109,7 @@ class XlaExecutableClosure {
   const XlaCompiler::CompilationResult* compilation_result_;
   ResourceVarsSnapshot resource_var_snapshots_;
   int num_constant_args_;
+  absl::optional<BucketedArguments> bucketed_arguments_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(XlaExecutableClosure);
 };
@@ -161,15 +168,38 @@ XlaLocalLaunchBase::XlaLocalLaunchBase(OpKernelConstruction* ctx,
       platform_info_(XlaPlatformInfoFromDevice(ctx->device())),
       has_ref_vars_(has_ref_vars) {}
 
+// Returns the buckets set with --tf_xla_shape_buckets, or nullptr if shape
+// bucketing is disabled.
+static const ShapeBuckets* GetShapeBuckets() {
+  static const ShapeBuckets* buckets = []() -> const ShapeBuckets* {
+    const string& spec = GetXlaOpsCommonFlags().tf_xla_shape_buckets;
+    if (spec.empty()) return nullptr;
+    xla::StatusOr<ShapeBuckets> parsed = ShapeBuckets::Parse(spec);
+    if (!parsed.ok()) {
+      LOG(ERROR) << "Ignoring --tf_xla_shape_buckets: " << parsed.status();
+      return nullptr;
+    }
+    return new ShapeBuckets(parsed.ConsumeValueOrDie());
+  }();
+  return buckets;
+}
+
+// If the cluster was compiled for arguments padded to a bucket of batch sizes
+// (see shape_bucketing.h), `bucketed_arguments` describes the padding, which
+// the inputs must get as well.
 static Status CompileToLocalExecutable(
     OpKernelContext* ctx, const NameAttrList& function, bool has_ref_vars,
     const XlaPlatformInfo& platform_info,
     absl::Span<const Tensor* const> inputs,
     absl::Span<VariableInfo const> variable_infos,
-    absl::Span<const int> constants, bool lazy, bool may_alias_resource_update,
+    absl::Span<const int> constants,
+    XlaCompilationCache::CompileMode compile_mode,
+    bool may_alias_resource_update,
     xla::LocalClient** client,
     const XlaCompiler::CompilationResult** compilation_result,
-    xla::LocalExecutable** executable) {
+    xla::LocalExecutable** executable,
+    absl::optional<BucketedArguments>* bucketed_arguments) {
+  bucketed_arguments->reset();
   // We store information about the JIT-compiled XLA computation
   // in the ResourceMgr.
   ResourceMgr* rm = ctx->resource_manager();
@@ -210,10 +240,34 @@ static Status CompileToLocalExecutable(
           constants, inputs, variable_infos,
           static_cast<Device*>(ctx->device()));
   TF_RETURN_IF_ERROR(args.status());
+
+  // Shape bucketing relies on the host reading the dynamic shapes of the
+  // outputs synchronously, so it is limited to XLA:CPU. Clusters for which the
+  // padding can't be hidden from the outputs are compiled for their actual
+  // shapes.
+  const ShapeBuckets* buckets = GetShapeBuckets();
+  if (buckets && platform_info.platform_id() == se::host::kHostPlatformId &&
+      !platform_info.is_on_xla_device()) {
+    std::vector<XlaCompiler::Argument> padded_args;
+    absl::optional<BucketedArguments> bucketed =
+        BucketArguments(*buckets, *args, &padded_args);
+    if (bucketed) {
+      Status status =
+          cache->Compile(options, function, padded_args, compile_options,
+                         compile_mode, compilation_result, executable);
+      if (status.ok() &&
+          (*executable == nullptr ||
+           CanSliceBucketedOutputs(**compilation_result, *bucketed))) {
+        *bucketed_arguments = std::move(bucketed);
+        return Status::OK();
+      }
+      VLOG(1) << "Not bucketing the shapes of " << function.name() << ": "
+              << (status.ok() ? "its outputs can't be sliced"
+                              : status.ToString());
+    }
+  }
   return cache->Compile(options, function, *args, compile_options,
-                        lazy ? XlaCompilationCache::CompileMode::kLazy
-                             : XlaCompilationCache::CompileMode::kStrict,
-                        compilation_result, executable);
+                        compile_mode, compilation_result, executable);
 }
 
 void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
@@ -224,6 +278,7 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
   xla::LocalClient* client;
   const XlaCompiler::CompilationResult* compilation_result;
   xla::LocalExecutable* executable;
+  absl::optional<BucketedArguments> bucketed_arguments;
 
   std::vector<VariableInfo> variable_infos;
   {
@@ -233,9 +288,9 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
     OP_REQUIRES_OK(ctx, LockVariables(absl::MakeSpan(variable_infos)));
     Status s = CompileToLocalExecutable(
         ctx, function_, /*has_ref_vars=*/has_ref_vars_, platform_info_, inputs,
-        variable_infos, constants_, /*lazy=*/false,
+        variable_infos, constants_, XlaCompilationCache::CompileMode::kStrict,
         /*may_alias_resource_update=*/true, &client, &compilation_result,
-        &executable);
+        &executable, &bucketed_arguments);
     OP_REQUIRES_OK(ctx, s);
   }
 
@@ -261,9 +316,10 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
   const xla::HloInputOutputAliasConfig& input_output_alias =
       executable->executable()->module().input_output_alias_config();
   xla::StatusOr<std::vector<xla::ExecutionInput>> execution_inputs =
-      launch_context.PopulateInputs(ctx, compilation_result, resource_var_ptrs,
-                                    /*missing_ctx_input_prefix=*/0,
-                                    input_output_alias);
+      launch_context.PopulateInputs(
+          ctx, compilation_result, resource_var_ptrs,
+          /*missing_ctx_input_prefix=*/0, input_output_alias,
+          bucketed_arguments ? &*bucketed_arguments : nullptr);
   OP_REQUIRES_OK(ctx, execution_inputs.status());
 
   // Execute the computation.
@@ -374,6 +430,7 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   const XlaCompiler::CompilationResult* kernel;
   xla::LocalExecutable* executable;
   ResourceVarsSnapshot variables;
+  absl::optional<BucketedArguments> bucketed_arguments;
 
   std::vector<const Tensor*> inputs = InputsFromContext(ctx);
   bool cannot_compile_cluster;
@@ -392,13 +449,21 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
                                         inputs, resources_, &variable_infos));
     OP_REQUIRES_OK(ctx, LockVariables(absl::MakeSpan(variable_infos)));
 
+    XlaCompilationCache::CompileMode compile_mode =
+        XlaCompilationCache::CompileMode::kStrict;
+    if (!must_compile_) {
+      compile_mode = GetXlaOpsCommonFlags().tf_xla_async_compilation
+                         ? XlaCompilationCache::CompileMode::kAsync
+                         : XlaCompilationCache::CompileMode::kLazy;
+    }
+
     // Do not alias resource updates as locking variables in XlaCompile and
     // unlocking them in XlaRun may lead to deadlocks.
     Status status = CompileToLocalExecutable(
         ctx, function_, has_ref_vars_, platform_info_, inputs, variable_infos,
-        constants_,
-        /*lazy=*/!must_compile_,
-        /*may_alias_resource_update=*/false, &client, &kernel, &executable);
+        constants_, compile_mode,
+        /*may_alias_resource_update=*/false, &client, &kernel, &executable,
+        &bucketed_arguments);
     OP_REQUIRES_OK(ctx, SnapshotResourceVariables(ctx, resources_,
                                                   variable_infos, &variables));
     if (must_compile_ || status.code() != error::UNIMPLEMENTED) {
@@ -440,7 +505,8 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   // variables.
   XlaExecutableClosureStore::KeyT key =
       XlaExecutableClosureStore::Global()->Produce(XlaExecutableClosure(
-          client, executable, kernel, std::move(variables), constants_.size()));
+          client, executable, kernel, std::move(variables), constants_.size(),
+          std::move(bucketed_arguments)));
 
   Tensor compilation_key(cpu_allocator, DT_STRING, TensorShape({}));
   compilation_key.flat<tstring>()(0) = key;
@@ -500,7 +566,9 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
     execution_inputs = launch_context.PopulateInputs(
         ctx, closure.compilation_result(), snapshot_ptrs,
         /*missing_ctx_input_prefix=*/closure.num_constant_args(),
-        input_output_alias);
+        input_output_alias,
+        closure.bucketed_arguments() ? &*closure.bucketed_arguments()
+                                     : nullptr);
     OP_REQUIRES_OK(ctx, execution_inputs.status());
   }
 
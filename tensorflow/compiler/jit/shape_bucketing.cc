@@ -0,0 +1,140 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include <algorithm>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/types/variant.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+
+/*static*/ xla::StatusOr<ShapeBuckets> ShapeBuckets::Parse(
+    absl::string_view spec) {
+  if (spec == "pow2") return ShapeBuckets({});
+
+  std::vector<int64> sizes;
+  for (absl::string_view size_str : absl::StrSplit(spec, ',')) {
+    int64 size;
+    if (!absl::SimpleAtoi(size_str, &size) || size <= 0 ||
+        (!sizes.empty() && size <= sizes.back())) {
+      return errors::InvalidArgument(
+          "Shape buckets must be \"pow2\" or a list of increasing positive "
+          "sizes, got \"",
+          spec, "\"");
+    }
+    sizes.push_back(size);
+  }
+  return ShapeBuckets(std::move(sizes));
+}
+
+absl::optional<int64> ShapeBuckets::BucketFor(int64 size) const {
+  if (sizes_.empty()) {
+    return static_cast<int64>(NextPowerOfTwo64(std::max<int64>(size, 1)));
+  }
+  auto it = std::lower_bound(sizes_.begin(), sizes_.end(), size);
+  if (it == sizes_.end()) return absl::nullopt;
+  return *it;
+}
+
+absl::optional<BucketedArguments> BucketArguments(
+    const ShapeBuckets& buckets, absl::Span<const XlaCompiler::Argument> args,
+    std::vector<XlaCompiler::Argument>* bucketed_args) {
+  auto is_batched_parameter = [](const XlaCompiler::Argument& arg) {
+    return arg.kind == XlaCompiler::Argument::kParameter &&
+           absl::holds_alternative<TensorShape>(arg.shape) &&
+           absl::get<TensorShape>(arg.shape).dims() > 0;
+  };
+  auto batch_arg = std::find_if(args.begin(), args.end(), is_batched_parameter);
+  if (batch_arg == args.end()) return absl::nullopt;
+
+  BucketedArguments bucketed;
+  bucketed.batch_size = absl::get<TensorShape>(batch_arg->shape).dim_size(0);
+  absl::optional<int64> bucket_size = buckets.BucketFor(bucketed.batch_size);
+  if (!bucket_size) return absl::nullopt;
+  bucketed.bucket_size = *bucket_size;
+  bucketed.batch_size_arg = args.size();
+
+  std::vector<XlaCompiler::Argument> padded_args(args.begin(), args.end());
+  for (int i = 0, end = padded_args.size(); i < end; ++i) {
+    XlaCompiler::Argument& arg = padded_args[i];
+    if (!is_batched_parameter(arg)) continue;
+    TensorShape& shape = absl::get<TensorShape>(arg.shape);
+    if (shape.dim_size(0) != bucketed.batch_size) continue;
+    shape.set_dim(0, bucketed.bucket_size);
+    arg.dynamic_dim_to_arg_num_map[0] = bucketed.batch_size_arg;
+    bucketed.padded_args.push_back(i);
+  }
+
+  XlaCompiler::Argument batch_size_arg;
+  batch_size_arg.kind = XlaCompiler::Argument::kParameter;
+  batch_size_arg.type = DT_INT32;
+  batch_size_arg.shape = TensorShape({});
+  batch_size_arg.name = "batch_size";
+  padded_args.push_back(std::move(batch_size_arg));
+
+  *bucketed_args = std::move(padded_args);
+  return bucketed;
+}
+
+bool CanSliceBucketedOutputs(const XlaCompiler::CompilationResult& result,
+                             const BucketedArguments& bucketed) {
+  auto can_slice = [&](const xla::Shape& shape) {
+    if (shape.rank() == 0) return true;
+    for (int64 dim = 1; dim < shape.rank(); ++dim) {
+      if (shape.is_dynamic_dimension(dim)) return false;
+    }
+    return shape.is_dynamic_dimension(0) ||
+           shape.dimensions(0) != bucketed.bucket_size;
+  };
+
+  // The computation returns the outputs which aren't constants or resources,
+  // then the resource updates, in a tuple unless there is only one of them.
+  int num_computed_outputs = 0;
+  for (const XlaCompiler::OutputDescription& output : result.outputs) {
+    if (output.is_constant) {
+      const TensorShape& shape = output.shape;
+      if (shape.dims() > 0 && shape.dim_size(0) == bucketed.bucket_size) {
+        return false;
+      }
+    } else if (output.type != DT_RESOURCE) {
+      ++num_computed_outputs;
+    }
+  }
+
+  const xla::Shape& output_shape = result.xla_output_shape;
+  const int num_elements = output_shape.IsTuple()
+                               ? xla::ShapeUtil::TupleElementCount(output_shape)
+                               : 1;
+  for (int i = 0; i < num_elements; ++i) {
+    const xla::Shape& element_shape =
+        output_shape.IsTuple()
+            ? xla::ShapeUtil::GetTupleElementShape(output_shape, i)
+            : output_shape;
+    if (!element_shape.IsArray()) return false;
+    if (i < num_computed_outputs ? !can_slice(element_shape)
+                                 : element_shape.is_dynamic()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace tensorflow
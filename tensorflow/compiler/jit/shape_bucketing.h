@@ -0,0 +1,90 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Shape bucketing lets a cluster fed with many batch sizes be compiled once
+// per bucket of batch sizes rather than once per batch size. The leading
+// dimension of the inputs holding the batch is padded up to the bucket and
+// marked as dynamic, with its actual size passed in an extra argument. XLA
+// then makes the padding invisible to the computation (see DynamicPadder) and
+// returns outputs whose leading dimension is the actual batch size.
+
+#ifndef TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+#define TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/tf2xla/xla_compiler.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The sizes to which batches are padded.
+class ShapeBuckets {
+ public:
+  // Parses `spec`, which is either "pow2" for all the powers of two or a
+  // comma-separated list of increasing positive sizes, e.g. "1,8,32".
+  static xla::StatusOr<ShapeBuckets> Parse(absl::string_view spec);
+
+  // Returns the smallest bucket holding `size`, or nullopt if `size` is larger
+  // than all the buckets.
+  absl::optional<int64> BucketFor(int64 size) const;
+
+ private:
+  explicit ShapeBuckets(std::vector<int64> sizes) : sizes_(std::move(sizes)) {}
+
+  // Empty for the powers of two.
+  std::vector<int64> sizes_;
+};
+
+// Describes how BucketArguments padded the arguments of a cluster.
+struct BucketedArguments {
+  // Actual and padded size of the leading dimension of the padded arguments.
+  int64 batch_size;
+  int64 bucket_size;
+
+  // Numbers of the padded arguments, in increasing order.
+  std::vector<int> padded_args;
+
+  // Number of the int32 scalar argument holding `batch_size`, which comes
+  // after all the arguments of the cluster.
+  int batch_size_arg;
+};
+
+// Pads the leading dimension of the parameters in `args` up to the bucket of
+// the batch size, and stores the resulting arguments in `bucketed_args`. The
+// batch size is the leading dimension of the first parameter which isn't a
+// scalar, and only the parameters with that leading dimension are padded.
+//
+// Returns nullopt, and leaves `bucketed_args` untouched, if there is no batch
+// or if it is larger than all the buckets.
+absl::optional<BucketedArguments> BucketArguments(
+    const ShapeBuckets& buckets, absl::Span<const XlaCompiler::Argument> args,
+    std::vector<XlaCompiler::Argument>* bucketed_args);
+
+// Returns true if the outputs of `result`, compiled from arguments padded as
+// described by `bucketed`, can be returned without their padding: only the
+// leading dimension of the outputs may be dynamic, and only if the shapes of
+// the resource variables don't depend on it. A static leading dimension of
+// the size of the bucket may hold padding, so it is rejected as well.
+bool CanSliceBucketedOutputs(const XlaCompiler::CompilationResult& result,
+                             const BucketedArguments& bucketed);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
@@ -0,0 +1,285 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/jit/xla_compilation_cache.h"
+#include "tensorflow/compiler/tf2xla/shape_util.h"
+#include "tensorflow/compiler/xla/array2d.h"
+#include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/compiler/xla/client/local_client.h"
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int64 kNumFeatures = 16;
+
+TEST(ShapeBucketsTest, PowersOfTwo) {
+  TF_ASSERT_OK_AND_ASSIGN(ShapeBuckets buckets, ShapeBuckets::Parse("pow2"));
+  EXPECT_EQ(buckets.BucketFor(1), 1);
+  EXPECT_EQ(buckets.BucketFor(5), 8);
+  EXPECT_EQ(buckets.BucketFor(512), 512);
+  EXPECT_EQ(buckets.BucketFor(513), 1024);
+}
+
+TEST(ShapeBucketsTest, List) {
+  TF_ASSERT_OK_AND_ASSIGN(ShapeBuckets buckets, ShapeBuckets::Parse("1,8,32"));
+  EXPECT_EQ(buckets.BucketFor(1), 1);
+  EXPECT_EQ(buckets.BucketFor(2), 8);
+  EXPECT_EQ(buckets.BucketFor(32), 32);
+  EXPECT_EQ(buckets.BucketFor(33), absl::nullopt);
+}
+
+TEST(ShapeBucketsTest, InvalidSpecs) {
+  for (const char* spec : {"", "pow3", "8,4", "0,4", "4,4", "1,,8"}) {
+    EXPECT_FALSE(ShapeBuckets::Parse(spec).ok()) << spec;
+  }
+}
+
+TEST(BucketArgumentsTest, PadsParametersWithTheBatchSize) {
+  TF_ASSERT_OK_AND_ASSIGN(ShapeBuckets buckets, ShapeBuckets::Parse("pow2"));
+  std::vector<XlaCompiler::Argument> args(4);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_FLOAT;
+  args[0].shape = TensorShape({});
+  args[1].kind = XlaCompiler::Argument::kParameter;
+  args[1].type = DT_FLOAT;
+  args[1].shape = TensorShape({5, 3});
+  args[2].kind = XlaCompiler::Argument::kParameter;
+  args[2].type = DT_FLOAT;
+  args[2].shape = TensorShape({3, 5});
+  args[3].kind = XlaCompiler::Argument::kParameter;
+  args[3].type = DT_INT32;
+  args[3].shape = TensorShape({5});
+
+  std::vector<XlaCompiler::Argument> bucketed_args;
+  absl::optional<BucketedArguments> bucketed =
+      BucketArguments(buckets, args, &bucketed_args);
+  ASSERT_TRUE(bucketed.has_value());
+  EXPECT_EQ(bucketed->batch_size, 5);
+  EXPECT_EQ(bucketed->bucket_size, 8);
+  EXPECT_EQ(bucketed->padded_args, std::vector<int>({1, 3}));
+  EXPECT_EQ(bucketed->batch_size_arg, 4);
+
+  ASSERT_EQ(bucketed_args.size(), 5);
+  EXPECT_EQ(absl::get<TensorShape>(bucketed_args[0].shape), TensorShape({}));
+  EXPECT_EQ(absl::get<TensorShape>(bucketed_args[1].shape),
+            TensorShape({8, 3}));
+  EXPECT_EQ(absl::get<TensorShape>(bucketed_args[2].shape),
+            TensorShape({3, 5}));
+  EXPECT_EQ(absl::get<TensorShape>(bucketed_args[3].shape), TensorShape({8}));
+  EXPECT_EQ(bucketed_args[1].dynamic_dim_to_arg_num_map,
+            (std::map<int32, int32>{{0, 4}}));
+  EXPECT_TRUE(bucketed_args[2].dynamic_dim_to_arg_num_map.empty());
+  EXPECT_EQ(bucketed_args[3].dynamic_dim_to_arg_num_map,
+            (std::map<int32, int32>{{0, 4}}));
+  EXPECT_EQ(bucketed_args[4].kind, XlaCompiler::Argument::kParameter);
+  EXPECT_EQ(bucketed_args[4].type, DT_INT32);
+  EXPECT_EQ(absl::get<TensorShape>(bucketed_args[4].shape), TensorShape({}));
+}
+
+TEST(BucketArgumentsTest, NoBatch) {
+  TF_ASSERT_OK_AND_ASSIGN(ShapeBuckets buckets, ShapeBuckets::Parse("1,8"));
+  std::vector<XlaCompiler::Argument> args(1);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_FLOAT;
+  args[0].shape = TensorShape({});
+  std::vector<XlaCompiler::Argument> bucketed_args;
+  EXPECT_FALSE(BucketArguments(buckets, args, &bucketed_args).has_value());
+
+  // Batches larger than the last bucket aren't padded.
+  args[0].shape = TensorShape({9});
+  EXPECT_FALSE(BucketArguments(buckets, args, &bucketed_args).has_value());
+  EXPECT_TRUE(bucketed_args.empty());
+}
+
+// Returns the maximum of every feature over the batch, and the input times two.
+FunctionDef MaxAndDouble() {
+  return FunctionDefHelper::Define(
+      // Name
+      "MaxAndDouble",
+      // Args
+      {"x: float"},
+      // Return values
+      {"max: float", "y: float"},
+      // Attr def
+      {},
+      // Nodes
+      {
+          FunctionDefHelper::Const("axis", 0),
+          {{"max"},
+           "Max",
+           {"x", "axis"},
+           {{"T", DT_FLOAT}, {"Tidx", DT_INT32}}},
+          FunctionDefHelper::Const("two", 2.0f),
+          {{"y"}, "Mul", {"x", "two"}, {{"T", DT_FLOAT}}},
+      });
+}
+
+// Compiles MaxAndDouble for [batch_size, kNumFeatures] inputs with an
+// XlaCompilationCache, optionally padding the batch to buckets, and runs it on
+// XLA:CPU.
+class MaxAndDoubleRunner {
+ public:
+  explicit MaxAndDoubleRunner(const ShapeBuckets* buckets)
+      : flib_def_(OpRegistry::Global(), FunctionDefLibrary()),
+        buckets_(buckets) {
+    TF_CHECK_OK(flib_def_.AddFunctionDef(MaxAndDouble()));
+    function_.set_name("MaxAndDouble");
+    client_ = xla::ClientLibrary::LocalClientOrDie();
+    options_.client = client_;
+    options_.device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+    options_.flib_def = &flib_def_;
+    options_.graph_def_version = TF_GRAPH_DEF_VERSION;
+    cache_ = new XlaCompilationCache(client_, options_.device_type);
+  }
+
+  ~MaxAndDoubleRunner() { cache_->Unref(); }
+
+  // Runs MaxAndDouble on an input of `batch_size` rows of negative values,
+  // which makes padding with zeros visible in the maximum if XLA doesn't hide
+  // it, and returns its outputs.
+  Status Run(int64 batch_size, xla::Literal* max, xla::Literal* doubled) {
+    std::vector<XlaCompiler::Argument> args(1);
+    args[0].kind = XlaCompiler::Argument::kParameter;
+    args[0].type = DT_FLOAT;
+    args[0].shape = TensorShape({batch_size, kNumFeatures});
+    std::vector<XlaCompiler::Argument> bucketed_args;
+    absl::optional<BucketedArguments> bucketed;
+    if (buckets_) bucketed = BucketArguments(*buckets_, args, &bucketed_args);
+
+    const XlaCompiler::CompilationResult* result;
+    xla::LocalExecutable* executable;
+    TF_RETURN_IF_ERROR(cache_->Compile(
+        options_, function_, bucketed ? bucketed_args : args,
+        XlaCompiler::CompileOptions{},
+        XlaCompilationCache::CompileMode::kStrict, &result, &executable));
+    TF_RET_CHECK(!bucketed || CanSliceBucketedOutputs(*result, *bucketed));
+    executables_.insert(executable);
+
+    const int64 rows = bucketed ? bucketed->bucket_size : batch_size;
+    xla::Array2D<float> input(rows, kNumFeatures, 0.0f);
+    for (int64 row = 0; row < batch_size; ++row) {
+      for (int64 feature = 0; feature < kNumFeatures; ++feature) {
+        input(row, feature) = -1.0f - row * kNumFeatures - feature;
+      }
+    }
+    std::vector<xla::Literal> literals;
+    literals.push_back(xla::LiteralUtil::CreateR2FromArray2D(input));
+    if (bucketed) {
+      literals.push_back(
+          xla::LiteralUtil::CreateR0<int32>(bucketed->batch_size));
+    }
+    std::vector<xla::ScopedShapedBuffer> buffers;
+    for (const xla::Literal& literal : literals) {
+      TF_ASSIGN_OR_RETURN(xla::ScopedShapedBuffer buffer,
+                          client_->LiteralToShapedBuffer(
+                              literal, client_->default_device_ordinal()));
+      buffers.push_back(std::move(buffer));
+    }
+    std::vector<const xla::ShapedBuffer*> arguments;
+    for (const xla::ScopedShapedBuffer& buffer : buffers) {
+      arguments.push_back(&buffer);
+    }
+
+    TF_ASSIGN_OR_RETURN(
+        xla::ScopedShapedBuffer output,
+        executable->Run(arguments, xla::ExecutableRunOptions()));
+    if (output.on_device_shape().is_dynamic()) {
+      TF_ASSIGN_OR_RETURN(xla::StreamPool::Ptr stream,
+                          client_->backend().BorrowStream(
+                              client_->default_device_ordinal()));
+      xla::Shape host_shape = output.on_host_shape();
+      xla::Shape device_shape = output.on_device_shape();
+      TF_RETURN_IF_ERROR(
+          client_->backend().transfer_manager()->ReadDynamicShapes(
+              stream.get(), &output, &host_shape, &device_shape));
+      output.set_shapes(host_shape, device_shape);
+    }
+    TF_ASSIGN_OR_RETURN(xla::Literal outputs,
+                        client_->ShapedBufferToLiteral(output));
+    std::vector<xla::Literal> elements = outputs.DecomposeTuple();
+    TF_RET_CHECK(elements.size() == 2);
+    *max = std::move(elements[0]);
+    *doubled = std::move(elements[1]);
+    return Status::OK();
+  }
+
+  int num_executables() const { return executables_.size(); }
+
+ private:
+  FunctionLibraryDefinition flib_def_;
+  const ShapeBuckets* buckets_;
+  NameAttrList function_;
+  xla::LocalClient* client_;
+  XlaCompiler::Options options_;
+  XlaCompilationCache* cache_;
+  absl::flat_hash_set<xla::LocalExecutable*> executables_;
+};
+
+TEST(ShapeBucketingTest, OutputsIgnorePadding) {
+  TF_ASSERT_OK_AND_ASSIGN(ShapeBuckets buckets, ShapeBuckets::Parse("pow2"));
+  MaxAndDoubleRunner runner(&buckets);
+  for (int64 batch_size : {3, 4}) {
+    xla::Literal max, doubled;
+    TF_ASSERT_OK(runner.Run(batch_size, &max, &doubled));
+    EXPECT_EQ(max.shape().dimensions(0), kNumFeatures);
+    EXPECT_EQ(doubled.shape().dimensions(0), batch_size);
+    EXPECT_EQ(doubled.shape().dimensions(1), kNumFeatures);
+    for (int64 feature = 0; feature < kNumFeatures; ++feature) {
+      EXPECT_EQ(max.Get<float>({feature}), -1.0f - feature);
+      EXPECT_EQ(doubled.Get<float>({batch_size - 1, feature}),
+                -2.0f * (batch_size * kNumFeatures + feature -
+                         kNumFeatures + 1));
+    }
+  }
+  // Both batches are in the bucket of size 4.
+  EXPECT_EQ(runner.num_executables(), 1);
+}
+
+// Runs MaxAndDouble over a stream of batch sizes from 1 to 512, with shape
+// bucketing if state.range(0) is true. Reports the number of compilations and
+// the number of rows processed per second.
+void BM_VariableBatchStream(::testing::benchmark::State& state) {
+  absl::optional<ShapeBuckets> buckets;
+  if (state.range(0)) buckets = ShapeBuckets::Parse("pow2").ValueOrDie();
+  MaxAndDoubleRunner runner(buckets ? &*buckets : nullptr);
+
+  int64 rows = 0;
+  int64 i = 0;
+  for (auto s : state) {
+    // Visits the batch sizes in a scrambled order.
+    const int64 batch_size = (i++ * 97) % 512 + 1;
+    xla::Literal max, doubled;
+    TF_CHECK_OK(runner.Run(batch_size, &max, &doubled));
+    rows += batch_size;
+  }
+  state.SetItemsProcessed(rows);
+  state.SetLabel(absl::StrCat(runner.num_executables(), " compilations"));
+}
+BENCHMARK(BM_VariableBatchStream)->Arg(false)->Arg(true);
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,10 +15,13 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
+#include <memory>
 #include <numeric>
+#include <vector>
 
 #include "tensorflow/compiler/mlir/mlir_bridge_rollout_policy.h"
 #include "absl/base/call_once.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/compiler/jit/flags.h"
@@ -95,12 +98,17 @@ string XlaCompilationCache::Signature::HumanString() const {
   for (const auto& v : arg_values) {
     absl::StrAppend(&result, "; ", v.DebugString());
   }
+
+  if (!dynamic_dims.empty()) {
+    absl::StrAppend(&result, "; dynamic ", absl::StrJoin(dynamic_dims, ","));
+  }
   return result;
 }
 
 bool XlaCompilationCache::Signature::operator==(const Signature& other) const {
   if (name != other.name) return false;
   if (arg_shapes != other.arg_shapes) return false;
+  if (dynamic_dims != other.dynamic_dims) return false;
 
   if (arg_values.size() != other.arg_values.size()) return false;
   for (int i = 0, end = arg_values.size(); i < end; ++i) {
@@ -127,6 +135,9 @@ uint64 XlaCompilationCache::Signature::Hash::operator()(
     h = Hash64Combine(
         h, Hash64(arg.tensor_data().data(), arg.tensor_data().size()));
   }
+  for (int dynamic_dim : signature.dynamic_dims) {
+    h = Hash64Combine(h, std::hash<int>()(dynamic_dim));
+  }
   return h;
 }
 
@@ -137,7 +148,8 @@ XlaCompilationCache::BuildSignature(
   Signature signature;
   signature.name = Canonicalize(function.name(), AttrSlice(&function.attr()));
 
-  for (const XlaCompiler::Argument& arg : args) {
+  for (int i = 0, end = args.size(); i < end; ++i) {
+    const XlaCompiler::Argument& arg = args[i];
     switch (arg.kind) {
       case XlaCompiler::Argument::kConstant:
       case XlaCompiler::Argument::kConstantResource:
@@ -147,6 +159,11 @@ XlaCompilationCache::BuildSignature(
       case XlaCompiler::Argument::kResource:
         signature.arg_shapes.emplace_back(arg.type,
                                           arg.DimensionSizesAsInlinedVector());
+        for (const auto& dim_and_arg_num : arg.dynamic_dim_to_arg_num_map) {
+          signature.dynamic_dims.push_back(i);
+          signature.dynamic_dims.push_back(dim_and_arg_num.first);
+          signature.dynamic_dims.push_back(dim_and_arg_num.second);
+        }
         break;
       default:
         return errors::InvalidArgument(
@@ -177,6 +194,12 @@ Status XlaCompilationCache::BuildExecutable(
   build_options.set_alias_passthrough_params(options.alias_passthrough_params);
   build_options.mutable_debug_options()->set_xla_detailed_logging(
       options.detailed_logging);
+  const string& persistent_cache_directory =
+      GetXlaOpsCommonFlags().tf_xla_persistent_cache_directory;
+  if (!persistent_cache_directory.empty()) {
+    build_options.mutable_debug_options()->set_xla_cpu_persistent_cache_dir(
+        persistent_cache_directory);
+  }
   TF_ASSIGN_OR_RETURN(
       auto executables,
       client_->Compile(*result.computation, argument_layouts, build_options));
@@ -192,16 +215,14 @@ Status XlaCompilationCache::Compile(
     CompileMode compile_mode,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
-  absl::optional<int64> compile_threshold;
-  if (compile_mode == CompileMode::kLazy) {
-    compile_threshold = kDefaultCompilationThreshold;
-  }
-  auto compile_fn = [&](XlaCompiler* compiler,
+  // Captures by value, as the compilation may outlive this call in kAsync mode.
+  auto compile_fn = [compile_options, function](
+                        XlaCompiler* compiler,
+                        absl::Span<const XlaCompiler::Argument> args,
                         XlaCompiler::CompilationResult* result) {
     return compiler->CompileFunction(compile_options, function, args, result);
   };
-  return CompileImpl(options, function, args, compile_fn,
-                     /*compile_threshold=*/compile_threshold,
+  return CompileImpl(options, function, args, compile_fn, compile_mode,
                      out_compilation_result, out_executable);
 }
 
@@ -277,6 +298,7 @@ Status XlaCompilationCache::CompileSingleOp(
   // and causes false uniqueness between nodes.
   name.mutable_attr()->erase("_class");
   auto compile_op = [&](XlaCompiler* compiler,
+                        absl::Span<const XlaCompiler::Argument> args,
                         XlaCompiler::CompilationResult* result) {
     std::vector<DataType> result_dtypes(ctx->num_outputs());
     for (int i = 0, end = result_dtypes.size(); i < end; ++i) {
@@ -316,8 +338,7 @@ Status XlaCompilationCache::CompileSingleOp(
         *options.flib_def, debug_info, options.shape_representation_fn, result);
 #endif
   };
-  return CompileImpl(options, name, args, compile_op,
-                     /*compile_threshold=*/absl::nullopt,
+  return CompileImpl(options, name, args, compile_op, CompileMode::kStrict,
                      out_compilation_result, out_executable);
 }
 
@@ -338,9 +359,7 @@ void LogOnceXlaCompiledFirstCluster() {
 Status XlaCompilationCache::CompileImpl(
     const XlaCompiler::Options& options, const NameAttrList& function,
     absl::Span<const XlaCompiler::Argument> args,
-    const std::function<Status(XlaCompiler* compiler,
-                               XlaCompiler::CompilationResult*)>& compile_fn,
-    absl::optional<int64> compile_threshold,
+    const CompileFn& compile_fn, CompileMode compile_mode,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
   if (FailOnXlaCompilation()) {
@@ -350,6 +369,11 @@ Status XlaCompilationCache::CompileImpl(
   DCHECK_NE(out_executable, nullptr);
   VLOG(2) << "XlaCompilationCache::Compile " << DebugString();
 
+  absl::optional<int64> compile_threshold;
+  if (compile_mode == CompileMode::kLazy) {
+    compile_threshold = kDefaultCompilationThreshold;
+  }
+
   if (VLOG_IS_ON(2)) {
     VLOG(2) << "num_inputs=" << args.size();
     for (int i = 0, end = args.size(); i < end; i++) {
@@ -409,6 +433,11 @@ Status XlaCompilationCache::CompileImpl(
   // TODO(phawkins): this locking will need to be restructured when we implement
   // cache eviction.
   mutex_lock entry_lock(entry->mu);
+  // Requests which can't fall back to TensorFlow wait for the pending
+  // background compilation rather than compiling the entry again.
+  while (entry->compiling_async && compile_mode != CompileMode::kAsync) {
+    entry->async_compilation_done.wait(entry_lock);
+  }
   int64 current_request_count = ++entry->request_count;
   VLOG(2) << "Compilation cache entry hit: " << entry->compiled
           << " signature: " << signature.HumanString() << " with request count "
@@ -417,7 +446,7 @@ Status XlaCompilationCache::CompileImpl(
   if (!entry->compiled) {
     XLA_SCOPED_LOGGING_TIMER("Compilation of XLA executable");
     const bool should_compile = [&] {
-      if (!compile_threshold.has_value()) {
+      if (compile_mode == CompileMode::kStrict) {
         // Lazy compilation is disabled.
         return true;
       }
@@ -431,7 +460,7 @@ Status XlaCompilationCache::CompileImpl(
         return false;
       }
 
-      if (is_first_execution) {
+      if (is_first_execution || compile_mode == CompileMode::kAsync) {
         return true;
       }
 
@@ -454,6 +483,19 @@ Status XlaCompilationCache::CompileImpl(
       return Status::OK();
     }
 
+    if (compile_mode == CompileMode::kAsync) {
+      if (!entry->compiling_async) {
+        entry->compiling_async = true;
+        CompileAsync(options, function, args, compile_fn, entry);
+      }
+      VLOG(2) << "Falling back to TensorFlow while compiling signature: "
+              << signature.HumanString();
+      metrics::IncrementXlaCompilationFallbackCount();
+      *out_compilation_result = nullptr;
+      *out_executable = nullptr;
+      return Status::OK();
+    }
+
     tensorflow::Env* env = tensorflow::Env::Default();
     const uint64 compile_start_us = env->NowMicros();
     // Do the actual JIT compilation without holding the lock (it can take
@@ -463,7 +505,7 @@ Status XlaCompilationCache::CompileImpl(
     entry->compiled = true;
 
     entry->compilation_status =
-        compile_fn(&compiler, &entry->compilation_result);
+        compile_fn(&compiler, args, &entry->compilation_result);
     TF_RETURN_IF_ERROR(entry->compilation_status);
     CHECK_EQ(entry->executable.get(), nullptr);
     entry->compilation_status =
@@ -472,34 +514,7 @@ Status XlaCompilationCache::CompileImpl(
     const uint64 compile_end_us = env->NowMicros();
     const uint64 compile_time_us = compile_end_us - compile_start_us;
     metrics::UpdateXlaCompilationTime(compile_time_us);
-    {
-      mutex_lock lock(cluster_compile_stats_mu_);
-      auto it = cluster_compile_stats_.find(function.name());
-      it->second.compile_count++;
-      it->second.cumulative_compile_time_us += compile_time_us;
-      LogOnceXlaCompiledFirstCluster();
-      VLOG(1) << "compiled " << function.name() << " "
-              << it->second.compile_count
-              << " times, compile time: " << compile_time_us
-              << " us, cumulative: " << it->second.cumulative_compile_time_us
-              << " us ("
-              << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
-                                                               1.0e6)
-              << " / "
-              << tensorflow::strings::HumanReadableElapsedTime(
-                     it->second.cumulative_compile_time_us / 1.0e6)
-              << ")";
-
-      XlaJitCompilationActivity jit_compilation_activity;
-      jit_compilation_activity.set_cluster_name(function.name());
-      jit_compilation_activity.set_compile_count(it->second.compile_count);
-      jit_compilation_activity.set_compile_time_us(compile_time_us);
-      jit_compilation_activity.set_cumulative_compile_time_us(
-          it->second.cumulative_compile_time_us);
-
-      TF_RETURN_IF_ERROR(
-          BroadcastXlaActivity(std::move(jit_compilation_activity)));
-    }
+    TF_RETURN_IF_ERROR(UpdateCompileStats(function.name(), compile_time_us));
   }
   TF_RETURN_IF_ERROR(entry->compilation_status);
   *out_compilation_result = &entry->compilation_result;
@@ -507,4 +522,86 @@ Status XlaCompilationCache::CompileImpl(
   return Status::OK();
 }
 
+void XlaCompilationCache::CompileAsync(
+    const XlaCompiler::Options& options, const NameAttrList& function,
+    absl::Span<const XlaCompiler::Argument> args, const CompileFn& compile_fn,
+    Entry* entry) {
+  // The compilation outlives the request, so it only uses copies of the
+  // request's state. The function library of the request may be modified or
+  // destroyed in the meantime, and so may the allocator, which is replaced by
+  // the allocator of the XLA backend.
+  auto flib_def =
+      std::make_shared<FunctionLibraryDefinition>(*options.flib_def);
+  XlaCompiler::Options async_options = options;
+  async_options.flib_def = flib_def.get();
+  async_options.device_allocator = nullptr;
+  std::vector<XlaCompiler::Argument> async_args(args.begin(), args.end());
+
+  mutex_lock lock(async_compiler_threads_mu_);
+  if (!async_compiler_threads_) {
+    async_compiler_threads_ = absl::make_unique<thread::ThreadPool>(
+        Env::Default(), "xla_async_compiler", kNumAsyncCompilerThreads);
+  }
+  async_compiler_threads_->Schedule([this, flib_def, async_options, function,
+                                     async_args, compile_fn, entry]() {
+    XLA_SCOPED_LOGGING_TIMER("Asynchronous compilation of XLA executable");
+    tensorflow::Env* env = tensorflow::Env::Default();
+    const uint64 compile_start_us = env->NowMicros();
+
+    XlaCompiler compiler(async_options);
+    XlaCompiler::CompilationResult compilation_result;
+    std::unique_ptr<xla::LocalExecutable> executable;
+    Status status = compile_fn(&compiler, async_args, &compilation_result);
+    if (status.ok()) {
+      status =
+          BuildExecutable(async_options, compilation_result, &executable);
+
+      const uint64 compile_time_us = env->NowMicros() - compile_start_us;
+      metrics::UpdateXlaCompilationTime(compile_time_us);
+      Status stats_status =
+          UpdateCompileStats(function.name(), compile_time_us);
+      if (!stats_status.ok()) {
+        LOG(WARNING) << "Failed to record the compilation of "
+                     << function.name() << ": " << stats_status;
+      }
+    }
+
+    mutex_lock entry_lock(entry->mu);
+    entry->compiled = true;
+    entry->compiling_async = false;
+    entry->compilation_status = status;
+    entry->compilation_result = std::move(compilation_result);
+    entry->executable = std::move(executable);
+    entry->async_compilation_done.notify_all();
+  });
+}
+
+Status XlaCompilationCache::UpdateCompileStats(const string& function_name,
+                                               uint64 compile_time_us) {
+  mutex_lock lock(cluster_compile_stats_mu_);
+  auto it = cluster_compile_stats_.find(function_name);
+  it->second.compile_count++;
+  it->second.cumulative_compile_time_us += compile_time_us;
+  LogOnceXlaCompiledFirstCluster();
+  VLOG(1) << "compiled " << function_name << " " << it->second.compile_count
+          << " times, compile time: " << compile_time_us
+          << " us, cumulative: " << it->second.cumulative_compile_time_us
+          << " us ("
+          << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
+                                                           1.0e6)
+          << " / "
+          << tensorflow::strings::HumanReadableElapsedTime(
+                 it->second.cumulative_compile_time_us / 1.0e6)
+          << ")";
+
+  XlaJitCompilationActivity jit_compilation_activity;
+  jit_compilation_activity.set_cluster_name(function_name);
+  jit_compilation_activity.set_compile_count(it->second.compile_count);
+  jit_compilation_activity.set_compile_time_us(compile_time_us);
+  jit_compilation_activity.set_cumulative_compile_time_us(
+      it->second.cumulative_compile_time_us);
+
+  return BroadcastXlaActivity(std::move(jit_compilation_activity));
+}
+
 }  // namespace tensorflow
@@ -50,6 +50,7 @@ class XlaCompilationCache : public ResourceBase {
   enum class CompileMode {
     kLazy,
     kStrict,
+    kAsync,
   };
 
   // Compiles a function into a XlaCompiler::CompilationResult that can be used
@@ -62,7 +63,11 @@ class XlaCompilationCache : public ResourceBase {
   // heuristics, the compilation cache may decide not to compile the cluster at
   // this time.  In this case it returns null into both `out_compilation_result`
   // and `out_executable`.  If `compile_mode` is `kStrict` then the compilation
-  // cache always attempts the compilation on a cache miss.
+  // cache always attempts the compilation on a cache miss.  If `compile_mode`
+  // is `kAsync` then, on a cache miss, the compilation cache starts compiling
+  // the cluster on a background thread and returns null into both
+  // `out_compilation_result` and `out_executable` until that compilation is
+  // done, so that the caller can run the cluster with TensorFlow meanwhile.
   //
   // The result of compilation is written to `*out_compilation_result`, which
   // must be non-null. If `out_executable` is non-null, also builds an
@@ -107,6 +112,10 @@ class XlaCompilationCache : public ResourceBase {
     // compilation, ordered by argument number. Tensors must be in host memory.
     absl::InlinedVector<Tensor, 4> arg_values;
 
+    // Dynamic dimensions of the arguments, as (argument number, dimension,
+    // number of the argument holding its size) triples.
+    absl::InlinedVector<int, 6> dynamic_dims;
+
     bool operator==(const Signature& other) const;
 
     struct Hash {
@@ -123,16 +132,35 @@ class XlaCompilationCache : public ResourceBase {
       absl::Span<const XlaCompiler::Argument> args);
 
  private:
+  // Compiles `args` to an XLA computation with `compiler`. Functions used with
+  // CompileMode::kAsync must not refer to the state of the caller.
+  using CompileFn = std::function<Status(
+      XlaCompiler* compiler, absl::Span<const XlaCompiler::Argument> args,
+      XlaCompiler::CompilationResult*)>;
+
+  // The value associated with a cache entry.
+  struct Entry;
+
   // Common implementation of Compile and CompileSingleOp.
   Status CompileImpl(
       const XlaCompiler::Options& options, const NameAttrList& function,
       absl::Span<const XlaCompiler::Argument> args,
-      const std::function<Status(XlaCompiler* compiler,
-                                 XlaCompiler::CompilationResult*)>& compile_fn,
-      absl::optional<int64> compile_threshold,
+      const CompileFn& compile_fn, CompileMode compile_mode,
       const XlaCompiler::CompilationResult** out_compilation_result,
       xla::LocalExecutable** out_executable);
 
+  // Compiles `entry` on async_compiler_threads_ and publishes the result in
+  // it once done.
+  void CompileAsync(const XlaCompiler::Options& options,
+                    const NameAttrList& function,
+                    absl::Span<const XlaCompiler::Argument> args,
+                    const CompileFn& compile_fn, Entry* entry);
+
+  // Updates the statistics of the cluster `function_name` after a compilation
+  // which took `compile_time_us`.
+  Status UpdateCompileStats(const string& function_name,
+                            uint64 compile_time_us);
+
   // Takes `result` which has been compiled from a Tensorflow subgraph to a
   // XLA computation already, and generates an XLA LocalExecutable `executable`.
   Status BuildExecutable(const XlaCompiler::Options& options,
@@ -142,13 +170,18 @@ class XlaCompilationCache : public ResourceBase {
   xla::LocalClient* const client_;
   const DeviceType device_type_;
 
-  // The value associated with a cache entry.
   struct Entry {
     mutex mu;
 
     // Have we tried compiling this entry?
     bool compiled = false;
 
+    // Is this entry being compiled in the background?
+    bool compiling_async = false;
+
+    // Notified when the background compilation of this entry is done.
+    condition_variable async_compilation_done;
+
     // The number of times a compilation with this signature has been requested.
     int64 request_count = 0;
 
@@ -193,6 +226,16 @@ class XlaCompilationCache : public ResourceBase {
   // signature before  we attempt to compile it.
   static constexpr int64 kDefaultCompilationThreshold = 2;
 
+  // The number of threads compiling clusters in the background.
+  static constexpr int kNumAsyncCompilerThreads = 2;
+
+  mutex async_compiler_threads_mu_;
+
+  // Created on the first asynchronous compilation. Declared last so that its
+  // threads are joined before the other members are destroyed.
+  std::unique_ptr<thread::ThreadPool> async_compiler_threads_
+      TF_GUARDED_BY(async_compiler_threads_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(XlaCompilationCache);
 };
 
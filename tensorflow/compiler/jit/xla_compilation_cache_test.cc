@@ -18,8 +18,12 @@ limitations under the License.
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
 namespace {
@@ -54,6 +58,34 @@ TEST(XlaCompilationCacheTest, SignatureEquality) {
   }
 }
 
+TEST(XlaCompilationCacheTest, SignatureDistinguishesDynamicDimensions) {
+  NameAttrList fn;
+  fn.set_name("afunction");
+  std::vector<XlaCompiler::Argument> args(3);
+  for (int i = 0; i < 2; ++i) {
+    args[i].kind = XlaCompiler::Argument::kParameter;
+    args[i].type = DT_FLOAT;
+    args[i].shape = TensorShape({8, 2});
+  }
+  args[2].kind = XlaCompiler::Argument::kParameter;
+  args[2].type = DT_INT32;
+  args[2].shape = TensorShape({});
+
+  args[0].dynamic_dim_to_arg_num_map[0] = 2;
+  TF_ASSERT_OK_AND_ASSIGN(XlaCompilationCache::Signature s1,
+                          XlaCompilationCache::BuildSignature(fn, args));
+  args[1].dynamic_dim_to_arg_num_map[0] = 2;
+  TF_ASSERT_OK_AND_ASSIGN(XlaCompilationCache::Signature s2,
+                          XlaCompilationCache::BuildSignature(fn, args));
+  TF_ASSERT_OK_AND_ASSIGN(XlaCompilationCache::Signature s3,
+                          XlaCompilationCache::BuildSignature(fn, args));
+
+  EXPECT_FALSE(s1 == s2) << s1.HumanString() << " " << s2.HumanString();
+  EXPECT_TRUE(s2 == s3);
+  EXPECT_EQ(XlaCompilationCache::Signature::Hash()(s2),
+            XlaCompilationCache::Signature::Hash()(s3));
+}
+
 TEST(XlaCompilationCacheTest, TestDisabledXlaCompilation) {
   NameAttrList fn;
   fn.set_name("afunction");
@@ -78,6 +110,65 @@ TEST(XlaCompilationCacheTest, TestDisabledXlaCompilation) {
       absl::StrContains(status.error_message(), "XLA compilation disabled"));
 }
 
+TEST(XlaCompilationCacheTest, AsyncCompilationFallsBackUntilCompiled) {
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(),
+                                     FunctionDefLibrary());
+  TF_ASSERT_OK(flib_def.AddFunctionDef(test::function::XTimesTwo()));
+  NameAttrList fn;
+  fn.set_name("XTimesTwo");
+  (*fn.mutable_attr())["T"].set_type(DT_FLOAT);
+
+  xla::LocalClient* client = xla::ClientLibrary::LocalClientOrDie();
+  XlaCompiler::Options options;
+  options.client = client;
+  options.device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+  options.flib_def = &flib_def;
+  options.graph_def_version = TF_GRAPH_DEF_VERSION;
+
+  auto cache = new XlaCompilationCache(client, options.device_type);
+  core::ScopedUnref cache_ref(cache);
+
+  // Compiles the function for a [size] float argument.
+  auto compile = [&](int64 size, XlaCompilationCache::CompileMode mode,
+                     xla::LocalExecutable** executable) {
+    std::vector<XlaCompiler::Argument> args(1);
+    args[0].kind = XlaCompiler::Argument::kParameter;
+    args[0].type = DT_FLOAT;
+    args[0].shape = TensorShape({size});
+    const XlaCompiler::CompilationResult* compilation_result;
+    return cache->Compile(options, fn, args, XlaCompiler::CompileOptions{},
+                          mode, &compilation_result, executable);
+  };
+
+  // The first request only starts the compilation.
+  xla::LocalExecutable* executable;
+  TF_ASSERT_OK(
+      compile(2, XlaCompilationCache::CompileMode::kAsync, &executable));
+  EXPECT_EQ(executable, nullptr);
+
+  // Later requests get the executable once it is compiled.
+  for (int i = 0; i < 1000 && executable == nullptr; ++i) {
+    Env::Default()->SleepForMicroseconds(10 * 1000);
+    TF_ASSERT_OK(
+        compile(2, XlaCompilationCache::CompileMode::kAsync, &executable));
+  }
+  EXPECT_NE(executable, nullptr);
+
+  // A strict request waits for the pending compilation of its signature
+  // instead of compiling it again.
+  xla::LocalExecutable* async_executable;
+  TF_ASSERT_OK(
+      compile(3, XlaCompilationCache::CompileMode::kAsync, &async_executable));
+  EXPECT_EQ(async_executable, nullptr);
+  xla::LocalExecutable* strict_executable;
+  TF_ASSERT_OK(compile(3, XlaCompilationCache::CompileMode::kStrict,
+                       &strict_executable));
+  EXPECT_NE(strict_executable, nullptr);
+  TF_ASSERT_OK(
+      compile(3, XlaCompilationCache::CompileMode::kAsync, &async_executable));
+  EXPECT_EQ(async_executable, strict_executable);
+}
+
 void BM_BuildSignature(::testing::benchmark::State& state) {
   const int n_args = state.range(0);
 
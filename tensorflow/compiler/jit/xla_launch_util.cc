@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_launch_util.h"
 
+#include <cstring>
 #include <memory>
 
 #include "absl/algorithm/container.h"
@@ -200,15 +201,38 @@ static void PopulateExecutionInputBuffer(xla::ExecutionInput& execution_input,
   }
 }
 
+// Returns a copy of `input`, which must be in host memory, with its leading
+// dimension padded with zeros up to `bucket_size`.
+static xla::StatusOr<Tensor> PadToBucket(OpKernelContext* ctx,
+                                         const Tensor& input,
+                                         int64 bucket_size) {
+  TensorShape shape = input.shape();
+  shape.set_dim(0, bucket_size);
+  Tensor padded;
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(input.dtype(), shape, &padded));
+  StringPiece data = input.tensor_data();
+  char* padded_data = static_cast<char*>(padded.data());
+  std::memcpy(padded_data, data.data(), data.size());
+  std::memset(padded_data + data.size(), 0, padded.TotalBytes() - data.size());
+  return padded;
+}
+
 xla::StatusOr<std::vector<xla::ExecutionInput>>
 XlaComputationLaunchContext::PopulateInputs(
     OpKernelContext* ctx,
     const XlaCompiler::CompilationResult* compilation_result,
     const std::map<int, const Tensor*>& resource_vars,
     int missing_ctx_input_prefix,
-    const xla::HloInputOutputAliasConfig& input_output_alias) {
+    const xla::HloInputOutputAliasConfig& input_output_alias,
+    const BucketedArguments* bucketed_arguments) {
   std::vector<xla::ExecutionInput> arguments;
   arguments.reserve(compilation_result->xla_input_shapes.size());
+  if (bucketed_arguments) {
+    // The inputs are padded on the host, and referenced by pointer below.
+    TF_RET_CHECK(!allocate_xla_tensors_);
+    bucketed_inputs_.clear();
+    bucketed_inputs_.reserve(compilation_result->xla_input_shapes.size());
+  }
 
   xla::TransferManager* transfer_manager =
       client_->backend().transfer_manager();
@@ -228,10 +252,37 @@ XlaComputationLaunchContext::PopulateInputs(
                          return update.input_index == i && update.modified;
                        });
 
-    const Tensor* t = is_resource_variable
-                          ? resource_vars.at(arg_num)
-                          : &(ctx->input(arg_num - missing_ctx_input_prefix));
+    const Tensor* t;
+    if (bucketed_arguments &&
+        arg_num == bucketed_arguments->batch_size_arg) {
+      // The batch size isn't an input of the kernel.
+      Tensor batch_size;
+      TF_RETURN_IF_ERROR(
+          ctx->allocate_temp(DT_INT32, TensorShape({}), &batch_size));
+      batch_size.scalar<int32>()() = bucketed_arguments->batch_size;
+      bucketed_inputs_.push_back(batch_size);
+      t = &bucketed_inputs_.back();
+    } else {
+      t = is_resource_variable
+              ? resource_vars.at(arg_num)
+              : &(ctx->input(arg_num - missing_ctx_input_prefix));
+    }
     CHECK(t);
+    if (bucketed_arguments &&
+        absl::c_binary_search(bucketed_arguments->padded_args, arg_num)) {
+      TF_RET_CHECK(t->dims() > 0 &&
+                   t->dim_size(0) == bucketed_arguments->batch_size)
+          << "Input " << arg_num << " of shape " << t->shape().DebugString()
+          << " doesn't have the batch size "
+          << bucketed_arguments->batch_size;
+      if (bucketed_arguments->batch_size < bucketed_arguments->bucket_size) {
+        TF_ASSIGN_OR_RETURN(
+            Tensor padded,
+            PadToBucket(ctx, *t, bucketed_arguments->bucket_size));
+        bucketed_inputs_.push_back(padded);
+        t = &bucketed_inputs_.back();
+      }
+    }
     bool donate_buffer =
         t->RefCountIsOne() && is_updated_resource_variable &&
         input_output_alias.ParameterHasAlias(i, xla::ShapeIndex{});
@@ -445,14 +496,22 @@ Status XlaComputationLaunchContext::PopulateOutputs(
   std::vector<TensorShape> output_tensor_shapes;
   output_tensor_shapes.reserve(ctx->num_outputs());
   if (output.on_host_shape().is_dynamic()) {
-    TF_ASSIGN_OR_RETURN(
-        auto transfer_manager,
-        xla::TransferManager::GetForPlatform(stream->parent()->platform()));
+    // Devices without a stream, i.e. the host, borrow one to read the shapes.
+    se::Stream* shape_stream = stream;
+    xla::StreamPool::Ptr borrowed_stream;
+    if (shape_stream == nullptr) {
+      TF_ASSIGN_OR_RETURN(borrowed_stream,
+                          client_->backend().BorrowStream(device_ordinal_));
+      shape_stream = borrowed_stream.get();
+    }
+    TF_ASSIGN_OR_RETURN(auto transfer_manager,
+                        xla::TransferManager::GetForPlatform(
+                            shape_stream->parent()->platform()));
 
     xla::Shape output_host_shape = output.on_host_shape();
     xla::Shape output_device_shape = output.on_device_shape();
     TF_RETURN_IF_ERROR(transfer_manager->ReadDynamicShapes(
-        stream, &output, &output_host_shape, &output_device_shape));
+        shape_stream, &output, &output_host_shape, &output_device_shape));
 
     output.set_shapes(output_host_shape, output_device_shape);
     for (int i = 0; i < ctx->num_outputs(); ++i) {
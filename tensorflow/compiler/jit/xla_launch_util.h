@@ -18,6 +18,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_XLA_LAUNCH_UTIL_H_
 #define TENSORFLOW_COMPILER_JIT_XLA_LAUNCH_UTIL_H_
 
+#include "tensorflow/compiler/jit/shape_bucketing.h"
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 #include "tensorflow/compiler/jit/xla_tensor.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
@@ -153,12 +154,18 @@ class XlaComputationLaunchContext {
   // missing and adjusts input indices accordingly.  All elements in kernel's
   // input_mapping must be greater than or equal to `missing_ctx_input_prefix`
   // (in other words, no inputs actually required by the kernel can be missing).
+  //
+  // If `bucketed_arguments` is not null, the computation was compiled for
+  // arguments padded to a bucket, and the inputs are padded the same way. The
+  // padded inputs are owned by this launch context, which must outlive the
+  // execution of the computation.
   xla::StatusOr<std::vector<xla::ExecutionInput>> PopulateInputs(
       OpKernelContext* ctx,
       const XlaCompiler::CompilationResult* compilation_result,
       const std::map<int, const Tensor*>& resource_vars,
       int missing_ctx_input_prefix,
-      const xla::HloInputOutputAliasConfig& input_output_alias);
+      const xla::HloInputOutputAliasConfig& input_output_alias,
+      const BucketedArguments* bucketed_arguments = nullptr);
 
   // Given the XLA output in `output`, populate all outputs of `ctx`.  Also
   // writes out the resource variable updates.
@@ -184,6 +191,9 @@ class XlaComputationLaunchContext {
   bool allocate_xla_tensors_;
   bool use_multiple_streams_;
   int device_ordinal_;
+
+  // Inputs padded to the bucket of the batch size by PopulateInputs.
+  std::vector<Tensor> bucketed_inputs_;
 };
 
 // A simple TensorBuffer implementation that allows us to create Tensors that
@@ -65,10 +65,33 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 
-// Checks that arguments `args` match types `types`.
+// Returns true if argument `arg_num` is an int32 parameter holding the size of
+// a dynamic dimension of another argument.
+bool IsDynamicDimensionSizeArgument(
+    absl::Span<const XlaCompiler::Argument> args, int arg_num) {
+  if (args[arg_num].kind != XlaCompiler::Argument::kParameter ||
+      args[arg_num].type != DT_INT32) {
+    return false;
+  }
+  for (const XlaCompiler::Argument& arg : args) {
+    for (const auto& dim_and_arg_num : arg.dynamic_dim_to_arg_num_map) {
+      if (dim_and_arg_num.second == arg_num) return true;
+    }
+  }
+  return false;
+}
+
+// Checks that arguments `args` match types `types`. Arguments beyond `types`
+// are only allowed if they hold the size of a dynamic dimension of other
+// arguments, as they don't correspond to any parameter of the function.
 Status CheckSignature(const DataTypeVector& types,
                       absl::Span<const XlaCompiler::Argument> args) {
-  if (args.size() != types.size()) {
+  bool arity_matches = args.size() >= types.size();
+  for (int i = types.size(), end = args.size(); arity_matches && i < end;
+       ++i) {
+    arity_matches = IsDynamicDimensionSizeArgument(args, i);
+  }
+  if (!arity_matches) {
     return errors::Internal("Compilation arguments have ", args.size(),
                             " elements while function has ", types.size());
   }
@@ -737,7 +760,7 @@ Status XlaCompiler::CompileFunction(
   // Set shapes for _Arg nodes. They are useful for constant folding (e.g. an
   // Xla op requires a compile-time constant input, and that input is shape of
   // an _Arg node.
-  for (int i = 0, end = args.size(); i < end; i++) {
+  for (int i = 0, end = fbody->arg_types.size(); i < end; i++) {
     // Skip resource variables and tensor lists.
     DataType dtype;
     TF_RETURN_IF_ERROR(GetNodeAttr(fbody->arg_nodes[i]->def(), "T", &dtype));
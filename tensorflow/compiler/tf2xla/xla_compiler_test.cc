@@ -1856,6 +1856,43 @@ TEST_F(XlaCompilerTest, DoNotConstantFoldShapeOp) {
   EXPECT_TRUE(xla::LiteralTestUtil::Equal(expected_literal, actual_literal));
 }
 
+// Tests that a function can be compiled with an extra argument holding the
+// size of a dynamic dimension of one of its parameters.
+TEST_F(XlaCompilerTest, FunctionWithDynamicDimensionSizeArgument) {
+  TF_ASSERT_OK(flib_def_->AddFunctionDef(test::function::XTimesTwo()));
+  NameAttrList name_attr;
+  name_attr.set_name("XTimesTwo");
+  (*name_attr.mutable_attr())["T"].set_type(DT_FLOAT);
+
+  std::vector<XlaCompiler::Argument> args(2);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_FLOAT;
+  args[0].shape = TensorShape({4});
+  args[1].kind = XlaCompiler::Argument::kParameter;
+  args[1].type = DT_INT32;
+  args[1].shape = TensorShape({});
+
+  // Arguments which don't hold a dynamic size don't match the function.
+  XlaCompiler compiler(DefaultOptions());
+  XlaCompiler::CompilationResult result;
+  Status status = compiler.CompileFunction(XlaCompiler::CompileOptions(),
+                                           name_attr, args, &result);
+  EXPECT_FALSE(status.ok());
+  EXPECT_TRUE(absl::StrContains(status.error_message(),
+                                "Compilation arguments have 2 elements"))
+      << status.error_message();
+
+  args[0].dynamic_dim_to_arg_num_map.insert({0, 1});
+  TF_ASSERT_OK(compiler.CompileFunction(XlaCompiler::CompileOptions(),
+                                        name_attr, args, &result));
+  ASSERT_EQ(result.xla_input_shapes.size(), 2);
+  EXPECT_EQ(result.input_mapping, std::vector<int>({0, 1}));
+  const xla::Shape& output_shape =
+      xla::ShapeUtil::GetTupleElementShape(result.xla_output_shape, 0);
+  EXPECT_TRUE(output_shape.is_dynamic_dimension(0))
+      << xla::ShapeUtil::HumanString(result.xla_output_shape);
+}
+
 TEST_F(XlaCompilerTest, AliasResourceUpdates) {
   Scope scope = Scope::NewRootScope().ExitOnError();
   auto a = ops::Const<int32>(scope.WithOpName("A"), {1, 2});
@@ -138,6 +138,15 @@ static void AllocateFlags() {
     };
   };
 
+  // Returns a lambda that calls "member_setter" on "flag_values" with the
+  // argument passed in to the lambda.
+  auto int64_setter_for = [](void (DebugOptions::*member_setter)(int64)) {
+    return [member_setter](int64 value) {
+      (flag_values->*member_setter)(value);
+      return true;
+    };
+  };
+
   auto string_setter_for =
       [](void (DebugOptions::*member_setter)(const string& value)) {
         return [member_setter](const string& value) {
@@ -562,6 +571,33 @@ static void AllocateFlags() {
       flag_values->xla_cpu_enable_xprof_traceme(),
       "If true, XLA CPU generates code to call "
       "TraceMe::Activity{Start|End} around HLO operations."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cpu_persistent_cache_dir",
+      string_setter_for(&DebugOptions::set_xla_cpu_persistent_cache_dir), "",
+      "If set, XLA CPU stores the object code it generates in this directory "
+      "and reuses it for identical modules compiled with the same options on "
+      "the same CPU, also across processes."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cpu_rematerialization_memory_limit_bytes",
+      int64_setter_for(
+          &DebugOptions::set_xla_cpu_rematerialization_memory_limit_bytes),
+      flag_values->xla_cpu_rematerialization_memory_limit_bytes(),
+      "If positive, XLA CPU rematerializes instructions to reduce the peak "
+      "memory use of each module to this many bytes. 0 disables "
+      "rematerialization."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cpu_log_compilation_stats",
+      bool_setter_for(&DebugOptions::set_xla_cpu_log_compilation_stats),
+      flag_values->xla_cpu_log_compilation_stats(),
+      "If true, XLA CPU logs the time taken by each HLO pass and by the LLVM "
+      "code generation of each module."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cpu_parallel_codegen_split_count",
+      int32_setter_for(
+          &DebugOptions::set_xla_cpu_parallel_codegen_split_count),
+      flag_values->xla_cpu_parallel_codegen_split_count(),
+      "If greater than 1, XLA CPU splits the LLVM module of each computation "
+      "into up to this many parts, which it compiles in parallel."));
   flag_objects->push_back(tensorflow::Flag(
       "xla_gpu_unsafe_fallback_to_driver_on_ptxas_not_found",
       bool_setter_for(
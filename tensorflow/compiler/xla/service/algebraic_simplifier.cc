@@ -5543,4 +5543,51 @@ StatusOr<bool> AlgebraicSimplifier::Run(HloModule* module) {
   return changed;
 }
 
+// Returns whether `computation` or one of the computations it calls is in
+// `changed`. The simplification of an instruction depends on the computations
+// it calls, like the reducer of a reduce, so their callers have to be
+// revisited when they change.
+static bool ComputationOrCalleeChanged(
+    HloComputation* computation,
+    const absl::flat_hash_set<HloComputation*>& changed) {
+  if (changed.contains(computation)) {
+    return true;
+  }
+  for (HloInstruction* instruction : computation->instructions()) {
+    for (HloComputation* callee : instruction->called_computations()) {
+      if (changed.contains(callee)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+Status AlgebraicSimplifier::RunOnChangedComputations(HloModule* module,
+                                                     RunState* run_state) {
+  XLA_VLOG_LINES(2,
+                 "AlgebraicSimplifier::RunOnChangedComputations(), before:\n" +
+                     module->ToString());
+  const absl::flat_hash_set<HloComputation*> computations_before(
+      module->computations().begin(), module->computations().end());
+  AlgebraicSimplifierVisitor visitor(options_, this);
+  for (auto* comp : module->MakeNonfusionComputations()) {
+    if (ComputationOrCalleeChanged(comp, run_state->changed_last_iteration) &&
+        visitor.Run(comp, options_, this)) {
+      run_state->changed_this_iteration.insert(comp);
+    }
+  }
+  // Some simplifications add computations, like the reducers of the reduces
+  // they create.
+  for (HloComputation* computation : module->computations()) {
+    if (!computations_before.contains(computation)) {
+      run_state->changed_this_iteration.insert(computation);
+    }
+  }
+  XLA_VLOG_LINES(2,
+                 "AlgebraicSimplifier::RunOnChangedComputations(), after:\n" +
+                     module->ToString());
+  return Status::OK();
+}
+
 }  // namespace xla
@@ -188,6 +188,11 @@ class AlgebraicSimplifier : public HloModulePass {
   // computation was changed.
   StatusOr<bool> Run(HloModule* module) override;
 
+  // Only simplifies the computations changed in the last iteration, and those
+  // calling them.
+  Status RunOnChangedComputations(HloModule* module,
+                                  RunState* run_state) override;
+
   // Create constant from literal with tiles and element size updated in the
   // constant's layout.
   std::unique_ptr<HloInstruction> CreateConstantWithLayoutUpdated(
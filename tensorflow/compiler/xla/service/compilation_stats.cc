@@ -53,7 +53,9 @@ class Stats : public CompilationStats {
     PassInfo(absl::string_view name, double duration)
         : name(name), duration_ms(duration) {}
 
-    absl::string_view name;
+    // Owned, as the stats may outlive the passes, e.g. when they are shared by
+    // several pipelines.
+    std::string name;
     int num_runs = 1;
     double duration_ms;
   };
@@ -62,7 +64,7 @@ class Stats : public CompilationStats {
   std::vector<PassInfo> passes_;
   // Used to avoid nested calls to StartPass.
   bool pass_running_ = false;
-  absl::string_view current_pass_;
+  std::string current_pass_;
   // The start time of the currently running pass.
   uint64 start_micros_;
 };
@@ -81,7 +83,7 @@ void Stats::StartPass(absl::string_view pass_name) {
   CHECK(!pass_running_) << "Can't start " << pass_name << " while running "
                         << current_pass_;
   pass_running_ = true;
-  current_pass_ = pass_name;
+  current_pass_ = std::string(pass_name);
   start_micros_ = tensorflow::Env::Default()->NowMicros();
 }
 
@@ -96,11 +98,11 @@ void Stats::EndPass(absl::string_view pass_name) {
 
 void Stats::CompilationReport() {
   CHECK(!pass_running_) << "EndPass never called for " << current_pass_;
-  absl::flat_hash_map<absl::string_view, PassInfo> summary;
+  absl::flat_hash_map<std::string, PassInfo> summary;
   double total_duration = 0;
 
   for (auto& pass_run : passes_) {
-    auto pass_name = pass_run.name;
+    const std::string& pass_name = pass_run.name;
     total_duration += pass_run.duration_ms;
     auto it = summary.find(pass_name);
     if (it == summary.end()) {
@@ -121,7 +123,7 @@ void Stats::CompilationReport() {
     return std::make_pair(b.duration_ms, a.name) <
            std::make_pair(a.duration_ms, b.name);
   });
-  LOG(INFO) << "Total runtime (ms) of HLO passes: " << total_duration;
+  LOG(INFO) << "Total runtime (ms) of passes: " << total_duration;
   LOG(INFO) << "Pass name, num runs, time (ms)";
   for (auto& pass_info : sorted_summary) {
     LOG(INFO) << pass_info.name << ", " << pass_info.num_runs << ", "
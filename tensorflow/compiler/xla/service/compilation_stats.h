@@ -25,9 +25,11 @@ namespace xla {
 
 // This class is used to collect information about HLO passes and print some
 // statistics at the end of compilation. From HloPassPipeline, we call StartPass
-// before the execution of a pass, and EndPass after. Currently, we only collect
-// timing information and how many times each pass was run. In the future, we
-// can add more things, such as the size of the HLO graph after each pass.
+// before the execution of a pass, and EndPass after. Backends can time their
+// other compilation phases, such as LLVM code generation, the same way, with
+// the same stats as their pipelines. Currently, we only collect timing
+// information and how many times each pass was run. In the future, we can add
+// more things, such as the size of the HLO graph after each pass.
 class CompilationStats {
  public:
   virtual ~CompilationStats() = default;
@@ -30,6 +30,7 @@ limitations under the License.
 #include "absl/base/call_once.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/IR/Function.h"
@@ -40,6 +41,7 @@ limitations under the License.
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
@@ -59,9 +61,11 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/batch_dot_simplification.h"
 #include "tensorflow/compiler/xla/service/batchnorm_expander.h"
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
+#include "tensorflow/compiler/xla/service/call_graph.h"
 #include "tensorflow/compiler/xla/service/call_inliner.h"
 #include "tensorflow/compiler/xla/service/cholesky_expander.h"
 #include "tensorflow/compiler/xla/service/comparison_expander.h"
+#include "tensorflow/compiler/xla/service/compilation_stats.h"
 #include "tensorflow/compiler/xla/service/conditional_canonicalizer.h"
 #include "tensorflow/compiler/xla/service/conditional_simplifier.h"
 #include "tensorflow/compiler/xla/service/conditional_to_select.h"
@@ -77,7 +81,9 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emitter.h"
+#include "tensorflow/compiler/xla/service/cpu/parallel_codegen.h"
 #include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
+#include "tensorflow/compiler/xla/service/cpu/persistent_object_cache.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
 #include "tensorflow/compiler/xla/service/dot_decomposer.h"
@@ -86,6 +92,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/dynamic_padder.h"
 #include "tensorflow/compiler/xla/service/flatten_call_graph.h"
 #include "tensorflow/compiler/xla/service/gather_expander.h"
+#include "tensorflow/compiler/xla/service/heap_simulator.h"
 #include "tensorflow/compiler/xla/service/hlo.pb.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_constant_folding.h"
@@ -99,6 +106,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_pass_fix.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 #include "tensorflow/compiler/xla/service/hlo_proto_util.h"
+#include "tensorflow/compiler/xla/service/hlo_rematerialization.h"
 #include "tensorflow/compiler/xla/service/hlo_subcomputation_unification.h"
 #include "tensorflow/compiler/xla/service/hlo_verifier.h"
 #include "tensorflow/compiler/xla/service/indexed_array_analysis.h"
@@ -128,6 +136,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/platform/dynamic_annotations.h"
+#include "tensorflow/core/platform/numbers.h"
 
 namespace {
 
@@ -261,12 +270,50 @@ class CollectProfileCandidates : public DfsHloVisitorWithDefault {
   const std::unordered_map<const HloInstruction*, int64>& assigned_indices_;
 };
 
+// Returns the algorithm which orders the instructions of each computation for
+// emission. JIT compiles use the cheaper DFS scheduler.
+ModuleSchedulerAlgorithm SchedulerAlgorithm(bool is_aot_compile) {
+  if (is_aot_compile) {
+    return {};
+  }
+  return ComputationSchedulerToModuleScheduler(DFSMemoryScheduler);
+}
+
+// Returns the order in which the instructions of `module` are emitted.
+// Rematerialization leaves its schedule on the module, and is the only pass
+// keeping it up to date: the rematerialized instructions only reduce memory
+// use in that order.
+StatusOr<HloSchedule> EmissionSchedule(
+    HloModule* module, const LogicalBuffer::SizeFunction& size_function,
+    bool is_aot_compile) {
+  if (module->has_schedule() &&
+      module->config()
+              .debug_options()
+              .xla_cpu_rematerialization_memory_limit_bytes() > 0) {
+    return module->schedule();
+  }
+  return ScheduleModule(module, size_function,
+                        SchedulerAlgorithm(is_aot_compile));
+}
+
+// Returns the stats timing the compilation of a module with `config`, which
+// are only logged if xla_cpu_log_compilation_stats is set.
+std::unique_ptr<CompilationStats> MakeCompilationStats(
+    const HloModuleConfig& config) {
+  if (config.debug_options().xla_cpu_log_compilation_stats()) {
+    return CompilationStats::MakeStats();
+  }
+  return CompilationStats::MakeNoopStats();
+}
+
 }  // namespace
 
 Status CpuCompiler::RunHloPassesThroughLayoutAssn(
     HloModule* module, bool /*is_aot_compile*/,
-    LLVMTargetMachineFeatures* target_machine_features) {
-  HloPassPipeline pipeline("HLO passes through layout assignment");
+    LLVMTargetMachineFeatures* target_machine_features,
+    CompilationStats* compilation_stats) {
+  HloPassPipeline pipeline("HLO passes through layout assignment",
+                           compilation_stats);
   pipeline.AddInvariantChecker<HloVerifier>(/*layout_sensitive=*/false,
                                             /*allow_mixed_precision=*/false);
   // Expand random number generation.
@@ -315,8 +362,12 @@ Status CpuCompiler::RunHloPassesThroughLayoutAssn(
   pipeline.AddPass<ScatterExpander>(ScatterExpander::kEliminateAllScatters);
   pipeline.AddPass<ConvCanonicalization>(target_machine_features);
   {
+    // The simplifications below only look into the computations called
+    // directly by an instruction, which is what an incremental fixed point
+    // loop revisits after a change.
     auto& pass =
         pipeline.AddPass<HloPassFix<HloPassPipeline>>("simplification");
+    pass.set_incremental(true);
     pass.AddInvariantCheckerDebug<HloVerifier>(/*layout_sensitive=*/false,
                                                /*allow_mixed_precision=*/false);
 
@@ -367,15 +418,17 @@ Status CpuCompiler::RunHloPassesThroughLayoutAssn(
       module->mutable_entry_computation_layout(),
       LayoutAssignment::InstructionCanChangeLayout, target_machine_features);
 
-  pipeline.AddPass<CpuInstructionFusion>();
+  pipeline.AddPass<CpuInstructionFusion>(target_machine_features);
 
   return pipeline.Run(module).status();
 }
 
 Status CpuCompiler::RunHloPassesAfterLayoutAssn(
     HloModule* module, bool is_aot_compile,
-    LLVMTargetMachineFeatures* target_machine_features) {
-  HloPassPipeline pipeline("HLO passes after layout assignment");
+    LLVMTargetMachineFeatures* target_machine_features,
+    CompilationStats* compilation_stats) {
+  HloPassPipeline pipeline("HLO passes after layout assignment",
+                           compilation_stats);
   // After layout assignment, use a layout-sensitive verifier.
 
   pipeline.AddPass<HloPassPipeline>("after layout assignment")
@@ -388,6 +441,7 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
   {
     auto& pass = pipeline.AddPass<HloPassFix<HloPassPipeline>>(
         "simplification after layout assignment");
+    pass.set_incremental(true);
     pass.AddInvariantCheckerDebug<HloVerifier>(
         /*layout_sensitive=*/true,
         /*allow_mixed_precision=*/false,
@@ -407,12 +461,13 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
       module->config().intra_op_parallelism_threads() > 0
           ? module->config().intra_op_parallelism_threads()
           : tensorflow::port::NumSchedulableCPUs();
-  if (!is_aot_compile) {
+  if (!is_aot_compile ||
+      module->config().intra_op_parallelism_threads() > 1) {
     // Run ParallelTaskAssigner to assign parallel tasks to HLOs in module.
-    // Note this is not run for AOT because it would bring in thread pool
-    // and thread synchronization dependencies which would likely increase
-    // binary size (and most AOT applications are single-threaded).
-    // TODO(b/29630486) Support multi-threaded AOT.
+    // Note this is only run for AOT if it asks for more than one thread,
+    // because it brings in the fork/join runtime and thread synchronization
+    // dependencies which increase binary size (and most AOT applications are
+    // single-threaded).
     pipeline.AddPass<ParallelTaskAssigner>(
         max_parallelism, ShapeSizeBytesFunction(), target_machine_features);
   }
@@ -425,16 +480,75 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
   pipeline.AddPass<HloDCE>();
   pipeline.AddPass<CopyInsertion>();
   pipeline.AddPass<HloDCE>();
-  return pipeline.Run(module).status();
+  TF_RETURN_IF_ERROR(pipeline.Run(module).status());
+
+  // Rematerialization needs the emission schedule, so it runs after all the
+  // passes which may change the module.
+  if (module->config()
+          .debug_options()
+          .xla_cpu_rematerialization_memory_limit_bytes() > 0) {
+    compilation_stats->StartPass("cpu-rematerialization");
+    TF_RETURN_IF_ERROR(RematerializeToMemoryLimit(module, is_aot_compile));
+    compilation_stats->EndPass("cpu-rematerialization");
+  }
+  return Status::OK();
+}
+
+Status CpuCompiler::RematerializeToMemoryLimit(HloModule* module,
+                                               bool is_aot_compile) {
+  const int64 memory_limit_bytes =
+      module->config()
+          .debug_options()
+          .xla_cpu_rematerialization_memory_limit_bytes();
+  TF_ASSIGN_OR_RETURN(HloSchedule schedule,
+                      ScheduleModule(module, BufferSizeBytesFunction(),
+                                     SchedulerAlgorithm(is_aot_compile)));
+  TF_RETURN_IF_ERROR(module->set_schedule(std::move(schedule)));
+  TF_ASSIGN_OR_RETURN(const int64 peak_memory_before,
+                      HeapSimulator::MinimumMemoryForModule(
+                          module->schedule(), BufferSizeBytesFunction()));
+
+  // XLA:CPU has no compact layouts to compress buffers into, so only
+  // recompute. Blocks of a single instruction keep the compile time of large
+  // modules reasonable; the fused computations make each instruction coarse
+  // already.
+  HloRematerialization rematerialization(
+      ShapeSizeBytesFunction(), memory_limit_bytes, /*sizes=*/nullptr,
+      HloRematerialization::RematerializationPass::kPostFusion,
+      /*block_size_limit=*/1, /*compact_shape_function=*/nullptr,
+      HloRematerialization::RematerializationMode::kRecomputeOnly);
+  TF_ASSIGN_OR_RETURN(bool changed, rematerialization.Run(module));
+  if (!changed) {
+    return Status::OK();
+  }
+
+  TF_ASSIGN_OR_RETURN(const int64 peak_memory_after,
+                      HeapSimulator::MinimumMemoryForModule(
+                          module->schedule(), BufferSizeBytesFunction()));
+  VLOG(1) << "Rematerialization reduced the peak memory of " << module->name()
+          << " from "
+          << tensorflow::strings::HumanReadableNumBytes(peak_memory_before)
+          << " to "
+          << tensorflow::strings::HumanReadableNumBytes(peak_memory_after)
+          << " (limit "
+          << tensorflow::strings::HumanReadableNumBytes(memory_limit_bytes)
+          << ")";
+  return Status::OK();
 }
 
 Status CpuCompiler::RunHloPasses(HloModule* module, bool is_aot_compile,
                                  llvm::TargetMachine* target_machine) {
   LLVMTargetMachineFeatures target_machine_features(target_machine);
-  TF_RETURN_IF_ERROR(RunHloPassesThroughLayoutAssn(module, is_aot_compile,
-                                                   &target_machine_features));
-  return RunHloPassesAfterLayoutAssn(module, is_aot_compile,
-                                     &target_machine_features);
+  std::unique_ptr<CompilationStats> compilation_stats =
+      MakeCompilationStats(module->config());
+  TF_RETURN_IF_ERROR(RunHloPassesThroughLayoutAssn(
+      module, is_aot_compile, &target_machine_features,
+      compilation_stats.get()));
+  TF_RETURN_IF_ERROR(RunHloPassesAfterLayoutAssn(module, is_aot_compile,
+                                                 &target_machine_features,
+                                                 compilation_stats.get()));
+  compilation_stats->CompilationReport();
+  return Status::OK();
 }
 
 namespace {
@@ -574,9 +688,8 @@ CpuCompiler::RunHloPassesAndBufferAssignement(
   // Using this sequence enables tighter buffer liveness analysis and reduced
   // memory usage (as compared to using DependencyHloOrdering).
   TF_ASSIGN_OR_RETURN(HloSchedule schedule,
-                      ScheduleModule(module.get(), BufferSizeBytesFunction(),
-                                     ComputationSchedulerToModuleScheduler(
-                                         DFSMemoryScheduler)));
+                      EmissionSchedule(module.get(), BufferSizeBytesFunction(),
+                                       /*is_aot_compile=*/false));
 
   // Run buffer allocation on the HLO graph.
   TF_ASSIGN_OR_RETURN(
@@ -595,12 +708,15 @@ namespace {
 //
 // Dumps machine code if dumping is enabled for the module.
 struct OrcJITPostCompilationHook {
-  // Gets an std::function that implements this hook.
+  // Gets an std::function that implements this hook. If `object_code` isn't
+  // null, the hook also copies the generated object code into it.
   static std::function<void(const llvm::object::ObjectFile& obj_file)> Create(
-      const HloModule* module) {
+      const HloModule* module,
+      std::shared_ptr<string> object_code = nullptr) {
     // This struct is not copyable, but std::functions must be.  So to create an
     // std::function out of this struct, we have to wrap it in a shared_ptr.
-    auto wrapped = std::make_shared<OrcJITPostCompilationHook>(module);
+    auto wrapped = std::make_shared<OrcJITPostCompilationHook>(
+        module, std::move(object_code));
     return [wrapped](const llvm::object::ObjectFile& obj_file) {
       (*wrapped)(obj_file);
     };
@@ -608,11 +724,16 @@ struct OrcJITPostCompilationHook {
 
   // Constructor can't be private because we want to call it from
   // std::make_shared, but users should call Create() instead.
-  explicit OrcJITPostCompilationHook(const HloModule* module)
-      : module(module) {}
+  OrcJITPostCompilationHook(const HloModule* module,
+                            std::shared_ptr<string> object_code)
+      : module(module), object_code(std::move(object_code)) {}
 
  private:
   void operator()(const llvm::object::ObjectFile& obj_file) {
+    if (object_code != nullptr) {
+      object_code->assign(obj_file.getData().data(),
+                          obj_file.getData().size());
+    }
     if (!DumpingEnabledForHloModule(*module)) {
       return;
     }
@@ -622,6 +743,7 @@ struct OrcJITPostCompilationHook {
   }
 
   const HloModule* module;
+  std::shared_ptr<string> object_code;
 };
 
 }  // namespace
@@ -651,6 +773,28 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
   auto llvm_module =
       absl::make_unique<llvm::Module>("__compute_module", *llvm_context);
 
+  // The persistent object cache can't restore the profiling artifacts nor the
+  // IR embedded in the executable, so it is only used without them.
+  const string& persistent_cache_dir =
+      module->config().debug_options().xla_cpu_persistent_cache_dir();
+  absl::optional<PersistentObjectCache> persistent_cache;
+  std::shared_ptr<string> object_code;
+  if (!persistent_cache_dir.empty() &&
+      !module->config().hlo_profiling_enabled() &&
+      !module->config().debug_options().xla_embed_ir_in_executable()) {
+    persistent_cache.emplace(persistent_cache_dir);
+    object_code = std::make_shared<string>();
+  }
+
+  // The persistent object cache stores the object code of a single module, so
+  // the module is only split without it.
+  const int parallel_codegen_split_count =
+      persistent_cache
+          ? 1
+          : module->config()
+                .debug_options()
+                .xla_cpu_parallel_codegen_split_count();
+
   auto jit = SimpleOrcJIT::Create(
       CompilerTargetOptions(module->config()),
       CodeGenOptLevel(module->config()),
@@ -658,7 +802,7 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
       module->config().debug_options().xla_llvm_disable_expensive_passes(),
       llvm_ir::GetCpuFastMathFlags(module->config()), pre_optimization_ir_hook,
       post_optimization_ir_hook,
-      OrcJITPostCompilationHook::Create(module.get()));
+      OrcJITPostCompilationHook::Create(module.get(), object_code));
   if (!jit) {
     return InternalError("Creating JIT failed: %s",
                          llvm::toString(jit.takeError()));
@@ -688,9 +832,8 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
   // computation. Using this sequence enables tighter buffer liveness analysis
   // and reduced memory usage (as compared to using DependencyHloOrdering).
   TF_ASSIGN_OR_RETURN(HloSchedule schedule,
-                      ScheduleModule(module.get(), BufferSizeBytesFunction(),
-                                     ComputationSchedulerToModuleScheduler(
-                                         DFSMemoryScheduler)));
+                      EmissionSchedule(module.get(), BufferSizeBytesFunction(),
+                                       /*is_aot_compile=*/false));
 
   // Run buffer allocation on the HLO graph.
   TF_ASSIGN_OR_RETURN(
@@ -701,6 +844,37 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
                           /*allocate_buffers_for_constants=*/true));
   DumpHloModuleIfEnabled(*module, *assignment, "after_optimizations");
 
+  string persistent_cache_key;
+  if (persistent_cache) {
+    persistent_cache_key =
+        PersistentObjectCache::Key(*module, *(*jit)->target_machine());
+    absl::optional<PersistentObjectCache::Entry> entry =
+        persistent_cache->Lookup(persistent_cache_key);
+    if (entry) {
+      VLOG(1) << "Loading " << module->name()
+              << " from the persistent object cache, key "
+              << persistent_cache_key;
+      llvm::Error error =
+          (*jit)->AddObjectFile(llvm::MemoryBuffer::getMemBufferCopy(
+              entry->object_code, module->name()));
+      if (error) {
+        return InternalError("Loading cached object code failed: %s",
+                             llvm::toString(std::move(error)));
+      }
+      auto executable = absl::make_unique<CpuExecutable>(
+          std::move(*jit), std::move(assignment), std::move(module),
+          entry->entry_function_name, /*hlo_profile_printer_data=*/nullptr,
+          /*hlo_profile_index_map=*/nullptr);
+      executable->set_loaded_from_persistent_cache(true);
+      VLOG(1) << "Compilation finished";
+      return std::unique_ptr<Executable>(std::move(executable));
+    }
+  }
+
+  std::unique_ptr<CompilationStats> compilation_stats =
+      MakeCompilationStats(module->config());
+  compilation_stats->StartPass("llvm-ir-emission");
+
   // Each computation is a single function.  Emit all embedded computations
   // before the entry computation. The order of computations returned from
   // GetEmbeddedComputations guarantees that a called computation occurs
@@ -720,18 +894,29 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
 
   TF_RETURN_IF_ERROR(ir_emitter.EmitConstantGlobals());
 
+  std::unique_ptr<CallGraph> call_graph;
+  if (parallel_codegen_split_count > 1) {
+    call_graph = CallGraph::Build(module.get());
+  }
   for (auto embedded_computation :
        entry_computation->MakeEmbeddedComputationsList()) {
     if (embedded_computation->IsFusionComputation()) {
       continue;
     }
-    TF_RETURN_IF_ERROR(
-        ir_emitter
-            .EmitComputation(
-                embedded_computation, embedded_computation->name(),
-                /*is_top_level_computation=*/false,
-                schedule.sequence(embedded_computation).instructions())
-            .status());
+    TF_ASSIGN_OR_RETURN(
+        llvm::Function * function,
+        ir_emitter.EmitComputation(
+            embedded_computation, embedded_computation->name(),
+            /*is_top_level_computation=*/false,
+            schedule.sequence(embedded_computation).instructions()));
+    // The computations called by control flow run whole on each call, so they
+    // gain little from being inlined, and the module is split at them. The
+    // others, such as reducers, stay with their callers.
+    if (call_graph != nullptr &&
+        call_graph->GetNode(embedded_computation).context() ==
+            CallContext::kSequential) {
+      MakeSplitPoint(function);
+    }
   }
   string function_name_prefix = entry_computation->name().empty()
                                     ? "__compute"
@@ -755,14 +940,62 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
   }
 
   TF_RETURN_IF_ERROR(VerifyLlvmModule(*llvm_module));
-
-  // JIT compile the LLVM IR module to in-memory machine code.
-  llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
-                                                 std::move(llvm_context));
-  cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  compilation_stats->EndPass("llvm-ir-emission");
+
+  compilation_stats->StartPass("llvm-codegen");
+  if (parallel_codegen_split_count > 1) {
+    // The parts are compiled without hooks: the IR is dumped before it is
+    // split, but neither the optimized IR nor the object code are.
+    if (pre_optimization_ir_hook) {
+      pre_optimization_ir_hook(*llvm_module);
+    }
+    const HloModuleConfig& config = module->config();
+    TF_ASSIGN_OR_RETURN(
+        std::vector<std::unique_ptr<llvm::MemoryBuffer>> object_files,
+        SplitAndCompileModule(
+            std::move(llvm_module), parallel_codegen_split_count,
+            [&config](llvm::Module& part)
+                -> llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> {
+              // Target machines aren't thread-safe, so each part gets its own.
+              std::unique_ptr<llvm::TargetMachine> target_machine =
+                  SimpleOrcJIT::InferTargetMachineForJIT(
+                      CompilerTargetOptions(config), CodeGenOptLevel(config));
+              CompilerFunctor compiler_functor(
+                  target_machine.get(), CodeGenOptLevel(config),
+                  options::OptimizeForSizeRequested(config),
+                  config.debug_options().xla_llvm_disable_expensive_passes(),
+                  llvm_ir::GetCpuFastMathFlags(config));
+              return compiler_functor(part);
+            }));
+    for (std::unique_ptr<llvm::MemoryBuffer>& object_file : object_files) {
+      llvm::Error error = (*jit)->AddObjectFile(std::move(object_file));
+      if (error) {
+        return InternalError("Loading object code failed: %s",
+                             llvm::toString(std::move(error)));
+      }
+    }
+  } else {
+    // JIT compile the LLVM IR module to in-memory machine code.
+    llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
+                                                   std::move(llvm_context));
+    cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  }
   cpu_executable.reset(new CpuExecutable(
       std::move(*jit), std::move(assignment), std::move(module), function_name,
       std::move(hlo_profile_printer_data), std::move(hlo_profile_index_map)));
+  compilation_stats->EndPass("llvm-codegen");
+  compilation_stats->CompilationReport();
+
+  // Constructing the executable looked up the entry function, which compiled
+  // the module and ran the post codegen hook.
+  if (persistent_cache && !object_code->empty()) {
+    Status status = persistent_cache->Store(
+        persistent_cache_key, {function_name, std::move(*object_code)});
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to store " << cpu_executable->module().name()
+                   << " in the persistent object cache: " << status;
+    }
+  }
 
   if (embed_ir_in_executable) {
     static_cast<CpuExecutable&>(*cpu_executable)
@@ -881,11 +1114,18 @@ CpuCompiler::CompileAheadOfTime(std::unique_ptr<HloModuleGroup> module_group,
     HloModule* module = modules[i].get();
     VLOG(1) << "Compiling ahead-of-time: " << module->name();
 
+    if (options.parallelism() > 1) {
+      HloModuleConfig config = module->config();
+      config.set_intra_op_parallelism_threads(options.parallelism());
+      module->set_config(config);
+    }
+
     TF_RETURN_IF_ERROR(
         RunHloPasses(module, /*is_aot_compile=*/true, target_machine.get()));
 
     TF_ASSIGN_OR_RETURN(HloSchedule schedule,
-                        ScheduleModule(module, BufferSizeBytesFunction()));
+                        EmissionSchedule(module, BufferSizeBytesFunction(),
+                                         /*is_aot_compile=*/true));
 
     // Run buffer analysis on the HLO graph. This analysis figures out which
     // temporary buffers are required to run the computation.
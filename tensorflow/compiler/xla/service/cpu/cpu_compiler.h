@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/types/span.h"
 #include "llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/cpu_function_runtime.h"
+#include "tensorflow/compiler/xla/service/compilation_stats.h"
 #include "tensorflow/compiler/xla/service/cpu/target_machine_features.h"
 #include "tensorflow/compiler/xla/service/executable.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
@@ -70,12 +71,20 @@ class CpuAotCompilationOptions : public AotCompilationOptions {
   // The relocation model used for compilation.
   RelocationModel relocation_model() const { return relocation_model_; }
 
+  // The number of threads the compiled code is partitioned for.  If greater
+  // than 1, large instructions are split into partitions which run on the
+  // intra-op thread pool of the run options, if one is set.  Otherwise the
+  // compiled code is single-threaded.
+  int parallelism() const { return parallelism_; }
+  void set_parallelism(int parallelism) { parallelism_ = parallelism; }
+
  private:
   const string triple_;
   const string cpu_name_;
   const string features_;
   const string entry_point_name_;
   const RelocationModel relocation_model_;
+  int parallelism_ = 1;
 };
 
 class CpuAotCompilationResult : public AotCompilationResult {
@@ -167,12 +176,19 @@ class CpuCompiler : public LLVMCompiler {
   // Runs HLO passes up to and including layout assignment.
   Status RunHloPassesThroughLayoutAssn(
       HloModule* module, bool /*is_aot_compile*/,
-      LLVMTargetMachineFeatures* target_machine_features);
+      LLVMTargetMachineFeatures* target_machine_features,
+      CompilationStats* compilation_stats);
 
   // Runs HLO passes after layout assignment.
   Status RunHloPassesAfterLayoutAssn(
       HloModule* module, bool is_aot_compile,
-      LLVMTargetMachineFeatures* target_machine_features);
+      LLVMTargetMachineFeatures* target_machine_features,
+      CompilationStats* compilation_stats);
+
+  // Schedules `module` and rematerializes instructions to reduce its peak
+  // memory use to xla_cpu_rematerialization_memory_limit_bytes. The schedule
+  // is left on the module, and is the one buffer assignment must use.
+  Status RematerializeToMemoryLimit(HloModule* module, bool is_aot_compile);
 
   TF_DISALLOW_COPY_AND_ASSIGN(CpuCompiler);
 };
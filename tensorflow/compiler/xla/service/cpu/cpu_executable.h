@@ -67,6 +67,16 @@ class CpuExecutable : public Executable {
     ir_module_string_ = ir_module_string;
   }
 
+  // Whether the code of this executable was loaded from the persistent object
+  // cache instead of being generated (see xla_cpu_persistent_cache_dir).
+  bool loaded_from_persistent_cache() const {
+    return loaded_from_persistent_cache_;
+  }
+
+  void set_loaded_from_persistent_cache(bool loaded_from_persistent_cache) {
+    loaded_from_persistent_cache_ = loaded_from_persistent_cache;
+  }
+
   static int64 ShapeSizeBytes(const Shape& shape);
 
   // Type of the computation function we expect in the JIT.
@@ -137,6 +147,8 @@ class CpuExecutable : public Executable {
   // positives.
   string ir_module_string_;
 
+  bool loaded_from_persistent_cache_ = false;
+
   ComputeFunctionType compute_function_;
 
   // Entry function name for the computation.
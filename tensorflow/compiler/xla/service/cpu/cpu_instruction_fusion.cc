@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/cpu_instruction_fusion.h"
 
+#include "absl/algorithm/container.h"
+#include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/fusion_node_indexing_evaluation.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/fused_ir_emitter.h"
@@ -66,6 +68,117 @@ bool CanBeOutputFusedIntoSomeOperand(const HloInstruction* consumer) {
          (CanBeOutputFused(consumer->operand(0), consumer) ||
           CanBeOutputFused(consumer->operand(1), consumer));
 }
+
+// Returns true if `hlo` can be part of the epilogue of a dot or a convolution,
+// i.e. the elementwise operations fused into its output.
+bool CanBeInEpilogue(const HloInstruction& hlo) {
+  return (hlo.IsElementwise() && hlo.opcode() != HloOpcode::kMap) ||
+         hlo.opcode() == HloOpcode::kBroadcast ||
+         hlo.opcode() == HloOpcode::kConstant ||
+         hlo.opcode() == HloOpcode::kParameter;
+}
+
+// Returns true if `hlo` is a matrix-matrix dot or a convolution implemented by
+// the Eigen runtime, whose result can take an epilogue.
+bool IsEpilogueProducer(const HloInstruction& hlo,
+                        const TargetMachineFeatures* target_machine_features) {
+  if (!HasExactlyOneUse(hlo)) {
+    return false;
+  }
+  if (hlo.opcode() == HloOpcode::kDot) {
+    return hlo.shape().rank() == 2 &&
+           hlo.dot_dimension_numbers().lhs_batch_dimensions_size() == 0;
+  }
+  return hlo.opcode() == HloOpcode::kConvolution &&
+         target_machine_features != nullptr &&
+         ImplementedAsEigenConvolution(hlo, *target_machine_features);
+}
+
+// Returns the dot or convolution of an output fusion applying an epilogue to
+// it, or nullptr if `hlo` isn't one.
+const HloInstruction* GetEpilogueProducer(const HloInstruction& hlo) {
+  if (!hlo.IsOutputFusion()) {
+    return nullptr;
+  }
+  // A dot with a fused addend.
+  const HloInstruction* root = hlo.fused_expression_root();
+  if (root->opcode() == HloOpcode::kAdd &&
+      absl::c_any_of(root->operands(), [](const HloInstruction* operand) {
+        return operand->opcode() == HloOpcode::kParameter;
+      })) {
+    return nullptr;
+  }
+  for (const HloInstruction* instruction : hlo.fused_instructions()) {
+    if (instruction->opcode() == HloOpcode::kDot ||
+        instruction->opcode() == HloOpcode::kConvolution) {
+      return instruction;
+    }
+  }
+  return nullptr;
+}
+
+// Returns true if all the transitive users of `hlo` are elementwise, so that
+// they read each element of `hlo` at the index they write.
+bool AreTransitiveUsersElementwise(const HloInstruction* hlo) {
+  for (const HloInstruction* user : hlo->users()) {
+    if (!user->IsElementwise() || user->opcode() == HloOpcode::kMap ||
+        !AreTransitiveUsersElementwise(user)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The operands of an epilogue fusion with the dimensions of its output may
+// share its buffer (see CanShareOperandBufferWithUser), which the dot or the
+// convolution overwrites before the epilogue reads them.
+bool HasOperandsOfOutputDimensions(const HloInstruction& hlo,
+                                   const Shape& output_shape,
+                                   int64 skipped_operand_index = -1) {
+  for (int64 i = 0; i < hlo.operand_count(); ++i) {
+    if (i != skipped_operand_index &&
+        ShapeUtil::SameDimensions(hlo.operand(i)->shape(), output_shape)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if `consumer` can be fused as an epilogue into the output of
+// `producer`, its operand `operand_index`.
+bool CanBeEpilogueFused(const HloInstruction* producer,
+                        const HloInstruction* consumer, int64 operand_index,
+                        const TargetMachineFeatures* target_machine_features) {
+  if (!IsEpilogueProducer(*producer, target_machine_features) ||
+      !ShapeUtil::Equal(producer->shape(), consumer->shape()) ||
+      HasOperandsOfOutputDimensions(*consumer, consumer->shape(),
+                                    operand_index)) {
+    return false;
+  }
+  if (consumer->IsLoopFusion()) {
+    return absl::c_all_of(consumer->fused_instructions(),
+                          [](const HloInstruction* instruction) {
+                            return CanBeInEpilogue(*instruction);
+                          }) &&
+           AreTransitiveUsersElementwise(
+               consumer->fused_parameter(operand_index));
+  }
+  return consumer->IsElementwise() && consumer->opcode() != HloOpcode::kMap;
+}
+
+// Returns true if `producer`, operand `operand_index` of `consumer`, can be
+// fused into the epilogue of `consumer` whose dot or convolution is
+// `epilogue_producer`.
+bool CanBeFusedIntoEpilogue(const HloInstruction* producer,
+                            const HloInstruction* consumer, int64 operand_index,
+                            const HloInstruction* epilogue_producer) {
+  const HloInstruction* fused_parameter =
+      consumer->fused_parameter(operand_index);
+  return producer->opcode() != HloOpcode::kParameter &&
+         CanBeInEpilogue(*producer) &&
+         !HasOperandsOfOutputDimensions(*producer, consumer->shape()) &&
+         !absl::c_linear_search(fused_parameter->users(), epilogue_producer);
+}
 }  // namespace
 
 bool CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
@@ -81,6 +194,13 @@ bool CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
     return true;
   }
 
+  if (CanBeEpilogueFused(producer, consumer, operand_index,
+                         target_machine_features_)) {
+    VLOG(2) << "Fusion OK: Can fuse an epilogue into the output of "
+            << producer->name();
+    return true;
+  }
+
   if (CanBeOutputFusedIntoSomeOperand(producer)) {
     VLOG(2)
         << "Bailing because producer can be output-fused into some operand.";
@@ -138,6 +258,17 @@ bool CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
     }
   }
 
+  if (const HloInstruction* epilogue_producer =
+          GetEpilogueProducer(*consumer)) {
+    if (CanBeFusedIntoEpilogue(producer, consumer, operand_index,
+                               epilogue_producer)) {
+      VLOG(2) << "Fusing: consumer is an epilogue.";
+      return true;
+    }
+    VLOG(2) << "Not fusing: producer can't be part of an epilogue.";
+    return false;
+  }
+
   if (consumer->opcode() == HloOpcode::kDot) {
     // In the general case we call out to optimized "black box" GEMM routines
     // for Dot, which precludes fusion.  However, in very specific cases, we try
@@ -197,7 +328,9 @@ bool CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
 
 HloInstruction::FusionKind CpuInstructionFusion::ChooseKind(
     const HloInstruction* producer, const HloInstruction* consumer) {
-  return CanBeOutputFused(producer, consumer)
+  return CanBeOutputFused(producer, consumer) ||
+                 IsEpilogueProducer(*producer, target_machine_features_) ||
+                 GetEpilogueProducer(*consumer) != nullptr
              ? HloInstruction::FusionKind::kOutput
              : HloInstruction::FusionKind::kLoop;
 }
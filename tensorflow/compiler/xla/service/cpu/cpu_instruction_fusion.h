@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_INSTRUCTION_FUSION_H_
 
 #include "absl/container/flat_hash_map.h"
+#include "tensorflow/compiler/xla/service/cpu/target_machine_features.h"
 #include "tensorflow/compiler/xla/service/fusion_node_indexing_evaluation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/instruction_fusion.h"
@@ -26,8 +27,13 @@ namespace cpu {
 
 class CpuInstructionFusion : public InstructionFusion {
  public:
-  CpuInstructionFusion()
-      : InstructionFusion(CpuInstructionFusion::IsExpensive) {}
+  // `target_machine_features` decides which convolutions are implemented by
+  // the Eigen runtime and can have elementwise epilogues fused into them.  If
+  // it is null, convolutions don't take epilogues.
+  explicit CpuInstructionFusion(
+      const TargetMachineFeatures* target_machine_features = nullptr)
+      : InstructionFusion(CpuInstructionFusion::IsExpensive),
+        target_machine_features_(target_machine_features) {}
   ~CpuInstructionFusion() override = default;
 
   StatusOr<bool> Run(HloModule* module) override {
@@ -44,6 +50,8 @@ class CpuInstructionFusion : public InstructionFusion {
   HloInstruction* FuseInstruction(HloInstruction* fusion_instruction,
                                   HloInstruction* producer) override;
 
+  const TargetMachineFeatures* target_machine_features_;
+
   // Keep track of the number of times each instruction inside a fusion node is
   // indexed with different index vectors.
   absl::flat_hash_map<const HloInstruction*, FusionNodeIndexingEvaluation>
@@ -741,6 +741,60 @@ ENTRY main {
               Not(op::Fusion()));
 }
 
+TEST_F(OpcodeFusionTest, DotBiasReluEpilogueFusion) {
+  absl::string_view module_string = R"(
+HloModule module
+
+ENTRY main {
+  a = f32[64,256]{1,0} parameter(0)
+  b = f32[256,128]{1,0} parameter(1)
+  bias = f32[128]{0} parameter(2)
+  dot = f32[64,128]{1,0} dot(a, b), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  bias_broadcast = f32[64,128]{1,0} broadcast(bias), dimensions={1}
+  add = f32[64,128]{1,0} add(dot, bias_broadcast)
+  zero = f32[] constant(0)
+  zeros = f32[64,128]{1,0} broadcast(zero), dimensions={}
+  ROOT relu = f32[64,128]{1,0} maximum(add, zeros)
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(module_string));
+  RunFusionAndCheckOpcodesWereFused(
+      module.get(),
+      {HloOpcode::kDot, HloOpcode::kBroadcast, HloOpcode::kAdd,
+       HloOpcode::kConstant, HloOpcode::kBroadcast, HloOpcode::kMaximum,
+       HloOpcode::kParameter, HloOpcode::kParameter, HloOpcode::kParameter},
+      HloInstruction::FusionKind::kOutput);
+}
+
+TEST_F(InstructionFusionTest, DontEpilogueFuseOperandsOfOutputDimensions) {
+  // `c` may share its buffer with the output, which the dot would overwrite
+  // before the epilogue reads it.
+  absl::string_view module_string = R"(
+HloModule module
+
+ENTRY main {
+  a = f32[64,256]{1,0} parameter(0)
+  b = f32[256,128]{1,0} parameter(1)
+  c = f32[64,128]{1,0} parameter(2)
+  dot = f32[64,128]{1,0} dot(a, b), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  add = f32[64,128]{1,0} add(dot, c)
+  ROOT tanh = f32[64,128]{1,0} tanh(add)
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(module_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool fused_something,
+                          CpuInstructionFusion().Run(module.get()));
+  EXPECT_TRUE(fused_something);
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              op::Fusion(op::Dot(), op::Parameter(2)));
+  EXPECT_TRUE(
+      module->entry_computation()->root_instruction()->IsLoopFusion());
+}
+
 struct GatherLoopFusionTestSpec {
   string test_name;
   string hlo_computation_text;
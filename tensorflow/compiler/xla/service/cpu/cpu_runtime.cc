@@ -65,6 +65,8 @@ extern const char* const kEigenMatMulF16SymbolName =
     "__xla_cpu_runtime_EigenMatMulF16";
 extern const char* const kEigenMatMulF32SymbolName =
     "__xla_cpu_runtime_EigenMatMulF32";
+extern const char* const kEigenMatMulF32WithEpilogueSymbolName =
+    "__xla_cpu_runtime_EigenMatMulF32WithEpilogue";
 extern const char* const kEigenMatMulF64SymbolName =
     "__xla_cpu_runtime_EigenMatMulF64";
 extern const char* const kEigenMatMulC64SymbolName =
@@ -86,6 +88,8 @@ extern const char* const kEigenConvF16SymbolName =
     "__xla_cpu_runtime_EigenConvF16";
 extern const char* const kEigenConvF32SymbolName =
     "__xla_cpu_runtime_EigenConvF32";
+extern const char* const kEigenConvF32WithEpilogueSymbolName =
+    "__xla_cpu_runtime_EigenConvF32WithEpilogue";
 extern const char* const kEigenFftSymbolName = "__xla_cpu_runtime_EigenFft";
 extern const char* const kEigenSingleThreadedFftSymbolName =
     "__xla_cpu_runtime_EigenSingleThreadedFft";
@@ -93,6 +97,8 @@ extern const char* const kEigenSingleThreadedMatMulF16SymbolName =
     "__xla_cpu_runtime_EigenSingleThreadedMatMulF16";
 extern const char* const kEigenSingleThreadedMatMulF32SymbolName =
     "__xla_cpu_runtime_EigenSingleThreadedMatMulF32";
+extern const char* const kEigenSingleThreadedMatMulF32WithEpilogueSymbolName =
+    "__xla_cpu_runtime_EigenSingleThreadedMatMulF32WithEpilogue";
 extern const char* const kEigenSingleThreadedMatMulF64SymbolName =
     "__xla_cpu_runtime_EigenSingleThreadedMatMulF64";
 extern const char* const kEigenSingleThreadedMatMulC64SymbolName =
@@ -105,6 +111,8 @@ extern const char* const kEigenSingleThreadedConvF16SymbolName =
     "__xla_cpu_runtime_EigenSingleThreadedConvF16";
 extern const char* const kEigenSingleThreadedConvF32SymbolName =
     "__xla_cpu_runtime_EigenSingleThreadedConvF32";
+extern const char* const kEigenSingleThreadedConvF32WithEpilogueSymbolName =
+    "__xla_cpu_runtime_EigenSingleThreadedConvF32WithEpilogue";
 extern const char* const kAcquireInfeedBufferForDequeueSymbolName =
     "__xla_cpu_runtime_AcquireInfeedBufferForDequeue";
 extern const char* const kReleaseInfeedBufferAfterDequeueSymbolName =
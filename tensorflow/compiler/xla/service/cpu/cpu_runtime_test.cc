@@ -15,9 +15,12 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <tuple>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/strings/str_format.h"
@@ -167,6 +170,54 @@ INSTANTIATE_TEST_SUITE_P(EigenMatMulTestInstantiaion, EigenMatMulTest,
                                             ::testing::Bool()),
                          EigenMatMulTest::Name);
 
+// Counts the calls of the epilogue on every element of the output.
+void CountingEpilogue(void* context, float* data, int64 offset, int64 size) {
+  auto* counts = static_cast<std::vector<int>*>(context);
+  for (int64 i = offset; i < offset + size; ++i) {
+    ++(*counts)[i];
+  }
+}
+
+// The single-threaded matmul runs on buffers that aren't 16-byte aligned with
+// the unaligned Eigen kernel, and only with it.
+TEST_F(CpuRuntimeTest, SingleThreadedMatMulOnUnalignedBuffersRunsOnce) {
+  const int64 m = 8;
+  const int64 n = 12;
+  const int64 k = 16;
+  auto a = MakeLinspaceArray2D(0.0, 1.0, m, k);
+  auto b = MakeLinspaceArray2D(-2.0, 2.0, k, n);
+  auto a_transpose = MaybeTransposeArray2D(*a, true);
+  auto b_transpose = MaybeTransposeArray2D(*b, true);
+
+  // Copies of the column-major buffers one float past a 16-byte boundary.
+  std::vector<float> lhs(m * k + 4);
+  std::vector<float> rhs(k * n + 4);
+  std::vector<float> out(m * n + 4);
+  auto unaligned = [](std::vector<float>* buffer) {
+    float* data = buffer->data();
+    while (reinterpret_cast<uintptr_t>(data) % 16 != 4) ++data;
+    return data;
+  };
+  float* lhs_data = unaligned(&lhs);
+  float* rhs_data = unaligned(&rhs);
+  float* out_data = unaligned(&out);
+  std::copy(a_transpose->data(), a_transpose->data() + m * k, lhs_data);
+  std::copy(b_transpose->data(), b_transpose->data() + k * n, rhs_data);
+
+  std::vector<int> counts(m * n, 0);
+  __xla_cpu_runtime_EigenSingleThreadedMatMulF32WithEpilogue(
+      nullptr, out_data, lhs_data, rhs_data, m, n, k, /*transpose_lhs=*/0,
+      /*transpose_rhs=*/0, reinterpret_cast<void*>(&CountingEpilogue),
+      &counts);
+
+  for (int count : counts) {
+    EXPECT_EQ(count, 1);
+  }
+  Array2D<float> c_transpose(n, m);
+  std::copy(out_data, out_data + m * n, c_transpose.data());
+  CheckMatrixMultiply(*a, *b, *MaybeTransposeArray2D(c_transpose, true));
+}
+
 #ifdef INTEL_MKL
 class MKLMatMulTest : public CpuRuntimeTest,
                       public ::testing::WithParamInterface<MatMulTestParam> {
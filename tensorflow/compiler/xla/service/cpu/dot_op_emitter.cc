@@ -104,8 +104,9 @@ enum class DotImplementationStrategy {
   // The dot operation is lowered into linalg.matmul op and lowered to LLVM IR.
   kLinalgMatmul,
 
-  // The dot operation is lowered into a call into an Eigen routine.  No fusions
-  // are supported today.  The two inputs and the output have to be row major.
+  // The dot operation is lowered into a call into an Eigen routine.  F32 dots
+  // can apply an epilogue to their output blocks, see runtime_epilogue.h.  The
+  // two inputs and the output have to be row major.
   // However, we do allow transposing either the LHS or the RHS as part of the
   // GEMM -- we expose this flexibility as flexibility in the contraction
   // dimensions, but we can also see this as flexibility in the input layouts.
@@ -126,6 +127,7 @@ class DotOpEmitter {
                         const llvm_ir::IrArray& lhs_array,
                         const llvm_ir::IrArray& rhs_array,
                         const llvm_ir::IrArray* addend_array,
+                        const RuntimeEpilogue* epilogue,
                         llvm::Value* executable_run_options_value,
                         llvm::IRBuilder<>* b, mlir::MLIRContext* mlir_context,
                         const HloModuleConfig& hlo_module_config,
@@ -224,6 +226,7 @@ class DotOpEmitter {
   const llvm_ir::IrArray& lhs_array_;
   const llvm_ir::IrArray& rhs_array_;
   const llvm_ir::IrArray* addend_array_;
+  const RuntimeEpilogue* epilogue_;
   llvm::Value* executable_run_options_value_;
   llvm::IRBuilder<>* b_;
   mlir::MLIRContext* mlir_context_;
@@ -235,7 +238,7 @@ class DotOpEmitter {
 DotOpEmitter::DotOpEmitter(
     DotInfo dot_info, string dot_hlo_name, const llvm_ir::IrArray& target_array,
     const llvm_ir::IrArray& lhs_array, const llvm_ir::IrArray& rhs_array,
-    const llvm_ir::IrArray* addend_array,
+    const llvm_ir::IrArray* addend_array, const RuntimeEpilogue* epilogue,
     llvm::Value* executable_run_options_value, llvm::IRBuilder<>* b,
     mlir::MLIRContext* mlir_context, const HloModuleConfig& hlo_module_config,
     const TargetMachineFeatures& target_machine_features)
@@ -245,6 +248,7 @@ DotOpEmitter::DotOpEmitter(
       lhs_array_(lhs_array),
       rhs_array_(rhs_array),
       addend_array_(addend_array),
+      epilogue_(epilogue),
       executable_run_options_value_(executable_run_options_value),
       b_(b),
       mlir_context_(mlir_context),
@@ -525,8 +529,11 @@ Status DotOpEmitter::Emit() {
     return EmitScalarDot();
   }
 
-  switch (GetDotImplementationStrategy(hlo_module_config_, dot_info_,
-                                       target_machine_features_)) {
+  DotImplementationStrategy strategy = GetDotImplementationStrategy(
+      hlo_module_config_, dot_info_, target_machine_features_);
+  TF_RET_CHECK(epilogue_ == nullptr ||
+               strategy == DotImplementationStrategy::kEigen);
+  switch (strategy) {
     case DotImplementationStrategy::kNaiveLlvmIr:
       EmitNaiveLlvmIrGemm();
       return Status::OK();
@@ -732,7 +739,9 @@ Status DotOpEmitter::EmitCallToRuntime() {
   //          int64 m, int64 n, int64 k, int32 transpose_lhs,
   //          int32 transpose_rhs);
   // The two transpose_... parameters are actually booleans, but we use int32
-  // to avoid target-dependent calling convention details.
+  // to avoid target-dependent calling convention details.  The functions
+  // applying an epilogue take the epilogue and its context as two additional
+  // void* parameters.
 
   bool multi_threaded = ShouldUseMultiThreadedEigen(hlo_module_config_);
   bool use_mkl_dnn = hlo_module_config_.debug_options().xla_cpu_use_mkl_dnn();
@@ -749,12 +758,21 @@ Status DotOpEmitter::EmitCallToRuntime() {
       float_type = b_->getHalfTy();
       break;
     case F32:
-      fn_name = multi_threaded
-                    ? (use_mkl_dnn ? runtime::kMKLMatMulF32SymbolName
-                                   : runtime::kEigenMatMulF32SymbolName)
-                    : (use_mkl_dnn
-                           ? runtime::kMKLSingleThreadedMatMulF32SymbolName
-                           : runtime::kEigenSingleThreadedMatMulF32SymbolName);
+      if (epilogue_ != nullptr) {
+        TF_RET_CHECK(!use_mkl_dnn);
+        fn_name =
+            multi_threaded
+                ? runtime::kEigenMatMulF32WithEpilogueSymbolName
+                : runtime::kEigenSingleThreadedMatMulF32WithEpilogueSymbolName;
+      } else {
+        fn_name =
+            multi_threaded
+                ? (use_mkl_dnn ? runtime::kMKLMatMulF32SymbolName
+                               : runtime::kEigenMatMulF32SymbolName)
+                : (use_mkl_dnn
+                       ? runtime::kMKLSingleThreadedMatMulF32SymbolName
+                       : runtime::kEigenSingleThreadedMatMulF32SymbolName);
+      }
       float_type = b_->getFloatTy();
       break;
     case F64:
@@ -788,23 +806,32 @@ Status DotOpEmitter::EmitCallToRuntime() {
       return Unimplemented("Invalid type %s for dot operation",
                            PrimitiveType_Name(type));
   }
+  TF_RET_CHECK(epilogue_ == nullptr || type == F32);
 
   llvm::Type* float_ptr_type = float_type->getPointerTo();
   llvm::Type* int64_type = b_->getInt64Ty();
   llvm::Type* int32_type = b_->getInt32Ty();
   llvm::Type* int8_ptr_type = b_->getInt8Ty()->getPointerTo();
+  std::vector<llvm::Type*> matmul_arg_types = {
+      int8_ptr_type, float_ptr_type, float_ptr_type, float_ptr_type,
+      int64_type,    int64_type,     int64_type,     int32_type,
+      int32_type};
+  if (epilogue_ != nullptr) {
+    matmul_arg_types.push_back(int8_ptr_type);
+    matmul_arg_types.push_back(int8_ptr_type);
+  }
   llvm::FunctionType* matmul_type = llvm::FunctionType::get(
-      b_->getVoidTy(),
-      {int8_ptr_type, float_ptr_type, float_ptr_type, float_ptr_type,
-       int64_type, int64_type, int64_type, int32_type, int32_type},
-      /*isVarArg=*/false);
+      b_->getVoidTy(), matmul_arg_types, /*isVarArg=*/false);
 
   llvm::FunctionCallee matmul_func =
       module->getOrInsertFunction(fn_name, matmul_type);
   if (auto* fn = llvm::dyn_cast<llvm::Function>(matmul_func.getCallee())) {
     fn->setCallingConv(llvm::CallingConv::C);
     fn->setDoesNotThrow();
-    fn->setOnlyAccessesArgMemory();
+    // The epilogue reads the operands of the fusion through its context.
+    if (epilogue_ == nullptr) {
+      fn->setOnlyAccessesArgMemory();
+    }
   }
 
   // The Eigen runtime function expects column-major layout. If the matrices are
@@ -833,15 +860,22 @@ Status DotOpEmitter::EmitCallToRuntime() {
     std::swap(transpose_lhs, transpose_rhs);
   }
 
-  b_->CreateCall(
-      matmul_func,
-      {b_->CreateBitCast(executable_run_options_value_, int8_ptr_type),
-       b_->CreateBitCast(target_array_.GetBasePointer(), float_ptr_type),
-       b_->CreateBitCast(lhs->GetBasePointer(), float_ptr_type),
-       b_->CreateBitCast(rhs->GetBasePointer(), float_ptr_type),
-       b_->getInt64(mat_mult_dims.m), b_->getInt64(mat_mult_dims.n),
-       b_->getInt64(mat_mult_dims.k), b_->getInt32(transpose_lhs),
-       b_->getInt32(transpose_rhs)});
+  std::vector<llvm::Value*> matmul_args = {
+      b_->CreateBitCast(executable_run_options_value_, int8_ptr_type),
+      b_->CreateBitCast(target_array_.GetBasePointer(), float_ptr_type),
+      b_->CreateBitCast(lhs->GetBasePointer(), float_ptr_type),
+      b_->CreateBitCast(rhs->GetBasePointer(), float_ptr_type),
+      b_->getInt64(mat_mult_dims.m),
+      b_->getInt64(mat_mult_dims.n),
+      b_->getInt64(mat_mult_dims.k),
+      b_->getInt32(transpose_lhs),
+      b_->getInt32(transpose_rhs)};
+  if (epilogue_ != nullptr) {
+    matmul_args.push_back(
+        b_->CreateBitCast(epilogue_->function, int8_ptr_type));
+    matmul_args.push_back(b_->CreateBitCast(epilogue_->context, int8_ptr_type));
+  }
+  b_->CreateCall(matmul_func, matmul_args);
   return Status::OK();
 }
 
@@ -1037,7 +1071,7 @@ DotImplementationStrategy GetDotImplementationStrategy(
 Status EmitNonBatchDotOperation(
     DotInfo dot_info, string hlo_name, const llvm_ir::IrArray& target_array,
     const llvm_ir::IrArray& lhs_array, const llvm_ir::IrArray& rhs_array,
-    const llvm_ir::IrArray* addend_array,
+    const llvm_ir::IrArray* addend_array, const RuntimeEpilogue* epilogue,
     llvm::Value* executable_run_options_value, llvm::IRBuilder<>* b,
     mlir::MLIRContext* mlir_context, const HloModuleConfig& hlo_module_config,
     const TargetMachineFeatures& target_machine_features) {
@@ -1046,7 +1080,8 @@ Status EmitNonBatchDotOperation(
                C64 == type || C128 == type);
   DotOpEmitter dot_emitter(std::move(dot_info), std::move(hlo_name),
                            target_array, lhs_array, rhs_array, addend_array,
-                           executable_run_options_value, b, mlir_context,
+                           epilogue, executable_run_options_value, b,
+                           mlir_context,
                            hlo_module_config, target_machine_features);
   return dot_emitter.Emit();
 }
@@ -1178,7 +1213,8 @@ Status EmitBatchDotOperation(
 
         // Emit the inner non-batch dot operation.
         return EmitNonBatchDotOperation(
-            dot_info, dot.name(), target_slice, lhs_slice, rhs_slice, nullptr,
+            dot_info, dot.name(), target_slice, lhs_slice, rhs_slice,
+            /*addend_array=*/nullptr, /*epilogue=*/nullptr,
             executable_run_options_value, b, mlir_context, hlo_module_config,
             target_machine_features);
       });
@@ -1223,11 +1259,25 @@ bool DotOperandsAndResultMustHaveRowMajorLayout(
          impl_strategy == DotImplementationStrategy::kEigen;
 }
 
+bool DotImplementationCanApplyEpilogue(
+    const HloInstruction& dot_instr,
+    const TargetMachineFeatures& target_machine_features) {
+  const HloModuleConfig& config = dot_instr.parent()->parent()->config();
+  if (IsBatchDot(dot_instr) || dot_instr.shape().element_type() != F32 ||
+      config.debug_options().xla_cpu_use_mkl_dnn()) {
+    return false;
+  }
+  return GetDotImplementationStrategy(config, DotInfo(dot_instr),
+                                      target_machine_features) ==
+         DotImplementationStrategy::kEigen;
+}
+
 Status EmitDotOperation(const HloInstruction& dot,
                         const llvm_ir::IrArray& target_array,
                         const llvm_ir::IrArray& lhs_array,
                         const llvm_ir::IrArray& rhs_array,
                         const llvm_ir::IrArray* addend_array,
+                        const RuntimeEpilogue* epilogue,
                         llvm::Value* executable_run_options_value,
                         llvm::IRBuilder<>* b, mlir::MLIRContext* mlir_context,
                         const HloModuleConfig& hlo_module_config,
@@ -1237,16 +1287,16 @@ Status EmitDotOperation(const HloInstruction& dot,
   CHECK(dot.parent()->root_instruction()->outer_dimension_partitions().empty());
 
   if (IsBatchDot(dot)) {
-    TF_RET_CHECK(addend_array == nullptr);
+    TF_RET_CHECK(addend_array == nullptr && epilogue == nullptr);
     return EmitBatchDotOperation(dot, target_array, lhs_array, rhs_array,
                                  executable_run_options_value, b, mlir_context,
                                  hlo_module_config, target_machine_features);
   }
 
-  return EmitNonBatchDotOperation(DotInfo(dot), dot.name(), target_array,
-                                  lhs_array, rhs_array, addend_array,
-                                  executable_run_options_value, b, mlir_context,
-                                  hlo_module_config, target_machine_features);
+  return EmitNonBatchDotOperation(
+      DotInfo(dot), dot.name(), target_array, lhs_array, rhs_array,
+      addend_array, epilogue, executable_run_options_value, b, mlir_context,
+      hlo_module_config, target_machine_features);
 }
 }  // namespace cpu
 }  // namespace xla
@@ -49,6 +49,21 @@ bool DotImplementationCanHandleTranspose(
 absl::optional<int64> ProfitableToMakeDotOperandColumnMajor(
     const HloInstruction& hlo);
 
+// Returns true if our lowering strategy for `dot_instr` is a call to a runtime
+// function which can apply an epilogue to the blocks of the result as they are
+// computed, see RuntimeEpilogue.
+bool DotImplementationCanApplyEpilogue(
+    const HloInstruction& dot_instr,
+    const TargetMachineFeatures& target_machine_features);
+
+// An epilogue applying the elementwise consumers fused into the output of a
+// dot or a convolution.  `function` is a tensorflow::xla::EpilogueFunction (see
+// runtime_epilogue.h), which the runtime calls with `context`.
+struct RuntimeEpilogue {
+  llvm::Value* function;
+  llvm::Value* context;
+};
+
 // Emit LLVM IR to perform the dot operation on lhs_array and rhs_array and
 // place the result in target_array. IR is emitted at current insert point of
 // the builder. Upon completion of the method, the insert point is set to the
@@ -58,11 +73,16 @@ absl::optional<int64> ProfitableToMakeDotOperandColumnMajor(
 // dimensions as the result, and the result is computed as `addend_array` +
 // dot(`lhs_array`, `rhs_array`).  A non-null `addend_array` is only supported
 // for Matrix-vector products.
+//
+// If `epilogue` is not nullptr then it is applied to the result by the runtime
+// function computing the dot, which DotImplementationCanApplyEpilogue must
+// allow.
 Status EmitDotOperation(const HloInstruction& dot,
                         const llvm_ir::IrArray& target_array,
                         const llvm_ir::IrArray& lhs_array,
                         const llvm_ir::IrArray& rhs_array,
                         const llvm_ir::IrArray* addend_array,
+                        const RuntimeEpilogue* epilogue,
                         llvm::Value* executable_run_options_value,
                         llvm::IRBuilder<>* b, mlir::MLIRContext* mlir_context,
                         const HloModuleConfig& hlo_module_config,
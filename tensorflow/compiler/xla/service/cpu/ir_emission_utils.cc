@@ -112,5 +112,17 @@ bool PotentiallyImplementedAsEigenConvolution(
              kernel_shape.dimensions_size() - 1;
 }
 
+bool ImplementedAsEigenConvolution(
+    const HloInstruction& convolution,
+    const TargetMachineFeatures& target_machine_features) {
+  return PotentiallyImplementedAsEigenConvolution(convolution,
+                                                  target_machine_features) &&
+         LayoutUtil::IsMonotonicWithDim0Major(
+             convolution.operand(0)->shape().layout()) &&
+         LayoutUtil::IsMonotonicWithDim0Major(
+             convolution.operand(1)->shape().layout()) &&
+         LayoutUtil::IsMonotonicWithDim0Major(convolution.shape().layout());
+}
+
 }  // namespace cpu
 }  // namespace xla
@@ -27,6 +27,13 @@ bool PotentiallyImplementedAsEigenConvolution(
     const HloInstruction& convolution,
     const TargetMachineFeatures& target_machine_features);
 
+// Returns true if `convolution` is implemented with a call to an Eigen
+// convolution, i.e. if it potentially is and its input, kernel and output
+// agree with respect to layout.
+bool ImplementedAsEigenConvolution(
+    const HloInstruction& convolution,
+    const TargetMachineFeatures& target_machine_features);
+
 // Computes the minimum alignment guaranteed for a tensor of shape `shape` on
 // the target machine.
 int64 GetMinimumAlignmentForArray(
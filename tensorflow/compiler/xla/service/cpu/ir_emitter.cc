@@ -31,6 +31,7 @@ limitations under the License.
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "llvm/CodeGen/TargetRegisterInfo.h"
 #include "llvm/CodeGen/TargetSubtargetInfo.h"
@@ -64,6 +65,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/llvm_ir/buffer_assignment_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/dynamic_update_slice_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ir_array.h"
+#include "tensorflow/compiler/xla/service/llvm_ir/kernel_support_library.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_loop.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/loop_emitter.h"
@@ -288,6 +290,15 @@ Status IrEmitter::HandleCopy(HloInstruction* copy) {
     TF_RETURN_IF_ERROR(EmitTargetAddressForOp(copy));
     return EmitMemcpy(*(copy->operand(0)), *copy);
   } else if (copy->shape().IsArray()) {
+    string tiling_failure_reason;
+    TF_ASSIGN_OR_RETURN(bool tiling_successful,
+                        EmitTiledTranspose(copy, &tiling_failure_reason));
+    if (tiling_successful) {
+      VLOG(1) << "Emitted tiled transpose for " << copy->ToString();
+      return Status::OK();
+    }
+    VLOG(1) << "Could not emit tiled transpose for " << copy->ToString()
+            << ": " << tiling_failure_reason;
     // Use the elemental emitter for array shapes.
     return DefaultAction(copy);
   }
@@ -850,7 +861,7 @@ Status IrEmitter::HandleDot(HloInstruction* dot) {
 
   // Dot operation is complicated so we delegate to a helper class.
   return EmitDotOperation(*dot, target_array, lhs_array, rhs_array,
-                          /*addend_array=*/nullptr,
+                          /*addend_array=*/nullptr, /*epilogue=*/nullptr,
                           GetExecutableRunOptionsArgument(), &b_, mlir_context_,
                           hlo_module_config_, target_machine_features_);
 }
@@ -1010,137 +1021,11 @@ Status IrEmitter::HandleConvolution(HloInstruction* convolution) {
 
   // TODO(tonywy): Add PotentiallyImplementedAsMKLConvolution to support
   // different data layouts.
-  if (PotentiallyImplementedAsEigenConvolution(*convolution,
-                                               target_machine_features_)) {
-    const Shape& lhs_shape = lhs->shape();
-    const Shape& rhs_shape = rhs->shape();
-    const Shape& convolution_shape = convolution->shape();
-    // The input, kernel and output agree with respect to layout.
-    if (LayoutUtil::IsMonotonicWithDim0Major(lhs_shape.layout()) &&
-        LayoutUtil::IsMonotonicWithDim0Major(rhs_shape.layout()) &&
-        LayoutUtil::IsMonotonicWithDim0Major(convolution_shape.layout())) {
-      // We lower 1D convolutions into calls to the same Eigen function as 2D
-      // convolutions, except that we pretend that the 1D convolution is really
-      // a 2D convolution with the missing dimension set to 1.  We also adjust
-      // the padding, dilation parameters as needed.
-      bool one_dim_convolution = lhs_shape.dimensions_size() == 3;
-      llvm::Value* lhs_address = GetEmittedValueFor(lhs);
-      llvm::Value* rhs_address = GetEmittedValueFor(rhs);
-      TF_RETURN_IF_ERROR(EmitTargetAddressForOp(convolution));
-
-      const ConvolutionDimensionNumbers& dnums =
-          convolution->convolution_dimension_numbers();
-
-      // Input tensor.
-      const Shape& input_shape = convolution->operand(0)->shape();
-      int64 input_batch = input_shape.dimensions(dnums.input_batch_dimension());
-      int64 input_rows =
-          input_shape.dimensions(dnums.input_spatial_dimensions(0));
-      int64 input_cols =
-          one_dim_convolution
-              ? 1
-              : input_shape.dimensions(dnums.input_spatial_dimensions(1));
-      int64 input_channels =
-          input_shape.dimensions(dnums.input_feature_dimension());
-
-      // Kernel tensor.
-      const Shape& kernel_shape = convolution->operand(1)->shape();
-      int64 kernel_rows =
-          kernel_shape.dimensions(dnums.kernel_spatial_dimensions(0));
-      int64 kernel_cols =
-          one_dim_convolution
-              ? 1
-              : kernel_shape.dimensions(dnums.kernel_spatial_dimensions(1));
-      int64 kernel_channels =
-          kernel_shape.dimensions(dnums.kernel_input_feature_dimension());
-      int64 kernel_filters =
-          kernel_shape.dimensions(dnums.kernel_output_feature_dimension());
-
-      // Output tensor.
-      const Shape& convolution_shape = convolution->shape();
-      int64 output_rows =
-          convolution_shape.dimensions(dnums.output_spatial_dimensions(0));
-      int64 output_cols = one_dim_convolution
-                              ? 1
-                              : convolution_shape.dimensions(
-                                    dnums.output_spatial_dimensions(1));
-
-      // Extract the window stride for the convolution.
-      const Window& window = convolution->window();
-      int64 row_stride = window.dimensions(0).stride();
-      int64 col_stride =
-          one_dim_convolution ? 1 : window.dimensions(1).stride();
-
-      int64 padding_top = window.dimensions(0).padding_low();
-      int64 padding_bottom = window.dimensions(0).padding_high();
-      int64 padding_left =
-          one_dim_convolution ? 0 : window.dimensions(1).padding_low();
-      int64 padding_right =
-          one_dim_convolution ? 0 : window.dimensions(1).padding_high();
-
-      int64 lhs_row_dilation = window.dimensions(0).base_dilation();
-      int64 lhs_col_dilation =
-          one_dim_convolution ? 1 : window.dimensions(1).base_dilation();
-      int64 rhs_row_dilation = window.dimensions(0).window_dilation();
-      int64 rhs_col_dilation =
-          one_dim_convolution ? 1 : window.dimensions(1).window_dilation();
-
-      PrimitiveType primitive_type = lhs->shape().element_type();
-      llvm::Type* ir_ptr_type = primitive_type == F16
-                                    ? b_.getHalfTy()->getPointerTo()
-                                    : b_.getFloatTy()->getPointerTo();
-      bool multi_threaded =
-          hlo_module_config_.debug_options().xla_cpu_multi_thread_eigen();
-      bool use_mkl_dnn =
-          hlo_module_config_.debug_options().xla_cpu_use_mkl_dnn();
-
-      // TODO(b/78639006) Singlethread MKL conv2d is not implemented due to the
-      // potential race condition by setting the omp_num_threads.
-      const char* fn_name =
-          primitive_type == F16
-              ? (multi_threaded
-                     ? runtime::kEigenConvF16SymbolName
-                     : runtime::kEigenSingleThreadedConvF16SymbolName)
-              : (multi_threaded
-                     ? (use_mkl_dnn ? runtime::kMKLConvF32SymbolName
-                                    : runtime::kEigenConvF32SymbolName)
-                     : runtime::kEigenSingleThreadedConvF32SymbolName);
-      if (!multi_threaded && use_mkl_dnn) {
-        LOG(WARNING) << "Using Eigen instead of MKL-DNN for single-threaded "
-                        "conv2d function.";
-      }
-      EmitCallToFunc(fn_name,
-                     {
-                         GetExecutableRunOptionsArgument(),
-                         BitCast(GetEmittedValueFor(convolution), ir_ptr_type),
-                         BitCast(lhs_address, ir_ptr_type),
-                         BitCast(rhs_address, ir_ptr_type),
-                         b_.getInt64(input_batch),
-                         b_.getInt64(input_rows),
-                         b_.getInt64(input_cols),
-                         b_.getInt64(input_channels),
-                         b_.getInt64(kernel_rows),
-                         b_.getInt64(kernel_cols),
-                         b_.getInt64(kernel_channels),
-                         b_.getInt64(kernel_filters),
-                         b_.getInt64(output_rows),
-                         b_.getInt64(output_cols),
-                         b_.getInt64(row_stride),
-                         b_.getInt64(col_stride),
-                         b_.getInt64(padding_top),
-                         b_.getInt64(padding_bottom),
-                         b_.getInt64(padding_left),
-                         b_.getInt64(padding_right),
-                         b_.getInt64(lhs_row_dilation),
-                         b_.getInt64(lhs_col_dilation),
-                         b_.getInt64(rhs_row_dilation),
-                         b_.getInt64(rhs_col_dilation),
-                     },
-                     b_.getVoidTy(), /*does_not_throw=*/true,
-                     /*only_accesses_arg_memory=*/true);
-
-      return Status::OK();
-    }
+  if (ImplementedAsEigenConvolution(*convolution, target_machine_features_)) {
+    TF_RETURN_IF_ERROR(EmitTargetAddressForOp(convolution));
+    return EmitCallToEigenConvolution(
+        *convolution, GetEmittedValueFor(convolution), GetEmittedValueFor(lhs),
+        GetEmittedValueFor(rhs), /*epilogue=*/nullptr);
   }
 
   // This is a completely un-optimized version of convolution just to
@@ -1152,6 +1037,134 @@ Status IrEmitter::HandleConvolution(HloInstruction* convolution) {
   return DefaultAction(convolution);
 }
 
+Status IrEmitter::EmitCallToEigenConvolution(
+    const HloInstruction& convolution, llvm::Value* target_address,
+    llvm::Value* lhs_address, llvm::Value* rhs_address,
+    const RuntimeEpilogue* epilogue) {
+  // We lower 1D convolutions into calls to the same Eigen function as 2D
+  // convolutions, except that we pretend that the 1D convolution is really
+  // a 2D convolution with the missing dimension set to 1.  We also adjust
+  // the padding, dilation parameters as needed.
+  bool one_dim_convolution =
+      convolution.operand(0)->shape().dimensions_size() == 3;
+
+  const ConvolutionDimensionNumbers& dnums =
+      convolution.convolution_dimension_numbers();
+
+  // Input tensor.
+  const Shape& input_shape = convolution.operand(0)->shape();
+  int64 input_batch = input_shape.dimensions(dnums.input_batch_dimension());
+  int64 input_rows = input_shape.dimensions(dnums.input_spatial_dimensions(0));
+  int64 input_cols =
+      one_dim_convolution
+          ? 1
+          : input_shape.dimensions(dnums.input_spatial_dimensions(1));
+  int64 input_channels =
+      input_shape.dimensions(dnums.input_feature_dimension());
+
+  // Kernel tensor.
+  const Shape& kernel_shape = convolution.operand(1)->shape();
+  int64 kernel_rows =
+      kernel_shape.dimensions(dnums.kernel_spatial_dimensions(0));
+  int64 kernel_cols =
+      one_dim_convolution
+          ? 1
+          : kernel_shape.dimensions(dnums.kernel_spatial_dimensions(1));
+  int64 kernel_channels =
+      kernel_shape.dimensions(dnums.kernel_input_feature_dimension());
+  int64 kernel_filters =
+      kernel_shape.dimensions(dnums.kernel_output_feature_dimension());
+
+  // Output tensor.
+  const Shape& convolution_shape = convolution.shape();
+  int64 output_rows =
+      convolution_shape.dimensions(dnums.output_spatial_dimensions(0));
+  int64 output_cols =
+      one_dim_convolution
+          ? 1
+          : convolution_shape.dimensions(dnums.output_spatial_dimensions(1));
+
+  // Extract the window stride for the convolution.
+  const Window& window = convolution.window();
+  int64 row_stride = window.dimensions(0).stride();
+  int64 col_stride = one_dim_convolution ? 1 : window.dimensions(1).stride();
+
+  int64 padding_top = window.dimensions(0).padding_low();
+  int64 padding_bottom = window.dimensions(0).padding_high();
+  int64 padding_left =
+      one_dim_convolution ? 0 : window.dimensions(1).padding_low();
+  int64 padding_right =
+      one_dim_convolution ? 0 : window.dimensions(1).padding_high();
+
+  int64 lhs_row_dilation = window.dimensions(0).base_dilation();
+  int64 lhs_col_dilation =
+      one_dim_convolution ? 1 : window.dimensions(1).base_dilation();
+  int64 rhs_row_dilation = window.dimensions(0).window_dilation();
+  int64 rhs_col_dilation =
+      one_dim_convolution ? 1 : window.dimensions(1).window_dilation();
+
+  PrimitiveType primitive_type = input_shape.element_type();
+  llvm::Type* ir_ptr_type = primitive_type == F16
+                                ? b_.getHalfTy()->getPointerTo()
+                                : b_.getFloatTy()->getPointerTo();
+  bool multi_threaded =
+      hlo_module_config_.debug_options().xla_cpu_multi_thread_eigen();
+  bool use_mkl_dnn = hlo_module_config_.debug_options().xla_cpu_use_mkl_dnn();
+
+  // TODO(b/78639006) Singlethread MKL conv2d is not implemented due to the
+  // potential race condition by setting the omp_num_threads.
+  const char* fn_name =
+      primitive_type == F16
+          ? (multi_threaded ? runtime::kEigenConvF16SymbolName
+                            : runtime::kEigenSingleThreadedConvF16SymbolName)
+          : (multi_threaded
+                 ? (use_mkl_dnn ? runtime::kMKLConvF32SymbolName
+                                : runtime::kEigenConvF32SymbolName)
+                 : runtime::kEigenSingleThreadedConvF32SymbolName);
+  if (!multi_threaded && use_mkl_dnn) {
+    LOG(WARNING) << "Using Eigen instead of MKL-DNN for single-threaded "
+                    "conv2d function.";
+  }
+  std::vector<llvm::Value*> args = {
+      GetExecutableRunOptionsArgument(),
+      BitCast(target_address, ir_ptr_type),
+      BitCast(lhs_address, ir_ptr_type),
+      BitCast(rhs_address, ir_ptr_type),
+      b_.getInt64(input_batch),
+      b_.getInt64(input_rows),
+      b_.getInt64(input_cols),
+      b_.getInt64(input_channels),
+      b_.getInt64(kernel_rows),
+      b_.getInt64(kernel_cols),
+      b_.getInt64(kernel_channels),
+      b_.getInt64(kernel_filters),
+      b_.getInt64(output_rows),
+      b_.getInt64(output_cols),
+      b_.getInt64(row_stride),
+      b_.getInt64(col_stride),
+      b_.getInt64(padding_top),
+      b_.getInt64(padding_bottom),
+      b_.getInt64(padding_left),
+      b_.getInt64(padding_right),
+      b_.getInt64(lhs_row_dilation),
+      b_.getInt64(lhs_col_dilation),
+      b_.getInt64(rhs_row_dilation),
+      b_.getInt64(rhs_col_dilation),
+  };
+  if (epilogue != nullptr) {
+    TF_RET_CHECK(primitive_type == F32 && !use_mkl_dnn);
+    fn_name = multi_threaded
+                  ? runtime::kEigenConvF32WithEpilogueSymbolName
+                  : runtime::kEigenSingleThreadedConvF32WithEpilogueSymbolName;
+    args.push_back(BitCast(epilogue->function, b_.getInt8PtrTy()));
+    args.push_back(BitCast(epilogue->context, b_.getInt8PtrTy()));
+  }
+  // The epilogue reads the operands of the fusion through its context.
+  EmitCallToFunc(fn_name, args, b_.getVoidTy(), /*does_not_throw=*/true,
+                 /*only_accesses_arg_memory=*/epilogue == nullptr);
+  return Status::OK();
+}
+
 Status IrEmitter::HandleFft(HloInstruction* fft) {
   auto operand = fft->operand(0);
   TF_RETURN_IF_ERROR(ElementTypesSameAndSupported(
@@ -1666,7 +1679,7 @@ IrEmitter::EmitInnerLoopForVectorizedReduction(
     const llvm_ir::IrArray::Index& output_index,
     const ShardedVectorType& accumulator_type, HloInstruction* init_value,
     HloInstruction* arg, absl::Span<const int64> dimensions,
-    unsigned element_alignment) {
+    unsigned element_alignment, const ReductionTile* tile) {
   ShardedVector accumulator;
   accumulator.reserve(accumulator_type.size());
   for (auto accumulator_shard_type : accumulator_type) {
@@ -1674,26 +1687,60 @@ IrEmitter::EmitInnerLoopForVectorizedReduction(
         accumulator_shard_type, "accumulator", &b_, 0));
   }
 
-  llvm::Value* init_value_ssa = Load(GetEmittedValueFor(init_value));
-
-  for (llvm::Value* accumulator_shard : accumulator) {
-    llvm::Value* initial_value;
-    auto shard_type = accumulator_shard->getType()->getPointerElementType();
-    if (auto vector_type = llvm::dyn_cast<llvm::VectorType>(shard_type)) {
-      initial_value =
-          VectorSplat(vector_type->getNumElements(), init_value_ssa);
-    } else {
-      initial_value = init_value_ssa;
+  if (tile != nullptr) {
+    // Continue from the partial results of the previous tiles.
+    llvm::Value* partial_result_address =
+        BitCast(tile->output->EmitArrayElementAddress(output_index, &b_),
+                b_.getInt8PtrTy());
+    for (int i = 0; i < accumulator.size(); i++) {
+      auto partial_result_address_typed =
+          BitCast(partial_result_address, accumulator[i]->getType());
+      auto partial_result =
+          AlignedLoad(partial_result_address_typed, element_alignment);
+      tile->output->AnnotateLoadStoreInstructionWithMetadata(partial_result);
+      AlignedStore(partial_result, accumulator[i], element_alignment);
+
+      if (i != (accumulator.size() - 1)) {
+        partial_result_address = ConstInBoundsGEP1_32(
+            partial_result->getType(), partial_result_address_typed, 1);
+      }
     }
+  } else {
+    llvm::Value* init_value_ssa = Load(GetEmittedValueFor(init_value));
+
+    for (llvm::Value* accumulator_shard : accumulator) {
+      llvm::Value* initial_value;
+      auto shard_type = accumulator_shard->getType()->getPointerElementType();
+      if (auto vector_type = llvm::dyn_cast<llvm::VectorType>(shard_type)) {
+        initial_value =
+            VectorSplat(vector_type->getNumElements(), init_value_ssa);
+      } else {
+        initial_value = init_value_ssa;
+      }
 
-    AlignedStore(initial_value, accumulator_shard, element_alignment);
+      AlignedStore(initial_value, accumulator_shard, element_alignment);
+    }
   }
 
   llvm_ir::ForLoopNest reduction_loop_nest(IrName(arg, "vectorized_inner"),
                                            &b_);
-  std::vector<llvm::Value*> input_multi_index =
-      reduction_loop_nest.AddLoopsForShapeOnDimensions(arg->shape(), dimensions,
-                                                       "reduction_dim");
+  std::vector<llvm::Value*> input_multi_index;
+  if (tile != nullptr) {
+    input_multi_index.resize(arg->shape().rank());
+    std::unique_ptr<llvm_ir::ForLoop> tile_loop = reduction_loop_nest.AddLoop(
+        llvm_ir::IrName("reduction_dim", absl::StrCat(dimensions[0])),
+        tile->start, tile->end);
+    input_multi_index[dimensions[0]] = tile_loop->GetIndVarValue();
+    std::vector<llvm::Value*> inner_multi_index =
+        reduction_loop_nest.AddLoopsForShapeOnDimensions(
+            arg->shape(), dimensions.subspan(1), "reduction_dim");
+    for (int64 dimension : dimensions.subspan(1)) {
+      input_multi_index[dimension] = inner_multi_index[dimension];
+    }
+  } else {
+    input_multi_index = reduction_loop_nest.AddLoopsForShapeOnDimensions(
+        arg->shape(), dimensions, "reduction_dim");
+  }
 
   SetToFirstInsertPoint(reduction_loop_nest.GetInnerLoopBodyBasicBlock(), &b_);
 
@@ -1764,6 +1811,15 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
     HloInstruction* reduce, HloInstruction* arg, HloInstruction* init_value,
     absl::Span<const int64> dimensions, HloComputation* function,
     string* failure_reason) {
+  // The vectorized loops, including those of
+  // EmitVectorizedReduceOverMinorDimensions, cover the whole output and ignore
+  // the bounds of the partition, so that the partitions would race.
+  if (ShouldEmitParallelLoopFor(*reduce)) {
+    *failure_reason =
+        "cannot generate vectorized reduction for the parallel CPU backend";
+    return false;
+  }
+
   if (!reduce->shape().IsArray()) {
     *failure_reason = "vectorization of variadic reduce not implemented";
     return false;
@@ -1805,13 +1861,14 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
       MinimumAlignmentForPrimitiveType(reduce->shape().element_type()));
 
   if (is_reduction_over_minor_dimension) {
-    // TODO(sanjoy): Implement vectorized reduction over the minor dimension.
-    *failure_reason = "reduction over minor dimension not implemented";
-    return false;
+    return EmitVectorizedReduceOverMinorDimensions(
+        reduce, arg, init_value, dimensions, reduction_generator,
+        vectorization_factor, element_alignment, failure_reason);
   }
 
   CHECK(!reduce->shape().IsTuple());
   TF_RETURN_IF_ERROR(EmitTargetAddressForOp(reduce));
+  llvm_ir::IrArray target_array = GetIrArrayFor(reduce);
 
   // We know we're not reducing over the most minor dimension, which means we
   // can lower the reduction loop as:
@@ -1832,6 +1889,48 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
   //      output[d1, d0] = vector_acc
   //    }
   //  }
+  //
+  // Every iteration of the d0 loop reads VS elements from each of R1 * R0
+  // rows of the input.  When there are many such rows, the lines that the
+  // hardware prefetcher brings in for the next iteration are evicted before
+  // that iteration reads them, so we tile the R1 loop with a tile size of RT
+  // picked from the size of the L1 cache, and keep the partial results in the
+  // output:
+  //
+  //  output = init
+  //  for (d1 in D1) {
+  //    for (rt in R1 with stride RT) {
+  //      for (d0 in D0 with stride VS) {
+  //        vector_acc = output[d1, d0]
+  //        for (r1 in [rt, min(rt + RT, R1))) {
+  //          for (r0 in R0) {
+  //            vector_acc =
+  //                elementwise_reduce(vector_acc, input[d1, d0, r1, r0])
+  //          }
+  //        }
+  //        output[d1, d0] = vector_acc
+  //      }
+  //    }
+  //  }
+  //
+  // which reduces the elements in the same order as the untiled loop nest.
+
+  int64 innermost_dimension = LayoutUtil::Minor(reduce->shape().layout(), 0);
+  int64 innermost_dimension_size =
+      reduce->shape().dimensions(innermost_dimension);
+
+  const int64 tile_size =
+      innermost_dimension_size >= 2 * vectorization_factor
+          ? ReductionTileSize(*arg, dimensions, vectorization_factor_in_bytes)
+          : 0;
+  if (tile_size > 0) {
+    llvm_ir::ElementGenerator init_generator =
+        [&](const llvm_ir::IrArray::Index&) -> StatusOr<llvm::Value*> {
+      return Load(GetEmittedValueFor(init_value));
+    };
+    TF_RETURN_IF_ERROR(llvm_ir::LoopEmitter(init_generator, target_array, &b_)
+                           .EmitLoop(IrName(reduce, "init")));
+  }
 
   llvm_ir::ForLoopNest loop_nest(IrName(reduce), &b_);
   std::vector<llvm::Value*> array_multi_index(
@@ -1846,9 +1945,34 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
     array_multi_index[dimension] = loop->GetIndVarValue();
   }
 
-  int64 innermost_dimension = LayoutUtil::Minor(reduce->shape().layout(), 0);
-  int64 innermost_dimension_size =
-      reduce->shape().dimensions(innermost_dimension);
+  std::unique_ptr<llvm_ir::ForLoop> tile_loop;
+  if (tile_size > 0) {
+    tile_loop = loop_nest.AddLoop(
+        /*start_index=*/0,
+        /*end_index=*/arg->shape().dimensions(dimensions[0]),
+        /*stride=*/tile_size, "reduction_tile");
+  }
+
+  // Emits the bounds of the current tile, if any.  This can't be done in the
+  // body of `tile_loop`, as adding a loop to `loop_nest` moves the existing
+  // instructions of the body after the new loop.
+  auto emit_tile = [&]() -> absl::optional<ReductionTile> {
+    if (tile_loop == nullptr) {
+      return absl::nullopt;
+    }
+    llvm::Value* tile_start = tile_loop->GetIndVarValue();
+    llvm::Value* tile_end = NSWAdd(tile_start, b_.getInt64(tile_size));
+    llvm::Value* dimension_size =
+        b_.getInt64(arg->shape().dimensions(dimensions[0]));
+    return ReductionTile{
+        tile_start,
+        Select(ICmpSLT(tile_end, dimension_size), tile_end, dimension_size),
+        &target_array};
+  };
+  // Whether the loop over the innermost dimension is nested in another loop.
+  const bool innermost_loop_is_nested =
+      LayoutUtil::MinorToMajor(reduce->shape()).size() > 1 ||
+      tile_loop != nullptr;
 
   if (llvm::BasicBlock* innermost_body_bb =
           loop_nest.GetInnerLoopBodyBasicBlock()) {
@@ -1872,22 +1996,23 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
         reduce->shape().element_type(), vectorization_factor);
     llvm_ir::IrArray::Index array_index(array_multi_index, reduce->shape(),
                                         b_.getInt64Ty());
-    TF_ASSIGN_OR_RETURN(std::vector<llvm::Value*> accumulator,
-                        EmitInnerLoopForVectorizedReduction(
-                            reduction_generator, array_index, vector_type,
-                            init_value, arg, dimensions, element_alignment));
+    absl::optional<ReductionTile> tile = emit_tile();
+    TF_ASSIGN_OR_RETURN(
+        std::vector<llvm::Value*> accumulator,
+        EmitInnerLoopForVectorizedReduction(
+            reduction_generator, array_index, vector_type, init_value, arg,
+            dimensions, element_alignment, tile ? &*tile : nullptr));
 
-    llvm_ir::IrArray target_array = GetIrArrayFor(reduce);
     llvm::Value* output_address =
         target_array.EmitArrayElementAddress(array_index, &b_);
     EmitShardedVectorStore(output_address, accumulator, element_alignment,
                            target_array);
 
     if (auto exit_terminator = loop->GetExitBasicBlock()->getTerminator()) {
-      CHECK_GT(LayoutUtil::MinorToMajor(reduce->shape()).size(), 1);
+      CHECK(innermost_loop_is_nested);
       b_.SetInsertPoint(exit_terminator);
     } else {
-      CHECK_EQ(LayoutUtil::MinorToMajor(reduce->shape()).size(), 1);
+      CHECK(!innermost_loop_is_nested);
       b_.SetInsertPoint(loop->GetExitBasicBlock());
     }
   }
@@ -1906,12 +2031,13 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
         innermost_dimension_size % vectorization_factor);
     llvm_ir::IrArray::Index array_index(array_multi_index, reduce->shape(),
                                         b_.getInt64Ty());
-    TF_ASSIGN_OR_RETURN(std::vector<llvm::Value*> accumulator,
-                        EmitInnerLoopForVectorizedReduction(
-                            reduction_generator, array_index, vector_type,
-                            init_value, arg, dimensions, element_alignment));
+    absl::optional<ReductionTile> tile = emit_tile();
+    TF_ASSIGN_OR_RETURN(
+        std::vector<llvm::Value*> accumulator,
+        EmitInnerLoopForVectorizedReduction(
+            reduction_generator, array_index, vector_type, init_value, arg,
+            dimensions, element_alignment, tile ? &*tile : nullptr));
 
-    llvm_ir::IrArray target_array = GetIrArrayFor(reduce);
     llvm::Value* output_address =
         target_array.EmitArrayElementAddress(array_index, &b_);
     EmitShardedVectorStore(output_address, accumulator, element_alignment,
@@ -1925,6 +2051,322 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
   return true;
 }
 
+StatusOr<bool> IrEmitter::EmitVectorizedReduceOverMinorDimensions(
+    HloInstruction* reduce, HloInstruction* arg, HloInstruction* init_value,
+    absl::Span<const int64> dimensions,
+    const ReductionGenerator& reduction_generator, int vectorization_factor,
+    unsigned element_alignment, string* failure_reason) {
+  // The reduced dimensions have to be the most minor ones, so that every
+  // output element is the reduction of a contiguous row of the input.
+  absl::Span<const int64> minor_to_major =
+      LayoutUtil::MinorToMajor(arg->shape());
+  int64 row_size = 1;
+  for (int i = 0; i < dimensions.size(); ++i) {
+    if (!absl::c_linear_search(dimensions, minor_to_major[i])) {
+      *failure_reason =
+          "reduction over minor and major dimensions not implemented";
+      return false;
+    }
+    row_size *= arg->shape().dimensions(minor_to_major[i]);
+  }
+
+  if (row_size < vectorization_factor) {
+    *failure_reason = "reduced rows are shorter than the vectorization factor";
+    return false;
+  }
+
+  TF_RETURN_IF_ERROR(EmitTargetAddressForOp(reduce));
+
+  // We lower the reduction of the N rows of C elements as:
+  //
+  //  for (n in N) {
+  //    vector_acc = input[n, 0 : VS]
+  //    for (c in [VS, C - C % VS) with stride VS) {
+  //      vector_acc = elementwise_reduce(vector_acc, input[n, c : c + VS])
+  //    }
+  //    acc = reduce(init, horizontal_reduce(vector_acc))
+  //    for (c in [C - C % VS, C)) {
+  //      acc = reduce(acc, input[n, c])
+  //    }
+  //    output[n] = acc
+  //  }
+  //
+  // This reduces the elements of a row in another order than the elemental
+  // emitter, which the semantics of Reduce allow.
+  const PrimitiveType element_type = reduce->shape().element_type();
+  const int64 row_count = ShapeUtil::ElementsIn(reduce->shape());
+  const Shape arg_rows_shape = ShapeUtil::MakeShapeWithDescendingLayout(
+      element_type, {row_count, row_size});
+  const Shape target_rows_shape =
+      ShapeUtil::MakeShapeWithDescendingLayout(element_type, {row_count});
+  llvm_ir::IrArray arg_array =
+      GetIrArrayFor(arg).CastToShape(arg_rows_shape, &b_);
+  llvm_ir::IrArray target_array =
+      GetIrArrayFor(reduce).CastToShape(target_rows_shape, &b_);
+
+  ShardedVectorType vector_type =
+      CreateShardedVectorType(element_type, vectorization_factor);
+  ShardedVector vector_accumulator;
+  vector_accumulator.reserve(vector_type.size());
+  for (llvm::Type* shard_type : vector_type) {
+    vector_accumulator.push_back(llvm_ir::EmitAllocaAtFunctionEntry(
+        shard_type, "vector_accumulator", &b_, 0));
+  }
+  llvm::Value* accumulator = llvm_ir::EmitAllocaAtFunctionEntry(
+      llvm_ir::PrimitiveTypeToIrType(element_type, module_), "accumulator",
+      &b_, 0);
+
+  auto load_vector = [&](llvm::Value* row, llvm::Value* column) {
+    llvm_ir::IrArray::Index index({row, column}, arg_rows_shape,
+                                  b_.getInt64Ty());
+    llvm::Value* address = BitCast(
+        arg_array.EmitArrayElementAddress(index, &b_), b_.getInt8PtrTy());
+    ShardedVector vector;
+    vector.reserve(vector_type.size());
+    for (int i = 0; i < vector_type.size(); i++) {
+      auto address_typed =
+          BitCast(address, llvm::PointerType::getUnqual(vector_type[i]));
+      auto shard = AlignedLoad(address_typed, element_alignment);
+      arg_array.AnnotateLoadStoreInstructionWithMetadata(shard);
+      vector.push_back(shard);
+
+      if (i != (vector_type.size() - 1)) {
+        address = ConstInBoundsGEP1_32(vector_type[i], address_typed, 1);
+      }
+    }
+    return vector;
+  };
+
+  const int64 vectorized_row_size = row_size - row_size % vectorization_factor;
+  KernelSupportLibrary ksl(&b_);
+  ksl.For(IrName(reduce, "row"), /*start=*/0, /*end=*/row_count, /*step=*/1,
+          [&](llvm::Value* row) {
+            ShardedVector first_vector = load_vector(row, b_.getInt64(0));
+            for (int i = 0; i < vector_accumulator.size(); i++) {
+              AlignedStore(first_vector[i], vector_accumulator[i],
+                           element_alignment);
+            }
+
+            ksl.For(IrName(reduce, "column"), /*start=*/vectorization_factor,
+                    /*end=*/vectorized_row_size, /*step=*/vectorization_factor,
+                    [&](llvm::Value* column) {
+                      ShardedVector addend = load_vector(row, column);
+                      for (int i = 0; i < vector_accumulator.size(); i++) {
+                        AlignedStore(
+                            reduction_generator(
+                                &b_,
+                                AlignedLoad(vector_accumulator[i],
+                                            element_alignment),
+                                addend[i]),
+                            vector_accumulator[i], element_alignment);
+                      }
+                    });
+
+            ShardedVector vector_result;
+            vector_result.reserve(vector_accumulator.size());
+            for (llvm::Value* accumulator_shard : vector_accumulator) {
+              vector_result.push_back(
+                  AlignedLoad(accumulator_shard, element_alignment));
+            }
+            Store(reduction_generator(
+                      &b_, Load(GetEmittedValueFor(init_value)),
+                      EmitHorizontalReduction(reduction_generator,
+                                              vector_result)),
+                  accumulator);
+
+            ksl.For(IrName(reduce, "column_epilogue"),
+                    /*start=*/vectorized_row_size, /*end=*/row_size,
+                    /*step=*/1, [&](llvm::Value* column) {
+                      llvm_ir::IrArray::Index index(
+                          {row, column}, arg_rows_shape, b_.getInt64Ty());
+                      Store(reduction_generator(
+                                &b_, Load(accumulator),
+                                arg_array.EmitReadArrayElement(index, &b_)),
+                            accumulator);
+                    });
+
+            target_array.EmitWriteArrayElement(
+                llvm_ir::IrArray::Index({row}, target_rows_shape,
+                                        b_.getInt64Ty()),
+                Load(accumulator), &b_);
+          });
+  return true;
+}
+
+llvm::Value* IrEmitter::EmitHorizontalReduction(
+    const ReductionGenerator& reduction_generator,
+    const ShardedVector& vector) {
+  // Reduce the consecutive shards of the same type elementwise first.
+  ShardedVector partial_results;
+  for (llvm::Value* shard : vector) {
+    if (!partial_results.empty() &&
+        partial_results.back()->getType() == shard->getType()) {
+      partial_results.back() =
+          reduction_generator(&b_, partial_results.back(), shard);
+    } else {
+      partial_results.push_back(shard);
+    }
+  }
+
+  llvm::Value* result = nullptr;
+  for (llvm::Value* partial_result : partial_results) {
+    if (auto vector_type =
+            llvm::dyn_cast<llvm::VectorType>(partial_result->getType())) {
+      // Every iteration reduces the upper half of the remaining lanes into
+      // the lower half.  The shards have a power of two number of lanes.
+      const unsigned lane_count = vector_type->getNumElements();
+      llvm::SmallVector<llvm::Constant*, 32> mask(lane_count, nullptr);
+      for (unsigned remaining = lane_count; remaining != 1; remaining >>= 1) {
+        for (unsigned i = 0; i < lane_count; ++i) {
+          mask[i] = i < remaining / 2
+                        ? b_.getInt32(remaining / 2 + i)
+                        : llvm::UndefValue::get(b_.getInt32Ty());
+        }
+        llvm::Value* upper_half = b_.CreateShuffleVector(
+            partial_result, llvm::UndefValue::get(vector_type),
+            llvm::ConstantVector::get(mask));
+        partial_result =
+            reduction_generator(&b_, partial_result, upper_half);
+      }
+      partial_result = b_.CreateExtractElement(partial_result, b_.getInt32(0));
+    }
+    result = result == nullptr
+                 ? partial_result
+                 : reduction_generator(&b_, result, partial_result);
+  }
+  return result;
+}
+
+int64 IrEmitter::ReductionTileSize(const HloInstruction& arg,
+                                   absl::Span<const int64> dimensions,
+                                   int vectorization_factor_in_bytes) {
+  if (dimensions.empty()) {
+    return 0;
+  }
+
+  // Every index of the outermost reduced dimension reads one vector per index
+  // of the other reduced dimensions.  Size the tiles so that the vectors read
+  // for the current output vector, and for the next one which the hardware
+  // prefetcher brings in meanwhile, fill at most half of the L1 cache.
+  int64 inner_reduced_elements = 1;
+  for (int64 dimension : dimensions.subspan(1)) {
+    inner_reduced_elements *= arg.shape().dimensions(dimension);
+  }
+  const int64 l1_cache_size = target_machine_features_.l1_data_cache_byte_size(
+      *compute_function_->function());
+  const int64 tile_size =
+      l1_cache_size / 2 /
+      std::max<int64>(
+          1, 2 * vectorization_factor_in_bytes * inner_reduced_elements);
+  if (tile_size == 0 || arg.shape().dimensions(dimensions[0]) <= tile_size) {
+    return 0;
+  }
+  return tile_size;
+}
+
+StatusOr<bool> IrEmitter::EmitTiledTranspose(HloInstruction* copy,
+                                             string* failure_reason) {
+  if (ShouldEmitParallelLoopFor(*copy)) {
+    *failure_reason =
+        "cannot generate tiled transpose for the parallel CPU backend";
+    return false;
+  }
+
+  const HloInstruction* operand = copy->operand(0);
+  absl::optional<std::vector<int64>> dims_021 =
+      ShapeUtil::FindTranspose021(operand->shape(), copy->shape());
+  if (!dims_021) {
+    *failure_reason = "layouts are not a 0-2-1 transpose of each other";
+    return false;
+  }
+
+  const PrimitiveType element_type = copy->shape().element_type();
+  const int64 tile_size = TransposeTileSize(element_type);
+  const int64 batch_size = (*dims_021)[0];
+  const int64 rows = (*dims_021)[1];
+  const int64 columns = (*dims_021)[2];
+  if (rows < tile_size || columns < tile_size) {
+    *failure_reason = "transposed dimensions are smaller than a tile";
+    return false;
+  }
+
+  TF_RETURN_IF_ERROR(EmitTargetAddressForOp(copy));
+
+  // The output is viewed as a [batch_size, rows, columns] array and the
+  // operand as a [batch_size, columns, rows] array, both with the physical
+  // layout of the original shapes.  We lower the copy as:
+  //
+  //  for (b in batch_size) {
+  //    for (rt in rows with stride T) {
+  //      for (ct in columns with stride T) {
+  //        for (r in [rt, min(rt + T, rows))) {
+  //          for (c in [ct, min(ct + T, columns))) {
+  //            output[b, r, c] = operand[b, c, r]
+  //          }
+  //        }
+  //      }
+  //    }
+  //  }
+  //
+  // so that the T rows of the operand read by a tile stay in the L1 cache
+  // while the T rows of the output are written.
+  const Shape target_shape = ShapeUtil::MakeShapeWithDescendingLayout(
+      element_type, {batch_size, rows, columns});
+  const Shape operand_shape = ShapeUtil::MakeShapeWithDescendingLayout(
+      element_type, {batch_size, columns, rows});
+  llvm_ir::IrArray operand_array =
+      GetIrArrayFor(operand).CastToShape(operand_shape, &b_);
+  llvm_ir::IrArray target_array =
+      GetIrArrayFor(copy).CastToShape(target_shape, &b_);
+
+  auto tile_end = [&](llvm::Value* tile_start, int64 dimension_size) {
+    llvm::Value* end = NSWAdd(tile_start, b_.getInt64(tile_size));
+    return Select(ICmpSLT(end, b_.getInt64(dimension_size)), end,
+                  b_.getInt64(dimension_size));
+  };
+
+  KernelSupportLibrary ksl(&b_, llvm_ir::UnrollMode::kDefaultUnroll,
+                           /*prevent_vectorization=*/false);
+  ksl.For("transpose.batch", 0, batch_size, 1, [&](llvm::Value* batch) {
+    ksl.For("transpose.rt", 0, rows, tile_size, [&](llvm::Value* rt) {
+      llvm::Value* row_end = tile_end(rt, rows);
+      ksl.For("transpose.ct", 0, columns, tile_size, [&](llvm::Value* ct) {
+        llvm::Value* column_end = tile_end(ct, columns);
+        ksl.For("transpose.r", rt, row_end, 1, [&](llvm::Value* row) {
+          ksl.For("transpose.c", ct, column_end, 1, [&](llvm::Value* column) {
+            llvm_ir::IrArray::Index operand_index(
+                {batch, column, row}, operand_shape, b_.getInt64Ty());
+            llvm_ir::IrArray::Index target_index(
+                {batch, row, column}, target_shape, b_.getInt64Ty());
+            target_array.EmitWriteArrayElement(
+                target_index,
+                operand_array.EmitReadArrayElement(operand_index, &b_), &b_);
+          });
+        });
+      });
+    });
+  });
+  return true;
+}
+
+int64 IrEmitter::TransposeTileSize(PrimitiveType element_type) {
+  const llvm::Function& function = *compute_function_->function();
+  const int64 element_size = ShapeUtil::ByteSizeOfPrimitiveType(element_type);
+
+  // The rows of a tile span whole cache lines, and the tile is as large as
+  // possible while an operand and an output tile fit in half of the L1 cache.
+  int64 tile_size = std::max<int64>(
+      1, target_machine_features_.cache_line_byte_size(function) /
+             element_size);
+  const int64 max_tiles_byte_size =
+      target_machine_features_.l1_data_cache_byte_size(function) / 2;
+  while (2 * (2 * tile_size) * (2 * tile_size) * element_size <=
+         max_tiles_byte_size) {
+    tile_size *= 2;
+  }
+  return tile_size;
+}
+
 Status IrEmitter::HandleReduce(HloInstruction* reduce) {
   auto arg = reduce->mutable_operand(0);
   auto init_value = reduce->mutable_operand(1);
@@ -2216,6 +2658,15 @@ Status IrEmitter::HandleFusion(HloInstruction* fusion) {
     return EmitTargetElementLoop(fusion, generator);
   } else if (fusion->IsOutputFusion()) {
     VLOG(3) << "HandleFusion kOutput";
+    // Other than a dot with a fused addend, output fusions apply an epilogue
+    // to the result of their dot or convolution.
+    if (root->opcode() != HloOpcode::kAdd ||
+        absl::c_none_of(root->operands(),
+                        [](const HloInstruction* operand) {
+                          return operand->opcode() == HloOpcode::kParameter;
+                        })) {
+      return EmitOutputFusionWithEpilogue(fusion);
+    }
     int64 dot_op_index = root->operand(0)->opcode() == HloOpcode::kDot ? 0 : 1;
     const HloInstruction* dot = root->operand(dot_op_index);
     CHECK_EQ(dot->opcode(), HloOpcode::kDot)
@@ -2240,14 +2691,165 @@ Status IrEmitter::HandleFusion(HloInstruction* fusion) {
 
     TF_RETURN_IF_ERROR(EmitDotOperation(
         *dot, target_array, lhs_array, rhs_array, &addend_array,
-        GetExecutableRunOptionsArgument(), &b_, mlir_context_,
-        hlo_module_config_, target_machine_features_));
+        /*epilogue=*/nullptr, GetExecutableRunOptionsArgument(), &b_,
+        mlir_context_, hlo_module_config_, target_machine_features_));
     return Status::OK();
   } else {
     return Unimplemented("Fusion kind not implemented on CPU");
   }
 }
 
+Status IrEmitter::EmitOutputFusionWithEpilogue(HloInstruction* fusion) {
+  auto producer_it = absl::c_find_if(
+      fusion->fused_instructions(), [](const HloInstruction* instruction) {
+        return instruction->opcode() == HloOpcode::kDot ||
+               instruction->opcode() == HloOpcode::kConvolution;
+      });
+  TF_RET_CHECK(producer_it != fusion->fused_instructions().end())
+      << fusion->ToString();
+  const HloInstruction* producer = *producer_it;
+  TF_RET_CHECK(ShapeUtil::Equal(producer->shape(), fusion->shape()));
+  TF_RET_CHECK(producer->operand(0)->opcode() == HloOpcode::kParameter &&
+               producer->operand(1)->opcode() == HloOpcode::kParameter);
+  const HloInstruction* lhs =
+      fusion->operand(producer->operand(0)->parameter_number());
+  const HloInstruction* rhs =
+      fusion->operand(producer->operand(1)->parameter_number());
+
+  TF_RETURN_IF_ERROR(EmitTargetAddressForOp(fusion));
+  llvm_ir::IrArray target_array = GetIrArrayFor(fusion);
+
+  bool is_dot = producer->opcode() == HloOpcode::kDot;
+  bool runtime_applies_epilogue =
+      is_dot ? DotImplementationCanApplyEpilogue(*producer,
+                                                 target_machine_features_)
+             : ImplementedAsEigenConvolution(*producer,
+                                             target_machine_features_) &&
+                   producer->shape().element_type() == F32 &&
+                   !hlo_module_config_.debug_options().xla_cpu_use_mkl_dnn();
+  if (runtime_applies_epilogue) {
+    VLOG(3) << "Epilogue of " << fusion->name() << " applied by the runtime";
+    TF_ASSIGN_OR_RETURN(llvm::Function * epilogue_function,
+                        EmitEpilogueFunction(fusion, producer));
+    std::vector<llvm::Value*> operand_addresses;
+    for (const HloInstruction* operand : fusion->operands()) {
+      operand_addresses.push_back(GetEmittedValueFor(operand));
+    }
+    RuntimeEpilogue epilogue{
+        epilogue_function,
+        EncodeArrayFunctionArguments(operand_addresses,
+                                     IrName(fusion, "epilogue"), &b_)};
+    if (is_dot) {
+      return EmitDotOperation(
+          *producer, target_array, GetIrArrayFor(lhs), GetIrArrayFor(rhs),
+          /*addend_array=*/nullptr, &epilogue,
+          GetExecutableRunOptionsArgument(), &b_, mlir_context_,
+          hlo_module_config_, target_machine_features_);
+    }
+    return EmitCallToEigenConvolution(
+        *producer, GetEmittedValueFor(fusion), GetEmittedValueFor(lhs),
+        GetEmittedValueFor(rhs), &epilogue);
+  }
+
+  // Compute the dot or convolution into the output buffer, then apply the
+  // epilogue in place while the output is still (partially) in cache.
+  if (is_dot) {
+    TF_RETURN_IF_ERROR(EmitDotOperation(
+        *producer, target_array, GetIrArrayFor(lhs), GetIrArrayFor(rhs),
+        /*addend_array=*/nullptr, /*epilogue=*/nullptr,
+        GetExecutableRunOptionsArgument(), &b_, mlir_context_,
+        hlo_module_config_, target_machine_features_));
+  } else {
+    TF_RET_CHECK(
+        ImplementedAsEigenConvolution(*producer, target_machine_features_))
+        << producer->ToString();
+    TF_RETURN_IF_ERROR(EmitCallToEigenConvolution(
+        *producer, GetEmittedValueFor(fusion), GetEmittedValueFor(lhs),
+        GetEmittedValueFor(rhs), /*epilogue=*/nullptr));
+  }
+  CpuElementalIrEmitter elemental_emitter(hlo_module_config_, this, module_);
+  FusedIrEmitter fused_emitter(&elemental_emitter);
+  BindFusionArguments(fusion, &fused_emitter);
+  fused_emitter.BindGenerator(
+      producer, [&](const llvm_ir::IrArray::Index& index) {
+        return target_array.EmitReadArrayElement(index, &b_);
+      });
+  TF_ASSIGN_OR_RETURN(auto generator, fused_emitter.GetGenerator(
+                                          fusion->fused_expression_root()));
+  return EmitTargetElementLoop(fusion, "epilogue", generator);
+}
+
+StatusOr<llvm::Function*> IrEmitter::EmitEpilogueFunction(
+    const HloInstruction* fusion, const HloInstruction* producer) {
+  llvm::IRBuilder<>::InsertPointGuard guard(b_);
+
+  llvm::Type* int8_ptr_type = b_.getInt8PtrTy();
+  llvm::Type* element_type =
+      llvm_ir::PrimitiveTypeToIrType(fusion->shape().element_type(), module_);
+  llvm::FunctionType* function_type = llvm::FunctionType::get(
+      b_.getVoidTy(),
+      {int8_ptr_type, element_type->getPointerTo(), b_.getInt64Ty(),
+       b_.getInt64Ty()},
+      /*isVarArg=*/false);
+  llvm::Function* function = llvm_ir::CreateCpuFunction(
+      function_type, llvm::GlobalValue::InternalLinkage, hlo_module_config_,
+      IrName(fusion, "epilogue"), module_);
+  llvm::Function::arg_iterator arg = function->arg_begin();
+  llvm::Value* context = &*arg++;
+  llvm::Value* data = &*arg++;
+  llvm::Value* offset = &*arg++;
+  llvm::Value* size = &*arg;
+  b_.SetInsertPoint(llvm::BasicBlock::Create(module_->getContext(), "entry",
+                                             function));
+
+  // The operands of the fusion are read through the addresses in `context`,
+  // the result of the producer from the element being overwritten.
+  CpuElementalIrEmitter elemental_emitter(hlo_module_config_, this, module_);
+  FusedIrEmitter fused_emitter(&elemental_emitter);
+  llvm::Value* operand_addresses =
+      BitCast(context, int8_ptr_type->getPointerTo());
+  for (int64 i = 0; i < fusion->operand_count(); ++i) {
+    const Shape& shape = fusion->operand(i)->shape();
+    llvm::Value* address = BitCast(
+        Load(InBoundsGEP(operand_addresses, {b_.getInt64(i)})),
+        IrShapeType(shape)->getPointerTo());
+    llvm_ir::IrArray array(address, shape);
+    fused_emitter.BindGenerator(
+        fusion->fused_parameter(i),
+        [this, array](const llvm_ir::IrArray::Index& index) {
+          return array.EmitReadArrayElement(index, &b_);
+        });
+  }
+  llvm::Value* element_address = nullptr;
+  fused_emitter.BindGenerator(
+      producer,
+      [&](const llvm_ir::IrArray::Index&) -> StatusOr<llvm::Value*> {
+        return Load(element_address);
+      });
+  TF_ASSIGN_OR_RETURN(auto generator, fused_emitter.GetGenerator(
+                                          fusion->fused_expression_root()));
+
+  // The elements lie within one row of the minor-most dimension, so that
+  // only the index in that dimension changes from one to the next.
+  const Shape& shape = fusion->shape();
+  llvm_ir::IrArray::Index start(offset, shape, &b_);
+  int64 minor_dimension = LayoutUtil::Minor(shape.layout(), 0);
+  KernelSupportLibrary ksl(&b_, llvm_ir::UnrollMode::kDefaultUnroll,
+                           /*prevent_vectorization=*/false);
+  TF_RETURN_IF_ERROR(ksl.ForWithStatus(
+      "epilogue", /*start=*/b_.getInt64(0), /*end=*/size, /*step=*/1,
+      [&](llvm::Value* i) -> Status {
+        element_address = InBoundsGEP(data, {i});
+        TF_ASSIGN_OR_RETURN(
+            llvm::Value * value,
+            generator(start.AddOffsetToDim(i, minor_dimension, &b_)));
+        Store(value, element_address);
+        return Status::OK();
+      }));
+  RetVoid();
+  return function;
+}
+
 Status IrEmitter::HandleCall(HloInstruction* call) {
   HloComputation* computation = call->to_apply();
   llvm::Function* call_ir_function = FindOrDie(emitted_functions_, computation);
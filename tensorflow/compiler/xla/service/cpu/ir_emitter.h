@@ -57,6 +57,9 @@ limitations under the License.
 
 namespace xla {
 namespace cpu {
+
+struct RuntimeEpilogue;
+
 // This class is the top-level API for the XLA HLO --> LLVM IR compiler.  It
 // implements the DfsHloVisitor interface and emits HLO computations as LLVM IR
 // functions.
@@ -239,6 +242,28 @@ class IrEmitter : public DfsHloVisitorWithDefault,
   void BindFusionArguments(const HloInstruction* fusion,
                            FusedIrEmitter* fused_emitter);
 
+  // Emits a call to the Eigen runtime computing `convolution`, which must be
+  // ImplementedAsEigenConvolution, into `target_address`.  If `epilogue` is
+  // not null the runtime applies it to the result, see runtime_epilogue.h.
+  Status EmitCallToEigenConvolution(const HloInstruction& convolution,
+                                    llvm::Value* target_address,
+                                    llvm::Value* lhs_address,
+                                    llvm::Value* rhs_address,
+                                    const RuntimeEpilogue* epilogue);
+
+  // Emits an output fusion made of a dot or a convolution followed by
+  // elementwise operations on its result (its "epilogue").  The epilogue is
+  // handed to the Eigen runtime when it can apply it to the output blocks of
+  // the dot or convolution; otherwise it runs in place over the output right
+  // after it has been computed.
+  Status EmitOutputFusionWithEpilogue(HloInstruction* fusion);
+
+  // Emits the epilogue of `fusion`, whose dot or convolution is `producer`, as
+  // a function with the signature of EpilogueFunction in runtime_epilogue.h.
+  // The context it receives holds the addresses of the operands of `fusion`.
+  StatusOr<llvm::Function*> EmitEpilogueFunction(
+      const HloInstruction* fusion, const HloInstruction* producer);
+
   // Augments IrArray with aliasing information.
   void AddAliasingInformationToIrArray(const HloInstruction& hlo,
                                        llvm_ir::IrArray* array) {
@@ -399,14 +424,58 @@ class IrEmitter : public DfsHloVisitorWithDefault,
   ReductionGenerator MatchReductionGenerator(HloComputation* function,
                                              string* failure_reason) const;
 
+  // A tile [start, end) of the outermost reduced dimension of a vectorized
+  // reduction, whose partial results are accumulated in "output".
+  struct ReductionTile {
+    llvm::Value* start;
+    llvm::Value* end;
+    const llvm_ir::IrArray* output;
+  };
+
   // Emits the inner loop nest that runs the reduction.  Helper function for
-  // EmitVectorizedReduce.
+  // EmitVectorizedReduce.  If "tile" is not null, the loop over the outermost
+  // reduced dimension only covers the tile and the reduction starts from the
+  // partial results in the output instead of from "init_value".
   StatusOr<ShardedVector> EmitInnerLoopForVectorizedReduction(
       const ReductionGenerator& reduction_generator,
       const llvm_ir::IrArray::Index& output_index,
       const ShardedVectorType& accumulator_type, HloInstruction* init_value,
       HloInstruction* arg, absl::Span<const int64> dimensions,
-      unsigned element_alignment);
+      unsigned element_alignment, const ReductionTile* tile = nullptr);
+
+  // Emits a vectorized reduction over the most minor dimensions of "arg",
+  // which reduces every row of contiguous elements into vector accumulators
+  // before reducing these horizontally.  Helper function for
+  // EmitVectorizedReduce.
+  StatusOr<bool> EmitVectorizedReduceOverMinorDimensions(
+      HloInstruction* reduce, HloInstruction* arg, HloInstruction* init_value,
+      absl::Span<const int64> dimensions,
+      const ReductionGenerator& reduction_generator, int vectorization_factor,
+      unsigned element_alignment, string* failure_reason);
+
+  // Emits LLVM IR reducing all the elements of "vector" into a scalar.
+  llvm::Value* EmitHorizontalReduction(
+      const ReductionGenerator& reduction_generator,
+      const ShardedVector& vector);
+
+  // Returns how many indices of the outermost reduced dimension a vectorized
+  // reduction of "arg" over "dimensions" processes per tile, or 0 if the
+  // reduction doesn't need to be tiled.  See EmitVectorizedReduce.
+  int64 ReductionTileSize(const HloInstruction& arg,
+                          absl::Span<const int64> dimensions,
+                          int vectorization_factor_in_bytes);
+
+  // Tries to emit a copy that transposes the physical layout of its operand
+  // as a loop nest over square tiles, so that the operand and output elements
+  // of a tile stay in the L1 cache.  Returns true if successful, and false on
+  // failure.  On failure, sets "failure_reason" to a string describing why it
+  // could not emit a tiled transpose.
+  StatusOr<bool> EmitTiledTranspose(HloInstruction* copy,
+                                    string* failure_reason);
+
+  // Returns the number of rows and columns of the tiles of a tiled transpose
+  // of "element_type" elements.
+  int64 TransposeTileSize(PrimitiveType element_type);
 
   // Tries to emit a fast concatenate operation using memcpy.  Returns true if
   // successful, and false on failure.  On failure, sets "failure_reason" to a
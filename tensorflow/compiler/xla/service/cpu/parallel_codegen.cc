@@ -0,0 +1,114 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/parallel_codegen.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace xla {
+namespace cpu {
+
+void MakeSplitPoint(llvm::Function* function) {
+  if (function->hasExternalLinkage()) {
+    return;
+  }
+  function->setName(
+      absl::StrCat("__xla_cpu_split_", function->getName().str()));
+  function->setLinkage(llvm::GlobalValue::ExternalLinkage);
+}
+
+StatusOr<std::vector<std::unique_ptr<llvm::MemoryBuffer>>>
+SplitAndCompileModule(std::unique_ptr<llvm::Module> module, int num_parts,
+                      const ModuleCompiler& compile_part) {
+  // The parts share the context of `module`, which is not thread-safe, so
+  // they are moved to contexts of their own through bitcode.
+  std::vector<string> part_bitcodes;
+  llvm::SplitModule(
+      std::move(module), num_parts,
+      [&](std::unique_ptr<llvm::Module> part) {
+        string bitcode;
+        llvm::raw_string_ostream stream(bitcode);
+        llvm::WriteBitcodeToFile(*part, stream);
+        stream.flush();
+        part_bitcodes.push_back(std::move(bitcode));
+      },
+      /*PreserveLocals=*/true);
+  VLOG(2) << "Split the LLVM module into " << part_bitcodes.size()
+          << " parts";
+
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> object_files(
+      part_bitcodes.size());
+  std::vector<Status> statuses(part_bitcodes.size());
+  auto compile = [&](int64 i) {
+    llvm::LLVMContext context;
+    llvm::Expected<std::unique_ptr<llvm::Module>> part =
+        llvm::parseBitcodeFile(
+            llvm::MemoryBufferRef(part_bitcodes[i], absl::StrCat("part", i)),
+            context);
+    if (!part) {
+      statuses[i] = InternalError("Reading part %d of the module failed: %s", i,
+                                  llvm::toString(part.takeError()));
+      return;
+    }
+    llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> object_file =
+        compile_part(**part);
+    if (!object_file) {
+      statuses[i] = InternalError("Compiling part %d of the module failed: %s",
+                                  i, llvm::toString(object_file.takeError()));
+      return;
+    }
+    object_files[i] = std::move(*object_file);
+  };
+
+  const int num_threads =
+      std::min<int>(part_bitcodes.size(), tensorflow::port::MaxParallelism());
+  if (num_threads <= 1) {
+    for (int64 i = 0; i < part_bitcodes.size(); ++i) {
+      compile(i);
+    }
+  } else {
+    // Destroying the pool waits for the compilation of all the parts.
+    tensorflow::thread::ThreadPool pool(tensorflow::Env::Default(),
+                                        "xla_cpu_codegen", num_threads);
+    for (int64 i = 0; i < part_bitcodes.size(); ++i) {
+      pool.Schedule([&compile, i] { compile(i); });
+    }
+  }
+
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return std::move(object_files);
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,57 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PARALLEL_CODEGEN_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PARALLEL_CODEGEN_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+namespace cpu {
+
+// Compiles an LLVM module to an object file.
+using ModuleCompiler =
+    std::function<llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>>(
+        llvm::Module&)>;
+
+// Gives `function` external linkage, under a name which can't clash with the
+// symbols of the runtime, so that SplitAndCompileModule can put it in another
+// part than its callers.
+void MakeSplitPoint(llvm::Function* function);
+
+// Splits `module` into up to `num_parts` modules, and compiles them to object
+// files in parallel with `compile_part`, which must be thread-safe. Each part
+// is compiled in an LLVM context of its own.
+//
+// The module is only split between global values with external linkage: the
+// functions with internal linkage stay in the same part as their callers, so
+// that they can still be inlined into them. The object files reference the
+// functions of each other, and must be linked together.
+StatusOr<std::vector<std::unique_ptr<llvm::MemoryBuffer>>>
+SplitAndCompileModule(std::unique_ptr<llvm::Module> module, int num_parts,
+                      const ModuleCompiler& compile_part);
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PARALLEL_CODEGEN_H_
@@ -28,6 +28,9 @@ limitations under the License.
 namespace xla {
 namespace cpu {
 
+// The maximum number of partitions per thread of compute bound instructions.
+constexpr int64 kPartitionsPerThread = 4;
+
 class SimpleCostModel : public ParallelCostModel {
  public:
   SimpleCostModel(const int64 max_parallelism,
@@ -82,8 +85,11 @@ class DefaultCostModel : public ParallelCostModel {
       instruction_cost = shape_size_(instruction->shape());
       min_cost_per_thread = 256LL << 10;  // 256KB L2 Cache size.
     } else {
-      // Use max parallelism for compute bound instructions.
-      max_parallelism = max_parallelism_;
+      // Split compute bound instructions into up to a few partitions per
+      // thread. ParallelForkJoin hands partitions to whichever thread is free,
+      // so smaller partitions even out partitions of unequal cost and threads
+      // that are busy with other work.
+      max_parallelism = kPartitionsPerThread * max_parallelism_;
       // Calculate the instruction cost in cycles.
       // TODO(b/29630486) Improve on this linear cost model.
       // Consider making 'min_cost_per_thread' be a function of the target
@@ -95,7 +101,7 @@ class DefaultCostModel : public ParallelCostModel {
       // Minimum per-thread cost is 100us of work on a 2GHz core.
       min_cost_per_thread = 100000;
     }
-    // Return target parallel task count in [1, max_parallelism_].
+    // Return target parallel task count in [1, max_parallelism].
     return std::min(max_parallelism,
                     std::max(int64{1}, instruction_cost / min_cost_per_thread));
   }
@@ -34,7 +34,10 @@ class ParallelCostModel {
 // ParallelTaskAssignment computes parallel task counts for HLOs in 'module'.
 class ParallelTaskAssignment {
  public:
-  // 'max_parallelism': the maximum parallel task count per instruction.
+  // 'max_parallelism': the number of threads running the parallel tasks,
+  //                    which is the maximum parallel task count per
+  //                    instruction, except for compute bound instructions
+  //                    which may be split into a few tasks per thread.
   // 'shape_size': shape size function used by HloCostAnalysis during parallel
   //               task assignment.
   // 'module': the containing HloModule.
@@ -59,10 +62,12 @@ class ParallelTaskAssignment {
 // Each HLO which is assigned parallel task counts is outlined into its
 // own embedded computation, which is compiled as a parallel compute function,
 // and which is invoked from a kCall instruction that is lowered in codegen to
-// a runtime parallel fork/join call.
+// a runtime parallel fork/join call. The runtime hands the partitions of the
+// instruction to the threads of the intra-op thread pool as they become free.
 class ParallelTaskAssigner : public HloModulePass {
  public:
-  // 'max_parallelism': the maximum parallel task count per instruction.
+  // 'max_parallelism': the number of threads running the parallel tasks (see
+  //                    ParallelTaskAssignment).
   // 'shape_size': shape size function used by HloCostAnalysis during parallel
   //               task assignment.
   ParallelTaskAssigner(const int64 max_parallelism,
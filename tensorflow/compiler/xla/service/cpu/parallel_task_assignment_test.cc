@@ -205,5 +205,39 @@ TEST_F(ParallelTaskAssignmentTest, ConstantNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(ParallelTaskAssignmentTest, ComputeBoundOperationSplitPerThread) {
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_reduce_window
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+
+    ENTRY ReduceWindow {
+      input = f32[4096,4096] parameter(0)
+      zero = f32[] constant(0)
+      ROOT reduce-window = f32[4033,4033] reduce-window(input, zero),
+        window={size=64x64}, to_apply=add
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+
+  // The reduce-window is outlined into a call, and split into more partitions
+  // than there are threads, so that the threads balance them.
+  const HloInstruction* call = m->entry_computation()->root_instruction();
+  ASSERT_EQ(call->opcode(), HloOpcode::kCall);
+  const HloInstruction* reduce_window = call->to_apply()->root_instruction();
+  int64 partition_count = 1;
+  for (int64 partitions : reduce_window->outer_dimension_partitions()) {
+    partition_count *= partitions;
+  }
+  EXPECT_GT(partition_count, max_parallelism_);
+}
+
 }  // namespace
 }  // namespace xla
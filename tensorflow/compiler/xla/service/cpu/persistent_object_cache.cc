@@ -0,0 +1,156 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/persistent_object_cache.h"
+
+#include <memory>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/compiler/xla/xla.pb.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/public/version.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// Bump when a change to the CPU backend changes the object code it generates
+// for a given module, or the format of the entries.
+constexpr char kCacheVersion[] = "xla-cpu-object-cache-1";
+
+// An entry file is the magic line, the entry function name on its own line,
+// then the object code.
+constexpr char kMagic[] = "XLA_CPU_OBJECT";
+
+// Returns whether `object_code` is an object file defining `symbol`.
+bool DefinesSymbol(const string& object_code, const string& symbol) {
+  std::unique_ptr<llvm::MemoryBuffer> buffer =
+      llvm::MemoryBuffer::getMemBuffer(object_code, /*BufferName=*/"",
+                                       /*RequiresNullTerminator=*/false);
+  auto object = llvm::object::ObjectFile::createObjectFile(*buffer);
+  if (!object) {
+    llvm::consumeError(object.takeError());
+    return false;
+  }
+  for (const llvm::object::SymbolRef& object_symbol : (*object)->symbols()) {
+    llvm::Expected<llvm::StringRef> name = object_symbol.getName();
+    if (!name) {
+      llvm::consumeError(name.takeError());
+      continue;
+    }
+    if (*name == symbol) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+/*static*/ string PersistentObjectCache::Key(
+    const HloModule& module, const llvm::TargetMachine& target_machine) {
+  DebugOptions debug_options = module.config().debug_options();
+  debug_options.clear_xla_cpu_persistent_cache_dir();
+  string serialized_debug_options;
+  tensorflow::SerializeToStringDeterministic(debug_options,
+                                             &serialized_debug_options);
+
+  // Unlike the fingerprint print options, these keep the instruction ids and
+  // the backend configs, which can influence scheduling and code generation.
+  const HloPrintOptions print_options = HloPrintOptions()
+                                            .set_print_large_constants(true)
+                                            .set_print_metadata(false);
+  const string fingerprinted = absl::StrCat(
+      kCacheVersion, "\n", TF_VERSION_STRING, "\n", LLVM_VERSION_STRING, "\n",
+      target_machine.getTargetTriple().getTriple(), "\n",
+      target_machine.getTargetCPU().str(), "\n",
+      target_machine.getTargetFeatureString().str(), "\n",
+      module.config().intra_op_parallelism_threads(), "\n",
+      serialized_debug_options, "\n", module.ToString(print_options));
+  const tensorflow::Fprint128 fingerprint =
+      tensorflow::Fingerprint128(fingerprinted);
+  return absl::StrFormat("%016x%016x", fingerprint.high64, fingerprint.low64);
+}
+
+string PersistentObjectCache::PathForKey(const string& key) const {
+  return tensorflow::io::JoinPath(directory_, absl::StrCat(key, ".o"));
+}
+
+absl::optional<PersistentObjectCache::Entry> PersistentObjectCache::Lookup(
+    const string& key) const {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const string path = PathForKey(key);
+  if (!env->FileExists(path).ok()) {
+    return absl::nullopt;
+  }
+  string contents;
+  Status status = tensorflow::ReadFileToString(env, path, &contents);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to read " << path << ": " << status;
+    return absl::nullopt;
+  }
+
+  const size_t magic_end = contents.find('\n');
+  const size_t name_end = magic_end == string::npos
+                              ? string::npos
+                              : contents.find('\n', magic_end + 1);
+  if (name_end == string::npos ||
+      contents.compare(0, magic_end, kMagic) != 0) {
+    LOG(WARNING) << "Ignoring malformed XLA:CPU object cache entry " << path;
+    return absl::nullopt;
+  }
+  Entry entry;
+  entry.entry_function_name =
+      contents.substr(magic_end + 1, name_end - magic_end - 1);
+  entry.object_code = contents.substr(name_end + 1);
+  if (!DefinesSymbol(entry.object_code, entry.entry_function_name)) {
+    LOG(WARNING) << "Ignoring malformed XLA:CPU object cache entry " << path;
+    return absl::nullopt;
+  }
+  return entry;
+}
+
+Status PersistentObjectCache::Store(const string& key,
+                                    const Entry& entry) const {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(directory_));
+  const string path = PathForKey(key);
+  const string temp_path =
+      absl::StrCat(path, ".tmp.", tensorflow::random::New64());
+  TF_RETURN_IF_ERROR(tensorflow::WriteStringToFile(
+      env, temp_path,
+      absl::StrCat(kMagic, "\n", entry.entry_function_name, "\n",
+                   entry.object_code)));
+  Status status = env->RenameFile(temp_path, path);
+  if (!status.ok()) {
+    env->DeleteFile(temp_path).IgnoreError();
+  }
+  return status;
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,76 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PERSISTENT_OBJECT_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PERSISTENT_OBJECT_CACHE_H_
+
+#include <utility>
+
+#include "absl/types/optional.h"
+#include "llvm/Target/TargetMachine.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/types.h"
+
+namespace xla {
+namespace cpu {
+
+// Stores the object code generated by CpuCompiler::RunBackend in a directory
+// (see DebugOptions::xla_cpu_persistent_cache_dir), so that compiling an
+// identical module again, typically after a process restart, skips IR
+// emission and LLVM code generation.
+//
+// Entries are keyed by a fingerprint of everything the object code depends
+// on: the scheduled HLO module, the debug options, the target machine (triple,
+// CPU and features) and the versions of TensorFlow and LLVM. A change to any
+// of them selects another entry, so stale entries are never loaded but are
+// also never deleted.
+//
+// Several processes may share a directory: entries are written to a temporary
+// file that is then renamed, so readers see either a complete entry or none.
+class PersistentObjectCache {
+ public:
+  struct Entry {
+    // Mangled name of the entry computation's function in `object_code`.
+    string entry_function_name;
+    string object_code;
+  };
+
+  explicit PersistentObjectCache(string directory)
+      : directory_(std::move(directory)) {}
+
+  // Returns the key of the object code generated for `module`, which must be
+  // optimized and scheduled, by a JIT using `target_machine`.
+  static string Key(const HloModule& module,
+                    const llvm::TargetMachine& target_machine);
+
+  // Returns the entry stored under `key`, or nullopt if there is none. Entries
+  // that can't be read, or whose object code doesn't define the entry
+  // function, are treated as missing.
+  absl::optional<Entry> Lookup(const string& key) const;
+
+  // Stores `entry` under `key`, replacing any existing entry.
+  Status Store(const string& key, const Entry& entry) const;
+
+ private:
+  string PathForKey(const string& key) const;
+
+  const string directory_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PERSISTENT_OBJECT_CACHE_H_
@@ -49,6 +49,23 @@ extern void __xla_cpu_runtime_EigenConvF16(
     tensorflow::int64 lhs_row_dilation, tensorflow::int64 lhs_col_dilation,
     tensorflow::int64 rhs_row_dilation, tensorflow::int64 rhs_col_dilation);
 
+// Like __xla_cpu_runtime_EigenConvF32, but also calls `epilogue`, a
+// tensorflow::xla::EpilogueFunction (see runtime_epilogue.h), with
+// `epilogue_context` on the blocks of 'out' as they are computed.
+extern void __xla_cpu_runtime_EigenConvF32WithEpilogue(
+    const void* /* xla::ExecutableRunOptions* */ run_options_ptr, float* out,
+    float* lhs, float* rhs, tensorflow::int64 input_batch,
+    tensorflow::int64 input_rows, tensorflow::int64 input_cols,
+    tensorflow::int64 input_channels, tensorflow::int64 kernel_rows,
+    tensorflow::int64 kernel_cols, tensorflow::int64 kernel_channels,
+    tensorflow::int64 kernel_filters, tensorflow::int64 output_rows,
+    tensorflow::int64 output_cols, tensorflow::int64 row_stride,
+    tensorflow::int64 col_stride, tensorflow::int64 padding_top,
+    tensorflow::int64 padding_bottom, tensorflow::int64 padding_left,
+    tensorflow::int64 padding_right, tensorflow::int64 lhs_row_dilation,
+    tensorflow::int64 lhs_col_dilation, tensorflow::int64 rhs_row_dilation,
+    tensorflow::int64 rhs_col_dilation, void* epilogue, void* epilogue_context);
+
 }  // extern "C"
 
 #endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_CONV2D_H_
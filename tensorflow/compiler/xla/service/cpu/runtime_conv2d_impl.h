@@ -28,7 +28,10 @@ limitations under the License.
 namespace tensorflow {
 namespace xla {
 
-template <typename EigenDevice, typename ScalarType>
+// Computes the convolution on `device`, applying `output_kernel` to the blocks
+// of the output as they are computed (see Eigen::TensorContractionOp).
+template <typename EigenDevice, typename ScalarType,
+          typename OutputKernel = Eigen::NoOpOutputKernel>
 void EigenConvImpl(const EigenDevice& device, ScalarType* out, ScalarType* lhs,
                    ScalarType* rhs, Eigen::Index input_batch,
                    Eigen::Index input_rows, Eigen::Index input_cols,
@@ -40,7 +43,8 @@ void EigenConvImpl(const EigenDevice& device, ScalarType* out, ScalarType* lhs,
                    Eigen::Index padding_bottom, Eigen::Index padding_left,
                    Eigen::Index padding_right, Eigen::Index lhs_row_dilation,
                    Eigen::Index lhs_col_dilation, Eigen::Index rhs_row_dilation,
-                   Eigen::Index rhs_col_dilation) {
+                   Eigen::Index rhs_col_dilation,
+                   const OutputKernel& output_kernel = OutputKernel()) {
   const Eigen::TensorMap<Eigen::Tensor<const ScalarType, 4, Eigen::RowMajor>,
                          Eigen::Aligned>
       input(lhs, input_batch, input_rows, input_cols, input_channels);
@@ -84,7 +88,8 @@ void EigenConvImpl(const EigenDevice& device, ScalarType* out, ScalarType* lhs,
                                  padding_left, padding_right, padding_top,
                                  padding_bottom, static_cast<ScalarType>(0.0f))
           .reshape(pre_contract_dims)
-          .contract(kernel.reshape(kernel_dims), contract_dims)
+          .contract(kernel.reshape(kernel_dims), contract_dims,
+                    output_kernel)
           .reshape(post_contract_dims);
 }
 
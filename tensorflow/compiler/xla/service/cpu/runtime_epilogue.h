@@ -0,0 +1,70 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_EPILOGUE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_EPILOGUE_H_
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/platform/types.h"
+
+// 'tensorflow' namespace is used so that int64 and other types don't require
+// qualification.
+namespace tensorflow {
+namespace xla {
+
+// An epilogue applies the elementwise operations fused into the output of a
+// dot or a convolution to `size` contiguous elements of its result. `data`
+// points to the elements, which the epilogue overwrites, and `offset` is the
+// linear index of the first one in the output buffer. `context` is passed
+// through as is from the caller of the runtime function.
+//
+// Epilogues are emitted by the XLA:CPU IR emitter and may be called
+// concurrently on disjoint parts of the result.
+using EpilogueFunction = void (*)(void* context, float* data, int64 offset,
+                                  int64 size);
+
+// An Eigen contraction output kernel which calls an epilogue on each column of
+// the output blocks once they hold their final values, while they are still
+// in cache. `rows` is the number of rows of the (column-major) contraction
+// output, which turns block coordinates into linear indices.  Since the rows
+// are the minor-most dimension of the XLA output, the elements passed to one
+// call of the epilogue never span more than one row of that dimension.
+struct EpilogueOutputKernel {
+  EpilogueOutputKernel(void* epilogue, void* context, Eigen::Index rows)
+      : epilogue(reinterpret_cast<EpilogueFunction>(epilogue)),
+        context(context),
+        rows(rows) {}
+
+  template <typename StorageIndex>
+  EIGEN_ALWAYS_INLINE void operator()(
+      const Eigen::internal::blas_data_mapper<float, StorageIndex,
+                                              Eigen::ColMajor>& output_mapper,
+      const Eigen::TensorContractionParams& params, StorageIndex i,
+      StorageIndex j, StorageIndex num_rows, StorageIndex num_cols) const {
+    for (StorageIndex col = 0; col < num_cols; ++col) {
+      epilogue(context, &output_mapper(0, col), i + (j + col) * rows,
+               num_rows);
+    }
+  }
+
+  EpilogueFunction epilogue;
+  void* context;
+  Eigen::Index rows;
+};
+
+}  // namespace xla
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_EPILOGUE_H_
@@ -17,6 +17,9 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <atomic>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/compiler/xla/executable_run_options.h"
 #include "tensorflow/core/platform/blocking_counter.h"
@@ -31,9 +34,17 @@ using tensorflow::uint64;
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      int64*, uint64*);
 
-// Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
-// Calls 'function_ptr' for first partition inline.
-// Uses blocking counter to synchronize threads after parallel calls complete.
+// Calls 'function_ptr' once for each of the 'num_partitions' partitions, in
+// parallel, and returns when all the calls are done.
+//
+// Partitions aren't bound to threads: the calling thread and up to
+// 'num_partitions - 1' workers enqueued on the intra-op thread pool claim the
+// next unclaimed partition until there are none left. Threads which are free
+// thus take over the partitions of threads which are busy or haven't started
+// yet, and workers which start after all partitions are claimed return right
+// away, so there may be more partitions than threads.  If no intra-op thread
+// pool is set, as may be the case for ahead-of-time compiled code, the calling
+// thread runs all the partitions.
 //
 // The 'partitions' array has a total number of elements equal to
 // 'num_partitions * num_partitioned_dims * 2' (the '2' is necessary to specify
@@ -74,31 +85,44 @@ TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
   const xla::ExecutableRunOptions* run_options =
       static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
   CHECK_NE(run_options, nullptr);
-  CHECK_NE(run_options->intra_op_thread_pool(), nullptr);
+  const Eigen::ThreadPoolDevice* thread_pool =
+      run_options->intra_op_thread_pool();
 
   ComputeFunctionType function =
       reinterpret_cast<ComputeFunctionType>(function_ptr);
   // Compute partition stride in 'partitions' array.
   const int64 stride = 2 * num_partitioned_dims;
 
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
-  tensorflow::BlockingCounter bc(num_partitions - 1);
-  for (int32 i = 1; i < num_partitions; ++i) {
-    const int64 offset = i * stride;
-    run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
-         partitions, offset, &bc]() {
-          function(result_ptr, run_options_ptr, nullptr, buffer_table,
-                   &partitions[offset], prof_counters);
+  // Runs the unclaimed partitions, one at a time.
+  std::atomic<int32> next_partition(0);
+  auto run_partitions = [&]() {
+    for (int32 i = next_partition.fetch_add(1, std::memory_order_relaxed);
+         i < num_partitions;
+         i = next_partition.fetch_add(1, std::memory_order_relaxed)) {
+      function(result_ptr, run_options_ptr, nullptr, buffer_table,
+               &partitions[i * stride], prof_counters);
+      VLOG(3) << "ParallelForkJoin partition " << i << " done.";
+    }
+  };
+
+  // Enqueue a worker per thread of the pool, but no more than there are
+  // partitions besides the one the calling thread runs.
+  const int32 num_workers =
+      thread_pool == nullptr
+          ? 0
+          : std::min<int32>(num_partitions - 1, thread_pool->numThreads());
+  tensorflow::BlockingCounter bc(num_workers);
+  for (int32 i = 0; i < num_workers; ++i) {
+    thread_pool->enqueueNoNotification(
+        [&run_partitions, &bc]() {
+          run_partitions();
           bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
         });
   }
 
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, buffer_table, &partitions[0],
-           prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
+  // Run partitions on the calling thread as well, rather than blocking while
+  // the workers start.
+  run_partitions();
   bc.Wait();
   VLOG(2) << "ParallelForkJoin EXIT";
 }
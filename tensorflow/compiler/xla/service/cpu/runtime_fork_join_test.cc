@@ -0,0 +1,153 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/runtime_fork_join.h"
+
+#define EIGEN_USE_THREADS
+
+#include <atomic>
+#include <tuple>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/compiler/xla/executable_run_options.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// Runs __xla_cpu_runtime_ParallelForkJoin over one dimension of size
+// `num_partitions`, split into partitions of one element.
+class ForkJoinRunner {
+ public:
+  explicit ForkJoinRunner(int num_threads)
+      : pool_(tensorflow::Env::Default(), "XLAEigen", num_threads),
+        device_(pool_.AsEigenThreadPool(), pool_.NumThreads()) {
+    run_options_.set_intra_op_thread_pool(&device_);
+  }
+
+  // Calls `function` with a buffer table holding `buffer`.
+  void Run(int32 num_partitions, void* buffer, void* function) {
+    std::vector<int64> partitions;
+    for (int64 i = 0; i < num_partitions; ++i) {
+      partitions.push_back(i);
+      partitions.push_back(i + 1);
+    }
+    void* buffer_table[] = {buffer};
+    __xla_cpu_runtime_ParallelForkJoin(
+        /*result_ptr=*/nullptr, &run_options_, /*params=*/nullptr,
+        buffer_table, /*prof_counters=*/nullptr, num_partitions,
+        partitions.data(), /*num_partitioned_dims=*/1, function);
+  }
+
+ private:
+  tensorflow::thread::ThreadPool pool_;
+  Eigen::ThreadPoolDevice device_;
+  ExecutableRunOptions run_options_;
+};
+
+// Counts the calls for each partition in the array of atomics in the buffer
+// table.
+void CountPartition(void* result, const void* run_options, const void** params,
+                    void** buffer_table, int64* partition,
+                    uint64* prof_counters) {
+  static_cast<std::atomic<int>*>(buffer_table[0])[partition[0]]++;
+}
+
+class ForkJoinTest : public ::testing::TestWithParam<std::tuple<int, int>> {};
+
+TEST_P(ForkJoinTest, RunsEachPartitionOnce) {
+  int num_threads, num_partitions;
+  std::tie(num_threads, num_partitions) = GetParam();
+  ForkJoinRunner runner(num_threads);
+  std::vector<std::atomic<int>> calls(num_partitions);
+  for (std::atomic<int>& count : calls) count = 0;
+
+  runner.Run(num_partitions, calls.data(),
+             reinterpret_cast<void*>(&CountPartition));
+  for (int i = 0; i < num_partitions; ++i) {
+    EXPECT_EQ(calls[i], 1) << "partition " << i;
+  }
+}
+
+// Fewer, as many and more partitions than threads.
+INSTANTIATE_TEST_SUITE_P(ForkJoinTestInstantiation, ForkJoinTest,
+                         ::testing::Combine(::testing::Values(1, 4),
+                                            ::testing::Values(2, 4, 5, 64)));
+
+TEST(ForkJoinWithoutThreadPoolTest, RunsEachPartitionOnce) {
+  const int32 num_partitions = 5;
+  std::vector<int64> partitions;
+  for (int64 i = 0; i < num_partitions; ++i) {
+    partitions.push_back(i);
+    partitions.push_back(i + 1);
+  }
+  std::vector<std::atomic<int>> calls(num_partitions);
+  for (std::atomic<int>& count : calls) count = 0;
+  void* buffer_table[] = {calls.data()};
+
+  // Ahead-of-time compiled code may run without an intra-op thread pool.
+  ExecutableRunOptions run_options;
+  __xla_cpu_runtime_ParallelForkJoin(
+      /*result_ptr=*/nullptr, &run_options, /*params=*/nullptr, buffer_table,
+      /*prof_counters=*/nullptr, num_partitions, partitions.data(),
+      /*num_partitioned_dims=*/1, reinterpret_cast<void*>(&CountPartition));
+  for (int i = 0; i < num_partitions; ++i) {
+    EXPECT_EQ(calls[i], 1) << "partition " << i;
+  }
+}
+
+// Spins for a number of iterations depending on the partition, so that the
+// partitions take uneven times like those of a partitioned instruction.
+void SpinPartition(void* result, const void* run_options, const void** params,
+                   void** buffer_table, int64* partition,
+                   uint64* prof_counters) {
+  const int64 iterations = 20000 * (1 + partition[0] % 4);
+  float value = 0;
+  for (int64 i = 0; i < iterations; ++i) {
+    value = value * 0.5f + 1.0f;
+  }
+  tensorflow::testing::DoNotOptimize(value);
+}
+
+// Measures how the fork/join scales with the number of threads (first
+// argument) for a number of partitions (second argument).
+void BM_ParallelForkJoin(::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  const int num_partitions = state.range(1);
+  ForkJoinRunner runner(num_threads);
+  for (auto s : state) {
+    runner.Run(num_partitions, nullptr,
+               reinterpret_cast<void*>(&SpinPartition));
+  }
+}
+
+BENCHMARK(BM_ParallelForkJoin)
+    ->ArgPair(1, 64)
+    ->ArgPair(2, 64)
+    ->ArgPair(4, 64)
+    ->ArgPair(8, 64)
+    ->ArgPair(16, 64)
+    ->ArgPair(4, 4)
+    ->ArgPair(4, 16);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
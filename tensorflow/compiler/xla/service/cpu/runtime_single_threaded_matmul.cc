@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_matmul.h"
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/compiler/xla/service/cpu/runtime_epilogue.h"
 #include "tensorflow/core/platform/dynamic_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -29,10 +30,11 @@ bool Is16BytesAligned(void* ptr) {
   return reinterpret_cast<uintptr_t>(ptr) % 16 == 0;
 }
 
-template <typename T, Eigen::AlignmentType Alignment>
+template <typename T, Eigen::AlignmentType Alignment, typename OutputKernel>
 void MatMul(const void* run_options_ptr, T* out, T* lhs, T* rhs,
             tensorflow::int64 m, tensorflow::int64 n, tensorflow::int64 k,
-            tensorflow::int32 transpose_lhs, tensorflow::int32 transpose_rhs) {
+            tensorflow::int32 transpose_lhs, tensorflow::int32 transpose_rhs,
+            const OutputKernel& output_kernel) {
   tensorflow::int64 lhs_rows = m;
   tensorflow::int64 lhs_cols = k;
   if (transpose_lhs) {
@@ -60,25 +62,26 @@ void MatMul(const void* run_options_ptr, T* out, T* lhs, T* rhs,
   // Matrix multiply is a special case of the "contract" operation where
   // the contraction is performed along dimension 1 of the lhs and dimension
   // 0 of the rhs.
-  C = A.contract(B, dims);
+  C = A.contract(B, dims, output_kernel);
 }
 
-template <typename T>
-void SingleThreadedMatMulDispatch(const void* run_options_ptr, T* out, T* lhs,
-                                  T* rhs, tensorflow::int64 m,
-                                  tensorflow::int64 n, tensorflow::int64 k,
-                                  tensorflow::int32 transpose_lhs,
-                                  tensorflow::int32 transpose_rhs) {
+template <typename T, typename OutputKernel = Eigen::NoOpOutputKernel>
+void SingleThreadedMatMulDispatch(
+    const void* run_options_ptr, T* out, T* lhs, T* rhs, tensorflow::int64 m,
+    tensorflow::int64 n, tensorflow::int64 k, tensorflow::int32 transpose_lhs,
+    tensorflow::int32 transpose_rhs,
+    const OutputKernel& output_kernel = OutputKernel()) {
   bool all_buffers_16b_aligned =
       Is16BytesAligned(out) && Is16BytesAligned(lhs) && Is16BytesAligned(rhs);
 
   if (!all_buffers_16b_aligned) {
     MatMul<T, Eigen::Unaligned>(run_options_ptr, out, lhs, rhs, m, n, k,
-                                transpose_lhs, transpose_rhs);
+                                transpose_lhs, transpose_rhs, output_kernel);
+    return;
   }
 
   MatMul<T, Eigen::Aligned16>(run_options_ptr, out, lhs, rhs, m, n, k,
-                              transpose_lhs, transpose_rhs);
+                              transpose_lhs, transpose_rhs, output_kernel);
 }
 
 }  // namespace
@@ -102,6 +105,17 @@ __xla_cpu_runtime_EigenSingleThreadedMatMulF32(
                                       transpose_lhs, transpose_rhs);
 }
 
+TF_ATTRIBUTE_NO_SANITIZE_MEMORY void
+__xla_cpu_runtime_EigenSingleThreadedMatMulF32WithEpilogue(
+    const void* run_options_ptr, float* out, float* lhs, float* rhs,
+    tensorflow::int64 m, tensorflow::int64 n, tensorflow::int64 k,
+    tensorflow::int32 transpose_lhs, tensorflow::int32 transpose_rhs,
+    void* epilogue, void* epilogue_context) {
+  SingleThreadedMatMulDispatch<float>(
+      run_options_ptr, out, lhs, rhs, m, n, k, transpose_lhs, transpose_rhs,
+      tensorflow::xla::EpilogueOutputKernel(epilogue, epilogue_context, m));
+}
+
 TF_ATTRIBUTE_NO_SANITIZE_MEMORY void
 __xla_cpu_runtime_EigenSingleThreadedMatMulF64(
     const void* run_options_ptr, double* out, double* lhs, double* rhs,
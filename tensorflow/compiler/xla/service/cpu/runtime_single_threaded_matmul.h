@@ -40,6 +40,15 @@ extern void __xla_cpu_runtime_EigenSingleThreadedMatMulF32(
     tensorflow::int64 k, tensorflow::int32 transpose_lhs,
     tensorflow::int32 transpose_rhs);
 
+// Like __xla_cpu_runtime_EigenSingleThreadedMatMulF32, but also calls
+// `epilogue`, a tensorflow::xla::EpilogueFunction (see runtime_epilogue.h),
+// with `epilogue_context` on the blocks of 'out' as they are computed.
+extern void __xla_cpu_runtime_EigenSingleThreadedMatMulF32WithEpilogue(
+    const void* /* xla::ExecutableRunOptions* */ run_options_ptr, float* out,
+    float* lhs, float* rhs, tensorflow::int64 m, tensorflow::int64 n,
+    tensorflow::int64 k, tensorflow::int32 transpose_lhs,
+    tensorflow::int32 transpose_rhs, void* epilogue, void* epilogue_context);
+
 extern void __xla_cpu_runtime_EigenSingleThreadedMatMulF64(
     const void* /* xla::ExecutableRunOptions* */ run_options_ptr, double* out,
     double* lhs, double* rhs, tensorflow::int64 m, tensorflow::int64 n,
@@ -20,6 +20,14 @@ limitations under the License.
 
 namespace xla {
 namespace cpu {
+namespace {
+
+// Used when LLVM doesn't know the caches of the target.  These are the sizes
+// found on most x86 and ARM cores.
+constexpr int kDefaultCacheLineByteSize = 64;
+constexpr int64 kDefaultL1DataCacheByteSize = 32 * 1024;
+
+}  // namespace
 
 llvm::TargetTransformInfo* LLVMTargetMachineFeatures::GetTargetTransformInfoFor(
     const llvm::Function& function) const {
@@ -34,6 +42,23 @@ llvm::TargetTransformInfo* LLVMTargetMachineFeatures::GetTargetTransformInfoFor(
   return &it->second;
 }
 
+int LLVMTargetMachineFeatures::cache_line_byte_size(
+    const llvm::Function& function) const {
+  unsigned cache_line_size =
+      GetTargetTransformInfoFor(function)->getCacheLineSize();
+  return cache_line_size > 0 ? cache_line_size : kDefaultCacheLineByteSize;
+}
+
+int64 LLVMTargetMachineFeatures::l1_data_cache_byte_size(
+    const llvm::Function& function) const {
+  llvm::Optional<unsigned> cache_size =
+      GetTargetTransformInfoFor(function)->getCacheSize(
+          llvm::TargetTransformInfo::CacheLevel::L1D);
+  return cache_size.hasValue() && *cache_size > 0
+             ? *cache_size
+             : kDefaultL1DataCacheByteSize;
+}
+
 int64 LLVMTargetMachineFeatures::minimum_alignment_for_allocation(
     int64 size_bytes) const {
   // Assume that all pointers are aligned to at least
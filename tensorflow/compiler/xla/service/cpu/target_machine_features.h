@@ -58,6 +58,13 @@ class TargetMachineFeatures {
   // this functionality).
   virtual int vector_register_count(const llvm::Function& function) const = 0;
 
+  // Return the size of a cache line and of the L1 data cache in bytes, which
+  // the loops emitted for large reductions and transposes are tiled for.  We
+  // need to pass in "function" for the same reason as above.
+  virtual int cache_line_byte_size(const llvm::Function& function) const = 0;
+  virtual int64 l1_data_cache_byte_size(
+      const llvm::Function& function) const = 0;
+
   // Returns the minimum alignment for a buffer of size size_bytes.
   virtual int64 minimum_alignment_for_allocation(int64 size_bytes) const = 0;
 
@@ -96,6 +103,10 @@ class LLVMTargetMachineFeatures : public TargetMachineFeatures {
         tti->getRegisterClassForType(/*Vector=*/true)));
   }
 
+  int cache_line_byte_size(const llvm::Function& function) const override;
+
+  int64 l1_data_cache_byte_size(const llvm::Function& function) const override;
+
   int64 minimum_alignment_for_allocation(int64 size_bytes) const override;
 
  private:
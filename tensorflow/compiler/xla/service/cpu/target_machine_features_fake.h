@@ -48,6 +48,14 @@ class TargetMachineFeaturesWithFakeAlignmentLogic
     LOG(FATAL) << "Unexpected call to " << __func__;
   }
 
+  int cache_line_byte_size(const llvm::Function& function) const override {
+    LOG(FATAL) << "Unexpected call to " << __func__;
+  }
+
+  int64 l1_data_cache_byte_size(const llvm::Function& function) const override {
+    LOG(FATAL) << "Unexpected call to " << __func__;
+  }
+
   int64 minimum_alignment_for_allocation(int64 size_bytes) const override {
     return fake_alignment_logic_(size_bytes);
   }
@@ -0,0 +1,243 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
+#include "tensorflow/compiler/xla/array2d.h"
+#include "tensorflow/compiler/xla/array4d.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/service/hlo_runner.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// A dense layer, relu(a x b + bias). "$m", "$k" and "$n" are replaced with the
+// sizes of the matrices.
+const char* const kDenseLayerHloText = R"(
+HloModule DenseLayer
+
+ENTRY main {
+  a = f32[$m,$k]{1,0} parameter(0)
+  b = f32[$k,$n]{1,0} parameter(1)
+  bias = f32[$n]{0} parameter(2)
+  dot = f32[$m,$n]{1,0} dot(a, b), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  bias_broadcast = f32[$m,$n]{1,0} broadcast(bias), dimensions={1}
+  add = f32[$m,$n]{1,0} add(dot, bias_broadcast)
+  zero = f32[] constant(0)
+  zeros = f32[$m,$n]{1,0} broadcast(zero), dimensions={}
+  ROOT relu = f32[$m,$n]{1,0} maximum(add, zeros)
+}
+)";
+
+// A 3x3 convolution with 4 input and 8 output features over an 8x8 image,
+// followed by a bias and a relu.
+const char* const kConvolutionLayerHloText = R"(
+HloModule ConvolutionLayer
+
+ENTRY main {
+  input = f32[2,8,8,4]{3,2,1,0} parameter(0)
+  kernel = f32[3,3,4,8]{3,2,1,0} parameter(1)
+  bias = f32[8]{0} parameter(2)
+  conv = f32[2,8,8,8]{3,2,1,0} convolution(input, kernel), window={size=3x3 pad=1_1x1_1}, dim_labels=b01f_01io->b01f
+  bias_broadcast = f32[2,8,8,8]{3,2,1,0} broadcast(bias), dimensions={3}
+  add = f32[2,8,8,8]{3,2,1,0} add(conv, bias_broadcast)
+  zero = f32[] constant(0)
+  zeros = f32[2,8,8,8]{3,2,1,0} broadcast(zero), dimensions={}
+  ROOT relu = f32[2,8,8,8]{3,2,1,0} maximum(add, zeros)
+}
+)";
+
+string DenseLayerHloText(int64 m, int64 k, int64 n) {
+  return absl::StrReplaceAll(kDenseLayerHloText, {{"$m", absl::StrCat(m)},
+                                                  {"$k", absl::StrCat(k)},
+                                                  {"$n", absl::StrCat(n)}});
+}
+
+// The values are centered on zero, so that the relu clamps about half of the
+// results.
+float MakeValue(int64 i) { return ((i * 37) % 17 - 8) / 8.0f; }
+
+struct DenseLayerArguments {
+  DenseLayerArguments(int64 m, int64 k, int64 n)
+      : a(m, k), b(k, n), bias(n) {
+    a.Each([](int64 i, int64 j, float* value) { *value = MakeValue(i + j); });
+    b.Each(
+        [](int64 i, int64 j, float* value) { *value = MakeValue(i * 3 + j); });
+    for (int64 i = 0; i < n; ++i) {
+      bias[i] = MakeValue(i * 5);
+    }
+  }
+
+  std::vector<Literal> MakeLiterals() const {
+    std::vector<Literal> literals;
+    literals.push_back(LiteralUtil::CreateR2FromArray2D(a));
+    literals.push_back(LiteralUtil::CreateR2FromArray2D(b));
+    literals.push_back(LiteralUtil::CreateR1<float>(bias));
+    return literals;
+  }
+
+  Literal Expected() const {
+    Array2D<float> expected(a.height(), b.width());
+    expected.Each([&](int64 i, int64 j, float* value) {
+      float sum = bias[j];
+      for (int64 l = 0; l < a.width(); ++l) {
+        sum += a(i, l) * b(l, j);
+      }
+      *value = std::max(sum, 0.0f);
+    });
+    return LiteralUtil::CreateR2FromArray2D(expected);
+  }
+
+  Array2D<float> a;
+  Array2D<float> b;
+  std::vector<float> bias;
+};
+
+class CpuEpilogueFusionTest : public CpuCodegenTest {
+ protected:
+  void RunDenseLayer(int64 m, int64 k, int64 n) {
+    std::unique_ptr<HloModule> module =
+        ParseAndReturnVerifiedModule(DenseLayerHloText(m, k, n)).ValueOrDie();
+    DenseLayerArguments arguments(m, k, n);
+    std::vector<Literal> literals = arguments.MakeLiterals();
+    Literal result = ExecuteAndTransfer(
+        std::move(module), {&literals[0], &literals[1], &literals[2]});
+    EXPECT_TRUE(LiteralTestUtil::Near(arguments.Expected(), result,
+                                      ErrorSpec(1e-4, 1e-4)));
+  }
+};
+
+TEST_F(CpuEpilogueFusionTest, MatMulEpilogueIsAppliedByRuntime) {
+  CompileAndVerifyIr(DenseLayerHloText(64, 256, 128),
+                     R"(CHECK: MatMulF32WithEpilogue)");
+}
+
+TEST_F(CpuEpilogueFusionTest, MatMulWithEpilogue) {
+  // Not a multiple of the Eigen block sizes, so that the blocks are partial.
+  RunDenseLayer(/*m=*/67, /*k=*/253, /*n=*/131);
+}
+
+TEST_F(CpuEpilogueFusionTest, MatrixVectorWithInPlaceEpilogue) {
+  // Matrix-vector products are emitted in LLVM IR rather than calling Eigen.
+  CompileAndVerifyIr(DenseLayerHloText(1, 64, 32),
+                     R"(CHECK-NOT: MatMulF32WithEpilogue)");
+  RunDenseLayer(/*m=*/1, /*k=*/64, /*n=*/32);
+}
+
+TEST_F(CpuEpilogueFusionTest, ConvolutionEpilogueIsAppliedByRuntime) {
+  CompileAndVerifyIr(kConvolutionLayerHloText,
+                     R"(CHECK: ConvF32WithEpilogue)");
+}
+
+TEST_F(CpuEpilogueFusionTest, ConvolutionWithEpilogue) {
+  Array4D<float> input(2, 8, 8, 4);
+  input.Each([](absl::Span<const int64> index, float* value) {
+    *value = MakeValue(index[0] + index[1] * 2 + index[2] * 3 + index[3]);
+  });
+  Array4D<float> kernel(3, 3, 4, 8);
+  kernel.Each([](absl::Span<const int64> index, float* value) {
+    *value = MakeValue(index[0] * 5 + index[1] + index[2] * 7 + index[3]);
+  });
+  std::vector<float> bias(8);
+  for (int64 i = 0; i < 8; ++i) {
+    bias[i] = MakeValue(i);
+  }
+
+  Array4D<float> expected(2, 8, 8, 8);
+  expected.Each([&](absl::Span<const int64> index, float* value) {
+    float sum = bias[index[3]];
+    for (int64 r = 0; r < 3; ++r) {
+      for (int64 c = 0; c < 3; ++c) {
+        int64 row = index[1] + r - 1;
+        int64 col = index[2] + c - 1;
+        if (row < 0 || row >= 8 || col < 0 || col >= 8) {
+          continue;
+        }
+        for (int64 f = 0; f < 4; ++f) {
+          sum += input(index[0], row, col, f) * kernel(r, c, f, index[3]);
+        }
+      }
+    }
+    *value = std::max(sum, 0.0f);
+  });
+
+  std::unique_ptr<HloModule> module =
+      ParseAndReturnVerifiedModule(kConvolutionLayerHloText).ValueOrDie();
+  Literal input_literal = LiteralUtil::CreateR4FromArray4D(input);
+  Literal kernel_literal = LiteralUtil::CreateR4FromArray4D(kernel);
+  Literal bias_literal = LiteralUtil::CreateR1<float>(bias);
+  Literal result = ExecuteAndTransfer(
+      std::move(module), {&input_literal, &kernel_literal, &bias_literal});
+  EXPECT_TRUE(LiteralTestUtil::Near(LiteralUtil::CreateR4FromArray4D(expected),
+                                    result, ErrorSpec(1e-4, 1e-4)));
+}
+
+// Runs a square dense layer of the size given by the first argument, with the
+// epilogue fused if the second argument is 1 and as a separate loop otherwise.
+void BM_DenseLayer(::testing::benchmark::State& state) {
+  const int64 n = state.range(0);
+  const bool fused = state.range(1);
+  HloRunner runner(PlatformUtil::GetPlatform("cpu").ValueOrDie());
+  HloModuleConfig config;
+  DebugOptions debug_options = GetDebugOptionsFromFlags();
+  if (!fused) {
+    debug_options.add_xla_disable_hlo_passes("fusion");
+  }
+  config.set_debug_options(debug_options);
+  std::unique_ptr<HloModule> module =
+      ParseAndReturnUnverifiedModule(DenseLayerHloText(n, n, n), config)
+          .ValueOrDie();
+  std::unique_ptr<Executable> executable =
+      runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true)
+          .ValueOrDie();
+  std::vector<Literal> literals =
+      DenseLayerArguments(n, n, n).MakeLiterals();
+  std::vector<ScopedShapedBuffer> arguments =
+      runner
+          .TransferLiteralsToDevice({&literals[0], &literals[1], &literals[2]})
+          .ValueOrDie();
+
+  for (auto s : state) {
+    TF_CHECK_OK(
+        runner.ExecuteWithDeviceBuffers(executable.get(), arguments).status());
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * n * n * n);
+}
+
+BENCHMARK(BM_DenseLayer)
+    ->ArgPair(64, 0)
+    ->ArgPair(64, 1)
+    ->ArgPair(256, 0)
+    ->ArgPair(256, 1)
+    ->ArgPair(1024, 0)
+    ->ArgPair(1024, 1);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
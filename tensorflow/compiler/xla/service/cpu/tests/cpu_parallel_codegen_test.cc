@@ -0,0 +1,154 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/service/hlo_runner.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// Returns a module chaining `num_loops` while loops, which each compute a
+// different function of an f32[64] array four times. The bodies and
+// conditions of the loops are the points at which the LLVM module is split.
+string ManyLoopsHloText(int num_loops) {
+  string hlo_text = "HloModule ManyLoops\n";
+  for (int i = 0; i < num_loops; ++i) {
+    absl::StrAppend(&hlo_text, R"(
+cond.)", i, R"( {
+  p = (s32[], f32[64]) parameter(0)
+  i = s32[] get-tuple-element(p), index=0
+  n = s32[] constant(4)
+  ROOT lt = pred[] compare(i, n), direction=LT
+}
+
+body.)", i, R"( {
+  p = (s32[], f32[64]) parameter(0)
+  i = s32[] get-tuple-element(p), index=0
+  x = f32[64] get-tuple-element(p), index=1
+  one = s32[] constant(1)
+  next = s32[] add(i, one)
+  scale = f32[] constant()", i % 7 + 1, R"()
+  scales = f32[64] broadcast(scale), dimensions={}
+  y = f32[64] multiply(x, scales)
+  z = f32[64] tanh(y)
+  ROOT t = (s32[], f32[64]) tuple(next, z)
+}
+)");
+  }
+  absl::StrAppend(&hlo_text, R"(
+ENTRY main {
+  x.0 = f32[64] parameter(0)
+  zero = s32[] constant(0)
+)");
+  for (int i = 0; i < num_loops; ++i) {
+    absl::StrAppend(&hlo_text, "  init.", i,
+                    " = (s32[], f32[64]) tuple(zero, x.", i, ")\n");
+    absl::StrAppend(&hlo_text, "  while.", i,
+                    " = (s32[], f32[64]) while(init.", i,
+                    "), condition=cond.", i, ", body=body.", i, "\n");
+    absl::StrAppend(&hlo_text, "  x.", i + 1,
+                    " = f32[64] get-tuple-element(while.", i, "), index=1\n");
+  }
+  absl::StrAppend(&hlo_text, "  ROOT result = f32[64] copy(x.", num_loops,
+                  ")\n}\n");
+  return hlo_text;
+}
+
+// Returns a config compiling modules with the LLVM module split into
+// `split_count` parts.
+HloModuleConfig ConfigWithSplitCount(const DebugOptions& debug_options,
+                                     int split_count) {
+  HloModuleConfig config;
+  DebugOptions options = debug_options;
+  options.set_xla_cpu_parallel_codegen_split_count(split_count);
+  config.set_debug_options(options);
+  return config;
+}
+
+class CpuParallelCodegenTest : public CpuCodegenTest {
+ protected:
+  Literal Run(int num_loops, int split_count) {
+    HloModuleConfig config =
+        ConfigWithSplitCount(GetDebugOptionsForTest(), split_count);
+    std::unique_ptr<HloModule> module =
+        ParseAndReturnVerifiedModule(ManyLoopsHloText(num_loops), config)
+            .ValueOrDie();
+    std::vector<float> input(64);
+    for (int i = 0; i < 64; ++i) {
+      input[i] = (i % 9 - 4) / 8.0f;
+    }
+    Literal argument = LiteralUtil::CreateR1<float>(input);
+    return ExecuteAndTransfer(std::move(module), {&argument});
+  }
+};
+
+TEST_F(CpuParallelCodegenTest, SplitModuleComputesTheSameValues) {
+  Literal expected = Run(/*num_loops=*/8, /*split_count=*/1);
+  Literal actual = Run(/*num_loops=*/8, /*split_count=*/4);
+  EXPECT_TRUE(LiteralTestUtil::Near(expected, actual, ErrorSpec(1e-5, 1e-5)));
+}
+
+TEST_F(CpuParallelCodegenTest, MorePartsThanFunctions) {
+  Literal expected = Run(/*num_loops=*/1, /*split_count=*/1);
+  Literal actual = Run(/*num_loops=*/1, /*split_count=*/16);
+  EXPECT_TRUE(LiteralTestUtil::Near(expected, actual, ErrorSpec(1e-5, 1e-5)));
+}
+
+// Measures the time to compile a module of a number of while loops (first
+// argument), with the LLVM module split into a number of parts (second
+// argument). This includes the HLO passes, whose timing is logged with
+// --xla_cpu_log_compilation_stats.
+void BM_CompileManyLoops(::testing::benchmark::State& state) {
+  const int num_loops = state.range(0);
+  const int split_count = state.range(1);
+  HloRunner runner(PlatformUtil::GetPlatform("cpu").ValueOrDie());
+  const string hlo_text = ManyLoopsHloText(num_loops);
+  const HloModuleConfig config =
+      ConfigWithSplitCount(GetDebugOptionsFromFlags(), split_count);
+
+  for (auto s : state) {
+    std::unique_ptr<HloModule> module =
+        ParseAndReturnUnverifiedModule(hlo_text, config).ValueOrDie();
+    TF_CHECK_OK(
+        runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true)
+            .status());
+  }
+}
+
+BENCHMARK(BM_CompileManyLoops)
+    ->ArgPair(64, 1)
+    ->ArgPair(64, 4)
+    ->ArgPair(256, 1)
+    ->ArgPair(256, 4)
+    ->ArgPair(256, 16);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,209 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_executable.h"
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/service/hlo_runner.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+const char* const kHloText = R"(
+HloModule PersistentCache
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  a = f32[4,8] parameter(0)
+  b = f32[8,4] parameter(1)
+  dot = f32[4,4] dot(a, b), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  c = f32[4,4] constant({{1, 2, 3, 4}, {5, 6, 7, 8}, {1, 2, 3, 4}, {5, 6, 7, 8}})
+  sum = f32[4,4] add(dot, c)
+  zero = f32[] constant(0)
+  ROOT reduce = f32[4] reduce(sum, zero), dimensions={1}, to_apply=add
+}
+)";
+
+class CpuPersistentCacheTest : public CpuCodegenTest {
+ protected:
+  void SetUp() override {
+    CpuCodegenTest::SetUp();
+    cache_dir_ = tensorflow::io::JoinPath(
+        tensorflow::testing::TmpDir(),
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+  }
+
+  void TearDown() override {
+    int64 undeleted_files, undeleted_dirs;
+    tensorflow::Env::Default()
+        ->DeleteRecursively(cache_dir_, &undeleted_files, &undeleted_dirs)
+        .IgnoreError();
+    CpuCodegenTest::TearDown();
+  }
+
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = CpuCodegenTest::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_persistent_cache_dir(cache_dir_);
+    return debug_options;
+  }
+
+  // Compiles kHloText, checks whether it was loaded from the cache, and
+  // returns the result of running it.
+  Literal CompileAndRun(bool expect_cache_hit,
+                        bool enable_fast_math = false) {
+    HloModuleConfig config = GetModuleConfigForTest();
+    DebugOptions debug_options = config.debug_options();
+    debug_options.set_xla_cpu_enable_fast_math(enable_fast_math);
+    config.set_debug_options(debug_options);
+    std::unique_ptr<HloModule> module =
+        ParseAndReturnVerifiedModule(kHloText, config).ValueOrDie();
+    std::unique_ptr<Executable> executable =
+        test_runner_.CreateExecutable(std::move(module), true).ValueOrDie();
+    EXPECT_EQ(static_cast<CpuExecutable*>(executable.get())
+                  ->loaded_from_persistent_cache(),
+              expect_cache_hit);
+
+    std::vector<Literal> arguments;
+    arguments.push_back(LiteralUtil::CreateR2<float>(
+        {{1, 2, 3, 4, 5, 6, 7, 8},
+         {8, 7, 6, 5, 4, 3, 2, 1},
+         {1, 1, 1, 1, 1, 1, 1, 1},
+         {0, 1, 0, 1, 0, 1, 0, 1}}));
+    arguments.push_back(LiteralUtil::CreateR2<float>({{1, 0, 0, 1},
+                                                      {0, 1, 0, 1},
+                                                      {0, 0, 1, 1},
+                                                      {1, 1, 1, 1},
+                                                      {1, 0, 0, 1},
+                                                      {0, 1, 0, 1},
+                                                      {0, 0, 1, 1},
+                                                      {1, 1, 1, 1}}));
+    return test_runner_.Execute(std::move(executable), arguments)
+        .ValueOrDie();
+  }
+
+  std::vector<string> CacheFiles() {
+    std::vector<string> files;
+    TF_CHECK_OK(tensorflow::Env::Default()->GetMatchingPaths(
+        tensorflow::io::JoinPath(cache_dir_, "*"), &files));
+    return files;
+  }
+
+  string cache_dir_;
+};
+
+TEST_F(CpuPersistentCacheTest, SecondCompilationLoadsObjectCode) {
+  Literal expected = CompileAndRun(/*expect_cache_hit=*/false);
+  ASSERT_EQ(CacheFiles().size(), 1);
+
+  Literal actual = CompileAndRun(/*expect_cache_hit=*/true);
+  EXPECT_TRUE(LiteralTestUtil::Equal(expected, actual));
+  EXPECT_EQ(CacheFiles().size(), 1);
+}
+
+TEST_F(CpuPersistentCacheTest, DifferentDebugOptionsMiss) {
+  CompileAndRun(/*expect_cache_hit=*/false);
+  CompileAndRun(/*expect_cache_hit=*/false, /*enable_fast_math=*/true);
+  EXPECT_EQ(CacheFiles().size(), 2);
+  CompileAndRun(/*expect_cache_hit=*/true, /*enable_fast_math=*/true);
+}
+
+TEST_F(CpuPersistentCacheTest, CorruptedEntryIsRecompiled) {
+  Literal expected = CompileAndRun(/*expect_cache_hit=*/false);
+  std::vector<string> files = CacheFiles();
+  ASSERT_EQ(files.size(), 1);
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(),
+                                             files[0], "not an object file"));
+
+  Literal actual = CompileAndRun(/*expect_cache_hit=*/false);
+  EXPECT_TRUE(LiteralTestUtil::Equal(expected, actual));
+  // The recompilation replaced the corrupted entry.
+  CompileAndRun(/*expect_cache_hit=*/true);
+}
+
+// Measures the time to compile kHloText with a cold (argument 0) or a warm
+// (argument 1) persistent cache. Cold compilations each use a new directory,
+// so that they include writing the entry.
+//
+// Both compilations parse the module, run the HLO passes, schedule it and
+// assign its buffers, since the cache key is computed from the optimized
+// module. A cold compilation then emits LLVM IR, optimizes it and generates
+// object code, which a warm one replaces with reading the entry and linking
+// it. The difference between the two is the time the cache saves on every
+// process start, which is what the cache is for; it also catches lookups or
+// key computations becoming a noticeable part of the warm path. Run the test
+// with --benchmarks=all to measure it.
+void BM_CompileWithPersistentCache(::testing::benchmark::State& state) {
+  const bool warm = state.range(0);
+  HloRunner runner(PlatformUtil::GetPlatform("cpu").ValueOrDie());
+  const string cache_root = tensorflow::io::JoinPath(
+      tensorflow::testing::TmpDir(), "BM_CompileWithPersistentCache");
+  const DebugOptions debug_options = GetDebugOptionsFromFlags();
+  auto compile = [&](const string& cache_dir) {
+    HloModuleConfig config;
+    DebugOptions options = debug_options;
+    options.set_xla_cpu_persistent_cache_dir(cache_dir);
+    config.set_debug_options(options);
+    std::unique_ptr<HloModule> module =
+        ParseAndReturnUnverifiedModule(kHloText, config).ValueOrDie();
+    std::unique_ptr<Executable> executable =
+        runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true)
+            .ValueOrDie();
+    return static_cast<CpuExecutable*>(executable.get())
+        ->loaded_from_persistent_cache();
+  };
+
+  const string warm_dir = tensorflow::io::JoinPath(cache_root, "warm");
+  if (warm) {
+    compile(warm_dir);
+  }
+  int64 iteration = 0;
+  for (auto s : state) {
+    const bool cache_hit =
+        compile(warm ? warm_dir
+                     : tensorflow::io::JoinPath(
+                           cache_root, absl::StrCat("cold", iteration++)));
+    CHECK_EQ(cache_hit, warm);
+  }
+
+  int64 undeleted_files, undeleted_dirs;
+  tensorflow::Env::Default()
+      ->DeleteRecursively(cache_root, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+}
+
+BENCHMARK(BM_CompileWithPersistentCache)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
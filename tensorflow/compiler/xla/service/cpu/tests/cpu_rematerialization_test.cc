@@ -0,0 +1,150 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#include "absl/algorithm/container.h"
+#include "absl/strings/match.h"
+#include "tensorflow/compiler/xla/array2d.h"
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/buffer_assignment.h"
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// `exp` is used by the first and the last instructions, and stays live across
+// the chain of dots unless it is recomputed for the last one. The final
+// reduction keeps the output small, so that the peak memory use is that of
+// the chain.
+const char* const kHloText = R"(
+HloModule Rematerialization
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  p = f32[256,256]{1,0} parameter(0)
+  exp = f32[256,256]{1,0} exponential(p)
+  dot1 = f32[256,256]{1,0} dot(exp, exp), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  dot2 = f32[256,256]{1,0} dot(dot1, dot1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  dot3 = f32[256,256]{1,0} dot(dot2, dot2), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  dot4 = f32[256,256]{1,0} dot(dot3, dot3), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  sum = f32[256,256]{1,0} add(dot4, exp)
+  zero = f32[] constant(0)
+  ROOT reduce = f32[256]{0} reduce(sum, zero), dimensions={1}, to_apply=add
+}
+)";
+
+// The size of each of the arrays in kHloText.
+constexpr int64 kArrayBytes = 256 * 256 * sizeof(float);
+
+class CpuRematerializationTest : public CpuCodegenTest {
+ protected:
+  // Parses kHloText with a rematerialization memory limit of
+  // `memory_limit_bytes`, without the parallel task assignment which would
+  // outline the dots.
+  std::unique_ptr<HloModule> ParseModule(int64 memory_limit_bytes) {
+    HloModuleConfig config = GetModuleConfigForTest();
+    DebugOptions debug_options = config.debug_options();
+    debug_options.set_xla_cpu_rematerialization_memory_limit_bytes(
+        memory_limit_bytes);
+    config.set_debug_options(debug_options);
+    config.set_intra_op_parallelism_threads(1);
+    return ParseAndReturnVerifiedModule(kHloText, config).ValueOrDie();
+  }
+
+  // Runs the HLO passes and the buffer assignment on kHloText, and returns
+  // the optimized module and the total size of the allocations.
+  std::pair<std::unique_ptr<HloModule>, int64> Optimize(
+      int64 memory_limit_bytes) {
+    std::unique_ptr<HloModule> module;
+    std::unique_ptr<BufferAssignment> assignment;
+    std::tie(module, assignment) =
+        backend()
+            .compiler()
+            ->RunHloPassesAndBufferAssignement(
+                ParseModule(memory_limit_bytes),
+                backend().default_stream_executor(),
+                /*device_allocator=*/nullptr, /*optimize=*/true)
+            .ValueOrDie();
+    VLOG(1) << assignment->GetStats().ToString();
+    return {std::move(module), assignment->GetStats().total_allocation_bytes};
+  }
+};
+
+bool HasRematerializedInstruction(const HloModule& module) {
+  return absl::c_any_of(
+      module.entry_computation()->instructions(),
+      [](const HloInstruction* instruction) {
+        return absl::StrContains(instruction->name(), "remat");
+      });
+}
+
+TEST_F(CpuRematerializationTest, DisabledByDefault) {
+  std::unique_ptr<HloModule> module =
+      Optimize(/*memory_limit_bytes=*/0).first;
+  EXPECT_FALSE(HasRematerializedInstruction(*module));
+}
+
+TEST_F(CpuRematerializationTest, ReducesBufferAssignmentSize) {
+  std::unique_ptr<HloModule> module;
+  int64 bytes_without_rematerialization, bytes_with_rematerialization;
+  std::tie(module, bytes_without_rematerialization) =
+      Optimize(/*memory_limit_bytes=*/0);
+  // The parameter and three arrays of the chain are live at the peak, which
+  // rematerializing `exp` brings down to two.
+  std::tie(module, bytes_with_rematerialization) =
+      Optimize(/*memory_limit_bytes=*/3 * kArrayBytes + kArrayBytes / 2);
+  EXPECT_TRUE(HasRematerializedInstruction(*module));
+  EXPECT_LT(bytes_with_rematerialization, bytes_without_rematerialization);
+}
+
+TEST_F(CpuRematerializationTest, LimitAboveThePeakIsANoOp) {
+  std::unique_ptr<HloModule> module =
+      Optimize(/*memory_limit_bytes=*/100 * kArrayBytes).first;
+  EXPECT_FALSE(HasRematerializedInstruction(*module));
+}
+
+TEST_F(CpuRematerializationTest, RematerializedModuleKeepsValues) {
+  // Small values, so that the powers computed by the dots stay finite.
+  Array2D<float> input(256, 256);
+  input.Each([](int64 i, int64 j, float* value) {
+    *value = ((i + j) % 7 - 3) / 64.0f - 5.0f;
+  });
+  Literal argument = LiteralUtil::CreateR2FromArray2D(input);
+
+  Literal expected =
+      ExecuteAndTransfer(ParseModule(/*memory_limit_bytes=*/0), {&argument});
+  Literal actual = ExecuteAndTransfer(
+      ParseModule(/*memory_limit_bytes=*/3 * kArrayBytes + kArrayBytes / 2),
+      {&argument});
+  EXPECT_TRUE(LiteralTestUtil::Near(expected, actual, ErrorSpec(1e-4, 1e-4)));
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
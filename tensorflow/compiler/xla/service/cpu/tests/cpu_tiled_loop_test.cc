@@ -0,0 +1,337 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/compiler/xla/array2d.h"
+#include "tensorflow/compiler/xla/array3d.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/service/hlo_runner.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// A copy transposing the layout of its operand.  "$n" is replaced with the
+// size of the dimensions.
+const char* const kTransposeHloText = R"(
+HloModule Transpose
+
+ENTRY main {
+  p = f32[$n,$n]{1,0} parameter(0)
+  ROOT copy = f32[$n,$n]{0,1} copy(p)
+}
+)";
+
+// Reductions of the outer and inner dimensions of an [n, 16, n] array. The
+// middle dimension is reduced as well and is shorter than the window of
+// TreeReductionRewriter, so that the reductions reach the IR emitter as is.
+const char* const kColumnReductionHloText = R"(
+HloModule ColumnReduction
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  p = f32[$n,16,$n]{2,1,0} parameter(0)
+  zero = f32[] constant(0)
+  ROOT reduce = f32[$n]{0} reduce(p, zero), dimensions={0,1}, to_apply=add
+}
+)";
+
+const char* const kRowReductionHloText = R"(
+HloModule RowReduction
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  p = f32[$n,16,$n]{2,1,0} parameter(0)
+  zero = f32[] constant(0)
+  ROOT reduce = f32[$n]{0} reduce(p, zero), dimensions={1,2}, to_apply=add
+}
+)";
+
+// Reductions of [16, n] and [n, 16] arrays to [n]. For large n, the outputs
+// are large enough for ParallelTaskAssignment to split the reductions into
+// partitions.
+const char* const kParallelColumnReductionHloText = R"(
+HloModule ParallelColumnReduction
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  p = f32[16,$n]{1,0} parameter(0)
+  zero = f32[] constant(0)
+  ROOT reduce = f32[$n]{0} reduce(p, zero), dimensions={0}, to_apply=add
+}
+)";
+
+const char* const kParallelRowReductionHloText = R"(
+HloModule ParallelRowReduction
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  p = f32[$n,16]{1,0} parameter(0)
+  zero = f32[] constant(0)
+  ROOT reduce = f32[$n]{0} reduce(p, zero), dimensions={1}, to_apply=add
+}
+)";
+
+string HloTextForSize(const char* hlo_text, int64 n) {
+  return absl::StrReplaceAll(hlo_text, {{"$n", absl::StrCat(n)}});
+}
+
+// The inputs hold small integers, which float additions in any order sum
+// exactly.
+Array2D<float> MakeTransposeInput(int64 n) {
+  Array2D<float> input(n, n);
+  input.Each([](int64 i, int64 j, float* value) { *value = (i * 7 + j) % 13; });
+  return input;
+}
+
+Array3D<float> MakeReductionInput(int64 n) {
+  Array3D<float> input(n, 16, n);
+  input.Each([](int64 i, int64 j, int64 k, float* value) {
+    *value = (i * 7 + j * 3 + k) % 13;
+  });
+  return input;
+}
+
+Literal MakeArgument(const char* hlo_text, int64 n) {
+  return hlo_text == kTransposeHloText
+             ? LiteralUtil::CreateR2FromArray2D(MakeTransposeInput(n))
+             : LiteralUtil::CreateR3FromArray3D(MakeReductionInput(n));
+}
+
+class CpuTiledLoopTest : public CpuCodegenTest {
+ protected:
+  Literal Run(const char* hlo_text, int64 n) {
+    std::unique_ptr<HloModule> module =
+        ParseAndReturnVerifiedModule(HloTextForSize(hlo_text, n)).ValueOrDie();
+    Literal argument = MakeArgument(hlo_text, n);
+    return ExecuteAndTransfer(std::move(module), {&argument});
+  }
+
+  // Runs a reduction of `input` to its dimension `kept_dimension`, with the
+  // reduction partitioned for several threads, and checks its result.
+  void RunParallelReduction(const Array2D<float>& input,
+                            int64 kept_dimension) {
+    const char* hlo_text = kept_dimension == 0
+                               ? kParallelRowReductionHloText
+                               : kParallelColumnReductionHloText;
+    const int64 n = kept_dimension == 0 ? input.n1() : input.n2();
+    std::vector<float> expected(n, 0);
+    for (int64 i = 0; i < input.n1(); ++i) {
+      for (int64 j = 0; j < input.n2(); ++j) {
+        expected[kept_dimension == 0 ? i : j] += input(i, j);
+      }
+    }
+
+    HloModuleConfig config = GetModuleConfigForTest();
+    config.set_intra_op_parallelism_threads(4);
+    std::unique_ptr<HloModule> module =
+        ParseAndReturnVerifiedModule(HloTextForSize(hlo_text, n), config)
+            .ValueOrDie();
+    Literal argument = LiteralUtil::CreateR2FromArray2D(input);
+    Literal result = ExecuteAndTransfer(std::move(module), {&argument});
+    EXPECT_TRUE(LiteralTestUtil::Equal(LiteralUtil::CreateR1<float>(expected),
+                                       result));
+  }
+};
+
+TEST_F(CpuTiledLoopTest, TransposeIsTiled) {
+  CompileAndVerifyIr(HloTextForSize(kTransposeHloText, 128),
+                     R"(CHECK: transpose.rt)");
+}
+
+TEST_F(CpuTiledLoopTest, SmallTransposeIsNotTiled) {
+  CompileAndVerifyIr(HloTextForSize(kTransposeHloText, 4),
+                     R"(CHECK-NOT: transpose.rt)");
+}
+
+TEST_F(CpuTiledLoopTest, TiledTransposeKeepsValues) {
+  // Not a multiple of the tile size, so that the last tiles are partial.
+  const int64 n = 150;
+  Literal result = Run(kTransposeHloText, n);
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2FromArray2D(MakeTransposeInput(n)), result));
+}
+
+TEST_F(CpuTiledLoopTest, ColumnReductionIsTiled) {
+  CompileAndVerifyIr(HloTextForSize(kColumnReductionHloText, 200),
+                     R"(CHECK: reduction_tile)");
+}
+
+TEST_F(CpuTiledLoopTest, TiledColumnReduction) {
+  const int64 n = 200;
+  Array3D<float> input = MakeReductionInput(n);
+  std::vector<float> expected(n, 0);
+  input.Each([&](int64 i, int64 j, int64 k, float* value) {
+    expected[k] += *value;
+  });
+  Literal result = Run(kColumnReductionHloText, n);
+  EXPECT_TRUE(
+      LiteralTestUtil::Equal(LiteralUtil::CreateR1<float>(expected), result));
+}
+
+TEST_F(CpuTiledLoopTest, RowReductionIsVectorized) {
+  CompileAndVerifyIr(HloTextForSize(kRowReductionHloText, 100),
+                     R"(CHECK: %vector_accumulator)");
+}
+
+TEST_F(CpuTiledLoopTest, VectorizedRowReduction) {
+  // The rows of 16 * 101 elements aren't a multiple of the vectorization
+  // factor, so that they have an epilogue.
+  const int64 n = 101;
+  Array3D<float> input = MakeReductionInput(n);
+  std::vector<float> expected(n, 0);
+  input.Each([&](int64 i, int64 j, int64 k, float* value) {
+    expected[i] += *value;
+  });
+  Literal result = Run(kRowReductionHloText, n);
+  EXPECT_TRUE(
+      LiteralTestUtil::Equal(LiteralUtil::CreateR1<float>(expected), result));
+}
+
+// The outputs of 1MiB are split into partitions on machines with several
+// cores, which must each compute their own part of the output only.
+TEST_F(CpuTiledLoopTest, ParallelColumnReduction) {
+  Array2D<float> input(16, 1 << 18);
+  input.Each([](int64 i, int64 j, float* value) { *value = (i * 7 + j) % 13; });
+  RunParallelReduction(input, /*kept_dimension=*/1);
+}
+
+TEST_F(CpuTiledLoopTest, ParallelRowReduction) {
+  Array2D<float> input(1 << 18, 16);
+  input.Each([](int64 i, int64 j, float* value) { *value = (i * 7 + j) % 13; });
+  RunParallelReduction(input, /*kept_dimension=*/0);
+}
+
+// Runs `hlo_text` for size n on a single thread, to compare with the Eigen
+// benchmarks below.
+void BM_Xla(::testing::benchmark::State& state, const char* hlo_text) {
+  const int64 n = state.range(0);
+  HloRunner runner(PlatformUtil::GetPlatform("cpu").ValueOrDie());
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsFromFlags());
+  config.set_intra_op_parallelism_threads(1);
+  std::unique_ptr<HloModule> module =
+      ParseAndReturnUnverifiedModule(HloTextForSize(hlo_text, n), config)
+          .ValueOrDie();
+  std::unique_ptr<Executable> executable =
+      runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true)
+          .ValueOrDie();
+  Literal argument = MakeArgument(hlo_text, n);
+  std::vector<ScopedShapedBuffer> arguments =
+      runner.TransferLiteralsToDevice({&argument}).ValueOrDie();
+
+  for (auto s : state) {
+    TF_CHECK_OK(
+        runner.ExecuteWithDeviceBuffers(executable.get(), arguments).status());
+  }
+  state.SetBytesProcessed(state.iterations() * argument.size_bytes());
+}
+
+void BM_XlaTranspose(::testing::benchmark::State& state) {
+  BM_Xla(state, kTransposeHloText);
+}
+
+void BM_XlaColumnReduction(::testing::benchmark::State& state) {
+  BM_Xla(state, kColumnReductionHloText);
+}
+
+void BM_XlaRowReduction(::testing::benchmark::State& state) {
+  BM_Xla(state, kRowReductionHloText);
+}
+
+using EigenVector = Eigen::Tensor<float, 1, Eigen::RowMajor>;
+using EigenMatrix = Eigen::Tensor<float, 2, Eigen::RowMajor>;
+using EigenTensor3 = Eigen::Tensor<float, 3, Eigen::RowMajor>;
+
+void BM_EigenTranspose(::testing::benchmark::State& state) {
+  const int n = state.range(0);
+  EigenMatrix input(n, n);
+  EigenMatrix output(n, n);
+  input.setRandom();
+  for (auto s : state) {
+    output = input.shuffle(Eigen::array<int, 2>{1, 0});
+    tensorflow::testing::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(state.iterations() * n * n * sizeof(float));
+}
+
+void BM_EigenColumnReduction(::testing::benchmark::State& state) {
+  const int n = state.range(0);
+  EigenTensor3 input(n, 16, n);
+  EigenVector output(n);
+  input.setRandom();
+  for (auto s : state) {
+    output = input.sum(Eigen::array<int, 2>{0, 1});
+    tensorflow::testing::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(state.iterations() * input.size() * sizeof(float));
+}
+
+void BM_EigenRowReduction(::testing::benchmark::State& state) {
+  const int n = state.range(0);
+  EigenTensor3 input(n, 16, n);
+  EigenVector output(n);
+  input.setRandom();
+  for (auto s : state) {
+    output = input.sum(Eigen::array<int, 2>{1, 2});
+    tensorflow::testing::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(state.iterations() * input.size() * sizeof(float));
+}
+
+BENCHMARK(BM_XlaTranspose)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_EigenTranspose)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_XlaColumnReduction)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_EigenColumnReduction)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_XlaRowReduction)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_EigenRowReduction)->Arg(256)->Arg(1024)->Arg(4096);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -74,17 +74,28 @@ StatusOr<bool> HloDCE::RunOnComputation(
 }
 
 StatusOr<bool> HloDCE::Run(HloModule* module) {
-  bool changed = false;
+  RunState run_state(module);
+  TF_RETURN_IF_ERROR(HloDCE::RunOnChangedComputations(module, &run_state));
+  return !run_state.changed_this_iteration.empty();
+}
 
+Status HloDCE::RunOnChangedComputations(HloModule* module,
+                                        RunState* run_state) {
   VLOG(2) << "Before dce:";
   XLA_VLOG_LINES(2, module->ToString());
 
-  // Run DCE on each computation.
+  // Run DCE on each computation which changed, the others have no new dead
+  // instructions.
   for (auto* computation : module->MakeComputationPostOrder()) {
+    if (!run_state->changed_last_iteration.contains(computation)) {
+      continue;
+    }
     TF_ASSIGN_OR_RETURN(
         bool changed_for_computation,
         RunOnComputation(computation, remove_cross_partition_collective_ops_));
-    changed |= changed_for_computation;
+    if (changed_for_computation) {
+      run_state->changed_this_iteration.insert(computation);
+    }
   }
 
   // Now DCE HloComputations.  First, collect the computations that are
@@ -101,18 +112,19 @@ StatusOr<bool> HloDCE::Run(HloModule* module) {
     }
   }
 
-  // Remove dead computations.
+  // Remove dead computations. This changes no other computation, but the
+  // removed one is recorded so that the state shows the module changed.
   for (auto* computation : module->MakeComputationPostOrder()) {
     if (!live_computations.contains(computation)) {
+      run_state->changed_this_iteration.insert(computation);
       TF_RETURN_IF_ERROR(module->RemoveEmbeddedComputation(computation));
-      changed = true;
     }
   }
 
   VLOG(2) << "After dce:";
   XLA_VLOG_LINES(2, module->ToString());
 
-  return changed;
+  return Status::OK();
 }
 
 }  // namespace xla
@@ -50,6 +50,11 @@ class HloDCE : public HloModulePass {
   // (instructions were removed).
   StatusOr<bool> Run(HloModule* module) override;
 
+  // Only removes the dead instructions of the computations changed in the last
+  // iteration, and the dead computations of the whole module.
+  Status RunOnChangedComputations(HloModule* module,
+                                  RunState* run_state) override;
+
  private:
   bool remove_cross_partition_collective_ops_;
 };
@@ -1828,6 +1828,25 @@ Status HloEvaluator::HandleBroadcast(HloInstruction* broadcast) {
         broadcast->ToString());
   }
 
+  // Copy scalars directly to each element of the result, which is the common
+  // case and makes the multi-dimensional indices unnecessary.
+  if (ShapeUtil::IsScalar(operand.shape())) {
+    Literal result(broadcast->shape());
+    char* dest_data = static_cast<char*>(result.untyped_data());
+    const char* source_data = static_cast<const char*>(operand.untyped_data());
+    const int64 primitive_size =
+        ShapeUtil::ByteSizeOfPrimitiveType(operand.shape().element_type());
+    ForEachLinearRange(ShapeUtil::ElementsIn(result.shape()),
+                       [&](int64 begin, int64 end) {
+                         for (int64 i = begin; i < end; ++i) {
+                           memcpy(dest_data + i * primitive_size, source_data,
+                                  primitive_size);
+                         }
+                       });
+    evaluated_[broadcast] = std::move(result);
+    return Status::OK();
+  }
+
   TF_ASSIGN_OR_RETURN(
       evaluated_[broadcast],
       operand.Broadcast(broadcast->shape(), broadcast->dimensions()));
@@ -2392,6 +2411,61 @@ static StatusOr<bool> GenerateReduceOutputElement(
   return true;
 }
 
+// Returns the number of elements of `arg_shape` reduced to each output element
+// by a reduction of `dimensions_to_reduce` if they are contiguous in the buffer
+// of the argument, and the output elements in `output_shape` are in the same
+// order as these runs of elements, so that output element i reduces the i-th
+// run. Returns 0 otherwise.
+static int64 ContiguousReductionSize(
+    const Shape& arg_shape, const Shape& output_shape,
+    absl::Span<const int64> dimensions_to_reduce,
+    absl::Span<const int64> result_to_arg_index) {
+  if (!LayoutUtil::HasLayout(arg_shape) ||
+      !LayoutUtil::HasLayout(output_shape)) {
+    return 0;
+  }
+  absl::Span<const int64> arg_minor_to_major =
+      LayoutUtil::MinorToMajor(arg_shape);
+  absl::Span<const int64> output_minor_to_major =
+      LayoutUtil::MinorToMajor(output_shape);
+  const int64 num_reduced = dimensions_to_reduce.size();
+  for (int64 i = 0; i < num_reduced; ++i) {
+    if (!absl::c_linear_search(dimensions_to_reduce, arg_minor_to_major[i])) {
+      return 0;
+    }
+  }
+  for (int64 i = 0; i < output_minor_to_major.size(); ++i) {
+    if (result_to_arg_index[output_minor_to_major[i]] !=
+        arg_minor_to_major[num_reduced + i]) {
+      return 0;
+    }
+  }
+  int64 size = 1;
+  for (const int64 dim : dimensions_to_reduce) {
+    size *= arg_shape.dimensions(dim);
+  }
+  return size;
+}
+
+// Returns a generator of the sums of the runs of `run_size` contiguous elements
+// of `arg`. Like the fast path of GenerateReduceOutputElement, it accumulates
+// in double from `init`, in the order of the elements in memory, so that the
+// folded values don't depend on the path taken.
+template <typename NativeT>
+static std::function<NativeT(int64)> ContiguousSumGenerator(const Literal& arg,
+                                                            int64 run_size,
+                                                            double init) {
+  const NativeT* data = arg.data<NativeT>().data();
+  return [data, run_size, init](int64 i) {
+    const NativeT* run = data + i * run_size;
+    double sum = init;
+    for (int64 j = 0; j < run_size; ++j) {
+      sum += run[j];
+    }
+    return static_cast<NativeT>(sum);
+  };
+}
+
 Status HloEvaluator::HandleReduce(HloInstruction* instr) {
   HloReduceInstruction* reduce = Cast<HloReduceInstruction>(instr);
   int64 num_args = reduce->inputs().size();
@@ -2461,13 +2535,34 @@ Status HloEvaluator::HandleReduce(HloInstruction* instr) {
     results[i] = Literal(is_tuple ? out_shape.tuple_shapes(i) : out_shape);
   }
 
-  TF_RETURN_IF_ERROR(ShapeUtil::ForEachIndexWithStatus(
-      output_shape, [&](absl::Span<const int64> output_index) {
-        return GenerateReduceOutputElement(
-            is_tuple, output_index, init_values, input_args,
-            absl::Span<Literal>(results), function, &embedded_evaluator,
-            arg_dim_steps, arg_dim_counts, result_to_arg_index);
-      }));
+  const PrimitiveType element_type = arg_shape.element_type();
+  const int64 run_size =
+      is_tuple || !IsScalarAdd(function) ||
+              (element_type != F32 && element_type != F64) ||
+              output_shape.element_type() != element_type
+          ? 0
+          : ContiguousReductionSize(arg_shape, output_shape,
+                                    dimensions_to_reduce, result_to_arg_index);
+  if (run_size > 0) {
+    const double init = *init_values[0]->GetAsDouble({});
+    if (element_type == F32) {
+      PopulateLinear<float>(
+          &results[0],
+          ContiguousSumGenerator<float>(*input_args[0], run_size, init));
+    } else {
+      PopulateLinear<double>(
+          &results[0],
+          ContiguousSumGenerator<double>(*input_args[0], run_size, init));
+    }
+  } else {
+    TF_RETURN_IF_ERROR(ShapeUtil::ForEachIndexWithStatus(
+        output_shape, [&](absl::Span<const int64> output_index) {
+          return GenerateReduceOutputElement(
+              is_tuple, output_index, init_values, input_args,
+              absl::Span<Literal>(results), function, &embedded_evaluator,
+              arg_dim_steps, arg_dim_counts, result_to_arg_index);
+        }));
+  }
 
   if (is_tuple) {
     Literal tuple_result(inferred_return_shape);
@@ -2542,6 +2637,30 @@ Status HloEvaluator::Postprocess(HloInstruction* hlo) {
   return Status::OK();
 }
 
+/* static */ bool HloEvaluator::HaveSameLayout(
+    const Shape& shape, absl::Span<const Literal* const> literals) {
+  if (!shape.IsArray() || !LayoutUtil::HasLayout(shape)) {
+    return false;
+  }
+  return absl::c_all_of(literals, [&](const Literal* literal) {
+    return literal->shape().IsArray() &&
+           LayoutUtil::HasLayout(literal->shape()) &&
+           Layout::Equal().MinorToMajorOnly()(literal->shape().layout(),
+                                              shape.layout());
+  });
+}
+
+void HloEvaluator::ForEachLinearRange(
+    int64 size, const std::function<void(int64, int64)>& fn) const {
+  if (thread_pool_ == nullptr) {
+    fn(0, size);
+    return;
+  }
+  // The cost is a rough number of cycles per element, from which the pool
+  // decides how many ranges are worth running concurrently.
+  thread_pool_->ParallelFor(size, /*cost_per_unit=*/10, fn);
+}
+
 namespace {
 template <typename T>
 std::unique_ptr<Array2D<T>> MatmulArray2DImpl(
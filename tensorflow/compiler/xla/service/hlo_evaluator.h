@@ -36,6 +36,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 
@@ -140,6 +141,14 @@ class HloEvaluator : public DfsHloVisitorWithDefault {
   // Enable the fast path for certain operations like dot or convolution.
   void set_use_fast_path(bool value) { use_fast_path_ = value; }
 
+  // Evaluates the elementwise operations, the broadcasts of scalars and the
+  // reductions over contiguous elements in parallel on `thread_pool`, which
+  // must outlive the evaluator. They are evaluated on the calling thread if it
+  // is null, the default.
+  void set_thread_pool(tensorflow::thread::ThreadPool* thread_pool) {
+    thread_pool_ = thread_pool;
+  }
+
   // Handles evaluation of a custom-call op.
   // Operand literals are provided in |operands| and implementations must
   // populate |output| before returning.
@@ -264,6 +273,32 @@ class HloEvaluator : public DfsHloVisitorWithDefault {
 
   Status HandleCustomCall(HloInstruction* custom_call) override;
 
+  // Returns true if the elements of `literals` are stored in the same order as
+  // those of `shape`, so that an elementwise operation producing `shape` from
+  // them can walk all the buffers linearly instead of computing the linear
+  // index of each element from its multi-dimensional index.
+  static bool HaveSameLayout(const Shape& shape,
+                             absl::Span<const Literal* const> literals);
+
+  // Sets element i of `result` to generator(i), with i the linear index of
+  // the element in the buffer of `result`. `generator` is called concurrently
+  // if there is a thread pool.
+  template <typename NativeT, typename FnType>
+  void PopulateLinear(Literal* result, const FnType& generator) const {
+    absl::Span<NativeT> data = result->data<NativeT>();
+    ForEachLinearRange(data.size(), [&](int64 begin, int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        data[i] = generator(i);
+      }
+    });
+  }
+
+  // Calls fn(begin, end) on ranges which together cover [0, size), one after
+  // the other, or concurrently if there is a thread pool and `size` is large
+  // enough to be worth splitting.
+  void ForEachLinearRange(
+      int64 size, const std::function<void(int64, int64)>& fn) const;
+
   // Unsupported HLOs, note some of them (such as BatchNorm*) are typically
   // expanded in a semantic-preserving way into other HLOs by adding expansion
   // HLO pass to the HLO optimization pass during compilation, which can then be
@@ -327,17 +362,27 @@ class HloEvaluator : public DfsHloVisitorWithDefault {
   // Use fast path that uses eigen in the evaluator.
   bool use_fast_path_ = false;
 
+  // Runs the evaluation of large results in parallel if not null.
+  tensorflow::thread::ThreadPool* thread_pool_ = nullptr;
+
  private:
   template <typename ReturnT, typename NativeT>
-  static StatusOr<Literal> ElementWiseUnaryOpImpl(
+  StatusOr<Literal> ElementWiseUnaryOpImpl(
       HloInstruction* instruction,
       const std::function<ReturnT(NativeT)>& unary_op,
-      const Literal& operand_literal) {
+      const Literal& operand_literal) const {
     const auto shape = instruction->shape();
     const auto* operand = instruction->operand(0);
     TF_RET_CHECK(ShapeUtil::SameDimensions(shape, operand->shape()));
 
     Literal result(shape);
+    if (HaveSameLayout(result.shape(), {&operand_literal})) {
+      absl::Span<const NativeT> operand_data =
+          operand_literal.data<NativeT>();
+      PopulateLinear<ReturnT>(
+          &result, [&](int64 i) { return unary_op(operand_data[i]); });
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(
         result.Populate<ReturnT>([&](absl::Span<const int64> multi_index) {
           return unary_op(operand_literal.Get<NativeT>(multi_index));
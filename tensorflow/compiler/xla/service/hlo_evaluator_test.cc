@@ -27,8 +27,10 @@ limitations under the License.
 #include "tensorflow/compiler/xla/literal.h"
 #include "tensorflow/compiler/xla/reference_util.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_constant_folding.h"
 #include "tensorflow/compiler/xla/service/hlo_element_type_converter.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/status.h"
 #include "tensorflow/compiler/xla/status_macros.h"
@@ -42,8 +44,10 @@ limitations under the License.
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace xla {
@@ -4567,5 +4571,183 @@ TEST_F(HloEvaluatorTest, MapBF16) {
   EXPECT_TRUE(LiteralTestUtil::Equal(expected, result));
 }
 
+TEST_F(HloEvaluatorTest, ElementwiseOpsWithDifferentLayouts) {
+  // The operands of the add and the negate do not have the layout of their
+  // results, so they are not evaluated over the linear indices.
+  const absl::string_view hlo_text = R"(
+  HloModule test
+
+  ENTRY main {
+    a = f32[2,3]{1,0} constant({{1, 2, 3}, {4, 5, 6}})
+    b = f32[2,3]{0,1} constant({{10, 20, 30}, {40, 50, 60}})
+    add = f32[2,3]{1,0} add(a, b)
+    c = f32[2,3]{0,1} constant({{0, 1, 2}, {3, 4, 5}})
+    negate = f32[2,3]{1,0} negate(c)
+    ROOT sub = f32[2,3]{1,0} subtract(add, negate)
+  }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+  TF_ASSERT_OK_AND_ASSIGN(Literal result, Evaluate());
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<float>({{11, 23, 35}, {47, 59, 71}}), result));
+}
+
+TEST_F(HloEvaluatorTest, ReduceAddOfMajorAndMinorDimensions) {
+  // dimension 0 is the minor-most one of the argument, so the sums over it
+  // are of contiguous elements, unlike those over dimension 1.
+  const absl::string_view hlo_text = R"(
+  HloModule test
+
+  add {
+    lhs = f32[] parameter(0)
+    rhs = f32[] parameter(1)
+    ROOT add = f32[] add(lhs, rhs)
+  }
+
+  ENTRY main {
+    arg = f32[2,3]{0,1} constant({{1, 2, 3}, {4, 5, 6}})
+    init = f32[] constant(10)
+    minor = f32[3]{0} reduce(arg, init), dimensions={0}, to_apply=add
+    major = f32[2]{0} reduce(arg, init), dimensions={1}, to_apply=add
+    ROOT tuple = (f32[3]{0}, f32[2]{0}) tuple(minor, major)
+  }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+  TF_ASSERT_OK_AND_ASSIGN(Literal result, Evaluate());
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::MakeTupleFromSlices(
+          {LiteralUtil::CreateR1<float>({15, 17, 19}),
+           LiteralUtil::CreateR1<float>({16, 25})}),
+      result));
+}
+
+TEST_F(HloEvaluatorTest, DotF64WithFastPath) {
+  const absl::string_view hlo_text = R"(
+  HloModule test
+
+  ENTRY main {
+    a = f64[2,3] constant({{1, 2, 3}, {4, 5, 6}})
+    b = f64[3,2] constant({{1, 2}, {3, 4}, {5, 6}})
+    ROOT dot = f64[2,2] dot(a, b), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+  HloEvaluator evaluator;
+  evaluator.set_use_fast_path(true);
+  TF_ASSERT_OK_AND_ASSIGN(Literal result,
+                          evaluator.Evaluate(*m_->entry_computation(), {}));
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<double>({{22, 28}, {49, 64}}), result));
+}
+
+// Sums the rows of 2 * iota, which is large enough for the broadcast, the
+// multiply and the reduce to be split across the threads of a pool.
+const char* const kScaledIotaRowSumHloText = R"(
+HloModule ScaledIotaRowSum
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  iota = f32[512,1024]{1,0} iota(), iota_dimension=1
+  two = f32[] constant(2)
+  twos = f32[512,1024]{1,0} broadcast(two), dimensions={}
+  multiply = f32[512,1024]{1,0} multiply(iota, twos)
+  zero = f32[] constant(0)
+  ROOT reduce = f32[512]{0} reduce(multiply, zero), dimensions={1}, to_apply=add
+}
+)";
+
+TEST_F(HloEvaluatorTest, EvaluatesInParallelWithThreadPool) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      m_, ParseAndReturnVerifiedModule(kScaledIotaRowSumHloText));
+  tensorflow::thread::ThreadPool thread_pool(tensorflow::Env::Default(),
+                                             "hlo_evaluator_test", 4);
+  HloEvaluator evaluator;
+  evaluator.set_thread_pool(&thread_pool);
+  TF_ASSERT_OK_AND_ASSIGN(Literal result,
+                          evaluator.Evaluate(*m_->entry_computation(), {}));
+  // 2 * (0 + 1 + ... + 1023), which is exact in f32.
+  std::vector<float> expected(512, 1023.0f * 1024.0f);
+  EXPECT_TRUE(
+      LiteralTestUtil::Equal(LiteralUtil::CreateR1<float>(expected), result));
+}
+
+// Evaluates kScaledIotaRowSumHloText, on a thread pool with as many threads
+// as the argument if it is greater than 0.
+void BM_ScaledIotaRowSum(::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsFromFlags());
+  std::unique_ptr<HloModule> module =
+      ParseAndReturnUnverifiedModule(kScaledIotaRowSumHloText, config)
+          .ValueOrDie();
+  std::unique_ptr<tensorflow::thread::ThreadPool> thread_pool;
+  if (num_threads > 0) {
+    thread_pool = absl::make_unique<tensorflow::thread::ThreadPool>(
+        tensorflow::Env::Default(), "hlo_evaluator_test", num_threads);
+  }
+
+  for (auto s : state) {
+    HloEvaluator evaluator;
+    evaluator.set_thread_pool(thread_pool.get());
+    evaluator.Evaluate(*module->entry_computation(), {}).ConsumeValueOrDie();
+  }
+}
+
+BENCHMARK(BM_ScaledIotaRowSum)->Arg(0)->Arg(1)->Arg(4)->Arg(8);
+
+// Runs HloConstantFolding on a module summing the rows of the product of two
+// constants of a number of rows (argument) by 1024 elements, which folds the
+// multiply and the reduce. Constant folding evaluates without a thread pool.
+void BM_ConstantFoldLargeConstants(::testing::benchmark::State& state) {
+  const int64 rows = state.range(0);
+  const int64 cols = 1024;
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsFromFlags());
+  HloModule module("LargeConstantRowSum", config);
+
+  const Shape scalar_shape = ShapeUtil::MakeShape(F32, {});
+  HloComputation::Builder add_builder("add");
+  HloInstruction* lhs = add_builder.AddInstruction(
+      HloInstruction::CreateParameter(0, scalar_shape, "lhs"));
+  HloInstruction* rhs = add_builder.AddInstruction(
+      HloInstruction::CreateParameter(1, scalar_shape, "rhs"));
+  add_builder.AddInstruction(
+      HloInstruction::CreateBinary(scalar_shape, HloOpcode::kAdd, lhs, rhs));
+  HloComputation* add = module.AddEmbeddedComputation(add_builder.Build());
+
+  Array2D<float> values(rows, cols);
+  values.Each([](int64 i, int64 j, float* value) { *value = (i + j) % 7; });
+  HloComputation::Builder builder("main");
+  HloInstruction* a = builder.AddInstruction(HloInstruction::CreateConstant(
+      LiteralUtil::CreateR2FromArray2D(values)));
+  HloInstruction* b = builder.AddInstruction(HloInstruction::CreateConstant(
+      LiteralUtil::CreateR2FromArray2D(values)));
+  HloInstruction* multiply = builder.AddInstruction(
+      HloInstruction::CreateBinary(ShapeUtil::MakeShape(F32, {rows, cols}),
+                                   HloOpcode::kMultiply, a, b));
+  HloInstruction* zero = builder.AddInstruction(
+      HloInstruction::CreateConstant(LiteralUtil::CreateR0<float>(0)));
+  builder.AddInstruction(
+      HloInstruction::CreateReduce(ShapeUtil::MakeShape(F32, {rows}), multiply,
+                                   zero, /*dimensions_to_reduce=*/{1}, add));
+  module.AddEntryComputation(builder.Build());
+
+  for (auto s : state) {
+    state.PauseTiming();
+    std::unique_ptr<HloModule> folded_module = module.Clone();
+    state.ResumeTiming();
+    CHECK(HloConstantFolding().Run(folded_module.get()).ValueOrDie());
+  }
+  state.SetBytesProcessed(state.iterations() * 2 * rows * cols *
+                          sizeof(float));
+}
+
+BENCHMARK(BM_ConstantFoldLargeConstants)->Arg(64)->Arg(512)->Arg(4096);
+
 }  // namespace
 }  // namespace xla
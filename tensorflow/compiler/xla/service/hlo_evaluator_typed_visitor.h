@@ -49,6 +49,14 @@ template <typename T>
 struct is_complex_t : absl::disjunction<std::is_same<T, complex64>,
                                         std::is_same<T, complex128>> {};
 
+// The element types of the dots which the fast path evaluates with Eigen. Half
+// is left out because Eigen would accumulate in half precision, and integers
+// because Eigen's arithmetic on them may overflow.
+template <typename T>
+struct is_eigen_dot_t
+    : absl::disjunction<std::is_same<T, float>, std::is_same<T, double>,
+                        is_complex_t<T>> {};
+
 namespace detail {
 template <typename T>
 using unsigned_promoted_type_t =
@@ -212,8 +220,8 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
         parent_->GetEvaluatedLiteralFor(abs->operand(0));
     TF_ASSIGN_OR_RETURN(
         parent_->evaluated_[abs],
-        (HloEvaluator::ElementWiseUnaryOpImpl<typename NativeT::value_type,
-                                              NativeT>(
+        (parent_->ElementWiseUnaryOpImpl<typename NativeT::value_type,
+                                         NativeT>(
             abs, [](NativeT elem_operand) { return std::abs(elem_operand); },
             operand_literal)));
 
@@ -1328,8 +1336,9 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
     return HandleDotSlowPath(dot);
   }
 
-  template <typename NativeT, typename std::enable_if<std::is_same<
-                                  NativeT, float>::value>::type* = nullptr>
+  template <typename NativeT, typename std::enable_if<
+                                  is_eigen_dot_t<NativeT>::value>::type* =
+                                  nullptr>
   Status HandleDot(HloInstruction* dot) {
     const HloInstruction* lhs = dot->operand(0);
     const HloInstruction* rhs = dot->operand(1);
@@ -1385,8 +1394,9 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
     return HandleDotSlowPath(dot);
   }
 
-  template <typename NativeT, typename std::enable_if<!std::is_same<
-                                  NativeT, float>::value>::type* = nullptr>
+  template <typename NativeT, typename std::enable_if<
+                                  !is_eigen_dot_t<NativeT>::value>::type* =
+                                  nullptr>
   Status HandleDot(HloInstruction* dot) {
     return HandleDotSlowPath(dot);
   }
@@ -2952,7 +2962,7 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
         parent_->GetEvaluatedLiteralFor(instruction->operand(0));
     TF_ASSIGN_OR_RETURN(
         auto result_literal,
-        (HloEvaluator::ElementWiseUnaryOpImpl<ReturnT, ReturnT>(
+        (parent_->ElementWiseUnaryOpImpl<ReturnT, ReturnT>(
             instruction, ConvertUnaryFunction(unary_op), operand_literal)));
 
     return std::move(result_literal);
@@ -2970,14 +2980,25 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
 
     const Literal& lhs_literal = parent_->GetEvaluatedLiteralFor(lhs);
     const Literal& rhs_literal = parent_->GetEvaluatedLiteralFor(rhs);
+    const std::function<ReturnT(ReturnT, ReturnT)> converted_binary_op =
+        ConvertBinaryFunction(binary_op);
 
     Literal result(shape);
 
+    if (HloEvaluator::HaveSameLayout(result.shape(),
+                                     {&lhs_literal, &rhs_literal})) {
+      absl::Span<const ReturnT> lhs_data = lhs_literal.data<ReturnT>();
+      absl::Span<const ReturnT> rhs_data = rhs_literal.data<ReturnT>();
+      parent_->PopulateLinear<ReturnT>(&result, [&](int64 i) {
+        return converted_binary_op(lhs_data[i], rhs_data[i]);
+      });
+      return std::move(result);
+    }
+
     TF_RETURN_IF_ERROR(
         result.Populate<ReturnT>([&](absl::Span<const int64> multi_index) {
-          return ConvertBinaryFunction(binary_op)(
-              lhs_literal.Get<ReturnT>(multi_index),
-              rhs_literal.Get<ReturnT>(multi_index));
+          return converted_binary_op(lhs_literal.Get<ReturnT>(multi_index),
+                                     rhs_literal.Get<ReturnT>(multi_index));
         }));
     return std::move(result);
   }
@@ -3000,6 +3021,17 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
 
     Literal result(shape);
 
+    if (HloEvaluator::HaveSameLayout(
+            result.shape(), {&lhs_literal, &rhs_literal, &ehs_literal})) {
+      absl::Span<const LhsType> lhs_data = lhs_literal.data<LhsType>();
+      absl::Span<const RhsType> rhs_data = rhs_literal.data<RhsType>();
+      absl::Span<const EhsType> ehs_data = ehs_literal.data<EhsType>();
+      parent_->PopulateLinear<ReturnT>(&result, [&](int64 i) {
+        return ternary_op(lhs_data[i], rhs_data[i], ehs_data[i]);
+      });
+      return std::move(result);
+    }
+
     TF_RETURN_IF_ERROR(
         result.Populate<ReturnT>([&](absl::Span<const int64> multi_index) {
           return ternary_op(lhs_literal.Get<LhsType>(multi_index),
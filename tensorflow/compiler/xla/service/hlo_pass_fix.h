@@ -17,9 +17,11 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_HLO_PASS_FIX_H_
 
 #include <algorithm>
+#include <type_traits>
 
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_module_group.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
@@ -28,28 +30,63 @@ limitations under the License.
 namespace xla {
 
 // Do an HLO pass to a fix point.
+//
+// With set_incremental(true), each iteration only revisits the computations
+// changed by the previous one, for the passes which override
+// HloPassInterface::RunOnChangedComputations.
 template <typename Pass>
 class HloPassFix : public Pass {
  public:
   template <typename... Args>
   explicit HloPassFix(Args&&... args) : Pass(args...) {}
 
+  // Makes Run revisit only the changed computations. The passes only revisit
+  // the direct callers of a changed computation, so a backend opts in once
+  // its passes don't depend on further callees. Nested fixed point loops run
+  // incrementally whenever the outer one does.
+  HloPassFix& set_incremental(bool incremental) {
+    incremental_ = incremental;
+    return *this;
+  }
+
   StatusOr<bool> Run(HloModule* module) override {
+    if (!incremental_) {
+      return RunOnWholeModule(module);
+    }
+    HloPassInterface::RunState run_state(module);
+    TF_ASSIGN_OR_RETURN(bool converged, RunToFixPoint(module, &run_state));
+    // Return false in case this is fixed point is nested.
+    return converged && !run_state.changed.empty();
+  }
+
+  // Runs the pass to a fix point, starting from the computations changed
+  // since the outer fixed point loop last ran it. All the iterations make up
+  // a single iteration of the outer loop.
+  Status RunOnChangedComputations(
+      HloModule* module, HloPassInterface::RunState* outer_run_state) override {
+    HloPassInterface::RunState run_state;
+    run_state.changed_last_iteration = outer_run_state->changed_last_iteration;
+    TF_RETURN_IF_ERROR(RunToFixPoint(module, &run_state).status());
+    outer_run_state->changed_this_iteration.insert(run_state.changed.begin(),
+                                                   run_state.changed.end());
+    return Status::OK();
+  }
+
+  StatusOr<bool> RunOnModuleGroup(HloModuleGroup* module_group) override {
     bool changed = false;
     bool changed_this_iteration = true;
     int64 iteration_count = 0;
     const int64 kLimit = 25;
-    VLOG(3) << "Running HloPassFix on " << Pass::name();
+    VLOG(3) << "Running HloPassFix.";
     while (changed_this_iteration) {
-      TF_ASSIGN_OR_RETURN(changed_this_iteration, Pass::Run(module));
+      TF_ASSIGN_OR_RETURN(changed_this_iteration,
+                          Pass::RunOnModuleGroup(module_group));
       changed |= changed_this_iteration;
-      VLOG(3) << Pass::name() << " iteration " << iteration_count
-              << " changed_this_iteration: " << changed_this_iteration;
+      VLOG(3) << "changed_this_iteration: " << changed_this_iteration;
       ++iteration_count;
       if (iteration_count == kLimit) {
-        VLOG(1) << "Unexpectedly high number of iterations in HLO passes '"
-                << Pass::name() << "' for module '" << module->name()
-                << "'. Exiting fixed point loop.";
+        VLOG(1) << "Unexpectedly high number of iterations in HLO passes, "
+                   "exiting fixed point loop.";
         // Return false in case this is fixed point is nested.
         return false;
       }
@@ -57,27 +94,72 @@ class HloPassFix : public Pass {
     return changed;
   }
 
-  StatusOr<bool> RunOnModuleGroup(HloModuleGroup* module_group) override {
+ private:
+  StatusOr<bool> RunOnWholeModule(HloModule* module) {
     bool changed = false;
     bool changed_this_iteration = true;
     int64 iteration_count = 0;
     const int64 kLimit = 25;
-    VLOG(3) << "Running HloPassFix.";
+    VLOG(3) << "Running HloPassFix on " << Pass::name();
     while (changed_this_iteration) {
-      TF_ASSIGN_OR_RETURN(changed_this_iteration,
-                          Pass::RunOnModuleGroup(module_group));
+      TF_ASSIGN_OR_RETURN(changed_this_iteration, Pass::Run(module));
       changed |= changed_this_iteration;
-      VLOG(3) << "changed_this_iteration: " << changed_this_iteration;
+      VLOG(3) << Pass::name() << " iteration " << iteration_count
+              << " changed_this_iteration: " << changed_this_iteration;
       ++iteration_count;
       if (iteration_count == kLimit) {
-        VLOG(1) << "Unexpectedly high number of iterations in HLO passes, "
-                   "exiting fixed point loop.";
+        VLOG(1) << "Unexpectedly high number of iterations in HLO passes '"
+                << Pass::name() << "' for module '" << module->name()
+                << "'. Exiting fixed point loop.";
         // Return false in case this is fixed point is nested.
         return false;
       }
     }
     return changed;
   }
+
+  // Runs iterations until one changes nothing. Returns false if it stopped at
+  // the limit on the number of iterations instead.
+  StatusOr<bool> RunToFixPoint(HloModule* module,
+                               HloPassInterface::RunState* run_state) {
+    const int64 kLimit = 25;
+    VLOG(3) << "Running HloPassFix on " << Pass::name();
+    while (!run_state->changed_last_iteration.empty()) {
+      TF_RETURN_IF_ERROR(RunOnChangedComputationsOnce(module, run_state));
+      VLOG(3) << Pass::name() << " iteration " << run_state->iteration
+              << " changed_this_iteration: "
+              << !run_state->changed_this_iteration.empty();
+      run_state->IncrementIteration();
+      if (run_state->iteration == kLimit) {
+        VLOG(1) << "Unexpectedly high number of iterations in HLO passes '"
+                << Pass::name() << "' for module '" << module->name()
+                << "'. Exiting fixed point loop.";
+        return false;
+      }
+    }
+    return true;
+  }
+
+  Status RunOnChangedComputationsOnce(HloModule* module,
+                                      HloPassInterface::RunState* run_state) {
+    // Passes which override RunOnChangedComputations only visit the changed
+    // computations. The default implementation would call back into Run,
+    // which is the fixed point loop itself, so run the pass directly instead.
+    using DefaultRunOnChangedComputations =
+        decltype(&HloPassInterface::RunOnChangedComputations);
+    if (!std::is_same<decltype(&Pass::RunOnChangedComputations),
+                      DefaultRunOnChangedComputations>::value) {
+      return Pass::RunOnChangedComputations(module, run_state);
+    }
+    TF_ASSIGN_OR_RETURN(bool changed, Pass::Run(module));
+    if (changed) {
+      run_state->changed_this_iteration.insert(module->computations().begin(),
+                                               module->computations().end());
+    }
+    return Status::OK();
+  }
+
+  bool incremental_ = false;
 };
 
 }  // namespace xla
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_HLO_PASS_INTERFACE_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_HLO_PASS_INTERFACE_H_
 
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_module_group.h"
 #include "tensorflow/compiler/xla/status_macros.h"
@@ -30,6 +32,36 @@ namespace xla {
 // directly; it should extend HloModulePass or HloModuleGroupPass.
 class HloPassInterface {
  public:
+  // The state of a fixed point loop over a pass (see HloPassFix), from which
+  // the pass finds the computations it has to revisit in each iteration.
+  struct RunState {
+    RunState() = default;
+    // Starts a loop in which the first iteration visits all the computations
+    // of `module`.
+    explicit RunState(HloModule* module)
+        : changed_last_iteration(module->computations().begin(),
+                                 module->computations().end()) {}
+
+    // Moves on to the next iteration of the loop.
+    void IncrementIteration() {
+      changed.insert(changed_this_iteration.begin(),
+                     changed_this_iteration.end());
+      changed_last_iteration = std::move(changed_this_iteration);
+      changed_this_iteration.clear();
+      ++iteration;
+    }
+
+    // The number of iterations run so far.
+    int64 iteration = 0;
+    // The computations changed by all the iterations so far.
+    absl::flat_hash_set<HloComputation*> changed;
+    // The computations changed by the last iteration, which are the only ones
+    // the current iteration has to visit.
+    absl::flat_hash_set<HloComputation*> changed_last_iteration;
+    // The computations changed by the current iteration so far.
+    absl::flat_hash_set<HloComputation*> changed_this_iteration;
+  };
+
   virtual ~HloPassInterface() = default;
   virtual absl::string_view name() const = 0;
 
@@ -37,6 +69,25 @@ class HloPassInterface {
   // module.
   virtual StatusOr<bool> Run(HloModule* module) = 0;
 
+  // Runs one iteration of a fixed point loop over the pass, on the
+  // computations in run_state->changed_last_iteration, and adds those it
+  // changes to run_state->changed_this_iteration. The computations may have
+  // been removed from the module since they were added to the state, and a
+  // pass must only use them to look up the computations of the module.
+  //
+  // The default runs the pass on the whole module, and adds all the
+  // computations to the state if it changes the module. Passes which keep
+  // track of the computations they change can override it to skip the others.
+  virtual Status RunOnChangedComputations(HloModule* module,
+                                          RunState* run_state) {
+    TF_ASSIGN_OR_RETURN(bool changed, Run(module));
+    if (changed) {
+      run_state->changed_this_iteration.insert(module->computations().begin(),
+                                               module->computations().end());
+    }
+    return Status::OK();
+  }
+
   // Run the pass on the given HLO module group. Returns whether it modified the
   // module group. Ideally, the module group variant would be named "Run" as
   // well, but C++ does not handle overloaded virtual methods well.
@@ -51,6 +51,32 @@ Status HloPassPipeline::RunInvariantCheckers(
   return Status::OK();
 }
 
+template <typename HloT>
+void HloPassPipeline::StartPass(HloT* hlo, HloPassInterface* pass,
+                                absl::string_view last_pass_name) {
+  absl::string_view pass_name = pass->name();
+  VLOG(1) << "  HLO pass " << pass_name;
+  VLOG(2) << "  Module hash " << hlo->Hash();
+  MaybeDumpHlo(*hlo,
+               /*after_pass_name=*/last_pass_name,
+               /*before_pass_name=*/pass_name);
+  if (pass->IsPassPipeline()) {
+    static_cast<HloPassPipeline*>(pass)->InheritCompilationStats(
+        compilation_stats_);
+  } else {
+    compilation_stats_->StartPass(pass_name);
+  }
+}
+
+template <typename HloT>
+Status HloPassPipeline::EndPass(HloT* hlo, HloPassInterface* pass) {
+  TF_RETURN_IF_ERROR(RunInvariantCheckers(hlo, pass->name()));
+  if (!pass->IsPassPipeline()) {
+    compilation_stats_->EndPass(pass->name());
+  }
+  return Status::OK();
+}
+
 template <typename HloT>
 StatusOr<bool> HloPassPipeline::RunPassesInternal(
     HloT* hlo, absl::Span<HloPassInterface* const> passes) {
@@ -59,25 +85,14 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
   bool changed = false;
   for (HloPassInterface* pass : passes) {
     XLA_SCOPED_LOGGING_TIMER(absl::StrCat("HLO pass: ", pass->name()));
-    absl::string_view pass_name = pass->name();
-    VLOG(1) << "  HLO pass " << pass_name;
-    VLOG(2) << "  Module hash " << hlo->Hash();
-    MaybeDumpHlo(*hlo,
-                 /*after_pass_name=*/last_pass_name,
-                 /*before_pass_name=*/pass_name);
-    if (!pass->IsPassPipeline()) {
-      compilation_stats_->StartPass(pass_name);
-    }
+    StartPass(hlo, pass, last_pass_name);
     TF_ASSIGN_OR_RETURN(bool pass_changed, RunHelper(pass, hlo));
     changed |= pass_changed;
     if (pass_changed) {
       VLOG(3) << "  Pass caused changes" << pass->name();
     }
-    TF_RETURN_IF_ERROR(RunInvariantCheckers(hlo, pass_name));
-    last_pass_name = string(pass_name);
-    if (!pass->IsPassPipeline()) {
-      compilation_stats_->EndPass(pass_name);
-    }
+    TF_RETURN_IF_ERROR(EndPass(hlo, pass));
+    last_pass_name = string(pass->name());
   }
   MaybeDumpHlo(*hlo,
                /*after_pass_name=*/last_pass_name,
@@ -154,6 +169,64 @@ StatusOr<bool> HloPassPipeline::Run(HloModule* module) {
                            GetEnabledPasses(module->config().debug_options()));
 }
 
+Status HloPassPipeline::RunOnChangedComputations(HloModule* module,
+                                                 RunState* run_state) {
+  run_called_ = true;
+
+  VLOG(1) << "Running HLO pass pipeline on changed computations of module "
+          << module->name() << ": " << name();
+
+  std::vector<HloPassInterface*> passes =
+      GetEnabledPasses(module->config().debug_options());
+  if (run_state->iteration == 0) {
+    changed_since_last_run_.clear();
+    for (HloPassInterface* pass : passes) {
+      changed_since_last_run_[pass] = run_state->changed_last_iteration;
+    }
+  }
+
+  string last_pass_name = "pipeline-start";
+  TF_RETURN_IF_ERROR(RunInvariantCheckers(module, last_pass_name));
+  for (HloPassInterface* pass : passes) {
+    // A pass left the module as it was the last time it ran, so it has
+    // nothing to do until another pass changes the module.
+    absl::flat_hash_set<HloComputation*>& changed_since_pass =
+        changed_since_last_run_[pass];
+    if (changed_since_pass.empty()) {
+      VLOG(1) << "  Skipping HLO pass " << pass->name()
+              << ", nothing changed since it last ran";
+      continue;
+    }
+    RunState pass_run_state;
+    pass_run_state.changed_last_iteration = std::move(changed_since_pass);
+    changed_since_pass.clear();
+
+    XLA_SCOPED_LOGGING_TIMER(absl::StrCat("HLO pass: ", pass->name()));
+    StartPass(module, pass, last_pass_name);
+    TF_RETURN_IF_ERROR(
+        pass->RunOnChangedComputations(module, &pass_run_state));
+    module->Cleanup();
+    const absl::flat_hash_set<HloComputation*>& changed_by_pass =
+        pass_run_state.changed_this_iteration;
+    if (!changed_by_pass.empty()) {
+      VLOG(3) << "  Pass caused changes" << pass->name();
+      // Including the pass itself, which may not have reached its own fix
+      // point.
+      for (auto& entry : changed_since_last_run_) {
+        entry.second.insert(changed_by_pass.begin(), changed_by_pass.end());
+      }
+      run_state->changed_this_iteration.insert(changed_by_pass.begin(),
+                                               changed_by_pass.end());
+    }
+    TF_RETURN_IF_ERROR(EndPass(module, pass));
+    last_pass_name = string(pass->name());
+  }
+  MaybeDumpHlo(*module,
+               /*after_pass_name=*/last_pass_name,
+               /*before_pass_name=*/"pipeline-end");
+  return Status::OK();
+}
+
 StatusOr<bool> HloPassPipeline::RunOnModuleGroup(HloModuleGroup* module_group) {
   run_called_ = true;
 
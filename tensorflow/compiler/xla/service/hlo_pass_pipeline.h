@@ -21,9 +21,12 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/xla/service/compilation_stats.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
 #include "tensorflow/compiler/xla/statusor.h"
@@ -81,9 +84,32 @@ class HloPassPipeline : public HloPassInterface {
   StatusOr<bool> Run(HloModule* module) override;
   StatusOr<bool> RunOnModuleGroup(HloModuleGroup* module_group) override;
 
+  // Runs the passes on the computations changed since they last ran in the
+  // fixed point loop of `run_state`, skipping those for which nothing changed.
+  Status RunOnChangedComputations(HloModule* module,
+                                  RunState* run_state) override;
+
   bool IsPassPipeline() override { return true; }
 
  private:
+  // Makes a nested pipeline report its passes to `compilation_stats`, unless
+  // it was given stats of its own.
+  void InheritCompilationStats(CompilationStats* compilation_stats) {
+    if (empty_compilation_stats_ != nullptr) {
+      compilation_stats_ = compilation_stats;
+    }
+  }
+
+  // Starts running `pass` from RunPassesInternal or RunOnChangedComputations,
+  // after `last_pass_name`.
+  template <typename HloT>
+  void StartPass(HloT* hlo, HloPassInterface* pass,
+                 absl::string_view last_pass_name);
+
+  // Finishes running `pass` on `hlo`, checking the invariants after it.
+  template <typename HloT>
+  Status EndPass(HloT* hlo, HloPassInterface* pass);
+
   // Returns the set of passes which are enabled. DebugOptions can selectively
   // disable passes via --xla_disable_hlo_passes flag.
   std::vector<HloPassInterface*> GetEnabledPasses(
@@ -132,6 +158,11 @@ class HloPassPipeline : public HloPassInterface {
   // Default stats instance for when one is not passed in the constructor.
   // Use via compilation_stats_, not directly.
   std::unique_ptr<CompilationStats> empty_compilation_stats_;
+
+  // For each pass, the computations changed since it last ran in the current
+  // fixed point loop of RunOnChangedComputations.
+  absl::flat_hash_map<HloPassInterface*, absl::flat_hash_set<HloComputation*>>
+      changed_since_last_run_;
 };
 
 }  // namespace xla
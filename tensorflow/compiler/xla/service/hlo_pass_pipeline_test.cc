@@ -15,10 +15,13 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_fix.h"
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -95,6 +98,146 @@ class BarBlowerUpper : public HloModulePass {
   }
 };
 
+// A module pass which renames one instruction named 'foo*' to 'bar*' per
+// computation each time it runs, and counts its runs and the computations it
+// visits.
+class OneFooToBarPerComputationPass : public HloModulePass {
+ public:
+  OneFooToBarPerComputationPass(int* num_runs,
+                                std::vector<int>* num_visited_computations)
+      : num_runs_(num_runs),
+        num_visited_computations_(num_visited_computations) {}
+
+  absl::string_view name() const override { return "one-foo2bar"; }
+
+  StatusOr<bool> Run(HloModule* module) override {
+    RunState run_state(module);
+    TF_RETURN_IF_ERROR(RunOnChangedComputations(module, &run_state));
+    return !run_state.changed_this_iteration.empty();
+  }
+
+  Status RunOnChangedComputations(HloModule* module,
+                                  RunState* run_state) override {
+    ++*num_runs_;
+    int num_visited = 0;
+    for (HloComputation* computation : module->computations()) {
+      if (!run_state->changed_last_iteration.contains(computation)) {
+        continue;
+      }
+      ++num_visited;
+      for (HloInstruction* instruction : computation->instructions()) {
+        if (absl::StartsWith(instruction->name(), "foo")) {
+          instruction->SetAndSanitizeName(
+              absl::StrCat("bar", instruction->name().substr(3)));
+          run_state->changed_this_iteration.insert(computation);
+          break;
+        }
+      }
+    }
+    num_visited_computations_->push_back(num_visited);
+    return Status::OK();
+  }
+
+ private:
+  int* num_runs_;
+  std::vector<int>* num_visited_computations_;
+};
+
+// A module pass which never changes the module, and counts its runs.
+class CountingNoopPass : public HloModulePass {
+ public:
+  explicit CountingNoopPass(int* num_runs) : num_runs_(num_runs) {}
+
+  absl::string_view name() const override { return "counting-noop"; }
+
+  StatusOr<bool> Run(HloModule* module) override {
+    ++*num_runs_;
+    return false;
+  }
+
+ private:
+  int* num_runs_;
+};
+
+const char* const kTwoFoosModule = R"(
+HloModule TwoFoos
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  a = f32[4] parameter(0)
+  b = f32[] parameter(1)
+  foo = f32[] reduce(a, b), dimensions={0}, to_apply=add
+  ROOT foo.1 = f32[] multiply(foo, b)
+}
+)";
+
+TEST_F(HloPassPipelineTest, FixedPointRevisitsOnlyChangedComputations) {
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(kTwoFoosModule));
+  int num_runs = 0;
+  std::vector<int> num_visited_computations;
+  HloPassFix<OneFooToBarPerComputationPass> pass(&num_runs,
+                                                 &num_visited_computations);
+  pass.set_incremental(true);
+
+  // The module has two computations, but only the entry computation is
+  // changed by the first two iterations, one 'foo*' at a time.
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, pass.Run(module.get()));
+  EXPECT_TRUE(changed);
+  EXPECT_EQ(num_runs, 3);
+  EXPECT_EQ(num_visited_computations, std::vector<int>({2, 1, 1}));
+  for (const HloInstruction* instruction :
+       module->entry_computation()->instructions()) {
+    EXPECT_FALSE(absl::StartsWith(instruction->name(), "foo"));
+  }
+}
+
+TEST_F(HloPassPipelineTest, FixedPointPipelineSkipsPassesWithoutChanges) {
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(kTwoFoosModule));
+  int num_foo_runs = 0;
+  int num_noop_runs = 0;
+  std::vector<int> num_visited_computations;
+  HloPassFix<HloPassPipeline> pipeline(TestName());
+  pipeline.set_incremental(true);
+  pipeline.AddPass<OneFooToBarPerComputationPass>(&num_foo_runs,
+                                                  &num_visited_computations);
+  pipeline.AddPass<CountingNoopPass>(&num_noop_runs);
+
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, pipeline.Run(module.get()));
+  EXPECT_TRUE(changed);
+  // The third iteration only reruns the renaming pass, as the no-op pass has
+  // already run after the last change.
+  EXPECT_EQ(num_foo_runs, 3);
+  EXPECT_EQ(num_noop_runs, 2);
+  EXPECT_EQ(num_visited_computations, std::vector<int>({2, 1, 1}));
+}
+
+TEST_F(HloPassPipelineTest, FixedPointPipelineRevisitsAllByDefault) {
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(kTwoFoosModule));
+  int num_foo_runs = 0;
+  int num_noop_runs = 0;
+  std::vector<int> num_visited_computations;
+  HloPassFix<HloPassPipeline> pipeline(TestName());
+  pipeline.AddPass<HloPassFix<OneFooToBarPerComputationPass>>(
+      &num_foo_runs, &num_visited_computations);
+  pipeline.AddPass<CountingNoopPass>(&num_noop_runs);
+
+  // Without set_incremental, every pass, including the nested fixed point
+  // loop, runs on all the computations in every iteration.
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, pipeline.Run(module.get()));
+  EXPECT_TRUE(changed);
+  EXPECT_EQ(num_foo_runs, 4);
+  EXPECT_EQ(num_noop_runs, 2);
+  EXPECT_EQ(num_visited_computations, std::vector<int>({2, 2, 2, 2}));
+}
+
 TEST_F(HloPassPipelineTest, ModulePassChanged) {
   // Test an HLO module pass which changes a module.
   const string module_str = R"(
@@ -41,6 +41,9 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/while_loop_simplifier.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace xla {
@@ -76,6 +79,16 @@ StatusOr<Literal> HandleEvaluatorCustomCall(
   return std::move(output);
 }
 
+// Returns the thread pool shared by the evaluators of all the executables,
+// on which they run their large elementwise operations and reductions.
+tensorflow::thread::ThreadPool* EvaluatorThreadPool() {
+  static tensorflow::thread::ThreadPool* thread_pool =
+      new tensorflow::thread::ThreadPool(tensorflow::Env::Default(),
+                                         "hlo_evaluator",
+                                         tensorflow::port::MaxParallelism());
+  return thread_pool;
+}
+
 }  // namespace
 
 Status InterpreterCompiler::RunHloOptimization(HloModule* hlo_module) {
@@ -111,9 +124,13 @@ StatusOr<std::unique_ptr<Executable>> InterpreterCompiler::RunBackend(
   TF_ASSIGN_OR_RETURN(DynamicDimensionInference dynamic_dimension_inference,
                       DynamicDimensionInference::Run(hlo_module.get()));
 
+  const bool use_fast_path =
+      hlo_module->config().debug_options().xla_hlo_evaluator_use_fast_path();
   auto evaluator = absl::make_unique<HloEvaluator>();
-  evaluator->set_use_fast_path(
-      hlo_module->config().debug_options().xla_hlo_evaluator_use_fast_path());
+  evaluator->set_use_fast_path(use_fast_path);
+  if (use_fast_path) {
+    evaluator->set_thread_pool(EvaluatorThreadPool());
+  }
   evaluator->set_custom_call_handler(HandleEvaluatorCustomCall);
 
   // Create executable from only the Hlo module.
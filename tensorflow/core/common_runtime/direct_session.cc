@@ -428,6 +428,8 @@ Status DirectSession::ExtendLocked(GraphDef graph) {
   if (finalized_) {
     return errors::FailedPrecondition("Session has been finalized.");
   }
+  const PlacementCostModel* placement_cost_model;
+  TF_RETURN_IF_ERROR(UpdatePlacementCostModelLocked(&placement_cost_model));
   if (!(flib_def_ && execution_state_)) {
     // If this is the first call, we can initialize the execution state
     // with `graph` and do not need to call `Extend()`.
@@ -439,6 +441,7 @@ Status DirectSession::ExtendLocked(GraphDef graph) {
     options.device_set = &device_set_;
     options.session_options = &options_;
     options.session_handle = session_handle_;
+    options.placement_cost_model = placement_cost_model;
     TF_RETURN_IF_ERROR(GraphExecutionState::MakeForBaseGraph(
         std::move(graph), options, &execution_state_));
     graph_created_ = true;
@@ -453,6 +456,33 @@ Status DirectSession::ExtendLocked(GraphDef graph) {
   return Status::OK();
 }
 
+Status DirectSession::UpdatePlacementCostModelLocked(
+    const PlacementCostModel** cost_model) {
+  const CostGraphDef& recorded_costs =
+      options_.config.experimental().placement_cost_graph();
+  if (recorded_costs.node().empty()) {
+    *cost_model = nullptr;
+    return Status::OK();
+  }
+  placement_cost_model_.Clear();
+  placement_cost_model_.AddCostGraph(recorded_costs);
+  {
+    // The graphs are owned by the executors, which must stay alive while
+    // their costs are read.
+    mutex_lock l(executor_lock_);
+    std::vector<const Graph*> graphs;
+    for (const auto& it : executors_) {
+      for (const auto& item : it.second->items) {
+        graphs.push_back(item.graph.get());
+      }
+    }
+    TF_RETURN_IF_ERROR(
+        placement_cost_model_.AddCostModels(&cost_model_manager_, graphs));
+  }
+  *cost_model = &placement_cost_model_;
+  return Status::OK();
+}
+
 Status DirectSession::Run(const NamedTensorList& inputs,
                           const std::vector<string>& output_names,
                           const std::vector<string>& target_nodes,
@@ -784,14 +814,25 @@ Status DirectSession::RunInternal(
       device_to_graph[device] = graph;
     }
 
-    mutex_lock l(executor_lock_);
-    run_state.collector->BuildCostModel(&cost_model_manager_, device_to_graph);
-
-    // annotate stats onto cost graph.
     CostGraphDef* cost_graph = run_metadata->mutable_cost_graph();
-    for (const auto& item : executors_and_keys->items) {
-      TF_RETURN_IF_ERROR(
-          cost_model_manager_.AddToCostGraphDef(item.graph.get(), cost_graph));
+    {
+      mutex_lock l(executor_lock_);
+      run_state.collector->BuildCostModel(&cost_model_manager_,
+                                          device_to_graph);
+
+      // annotate stats onto cost graph.
+      for (const auto& item : executors_and_keys->items) {
+        TF_RETURN_IF_ERROR(cost_model_manager_.AddToCostGraphDef(
+            item.graph.get(), cost_graph));
+      }
+    }
+
+    // The graphs created for the next call signatures are placed with the
+    // costs measured by this step. graph_state_lock_ is acquired before
+    // executor_lock_, so the latter must be released first.
+    if (!options_.config.experimental().placement_cost_graph().node().empty()) {
+      mutex_lock l(graph_state_lock_);
+      placement_cost_model_.AddCostGraph(*cost_graph);
     }
   }
 
@@ -1599,6 +1640,10 @@ Status DirectSession::CreateGraphs(
     prune_options.session_options = &options_;
     prune_options.stateful_placements = stateful_placements_;
     prune_options.session_handle = session_handle_;
+    prune_options.placement_cost_model =
+        options_.config.experimental().placement_cost_graph().node().empty()
+            ? nullptr
+            : &placement_cost_model_;
     TF_RETURN_IF_ERROR(GraphExecutionState::MakeForPrunedGraph(
         *execution_state_, prune_options, subgraph_options,
         &temp_exec_state_holder, &client_graph));
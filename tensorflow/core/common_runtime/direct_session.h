@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/graph_execution_state.h"
+#include "tensorflow/core/common_runtime/placement_cost_model.h"
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
@@ -277,6 +278,15 @@ class DirectSession : public Session {
   ::tensorflow::Status ExtendLocked(GraphDef graph)
       TF_EXCLUSIVE_LOCKS_REQUIRED(graph_state_lock_);
 
+  // Sets "*cost_model" to the costs used to place the graph, or to nullptr if
+  // ConfigProto.Experimental.placement_cost_graph is empty. The costs measured
+  // by this session (see GraphOptions.build_cost_model) take precedence over
+  // the recorded ones. The costs measured by later steps are added by
+  // RunInternal().
+  ::tensorflow::Status UpdatePlacementCostModelLocked(
+      const PlacementCostModel** cost_model)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(graph_state_lock_);
+
   ::tensorflow::Status ResourceHandleToInputTensor(
       const Tensor& resource_tensor, Tensor* retrieved_tensor);
 
@@ -399,6 +409,9 @@ class DirectSession : public Session {
   std::unique_ptr<GraphExecutionState> execution_state_
       TF_GUARDED_BY(graph_state_lock_);
 
+  // Costs used for cost-based placement, borrowed by the execution states.
+  PlacementCostModel placement_cost_model_ TF_GUARDED_BY(graph_state_lock_);
+
   // The function library, before any rewrites or optimizations have been
   // performed. In particular, CreateGraphs() may need to modify the function
   // library; it copies and modifies the function library.
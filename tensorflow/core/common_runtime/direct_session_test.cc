@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/function_testlib.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -2150,6 +2151,68 @@ TEST(DirectSessionTest, TestSessionInterOpThreadsInvalidOptions) {
   }
 }
 
+// Returns the device of the node named "name" in the partition graphs of
+// "run_metadata", or an empty string if it is not found.
+string PartitionDevice(const RunMetadata& run_metadata, const string& name) {
+  for (const GraphDef& graph : run_metadata.partition_graphs()) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) return node.device();
+    }
+  }
+  return "";
+}
+
+TEST(DirectSessionTest, MeasuredCostsChangePlacement) {
+  Graph g(OpRegistry::Global());
+  Node* shape = test::graph::Constant(&g, test::AsTensor<int32>({512, 512}));
+  Node* a = test::graph::RandomUniform(&g, shape, DT_FLOAT);
+  Node* m1 = test::graph::Matmul(&g, a, a, false, false);
+  Node* m2 = test::graph::Matmul(&g, a, a, true, false);
+  GraphDef def;
+  g.ToGraphDef(&def);
+
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  GraphOptions* graph_options = options.config.mutable_graph_options();
+  graph_options->mutable_optimizer_options()->set_opt_level(
+      OptimizerOptions::L0);
+  graph_options->mutable_rewrite_options()->set_disable_meta_optimizer(true);
+  graph_options->set_build_cost_model(1);
+  // Enable cost-based placement, without recorded costs for the graph.
+  CostGraphDef::Node* seed = options.config.mutable_experimental()
+                                 ->mutable_placement_cost_graph()
+                                 ->add_node();
+  seed->set_name("unused");
+  seed->set_compute_cost(1);
+
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  RunOptions run_options;
+  run_options.set_output_partition_graphs(true);
+  std::vector<Tensor> outputs;
+
+  // Without costs, both products are placed on the first device.
+  RunMetadata first_metadata;
+  TF_ASSERT_OK(session->Run(run_options, {}, {m1->name(), m2->name()}, {},
+                            &outputs, &first_metadata));
+  EXPECT_EQ(PartitionDevice(first_metadata, m1->name()),
+            PartitionDevice(first_metadata, m2->name()));
+
+  // The graphs of a new call signature are placed with the costs measured
+  // by the first run, which spread the two products over the devices.
+  RunMetadata second_metadata;
+  TF_ASSERT_OK(session->Run(run_options, {},
+                            {m1->name(), m2->name(), a->name()}, {}, &outputs,
+                            &second_metadata));
+  const string m1_device = PartitionDevice(second_metadata, m1->name());
+  const string m2_device = PartitionDevice(second_metadata, m2->name());
+  EXPECT_FALSE(m1_device.empty());
+  EXPECT_FALSE(m2_device.empty());
+  EXPECT_NE(m1_device, m2_device);
+}
+
 TEST(DirectSessionTest, TestDirectSessionRunClose) {
   // Construct a graph with a variable and a single assign.
   Graph g(OpRegistry::Global());
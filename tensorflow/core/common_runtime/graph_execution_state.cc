@@ -71,6 +71,7 @@ GraphExecutionState::GraphExecutionState(
       device_set_(options.device_set),
       session_options_(options.session_options),
       session_handle_(options.session_handle),
+      placement_cost_model_(options.placement_cost_model),
       flib_def_(std::move(flib_def)),
       graph_(nullptr) {}
 
@@ -254,6 +255,7 @@ Status GraphExecutionState::Extend(
   combined_options.session_options = session_options_;
   combined_options.session_handle = session_handle_;
   combined_options.stateful_placements = stateful_placements_;
+  combined_options.placement_cost_model = placement_cost_model_;
 
   TF_RETURN_IF_ERROR(AddDefaultAttrsToGraphDef(&gdef, *flib_def_, 0));
   auto flib_def = absl::make_unique<FunctionLibraryDefinition>(
@@ -615,7 +617,8 @@ Status GraphExecutionState::InitBaseGraph(std::unique_ptr<Graph>&& new_graph) {
                 session_options_ == nullptr ||
                     session_options_->config.allow_soft_placement(),
                 session_options_ != nullptr &&
-                    session_options_->config.log_device_placement());
+                    session_options_->config.log_device_placement(),
+                placement_cost_model_);
   // TODO(mrry): Consider making the Placer cancellable.
   TF_RETURN_IF_ERROR(placer.Run());
 
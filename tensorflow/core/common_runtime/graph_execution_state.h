@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/build_graph_options.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_set.h"
+#include "tensorflow/core/common_runtime/placement_cost_model.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/graph/costmodel.h"
@@ -47,6 +48,10 @@ struct GraphExecutionStateOptions {
   // A map from node name to device name, representing the unchangeable
   // placement of stateful nodes.
   std::unordered_map<string, string> stateful_placements;
+  // If non-null, the costs measured by prior runs of the graph, used by the
+  // placer to balance nodes over devices. Not owned, must outlive the
+  // GraphExecutionState and the states created from it by Extend().
+  const PlacementCostModel* placement_cost_model = nullptr;
 };
 
 // A ClientGraph is simply a sub-graph of the full graph as induced by
@@ -195,6 +200,7 @@ class GraphExecutionState {
   const SessionOptions* session_options_;  // Not owned
   // Unique session identifier. Can be empty.
   string session_handle_;
+  const PlacementCostModel* placement_cost_model_;  // Not owned
 
   // Map from name to Node for the full graph in placed_.
   NodeNameToCostIdMap node_name_to_cost_id_map_;
@@ -0,0 +1,87 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/placement_cost_model.h"
+
+#include <algorithm>
+
+namespace tensorflow {
+
+namespace {
+
+// Copies between devices of the same host go through host memory: a fixed
+// cost for the Send/Recv pair and a memcpy bandwidth of about 10 GB/s.
+constexpr double kHostCopyLatencyMillis = 0.01;
+constexpr double kHostCopyGbps = 80.0;
+
+}  // namespace
+
+PlacementCostModel::PlacementCostModel(const CostGraphDef& cost_graph) {
+  AddCostGraph(cost_graph);
+}
+
+void PlacementCostModel::AddCostGraph(const CostGraphDef& cost_graph) {
+  for (const CostGraphDef::Node& node : cost_graph.node()) {
+    NodeCost& cost = node_costs_[node.name()];
+    cost.compute_time = Microseconds(std::max<int64>(node.compute_cost(), 0));
+    cost.output_sizes.clear();
+    cost.output_sizes.reserve(node.output_info_size());
+    for (const CostGraphDef::Node::OutputInfo& output : node.output_info()) {
+      // Sizes that were never measured are reported as negative values.
+      cost.output_sizes.emplace_back(std::max<int64>(output.size(), 0));
+    }
+  }
+}
+
+Status PlacementCostModel::AddCostModels(
+    CostModelManager* cost_model_manager,
+    const std::vector<const Graph*>& graphs) {
+  CostModelManager::CostModelMap cost_models;
+  cost_model_manager->ExportCostModels(&cost_models);
+  CostGraphDef cost_graph;
+  for (const Graph* graph : graphs) {
+    if (cost_models.find(graph) == cost_models.end()) continue;
+    TF_RETURN_IF_ERROR(
+        cost_model_manager->AddToCostGraphDef(graph, &cost_graph));
+  }
+  AddCostGraph(cost_graph);
+  return Status::OK();
+}
+
+bool PlacementCostModel::GetComputeTime(const string& node_name,
+                                        Microseconds* compute_time) const {
+  auto it = node_costs_.find(node_name);
+  if (it == node_costs_.end()) return false;
+  *compute_time = it->second.compute_time;
+  return true;
+}
+
+Bytes PlacementCostModel::OutputSize(const string& node_name,
+                                     int output_slot) const {
+  auto it = node_costs_.find(node_name);
+  if (it == node_costs_.end() || output_slot < 0 ||
+      output_slot >= static_cast<int>(it->second.output_sizes.size())) {
+    return Bytes(0);
+  }
+  return it->second.output_sizes[output_slot];
+}
+
+/* static */
+Microseconds PlacementCostModel::CopyTime(Bytes bytes) {
+  return CostModel::CopyTimeEstimate(bytes, kHostCopyLatencyMillis,
+                                     kHostCopyGbps);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,79 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_PLACEMENT_COST_MODEL_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_PLACEMENT_COST_MODEL_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/costmodel_manager.h"
+#include "tensorflow/core/framework/cost_graph.pb.h"
+#include "tensorflow/core/graph/costmodel.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Per-node costs measured by prior runs of a graph, keyed by node name, that
+// the Placer uses to balance nodes over several devices of the same type.
+//
+// The costs come either from a recorded CostGraphDef (e.g.
+// RunMetadata.cost_graph) or from the CostModels of a CostModelManager.
+class PlacementCostModel {
+ public:
+  PlacementCostModel() = default;
+  explicit PlacementCostModel(const CostGraphDef& cost_graph);
+
+  // Records the compute time and output sizes of the nodes in "cost_graph".
+  // The costs of nodes that were already recorded are overwritten.
+  void AddCostGraph(const CostGraphDef& cost_graph);
+
+  // Records the costs collected by "cost_model_manager" for each graph in
+  // "graphs". Graphs without a cost model are ignored.
+  Status AddCostModels(CostModelManager* cost_model_manager,
+                       const std::vector<const Graph*>& graphs);
+
+  // Removes all the recorded costs.
+  void Clear() { node_costs_.clear(); }
+
+  bool empty() const { return node_costs_.empty(); }
+
+  // Returns true and sets "compute_time" if a cost was recorded for the node
+  // named "node_name".
+  bool GetComputeTime(const string& node_name,
+                      Microseconds* compute_time) const;
+
+  // Returns the recorded size of output "output_slot" of the node named
+  // "node_name", or 0 if unknown.
+  Bytes OutputSize(const string& node_name, int output_slot) const;
+
+  // Returns the estimated time to copy "bytes" between two devices of the
+  // same host.
+  static Microseconds CopyTime(Bytes bytes);
+
+ private:
+  struct NodeCost {
+    Microseconds compute_time;
+    std::vector<Bytes> output_sizes;
+  };
+
+  std::unordered_map<string, NodeCost> node_costs_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_PLACEMENT_COST_MODEL_H_
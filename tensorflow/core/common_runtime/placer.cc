@@ -15,9 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/placer.h"
 
+#include <algorithm>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/colocation_graph.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/attr_value_util.h"
@@ -26,8 +29,10 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph_node_util.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/port.h"
 
@@ -129,19 +134,106 @@ Status AssignAndLog(int assigned_device, Node* node,
   return Status::OK();
 }
 
+// Spreads nodes over devices of the same type using the costs recorded in a
+// PlacementCostModel. The assigner simulates a list schedule of the graph: each
+// device runs its nodes one after the other, and a node starts once its inputs
+// are available on its device, i.e. after they are computed and, if produced
+// on another device, copied. A node goes to the candidate device on which it
+// would complete first.
+//
+// Nodes should be visited in topological order, so that the devices of their
+// inputs are known when they are placed.
+class CostBasedAssigner {
+ public:
+  CostBasedAssigner(const PlacementCostModel* cost_model, Graph* graph)
+      : cost_model_(*cost_model), graph_(graph) {}
+
+  // Schedules "node", which has an assigned device, on that device. Nodes
+  // without a recorded cost take no time.
+  void Record(const Node& node) {
+    Microseconds compute_time(0);
+    cost_model_.GetComputeTime(node.name(), &compute_time);
+    const int device = node.assigned_device_name_index();
+    const int64 completion_time =
+        CompletionTime(node, device, compute_time.value());
+    completion_times_[node.id()] = completion_time;
+    device_available_[device] = completion_time;
+  }
+
+  // Returns the index of the device name to assign to "node", or -1 if no
+  // cost was recorded for "node". Only the devices with the same type and
+  // address space as the preferred device "devices[0]" are considered, ties
+  // are broken in favor of the earliest device in "devices".
+  int Choose(const Node& node, const std::vector<Device*>& devices) {
+    Microseconds compute_time;
+    if (!cost_model_.GetComputeTime(node.name(), &compute_time)) return -1;
+    const Device* preferred = devices[0];
+    int best_device = -1;
+    int64 best_completion_time = 0;
+    for (const Device* device : devices) {
+      if (device->device_type() != preferred->device_type() ||
+          !DeviceNameUtils::IsSameAddressSpace(device->parsed_name(),
+                                               preferred->parsed_name())) {
+        continue;
+      }
+      const int index = graph_->InternDeviceName(device->name());
+      const int64 completion_time =
+          CompletionTime(node, index, compute_time.value());
+      if (best_device == -1 || completion_time < best_completion_time) {
+        best_device = index;
+        best_completion_time = completion_time;
+      }
+    }
+    return best_device;
+  }
+
+ private:
+  // Returns the time at which "node" would complete if it ran on "device".
+  // Inputs that are not scheduled yet (e.g. loop back edges) are ignored.
+  int64 CompletionTime(const Node& node, int device,
+                       int64 compute_time) const {
+    auto available = device_available_.find(device);
+    int64 start_time =
+        available == device_available_.end() ? 0 : available->second;
+    for (const Edge* edge : node.in_edges()) {
+      const Node* src = edge->src();
+      auto completed = completion_times_.find(src->id());
+      if (completed == completion_times_.end()) continue;
+      int64 ready_time = completed->second;
+      if (!edge->IsControlEdge() &&
+          src->assigned_device_name_index() != device) {
+        ready_time +=
+            PlacementCostModel::CopyTime(
+                cost_model_.OutputSize(src->name(), edge->src_output()))
+                .value();
+      }
+      start_time = std::max(start_time, ready_time);
+    }
+    return start_time + compute_time;
+  }
+
+  const PlacementCostModel& cost_model_;
+  Graph* const graph_;  // Not owned.
+  // Simulated times in microseconds, keyed by node id and device name index.
+  std::unordered_map<int, int64> completion_times_;
+  std::unordered_map<int, int64> device_available_;
+};
+
 }  // namespace
 
 Placer::Placer(Graph* graph, const string& function_name,
                const FunctionLibraryDefinition* flib_def,
                const DeviceSet* devices, const Device* default_local_device,
-               bool allow_soft_placement, bool log_device_placement)
+               bool allow_soft_placement, bool log_device_placement,
+               const PlacementCostModel* cost_model)
     : graph_(graph),
       function_name_(function_name),
       flib_def_(flib_def),
       devices_(devices),
       default_local_device_(default_local_device),
       allow_soft_placement_(allow_soft_placement),
-      log_device_placement_(log_device_placement) {}
+      log_device_placement_(log_device_placement),
+      cost_model_(cost_model) {}
 
 Placer::Placer(Graph* graph, const string& function_name,
                const DeviceSet* devices, const Device* default_local_device)
@@ -178,16 +270,39 @@ Status Placer::Run() {
 
   TF_RETURN_IF_ERROR(colocation_graph.Initialize());
 
+  // Cost-based placement needs the inputs of a node to be placed before the
+  // node itself, so the nodes are visited in a (deterministic) topological
+  // order in that case.
+  std::unique_ptr<CostBasedAssigner> cost_assigner;
+  std::vector<Node*> nodes;
+  if (cost_model_ != nullptr && !cost_model_->empty()) {
+    cost_assigner = absl::make_unique<CostBasedAssigner>(cost_model_, graph_);
+    GetReversePostOrder(*graph_, &nodes, NodeComparatorName());
+    nodes.erase(std::remove_if(nodes.begin(), nodes.end(),
+                               [](const Node* node) { return !node->IsOp(); }),
+                nodes.end());
+  }
+  if (static_cast<int>(nodes.size()) != graph_->num_op_nodes()) {
+    // Visits the remaining nodes in id order: all of them without a cost
+    // model, otherwise those that are not reachable from the source node.
+    std::vector<bool> visited(graph_->num_node_ids(), false);
+    for (const Node* node : nodes) visited[node->id()] = true;
+    for (Node* node : graph_->op_nodes()) {
+      if (!visited[node->id()]) nodes.push_back(node);
+    }
+  }
+
   // For each node, assign a device based on the constraints in the disjoint
   // node set.
   std::vector<Node*> second_pass;
-  for (Node* node : graph_->op_nodes()) {
+  for (Node* node : nodes) {
     // The graph may have come pre-populated by the framework with assigned
     // devices (e.g., for stateful placements), so the placer should not try to
     // place nodes that are already placed.
     if (node->has_assigned_device_name()) {
       TF_RETURN_IF_ERROR(colocation_graph.LimitToAssignedDevice(*node));
       LogDeviceAssignment(node, log_device_placement_);
+      if (cost_assigner) cost_assigner->Record(*node);
       continue;
     }
 
@@ -238,6 +353,11 @@ Status Placer::Run() {
       }
     }
 
+    // Balance the load using the measured costs, if available.
+    if (assigned_device == -1 && cost_assigner) {
+      assigned_device = cost_assigner->Choose(*node, *devices);
+    }
+
     // Provide the default, if necessary.
     if (assigned_device == -1) {
       assigned_device = graph_->InternDeviceName((*devices)[0]->name());
@@ -245,6 +365,7 @@ Status Placer::Run() {
 
     TF_RETURN_IF_ERROR(AssignAndLog(assigned_device, node, &colocation_graph,
                                     log_device_placement_));
+    if (cost_assigner) cost_assigner->Record(*node);
   }
 
   // Perform a second pass assignment for those nodes explicitly
@@ -278,6 +399,11 @@ Status Placer::Run() {
       }
     }
 
+    // Balance the load using the measured costs, if available.
+    if (assigned_device == -1 && cost_assigner) {
+      assigned_device = cost_assigner->Choose(*node, *devices);
+    }
+
     // Provide the default, if necessary.
     if (assigned_device == -1) {
       assigned_device = graph_->InternDeviceName((*devices)[0]->name());
@@ -285,6 +411,7 @@ Status Placer::Run() {
 
     TF_RETURN_IF_ERROR(AssignAndLog(assigned_device, node, &colocation_graph,
                                     log_device_placement_));
+    if (cost_assigner) cost_assigner->Record(*node);
   }
 
   if (VLOG_IS_ON(3)) {
@@ -19,6 +19,7 @@ limitations under the License.
 #include <string>
 
 #include "tensorflow/core/common_runtime/device_set.h"
+#include "tensorflow/core/common_runtime/placement_cost_model.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -66,12 +67,19 @@ class Placer {
   // would otherwise be higher priority. default_local_device should be on the
   // local host so that its FLR is directly accessible by the current process.
   //
-  // The "graph", "devices", and "default_local_device" pointer arguments are
-  // borrowed by this Placer, and must outlive it.
+  // If non-null, "cost_model" holds the costs measured by prior runs of
+  // "graph". Nodes with a recorded cost that may run on several devices of the
+  // same type are then spread over these devices to balance their load, while
+  // accounting for the cost of copying their inputs between devices. Other
+  // nodes are placed as if no cost model was given.
+  //
+  // The "graph", "devices", "default_local_device" and "cost_model" pointer
+  // arguments are borrowed by this Placer, and must outlive it.
   Placer(Graph* graph, const string& function_name,
          const FunctionLibraryDefinition* flib_def, const DeviceSet* devices,
          const Device* default_local_device, bool allow_soft_placement,
-         bool log_device_placement);
+         bool log_device_placement,
+         const PlacementCostModel* cost_model = nullptr);
 
   Placer(Graph* graph, const string& function_name, const DeviceSet* devices,
          const Device* default_local_device);
@@ -100,6 +108,7 @@ class Placer {
   const Device* default_local_device_;               // Not owned.
   const bool allow_soft_placement_;
   const bool log_device_placement_;
+  const PlacementCostModel* const cost_model_;  // Not owned.
 
   TF_DISALLOW_COPY_AND_ASSIGN(Placer);
 };
@@ -27,6 +27,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/graph_def_builder_util.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/common_runtime/placement_cost_model.h"
+#include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/function_testlib.h"
@@ -1607,6 +1609,131 @@ TEST_F(PlacerTest, TestNoKernelsRegisteredWithRequestedDeviceRemote) {
   EXPECT_DEVICE_CONTAINS(g, "var", remote_device);
 }
 
+// Adds the measured costs of node "name" to "cost_graph", as recorded in the
+// RunMetadata of a prior run.
+void AddNodeCost(const string& name, int64 compute_micros,
+                 const std::vector<int64>& output_bytes,
+                 CostGraphDef* cost_graph) {
+  CostGraphDef::Node* node = cost_graph->add_node();
+  node->set_name(name);
+  node->set_compute_cost(compute_micros);
+  for (int64 bytes : output_bytes) {
+    node->add_output_info()->set_size(bytes);
+  }
+}
+
+// Test that cost-based placement spreads independent chains of expensive ops
+// over the devices, keeps each chain on a single device, and places the nodes
+// without recorded costs as usual.
+TEST_F(PlacerTest, TestCostBasedPlacementBalancesLoad) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* input = ops::SourceOp("TestInput", b.opts().WithName("in"));
+    Node* r1 = ops::UnaryOp("TestRelu", ops::NodeOut(input, 0),
+                            b.opts().WithName("r1"));
+    Node* r2 = ops::UnaryOp("TestRelu", r1, b.opts().WithName("r2"));
+    Node* s1 = ops::UnaryOp("TestRelu", ops::NodeOut(input, 1),
+                            b.opts().WithName("s1"));
+    Node* s2 = ops::UnaryOp("TestRelu", s1, b.opts().WithName("s2"));
+    Node* add = ops::BinaryOp("TestAdd", r2, s2, b.opts().WithName("add"));
+    ops::UnaryOp("TestRelu", add, b.opts().WithName("untracked"));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  CostGraphDef cost_graph;
+  AddNodeCost("in", 1, {4096, 4096}, &cost_graph);
+  AddNodeCost("r1", 1000, {4096}, &cost_graph);
+  AddNodeCost("r2", 1000, {4096}, &cost_graph);
+  AddNodeCost("s1", 1000, {4096}, &cost_graph);
+  AddNodeCost("s2", 1000, {4096}, &cost_graph);
+  AddNodeCost("add", 10, {4096}, &cost_graph);
+  PlacementCostModel cost_model(cost_graph);
+
+  DeviceSet cpus;
+  std::unique_ptr<Device> cpu0(
+      FakeDevice::MakeCPU("/job:a/replica:0/task:0/device:FakeCPU:0"));
+  cpus.AddDevice(cpu0.get());
+  std::unique_ptr<Device> cpu1(
+      FakeDevice::MakeCPU("/job:a/replica:0/task:0/device:FakeCPU:1"));
+  cpus.AddDevice(cpu1.get());
+
+  Placer placer(&g, "", &g.flib_def(), &cpus, nullptr, true, false,
+                &cost_model);
+  TF_EXPECT_OK(placer.Run());
+
+  EXPECT_DEVICE_CONTAINS(g, "in", "/device:FakeCPU:0");
+  EXPECT_COLOCATED(g, "r1", "r2");
+  EXPECT_COLOCATED(g, "s1", "s2");
+  EXPECT_NOT_COLOCATED(g, "r1", "s1");
+  EXPECT_DEVICE_CONTAINS(g, "untracked", "/device:FakeCPU:0");
+
+  // Without costs, all the nodes go to the first device.
+  Graph g2(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g2.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* input = ops::SourceOp("TestInput", b.opts().WithName("in"));
+    ops::UnaryOp("TestRelu", ops::NodeOut(input, 0), b.opts().WithName("r1"));
+    ops::UnaryOp("TestRelu", ops::NodeOut(input, 1), b.opts().WithName("s1"));
+    TF_EXPECT_OK(BuildGraph(b, &g2));
+  }
+  PlacementCostModel empty_cost_model;
+  Placer default_placer(&g2, "", &g2.flib_def(), &cpus, nullptr, true, false,
+                        &empty_cost_model);
+  TF_EXPECT_OK(default_placer.Run());
+  EXPECT_COLOCATED(g2, "in", "r1");
+  EXPECT_COLOCATED(g2, "in", "s1");
+}
+
+// Test that cost-based placement keeps the consumers of large tensors on the
+// device of their producer when copying the tensor would cost more than the
+// computation, and respects devices that are already assigned.
+TEST_F(PlacerTest, TestCostBasedPlacementAvoidsLargeCopies) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* input = ops::SourceOp("TestInput", b.opts().WithName("in"));
+    ops::UnaryOp("TestRelu", ops::NodeOut(input, 0), b.opts().WithName("r1"));
+    ops::UnaryOp("TestRelu", ops::NodeOut(input, 1), b.opts().WithName("s1"));
+    Node* pinned_input =
+        ops::SourceOp("TestInput", b.opts().WithName("pinned_in"));
+    ops::UnaryOp("TestRelu", ops::NodeOut(pinned_input, 0),
+                 b.opts().WithName("pinned"));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+  GetNodeByName(g, "pinned_in")
+      ->set_assigned_device_name("/job:a/replica:0/task:0/device:FakeCPU:1");
+  GetNodeByName(g, "pinned")
+      ->set_assigned_device_name("/job:a/replica:0/task:0/device:FakeCPU:1");
+
+  // Copying a 10MB output between devices takes about 1ms.
+  CostGraphDef cost_graph;
+  AddNodeCost("in", 10, {10 << 20, 10 << 20}, &cost_graph);
+  AddNodeCost("r1", 500, {4096}, &cost_graph);
+  AddNodeCost("s1", 500, {4096}, &cost_graph);
+  AddNodeCost("pinned_in", 1, {4096, 4096}, &cost_graph);
+  AddNodeCost("pinned", 5000, {4096}, &cost_graph);
+  PlacementCostModel cost_model(cost_graph);
+
+  DeviceSet cpus;
+  std::unique_ptr<Device> cpu0(
+      FakeDevice::MakeCPU("/job:a/replica:0/task:0/device:FakeCPU:0"));
+  cpus.AddDevice(cpu0.get());
+  std::unique_ptr<Device> cpu1(
+      FakeDevice::MakeCPU("/job:a/replica:0/task:0/device:FakeCPU:1"));
+  cpus.AddDevice(cpu1.get());
+
+  Placer placer(&g, "", &g.flib_def(), &cpus, nullptr, true, false,
+                &cost_model);
+  TF_EXPECT_OK(placer.Run());
+
+  EXPECT_DEVICE_CONTAINS(g, "in", "/device:FakeCPU:0");
+  EXPECT_DEVICE_CONTAINS(g, "r1", "/device:FakeCPU:0");
+  EXPECT_DEVICE_CONTAINS(g, "s1", "/device:FakeCPU:0");
+  EXPECT_DEVICE_CONTAINS(g, "pinned_in", "/device:FakeCPU:1");
+  EXPECT_DEVICE_CONTAINS(g, "pinned", "/device:FakeCPU:1");
+}
+
 // Test that placement fails when a kernel is registered but no known
 // device supports it.
 TEST_F(PlacerTest, TestNoDevicesRegistered) {
@@ -153,6 +153,17 @@ auto* xla_compilation_time_usecs = monitoring::Counter<0>::New(
     "/tensorflow/core/xla_compilation_time_usecs",
     "The total time spent on compiling XLA graphs in microseconds.");
 
+auto* xla_compilation_time_usecs_histogram = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/xla_compilation_time_usecs_histogram",
+     "The wall-clock time spent on compiling XLA graphs in microseconds."},
+    // Power of 2 with bucket count 20 (> 17 minutes)
+    {monitoring::Buckets::Exponential(1000, 2, 20)});
+
+auto* xla_compilation_fallbacks = monitoring::Counter<0>::New(
+    "/tensorflow/core/xla_compilation_fallbacks",
+    "The number of times an XLA cluster was executed as a TensorFlow function "
+    "because its compilation was still pending in the background.");
+
 auto* mlir_import_failure_count = monitoring::Counter<0>::New(
     "/tensorflow/mlir/import_failure_count",
     "The number of jobs that failed during mlir import or verification.");
@@ -297,11 +308,20 @@ void UpdateXlaCompilationTime(const uint64 compilation_time_usecs) {
     static auto* xla_compilations_cell = xla_compilations->GetCell();
     static auto* xla_compilation_time_usecs_cell =
         xla_compilation_time_usecs->GetCell();
+    static auto* xla_compilation_time_usecs_histogram_cell =
+        xla_compilation_time_usecs_histogram->GetCell();
     xla_compilations_cell->IncrementBy(1);
     xla_compilation_time_usecs_cell->IncrementBy(compilation_time_usecs);
+    xla_compilation_time_usecs_histogram_cell->Add(compilation_time_usecs);
   }
 }
 
+void IncrementXlaCompilationFallbackCount() {
+  static auto* xla_compilation_fallbacks_cell =
+      xla_compilation_fallbacks->GetCell();
+  xla_compilation_fallbacks_cell->IncrementBy(1);
+}
+
 void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs) {
   static auto* bfc_allocator_delay_cell = bfc_allocator_delay->GetCell();
   if (delay_usecs > 0) {
@@ -127,6 +127,10 @@ void UpdateGrapplerPassTime(const string& pass_name,
 // Updates the metrics stored about time XLA spents compiling graphs.
 void UpdateXlaCompilationTime(const uint64 compilation_time_usecs);
 
+// Increments the number of times an XLA cluster ran as a TensorFlow function
+// while its compilation was pending in the background.
+void IncrementXlaCompilationFallbackCount();
+
 // Updates the metrics stored about time BFC allocator spents during delay.
 void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs);
 
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/common_subgraph_elimination.h"
 
+#include <algorithm>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -24,8 +25,11 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -54,6 +58,46 @@ using tensorflow::strings::StrCat;
 namespace tensorflow {
 namespace grappler {
 
+namespace {
+
+constexpr char kFuncAttr[] = "f";
+
+// Returns true if the function `func_name` and all the functions it calls are
+// free of side effects. The results are memoized in `free_of_side_effect`.
+bool IsFunctionFreeOfSideEffect(
+    const string& func_name, const FunctionLibraryDefinition& flib,
+    absl::flat_hash_map<string, bool>* free_of_side_effect) {
+  auto it = free_of_side_effect->find(func_name);
+  if (it != free_of_side_effect->end()) return it->second;
+  // Recursive functions are conservatively assumed to have side effects.
+  (*free_of_side_effect)[func_name] = false;
+
+  const FunctionDef* func = flib.Find(func_name);
+  if (func == nullptr || func->signature().is_stateful()) return false;
+  const auto is_free = [&](const string& name) {
+    return IsFunctionFreeOfSideEffect(name, flib, free_of_side_effect);
+  };
+  for (const NodeDef& node : func->node_def()) {
+    if (flib.Find(node.op()) != nullptr) {
+      if (!is_free(node.op())) return false;
+    } else if (!IsFreeOfSideEffect(node)) {
+      return false;
+    }
+    // Functional ops (e.g. StatelessIf) reference their functions in attrs.
+    for (const auto& attr : node.attr()) {
+      const AttrValue& value = attr.second;
+      if (value.has_func() && !is_free(value.func().name())) return false;
+      for (const NameAttrList& attr_func : value.list().func()) {
+        if (!is_free(attr_func.name())) return false;
+      }
+    }
+  }
+  (*free_of_side_effect)[func_name] = true;
+  return true;
+}
+
+}  // namespace
+
 class UniqueNodes {
  public:
   NodeDef* FindOrAddRepresentative(NodeDef* node) {
@@ -148,6 +192,19 @@ bool UniqueNodes::SameNode(const NodeDef& node1, const NodeDef& node2) const {
   return true;
 }
 
+const string* CommonSubgraphElimination::FindDedupableFunction(
+    const NodeDef& node) const {
+  const string* func_name = nullptr;
+  if (IsPartitionedCall(node) || IsStatefulPartitionedCall(node)) {
+    const AttrValue* func_attr = AttrSlice(node).Find(kFuncAttr);
+    if (func_attr == nullptr || !func_attr->has_func()) return nullptr;
+    func_name = &func_attr->func().name();
+  } else {
+    func_name = &node.op();
+  }
+  return dedupable_function_sizes_.contains(*func_name) ? func_name : nullptr;
+}
+
 bool CommonSubgraphElimination::CanDedup(const NodeDef& node) const {
   if (nodes_to_preserve_.find(node.name()) != nodes_to_preserve_.end()) {
     return false;
@@ -158,6 +215,11 @@ bool CommonSubgraphElimination::CanDedup(const NodeDef& node) const {
   if (node.device().find("SPU") != string::npos) {
     return false;
   }
+  // Calls with the same inputs to a function free of side effects compute the
+  // same outputs.
+  if (FindDedupableFunction(node) != nullptr) {
+    return true;
+  }
   // Workaround for Assert and Print mistakenly being labeled as stateful.
   if (IsAssert(node) || IsPrint(node)) {
     return true;
@@ -165,6 +227,111 @@ bool CommonSubgraphElimination::CanDedup(const NodeDef& node) const {
   return IsFreeOfSideEffect(node);
 }
 
+Status CommonSubgraphElimination::CanonicalizeFunctionCalls(
+    GraphDef* optimized_graph) {
+  dedupable_function_sizes_.clear();
+  original_calls_.clear();
+  const FunctionDefLibrary& library = optimized_graph->library();
+  if (library.function().empty()) return Status::OK();
+
+  // Calls are redirected to the representative of their function without
+  // updating the gradient entries of the library, so functions with a
+  // registered gradient keep their own calls.
+  absl::flat_hash_set<string> functions_with_gradient;
+  for (const GradientDef& gradient : library.gradient()) {
+    functions_with_gradient.insert(gradient.function_name());
+  }
+
+  FunctionLibraryDefinition flib(OpRegistry::Global(), library);
+  absl::flat_hash_map<string, bool> free_of_side_effect;
+  std::vector<const FunctionDef*> functions;
+  for (const FunctionDef& func : library.function()) {
+    const string& func_name = func.signature().name();
+    if (IsFunctionFreeOfSideEffect(func_name, flib, &free_of_side_effect)) {
+      dedupable_function_sizes_[func_name] = func.node_def_size();
+      if (!functions_with_gradient.contains(func_name)) {
+        functions.push_back(&func);
+      }
+    }
+  }
+  if (dedupable_function_sizes_.empty()) return Status::OK();
+
+  // Among the functions with the same body, the one with the smallest name
+  // represents all the others. The bodies are compared without the function
+  // names, so that separately traced copies of the same computation match.
+  std::sort(functions.begin(), functions.end(),
+            [](const FunctionDef* a, const FunctionDef* b) {
+              return a->signature().name() < b->signature().name();
+            });
+  absl::flat_hash_map<uint64, std::vector<std::pair<string, FunctionDef>>>
+      bodies;
+  absl::flat_hash_map<string, string> representatives;
+  for (const FunctionDef* func : functions) {
+    FunctionDef body = *func;
+    body.mutable_signature()->clear_name();
+    std::vector<std::pair<string, FunctionDef>>& candidates =
+        bodies[FunctionDefHash(body)];
+    auto it = std::find_if(
+        candidates.begin(), candidates.end(),
+        [&body](const std::pair<string, FunctionDef>& candidate) {
+          return FunctionDefsEqual(candidate.second, body);
+        });
+    if (it == candidates.end()) {
+      candidates.emplace_back(func->signature().name(), std::move(body));
+    } else {
+      representatives[func->signature().name()] = it->first;
+    }
+  }
+
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    string* func_name = nullptr;
+    const bool is_stateful_call = IsStatefulPartitionedCall(node);
+    if (IsPartitionedCall(node) || is_stateful_call) {
+      auto it = node.mutable_attr()->find(kFuncAttr);
+      if (it == node.mutable_attr()->end() || !it->second.has_func()) continue;
+      func_name = it->second.mutable_func()->mutable_name();
+    } else {
+      func_name = node.mutable_op();
+    }
+    if (!dedupable_function_sizes_.contains(*func_name)) continue;
+    auto it = representatives.find(*func_name);
+    if (!is_stateful_call && it == representatives.end()) continue;
+
+    // The call is only rewritten for the duration of DedupComputations, and
+    // RestoreFunctionCalls reverts the calls which are not dedupped.
+    original_calls_[node.name()] = {node.op(), *func_name};
+    if (is_stateful_call) {
+      // Both ops have the same attributes, and calling a function free of
+      // side effects is free of side effects.
+      node.set_op("PartitionedCall");
+    }
+    if (it != representatives.end()) {
+      VLOG(2) << "Redirect call " << node.name() << " from " << *func_name
+              << " to the identical function " << it->second;
+      *func_name = it->second;
+    }
+  }
+  return Status::OK();
+}
+
+void CommonSubgraphElimination::RestoreFunctionCalls(
+    GraphDef* optimized_graph) {
+  if (original_calls_.empty()) return;
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    auto it = original_calls_.find(node.name());
+    if (it == original_calls_.end()) continue;
+    const string& original_op = it->second.first;
+    const string& original_func = it->second.second;
+    node.set_op(original_op);
+    if (original_op != original_func) {
+      // A (Stateful)PartitionedCall rather than a direct call.
+      (*node.mutable_attr())[kFuncAttr].mutable_func()->set_name(
+          original_func);
+    }
+  }
+  original_calls_.clear();
+}
+
 Status CommonSubgraphElimination::DedupComputations(GraphDef* optimized_graph) {
   CanonicalizeGraph(optimized_graph);
 
@@ -202,6 +369,8 @@ Status CommonSubgraphElimination::DedupComputations(GraphDef* optimized_graph) {
                    CanDedup(node);
   }
 
+  int num_dedupped_calls = 0;
+  int num_dedupped_function_nodes = 0;
   bool stop = true;
   std::set<int> duplicates;
   UniqueNodes nodes;
@@ -251,6 +420,10 @@ Status CommonSubgraphElimination::DedupComputations(GraphDef* optimized_graph) {
           CanonicalizeNode(fanout);
         }
       }
+      if (const string* func_name = FindDedupableFunction(*node)) {
+        ++num_dedupped_calls;
+        num_dedupped_function_nodes += dedupable_function_sizes_.at(*func_name);
+      }
       if (fetch_nodes_known_) {
         node->Clear();
       }
@@ -259,6 +432,12 @@ Status CommonSubgraphElimination::DedupComputations(GraphDef* optimized_graph) {
     }
   } while (!stop);
 
+  if (num_dedupped_calls > 0) {
+    VLOG(1) << "Dedupped " << num_dedupped_calls << " function calls, "
+            << num_dedupped_function_nodes
+            << " function body nodes are no longer computed.";
+  }
+
   // Delete duplicates
   if (fetch_nodes_known_ && !duplicates.empty()) {
     EraseNodesFromGraph(duplicates, optimized_graph);
@@ -275,12 +454,16 @@ Status CommonSubgraphElimination::Optimize(Cluster* /*cluster*/,
   fetch_nodes_known_ = !item.fetch.empty();
   *optimized_graph = item.graph;
 
+  TF_RETURN_IF_ERROR(CanonicalizeFunctionCalls(optimized_graph));
+
   // Perform topological sort on the graph in order to help DedupComputations
   // optimize larger subgraphs starting from the roots with more inputs.
   TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
   GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
 
-  return DedupComputations(optimized_graph);
+  TF_RETURN_IF_ERROR(DedupComputations(optimized_graph));
+  RestoreFunctionCalls(optimized_graph);
+  return Status::OK();
 }
 
 void CommonSubgraphElimination::Feedback(Cluster* /*cluster*/,
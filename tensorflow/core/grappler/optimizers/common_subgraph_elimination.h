@@ -17,7 +17,9 @@ limitations under the License.
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_COMMON_SUBGRAPH_ELIMINATION_H_
 
 #include <unordered_set>
+#include <utility>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
@@ -44,7 +46,7 @@ class CommonSubgraphElimination : public GraphOptimizer {
 
   string name() const override { return "common_subgraph_elimination"; };
 
-  bool UsesFunctionLibrary() const override { return false; }
+  bool UsesFunctionLibrary() const override { return true; }
 
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* optimized_graph) override;
@@ -58,6 +60,20 @@ class CommonSubgraphElimination : public GraphOptimizer {
   // Returns true if it is safe to dedup node from the graph.
   bool CanDedup(const NodeDef& node) const;
 
+  // Returns the function called by `node`, or nullptr if `node` is not a call
+  // to a function that is free of side effects.
+  const string* FindDedupableFunction(const NodeDef& node) const;
+
+  // Redirects the calls to functions that are free of side effects and have
+  // the same body to a single representative function, so that the calls
+  // with the same inputs can be dedupped by DedupComputations. Functions with
+  // a registered gradient are not redirected.
+  Status CanonicalizeFunctionCalls(GraphDef* optimized_graph);
+
+  // Reverts the calls rewritten by CanonicalizeFunctionCalls which remain in
+  // the graph, so that only the dedupped calls change the graph.
+  void RestoreFunctionCalls(GraphDef* optimized_graph);
+
   // Dedup redundant nodes in the graph.
   Status DedupComputations(GraphDef* optimized_graph);
 
@@ -65,6 +81,12 @@ class CommonSubgraphElimination : public GraphOptimizer {
 
   bool fetch_nodes_known_ = false;
   std::unordered_set<string> nodes_to_preserve_;
+  // Number of nodes in the body of each function of the library that is free
+  // of side effects.
+  absl::flat_hash_map<string, int> dedupable_function_sizes_;
+  // The op and function of the calls rewritten by CanonicalizeFunctionCalls,
+  // by node name.
+  absl::flat_hash_map<string, std::pair<string, string>> original_calls_;
 };
 
 }  // end namespace grappler
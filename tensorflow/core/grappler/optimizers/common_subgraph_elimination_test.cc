@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/array_ops.h"
 #include "tensorflow/cc/ops/math_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -174,5 +175,175 @@ TEST_F(CommonSubgraphEliminationTest, OpDedupCommutative) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(CommonSubgraphEliminationTest, DedupCallsToIdenticalFunctions) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  // Two towers traced separately into functions with the same body.
+  const auto make_tower = [](const string& name) {
+    return FDH::Create(name, {"x:float", "y:float"}, {"z:float"}, {},
+                       {{{"mul"}, "Mul", {"x", "y"}, {{"T", DT_FLOAT}}},
+                        {{"relu"}, "Relu", {"mul:z:0"}, {{"T", DT_FLOAT}}}},
+                       {{"z", "relu:activations:0"}});
+  };
+  const auto call = [](const string& name, const string& op,
+                       const string& func) {
+    return NDef(name, op, {"a", "b"},
+                {{"Tin", DataTypeSlice{DT_FLOAT, DT_FLOAT}},
+                 {"Tout", DataTypeSlice{DT_FLOAT}},
+                 {"f", FDH::FunctionRef(func)}});
+  };
+
+  GrapplerItem item;
+  item.fetch = {"out"};
+  item.graph = test::function::GDef(
+      {NDef("a", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("b", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("direct1", "Tower1", {"a", "b"}, {}),
+       NDef("direct2", "Tower2", {"a", "b"}, {}),
+       call("indirect1", "StatefulPartitionedCall", "Tower2"),
+       call("indirect2", "PartitionedCall", "Tower1"),
+       NDef("add1", "Add", {"direct1", "direct2"}, {{"T", DT_FLOAT}}),
+       NDef("add2", "Add", {"indirect1", "indirect2"}, {{"T", DT_FLOAT}}),
+       NDef("out", "Add", {"add1", "add2"}, {{"T", DT_FLOAT}})},
+      {make_tower("Tower1"), make_tower("Tower2")});
+
+  Tensor a = test::AsTensor<float>({1.0f, -2.0f, 3.0f});
+  Tensor b = test::AsTensor<float>({4.0f, 5.0f, -6.0f});
+  auto tensors_expected =
+      EvaluateNodes(item.graph, item.fetch, {{"a", a}, {"b", b}});
+  ASSERT_EQ(tensors_expected.size(), 1);
+
+  CommonSubgraphElimination optimizer;
+  GraphDef output;
+  OptimizeTwice(&optimizer, &item, &output);
+  NodeMap node_map(&output);
+
+  EXPECT_EQ(output.node_size(), 7);
+  EXPECT_EQ(node_map.GetNode("direct2"), nullptr);
+  EXPECT_EQ(node_map.GetNode("indirect2"), nullptr);
+
+  const NodeDef* direct1 = node_map.GetNode("direct1");
+  ASSERT_NE(direct1, nullptr);
+  EXPECT_EQ(direct1->op(), "Tower1");
+  // The remaining calls are not rewritten.
+  const NodeDef* indirect1 = node_map.GetNode("indirect1");
+  ASSERT_NE(indirect1, nullptr);
+  EXPECT_EQ(indirect1->op(), "StatefulPartitionedCall");
+  EXPECT_EQ(indirect1->attr().at("f").func().name(), "Tower2");
+
+  const NodeDef* add1 = node_map.GetNode("add1");
+  ASSERT_NE(add1, nullptr);
+  ASSERT_EQ(add1->input_size(), 2);
+  EXPECT_EQ(add1->input(0), "direct1");
+  EXPECT_EQ(add1->input(1), "direct1");
+  const NodeDef* add2 = node_map.GetNode("add2");
+  ASSERT_NE(add2, nullptr);
+  ASSERT_EQ(add2->input_size(), 2);
+  EXPECT_EQ(add2->input(0), "indirect1");
+  EXPECT_EQ(add2->input(1), "indirect1");
+
+  auto tensors = EvaluateNodes(output, item.fetch, {{"a", a}, {"b", b}});
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(CommonSubgraphEliminationTest, KeepCallsWhichAreNotDedupped) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  FunctionDef square =
+      FDH::Create("Square", {"x:float"}, {"y:float"}, {},
+                  {{{"mul"}, "Mul", {"x", "x"}, {{"T", DT_FLOAT}}}},
+                  {{"y", "mul:z:0"}});
+
+  GrapplerItem item;
+  item.fetch = {"out"};
+  item.graph = test::function::GDef(
+      {NDef("a", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("b", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("call1", "StatefulPartitionedCall", {"a"},
+            {{"Tin", DataTypeSlice{DT_FLOAT}},
+             {"Tout", DataTypeSlice{DT_FLOAT}},
+             {"f", FDH::FunctionRef("Square")}}),
+       NDef("call2", "StatefulPartitionedCall", {"b"},
+            {{"Tin", DataTypeSlice{DT_FLOAT}},
+             {"Tout", DataTypeSlice{DT_FLOAT}},
+             {"f", FDH::FunctionRef("Square")}}),
+       NDef("out", "Add", {"call1", "call2"}, {{"T", DT_FLOAT}})},
+      {square});
+
+  CommonSubgraphElimination optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  VerifyGraphsMatch(item.graph, output, __LINE__);
+  for (const NodeDef& node : output.node()) {
+    if (node.op() == "StatefulPartitionedCall") {
+      EXPECT_EQ(node.attr().at("f").func().name(), "Square");
+    }
+  }
+}
+
+TEST_F(CommonSubgraphEliminationTest, KeepCallsToFunctionsWithGradient) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  const auto make_tower = [](const string& name) {
+    return FDH::Create(name, {"x:float", "y:float"}, {"z:float"}, {},
+                       {{{"mul"}, "Mul", {"x", "y"}, {{"T", DT_FLOAT}}}},
+                       {{"z", "mul:z:0"}});
+  };
+
+  GrapplerItem item;
+  item.fetch = {"out"};
+  item.graph = test::function::GDef(
+      {NDef("a", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("b", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("call1", "Tower1", {"a", "b"}, {}),
+       NDef("call2", "Tower2", {"a", "b"}, {}),
+       NDef("out", "Add", {"call1", "call2"}, {{"T", DT_FLOAT}})},
+      {make_tower("Tower1"), make_tower("Tower2"), make_tower("Tower2Grad")});
+  GradientDef* gradient = item.graph.mutable_library()->add_gradient();
+  gradient->set_function_name("Tower2");
+  gradient->set_gradient_func("Tower2Grad");
+
+  CommonSubgraphElimination optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  VerifyGraphsMatch(item.graph, output, __LINE__);
+}
+
+TEST_F(CommonSubgraphEliminationTest, KeepCallsToFunctionsWithSideEffects) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  const auto make_random = [](const string& name) {
+    return FDH::Create(
+        name, {"shape:int32"}, {"z:float"}, {},
+        {{{"random"},
+          "RandomUniform",
+          {"shape"},
+          {{"T", DT_INT32}, {"dtype", DT_FLOAT}}}},
+        {{"z", "random:output:0"}});
+  };
+
+  GrapplerItem item;
+  item.fetch = {"out"};
+  item.graph = test::function::GDef(
+      {NDef("shape", "Const", {},
+            {{"dtype", DT_INT32}, {"value", test::AsTensor<int32>({2})}}),
+       NDef("random1", "Random1", {"shape"}, {}),
+       NDef("random2", "Random2", {"shape"}, {}),
+       NDef("random3", "Random1", {"shape"}, {}),
+       NDef("out", "AddN", {"random1", "random2", "random3"},
+            {{"N", 3}, {"T", DT_FLOAT}})},
+      {make_random("Random1"), make_random("Random2")});
+
+  CommonSubgraphElimination optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  VerifyGraphsMatch(item.graph, output, __LINE__);
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
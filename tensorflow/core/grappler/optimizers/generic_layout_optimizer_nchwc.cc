@@ -0,0 +1,398 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_nchwc.h"
+
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/cpu_info.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+constexpr char kToNCHWc[] = "_ToNCHWc";
+constexpr char kFromNCHWc[] = "_FromNCHWc";
+constexpr char kNCHWcSuffix[] = "/NCHWc";
+
+bool IsOnCpuOrUnassigned(const NodeDef& node) {
+  return node.device().empty() || NodeIsOnCpu(&node);
+}
+
+bool HasFloatType(const NodeDef& node) {
+  const AttrValue* type = AttrSlice(node).Find("T");
+  return type != nullptr && type->type() == DT_FLOAT;
+}
+
+bool HasNHWCDataFormat(const NodeDef& node) {
+  const AttrValue* data_format = AttrSlice(node).Find("data_format");
+  return data_format == nullptr || data_format->s() == "NHWC";
+}
+
+bool HasSamePaddingOrValidPadding(const NodeDef& node) {
+  const AttrValue* padding = AttrSlice(node).Find("padding");
+  return padding != nullptr &&
+         (padding->s() == "SAME" || padding->s() == "VALID");
+}
+
+// Returns true if the list attribute `attr_name` is of the form [1, h, w, 1].
+bool IsSpatialWindowAttr(const NodeDef& node, const string& attr_name) {
+  const AttrValue* attr = AttrSlice(node).Find(attr_name);
+  if (attr == nullptr) return false;
+  const auto& values = attr->list().i();
+  return values.size() == 4 && values[0] == 1 && values[3] == 1;
+}
+
+bool HasUnitDilations(const NodeDef& node) {
+  const AttrValue* dilations = AttrSlice(node).Find("dilations");
+  if (dilations == nullptr) return true;
+  for (int64 dilation : dilations->list().i()) {
+    if (dilation != 1) return false;
+  }
+  return true;
+}
+
+bool IsPool(const NodeDef& node) {
+  return node.op() == "MaxPool" || node.op() == "AvgPool";
+}
+
+// Element-wise ops that can consume and produce blocked tensors as is.
+bool IsLayoutAgnosticUnaryOp(const NodeDef& node) {
+  return IsRelu(node) || IsRelu6(node) || IsElu(node) || IsTanh(node) ||
+         IsIdentity(node) || node.op() == "Sigmoid";
+}
+
+// Element-wise ops that can consume blocked tensors if all their data inputs
+// are blocked (broadcasting along N, H and W is still valid in NCHWc).
+bool IsLayoutAgnosticBinaryOp(const NodeDef& node) {
+  return IsAdd(node) || IsSub(node) || IsMul(node) || IsMaximum(node) ||
+         IsMinimum(node);
+}
+
+class NCHWcConverter {
+ public:
+  NCHWcConverter(const std::unordered_set<string>& nodes_to_preserve,
+                 int block_size, GraphDef* graph)
+      : nodes_to_preserve_(nodes_to_preserve),
+        block_size_(block_size),
+        graph_(graph) {}
+
+  Status Run() {
+    const int num_nodes = graph_->node_size();
+    for (int i = 0; i < num_nodes; ++i) {
+      NodeDef* node = graph_->mutable_node(i);
+      nodes_[node->name()] = node;
+      for (const string& input : node->input()) {
+        consumers_[NodeName(input)].push_back(node);
+      }
+    }
+
+    int num_converted = 0;
+    for (int i = 0; i < num_nodes; ++i) {
+      NodeDef* node = graph_->mutable_node(i);
+      if (nodes_to_delete_.count(node->name()) > 0 ||
+          !IsOnCpuOrUnassigned(*node) || !HasFloatType(*node)) {
+        continue;
+      }
+      if (ConvertConv2D(node) || ConvertPool(node) ||
+          ConvertElementWise(node)) {
+        ++num_converted;
+      }
+    }
+    if (num_converted == 0) return Status::OK();
+    VLOG(1) << "Converted " << num_converted << " nodes to NCHWc with block "
+            << "size " << block_size_;
+
+    RemoveUnusedNodes();
+    return TopologicalSort(graph_);
+  }
+
+ private:
+  bool IsPreserved(const NodeDef& node) const {
+    return nodes_to_preserve_.count(node.name()) > 0;
+  }
+
+  NodeDef* GetNode(const string& input) const {
+    auto it = nodes_.find(NodeName(input));
+    return it == nodes_.end() ? nullptr : it->second;
+  }
+
+  // Returns the node consuming `node` if it is the only reference to `node`
+  // and it reads it as its first input.
+  NodeDef* GetSoleConsumer(const NodeDef& node) const {
+    auto it = consumers_.find(node.name());
+    if (it == consumers_.end() || it->second.size() != 1) return nullptr;
+    NodeDef* consumer = it->second.front();
+    if (consumer->input_size() == 0 || consumer->input(0) != node.name() ||
+        !IsOnCpuOrUnassigned(*consumer) || !HasFloatType(*consumer)) {
+      return nullptr;
+    }
+    return consumer;
+  }
+
+  // Returns the blocked tensor that `input` was converted from, or an empty
+  // string if `input` is not produced by a _FromNCHWc node.
+  string GetBlockedInput(const string& input) const {
+    if (IsControlInput(input) || NodePosition(input) != 0) return "";
+    const NodeDef* producer = GetNode(input);
+    if (producer == nullptr || producer->op() != kFromNCHWc) return "";
+    return producer->input(0);
+  }
+
+  // Returns a blocked version of the NHWC tensor `input`, adding a _ToNCHWc
+  // node if there is none yet.
+  string GetOrAddToNCHWc(const string& input, const NodeDef& consumer) {
+    const string blocked = GetBlockedInput(input);
+    if (!blocked.empty()) return blocked;
+
+    auto it = to_nchwc_.find(input);
+    if (it != to_nchwc_.end()) return it->second;
+
+    string name = NodeName(input);
+    const int position = NodePosition(input);
+    if (position > 0) absl::StrAppend(&name, "_", position);
+    NodeDef* to_nchwc = AddNode(AddPrefixToNodeName("ToNCHWc", name),
+                                kToNCHWc, consumer.device());
+    to_nchwc->add_input(input);
+    SetAttrValue(DT_FLOAT, &(*to_nchwc->mutable_attr())["T"]);
+    SetAttrValue(block_size_, &(*to_nchwc->mutable_attr())["block_size"]);
+    to_nchwc_[input] = to_nchwc->name();
+    return to_nchwc->name();
+  }
+
+  // Returns `name`, with a suffix if a node of the graph already has it.
+  string UniqueNodeName(const string& name) {
+    string unique_name = name;
+    while (nodes_.contains(unique_name)) {
+      unique_name = absl::StrCat(name, "_unique", unique_name_counter_++);
+    }
+    return unique_name;
+  }
+
+  // Adds a node named `name`, or a unique variation of it if the name is
+  // taken.
+  NodeDef* AddNode(const string& name, const string& op,
+                   const string& device) {
+    NodeDef* node = graph_->add_node();
+    node->set_name(UniqueNodeName(name));
+    node->set_op(op);
+    node->set_device(device);
+    nodes_[node->name()] = node;
+    return node;
+  }
+
+  // Turns `node` into a conversion of `blocked` back to NHWC. The node keeps
+  // its name, so its consumers don't need to be updated.
+  void ReplaceWithFromNCHWc(NodeDef* node, const string& blocked) {
+    node->set_op(kFromNCHWc);
+    node->clear_input();
+    node->add_input(blocked);
+    node->clear_attr();
+    SetAttrValue(DT_FLOAT, &(*node->mutable_attr())["T"]);
+  }
+
+  bool ConvertConv2D(NodeDef* conv) {
+    if (!IsConv2D(*conv) || !HasNHWCDataFormat(*conv) ||
+        !HasSamePaddingOrValidPadding(*conv) ||
+        !IsSpatialWindowAttr(*conv, "strides") || !HasUnitDilations(*conv)) {
+      return false;
+    }
+    const NodeDef* filter = GetNode(conv->input(1));
+    if (filter == nullptr || !IsConstant(*filter) ||
+        NodePosition(conv->input(1)) != 0) {
+      return false;
+    }
+    const AttrValue* value = AttrSlice(*filter).Find("value");
+    if (value == nullptr) return false;
+    const TensorShapeProto& filter_shape = value->tensor().tensor_shape();
+    if (filter_shape.dim_size() != 4) return false;
+    const int64 in_depth = filter_shape.dim(2).size();
+    const int64 out_depth = filter_shape.dim(3).size();
+    if (in_depth <= 0 || out_depth <= 0 || in_depth % block_size_ != 0 ||
+        out_depth % block_size_ != 0) {
+      return false;
+    }
+
+    // Fuse a following BiasAdd and activation into the blocked convolution.
+    std::vector<NodeDef*> fused_nodes = {conv};
+    std::vector<string> fused_ops;
+    string bias;
+    NodeDef* bias_add = IsPreserved(*conv) ? nullptr : GetSoleConsumer(*conv);
+    if (bias_add != nullptr && IsBiasAdd(*bias_add) &&
+        HasNHWCDataFormat(*bias_add)) {
+      fused_nodes.push_back(bias_add);
+      fused_ops.push_back("BiasAdd");
+      bias = bias_add->input(1);
+      NodeDef* activation =
+          IsPreserved(*bias_add) ? nullptr : GetSoleConsumer(*bias_add);
+      if (activation != nullptr && (IsRelu(*activation) ||
+                                    IsRelu6(*activation))) {
+        fused_nodes.push_back(activation);
+        fused_ops.push_back(activation->op());
+      }
+    }
+    NodeDef* last = fused_nodes.back();
+
+    NodeDef* blocked = AddNode(absl::StrCat(last->name(), kNCHWcSuffix),
+                               "_NCHWcConv2D", conv->device());
+    blocked->add_input(GetOrAddToNCHWc(conv->input(0), *conv));
+    blocked->add_input(conv->input(1));
+    if (!bias.empty()) blocked->add_input(bias);
+    for (const NodeDef* fused : fused_nodes) {
+      for (const string& input : fused->input()) {
+        if (IsControlInput(input)) blocked->add_input(input);
+      }
+    }
+    auto* attr = blocked->mutable_attr();
+    SetAttrValue(DT_FLOAT, &(*attr)["T"]);
+    SetAttrValue(bias.empty() ? 0 : 1, &(*attr)["num_args"]);
+    (*attr)["strides"] = conv->attr().at("strides");
+    (*attr)["padding"] = conv->attr().at("padding");
+    SetAttrValue(fused_ops, &(*attr)["fused_ops"]);
+
+    for (const NodeDef* fused : fused_nodes) {
+      if (fused != last) nodes_to_delete_.insert(fused->name());
+    }
+    ReplaceWithFromNCHWc(last, blocked->name());
+    return true;
+  }
+
+  bool ConvertPool(NodeDef* pool) {
+    if (!IsPool(*pool) || !HasNHWCDataFormat(*pool) ||
+        !HasSamePaddingOrValidPadding(*pool) ||
+        !IsSpatialWindowAttr(*pool, "ksize") ||
+        !IsSpatialWindowAttr(*pool, "strides")) {
+      return false;
+    }
+    // Pooling alone is not worth a layout conversion.
+    const string input = GetBlockedInput(pool->input(0));
+    if (input.empty()) return false;
+
+    NodeDef* blocked = AddNode(
+        absl::StrCat(pool->name(), kNCHWcSuffix),
+        pool->op() == "MaxPool" ? "_NCHWcMaxPool" : "_NCHWcAvgPool",
+        pool->device());
+    blocked->add_input(input);
+    for (int i = 1; i < pool->input_size(); ++i) {
+      blocked->add_input(pool->input(i));
+    }
+    auto* attr = blocked->mutable_attr();
+    SetAttrValue(DT_FLOAT, &(*attr)["T"]);
+    (*attr)["ksize"] = pool->attr().at("ksize");
+    (*attr)["strides"] = pool->attr().at("strides");
+    (*attr)["padding"] = pool->attr().at("padding");
+    ReplaceWithFromNCHWc(pool, blocked->name());
+    return true;
+  }
+
+  bool ConvertElementWise(NodeDef* node) {
+    const int num_data_inputs = IsLayoutAgnosticUnaryOp(*node)    ? 1
+                                : IsLayoutAgnosticBinaryOp(*node) ? 2
+                                                                  : 0;
+    if (num_data_inputs == 0 || node->input_size() < num_data_inputs) {
+      return false;
+    }
+    std::vector<string> blocked_inputs;
+    for (int i = 0; i < num_data_inputs; ++i) {
+      blocked_inputs.push_back(GetBlockedInput(node->input(i)));
+      if (blocked_inputs.back().empty()) return false;
+    }
+
+    NodeDef* blocked = AddNode(absl::StrCat(node->name(), kNCHWcSuffix),
+                               node->op(), node->device());
+    for (const string& input : blocked_inputs) blocked->add_input(input);
+    for (int i = num_data_inputs; i < node->input_size(); ++i) {
+      blocked->add_input(node->input(i));
+    }
+    *blocked->mutable_attr() = node->attr();
+    // The inferred shapes are those of the NHWC tensors.
+    blocked->mutable_attr()->erase("_output_shapes");
+    ReplaceWithFromNCHWc(node, blocked->name());
+    return true;
+  }
+
+  // Removes the nodes fused into blocked convolutions, and the _FromNCHWc
+  // nodes whose consumers were all converted.
+  void RemoveUnusedNodes() {
+    absl::flat_hash_map<string, int> num_consumers;
+    for (const NodeDef& node : graph_->node()) {
+      if (nodes_to_delete_.count(node.name()) > 0) continue;
+      for (const string& input : node.input()) {
+        ++num_consumers[NodeName(input)];
+      }
+    }
+    std::set<int> nodes_to_delete;
+    for (int i = 0; i < graph_->node_size(); ++i) {
+      const NodeDef& node = graph_->node(i);
+      if (nodes_to_delete_.count(node.name()) > 0 ||
+          (node.op() == kFromNCHWc && !IsPreserved(node) &&
+           num_consumers[node.name()] == 0)) {
+        nodes_to_delete.insert(i);
+      }
+    }
+    EraseNodesFromGraph(nodes_to_delete, graph_);
+  }
+
+  const std::unordered_set<string>& nodes_to_preserve_;
+  const int block_size_;
+  GraphDef* graph_;
+  absl::flat_hash_map<string, NodeDef*> nodes_;
+  absl::flat_hash_map<string, std::vector<NodeDef*>> consumers_;
+  // The _ToNCHWc nodes added for each NHWC tensor.
+  absl::flat_hash_map<string, string> to_nchwc_;
+  std::unordered_set<string> nodes_to_delete_;
+  int64 unique_name_counter_ = 0;
+};
+
+}  // namespace
+
+int NCHWcBlockSize() {
+  return port::TestCPUFeature(port::CPUFeature::AVX512F) ? 16 : 8;
+}
+
+Status ConvertNHWCToNCHWc(const std::unordered_set<string>& nodes_to_preserve,
+                          int block_size, GraphDef* graph) {
+  if (block_size <= 0) {
+    return errors::InvalidArgument("Invalid NCHWc block size: ", block_size);
+  }
+  // The conversion relies on visiting producers before their consumers.
+  Status sorted = TopologicalSort(graph);
+  if (!sorted.ok()) {
+    VLOG(1) << "Skipping NCHWc conversion: " << sorted.error_message();
+    return Status::OK();
+  }
+  NCHWcConverter converter(nodes_to_preserve, block_size, graph);
+  return converter.Run();
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
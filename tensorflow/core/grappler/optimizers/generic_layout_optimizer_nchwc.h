@@ -0,0 +1,50 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_GENERIC_LAYOUT_OPTIMIZER_NCHWC_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_GENERIC_LAYOUT_OPTIMIZER_NCHWC_H_
+
+#include <unordered_set>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Returns the channel block size of the NCHWc layout for this host: the number
+// of float lanes of the widest SIMD registers available.
+int NCHWcBlockSize();
+
+// Rewrites the float NHWC convolution stacks of `graph` into the channel-
+// blocked NCHWc ops (_NCHWcConv2D, _NCHWcMaxPool, ...), so that consecutive
+// layers exchange blocked tensors and layout conversions only remain at the
+// boundaries of the stack.
+//
+// Conv2D nodes with a constant filter whose input and output depths are
+// multiples of `block_size` are converted, together with a following BiasAdd
+// and Relu/Relu6. Pooling and element-wise ops are converted when their inputs
+// are already blocked. Every converted node `X` is replaced by a _FromNCHWc
+// node of the same name reading from the blocked `X/NCHWc`, so consumers that
+// were not converted, fetches and `nodes_to_preserve` keep seeing an NHWC
+// tensor. Unused _FromNCHWc nodes are removed.
+Status ConvertNHWCToNCHWc(const std::unordered_set<string>& nodes_to_preserve,
+                          int block_size, GraphDef* graph);
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_GENERIC_LAYOUT_OPTIMIZER_NCHWC_H_
@@ -0,0 +1,230 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_nchwc.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr int kBlockSize = 8;
+
+class NCHWcConversionTest : public GrapplerTest {
+ protected:
+  Output RandomConst(const Scope& scope, const TensorShape& shape) {
+    return ops::Const(
+        scope, Input::Initializer(GenerateRandomTensor<DT_FLOAT>(shape)));
+  }
+};
+
+TEST_F(NCHWcConversionTest, ConvertsConvStack) {
+  Scope s = Scope::NewRootScope().WithDevice("/device:CPU:0");
+
+  auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT,
+                                ops::Placeholder::Shape({2, 12, 12, 8}));
+  auto conv1 = ops::Conv2D(s.WithOpName("conv1"), input,
+                           RandomConst(s.WithOpName("filter1"), {3, 3, 8, 16}),
+                           {1, 1, 1, 1}, "SAME");
+  auto bias1 = ops::BiasAdd(s.WithOpName("bias1"), conv1,
+                            RandomConst(s.WithOpName("bias1_value"), {16}));
+  auto relu1 = ops::Relu(s.WithOpName("relu1"), bias1);
+  auto pool = ops::MaxPool(s.WithOpName("pool"), relu1, {1, 2, 2, 1},
+                           {1, 2, 2, 1}, "VALID");
+  auto conv2 = ops::Conv2D(s.WithOpName("conv2"), pool,
+                           RandomConst(s.WithOpName("filter2"), {3, 3, 16, 16}),
+                           {1, 1, 1, 1}, "SAME");
+  auto bias2 = ops::BiasAdd(s.WithOpName("bias2"), conv2,
+                            RandomConst(s.WithOpName("bias2_value"), {16}));
+  auto add = ops::Add(s.WithOpName("add"), bias2, pool);
+  auto output = ops::Identity(s.WithOpName("output"), add);
+
+  GrapplerItem item;
+  item.fetch = {"output"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GraphDef converted = item.graph;
+  TF_ASSERT_OK(
+      ConvertNHWCToNCHWc(item.NodesToPreserve(), kBlockSize, &converted));
+
+  // The whole stack runs blocked, with a single conversion at each boundary.
+  EXPECT_EQ(CountOpNodes(converted, "_ToNCHWc"), 1);
+  EXPECT_EQ(CountOpNodes(converted, "_FromNCHWc"), 1);
+  EXPECT_EQ(CountOpNodes(converted, "_NCHWcConv2D"), 2);
+  EXPECT_EQ(CountOpNodes(converted, "_NCHWcMaxPool"), 1);
+  EXPECT_EQ(CountOpNodes(converted, "Conv2D"), 0);
+  EXPECT_EQ(CountOpNodes(converted, "BiasAdd"), 0);
+  EXPECT_EQ(CountOpNodes(converted, "Relu"), 0);
+  EXPECT_EQ(CountOpNodes(converted, "MaxPool"), 0);
+
+  int found = 0;
+  for (const NodeDef& node : converted.node()) {
+    if (node.name() == "relu1/NCHWc") {
+      ++found;
+      EXPECT_EQ(node.op(), "_NCHWcConv2D");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "input/ToNCHWc");
+      EXPECT_EQ(node.input(1), "filter1");
+      EXPECT_EQ(node.input(2), "bias1_value");
+      const auto& fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 2);
+      EXPECT_EQ(fused_ops[0], "BiasAdd");
+      EXPECT_EQ(fused_ops[1], "Relu");
+    } else if (node.name() == "add/NCHWc") {
+      ++found;
+      EXPECT_EQ(node.op(), "Add");
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "bias2/NCHWc");
+      EXPECT_EQ(node.input(1), "pool/NCHWc");
+    } else if (node.name() == "output") {
+      ++found;
+      EXPECT_EQ(node.op(), "_FromNCHWc");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "output/NCHWc");
+    }
+  }
+  EXPECT_EQ(found, 3);
+
+  auto input_tensor = GenerateRandomTensor<DT_FLOAT>({2, 12, 12, 8});
+  auto expected =
+      EvaluateNodes(item.graph, item.fetch, {{"input", input_tensor}});
+  auto actual = EvaluateNodes(converted, item.fetch, {{"input", input_tensor}});
+  ASSERT_EQ(expected.size(), 1);
+  ASSERT_EQ(actual.size(), 1);
+  test::ExpectTensorNear<float>(expected[0], actual[0], 1e-4);
+}
+
+TEST_F(NCHWcConversionTest, KeepsPreservedIntermediateNodes) {
+  Scope s = Scope::NewRootScope().WithDevice("/device:CPU:0");
+
+  auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT,
+                                ops::Placeholder::Shape({1, 6, 6, 8}));
+  auto conv = ops::Conv2D(s.WithOpName("conv"), input,
+                          RandomConst(s.WithOpName("filter"), {1, 1, 8, 8}),
+                          {1, 1, 1, 1}, "VALID");
+  auto bias = ops::BiasAdd(s.WithOpName("bias"), conv,
+                           RandomConst(s.WithOpName("bias_value"), {8}));
+  auto relu = ops::Relu(s.WithOpName("relu"), bias);
+
+  GrapplerItem item;
+  item.fetch = {"bias", "relu"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GraphDef converted = item.graph;
+  TF_ASSERT_OK(
+      ConvertNHWCToNCHWc(item.NodesToPreserve(), kBlockSize, &converted));
+
+  // The Relu can't be fused since the BiasAdd output is fetched, it is
+  // converted on its own instead.
+  EXPECT_EQ(CountOpNodes(converted, "_NCHWcConv2D"), 1);
+  EXPECT_EQ(CountOpNodes(converted, "_FromNCHWc"), 2);
+  EXPECT_EQ(CountOpNodes(converted, "Relu"), 1);
+
+  auto input_tensor = GenerateRandomTensor<DT_FLOAT>({1, 6, 6, 8});
+  auto expected =
+      EvaluateNodes(item.graph, item.fetch, {{"input", input_tensor}});
+  auto actual = EvaluateNodes(converted, item.fetch, {{"input", input_tensor}});
+  ASSERT_EQ(expected.size(), 2);
+  ASSERT_EQ(actual.size(), 2);
+  for (int i = 0; i < 2; ++i) {
+    test::ExpectTensorNear<float>(expected[i], actual[i], 1e-4);
+  }
+}
+
+TEST_F(NCHWcConversionTest, SkipsConvWithUnalignedChannels) {
+  Scope s = Scope::NewRootScope().WithDevice("/device:CPU:0");
+
+  auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT,
+                                ops::Placeholder::Shape({1, 8, 8, 3}));
+  auto conv = ops::Conv2D(s.WithOpName("conv"), input,
+                          RandomConst(s.WithOpName("filter"), {3, 3, 3, 16}),
+                          {1, 1, 1, 1}, "SAME");
+  auto relu = ops::Relu(s.WithOpName("relu"), conv);
+
+  GrapplerItem item;
+  item.fetch = {"relu"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GraphDef converted = item.graph;
+  TF_ASSERT_OK(
+      ConvertNHWCToNCHWc(item.NodesToPreserve(), kBlockSize, &converted));
+  CompareGraphs(item.graph, converted);
+}
+
+TEST_F(NCHWcConversionTest, AddedNodesDontReuseExistingNames) {
+  Scope s = Scope::NewRootScope().WithDevice("/device:CPU:0");
+
+  auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT,
+                                ops::Placeholder::Shape({1, 6, 6, 8}));
+  auto taken1 = ops::Identity(s.WithOpName("input/ToNCHWc"), input);
+  auto taken2 = ops::Identity(s.WithOpName("relu/NCHWc"), input);
+  auto conv = ops::Conv2D(s.WithOpName("conv"), input,
+                          RandomConst(s.WithOpName("filter"), {1, 1, 8, 8}),
+                          {1, 1, 1, 1}, "VALID");
+  auto bias = ops::BiasAdd(s.WithOpName("bias"), conv,
+                           RandomConst(s.WithOpName("bias_value"), {8}));
+  auto relu = ops::Relu(s.WithOpName("relu"), bias);
+
+  GrapplerItem item;
+  item.fetch = {"bias", "relu", "input/ToNCHWc", "relu/NCHWc"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (NodeDef& node : *item.graph.mutable_node()) {
+    if (node.name() == "relu") {
+      TensorShapeProto shape;
+      TensorShape({1, 6, 6, 8}).AsProto(&shape);
+      SetAttrValue(std::vector<TensorShapeProto>{shape},
+                   &(*node.mutable_attr())["_output_shapes"]);
+    }
+  }
+
+  GraphDef converted = item.graph;
+  TF_ASSERT_OK(
+      ConvertNHWCToNCHWc(item.NodesToPreserve(), kBlockSize, &converted));
+
+  EXPECT_EQ(CountOpNodes(converted, "_ToNCHWc"), 1);
+  EXPECT_EQ(CountOpNodes(converted, "Identity"), 2);
+  for (const NodeDef& node : converted.node()) {
+    if (node.name() == "input/ToNCHWc" || node.name() == "relu/NCHWc") {
+      EXPECT_EQ(node.op(), "Identity");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "input");
+    } else if (node.op() == "Relu") {
+      // The blocked Relu doesn't keep the NHWC shape of the original one.
+      EXPECT_EQ(node.attr().count("_output_shapes"), 0);
+    }
+  }
+
+  auto input_tensor = GenerateRandomTensor<DT_FLOAT>({1, 6, 6, 8});
+  auto expected =
+      EvaluateNodes(item.graph, item.fetch, {{"input", input_tensor}});
+  auto actual = EvaluateNodes(converted, item.fetch, {{"input", input_tensor}});
+  ASSERT_EQ(expected.size(), 4);
+  ASSERT_EQ(actual.size(), 4);
+  for (int i = 0; i < 4; ++i) {
+    test::ExpectTensorNear<float>(expected[i], actual[i], 1e-4);
+  }
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
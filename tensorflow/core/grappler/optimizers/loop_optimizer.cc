@@ -23,10 +23,14 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/tensor.pb.h"
@@ -714,26 +718,653 @@ Status CheckForDeadFanout(const MutableGraphView& view,
   return Status::OK();
 }
 
+// Splits a FunctionDef node input of the form "node:output_arg:index" into its
+// parts. Returns false if `input` is a function argument or a control input.
+bool ParseFunctionNodeOutput(const string& input, string* node,
+                             string* output_arg, int* index) {
+  if (IsControlInput(input)) return false;
+  std::vector<string> parts = absl::StrSplit(input, ':');
+  if (parts.size() != 3) return false;
+  *node = parts[0];
+  *output_arg = parts[1];
+  return absl::SimpleAtoi(parts[2], index);
+}
+
+// Returns the name of the node referenced by a FunctionDef node input (regular
+// or control), or an empty string if `input` is a function argument.
+string FunctionInputNodeName(const string& input) {
+  if (IsControlInput(input)) return input.substr(1);
+  const size_t pos = input.find(':');
+  return pos == string::npos ? "" : input.substr(0, pos);
+}
+
+// Returns true if `node` can't fail on inputs which are valid for its type
+// constraints, so that it can be run even if the loop it comes from doesn't.
+bool CannotFail(const NodeDef& node) {
+  static const auto* const kOps = new std::unordered_set<string>{
+      "Abs",  "Cast",       "Exp",    "Identity", "Neg",       "OnesLike",
+      "Rank", "Reciprocal", "Relu",   "Rsqrt",    "Shape",     "Sigmoid",
+      "Size", "Sqrt",       "Square", "Tanh",     "ZerosLike"};
+  return kOps->count(node.op()) > 0;
+}
+
+// Optimizes functional (V2) While loops, whose condition and body are
+// functions of the graph function library:
+//
+//  (1) Loop invariant node motion: side effect free computations of the body
+//      that depend only on loop invariant arguments are hoisted in front of
+//      the loop, and their results are passed to the body as additional loop
+//      invariant arguments. Computations which can fail are only hoisted out
+//      of loops known to run at least once.
+//  (2) Partial unrolling: the body of a loop counting to a constant limit is
+//      replaced by `unroll_factor` chained copies of itself, if the trip count
+//      is a multiple of the unroll factor. This amortizes the per iteration
+//      executor overhead of loops with small bodies.
+//
+// Loop bodies and conditions are never modified in place, because they can be
+// shared with other callers: new functions are added to the library instead.
+class FunctionalWhileOptimizer {
+ public:
+  FunctionalWhileOptimizer(int unroll_factor, GraphDef* optimized_graph)
+      : unroll_factor_(unroll_factor), optimized_graph_(optimized_graph) {
+    for (const FunctionDef& func : optimized_graph_->library().function()) {
+      function_names_.insert(func.signature().name());
+    }
+    for (const NodeDef& node : optimized_graph_->node()) {
+      node_names_.insert(node.name());
+    }
+  }
+
+  Status HoistInvariantNodes(int while_node_idx);
+  Status UnrollBody(int while_node_idx);
+
+ private:
+  // Hoisting and unrolling are only done for loops with monomorphic body and
+  // condition functions, whose signatures match the While node.
+  bool IsSupportedWhile(const NodeDef& while_node, const FunctionDef** cond,
+                        const FunctionDef** body) const;
+  const FunctionDef* FindFunction(const string& name) const;
+  string UniqueFunctionName(const string& prefix);
+  string UniqueNodeName(const string& prefix);
+  // Returns the constant value of a scalar integer Const node.
+  bool GetScalarIntConst(const NodeDef& node, int64* value) const;
+  // Returns the statically known trip count of the loop, or -1 if the loop is
+  // not counting with a constant step of 1 to a constant limit.
+  int64 GetTripCount(const NodeDef& while_node, const FunctionDef& cond,
+                     const FunctionDef& body) const;
+
+  const int unroll_factor_;
+  GraphDef* optimized_graph_;  // Not owned.
+  std::unordered_set<string> function_names_;
+  std::unordered_set<string> node_names_;
+};
+
+const FunctionDef* FunctionalWhileOptimizer::FindFunction(
+    const string& name) const {
+  for (const FunctionDef& func : optimized_graph_->library().function()) {
+    if (func.signature().name() == name) return &func;
+  }
+  return nullptr;
+}
+
+string FunctionalWhileOptimizer::UniqueFunctionName(const string& prefix) {
+  string name = prefix;
+  for (int i = 1; function_names_.count(name); ++i) {
+    name = StrCat(prefix, "_", i);
+  }
+  function_names_.insert(name);
+  return name;
+}
+
+string FunctionalWhileOptimizer::UniqueNodeName(const string& prefix) {
+  string name = prefix;
+  for (int i = 1; node_names_.count(name); ++i) {
+    name = StrCat(prefix, "_", i);
+  }
+  node_names_.insert(name);
+  return name;
+}
+
+bool FunctionalWhileOptimizer::IsSupportedWhile(
+    const NodeDef& while_node, const FunctionDef** cond,
+    const FunctionDef** body) const {
+  if (!IsWhile(while_node)) return false;
+  const AttrValue* cond_attr = AttrSlice(while_node).Find("cond");
+  const AttrValue* body_attr = AttrSlice(while_node).Find("body");
+  if (cond_attr == nullptr || body_attr == nullptr) return false;
+  // Instantiation attributes would have to be substituted into the bodies.
+  if (cond_attr->func().attr_size() > 0 || body_attr->func().attr_size() > 0) {
+    return false;
+  }
+
+  *cond = FindFunction(cond_attr->func().name());
+  *body = FindFunction(body_attr->func().name());
+  if (*cond == nullptr || *body == nullptr) return false;
+  if ((*cond)->signature().attr_size() > 0 ||
+      (*body)->signature().attr_size() > 0) {
+    return false;
+  }
+
+  const int num_loop_vars = NumNonControlInputs(while_node);
+  return (*body)->signature().input_arg_size() == num_loop_vars &&
+         (*body)->signature().output_arg_size() == num_loop_vars &&
+         (*cond)->signature().input_arg_size() == num_loop_vars;
+}
+
+Status FunctionalWhileOptimizer::HoistInvariantNodes(int while_node_idx) {
+  const FunctionDef* cond;
+  const FunctionDef* body;
+  if (!IsSupportedWhile(optimized_graph_->node(while_node_idx), &cond,
+                        &body)) {
+    return Status::OK();
+  }
+  const OpDef& signature = body->signature();
+
+  // Arguments that the body returns unchanged are loop invariant.
+  std::unordered_map<string, int> invariant_args;
+  for (int i = 0; i < signature.input_arg_size(); ++i) {
+    const string& arg = signature.input_arg(i).name();
+    auto ret = body->ret().find(signature.output_arg(i).name());
+    if (ret != body->ret().end() && ret->second == arg) {
+      invariant_args.emplace(arg, i);
+    }
+  }
+  if (invariant_args.empty()) return Status::OK();
+
+  std::unordered_map<string, const NodeDef*> body_nodes;
+  for (const NodeDef& node : body->node_def()) {
+    body_nodes.emplace(node.name(), &node);
+  }
+
+  // Nodes which other nodes of the body, or the body itself, depend on
+  // through control edges must run in every iteration.
+  std::unordered_set<string> control_dependencies;
+  for (const NodeDef& node : body->node_def()) {
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) {
+        control_dependencies.insert(FunctionInputNodeName(input));
+      }
+    }
+  }
+  for (const auto& control_ret : body->control_ret()) {
+    control_dependencies.insert(control_ret.second);
+  }
+
+  // Hoisted nodes run even if the loop doesn't, so nodes which can fail are
+  // only hoisted out of loops known to run at least once.
+  const bool runs_at_least_once =
+      GetTripCount(optimized_graph_->node(while_node_idx), *cond, *body) >= 1;
+
+  // A node is invariant if it is free of side effects, and all of its inputs
+  // are either invariant arguments or outputs of invariant nodes. Nodes
+  // without inputs (constants) are trivially invariant.
+  std::unordered_set<string> invariant_nodes;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const NodeDef& node : body->node_def()) {
+      if (invariant_nodes.count(node.name())) continue;
+      if (!IsFreeOfSideEffect(node)) continue;
+      if (control_dependencies.count(node.name())) continue;
+      if (!runs_at_least_once && node.input_size() > 0 && !CannotFail(node)) {
+        continue;
+      }
+      bool is_invariant = true;
+      for (const string& input : node.input()) {
+        if (IsControlInput(input)) {
+          is_invariant = false;
+        } else if (!invariant_args.count(input) &&
+                   !invariant_nodes.count(FunctionInputNodeName(input))) {
+          is_invariant = false;
+        }
+        if (!is_invariant) break;
+      }
+      if (is_invariant) {
+        invariant_nodes.insert(node.name());
+        changed = true;
+      }
+    }
+  }
+
+  // Only hoist nodes doing actual computations, constants are copied in front
+  // of the loop only when they are used by the hoisted nodes.
+  std::vector<const NodeDef*> hoisted;
+  std::unordered_set<string> hoisted_names;
+  for (const NodeDef& node : body->node_def()) {
+    if (invariant_nodes.count(node.name()) && node.input_size() > 0) {
+      hoisted.push_back(&node);
+      hoisted_names.insert(node.name());
+    }
+  }
+  if (hoisted.empty()) return Status::OK();
+
+  // Hoisted node outputs consumed by the rest of the body become new loop
+  // invariant arguments. Hoisted nodes are never control inputs.
+  std::vector<string> escaping_outputs;
+  std::unordered_set<string> escaping_outputs_set;
+  auto add_escaping_output = [&](const string& input) {
+    if (hoisted_names.count(FunctionInputNodeName(input)) &&
+        escaping_outputs_set.insert(input).second) {
+      escaping_outputs.push_back(input);
+    }
+  };
+  for (const NodeDef& node : body->node_def()) {
+    if (hoisted_names.count(node.name())) continue;
+    for (const string& input : node.input()) {
+      if (!IsControlInput(input)) add_escaping_output(input);
+    }
+  }
+  for (const auto& ret : body->ret()) {
+    add_escaping_output(ret.second);
+  }
+  if (escaping_outputs.empty()) return Status::OK();
+
+  NodeDef* while_node = optimized_graph_->mutable_node(while_node_idx);
+  VLOG(2) << "Hoist " << hoisted.size() << " loop invariant nodes out of "
+          << while_node->op() << " " << while_node->name();
+
+  // Data and control inputs of the While node.
+  std::vector<string> loop_inputs;
+  std::vector<string> control_inputs;
+  for (const string& input : while_node->input()) {
+    if (IsControlInput(input)) {
+      control_inputs.push_back(input);
+    } else {
+      loop_inputs.push_back(input);
+    }
+  }
+
+  // Creates the hoisted nodes in front of the loop. Names of the nodes in the
+  // outer graph are recorded in `outer_names`.
+  std::unordered_map<string, string> outer_names;
+  std::vector<NodeDef> outer_nodes;
+  const string name_prefix = StrCat(while_node->name(), "/licm/");
+  auto outer_tensor = [&](const string& input, string* tensor) -> Status {
+    auto arg = invariant_args.find(input);
+    if (arg != invariant_args.end()) {
+      *tensor = loop_inputs[arg->second];
+      return Status::OK();
+    }
+    string node_name, output_arg;
+    int index;
+    if (!ParseFunctionNodeOutput(input, &node_name, &output_arg, &index)) {
+      return errors::InvalidArgument("Unexpected function input: ", input);
+    }
+    const NodeDef* node = body_nodes.at(node_name);
+    const OpDef* op_def;
+    TF_RETURN_IF_ERROR(OpRegistry::Global()->LookUpOpDef(node->op(), &op_def));
+    NameRangeMap outputs;
+    TF_RETURN_IF_ERROR(NameRangesForNode(*node, *op_def, nullptr, &outputs));
+    auto range = outputs.find(output_arg);
+    if (range == outputs.end()) {
+      return errors::InvalidArgument("Unknown output ", output_arg, " of ",
+                                     node->name());
+    }
+    *tensor = TensorIdToString({outer_names.at(node_name),
+                                range->second.first + index});
+    return Status::OK();
+  };
+
+  std::function<Status(const NodeDef&)> add_outer_node =
+      [&](const NodeDef& node) -> Status {
+    if (outer_names.count(node.name())) return Status::OK();
+    NodeDef outer_node = node;
+    outer_node.set_name(UniqueNodeName(name_prefix + node.name()));
+    if (outer_node.device().empty()) {
+      outer_node.set_device(while_node->device());
+    }
+    outer_node.clear_input();
+    for (const string& input : node.input()) {
+      const string input_node = FunctionInputNodeName(input);
+      if (!input_node.empty()) {
+        TF_RETURN_IF_ERROR(add_outer_node(*body_nodes.at(input_node)));
+      }
+      string tensor;
+      TF_RETURN_IF_ERROR(outer_tensor(input, &tensor));
+      outer_node.add_input(tensor);
+    }
+    if (node.input_size() == 0 && !loop_inputs.empty()) {
+      // Anchor constants to the loop inputs, so that they are in the same
+      // frame as the While node.
+      outer_node.add_input(AsControlDependency(NodeName(loop_inputs[0])));
+    }
+    for (const string& control_input : control_inputs) {
+      outer_node.add_input(control_input);
+    }
+    outer_names.emplace(node.name(), outer_node.name());
+    outer_nodes.push_back(std::move(outer_node));
+    return Status::OK();
+  };
+  for (const NodeDef* node : hoisted) {
+    TF_RETURN_IF_ERROR(add_outer_node(*node));
+  }
+
+  // Types and outer tensors of the new loop invariant arguments.
+  std::vector<string> new_inputs;
+  DataTypeVector new_types;
+  for (const string& output : escaping_outputs) {
+    string tensor;
+    TF_RETURN_IF_ERROR(outer_tensor(output, &tensor));
+    const TensorId tensor_id = ParseTensorName(tensor);
+    const NodeDef* node = body_nodes.at(FunctionInputNodeName(output));
+    const OpDef* op_def;
+    TF_RETURN_IF_ERROR(OpRegistry::Global()->LookUpOpDef(node->op(), &op_def));
+    DataType type;
+    TF_RETURN_IF_ERROR(
+        OutputTypeForNode(*node, *op_def, tensor_id.index(), &type));
+    new_inputs.push_back(tensor);
+    new_types.push_back(type);
+  }
+
+  // New body: hoisted nodes are removed, and their outputs are replaced with
+  // the new arguments, which are returned unchanged.
+  FunctionDef new_body = *body;
+  new_body.mutable_signature()->set_name(
+      UniqueFunctionName(StrCat(signature.name(), "_licm")));
+  std::unordered_set<string> body_names;
+  for (const auto& arg : signature.input_arg()) body_names.insert(arg.name());
+  for (const auto& arg : signature.output_arg()) body_names.insert(arg.name());
+  for (const NodeDef& node : body->node_def()) body_names.insert(node.name());
+
+  std::unordered_map<string, string> replaced_outputs;
+  for (int i = 0; i < escaping_outputs.size(); ++i) {
+    string arg_name = StrCat("licm_arg_", i);
+    while (body_names.count(arg_name)) arg_name += "_";
+    string ret_name = StrCat(arg_name, "_ret");
+    while (body_names.count(ret_name)) ret_name += "_";
+    body_names.insert(arg_name);
+    body_names.insert(ret_name);
+
+    OpDef::ArgDef* input_arg = new_body.mutable_signature()->add_input_arg();
+    input_arg->set_name(arg_name);
+    input_arg->set_type(new_types[i]);
+    OpDef::ArgDef* output_arg = new_body.mutable_signature()->add_output_arg();
+    output_arg->set_name(ret_name);
+    output_arg->set_type(new_types[i]);
+    (*new_body.mutable_ret())[ret_name] = arg_name;
+    replaced_outputs.emplace(escaping_outputs[i], arg_name);
+  }
+
+  new_body.clear_node_def();
+  for (const NodeDef& node : body->node_def()) {
+    if (hoisted_names.count(node.name())) continue;
+    NodeDef* new_node = new_body.add_node_def();
+    *new_node = node;
+    for (int i = 0; i < new_node->input_size(); ++i) {
+      auto it = replaced_outputs.find(new_node->input(i));
+      if (it != replaced_outputs.end()) new_node->set_input(i, it->second);
+    }
+  }
+  for (auto& ret : *new_body.mutable_ret()) {
+    auto it = replaced_outputs.find(ret.second);
+    if (it != replaced_outputs.end()) ret.second = it->second;
+  }
+
+  // New condition: takes the new arguments and ignores them.
+  FunctionDef new_cond = *cond;
+  new_cond.mutable_signature()->set_name(
+      UniqueFunctionName(StrCat(cond->signature().name(), "_licm")));
+  std::unordered_set<string> cond_names;
+  for (const auto& arg : cond->signature().input_arg()) {
+    cond_names.insert(arg.name());
+  }
+  for (const NodeDef& node : cond->node_def()) cond_names.insert(node.name());
+  for (int i = 0; i < new_types.size(); ++i) {
+    string arg_name = StrCat("licm_arg_", i);
+    while (cond_names.count(arg_name)) arg_name += "_";
+    cond_names.insert(arg_name);
+    OpDef::ArgDef* input_arg = new_cond.mutable_signature()->add_input_arg();
+    input_arg->set_name(arg_name);
+    input_arg->set_type(new_types[i]);
+  }
+
+  // Rewire the While node. Control inputs must stay after the data inputs.
+  const int num_loop_vars = loop_inputs.size();
+  while_node->clear_input();
+  for (const string& input : loop_inputs) while_node->add_input(input);
+  for (const string& input : new_inputs) while_node->add_input(input);
+  for (const string& input : control_inputs) while_node->add_input(input);
+
+  auto* attr = while_node->mutable_attr();
+  for (DataType type : new_types) {
+    (*attr)["T"].mutable_list()->add_type(type);
+  }
+  for (const char* shapes_attr : {"output_shapes", "_output_shapes"}) {
+    auto it = attr->find(shapes_attr);
+    if (it != attr->end() && it->second.list().shape_size() == num_loop_vars) {
+      for (int i = 0; i < new_types.size(); ++i) {
+        it->second.mutable_list()->add_shape()->set_unknown_rank(true);
+      }
+    }
+  }
+  (*attr)["body"].mutable_func()->set_name(new_body.signature().name());
+  (*attr)["cond"].mutable_func()->set_name(new_cond.signature().name());
+
+  *optimized_graph_->mutable_library()->add_function() = std::move(new_body);
+  *optimized_graph_->mutable_library()->add_function() = std::move(new_cond);
+  for (NodeDef& node : outer_nodes) {
+    *optimized_graph_->add_node() = std::move(node);
+  }
+  return Status::OK();
+}
+
+bool FunctionalWhileOptimizer::GetScalarIntConst(const NodeDef& node,
+                                                 int64* value) const {
+  if (!IsConstant(node) || !node.attr().count("value")) return false;
+  Tensor tensor;
+  if (!tensor.FromProto(node.attr().at("value").tensor()) ||
+      tensor.NumElements() != 1) {
+    return false;
+  }
+  if (tensor.dtype() == DT_INT32) {
+    *value = tensor.flat<int32>()(0);
+  } else if (tensor.dtype() == DT_INT64) {
+    *value = tensor.flat<int64>()(0);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+int64 FunctionalWhileOptimizer::GetTripCount(const NodeDef& while_node,
+                                             const FunctionDef& cond,
+                                             const FunctionDef& body) const {
+  // The condition must be `Less(counter, limit)`.
+  if (cond.ret_size() != 1) return -1;
+  string less_name, output_arg;
+  int index;
+  if (!ParseFunctionNodeOutput(cond.ret().begin()->second, &less_name,
+                               &output_arg, &index)) {
+    return -1;
+  }
+  std::unordered_map<string, const NodeDef*> cond_nodes;
+  for (const NodeDef& node : cond.node_def()) {
+    cond_nodes.emplace(node.name(), &node);
+  }
+  auto less = cond_nodes.find(less_name);
+  if (less == cond_nodes.end() || !IsLess(*less->second) ||
+      less->second->input_size() != 2) {
+    return -1;
+  }
+
+  const OpDef& cond_signature = cond.signature();
+  int counter_idx = -1;
+  for (int i = 0; i < cond_signature.input_arg_size(); ++i) {
+    if (cond_signature.input_arg(i).name() == less->second->input(0)) {
+      counter_idx = i;
+    }
+  }
+  if (counter_idx < 0) return -1;
+
+  // The limit is either a constant of the condition, or a loop invariant
+  // argument initialized by a constant.
+  NodeMap node_map(optimized_graph_);
+  int64 limit;
+  const string& limit_input = less->second->input(1);
+  auto limit_node = cond_nodes.find(FunctionInputNodeName(limit_input));
+  if (limit_node != cond_nodes.end()) {
+    if (!GetScalarIntConst(*limit_node->second, &limit)) return -1;
+  } else {
+    int limit_idx = -1;
+    for (int i = 0; i < cond_signature.input_arg_size(); ++i) {
+      if (cond_signature.input_arg(i).name() == limit_input) limit_idx = i;
+    }
+    if (limit_idx < 0) return -1;
+    const OpDef& body_signature = body.signature();
+    auto ret = body.ret().find(body_signature.output_arg(limit_idx).name());
+    if (ret == body.ret().end() ||
+        ret->second != body_signature.input_arg(limit_idx).name()) {
+      return -1;
+    }
+    const NodeDef* init = node_map.GetNode(while_node.input(limit_idx));
+    if (init == nullptr || !GetScalarIntConst(*init, &limit)) return -1;
+  }
+
+  // The body must increment the counter by one.
+  const string& counter_arg = body.signature().input_arg(counter_idx).name();
+  auto counter_ret =
+      body.ret().find(body.signature().output_arg(counter_idx).name());
+  if (counter_ret == body.ret().end()) return -1;
+  string add_name;
+  if (!ParseFunctionNodeOutput(counter_ret->second, &add_name, &output_arg,
+                               &index)) {
+    return -1;
+  }
+  const NodeDef* add = nullptr;
+  const NodeDef* step = nullptr;
+  for (const NodeDef& node : body.node_def()) {
+    if (node.name() == add_name) add = &node;
+  }
+  if (add == nullptr || !IsAdd(*add) || add->input_size() != 2) return -1;
+  int step_input = -1;
+  if (add->input(0) == counter_arg) step_input = 1;
+  if (add->input(1) == counter_arg) step_input = 0;
+  if (step_input < 0) return -1;
+  const string step_name = FunctionInputNodeName(add->input(step_input));
+  for (const NodeDef& node : body.node_def()) {
+    if (node.name() == step_name) step = &node;
+  }
+  int64 step_value;
+  if (step == nullptr || !GetScalarIntConst(*step, &step_value) ||
+      step_value != 1) {
+    return -1;
+  }
+
+  // The counter must be initialized by a constant.
+  const NodeDef* init = node_map.GetNode(while_node.input(counter_idx));
+  int64 start;
+  if (init == nullptr || !GetScalarIntConst(*init, &start)) return -1;
+
+  return std::max<int64>(0, limit - start);
+}
+
+Status FunctionalWhileOptimizer::UnrollBody(int while_node_idx) {
+  if (unroll_factor_ <= 1) return Status::OK();
+  const FunctionDef* cond;
+  const FunctionDef* body;
+  NodeDef* while_node = optimized_graph_->mutable_node(while_node_idx);
+  if (!IsSupportedWhile(*while_node, &cond, &body)) return Status::OK();
+
+  // Copies of stateful nodes would have to be ordered with control edges.
+  if (body->control_ret_size() > 0) return Status::OK();
+  for (const NodeDef& node : body->node_def()) {
+    if (!IsFreeOfSideEffect(node)) return Status::OK();
+  }
+
+  const int64 trip_count = GetTripCount(*while_node, *cond, *body);
+  if (trip_count < 0 || trip_count % unroll_factor_ != 0) {
+    VLOG(3) << "Can't unroll " << while_node->name()
+            << ": trip_count=" << trip_count;
+    return Status::OK();
+  }
+  VLOG(2) << "Unroll " << while_node->op() << " " << while_node->name()
+          << " by " << unroll_factor_ << ", trip_count=" << trip_count;
+
+  const OpDef& signature = body->signature();
+  std::unordered_set<string> arg_names;
+  for (const auto& arg : signature.input_arg()) arg_names.insert(arg.name());
+
+  // Values of the body arguments in the current copy of the body.
+  std::unordered_map<string, string> arg_values;
+  for (const string& arg : arg_names) arg_values.emplace(arg, arg);
+
+  FunctionDef new_body = *body;
+  new_body.mutable_signature()->set_name(
+      UniqueFunctionName(StrCat(signature.name(), "_unroll")));
+  new_body.clear_node_def();
+  for (int copy = 0; copy < unroll_factor_; ++copy) {
+    const string prefix = StrCat("unroll", copy, "/");
+    auto rewrite_input = [&](const string& input) -> string {
+      if (IsControlInput(input)) return StrCat("^", prefix, input.substr(1));
+      auto arg = arg_values.find(input);
+      return arg != arg_values.end() ? arg->second : prefix + input;
+    };
+    for (const NodeDef& node : body->node_def()) {
+      NodeDef* new_node = new_body.add_node_def();
+      *new_node = node;
+      new_node->set_name(prefix + node.name());
+      for (int i = 0; i < new_node->input_size(); ++i) {
+        new_node->set_input(i, rewrite_input(node.input(i)));
+      }
+    }
+    // Results of this copy are the arguments of the next one.
+    std::unordered_map<string, string> next_arg_values;
+    for (int i = 0; i < signature.input_arg_size(); ++i) {
+      const string& ret = body->ret().at(signature.output_arg(i).name());
+      next_arg_values.emplace(signature.input_arg(i).name(),
+                              rewrite_input(ret));
+    }
+    arg_values.swap(next_arg_values);
+  }
+  for (int i = 0; i < signature.output_arg_size(); ++i) {
+    (*new_body.mutable_ret())[signature.output_arg(i).name()] =
+        arg_values.at(signature.input_arg(i).name());
+  }
+
+  (*while_node->mutable_attr())["body"].mutable_func()->set_name(
+      new_body.signature().name());
+  *optimized_graph_->mutable_library()->add_function() = std::move(new_body);
+  return Status::OK();
+}
+
 }  // namespace
 
+LoopOptimizer::LoopOptimizerOptions
+LoopOptimizer::LoopOptimizerOptions::Default(RewriterConfig::Toggle opt_level,
+                                             int unroll_factor) {
+  LoopOptimizerOptions options;
+  options.enable_functional_while_licm =
+      opt_level == RewriterConfig::AGGRESSIVE;
+  options.functional_while_unroll_factor = unroll_factor;
+  return options;
+}
+
 LoopOptimizer::LoopOptimizer()
     : opt_level_(RewriterConfig::ON),
       cpu_device_(nullptr),
       options_(LoopOptimizerOptions::Default(RewriterConfig::ON)) {}
 
 LoopOptimizer::LoopOptimizer(RewriterConfig::Toggle opt_level,
-                             DeviceBase* cpu_device)
+                             DeviceBase* cpu_device, int unroll_factor)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
-      options_(LoopOptimizerOptions::Default(RewriterConfig::ON)) {
+      options_(LoopOptimizerOptions::Default(opt_level, unroll_factor)) {
   resource_mgr_.reset(new ResourceMgr());
 }
 
+bool LoopOptimizer::UsesFunctionLibrary() const {
+  // Bodies of functional While loops are rewritten in the function library.
+  return options_.enable_functional_while_licm ||
+         options_.functional_while_unroll_factor > 1;
+}
+
 Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                GraphDef* optimized_graph) {
   if (!options_.enable_loop_invariant_node_motion &&
       !options_.enable_stack_push_removal &&
-      !options_.enable_dead_branch_removal) {
+      !options_.enable_dead_branch_removal &&
+      !options_.enable_functional_while_licm &&
+      options_.functional_while_unroll_factor <= 1) {
     return errors::Aborted("Nothing to do.");
   }
   *optimized_graph = item.graph;
@@ -742,6 +1373,20 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     LoopInvariantNodeMotionOptimizer linm_optimizer(optimized_graph);
     TF_RETURN_IF_ERROR(linm_optimizer.Optimize());
   }
+  if (options_.enable_functional_while_licm ||
+      options_.functional_while_unroll_factor > 1) {
+    FunctionalWhileOptimizer while_optimizer(
+        options_.functional_while_unroll_factor, optimized_graph);
+    // New nodes are appended to the graph, only visit the original ones.
+    const int num_nodes = optimized_graph->node_size();
+    for (int i = 0; i < num_nodes; ++i) {
+      if (!IsWhile(optimized_graph->node(i))) continue;
+      if (options_.enable_functional_while_licm) {
+        TF_RETURN_IF_ERROR(while_optimizer.HoistInvariantNodes(i));
+      }
+      TF_RETURN_IF_ERROR(while_optimizer.UnrollBody(i));
+    }
+  }
   if (options_.enable_stack_push_removal) {
     TF_RETURN_IF_ERROR(RemoveStackOps(item.NodesToPreserve(), optimized_graph));
   }
@@ -34,13 +34,13 @@ class LoopOptimizer : public GraphOptimizer {
   LoopOptimizer();
 
   explicit LoopOptimizer(RewriterConfig::Toggle opt_level,
-                         DeviceBase* cpu_device);
+                         DeviceBase* cpu_device, int unroll_factor = 1);
 
   ~LoopOptimizer() override {}
 
   string name() const override { return "loop_optimizer"; };
 
-  bool UsesFunctionLibrary() const override { return false; }
+  bool UsesFunctionLibrary() const override;
 
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* optimized_graph) override;
@@ -56,11 +56,14 @@ class LoopOptimizer : public GraphOptimizer {
     bool enable_loop_invariant_node_motion = false;
     bool enable_stack_push_removal = true;
     bool enable_dead_branch_removal = true;
-
-    static LoopOptimizerOptions Default(RewriterConfig::Toggle opt_level) {
-      LoopOptimizerOptions options;
-      return options;
-    }
+    // Hoists loop invariant computations out of functional While bodies.
+    bool enable_functional_while_licm = false;
+    // Partially unrolls functional While loops with a known trip count that
+    // is a multiple of this factor. Values <= 1 disable unrolling.
+    int functional_while_unroll_factor = 1;
+
+    static LoopOptimizerOptions Default(RewriterConfig::Toggle opt_level,
+                                        int unroll_factor = 1);
   };
 
   Status RemoveDeadBranches(const std::unordered_set<string>& nodes_to_preserve,
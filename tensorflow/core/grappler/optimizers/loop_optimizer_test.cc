@@ -16,6 +16,9 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -25,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -70,11 +74,69 @@ class LoopOptimizerTest : public GrapplerTest {
     optimizer->options_.enable_stack_push_removal = true;
   }
 
+  void EnableOnlyFunctionalWhileOptimizations(LoopOptimizer* optimizer,
+                                              bool enable_licm,
+                                              int unroll_factor) {
+    DisableAllStages(optimizer);
+    optimizer->options_.enable_functional_while_licm = enable_licm;
+    optimizer->options_.functional_while_unroll_factor = unroll_factor;
+  }
+
+  // Returns a graph with a functional While loop computing:
+  //   for (i = 0; i < limit; ++i) x += y * y;
+  GraphDef FunctionalWhileGraph(int limit) const {
+    using FDH = FunctionDefHelper;
+    return FunctionalWhileGraph(
+        limit,
+        {{{"y_squared"}, "Mul", {"y", "y"}, {{"T", DT_FLOAT}}},
+         {{"next_x"}, "AddV2", {"x", "y_squared:z:0"}, {{"T", DT_FLOAT}}}});
+  }
+
+  // Same as above, with a loop computing `x = next_x` from the nodes
+  // `x_nodes` of the body.
+  GraphDef FunctionalWhileGraph(
+      int limit, std::vector<FunctionDefHelper::Node> x_nodes) const {
+    using test::function::NDef;
+    using FDH = FunctionDefHelper;
+
+    FunctionDef cond = FDH::Create(
+        "LessThanLimit", {"i: int32", "x: float", "y: float"}, {"r: bool"}, {},
+        {FDH::Const<int32>("limit", limit),
+         {{"less"}, "Less", {"i", "limit:output:0"}, {{"T", DT_INT32}}}},
+        {{"r", "less:z:0"}});
+
+    std::vector<FDH::Node> body_nodes = {
+        FDH::Const<int32>("one", 1),
+        {{"next_i"}, "AddV2", {"i", "one:output:0"}, {{"T", DT_INT32}}}};
+    body_nodes.insert(body_nodes.end(), x_nodes.begin(), x_nodes.end());
+    FunctionDef body = FDH::Create(
+        "Body", {"i: int32", "x: float", "y: float"},
+        {"i_out: int32", "x_out: float", "y_out: float"}, {}, body_nodes,
+        {{"i_out", "next_i:z:0"}, {"x_out", "next_x:z:0"}, {"y_out", "y"}});
+
+    return test::function::GDef(
+        {NDef("i", "Const", {},
+              {{"dtype", DT_INT32}, {"value", test::AsScalar<int32>(0)}}),
+         NDef("x", "Const", {},
+              {{"dtype", DT_FLOAT}, {"value", test::AsScalar<float>(1.0f)}}),
+         NDef("y", "Const", {},
+              {{"dtype", DT_FLOAT}, {"value", test::AsScalar<float>(3.0f)}}),
+         NDef("while", "While", {"i", "x", "y"},
+              {{"T", DataTypeSlice{DT_INT32, DT_FLOAT, DT_FLOAT}},
+               {"cond", FDH::FunctionRef("LessThanLimit")},
+               {"body", FDH::FunctionRef("Body")},
+               {"parallel_iterations", 10}}),
+         NDef("out", "Identity", {"while:1"}, {{"T", DT_FLOAT}})},
+        {cond, body});
+  }
+
  private:
   void DisableAllStages(LoopOptimizer* optimizer) {
     LoopOptimizer::LoopOptimizerOptions options;
     options.enable_loop_invariant_node_motion = false;
     options.enable_stack_push_removal = false;
+    options.enable_functional_while_licm = false;
+    options.functional_while_unroll_factor = 1;
     optimizer->options_ = options;
   }
 };
@@ -1689,5 +1751,290 @@ versions {
   EXPECT_TRUE(found);
 }
 
+TEST_F(LoopOptimizerTest, FunctionalWhileHoistInvariantNodes) {
+  GrapplerItem item;
+  item.graph = FunctionalWhileGraph(/*limit=*/8);
+  item.fetch = {"out"};
+
+  LoopOptimizer optimizer;
+  EnableOnlyFunctionalWhileOptimizations(&optimizer, /*enable_licm=*/true,
+                                         /*unroll_factor=*/1);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // y * y is computed once in front of the loop, and passed as a new loop
+  // invariant argument.
+  const NodeDef* while_node = nullptr;
+  const NodeDef* hoisted = nullptr;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "while") while_node = &node;
+    if (node.name() == "while/licm/y_squared") hoisted = &node;
+  }
+  ASSERT_NE(while_node, nullptr);
+  ASSERT_NE(hoisted, nullptr);
+  EXPECT_EQ(hoisted->op(), "Mul");
+  ASSERT_EQ(hoisted->input_size(), 2);
+  EXPECT_EQ(hoisted->input(0), "y");
+  EXPECT_EQ(hoisted->input(1), "y");
+
+  ASSERT_EQ(while_node->input_size(), 4);
+  EXPECT_EQ(while_node->input(3), "while/licm/y_squared");
+  EXPECT_EQ(while_node->attr().at("T").list().type_size(), 4);
+
+  const string& body_name = while_node->attr().at("body").func().name();
+  EXPECT_NE(body_name, "Body");
+  for (const FunctionDef& func : output.library().function()) {
+    if (func.signature().name() != body_name) continue;
+    EXPECT_EQ(func.signature().input_arg_size(), 4);
+    for (const NodeDef& node : func.node_def()) {
+      EXPECT_NE(node.op(), "Mul");
+    }
+  }
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
+TEST_F(LoopOptimizerTest, FunctionalWhileKeepControlDependenciesInBody) {
+  GrapplerItem item;
+  item.graph = FunctionalWhileGraph(
+      /*limit=*/8,
+      {{{"y_squared"}, "Mul", {"y", "y"}, {{"T", DT_FLOAT}}},
+       {{"y_cubed"}, "Mul", {"y_squared:z:0", "y"}, {{"T", DT_FLOAT}}},
+       {{"next_x"},
+        "AddV2",
+        {"x", "y_squared:z:0"},
+        {{"T", DT_FLOAT}},
+        {"y_cubed"}}});
+  item.fetch = {"out"};
+
+  LoopOptimizer optimizer;
+  EnableOnlyFunctionalWhileOptimizations(&optimizer, /*enable_licm=*/true,
+                                         /*unroll_factor=*/1);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // y_cubed is a control input of next_x and stays in the body, where it
+  // reads the hoisted y * y from the new argument.
+  const NodeDef* while_node = nullptr;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "while") while_node = &node;
+    EXPECT_NE(node.name(), "while/licm/y_cubed");
+  }
+  ASSERT_NE(while_node, nullptr);
+  ASSERT_EQ(while_node->input_size(), 4);
+  EXPECT_EQ(while_node->input(3), "while/licm/y_squared");
+
+  const string& body_name = while_node->attr().at("body").func().name();
+  bool found = false;
+  for (const FunctionDef& func : output.library().function()) {
+    if (func.signature().name() != body_name) continue;
+    const string& new_arg = func.signature().input_arg(3).name();
+    for (const NodeDef& node : func.node_def()) {
+      EXPECT_NE(node.name(), "y_squared");
+      if (node.name() == "y_cubed") {
+        ASSERT_EQ(node.input_size(), 2);
+        EXPECT_EQ(node.input(0), new_arg);
+        found = true;
+      }
+    }
+  }
+  EXPECT_TRUE(found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
+TEST_F(LoopOptimizerTest, FunctionalWhileOnlyHoistCannotFailOutOfZeroTrip) {
+  GrapplerItem item;
+  item.graph = FunctionalWhileGraph(
+      /*limit=*/0,
+      {{{"y_squared"}, "Mul", {"y", "y"}, {{"T", DT_FLOAT}}},
+       {{"y_neg"}, "Neg", {"y"}, {{"T", DT_FLOAT}}},
+       {{"sum"}, "AddV2", {"y_squared:z:0", "y_neg:y:0"}, {{"T", DT_FLOAT}}},
+       {{"next_x"}, "AddV2", {"x", "sum:z:0"}, {{"T", DT_FLOAT}}}});
+  item.fetch = {"out"};
+
+  LoopOptimizer optimizer;
+  EnableOnlyFunctionalWhileOptimizations(&optimizer, /*enable_licm=*/true,
+                                         /*unroll_factor=*/1);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The loop doesn't run, so Mul, which fails on mismatched shapes, must stay
+  // in the body. Neg can't fail and is hoisted.
+  bool found = false;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "while/licm/y_squared");
+    EXPECT_NE(node.name(), "while/licm/sum");
+    if (node.name() == "while/licm/y_neg") found = true;
+  }
+  EXPECT_TRUE(found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
+TEST_F(LoopOptimizerTest, FunctionalWhileUnrollKnownTripCount) {
+  GrapplerItem item;
+  item.graph = FunctionalWhileGraph(/*limit=*/8);
+  item.fetch = {"out"};
+
+  LoopOptimizer optimizer;
+  EnableOnlyFunctionalWhileOptimizations(&optimizer, /*enable_licm=*/false,
+                                         /*unroll_factor=*/4);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  const NodeDef* while_node = nullptr;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "while") while_node = &node;
+  }
+  ASSERT_NE(while_node, nullptr);
+  const string& body_name = while_node->attr().at("body").func().name();
+  EXPECT_NE(body_name, "Body");
+  for (const FunctionDef& func : output.library().function()) {
+    if (func.signature().name() != body_name) continue;
+    EXPECT_EQ(func.node_def_size(), 4 * 4);
+    EXPECT_EQ(func.ret().at("x_out"), "unroll3/next_x:z:0");
+  }
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
+TEST_F(LoopOptimizerTest, FunctionalWhileUnrollFactorFromConstructor) {
+  GrapplerItem item;
+  item.graph = FunctionalWhileGraph(/*limit=*/8);
+  item.fetch = {"out"};
+
+  LoopOptimizer optimizer(RewriterConfig::ON, /*cpu_device=*/nullptr,
+                          /*unroll_factor=*/2);
+  EXPECT_TRUE(optimizer.UsesFunctionLibrary());
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "while") {
+      EXPECT_NE(node.attr().at("body").func().name(), "Body");
+    }
+  }
+}
+
+TEST_F(LoopOptimizerTest, FunctionalWhileNoUnrollIfTripCountNotMultiple) {
+  GrapplerItem item;
+  item.graph = FunctionalWhileGraph(/*limit=*/7);
+  item.fetch = {"out"};
+
+  LoopOptimizer optimizer;
+  EnableOnlyFunctionalWhileOptimizations(&optimizer, /*enable_licm=*/false,
+                                         /*unroll_factor=*/4);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "while") {
+      EXPECT_EQ(node.attr().at("body").func().name(), "Body");
+    }
+  }
+  EXPECT_EQ(output.library().function_size(), 2);
+}
+
+TEST_F(LoopOptimizerTest, FunctionalWhileHoistAndUnroll) {
+  GrapplerItem item;
+  item.graph = FunctionalWhileGraph(/*limit=*/6);
+  item.fetch = {"out"};
+
+  LoopOptimizer optimizer;
+  EnableOnlyFunctionalWhileOptimizations(&optimizer, /*enable_licm=*/true,
+                                         /*unroll_factor=*/3);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
+// Returns a graph with a functional While loop computing:
+//   for (i = 0; i < limit; ++i) x += matmul(y, y);
+// with [n, n] matrices x and y.
+static GraphDef InvariantMatMulWhileGraph(int limit, int n) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  FunctionDef cond = FDH::Create(
+      "LessThanLimit", {"i: int32", "x: float", "y: float"}, {"r: bool"}, {},
+      {FDH::Const<int32>("limit", limit),
+       {{"less"}, "Less", {"i", "limit:output:0"}, {{"T", DT_INT32}}}},
+      {{"r", "less:z:0"}});
+
+  FunctionDef body = FDH::Create(
+      "Body", {"i: int32", "x: float", "y: float"},
+      {"i_out: int32", "x_out: float", "y_out: float"}, {},
+      {FDH::Const<int32>("one", 1),
+       {{"next_i"}, "AddV2", {"i", "one:output:0"}, {{"T", DT_INT32}}},
+       {{"y_squared"}, "MatMul", {"y", "y"}, {{"T", DT_FLOAT}}},
+       {{"next_x"}, "AddV2", {"x", "y_squared:product:0"}, {{"T", DT_FLOAT}}}},
+      {{"i_out", "next_i:z:0"}, {"x_out", "next_x:z:0"}, {"y_out", "y"}});
+
+  Tensor matrix(DT_FLOAT, TensorShape({n, n}));
+  matrix.flat<float>().setConstant(1.0f / n);
+  return test::function::GDef(
+      {NDef("i", "Const", {},
+            {{"dtype", DT_INT32}, {"value", test::AsScalar<int32>(0)}}),
+       NDef("x", "Const", {}, {{"dtype", DT_FLOAT}, {"value", matrix}}),
+       NDef("y", "Const", {}, {{"dtype", DT_FLOAT}, {"value", matrix}}),
+       NDef("while", "While", {"i", "x", "y"},
+            {{"T", DataTypeSlice{DT_INT32, DT_FLOAT, DT_FLOAT}},
+             {"cond", FDH::FunctionRef("LessThanLimit")},
+             {"body", FDH::FunctionRef("Body")},
+             {"parallel_iterations", 10}}),
+       NDef("out", "Identity", {"while:1"}, {{"T", DT_FLOAT}})},
+      {cond, body});
+}
+
+// Runs a loop of 16 iterations over [n, n] matrices (first argument), with or
+// without the functional While optimizations (second argument).
+static void BM_FunctionalWhileInvariantMatMul(
+    ::testing::benchmark::State& state) {
+  const int n = state.range(0);
+  const bool optimize = state.range(1);
+
+  GrapplerItem item;
+  item.graph = InvariantMatMulWhileGraph(/*limit=*/16, n);
+  item.fetch = {"out"};
+  GraphDef graph_def = item.graph;
+  if (optimize) {
+    LoopOptimizer optimizer(RewriterConfig::AGGRESSIVE, nullptr);
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &graph_def));
+  }
+
+  Graph* graph = new Graph(OpRegistry::Global());
+  TF_CHECK_OK(
+      ConvertGraphDefToGraph(GraphConstructorOptions(), graph_def, graph));
+  test::Benchmark("cpu", graph, /*old_benchmark_api=*/false).Run(state);
+}
+
+BENCHMARK(BM_FunctionalWhileInvariantMatMul)
+    ->ArgPair(16, false)
+    ->ArgPair(16, true)
+    ->ArgPair(256, false)
+    ->ArgPair(256, true);
+
 }  // namespace grappler
 }  // namespace tensorflow
@@ -199,7 +199,9 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
          new CommonSubgraphElimination(cfg_.common_subgraph_elimination()));
   MK_OPT("arithmetic", new ArithmeticOptimizer(cfg_.arithmetic_optimization()));
   MK_OPT("autoparallel", new AutoParallel(cfg_.auto_parallel().num_replicas()));
-  MK_OPT("loop", new LoopOptimizer(cfg_.loop_optimization(), cpu_device_));
+  MK_OPT("loop",
+         new LoopOptimizer(cfg_.loop_optimization(), cpu_device_,
+                           cfg_.loop_optimization_unroll_factor()));
   MK_OPT("dependency", new DependencyOptimizer(cfg_.dependency_optimization()));
   MK_OPT("debug_stripper", new DebugStripper());
   MK_OPT("scoped_allocator",
@@ -278,7 +280,8 @@ Status MetaOptimizer::InitializeOptimizers(
   }
   if (cfg_.loop_optimization() != RewriterConfig::OFF) {
     optimizers->push_back(
-        MakeUnique<LoopOptimizer>(cfg_.loop_optimization(), cpu_device_));
+        MakeUnique<LoopOptimizer>(cfg_.loop_optimization(), cpu_device_,
+                                  cfg_.loop_optimization_unroll_factor()));
   }
   if (cfg_.dependency_optimization() != RewriterConfig::OFF) {
     optimizers->push_back(
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/graph_view.h"
@@ -1746,6 +1748,51 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
 #endif  // INTEL_MKL
 }
 
+#ifndef INTEL_MKL
+// Must match kPrepackWeightsAttr in kernels/matmul_op_prepacked_weights.h.
+constexpr char kPrepackWeights[] = "_prepack_weights";
+
+// Returns whether the kernel of MatMul or _FusedMatMul `node` repacks its
+// weights on every call: it transposes them, or converts bfloat16 weights to
+// float. Weights already in the layout consumed by the contraction gain
+// nothing from a prepacked copy.
+bool MatMulRepacksWeights(const NodeDef& node) {
+  bool transpose_b = false;
+  if (TryGetNodeAttr(node, "transpose_b", &transpose_b) && transpose_b) {
+    return true;
+  }
+  // Only the MatMul kernel computes bfloat16 products in float.
+  DataType dtype = DT_INVALID;
+  return IsMatMul(node) && TryGetNodeAttr(node, "T", &dtype) &&
+         dtype == DT_BFLOAT16;
+}
+
+// Marks CPU MatMul and _FusedMatMul nodes that multiply by a Const weight
+// matrix which they repack. Their kernels keep the weights in the layout
+// consumed by the contraction (transposed and converted to the compute type)
+// instead of repacking them on every call.
+void MarkConstantWeightsForPrepacking(GraphDef* graph) {
+  absl::flat_hash_map<string, const NodeDef*> node_by_name;
+  for (const NodeDef& node : graph->node()) {
+    node_by_name.emplace(node.name(), &node);
+  }
+
+  for (NodeDef& node : *graph->mutable_node()) {
+    if (!IsMatMul(node) && node.op() != kFusedMatMul) continue;
+    if (!NodeIsOnCpu(&node) || node.input_size() < 2) continue;
+    if (IsControlInput(node.input(1))) continue;
+
+    auto it = node_by_name.find(NodeName(node.input(1)));
+    if (it == node_by_name.end() || !IsConstant(*it->second)) continue;
+    if (!MatMulRepacksWeights(node)) continue;
+
+    VLOG(2) << "Prepack constant weights " << it->second->name()
+            << " of " << node.op() << " " << node.name();
+    AddNodeAttr(kPrepackWeights, true, &node);
+  }
+}
+#endif  // !INTEL_MKL
+
 }  // namespace
 
 Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
@@ -1912,6 +1959,11 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
   }
   TF_RETURN_IF_ERROR(mutation->Apply());
 
+#ifndef INTEL_MKL
+  // MatMul nodes are rewritten to _MklMatMul, which manages its own weights.
+  MarkConstantWeightsForPrepacking(&mutable_item.graph);
+#endif  // !INTEL_MKL
+
   *optimized_graph = std::move(mutable_item.graph);
 
   return Status::OK();
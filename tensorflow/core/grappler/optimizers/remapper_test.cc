@@ -629,6 +629,67 @@ TEST_F(RemapperTest, FuseConv2DWithBiasAndActivation) {
   }
 }
 
+#ifndef INTEL_MKL
+TEST_F(RemapperTest, PrepackConstantMatMulWeights) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto input_shape = ops::Placeholder::Shape({8, 32});
+  auto input = Placeholder(s.WithOpName("input"), DT_FLOAT, input_shape);
+  auto weights = ops::Const(s.WithOpName("weights"), 0.5f, {64, 32});
+  auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT,
+                         ops::Placeholder::Shape({64, 16}));
+
+  // Weights already in the contraction layout are used as is.
+  auto plain_weights = ops::Const(s.WithOpName("plain_weights"), 0.25f,
+                                  {16, 16});
+
+  auto const_matmul = ops::MatMul(s.WithOpName("const_matmul"), input, weights,
+                                  ops::MatMul::TransposeB(true));
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), const_matmul, rhs);
+  auto plain_matmul =
+      ops::MatMul(s.WithOpName("plain_matmul"), matmul, plain_weights);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), plain_matmul);
+
+  auto input_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+  auto rhs_t = GenerateRandomTensor<DT_FLOAT>({64, 16});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"input", input_t}, {"rhs", rhs_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "const_matmul") {
+      ASSERT_EQ(node.attr().count("_prepack_weights"), 1);
+      EXPECT_TRUE(node.attr().at("_prepack_weights").b());
+      found++;
+    } else if (node.name() == "matmul" || node.name() == "plain_matmul") {
+      EXPECT_EQ(node.attr().count("_prepack_weights"), 0);
+      found++;
+    }
+  }
+  EXPECT_EQ(3, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+#endif  // !INTEL_MKL
+
 class RemapperFuseMatMulWithBiasAndActivationTest : public RemapperTest {
  public:
   template <DataType DTYPE>
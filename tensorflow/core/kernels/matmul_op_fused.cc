@@ -38,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/kernels/fused_eigen_output_kernels.h"
+#include "tensorflow/core/kernels/matmul_op_prepacked_weights.h"
 #include "tensorflow/core/util/tensor_format.h"
 
 #if defined(TENSORFLOW_USE_CUSTOM_CONTRACTION_KERNEL)
@@ -157,6 +158,16 @@ class FusedMatMulOp : public OpKernel {
     OP_REQUIRES_OK(context, InitializeFusedComputation(
                                 context, "MatMul", patterns,
                                 &fused_computation_, &fused_computation_args_));
+
+    if (context->HasAttr(kPrepackWeightsAttr)) {
+      OP_REQUIRES_OK(context,
+                     context->GetAttr(kPrepackWeightsAttr, &prepack_weights_));
+    }
+    // A copy of weights already in the canonical layout would only double
+    // their memory.
+    prepack_weights_ = prepack_weights_ &&
+                       PrepackedMatMulWeights<T>::NeedsPacking(
+                           /*transpose=*/transpose_b_, /*conjugate=*/false);
   }
 
   void Compute(OpKernelContext* ctx) override {
@@ -203,6 +214,34 @@ class FusedMatMulOp : public OpKernel {
       return;
     }
 
+    if (prepack_weights_) {
+      // Contract with the cached [k, n] weights instead of `b`.
+      Tensor b_reshaped;
+      OP_REQUIRES(ctx,
+                  b_reshaped.CopyFrom(
+                      b, TensorShape({1, b.dim_size(0), b.dim_size(1)})),
+                  errors::Internal("Failed to reshape In[1] from ",
+                                   b.shape().DebugString()));
+      Tensor b_prepacked;
+      OP_REQUIRES_OK(ctx, prepacked_weights_.Get(ctx, b_reshaped,
+                                                 /*transpose=*/transpose_b_,
+                                                 /*conjugate=*/false,
+                                                 &b_prepacked));
+      Tensor b_matrix;
+      OP_REQUIRES(ctx,
+                  b_matrix.CopyFrom(b_prepacked,
+                                    TensorShape({b_prepacked.dim_size(1),
+                                                 b_prepacked.dim_size(2)})),
+                  errors::Internal("Failed to reshape prepacked In[1] from ",
+                                   b_prepacked.shape().DebugString()));
+      dim_pair[0].second = 0;
+
+      auto launch = LaunchFusedMatMulOp<Device, T>();
+      launch(ctx, a, b_matrix, dim_pair, fused_computation_,
+             fused_computation_args_, out);
+      return;
+    }
+
     auto launch = LaunchFusedMatMulOp<Device, T>();
     launch(ctx, a, b, dim_pair, fused_computation_, fused_computation_args_,
            out);
@@ -212,6 +251,9 @@ class FusedMatMulOp : public OpKernel {
   bool transpose_a_;
   bool transpose_b_;
 
+  bool prepack_weights_ = false;
+  PrepackedMatMulWeights<T> prepacked_weights_;
+
   FusedComputationType fused_computation_ = FusedComputationType::kUndefined;
   FusedComputationArgs fused_computation_args_;
 
@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/type_traits.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/matmul_op_prepacked_weights.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/platform/logging.h"
@@ -648,6 +649,20 @@ class BaseBatchMatMulOp : public OpKernel {
       trans_x_ = false;
       trans_y_ = false;
     }
+    // Constant weights can only be prepacked once on CPU, see
+    // matmul_op_prepacked_weights.h.
+    prepack_rhs_ = false;
+    if (std::is_same<Device, CPUDevice>::value &&
+        context->HasAttr(kPrepackWeightsAttr)) {
+      OP_REQUIRES_OK(context,
+                     context->GetAttr(kPrepackWeightsAttr, &prepack_rhs_));
+    }
+    // A copy of weights already in the canonical layout would only double
+    // their memory.
+    using PrepackedWeights = PrepackedMatMulWeights<Scalar, PrepackedScalar>;
+    prepack_rhs_ = prepack_rhs_ && PrepackedWeights::NeedsPacking(
+                                       /*transpose=*/adj_y_ || trans_y_,
+                                       /*conjugate=*/adj_y_);
   }
 
   ~BaseBatchMatMulOp() override {}
@@ -707,6 +722,20 @@ class BaseBatchMatMulOp : public OpKernel {
                 out_reshaped.CopyFrom(*out, TensorShape({batch_size, d0, d3})),
                 errors::Internal("Failed to reshape output from ",
                                  out->shape().DebugString()));
+    // The right-hand side of the product. When the weights are prepacked they
+    // are already transposed/conjugated, so the launch must not do it again.
+    bool adj_y = adj_y_;
+    bool trans_y = trans_y_;
+    Tensor in1_prepacked;
+    if (prepack_rhs_) {
+      OP_REQUIRES_OK(ctx, prepacked_rhs_.Get(ctx, in1_reshaped,
+                                             /*transpose=*/adj_y_ || trans_y_,
+                                             /*conjugate=*/adj_y_,
+                                             &in1_prepacked));
+      adj_y = false;
+      trans_y = false;
+    }
+
     if (std::is_same<Scalar, bfloat16>::value) {
       bool is_cpu = std::is_same<Device, CPUDevice>::value;
       OP_REQUIRES(ctx, is_cpu,
@@ -714,8 +743,6 @@ class BaseBatchMatMulOp : public OpKernel {
       Tensor in0_reshaped_float, in1_reshaped_float, out_reshaped_float;
       OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, in0_reshaped.shape(),
                                              &in0_reshaped_float));
-      OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, in1_reshaped.shape(),
-                                             &in1_reshaped_float));
       OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, out_reshaped.shape(),
                                              &out_reshaped_float));
 
@@ -723,19 +750,26 @@ class BaseBatchMatMulOp : public OpKernel {
       BFloat16ToFloat(in0_reshaped.flat<bfloat16>().data(),
                       in0_reshaped_float.flat<float>().data(),
                       in0_reshaped.NumElements());
-      BFloat16ToFloat(in1_reshaped.flat<bfloat16>().data(),
-                      in1_reshaped_float.flat<float>().data(),
-                      in1_reshaped.NumElements());
+      if (prepack_rhs_) {
+        // Prepacked bfloat16 weights are stored as float.
+        in1_reshaped_float = in1_prepacked;
+      } else {
+        OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, in1_reshaped.shape(),
+                                               &in1_reshaped_float));
+        BFloat16ToFloat(in1_reshaped.flat<bfloat16>().data(),
+                        in1_reshaped_float.flat<float>().data(),
+                        in1_reshaped.NumElements());
+      }
 
       LaunchBatchMatMul<Device, float>::Launch(
-          ctx, in0_reshaped_float, in1_reshaped_float, adj_x_, adj_y_, trans_x_,
-          trans_y_, bcast, &out_reshaped_float);
+          ctx, in0_reshaped_float, in1_reshaped_float, adj_x_, adj_y, trans_x_,
+          trans_y, bcast, &out_reshaped_float);
       FloatToBFloat16(out_reshaped_float.flat<float>().data(),
                       out_reshaped.flat<bfloat16>().data(), out->NumElements());
     } else {
-      LaunchBatchMatMul<Device, Scalar>::Launch(ctx, in0_reshaped, in1_reshaped,
-                                                adj_x_, adj_y_, trans_x_,
-                                                trans_y_, bcast, &out_reshaped);
+      LaunchBatchMatMul<Device, Scalar>::Launch(
+          ctx, in0_reshaped, prepack_rhs_ ? in1_prepacked : in1_reshaped,
+          adj_x_, adj_y, trans_x_, trans_y, bcast, &out_reshaped);
     }
   }
 
@@ -749,6 +783,13 @@ class BaseBatchMatMulOp : public OpKernel {
   bool adj_y_;
   bool trans_x_;
   bool trans_y_;
+
+  // bfloat16 products are computed in float, so are the prepacked weights.
+  using PrepackedScalar =
+      typename std::conditional<std::is_same<Scalar, bfloat16>::value, float,
+                                Scalar>::type;
+  bool prepack_rhs_;
+  PrepackedMatMulWeights<Scalar, PrepackedScalar> prepacked_rhs_;
 };
 
 // BatchMatMul Op implementation which disallows broadcasting.
@@ -0,0 +1,171 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_MATMUL_OP_PREPACKED_WEIGHTS_H_
+#define TENSORFLOW_CORE_KERNELS_MATMUL_OP_PREPACKED_WEIGHTS_H_
+
+#define EIGEN_USE_THREADS
+
+#include <type_traits>
+#include <utility>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+// Name of the node attribute that Grappler sets on CPU MatMul/_FusedMatMul
+// nodes whose right-hand side operand is a constant. Kernels that see this
+// attribute keep a prepacked copy of the weights between invocations.
+constexpr char kPrepackWeightsAttr[] = "_prepack_weights";
+
+// Caches the right-hand side operand of a CPU matrix multiplication in the
+// canonical layout consumed by the Eigen contraction and matmul kernels:
+// [batch, k, n], row-major, not transposed, not conjugated and already
+// converted to the compute type `OutT` (e.g. bfloat16 weights are stored as
+// float).
+//
+// The cache is keyed by the underlying buffer of the weights tensor. As long
+// as the kernel is fed the same buffer (which is the case for constants), the
+// transpose and type conversion are done once instead of on every call. A
+// reference to the source buffer is held so that it can't be freed and reused
+// for a different tensor while the cache entry is alive.
+//
+// Weights which are already in the canonical layout and compute type are
+// returned as is, without a cached copy.
+template <typename InT, typename OutT = InT>
+class PrepackedMatMulWeights {
+ public:
+  PrepackedMatMulWeights() = default;
+
+  // Returns whether weights of type InT, transposed and conjugated as given,
+  // have to be repacked at all.
+  static bool NeedsPacking(bool transpose, bool conjugate) {
+    return !std::is_same<InT, OutT>::value || transpose || conjugate;
+  }
+
+  // Returns in `packed` the canonical form of the 3D tensor `weights`. If
+  // `transpose` is true the two inner dimensions of `weights` are swapped, and
+  // if `conjugate` is true the values are conjugated (no-op for real types).
+  Status Get(OpKernelContext* ctx, const Tensor& weights, bool transpose,
+             bool conjugate, Tensor* packed) {
+    if (weights.dims() != 3) {
+      return errors::InvalidArgument(
+          "Prepacked weights must be a 3D tensor, got shape ",
+          weights.shape().DebugString());
+    }
+    if (!NeedsPacking(transpose, conjugate)) {
+      *packed = weights;
+      return Status::OK();
+    }
+
+    {
+      mutex_lock lock(mu_);
+      if (initialized_ && transpose == transpose_ &&
+          conjugate == conjugate_) {
+        const Tensor* source = source_.AccessTensor(ctx);
+        if (source->SharesBufferWith(weights) &&
+            source->shape() == weights.shape()) {
+          *packed = *packed_.AccessTensor(ctx);
+          return Status::OK();
+        }
+      }
+    }
+
+    // Pack without holding the lock, so that concurrent calls with cached
+    // weights don't wait for it. Concurrent misses each pack the weights, and
+    // the last one to finish is cached.
+    TensorShape packed_shape = weights.shape();
+    if (transpose) {
+      packed_shape.set_dim(1, weights.dim_size(2));
+      packed_shape.set_dim(2, weights.dim_size(1));
+    }
+
+    PersistentTensor new_packed;
+    Tensor* packed_tensor = nullptr;
+    TF_RETURN_IF_ERROR(ctx->allocate_persistent(DataTypeToEnum<OutT>::value,
+                                                packed_shape, &new_packed,
+                                                &packed_tensor));
+
+    // Convert to the compute type first, the shuffle below is done in OutT.
+    Tensor converted = weights;
+    if (!std::is_same<InT, OutT>::value) {
+      TF_RETURN_IF_ERROR(ctx->allocate_temp(DataTypeToEnum<OutT>::value,
+                                            weights.shape(), &converted));
+      ConvertToComputeType(weights, &converted);
+    }
+
+    const Eigen::ThreadPoolDevice& d = ctx->eigen_cpu_device();
+    auto in = converted.tensor<OutT, 3>();
+    auto out = packed_tensor->tensor<OutT, 3>();
+    if (transpose) {
+      Eigen::array<int, 3> perm({0, 2, 1});
+      if (conjugate) {
+        out.device(d) = in.shuffle(perm).conjugate();
+      } else {
+        out.device(d) = in.shuffle(perm);
+      }
+    } else if (conjugate) {
+      out.device(d) = in.conjugate();
+    } else {
+      out.device(d) = in;
+    }
+
+    *packed = *packed_tensor;
+    mutex_lock lock(mu_);
+    source_ = PersistentTensor(weights);
+    packed_ = std::move(new_packed);
+    transpose_ = transpose;
+    conjugate_ = conjugate;
+    initialized_ = true;
+    return Status::OK();
+  }
+
+ private:
+  template <typename T = InT>
+  static typename std::enable_if<std::is_same<T, bfloat16>::value &&
+                                 std::is_same<OutT, float>::value>::type
+  ConvertToComputeType(const Tensor& in, Tensor* out) {
+    BFloat16ToFloat(in.flat<bfloat16>().data(), out->flat<float>().data(),
+                    in.NumElements());
+  }
+
+  template <typename T = InT>
+  static typename std::enable_if<!(std::is_same<T, bfloat16>::value &&
+                                   std::is_same<OutT, float>::value)>::type
+  ConvertToComputeType(const Tensor& in, Tensor* out) {
+    auto out_flat = out->flat<OutT>();
+    out_flat = in.flat<InT>().template cast<OutT>();
+  }
+
+  mutex mu_;
+  bool initialized_ TF_GUARDED_BY(mu_) = false;
+  bool transpose_ TF_GUARDED_BY(mu_) = false;
+  bool conjugate_ TF_GUARDED_BY(mu_) = false;
+  PersistentTensor source_ TF_GUARDED_BY(mu_);
+  PersistentTensor packed_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PrepackedMatMulWeights);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_MATMUL_OP_PREPACKED_WEIGHTS_H_
@@ -16,7 +16,10 @@ limitations under the License.
 #include "absl/algorithm/container.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -339,6 +342,63 @@ using FusedBiasAddDataTypes = ::testing::Types<float>;
 INSTANTIATE_TYPED_TEST_SUITE_P(Test, FusedMatMulWithBiasOpTest,
                                FusedBiasAddDataTypes);
 
+class MatMulPrepackedWeightsOpTest : public OpsTestBase {
+ protected:
+  // Runs MatMul twice with the same weights buffer (the second run uses the
+  // cached weights), and compares both results with a regular MatMul.
+  template <typename T>
+  void VerifyPrepackedMatMul(int m, int k, int n, bool transpose_b) {
+    DataType dtype = DataTypeToEnum<T>::v();
+
+    Tensor lhs(dtype, {m, k});
+    lhs.flat<T>().setRandom();
+    Tensor rhs(dtype, transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+    rhs.flat<T>().setRandom();
+
+    auto run_matmul = [&](bool prepack, int num_runs, Tensor* out) {
+      NodeDefBuilder builder("matmul", "MatMul");
+      builder.Input(FakeInput(dtype))
+          .Input(FakeInput(dtype))
+          .Attr("transpose_a", false)
+          .Attr("transpose_b", transpose_b);
+      if (prepack) builder.Attr("_prepack_weights", true);
+      TF_ASSERT_OK(builder.Finalize(node_def()));
+      TF_ASSERT_OK(InitOp());
+
+      inputs_.clear();
+      AddInputFromArray<T>(lhs.shape(), lhs.flat<T>());
+      AddInputFromArray<T>(rhs.shape(), rhs.flat<T>());
+      for (int i = 0; i < num_runs; ++i) {
+        TF_ASSERT_OK(RunOpKernel());
+        Tensor result = *GetOutput(0);
+        if (i > 0) test::ExpectTensorEqual<T>(*out, result);
+        *out = tensor::DeepCopy(result);
+      }
+    };
+
+    Tensor expected;
+    Tensor prepacked;
+    run_matmul(/*prepack=*/false, /*num_runs=*/1, &expected);
+    run_matmul(/*prepack=*/true, /*num_runs=*/2, &prepacked);
+
+    test::ExpectClose(expected, prepacked, /*atol=*/1e-5);
+  }
+};
+
+TEST_F(MatMulPrepackedWeightsOpTest, Float) {
+  VerifyPrepackedMatMul<float>(1, 64, 32, /*transpose_b=*/false);
+  VerifyPrepackedMatMul<float>(8, 64, 32, /*transpose_b=*/false);
+}
+
+TEST_F(MatMulPrepackedWeightsOpTest, FloatTransposed) {
+  VerifyPrepackedMatMul<float>(1, 64, 32, /*transpose_b=*/true);
+  VerifyPrepackedMatMul<float>(8, 64, 32, /*transpose_b=*/true);
+}
+
+TEST_F(MatMulPrepackedWeightsOpTest, Complex64Transposed) {
+  VerifyPrepackedMatMul<complex64>(8, 64, 32, /*transpose_b=*/true);
+}
+
 //----------------------------------------------------------------------------//
 // Performance benchmarks are below.                                          //
 //----------------------------------------------------------------------------//
@@ -386,6 +446,47 @@ static Graph* Matmul(int m, int k, int n, bool transpose_a, bool transpose_b,
 
 #endif  // GOOGLE_CUDA
 
+// Matmul with constant weights, with or without the `_prepack_weights`
+// attribute that Grappler sets when the kernel would repack them.
+template <typename T>
+static Graph* MatmulConstWeights(int m, int k, int n, bool transpose_b,
+                                 bool prepack, DataType type) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor in0(type, TensorShape({m, k}));
+  in0.flat<T>().setRandom();
+  Tensor in1(type, transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+  in1.flat<T>().setRandom();
+  Node* matmul =
+      test::graph::Matmul(g, test::graph::Constant(g, in0),
+                          test::graph::Constant(g, in1), false, transpose_b);
+  if (prepack) matmul->AddAttr("_prepack_weights", true);
+  return g;
+}
+
+#define BM_MatmulConstWeightsDev(M, K, N, TB, PREPACK, T, TFTYPE)             \
+  static void                                                                \
+      BM_MatmulConstWeights##_##M##_##K##_##N##_##TB##_##PREPACK##_##TFTYPE( \
+          int iters) {                                                       \
+    testing::UseRealTime();                                                  \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);      \
+    test::Benchmark("cpu",                                                   \
+                    MatmulConstWeights<T>(M, K, N, TB, PREPACK, TFTYPE))     \
+        .Run(iters);                                                         \
+  }                                                                          \
+  BENCHMARK(                                                                 \
+      BM_MatmulConstWeights##_##M##_##K##_##N##_##TB##_##PREPACK##_##TFTYPE);
+
+#define BM_MatmulConstWeights(M, K, N, TB, T, TFTYPE)      \
+  BM_MatmulConstWeightsDev(M, K, N, TB, false, T, TFTYPE); \
+  BM_MatmulConstWeightsDev(M, K, N, TB, true, T, TFTYPE);
+
+// Small batch inference with constant weights which the kernel transposes or
+// converts on every call, unless they are prepacked.
+BM_MatmulConstWeights(1, 1024, 1024, true, float, DT_FLOAT);
+BM_MatmulConstWeights(8, 1024, 1024, true, float, DT_FLOAT);
+BM_MatmulConstWeights(1, 1024, 1024, false, bfloat16, DT_BFLOAT16);
+BM_MatmulConstWeights(8, 1024, 1024, false, bfloat16, DT_BFLOAT16);
+
 // Batch size of 1 included for inference.
 // Typical fully connected layers
 BM_Matmul(1, 512, 512, false, false);
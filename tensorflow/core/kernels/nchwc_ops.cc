@@ -0,0 +1,536 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// CPU kernels for the channel-blocked NCHWc layout (see FORMAT_NCHWc in
+// util/tensor_format.h). These ops are not meant to be used directly, Grappler
+// rewrites NHWC convolution stacks into them when the CPU layout conversion
+// is set to NHWC_TO_NCHWC.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_join.h"
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/kernel_shape_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/avgpooling_op.h"
+#include "tensorflow/core/kernels/maxpooling_op.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/padding.h"
+#include "tensorflow/core/util/tensor_format.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Number of adjacent output pixels of a row computed together by the
+// convolution micro-kernel. Every filter vector loaded from memory is reused
+// for all of them.
+constexpr int kNCHWcWidthBlock = 4;
+
+enum class NCHWcActivation { kNone, kRelu, kRelu6 };
+
+Status ValidateBlockSize(int64 block_size) {
+  if (block_size != 4 && block_size != 8 && block_size != 16) {
+    return errors::Unimplemented(
+        "NCHWc kernels only support block sizes 4, 8 and 16, got ",
+        block_size);
+  }
+  return Status::OK();
+}
+
+struct NCHWcConvParams {
+  int64 batch;
+  int64 in_blocks;
+  int64 in_rows;
+  int64 in_cols;
+  int64 out_blocks;
+  int64 out_rows;
+  int64 out_cols;
+  int64 filter_rows;
+  int64 filter_cols;
+  int64 stride_rows;
+  int64 stride_cols;
+  int64 pad_rows;
+  int64 pad_cols;
+  NCHWcActivation activation;
+};
+
+// Computes one output row [ow, kBlock] of output channel block `ob` for batch
+// `n`. `filter` is packed as [out_blocks, in_blocks, rows, cols, kBlock (in),
+// kBlock (out)], so that the innermost loop is a contiguous kBlock-wide
+// multiply-add. It is done on fixed size Eigen arrays, which Eigen vectorizes,
+// and the accumulators stay in SIMD registers.
+template <typename T, int kBlock>
+void NCHWcConv2DRow(const NCHWcConvParams& p, const T* input, const T* filter,
+                    const T* bias, T* output, int64 n, int64 ob, int64 oh) {
+  using Vector = Eigen::Array<T, kBlock, 1>;
+  using ConstVectorMap = Eigen::Map<const Vector>;
+
+  const T* input_n = input + n * p.in_blocks * p.in_rows * p.in_cols * kBlock;
+  const T* filter_ob = filter + ob * p.in_blocks * p.filter_rows *
+                                    p.filter_cols * kBlock * kBlock;
+  T* output_row = output + ((n * p.out_blocks + ob) * p.out_rows + oh) *
+                               p.out_cols * kBlock;
+
+  for (int64 ow_start = 0; ow_start < p.out_cols;
+       ow_start += kNCHWcWidthBlock) {
+    const int width = static_cast<int>(
+        std::min<int64>(kNCHWcWidthBlock, p.out_cols - ow_start));
+
+    Vector acc[kNCHWcWidthBlock];
+    for (int j = 0; j < kNCHWcWidthBlock; ++j) {
+      if (bias != nullptr) {
+        acc[j] = ConstVectorMap(bias + ob * kBlock);
+      } else {
+        acc[j].setZero();
+      }
+    }
+
+    for (int64 ib = 0; ib < p.in_blocks; ++ib) {
+      for (int64 kh = 0; kh < p.filter_rows; ++kh) {
+        const int64 ih = oh * p.stride_rows - p.pad_rows + kh;
+        if (ih < 0 || ih >= p.in_rows) continue;
+        const T* input_row =
+            input_n + (ib * p.in_rows + ih) * p.in_cols * kBlock;
+        const T* filter_row =
+            filter_ob +
+            (ib * p.filter_rows + kh) * p.filter_cols * kBlock * kBlock;
+
+        for (int64 kw = 0; kw < p.filter_cols; ++kw) {
+          const T* x[kNCHWcWidthBlock];
+          for (int j = 0; j < width; ++j) {
+            const int64 iw = (ow_start + j) * p.stride_cols - p.pad_cols + kw;
+            x[j] = (iw >= 0 && iw < p.in_cols) ? input_row + iw * kBlock
+                                               : nullptr;
+          }
+          const T* w = filter_row + kw * kBlock * kBlock;
+          for (int ci = 0; ci < kBlock; ++ci) {
+            const ConstVectorMap w_ci(w + ci * kBlock);
+            for (int j = 0; j < width; ++j) {
+              if (x[j] == nullptr) continue;
+              acc[j] += x[j][ci] * w_ci;
+            }
+          }
+        }
+      }
+    }
+
+    for (int j = 0; j < width; ++j) {
+      Eigen::Map<Vector> out(output_row + (ow_start + j) * kBlock);
+      switch (p.activation) {
+        case NCHWcActivation::kNone:
+          out = acc[j];
+          break;
+        case NCHWcActivation::kRelu:
+          out = acc[j].max(T(0));
+          break;
+        case NCHWcActivation::kRelu6:
+          out = acc[j].max(T(0)).min(T(6));
+          break;
+      }
+    }
+  }
+}
+
+template <typename T, int kBlock>
+void LaunchNCHWcConv2D(OpKernelContext* context, const NCHWcConvParams& p,
+                       const T* input, const T* filter, const T* bias,
+                       T* output) {
+  auto work = [&p, input, filter, bias, output](int64 start, int64 limit) {
+    for (int64 i = start; i < limit; ++i) {
+      const int64 oh = i % p.out_rows;
+      const int64 ob = (i / p.out_rows) % p.out_blocks;
+      const int64 n = i / (p.out_rows * p.out_blocks);
+      NCHWcConv2DRow<T, kBlock>(p, input, filter, bias, output, n, ob, oh);
+    }
+  };
+  const int64 cost_per_row = p.out_cols * p.in_blocks * p.filter_rows *
+                             p.filter_cols * kBlock * kBlock;
+  auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+  Shard(worker_threads.num_threads, worker_threads.workers,
+        p.batch * p.out_blocks * p.out_rows, cost_per_row, work);
+}
+
+}  // namespace
+
+// Converts [N, H, W, C] to [N, C / block_size, H, W, block_size].
+template <typename T>
+class ToNCHWcOp : public OpKernel {
+ public:
+  explicit ToNCHWcOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("block_size", &block_size_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    OP_REQUIRES(context, input.dims() == 4,
+                errors::InvalidArgument("input must be 4-dimensional: ",
+                                        input.shape().DebugString()));
+    const int64 batch = input.dim_size(0);
+    const int64 rows = input.dim_size(1);
+    const int64 cols = input.dim_size(2);
+    const int64 channels = input.dim_size(3);
+    OP_REQUIRES(context, channels % block_size_ == 0,
+                errors::InvalidArgument("Number of channels ", channels,
+                                        " is not a multiple of the block size ",
+                                        block_size_));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0,
+                       ShapeFromBlockedFormat(batch, {rows, cols}, channels,
+                                              block_size_),
+                       &output));
+    if (output->NumElements() == 0) return;
+
+    const Eigen::array<int, 5> perm({0, 3, 1, 2, 4});
+    output->tensor<T, 5>().device(context->eigen_device<CPUDevice>()) =
+        input
+            .shaped<T, 5>(
+                {batch, rows, cols, channels / block_size_, block_size_})
+            .shuffle(perm);
+  }
+
+ private:
+  int64 block_size_;
+};
+
+// Converts [N, C / c, H, W, c] to [N, H, W, C].
+template <typename T>
+class FromNCHWcOp : public OpKernel {
+ public:
+  explicit FromNCHWcOp(OpKernelConstruction* context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    OP_REQUIRES(context, input.dims() == 5,
+                errors::InvalidArgument("input must be 5-dimensional: ",
+                                        input.shape().DebugString()));
+    const int64 batch = input.dim_size(0);
+    const int64 blocks = input.dim_size(1);
+    const int64 rows = input.dim_size(2);
+    const int64 cols = input.dim_size(3);
+    const int64 block_size = input.dim_size(4);
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(
+        context,
+        context->allocate_output(
+            0, TensorShape({batch, rows, cols, blocks * block_size}), &output));
+    if (output->NumElements() == 0) return;
+
+    const Eigen::array<int, 5> perm({0, 2, 3, 1, 4});
+    output->shaped<T, 5>({batch, rows, cols, blocks, block_size})
+        .device(context->eigen_device<CPUDevice>()) =
+        input.tensor<T, 5>().shuffle(perm);
+  }
+};
+
+// Direct convolution of a NCHWc input with a HWIO filter, optionally fused
+// with a bias addition and a Relu/Relu6 activation.
+template <typename T>
+class NCHWcConv2DOp : public OpKernel {
+ public:
+  explicit NCHWcConv2DOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("strides", &strides_));
+    OP_REQUIRES(context, strides_.size() == 4,
+                errors::InvalidArgument("Sliding window strides field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES(context, strides_[0] == 1 && strides_[3] == 1,
+                errors::Unimplemented(
+                    "Current implementation does not yet support "
+                    "strides in the batch and depth dimensions."));
+    OP_REQUIRES(context, strides_[1] > 0 && strides_[2] > 0,
+                errors::InvalidArgument("Strides must be positive"));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+
+    int num_args;
+    OP_REQUIRES_OK(context, context->GetAttr("num_args", &num_args));
+    std::vector<string> fused_ops;
+    OP_REQUIRES_OK(context, context->GetAttr("fused_ops", &fused_ops));
+
+    activation_ = NCHWcActivation::kNone;
+    with_bias_ = false;
+    if (!fused_ops.empty()) {
+      OP_REQUIRES(context, fused_ops[0] == "BiasAdd" && fused_ops.size() <= 2,
+                  errors::Unimplemented("Fusion is not implemented: [",
+                                        absl::StrJoin(fused_ops, ","), "]"));
+      with_bias_ = true;
+      if (fused_ops.size() == 2) {
+        OP_REQUIRES(context,
+                    fused_ops[1] == "Relu" || fused_ops[1] == "Relu6",
+                    errors::Unimplemented("Fusion is not implemented: [",
+                                          absl::StrJoin(fused_ops, ","), "]"));
+        activation_ = fused_ops[1] == "Relu" ? NCHWcActivation::kRelu
+                                             : NCHWcActivation::kRelu6;
+      }
+    }
+    OP_REQUIRES(context, num_args == (with_bias_ ? 1 : 0),
+                errors::InvalidArgument(
+                    "Fused NCHWc convolution must have ", with_bias_ ? 1 : 0,
+                    " extra arguments: num_args=", num_args));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    const Tensor& filter = context->input(1);
+    OP_REQUIRES(context, input.dims() == 5,
+                errors::InvalidArgument("input must be 5-dimensional: ",
+                                        input.shape().DebugString()));
+    OP_REQUIRES(context, filter.dims() == 4,
+                errors::InvalidArgument("filter must be 4-dimensional: ",
+                                        filter.shape().DebugString()));
+
+    NCHWcConvParams p;
+    p.batch = input.dim_size(0);
+    p.in_blocks = input.dim_size(1);
+    p.in_rows = input.dim_size(2);
+    p.in_cols = input.dim_size(3);
+    const int64 block_size = input.dim_size(4);
+    OP_REQUIRES_OK(context, ValidateBlockSize(block_size));
+
+    p.filter_rows = filter.dim_size(0);
+    p.filter_cols = filter.dim_size(1);
+    const int64 in_depth = filter.dim_size(2);
+    const int64 out_depth = filter.dim_size(3);
+    OP_REQUIRES(context, in_depth == p.in_blocks * block_size,
+                errors::InvalidArgument(
+                    "input and filter must have the same depth: ",
+                    p.in_blocks * block_size, " vs ", in_depth));
+    OP_REQUIRES(context, out_depth % block_size == 0,
+                errors::InvalidArgument("Output depth ", out_depth,
+                                        " is not a multiple of the block size ",
+                                        block_size));
+    p.out_blocks = out_depth / block_size;
+
+    const T* bias_data = nullptr;
+    if (with_bias_) {
+      const Tensor& bias = context->input(2);
+      OP_REQUIRES(context, bias.dims() == 1 && bias.dim_size(0) == out_depth,
+                  errors::InvalidArgument("bias must be a vector of size ",
+                                          out_depth, ": ",
+                                          bias.shape().DebugString()));
+      bias_data = bias.flat<T>().data();
+    }
+
+    p.stride_rows = strides_[1];
+    p.stride_cols = strides_[2];
+    OP_REQUIRES_OK(context, GetWindowedOutputSize(
+                                p.in_rows, p.filter_rows, p.stride_rows,
+                                padding_, &p.out_rows, &p.pad_rows));
+    OP_REQUIRES_OK(context, GetWindowedOutputSize(
+                                p.in_cols, p.filter_cols, p.stride_cols,
+                                padding_, &p.out_cols, &p.pad_cols));
+    p.activation = activation_;
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0,
+                       ShapeFromBlockedFormat(p.batch, {p.out_rows, p.out_cols},
+                                              out_depth, block_size),
+                       &output));
+    if (output->NumElements() == 0) return;
+
+    Tensor packed_filter;
+    OP_REQUIRES_OK(context,
+                   GetPackedFilter(context, filter, p, block_size,
+                                   &packed_filter));
+
+    const T* input_data = input.flat<T>().data();
+    const T* filter_data = packed_filter.flat<T>().data();
+    T* output_data = output->flat<T>().data();
+    switch (block_size) {
+      case 4:
+        LaunchNCHWcConv2D<T, 4>(context, p, input_data, filter_data, bias_data,
+                                output_data);
+        break;
+      case 8:
+        LaunchNCHWcConv2D<T, 8>(context, p, input_data, filter_data, bias_data,
+                                output_data);
+        break;
+      case 16:
+        LaunchNCHWcConv2D<T, 16>(context, p, input_data, filter_data,
+                                 bias_data, output_data);
+        break;
+    }
+  }
+
+ private:
+  // Returns in `packed` the filter repacked from [rows, cols, in_blocks, c,
+  // out_blocks, c] to [out_blocks, in_blocks, rows, cols, c, c]. The filter
+  // is a constant in the graphs rewritten by Grappler, so the packed filter is
+  // kept until the kernel is fed another filter buffer.
+  Status GetPackedFilter(OpKernelContext* context, const Tensor& filter,
+                         const NCHWcConvParams& p, int64 block_size,
+                         Tensor* packed) {
+    {
+      mutex_lock lock(mu_);
+      if (packed_block_size_ == block_size) {
+        const Tensor* source = filter_source_.AccessTensor(context);
+        if (source->SharesBufferWith(filter) &&
+            source->shape() == filter.shape()) {
+          *packed = *packed_filter_.AccessTensor(context);
+          return Status::OK();
+        }
+      }
+    }
+
+    // Pack without holding the lock, like PrepackedMatMulWeights.
+    PersistentTensor new_packed;
+    Tensor* packed_tensor = nullptr;
+    TF_RETURN_IF_ERROR(context->allocate_persistent(
+        DataTypeToEnum<T>::value,
+        TensorShape({p.out_blocks, p.in_blocks, p.filter_rows, p.filter_cols,
+                     block_size, block_size}),
+        &new_packed, &packed_tensor));
+    const Eigen::array<int, 6> perm({4, 2, 0, 1, 3, 5});
+    packed_tensor->tensor<T, 6>().device(context->eigen_device<CPUDevice>()) =
+        filter
+            .shaped<T, 6>({p.filter_rows, p.filter_cols, p.in_blocks,
+                           block_size, p.out_blocks, block_size})
+            .shuffle(perm);
+
+    *packed = *packed_tensor;
+    mutex_lock lock(mu_);
+    filter_source_ = PersistentTensor(filter);
+    packed_filter_ = std::move(new_packed);
+    packed_block_size_ = block_size;
+    return Status::OK();
+  }
+
+  std::vector<int32> strides_;
+  Padding padding_;
+  bool with_bias_;
+  NCHWcActivation activation_;
+
+  mutex mu_;
+  // Block size of `packed_filter_`, or 0 if no filter was packed yet.
+  int64 packed_block_size_ TF_GUARDED_BY(mu_) = 0;
+  PersistentTensor filter_source_ TF_GUARDED_BY(mu_);
+  PersistentTensor packed_filter_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(NCHWcConv2DOp);
+};
+
+// Pooling on a NCHWc tensor. [N, C / c, H, W, c] is viewed as a NHWC tensor
+// with N * C / c batches and c channels, so the regular NHWC pooling functors
+// apply without any data movement.
+template <typename T, bool kIsMaxPool>
+class NCHWcPoolOp : public OpKernel {
+ public:
+  explicit NCHWcPoolOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("ksize", &ksize_));
+    OP_REQUIRES(context, ksize_.size() == 4,
+                errors::InvalidArgument("Sliding window ksize field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES_OK(context, context->GetAttr("strides", &strides_));
+    OP_REQUIRES(context, strides_.size() == 4,
+                errors::InvalidArgument("Sliding window stride field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES(context, ksize_[0] == 1 && strides_[0] == 1,
+                errors::Unimplemented(
+                    "Pooling is not yet supported on the batch dimension."));
+    OP_REQUIRES(context, ksize_[3] == 1 && strides_[3] == 1,
+                errors::Unimplemented(
+                    "Pooling is not yet supported on the depth dimension."));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    OP_REQUIRES(context, input.dims() == 5,
+                errors::InvalidArgument("input must be 5-dimensional: ",
+                                        input.shape().DebugString()));
+    const int64 batch = input.dim_size(0);
+    const int64 blocks = input.dim_size(1);
+    const int64 rows = input.dim_size(2);
+    const int64 cols = input.dim_size(3);
+    const int64 block_size = input.dim_size(4);
+
+    int64 out_rows, out_cols, pad_rows, pad_cols;
+    OP_REQUIRES_OK(context,
+                   GetWindowedOutputSize(rows, ksize_[1], strides_[1],
+                                         padding_, &out_rows, &pad_rows));
+    OP_REQUIRES_OK(context,
+                   GetWindowedOutputSize(cols, ksize_[2], strides_[2],
+                                         padding_, &out_cols, &pad_cols));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0,
+                                TensorShape({batch, blocks, out_rows, out_cols,
+                                             block_size}),
+                                &output));
+    if (output->NumElements() == 0) return;
+
+    auto in = input.shaped<T, 4>({batch * blocks, rows, cols, block_size});
+    auto out =
+        output->shaped<T, 4>({batch * blocks, out_rows, out_cols, block_size});
+    const CPUDevice& d = context->eigen_device<CPUDevice>();
+    const Eigen::PaddingType padding = BrainPadding2EigenPadding(padding_);
+    if (kIsMaxPool) {
+      functor::SpatialMaxPooling<CPUDevice, T>()(d, out, in, ksize_[1],
+                                                 ksize_[2], strides_[1],
+                                                 strides_[2], padding);
+    } else {
+      functor::SpatialAvgPooling<CPUDevice, T>()(d, out, in, ksize_[1],
+                                                 ksize_[2], strides_[1],
+                                                 strides_[2], padding);
+    }
+  }
+
+ private:
+  std::vector<int32> ksize_;
+  std::vector<int32> strides_;
+  Padding padding_;
+};
+
+#define REGISTER_CPU(T)                                                   \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("_ToNCHWc").Device(DEVICE_CPU).TypeConstraint<T>("T"),         \
+      ToNCHWcOp<T>);                                                      \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("_FromNCHWc").Device(DEVICE_CPU).TypeConstraint<T>("T"),       \
+      FromNCHWcOp<T>);                                                    \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("_NCHWcConv2D").Device(DEVICE_CPU).TypeConstraint<T>("T"),     \
+      NCHWcConv2DOp<T>);                                                  \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("_NCHWcMaxPool").Device(DEVICE_CPU).TypeConstraint<T>("T"),    \
+      NCHWcPoolOp<T, true>);                                              \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("_NCHWcAvgPool").Device(DEVICE_CPU).TypeConstraint<T>("T"),    \
+      NCHWcPoolOp<T, false>);
+
+TF_CALL_float(REGISTER_CPU);
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
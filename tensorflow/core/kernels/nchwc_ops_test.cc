@@ -0,0 +1,279 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace {
+
+class NCHWcLayoutOpTest : public OpsTestBase {};
+
+TEST_F(NCHWcLayoutOpTest, ToNCHWc) {
+  TF_ASSERT_OK(NodeDefBuilder("to_nchwc", "_ToNCHWc")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("T", DT_FLOAT)
+                   .Attr("block_size", 4)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({1, 1, 2, 8}),
+                           {0, 1, 2, 3, 4, 5, 6, 7,  //
+                            8, 9, 10, 11, 12, 13, 14, 15});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_FLOAT, TensorShape({1, 2, 1, 2, 4}));
+  test::FillValues<float>(&expected, {0, 1, 2, 3, 8, 9, 10, 11,  //
+                                      4, 5, 6, 7, 12, 13, 14, 15});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(NCHWcLayoutOpTest, ToNCHWcRequiresDivisibleChannels) {
+  TF_ASSERT_OK(NodeDefBuilder("to_nchwc", "_ToNCHWc")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("T", DT_FLOAT)
+                   .Attr("block_size", 8)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({1, 1, 1, 4}), {0, 1, 2, 3});
+  EXPECT_FALSE(RunOpKernel().ok());
+}
+
+// Compares the NCHWc kernels with the regular NHWC kernels by running both in
+// the same graph: input -> reference op, and
+// input -> _ToNCHWc -> NCHWc op -> _FromNCHWc.
+class NCHWcOpsTest : public ::testing::Test {
+ protected:
+  static Tensor RandomTensor(const TensorShape& shape) {
+    Tensor tensor(DT_FLOAT, shape);
+    tensor.flat<float>().setRandom();
+    tensor.flat<float>() -= tensor.flat<float>().constant(0.5f);
+    return tensor;
+  }
+
+  static void AddToNCHWc(const string& input, int block_size, GraphDef* graph) {
+    TF_ASSERT_OK(NodeDefBuilder("to_nchwc", "_ToNCHWc")
+                     .Input(input, 0, DT_FLOAT)
+                     .Attr("T", DT_FLOAT)
+                     .Attr("block_size", block_size)
+                     .Finalize(graph->add_node()));
+  }
+
+  static void AddFromNCHWc(const string& input, GraphDef* graph) {
+    TF_ASSERT_OK(NodeDefBuilder("from_nchwc", "_FromNCHWc")
+                     .Input(input, 0, DT_FLOAT)
+                     .Attr("T", DT_FLOAT)
+                     .Finalize(graph->add_node()));
+  }
+
+  static void RunAndCompare(GraphDef graph, const string& reference) {
+    SessionOptions session_options;
+    session_options.config.mutable_graph_options()
+        ->mutable_optimizer_options()
+        ->set_opt_level(OptimizerOptions::L0);
+    RewriterConfig* cfg = session_options.config.mutable_graph_options()
+                              ->mutable_rewrite_options();
+    cfg->set_constant_folding(RewriterConfig::OFF);
+    cfg->set_layout_optimizer(RewriterConfig::OFF);
+    cfg->set_remapping(RewriterConfig::OFF);
+    for (NodeDef& node : *graph.mutable_node()) {
+      node.set_device("/device:CPU:0");
+    }
+
+    std::unique_ptr<Session> session(NewSession(session_options));
+    TF_ASSERT_OK(session->Create(graph));
+    // The second run reuses the filter packed by the first one.
+    for (int run = 0; run < 2; ++run) {
+      std::vector<Tensor> outputs;
+      TF_ASSERT_OK(session->Run({}, {reference, "from_nchwc"}, {}, &outputs));
+      ASSERT_EQ(outputs.size(), 2);
+      test::ExpectTensorNear<float>(outputs[0], outputs[1], 1e-4);
+    }
+  }
+
+  void RunConv2D(int block_size, int filter_size, int stride,
+                 const string& padding, const string& activation) {
+    const int in_depth = 2 * block_size;
+    const int out_depth = 3 * block_size;
+    Scope root = Scope::NewRootScope();
+    auto input =
+        ops::Const(root.WithOpName("input"),
+                   Input::Initializer(RandomTensor({2, 9, 11, in_depth})));
+    auto filter = ops::Const(
+        root.WithOpName("filter"),
+        Input::Initializer(
+            RandomTensor({filter_size, filter_size, in_depth, out_depth})));
+    auto bias = ops::Const(root.WithOpName("bias"),
+                           Input::Initializer(RandomTensor({out_depth})));
+    auto conv = ops::Conv2D(root.WithOpName("conv"), input, filter,
+                            {1, stride, stride, 1}, padding);
+    Output reference = ops::BiasAdd(root.WithOpName("reference"), conv, bias);
+    std::vector<string> fused_ops = {"BiasAdd"};
+    if (activation == "Relu") {
+      reference = ops::Relu(root.WithOpName("reference_activation"), reference);
+      fused_ops.push_back(activation);
+    } else if (activation == "Relu6") {
+      reference =
+          ops::Relu6(root.WithOpName("reference_activation"), reference);
+      fused_ops.push_back(activation);
+    }
+
+    GraphDef graph;
+    TF_ASSERT_OK(root.ToGraphDef(&graph));
+    AddToNCHWc("input", block_size, &graph);
+    TF_ASSERT_OK(NodeDefBuilder("nchwc_conv", "_NCHWcConv2D")
+                     .Input("to_nchwc", 0, DT_FLOAT)
+                     .Input("filter", 0, DT_FLOAT)
+                     .Input(std::vector<NodeDefBuilder::NodeOut>{
+                         {"bias", 0, DT_FLOAT}})
+                     .Attr("T", DT_FLOAT)
+                     .Attr("num_args", 1)
+                     .Attr("strides", {1, stride, stride, 1})
+                     .Attr("padding", padding)
+                     .Attr("fused_ops", fused_ops)
+                     .Finalize(graph.add_node()));
+    AddFromNCHWc("nchwc_conv", &graph);
+
+    RunAndCompare(graph, reference.node()->name());
+  }
+
+  void RunPool(bool max_pool, int block_size, int window, int stride,
+               const string& padding) {
+    Scope root = Scope::NewRootScope();
+    auto input = ops::Const(
+        root.WithOpName("input"),
+        Input::Initializer(RandomTensor({2, 9, 11, 2 * block_size})));
+    const std::vector<int> ksize = {1, window, window, 1};
+    const std::vector<int> strides = {1, stride, stride, 1};
+    if (max_pool) {
+      ops::MaxPool(root.WithOpName("reference"), input, ksize, strides,
+                   padding);
+    } else {
+      ops::AvgPool(root.WithOpName("reference"), input, ksize, strides,
+                   padding);
+    }
+
+    GraphDef graph;
+    TF_ASSERT_OK(root.ToGraphDef(&graph));
+    AddToNCHWc("input", block_size, &graph);
+    TF_ASSERT_OK(NodeDefBuilder("nchwc_pool",
+                                max_pool ? "_NCHWcMaxPool" : "_NCHWcAvgPool")
+                     .Input("to_nchwc", 0, DT_FLOAT)
+                     .Attr("T", DT_FLOAT)
+                     .Attr("ksize", ksize)
+                     .Attr("strides", strides)
+                     .Attr("padding", padding)
+                     .Finalize(graph.add_node()));
+    AddFromNCHWc("nchwc_pool", &graph);
+
+    RunAndCompare(graph, "reference");
+  }
+};
+
+TEST_F(NCHWcOpsTest, Conv2D3x3Same) { RunConv2D(8, 3, 1, "SAME", ""); }
+
+TEST_F(NCHWcOpsTest, Conv2D3x3ValidStrided) {
+  RunConv2D(8, 3, 2, "VALID", "Relu");
+}
+
+TEST_F(NCHWcOpsTest, Conv2D1x1Block4) { RunConv2D(4, 1, 1, "VALID", "Relu"); }
+
+TEST_F(NCHWcOpsTest, Conv2D5x5Block16) {
+  RunConv2D(16, 5, 2, "SAME", "Relu6");
+}
+
+TEST_F(NCHWcOpsTest, MaxPool) { RunPool(true, 8, 3, 2, "SAME"); }
+
+TEST_F(NCHWcOpsTest, AvgPool) { RunPool(false, 8, 3, 2, "SAME"); }
+
+TEST_F(NCHWcOpsTest, AvgPoolValid) { RunPool(false, 16, 2, 2, "VALID"); }
+
+// Returns a graph with a 3x3 SAME convolution of a [batch, size, size, depth]
+// input into `depth` channels: a NHWC Conv2D, or a NCHWc convolution of an
+// input already in the blocked layout.
+Graph* Conv2DGraph(int batch, int size, int depth, int block_size) {
+  Tensor filter(DT_FLOAT, TensorShape({3, 3, depth, depth}));
+  filter.flat<float>().setRandom();
+  Scope root = Scope::NewRootScope();
+  if (block_size == 0) {
+    Tensor input(DT_FLOAT, TensorShape({batch, size, size, depth}));
+    input.flat<float>().setRandom();
+    ops::Conv2D(root.WithOpName("conv"),
+                ops::Const(root.WithOpName("input"), Input::Initializer(input)),
+                ops::Const(root.WithOpName("filter"),
+                           Input::Initializer(filter)),
+                {1, 1, 1, 1}, "SAME");
+  } else {
+    Tensor input(DT_FLOAT, TensorShape({batch, depth / block_size, size, size,
+                                        block_size}));
+    input.flat<float>().setRandom();
+    ops::Const(root.WithOpName("input"), Input::Initializer(input));
+    ops::Const(root.WithOpName("filter"), Input::Initializer(filter));
+  }
+
+  GraphDef graph_def;
+  TF_CHECK_OK(root.ToGraphDef(&graph_def));
+  if (block_size != 0) {
+    TF_CHECK_OK(NodeDefBuilder("conv", "_NCHWcConv2D")
+                    .Input("input", 0, DT_FLOAT)
+                    .Input("filter", 0, DT_FLOAT)
+                    .Input(std::vector<NodeDefBuilder::NodeOut>{})
+                    .Attr("T", DT_FLOAT)
+                    .Attr("num_args", 0)
+                    .Attr("strides", {1, 1, 1, 1})
+                    .Attr("padding", "SAME")
+                    .Attr("fused_ops", std::vector<string>{})
+                    .Finalize(graph_def.add_node()));
+  }
+  Graph* graph = new Graph(OpRegistry::Global());
+  TF_CHECK_OK(
+      ConvertGraphDefToGraph(GraphConstructorOptions(), graph_def, graph));
+  return graph;
+}
+
+// Arguments: batch, size, depth, block size (0 for the NHWC Conv2D).
+void BM_NCHWcConv2D(::testing::benchmark::State& state) {
+  const int batch = state.range(0);
+  const int size = state.range(1);
+  const int depth = state.range(2);
+  const int block_size = state.range(3);
+  test::Benchmark("cpu", Conv2DGraph(batch, size, depth, block_size),
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  state.SetItemsProcessed(state.iterations() * 2 * 9 * batch * size * size *
+                          depth * depth);
+}
+
+BENCHMARK(BM_NCHWcConv2D)
+    ->Args({1, 56, 64, 0})
+    ->Args({1, 56, 64, 8})
+    ->Args({1, 56, 64, 16})
+    ->Args({8, 28, 128, 0})
+    ->Args({8, 28, 128, 8})
+    ->Args({8, 28, 128, 16})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace tensorflow
@@ -424,6 +424,182 @@ output.
 create these operators.
 )doc");
 
+// --------------------------------------------------------------------------
+// Ops operating on channel-blocked (NCHWc) tensors. A NCHWc tensor has
+// dimensions [N, C / c, H, W, c], see FORMAT_NCHWc in util/tensor_format.h.
+// Spatial attributes (ksize, strides) keep the NHWC order of the ops they
+// replace.
+
+namespace {
+
+// Returns in `out` the [N, C / c, OH, OW, c] shape of a windowed op applied
+// to the NCHWc `input`, producing `out_channel_blocks` channel blocks.
+Status NCHWcWindowedOutputShape(InferenceContext* c, ShapeHandle input,
+                                DimensionHandle filter_rows,
+                                DimensionHandle filter_cols,
+                                DimensionHandle out_channel_blocks,
+                                ShapeHandle* out) {
+  std::vector<int32> strides;
+  TF_RETURN_IF_ERROR(c->GetAttr("strides", &strides));
+  if (strides.size() != 4) {
+    return errors::InvalidArgument(
+        "NCHWc ops require the stride attribute to contain 4 values, but got: ",
+        strides.size());
+  }
+  Padding padding;
+  TF_RETURN_IF_ERROR(c->GetAttr("padding", &padding));
+
+  DimensionHandle out_rows, out_cols;
+  TF_RETURN_IF_ERROR(GetWindowedOutputSizeFromDims(
+      c, c->Dim(input, 2), filter_rows, strides[1], padding, &out_rows));
+  TF_RETURN_IF_ERROR(GetWindowedOutputSizeFromDims(
+      c, c->Dim(input, 3), filter_cols, strides[2], padding, &out_cols));
+  *out = c->MakeShape({c->Dim(input, 0), out_channel_blocks, out_rows,
+                       out_cols, c->Dim(input, 4)});
+  return Status::OK();
+}
+
+Status NCHWcConv2DShape(InferenceContext* c) {
+  ShapeHandle input, filter;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 5, &input));
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 4, &filter));
+
+  DimensionHandle out_channel_blocks = c->UnknownDim();
+  if (c->ValueKnown(c->Dim(filter, 3)) && c->ValueKnown(c->Dim(input, 4))) {
+    TF_RETURN_IF_ERROR(c->Divide(c->Dim(filter, 3), c->Dim(input, 4),
+                                 /*evenly_divisible=*/true,
+                                 &out_channel_blocks));
+  }
+  ShapeHandle out;
+  TF_RETURN_IF_ERROR(NCHWcWindowedOutputShape(
+      c, input, c->Dim(filter, 0), c->Dim(filter, 1), out_channel_blocks,
+      &out));
+  c->set_output(0, out);
+  return Status::OK();
+}
+
+Status NCHWcPoolShape(InferenceContext* c) {
+  ShapeHandle input;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 5, &input));
+  std::vector<int32> ksize;
+  TF_RETURN_IF_ERROR(c->GetAttr("ksize", &ksize));
+  if (ksize.size() != 4) {
+    return errors::InvalidArgument(
+        "NCHWc pooling requires the ksize attribute to contain 4 values, but "
+        "got: ",
+        ksize.size());
+  }
+  ShapeHandle out;
+  TF_RETURN_IF_ERROR(NCHWcWindowedOutputShape(
+      c, input, c->MakeDim(ksize[1]), c->MakeDim(ksize[2]), c->Dim(input, 1),
+      &out));
+  c->set_output(0, out);
+  return Status::OK();
+}
+
+}  // namespace
+
+REGISTER_OP("_ToNCHWc")
+    .Input("x: T")
+    .Output("y: T")
+    .Attr("T: {float}")
+    .Attr("block_size: int >= 1")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle input;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &input));
+      int64 block_size;
+      TF_RETURN_IF_ERROR(c->GetAttr("block_size", &block_size));
+      DimensionHandle channel_blocks;
+      TF_RETURN_IF_ERROR(c->Divide(c->Dim(input, 3), block_size,
+                                   /*evenly_divisible=*/true,
+                                   &channel_blocks));
+      c->set_output(0, c->MakeShape({c->Dim(input, 0), channel_blocks,
+                                     c->Dim(input, 1), c->Dim(input, 2),
+                                     c->MakeDim(block_size)}));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Converts a NHWC tensor to the channel-blocked NCHWc layout, i.e. from
+[N, H, W, C] to [N, C / block_size, H, W, block_size].
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
+REGISTER_OP("_FromNCHWc")
+    .Input("x: T")
+    .Output("y: T")
+    .Attr("T: {float}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle input;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 5, &input));
+      DimensionHandle channels;
+      TF_RETURN_IF_ERROR(
+          c->Multiply(c->Dim(input, 1), c->Dim(input, 4), &channels));
+      c->set_output(0, c->MakeShape({c->Dim(input, 0), c->Dim(input, 2),
+                                     c->Dim(input, 3), channels}));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Converts a channel-blocked NCHWc tensor back to NHWC, i.e. from
+[N, C / c, H, W, c] to [N, H, W, C].
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
+REGISTER_OP("_NCHWcConv2D")
+    .Input("input: T")
+    .Input("filter: T")
+    .Input("args: num_args * T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("num_args: int >= 0")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .Attr("fused_ops: list(string) = []")
+    .SetShapeFn(NCHWcConv2DShape)
+    .Doc(R"doc(
+Computes a 2D convolution of a NCHWc `input` with a HWIO `filter`, producing a
+NCHWc output with the same block size as `input`.
+
+Supported `fused_ops` are [], ["BiasAdd"] and ["BiasAdd", A] where A is one of
+{"Relu", "Relu6"}. The bias is passed in `args`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
+REGISTER_OP("_NCHWcMaxPool")
+    .Input("input: T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("ksize: list(int) >= 4")
+    .Attr("strides: list(int) >= 4")
+    .Attr(GetPaddingAttrString())
+    .SetShapeFn(NCHWcPoolShape)
+    .Doc(R"doc(
+Performs max pooling on a NCHWc `input`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
+REGISTER_OP("_NCHWcAvgPool")
+    .Input("input: T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("ksize: list(int) >= 4")
+    .Attr("strides: list(int) >= 4")
+    .Attr(GetPaddingAttrString())
+    .SetShapeFn(NCHWcPoolShape)
+    .Doc(R"doc(
+Performs average pooling on a NCHWc `input`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
 namespace {
 
 Status CommonFusedConvCalculations(InferenceContext* c, bool has_resize) {
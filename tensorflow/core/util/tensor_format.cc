@@ -51,6 +51,8 @@ string ToString(TensorFormat format) {
       return "HWNC";
     case FORMAT_HWCN:
       return "HWCN";
+    case FORMAT_NCHWc:
+      return "NCHWc";
     default:
       LOG(FATAL) << "Invalid Format: " << static_cast<int32>(format);
       return "INVALID_FORMAT";
@@ -98,6 +100,10 @@ bool FormatFromString(absl::string_view format_str, TensorFormat* format) {
     *format = FORMAT_HWCN;
     return true;
   }
+  if (format_str == "NCHWc") {
+    *format = FORMAT_NCHWc;
+    return true;
+  }
   return false;
 }
 
@@ -67,6 +67,16 @@ enum TensorFormat {
 
   // FORMAT_HWCN is for TPUs.
   FORMAT_HWCN = 5,
+
+  // NCHWc is a channel-blocked layout used by CPU convolution kernels. It is
+  // laid out like NCHW_VECT_C, except that the size of the innermost block is
+  // not fixed: an NCHW tensor with dimensions [N, C, H, W] has dimensions
+  // [N, C/c, H, W, c] in NCHWc format, where c is typically the number of
+  // float lanes of a SIMD register (8 for AVX2, 16 for AVX-512). Keeping a
+  // whole block of channels contiguous lets the kernels vectorize over
+  // channels without any gather.
+  // A pre-condition of this format is that C must be a multiple of c.
+  FORMAT_NCHWc = 6,
 };
 
 // Tensor format for convolutional filters.
@@ -122,6 +132,7 @@ inline int GetTensorSpatialDims(int num_dims, TensorFormat format) {
       return num_dims - 2;  // Exclude N,C.
     case FORMAT_NCHW_VECT_C:
     case FORMAT_NHWC_VECT_W:
+    case FORMAT_NCHWc:
       // Note: the VECT_W is not counted as an independent spatial dim here,
       // since it just a component of the width dimension.
       return num_dims - 3;  // Exclude N,C,VectDim.
@@ -151,6 +162,7 @@ inline int GetTensorDimsFromSpatialDims(int num_spatial_dims,
       return num_spatial_dims + 2;  // Include N,C.
     case FORMAT_NCHW_VECT_C:
     case FORMAT_NHWC_VECT_W:
+    case FORMAT_NCHWc:
       return num_spatial_dims + 3;  // Include N,C,VectDim.
     default:
       LOG(FATAL) << "Unknown format " << format;
@@ -176,6 +188,7 @@ inline int GetTensorBatchDimIndex(int num_dims, TensorFormat format) {
     case FORMAT_NCHW:
     case FORMAT_NCHW_VECT_C:
     case FORMAT_NHWC_VECT_W:
+    case FORMAT_NCHWc:
       return 0;
     case FORMAT_HWNC:
       return num_dims - 2;
@@ -200,6 +213,7 @@ inline int GetTensorFeatureDimIndex(int num_dims, TensorFormat format) {
       return num_dims - 2;
     case FORMAT_NCHW:
     case FORMAT_NCHW_VECT_C:
+    case FORMAT_NCHWc:
       return 1;
     default:
       LOG(FATAL) << "Unknown format " << format;
@@ -209,7 +223,7 @@ inline int GetTensorFeatureDimIndex(int num_dims, TensorFormat format) {
 
 // Returns the index of the inner feature dimension.
 inline int GetTensorInnerFeatureDimIndex(int num_dims, TensorFormat format) {
-  DCHECK_EQ(format, FORMAT_NCHW_VECT_C);
+  DCHECK(format == FORMAT_NCHW_VECT_C || format == FORMAT_NCHWc) << format;
   return num_dims - 1;
 }
 
@@ -234,6 +248,7 @@ inline int GetTensorSpatialDimIndex(int num_dims, TensorFormat format,
       return spatial_dim + 1;
     case FORMAT_NCHW:
     case FORMAT_NCHW_VECT_C:
+    case FORMAT_NCHWc:
       return spatial_dim + 2;
     case FORMAT_HWNC:
     case FORMAT_HWCN:
@@ -307,8 +322,8 @@ inline int GetFilterTensorOutputChannelsDimIndex(int num_dims,
 // data 'tensor_format'.  'dimension' is a char that can be 'N' (batch size),
 // 'C' (channels), 'H' (height), 'W' (width),  or a numbered spatial dimension:
 // '0',  .. (NUM_SPATIAL_DIMS-1)..
-// If 'format' is NCHW_VECT_C and 'dimension' is 'C', returns the index of
-// the outer channel dimension (i.e. 1).
+// If 'format' is NCHW_VECT_C or NCHWc and 'dimension' is 'C', returns the
+// index of the outer channel dimension (i.e. 1).
 template <int NUM_SPATIAL_DIMS>
 inline int32 GetTensorDimIndex(TensorFormat format, char dimension) {
   if (format == FORMAT_NHWC || format == FORMAT_NHWC_VECT_W) {
@@ -325,7 +340,8 @@ inline int32 GetTensorDimIndex(TensorFormat format, char dimension) {
         LOG(FATAL) << "Invalid dimension: " << dimension;
         return -1;  // Avoid compiler warning about missing return value
     }
-  } else if (format == FORMAT_NCHW || format == FORMAT_NCHW_VECT_C) {
+  } else if (format == FORMAT_NCHW || format == FORMAT_NCHW_VECT_C ||
+             format == FORMAT_NCHWc) {
     switch (dimension) {
       case 'N': return 0;
       case 'C': return 1;
@@ -519,8 +535,12 @@ std::string GetConvnetDataFormat2D3DAttrString();
 // FORMAT_NCHW:        (N, C, spatial); rank = spatial.size() + 2
 // FORMAT_NCHW_VECT_C: (N, C, spatial, InnerC); rank = spatial.size() + 3
 // FORMAT_NHWC_VECT_W: (N, spatial, C, InnerW); rank = spatial.size() + 3
+// FORMAT_NCHWc is not supported since its block size is not implied by the
+// format, use ShapeFromBlockedFormat instead.
 inline TensorShape ShapeFromFormat(TensorFormat format, int64 N,
                                    gtl::ArraySlice<int64> spatial, int64 C) {
+  CHECK_NE(format, FORMAT_NCHWc)
+      << "ShapeFromFormat can't infer the block size of NCHWc";
   const int dims = GetTensorDimsFromSpatialDims(spatial.size(), format);
   gtl::InlinedVector<int64, 6> dim_sizes(dims);
   dim_sizes[GetTensorBatchDimIndex(dims, format)] = N;
@@ -548,6 +568,22 @@ inline TensorShape ShapeFromFormat(TensorFormat format, int64 N,
   return TensorShape(dim_sizes);
 }
 
+// Returns the FORMAT_NCHWc tensor shape (N, C / block_size, spatial,
+// block_size) for the specified dimension sizes.
+inline TensorShape ShapeFromBlockedFormat(int64 N,
+                                          gtl::ArraySlice<int64> spatial,
+                                          int64 C, int64 block_size) {
+  CHECK_GT(block_size, 0);
+  CHECK_EQ(0, C % block_size) << "NCHWc requires C to be a multiple of the "
+                              << "block size " << block_size << ", but C=" << C;
+  gtl::InlinedVector<int64, 6> dim_sizes;
+  dim_sizes.push_back(N);
+  dim_sizes.push_back(C / block_size);
+  dim_sizes.insert(dim_sizes.end(), spatial.begin(), spatial.end());
+  dim_sizes.push_back(block_size);
+  return TensorShape(dim_sizes);
+}
+
 // Return a tensor shape of the specified 'format', and dimensions.
 // Works for both 2D and 3D operations. If 'format' is OIHW_VECT_I,
 // the output TensorShape has spatial.size() + 3 dimensions, otherwise
@@ -595,8 +631,13 @@ inline TensorShape ShapeFromFormat(TensorFormat dst_format,
   }
 
   const int64 batch = GetTensorDim(src_shape, src_format, 'N');
-  const int64 channels = GetTensorDim(src_shape, src_format, 'C') *
-                         (src_format == FORMAT_NCHW_VECT_C ? 4 : 1);
+  int64 channels = GetTensorDim(src_shape, src_format, 'C');
+  if (src_format == FORMAT_NCHW_VECT_C) {
+    channels *= 4;
+  } else if (src_format == FORMAT_NCHWc) {
+    channels *= src_shape.dim_size(
+        GetTensorInnerFeatureDimIndex(src_shape.dims(), src_format));
+  }
   const int num_src_spatial_dims =
       GetTensorSpatialDims(src_shape.dims(), src_format);
   std::vector<int64> spatial_dims(num_src_spatial_dims);
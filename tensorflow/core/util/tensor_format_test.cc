@@ -29,6 +29,7 @@ std::pair<TensorFormat, const char*> test_data_formats[] = {
     EnumStringPair(FORMAT_NHWC),        EnumStringPair(FORMAT_NCHW),
     EnumStringPair(FORMAT_NCHW_VECT_C), EnumStringPair(FORMAT_NHWC_VECT_W),
     EnumStringPair(FORMAT_HWNC),        EnumStringPair(FORMAT_HWCN),
+    EnumStringPair(FORMAT_NCHWc),
 };
 
 std::pair<FilterTensorFormat, const char*> test_filter_formats[] = {
@@ -117,7 +118,8 @@ GetTensorDimMap(const int num_spatial_dims, const TensorFormat format) {
       (format == FORMAT_NHWC ||
        format == FORMAT_NHWC_VECT_W) ? DimMaps::kTdmNHWC[num_spatial_dims] :
       (format == FORMAT_NCHW ||
-       format == FORMAT_NCHW_VECT_C) ? DimMaps::kTdmNCHW[num_spatial_dims] :
+       format == FORMAT_NCHW_VECT_C ||
+       format == FORMAT_NCHWc) ? DimMaps::kTdmNCHW[num_spatial_dims] :
       (format == FORMAT_HWNC) ? DimMaps::kTdmHWNC[num_spatial_dims] :
       (format == FORMAT_HWCN) ? DimMaps::kTdmHWCN[num_spatial_dims]
                               : DimMaps::kTdmInvalid;
@@ -210,4 +212,18 @@ TEST(TensorFormatTest, DimensionIndexes) {
   RunDimensionIndexesTest<3>();
 }
 
+TEST(TensorFormatTest, BlockedShapes) {
+  TensorShape blocked = ShapeFromBlockedFormat(2, {5, 7}, 32, 8);
+  EXPECT_EQ(TensorShape({2, 4, 5, 7, 8}), blocked);
+  EXPECT_EQ(4, GetTensorInnerFeatureDimIndex(blocked.dims(), FORMAT_NCHWc));
+  EXPECT_EQ(4, GetTensorDim(blocked, FORMAT_NCHWc, 'C'));
+  EXPECT_EQ(5, GetTensorDim(blocked, FORMAT_NCHWc, 'H'));
+  EXPECT_EQ(7, GetTensorDim(blocked, FORMAT_NCHWc, 'W'));
+
+  EXPECT_EQ(TensorShape({2, 5, 7, 32}),
+            ShapeFromFormat(FORMAT_NHWC, blocked, FORMAT_NCHWc));
+  EXPECT_EQ(TensorShape({2, 32, 5, 7}),
+            ShapeFromFormat(FORMAT_NCHW, blocked, FORMAT_NCHWc));
+}
+
 }  // namespace tensorflow
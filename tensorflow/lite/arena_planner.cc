@@ -16,6 +16,8 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <limits>
 #include <set>
 #include <type_traits>
@@ -36,11 +38,20 @@ ArenaPlanner::ArenaPlanner(TfLiteContext* context,
       graph_info_(std::move(graph_info)),
       arena_(kDefaultArenaAlignment),
       persistent_arena_(kDefaultArenaAlignment),
+      dynamic_arena_(kDefaultArenaAlignment),
       preserve_inputs_(preserve_inputs),
       preserve_intermediates_(preserve_intermediates),
       tensor_alignment_(tensor_alignment) {}
 
-ArenaPlanner::~ArenaPlanner() {}
+ArenaPlanner::~ArenaPlanner() {
+  // The dynamic arena goes away with the planner, so make sure that no tensor
+  // data that would be freed as heap memory still points into it.
+  for (int i = 0; i < static_cast<int>(dynamic_allocs_.size()); ++i) {
+    if (IsInDynamicArena(i)) {
+      graph_info_->tensor(i)->data.raw = nullptr;
+    }
+  }
+}
 
 std::intptr_t ArenaPlanner::BasePointer(TfLiteAllocationType type) {
   if (type == kTfLiteArenaRwPersistent) {
@@ -49,6 +60,9 @@ std::intptr_t ArenaPlanner::BasePointer(TfLiteAllocationType type) {
   if (type == kTfLiteArenaRw) {
     return arena_.BasePointer();
   }
+  if (type == kTfLiteDynamic) {
+    return dynamic_arena_.BasePointer();
+  }
   return 0;
 }
 
@@ -186,6 +200,10 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
 
   // Note that graph outputs will never be scheduled for deallocation. We
   // could do that here for completeness, but it won't have any effect.
+
+  // The lifetimes may have changed, so the dynamic arena has to be replanned
+  // before the next invocation.
+  dynamic_plan_stale_ = true;
   return kTfLiteOk;
 }
 
@@ -253,6 +271,116 @@ bool ArenaPlanner::HasNonPersistentMemory() {
   return arena_.GetBufferSize() != 0;
 }
 
+bool ArenaPlanner::ReallocDynamicTensor(int tensor_index, size_t num_bytes) {
+  if (!IsDynamicArenaCandidate(tensor_index)) {
+    return false;
+  }
+  if (static_cast<int>(dynamic_high_water_bytes_.size()) <= tensor_index) {
+    dynamic_high_water_bytes_.resize(graph_info_->num_tensors(), 0);
+  }
+  if (num_bytes > dynamic_high_water_bytes_[tensor_index]) {
+    dynamic_high_water_bytes_[tensor_index] = num_bytes;
+    dynamic_plan_stale_ = true;
+  }
+  if (!IsInDynamicArena(tensor_index)) {
+    return false;
+  }
+  if (num_bytes <= dynamic_allocs_[tensor_index].size) {
+    return true;
+  }
+  // The tensor outgrew its place in the arena, so it lives on the heap until
+  // the arena is replanned with its new size.
+  return MoveDynamicTensorToHeap(tensor_index, num_bytes) == kTfLiteOk;
+}
+
+TfLiteStatus ArenaPlanner::PlanDynamicAllocations() {
+  if (!dynamic_plan_stale_) {
+    return kTfLiteOk;
+  }
+  // Start from a state where no tensor is in the arena, so that the contents
+  // of those that are read before being written again, i.e. temporaries and
+  // graph outputs, survive the arena being replanned and moved.
+  TF_LITE_ENSURE_STATUS(ReleaseDynamicAllocations());
+  TF_LITE_ENSURE_STATUS(dynamic_arena_.ClearPlan());
+
+  const size_t num_tensors = graph_info_->num_tensors();
+  dynamic_allocs_.assign(num_tensors, ArenaAllocWithUsageInterval());
+  dynamic_high_water_bytes_.resize(num_tensors, 0);
+  alloc_node_.resize(num_tensors, kNodeNotAssigned);
+  dealloc_node_.resize(num_tensors, kNodeNotAssigned);
+
+  // Some kernels fill dynamic temporaries once in Prepare() and use them in
+  // every invocation, so temporaries don't share memory with other tensors.
+  std::vector<bool> is_temporary(num_tensors, false);
+  for (size_t i = 0; i < graph_info_->num_execution_nodes(); ++i) {
+    const TfLiteIntArray* node_temporaries = graph_info_->node(i).temporaries;
+    for (int j = 0; j < node_temporaries->size; ++j) {
+      is_temporary[node_temporaries->data[j]] = true;
+    }
+  }
+
+  std::vector<int32_t> tensor_order;
+  for (int i = 0; i < static_cast<int>(num_tensors); ++i) {
+    if (dynamic_high_water_bytes_[i] > 0 &&
+        alloc_node_[i] != kNodeNotAssigned && IsDynamicArenaCandidate(i)) {
+      dynamic_high_water_bytes_[i] =
+          std::max(dynamic_high_water_bytes_[i], graph_info_->tensor(i)->bytes);
+      tensor_order.push_back(i);
+    }
+  }
+  dynamic_plan_stale_ = false;
+  if (tensor_order.empty()) {
+    return dynamic_arena_.ReleaseBuffer();
+  }
+
+  // As in CreateTensorAllocationVector(), larger tensors are placed first.
+  std::sort(tensor_order.begin(), tensor_order.end(),
+            [this](int idx1, int idx2) {
+              const size_t size1 = dynamic_high_water_bytes_[idx1];
+              const size_t size2 = dynamic_high_water_bytes_[idx2];
+              if (size1 != size2) {
+                return size1 > size2;
+              }
+              if (alloc_node_[idx1] != alloc_node_[idx2]) {
+                return alloc_node_[idx1] < alloc_node_[idx2];
+              }
+              return idx1 < idx2;
+            });
+  for (int tensor_index : tensor_order) {
+    const bool whole_run = is_temporary[tensor_index];
+    TF_LITE_ENSURE_STATUS(dynamic_arena_.Allocate(
+        context_, tensor_alignment_, dynamic_high_water_bytes_[tensor_index],
+        tensor_index, whole_run ? 0 : alloc_node_[tensor_index],
+        whole_run ? kNodeNotAssigned : dealloc_node_[tensor_index],
+        &dynamic_allocs_[tensor_index]));
+  }
+  TF_LITE_ENSURE_STATUS(dynamic_arena_.Commit(context_));
+
+  for (int tensor_index : tensor_order) {
+    TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+    char* data;
+    TF_LITE_ENSURE_STATUS(dynamic_arena_.ResolveAlloc(
+        context_, dynamic_allocs_[tensor_index], &data));
+    if (tensor.data.raw != nullptr) {
+      std::memcpy(data, tensor.data.raw, tensor.bytes);
+      std::free(tensor.data.raw);
+    }
+    tensor.data.raw = data;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus ArenaPlanner::ReleaseDynamicAllocations() {
+  for (int i = 0; i < static_cast<int>(dynamic_allocs_.size()); ++i) {
+    if (IsInDynamicArena(i)) {
+      TF_LITE_ENSURE_STATUS(
+          MoveDynamicTensorToHeap(i, graph_info_->tensor(i)->bytes));
+      dynamic_plan_stale_ = true;
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus ArenaPlanner::Commit() {
   TF_LITE_ENSURE_STATUS(arena_.Commit(context_));
   TF_LITE_ENSURE_STATUS(persistent_arena_.Commit(context_));
@@ -351,4 +479,41 @@ TfLiteStatus ArenaPlanner::ResolveTensorAllocation(int tensor_index) {
   return kTfLiteOk;
 }
 
+bool ArenaPlanner::IsDynamicArenaCandidate(int tensor_index) {
+  const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+  if (tensor.allocation_type != kTfLiteDynamic ||
+      tensor.type == kTfLiteString) {
+    return false;
+  }
+  // Graph inputs are written by the caller before Invoke(), so they are left
+  // on the heap.
+  const std::vector<int>& inputs = graph_info_->inputs();
+  return std::find(inputs.begin(), inputs.end(), tensor_index) == inputs.end();
+}
+
+bool ArenaPlanner::IsInDynamicArena(int tensor_index) {
+  if (tensor_index >= static_cast<int>(dynamic_allocs_.size()) ||
+      dynamic_allocs_[tensor_index].size == 0) {
+    return false;
+  }
+  const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+  return tensor.allocation_type == kTfLiteDynamic &&
+         tensor.data.raw ==
+             reinterpret_cast<char*>(dynamic_arena_.BasePointer()) +
+                 dynamic_allocs_[tensor_index].offset;
+}
+
+TfLiteStatus ArenaPlanner::MoveDynamicTensorToHeap(int tensor_index,
+                                                   size_t num_bytes) {
+  TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+  char* data = static_cast<char*>(std::malloc(num_bytes));
+  if (data != nullptr) {
+    std::memcpy(data, tensor.data.raw, std::min(tensor.bytes, num_bytes));
+  }
+  tensor.data.raw = data;
+  dynamic_allocs_[tensor_index].reset();
+  TF_LITE_ENSURE(context_, data != nullptr || num_bytes == 0);
+  return kTfLiteOk;
+}
+
 }  // namespace tflite
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_ARENA_PLANNER_H_
 #define TENSORFLOW_LITE_ARENA_PLANNER_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -43,6 +44,15 @@ struct AllocationInfo;
 // execution. Since dynamic tensors don't have sizes until after the
 // corresponding operation is executed, this class supports incremental
 // planning.
+//
+// The data of kTfLiteDynamic tensors is normally (re)allocated on the heap
+// while the model runs. To avoid doing so on every inference, this class
+// records the largest size each of them was resized to, and between
+// invocations places them in a separate arena using these sizes and the same
+// lifetimes as the other tensors. Dynamic temporaries keep their own memory
+// for the whole run, since their contents may outlive an invocation. A dynamic
+// tensor that outgrows its place in that arena moves back to the heap until
+// the next PlanDynamicAllocations().
 class ArenaPlanner : public MemoryPlanner {
  public:
   // Ownership of 'context' is not taken and it must remain util the
@@ -63,6 +73,9 @@ class ArenaPlanner : public MemoryPlanner {
   TfLiteStatus ReleaseNonPersistentMemory() override;
   TfLiteStatus AcquireNonPersistentMemory() override;
   bool HasNonPersistentMemory() override;
+  bool ReallocDynamicTensor(int tensor_index, size_t num_bytes) override;
+  TfLiteStatus PlanDynamicAllocations() override;
+  TfLiteStatus ReleaseDynamicAllocations() override;
 
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
@@ -98,6 +111,16 @@ class ArenaPlanner : public MemoryPlanner {
   // 'node_index'.
   TfLiteStatus CalculateDeallocationOfInternalTensors(int node_index);
 
+  // Returns true if 'tensor_index' may be placed in the dynamic arena.
+  bool IsDynamicArenaCandidate(int tensor_index);
+
+  // Returns true if the data of 'tensor_index' points into the dynamic arena.
+  bool IsInDynamicArena(int tensor_index);
+
+  // Moves 'tensor_index' from the dynamic arena to a new heap buffer of at
+  // least 'num_bytes', keeping its contents.
+  TfLiteStatus MoveDynamicTensorToHeap(int tensor_index, size_t num_bytes);
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -120,6 +143,20 @@ class ArenaPlanner : public MemoryPlanner {
   // declared as kTfLiteArenaRwPersistent.
   SimpleMemoryArena persistent_arena_;
 
+  // Raw memory buffer that is shared by kTfLiteDynamic tensors, based on the
+  // largest size each of them has had so far.
+  SimpleMemoryArena dynamic_arena_;
+
+  // Allocation data for the tensors placed in dynamic_arena_.
+  std::vector<ArenaAllocWithUsageInterval> dynamic_allocs_;
+
+  // The largest number of bytes each dynamic tensor was resized to.
+  std::vector<size_t> dynamic_high_water_bytes_;
+
+  // Whether a dynamic tensor grew, or the lifetimes changed, since
+  // dynamic_arena_ was last planned.
+  bool dynamic_plan_stale_ = false;
+
   // Ensure that the memory self-allocated for inputs is never reused by the
   // allocator. This allows for example, multiple runs without getting
   // unpredictable results.
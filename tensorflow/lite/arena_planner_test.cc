@@ -16,6 +16,8 @@ limitations under the License.
 
 #include <cstdarg>
 #include <cstdint>
+#include <cstring>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -218,6 +220,40 @@ class ArenaPlannerTest : public ::testing::Test {
     return offset;
   }
 
+  // Resizes the dynamic tensor as Subgraph::ResizeTensor() would, falling back
+  // to the heap if the planner doesn't provide the memory.
+  void ResizeDynamicTensor(int tensor_index, size_t num_bytes) {
+    TfLiteTensor& tensor = (*graph_->tensors())[tensor_index];
+    if (!planner_->ReallocDynamicTensor(tensor_index, num_bytes)) {
+      TfLiteTensorRealloc(num_bytes, &tensor);
+    }
+    tensor.bytes = num_bytes;
+  }
+
+  void PlanDynamicAllocations() {
+    CHECK(planner_->PlanDynamicAllocations() == kTfLiteOk);
+  }
+
+  // Moves the dynamic tensors back to the heap, frees them and destroys the
+  // planner while the graph is still alive.
+  void FreeDynamicTensors() {
+    CHECK(planner_->ReleaseDynamicAllocations() == kTfLiteOk);
+    for (TfLiteTensor& tensor : *graph_->tensors()) {
+      if (tensor.allocation_type == kTfLiteDynamic) {
+        TfLiteTensorDataFree(&tensor);
+      }
+    }
+    planner_.reset();
+  }
+
+  // Returns true if the given tensor is located in the dynamic arena.
+  bool IsInDynamicArena(int tensor_index) {
+    const TfLiteTensor& tensor = (*graph_->tensors())[tensor_index];
+    const std::intptr_t base = planner_->BasePointer(kTfLiteDynamic);
+    const std::intptr_t data = reinterpret_cast<std::intptr_t>(tensor.data.raw);
+    return base != 0 && data >= base && data < base + 1024;
+  }
+
   // Returns if the given tensor is unallocated or not.
   bool IsUnallocated(int tensor_index) {
     return (*graph_->tensors())[tensor_index].data.raw == nullptr;
@@ -711,6 +747,100 @@ TEST_F(ArenaPlannerTest, GraphWithIntermediates) {
   EXPECT_EQ(GetOffset(2), GetOffsetAfter(5));
 }
 
+TEST_F(ArenaPlannerTest, DynamicTensorsMoveToArenaAfterFirstInvocation) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},   // First op
+                      {{1}, {2}, {}},   // Second op
+                      {{2}, {3}, {5}},  // Third op
+                      {{3}, {4}, {}},   // Fourth op
+                  },
+                  {4});
+  const std::vector<int> dynamic_tensors = {1, 2, 3, 5};
+  for (int i : dynamic_tensors) {
+    (*graph.tensors())[i].allocation_type = kTfLiteDynamic;
+    (*graph.tensors())[i].bytes = 0;
+  }
+  SetGraph(&graph);
+  Execute(0, 10);
+
+  // The first invocation resizes the dynamic tensors on the heap.
+  PlanDynamicAllocations();
+  const size_t sizes[] = {0, 64, 32, 64, 0, 64};
+  for (int i : dynamic_tensors) {
+    ResizeDynamicTensor(i, sizes[i]);
+    std::memset((*graph.tensors())[i].data.raw, i, sizes[i]);
+    EXPECT_FALSE(IsInDynamicArena(i));
+  }
+
+  // Before the next one they move to the arena. Tensors 1 and 3 are never
+  // alive at the same time, so they share memory. The temporary gets memory of
+  // its own, and keeps its contents.
+  PlanDynamicAllocations();
+  for (int i : dynamic_tensors) {
+    EXPECT_TRUE(IsInDynamicArena(i));
+  }
+  EXPECT_EQ(GetOffset(1), 0);
+  EXPECT_EQ(GetOffset(3), 0);
+  EXPECT_EQ(GetOffset(5), GetOffsetAfter(3));
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(5));
+  EXPECT_EQ((*graph.tensors())[5].data.raw[63], 5);
+
+  // Resizing within the largest size seen stays in the arena.
+  char* data = (*graph.tensors())[2].data.raw;
+  ResizeDynamicTensor(2, 16);
+  ResizeDynamicTensor(2, 32);
+  EXPECT_EQ((*graph.tensors())[2].data.raw, data);
+
+  FreeDynamicTensors();
+}
+
+TEST_F(ArenaPlannerTest, DynamicTensorOutgrowingArenaMovesToHeap) {
+  TestGraph graph({0}, {{{0}, {1}, {}}, {{1}, {2}, {}}}, {2});
+  (*graph.tensors())[1].allocation_type = kTfLiteDynamic;
+  (*graph.tensors())[1].bytes = 0;
+  SetGraph(&graph);
+  Execute(0, 10);
+
+  ResizeDynamicTensor(1, 16);
+  PlanDynamicAllocations();
+  ASSERT_TRUE(IsInDynamicArena(1));
+  std::memset((*graph.tensors())[1].data.raw, 7, 16);
+
+  ResizeDynamicTensor(1, 256);
+  EXPECT_FALSE(IsInDynamicArena(1));
+  EXPECT_EQ((*graph.tensors())[1].data.raw[15], 7);
+
+  // The next plan uses the new size.
+  PlanDynamicAllocations();
+  EXPECT_TRUE(IsInDynamicArena(1));
+  EXPECT_EQ((*graph.tensors())[1].data.raw[15], 7);
+
+  FreeDynamicTensors();
+}
+
+TEST_F(ArenaPlannerTest, DynamicInputsAndStringsStayOnHeap) {
+  TestGraph graph({0}, {{{0}, {1}, {}}, {{1}, {2}, {}}}, {2});
+  (*graph.tensors())[0].allocation_type = kTfLiteDynamic;
+  (*graph.tensors())[0].bytes = 0;
+  (*graph.tensors())[1].allocation_type = kTfLiteDynamic;
+  (*graph.tensors())[1].type = kTfLiteString;
+  (*graph.tensors())[1].bytes = 0;
+  SetGraph(&graph);
+  Execute(0, 10);
+
+  EXPECT_FALSE(planner_->ReallocDynamicTensor(0, 16));
+  EXPECT_FALSE(planner_->ReallocDynamicTensor(1, 16));
+  ResizeDynamicTensor(0, 16);
+  ResizeDynamicTensor(1, 16);
+  PlanDynamicAllocations();
+  EXPECT_FALSE(IsInDynamicArena(0));
+  EXPECT_FALSE(IsInDynamicArena(1));
+
+  FreeDynamicTensors();
+}
+
 }  // namespace
 }  // namespace tflite
 
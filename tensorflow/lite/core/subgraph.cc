@@ -224,6 +224,10 @@ Subgraph::Subgraph(ErrorReporter* error_reporter,
 }
 
 Subgraph::~Subgraph() {
+  // Destroying the planner first moves dynamic tensors out of its memory, so
+  // that the loop below only frees heap buffers.
+  memory_planner_.reset();
+
   for (int node_index = 0; node_index < nodes_and_registration_.size();
        ++node_index) {
     CleanupNode(node_index);
@@ -990,6 +994,12 @@ TfLiteStatus Subgraph::Invoke() {
     return kTfLiteError;
   }
 
+  // Give the dynamic tensors planner-owned memory sized after the previous
+  // invocations, instead of reallocating them on the heap while running.
+  if (memory_planner_) {
+    TF_LITE_ENSURE_STATUS(memory_planner_->PlanDynamicAllocations());
+  }
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -1199,6 +1209,9 @@ TfLiteStatus Subgraph::SetTensorParametersReadOnly(
   }
 
   TfLiteTensor& tensor = context_.tensors[tensor_index];
+  if (memory_planner_ && tensor.allocation_type == kTfLiteDynamic) {
+    TF_LITE_ENSURE_STATUS(memory_planner_->ReleaseDynamicAllocations());
+  }
   if (type == tensor.type &&
       EqualArrayAndTfLiteIntArray(tensor.dims, rank, dims)) {
     // Fast path which does not invalidate the invokable property.
@@ -1265,6 +1278,9 @@ TfLiteStatus Subgraph::SetTensorParametersReadWrite(
   }
 
   TfLiteTensor& tensor = context_.tensors[tensor_index];
+  if (memory_planner_ && tensor.allocation_type == kTfLiteDynamic) {
+    TF_LITE_ENSURE_STATUS(memory_planner_->ReleaseDynamicAllocations());
+  }
   TfLiteTensorReset(type, name, ConvertArrayToTfLiteIntArray(rank, dims),
                     GetLegacyQuantization(quantization),
                     /*buffer=*/nullptr, required_bytes, allocation_type,
@@ -1305,8 +1321,16 @@ TfLiteStatus Subgraph::ResizeTensorImpl(TfLiteTensor* tensor,
         return kTfLiteError;
       }
 
-      // Realloc space for heap-allocated tensors.
-      TfLiteTensorRealloc(bytesRequired, tensor);
+      // Realloc space for heap-allocated tensors, unless the memory planner
+      // provides the memory of this dynamic tensor.
+      const int tensor_index = tensor - context_.tensors;
+      if (tensor->allocation_type != kTfLiteDynamic || !memory_planner_ ||
+          tensor_index < 0 ||
+          static_cast<size_t>(tensor_index) >= context_.tensors_size ||
+          !memory_planner_->ReallocDynamicTensor(tensor_index,
+                                                 bytesRequired)) {
+        TfLiteTensorRealloc(bytesRequired, tensor);
+      }
       tensor->bytes = bytesRequired;
     }
     if (tensor->dims) TfLiteIntArrayFree(tensor->dims);
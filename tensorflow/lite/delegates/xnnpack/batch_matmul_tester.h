@@ -0,0 +1,101 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_DELEGATES_XNNPACK_BATCH_MATMUL_TESTER_H_
+#define TENSORFLOW_LITE_DELEGATES_XNNPACK_BATCH_MATMUL_TESTER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace xnnpack {
+
+// Tests BATCH_MATMUL operators with a dynamic left-hand side input and a static
+// right-hand side, broadcasted across all batch dimensions of the input.
+class BatchMatMulTester {
+ public:
+  BatchMatMulTester() = default;
+  BatchMatMulTester(const BatchMatMulTester&) = delete;
+  BatchMatMulTester& operator=(const BatchMatMulTester&) = delete;
+
+  inline BatchMatMulTester& InputShape(std::initializer_list<int32_t> shape) {
+    for (auto it = shape.begin(); it != shape.end(); ++it) {
+      EXPECT_GT(*it, 0);
+    }
+    input_shape_ = std::vector<int32_t>(shape.begin(), shape.end());
+    input_size_ = ComputeSize(input_shape_);
+    return *this;
+  }
+
+  inline const std::vector<int32_t>& InputShape() const { return input_shape_; }
+
+  inline int32_t InputSize() const { return input_size_; }
+
+  inline int32_t InputChannels() const {
+    EXPECT_GE(input_shape_.size(), 2);
+    return input_shape_.back();
+  }
+
+  inline BatchMatMulTester& OutputChannels(int32_t output_channels) {
+    EXPECT_GT(output_channels, 0);
+    output_channels_ = output_channels;
+    return *this;
+  }
+
+  inline int32_t OutputChannels() const { return output_channels_; }
+
+  std::vector<int32_t> OutputShape() const;
+
+  // Number of dimensions of the right-hand side tensor. All dimensions but the
+  // last two are 1.
+  inline BatchMatMulTester& RHSRank(int32_t rhs_rank) {
+    EXPECT_GE(rhs_rank, 2);
+    rhs_rank_ = rhs_rank;
+    return *this;
+  }
+
+  inline int32_t RHSRank() const { return rhs_rank_; }
+
+  std::vector<int32_t> RHSShape() const;
+
+  inline BatchMatMulTester& AdjY(bool adj_y) {
+    adj_y_ = adj_y;
+    return *this;
+  }
+
+  inline bool AdjY() const { return adj_y_; }
+
+  void Test(TfLiteDelegate* delegate) const;
+
+ private:
+  std::vector<char> CreateTfLiteModel() const;
+
+  static int32_t ComputeSize(const std::vector<int32_t>& shape);
+
+  std::vector<int32_t> input_shape_;
+  int32_t input_size_ = 1;
+  int32_t output_channels_ = 1;
+  int32_t rhs_rank_ = 2;
+  bool adj_y_ = false;
+};
+
+}  // namespace xnnpack
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_DELEGATES_XNNPACK_BATCH_MATMUL_TESTER_H_
@@ -0,0 +1,217 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace tflite {
+namespace xnnpack {
+namespace {
+
+// Builds single-subgraph float models out of builtin operators, to count the
+// partitions which the delegate leaves in the execution plan.
+class ModelBuilder {
+ public:
+  ModelBuilder() {
+    buffers_.push_back(CreateBuffer(builder_, builder_.CreateVector({})));
+  }
+
+  flatbuffers::FlatBufferBuilder& builder() { return builder_; }
+
+  // Adds a tensor, which is a constant holding `data` if it is not empty.
+  template <typename T = float>
+  int32_t AddTensor(const std::vector<int32_t>& shape,
+                    const std::vector<T>& data = {},
+                    TensorType type = TensorType_FLOAT32) {
+    uint32_t buffer = 0;
+    if (!data.empty()) {
+      buffer = buffers_.size();
+      buffers_.push_back(CreateBuffer(
+          builder_,
+          builder_.CreateVector(reinterpret_cast<const uint8_t*>(data.data()),
+                                sizeof(T) * data.size())));
+    }
+    tensors_.push_back(CreateTensor(
+        builder_, builder_.CreateVector<int32_t>(shape.data(), shape.size()),
+        type, buffer));
+    return tensors_.size() - 1;
+  }
+
+  void AddOperator(BuiltinOperator op, const std::vector<int32_t>& inputs,
+                   const std::vector<int32_t>& outputs,
+                   BuiltinOptions options_type = BuiltinOptions_NONE,
+                   flatbuffers::Offset<void> options = 0) {
+    auto it = opcode_indices_.find(op);
+    if (it == opcode_indices_.end()) {
+      it = opcode_indices_.emplace(op, operator_codes_.size()).first;
+      operator_codes_.push_back(CreateOperatorCode(builder_, op));
+    }
+    operators_.push_back(CreateOperator(
+        builder_, it->second,
+        builder_.CreateVector<int32_t>(inputs.data(), inputs.size()),
+        builder_.CreateVector<int32_t>(outputs.data(), outputs.size()),
+        options_type, options));
+  }
+
+  std::vector<char> Build(const std::vector<int32_t>& inputs,
+                          const std::vector<int32_t>& outputs) {
+    flatbuffers::Offset<SubGraph> subgraph = CreateSubGraph(
+        builder_, builder_.CreateVector(tensors_.data(), tensors_.size()),
+        builder_.CreateVector<int32_t>(inputs.data(), inputs.size()),
+        builder_.CreateVector<int32_t>(outputs.data(), outputs.size()),
+        builder_.CreateVector(operators_.data(), operators_.size()));
+    flatbuffers::Offset<Model> model = CreateModel(
+        builder_, TFLITE_SCHEMA_VERSION,
+        builder_.CreateVector(operator_codes_.data(), operator_codes_.size()),
+        builder_.CreateVector(&subgraph, 1),
+        builder_.CreateString("Partitioning model"),
+        builder_.CreateVector(buffers_.data(), buffers_.size()));
+    builder_.Finish(model);
+    return std::vector<char>(builder_.GetBufferPointer(),
+                             builder_.GetBufferPointer() + builder_.GetSize());
+  }
+
+ private:
+  flatbuffers::FlatBufferBuilder builder_;
+  std::vector<flatbuffers::Offset<Buffer>> buffers_;
+  std::vector<flatbuffers::Offset<Tensor>> tensors_;
+  std::vector<flatbuffers::Offset<OperatorCode>> operator_codes_;
+  std::vector<flatbuffers::Offset<Operator>> operators_;
+  std::map<BuiltinOperator, int32_t> opcode_indices_;
+};
+
+// Returns the number of nodes of the execution plan of `buffer` once the
+// XNNPACK delegate is applied: one per delegate partition, plus one per node
+// left to TensorFlow Lite.
+int ExecutionPlanSize(const std::vector<char>& buffer) {
+  std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
+      xnnpack_delegate(TfLiteXNNPackDelegateCreate(nullptr),
+                       TfLiteXNNPackDelegateDelete);
+  std::unique_ptr<Interpreter> interpreter;
+  EXPECT_EQ(
+      InterpreterBuilder(
+          GetModel(buffer.data()),
+          ::tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates())(
+          &interpreter),
+      kTfLiteOk);
+  if (interpreter == nullptr) return -1;
+  EXPECT_EQ(interpreter->ModifyGraphWithDelegate(xnnpack_delegate.get()),
+            kTfLiteOk);
+  EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  return interpreter->execution_plan().size();
+}
+
+// Tensors of a model where the operator under test, which reads `x` and
+// writes `y`, sits between two RELUs, which the delegate always supports.
+struct BetweenRelus {
+  int32_t input;
+  int32_t x;
+  int32_t y;
+  int32_t output;
+};
+
+BetweenRelus AddRelus(ModelBuilder* model,
+                      const std::vector<int32_t>& input_shape,
+                      const std::vector<int32_t>& output_shape) {
+  BetweenRelus tensors;
+  tensors.input = model->AddTensor(input_shape);
+  tensors.x = model->AddTensor(input_shape);
+  tensors.y = model->AddTensor(output_shape);
+  tensors.output = model->AddTensor(output_shape);
+  model->AddOperator(BuiltinOperator_RELU, {tensors.input}, {tensors.x});
+  model->AddOperator(BuiltinOperator_RELU, {tensors.y}, {tensors.output});
+  return tensors;
+}
+
+TEST(Partitioning, TransposeConvIsDelegated) {
+  ModelBuilder model;
+  const BetweenRelus t = AddRelus(&model, {1, 8, 8, 8}, {1, 8, 8, 8});
+  const int32_t output_shape =
+      model.AddTensor<int32_t>({4}, {1, 8, 8, 8}, TensorType_INT32);
+  const int32_t filter =
+      model.AddTensor({8, 1, 1, 8}, std::vector<float>(64, 0.5f));
+  model.AddOperator(
+      BuiltinOperator_TRANSPOSE_CONV, {output_shape, filter, t.x}, {t.y},
+      BuiltinOptions_TransposeConvOptions,
+      CreateTransposeConvOptions(model.builder(), Padding_VALID,
+                                 /*stride_w=*/1, /*stride_h=*/1)
+          .Union());
+  EXPECT_EQ(ExecutionPlanSize(model.Build({t.input}, {t.output})), 1);
+}
+
+TEST(Partitioning, BatchMatMulWithStaticRHSIsDelegated) {
+  ModelBuilder model;
+  const BetweenRelus t = AddRelus(&model, {1, 4, 8}, {1, 4, 8});
+  const int32_t rhs = model.AddTensor({8, 8}, std::vector<float>(64, 0.5f));
+  model.AddOperator(
+      BuiltinOperator_BATCH_MATMUL, {t.x, rhs}, {t.y},
+      BuiltinOptions_BatchMatMulOptions,
+      CreateBatchMatMulOptions(model.builder(), /*adj_x=*/false,
+                               /*adj_y=*/false)
+          .Union());
+  EXPECT_EQ(ExecutionPlanSize(model.Build({t.input}, {t.output})), 1);
+}
+
+// The pinned XNNPACK revision has no subgraph nodes for CONCATENATION,
+// TRANSPOSE, SLICE and STRIDED_SLICE, which split the delegated graph into
+// two partitions around the node left to TensorFlow Lite.
+TEST(Partitioning, ConcatenationSplitsPartitions) {
+  ModelBuilder model;
+  const BetweenRelus t = AddRelus(&model, {1, 8, 8, 8}, {1, 8, 8, 16});
+  model.AddOperator(BuiltinOperator_CONCATENATION, {t.x, t.x}, {t.y},
+                    BuiltinOptions_ConcatenationOptions,
+                    CreateConcatenationOptions(model.builder(), /*axis=*/3)
+                        .Union());
+  EXPECT_EQ(ExecutionPlanSize(model.Build({t.input}, {t.output})), 3);
+}
+
+TEST(Partitioning, TransposeSplitsPartitions) {
+  ModelBuilder model;
+  const BetweenRelus t = AddRelus(&model, {1, 4, 8, 2}, {1, 8, 4, 2});
+  const int32_t perm =
+      model.AddTensor<int32_t>({4}, {0, 2, 1, 3}, TensorType_INT32);
+  model.AddOperator(BuiltinOperator_TRANSPOSE, {t.x, perm}, {t.y},
+                    BuiltinOptions_TransposeOptions,
+                    CreateTransposeOptions(model.builder()).Union());
+  EXPECT_EQ(ExecutionPlanSize(model.Build({t.input}, {t.output})), 3);
+}
+
+TEST(Partitioning, SliceSplitsPartitions) {
+  ModelBuilder model;
+  const BetweenRelus t = AddRelus(&model, {1, 8, 8, 8}, {1, 4, 4, 8});
+  const int32_t begin =
+      model.AddTensor<int32_t>({4}, {0, 2, 2, 0}, TensorType_INT32);
+  const int32_t size =
+      model.AddTensor<int32_t>({4}, {1, 4, 4, 8}, TensorType_INT32);
+  model.AddOperator(BuiltinOperator_SLICE, {t.x, begin, size}, {t.y},
+                    BuiltinOptions_SliceOptions,
+                    CreateSliceOptions(model.builder()).Union());
+  EXPECT_EQ(ExecutionPlanSize(model.Build({t.input}, {t.output})), 3);
+}
+
+}  // namespace
+}  // namespace xnnpack
+}  // namespace tflite
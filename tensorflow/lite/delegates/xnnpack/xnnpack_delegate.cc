@@ -121,6 +121,11 @@ class Subgraph {
       return nullptr;
     }
 
+    // Storage for the data of static XNNPACK Values which are not backed by
+    // any TFLite tensor (e.g. transposed weights). The data must outlive the
+    // XNNPACK subgraph, and is no longer used once the runtime is created.
+    std::vector<std::vector<float>> static_data;
+
     xnn_subgraph_t subgraph_ptr = nullptr;
     xnn_status status = xnn_create_subgraph(
         /*external_value_ids=*/context->tensors_size, /*flags=*/0,
@@ -166,6 +171,25 @@ class Subgraph {
             tensors[t] = t;
           }
           break;
+        case kTfLiteBuiltinBatchMatmul:
+          // Ignore the second input (static right-hand side matrix), because
+          // it is represented as a transposed copy created in VisitNode.
+          {
+            const int t = node->inputs->data[0];
+            tensors[t] = t;
+          }
+          break;
+        case kTfLiteBuiltinTransposeConv:
+          // Ignore the first input (output shape), because it is represented
+          // as parameters of the XNNPACK operator rather than extra input.
+          // The last input (bias) is optional.
+          for (int k = 1; k < node->inputs->size; k++) {
+            const int t = node->inputs->data[k];
+            if (t >= 0) {
+              tensors[t] = t;
+            }
+          }
+          break;
         default:
           // All other operators: process all inputs
           for (int k = 0; k < node->inputs->size; k++) {
@@ -254,7 +278,8 @@ class Subgraph {
       }
 
       if (VisitNode(subgraph.get(), context, registration, node, node_index,
-                    quasi_static_tensors, xnnpack_tensors) != kTfLiteOk) {
+                    quasi_static_tensors, xnnpack_tensors,
+                    &static_data) != kTfLiteOk) {
         return nullptr;
       }
     }
@@ -794,11 +819,100 @@ class Subgraph {
     return kTfLiteOk;
   }
 
+  static TfLiteStatus CheckTransposeConvolutionParams(
+      TfLiteContext* context, const TfLiteTransposeConvParams* params,
+      int node_index) {
+    if (params->stride_width <= 0) {
+      TF_LITE_MAYBE_KERNEL_LOG(context, "invalid stride width %d in node #%d",
+                               params->stride_width, node_index);
+      return kTfLiteError;
+    }
+    if (params->stride_height <= 0) {
+      TF_LITE_MAYBE_KERNEL_LOG(context, "invalid stride height %d in node #%d",
+                               params->stride_height, node_index);
+      return kTfLiteError;
+    }
+
+    return kTfLiteOk;
+  }
+
+  // Computes explicit XNNPACK Deconvolution padding and adjustment along one
+  // dimension, which reproduce the cropping of the TFLite TRANSPOSE_CONV
+  // operator for the requested output size.
+  static TfLiteStatus CalculateTransposeConvolutionPadding(
+      TfLiteContext* context, TfLitePadding padding, int input_size,
+      int kernel_size, int stride, int output_size, uint32_t* padding_before,
+      uint32_t* padding_after, uint32_t* adjustment, int node_index) {
+    // Same computation as ComputePaddingHeightWidth in kernels/padding.h, with
+    // the output of the operator in place of the convolution input.
+    int padded_size = 0;
+    switch (padding) {
+      case kTfLitePaddingSame:
+        padded_size = (output_size + stride - 1) / stride;
+        break;
+      case kTfLitePaddingValid:
+        padded_size = (output_size + stride - kernel_size) / stride;
+        break;
+      default:
+        TF_LITE_MAYBE_KERNEL_LOG(context,
+                                 "invalid padding mode (%d) in node #%d",
+                                 static_cast<int>(padding), node_index);
+        return kTfLiteError;
+    }
+    const int total_padding =
+        std::max((padded_size - 1) * stride + kernel_size - output_size, 0);
+    const int before = total_padding / 2;
+
+    // XNNPACK Deconvolution produces
+    //   (input_size - 1) * stride + kernel_size + adjustment - before - after
+    // elements, of which TFLite keeps output_size starting at offset `before`.
+    const int after = (input_size - 1) * stride + kernel_size - before -
+                      output_size;
+    if (after >= 0) {
+      *padding_after = static_cast<uint32_t>(after);
+      *adjustment = 0;
+    } else if (-after < stride) {
+      *padding_after = 0;
+      *adjustment = static_cast<uint32_t>(-after);
+    } else {
+      TF_LITE_MAYBE_KERNEL_LOG(
+          context,
+          "output size %d is incompatible with input size %d, kernel size %d "
+          "and stride %d in node #%d",
+          output_size, input_size, kernel_size, stride, node_index);
+      return kTfLiteError;
+    }
+    *padding_before = static_cast<uint32_t>(before);
+    return kTfLiteOk;
+  }
+
+  // Defines a static float XNNPACK Value which does not correspond to any
+  // TFLite tensor. The data is moved into `static_data`, which must outlive
+  // the XNNPACK subgraph.
+  static TfLiteStatus DefineStaticFloatValue(
+      xnn_subgraph_t subgraph, TfLiteContext* logging_context, int node_index,
+      std::vector<size_t> dims, std::vector<float> data,
+      std::vector<std::vector<float>>* static_data, uint32_t* value_id) {
+    static_data->push_back(std::move(data));
+    const xnn_status status = xnn_define_tensor_value(
+        subgraph, xnn_datatype_fp32, dims.size(), dims.data(),
+        static_data->back().data(), /*external_id=*/XNN_INVALID_VALUE_ID,
+        /*flags=*/0, value_id);
+    if (status != xnn_status_success) {
+      TF_LITE_KERNEL_LOG(logging_context,
+                         "failed to create XNNPACK Value for node #%d",
+                         node_index);
+      return kTfLiteError;
+    }
+    return kTfLiteOk;
+  }
+
   static TfLiteStatus VisitNode(
       xnn_subgraph_t subgraph, TfLiteContext* context,
       TfLiteRegistration* registration, TfLiteNode* node, int node_index,
       const std::unordered_set<int>& quasi_static_tensors,
-      const std::vector<uint32_t>& xnnpack_tensors) {
+      const std::vector<uint32_t>& xnnpack_tensors,
+      std::vector<std::vector<float>>* static_data) {
     // TFLite context used for logging purposes. When we create a new node
     // (subgraph is non-null), logging context is the same as context, and error
     // messages are passed to TFLite. When we detect supported operations
@@ -824,6 +938,15 @@ class Subgraph {
                                       node, context->tensors, pool_params,
                                       xnnpack_tensors);
       }
+      case kTfLiteBuiltinBatchMatmul: {
+        const TfLiteBatchMatMulParams* batch_matmul_params =
+            static_cast<const TfLiteBatchMatMulParams*>(node->builtin_data);
+
+        return VisitBatchMatMulNode(subgraph, logging_context, node_index,
+                                    node, context->tensors,
+                                    batch_matmul_params, xnnpack_tensors,
+                                    static_data);
+      }
       case kTfLiteBuiltinCeil:
         return VisitCeilNode(subgraph, logging_context, node_index, node,
                              context->tensors, xnnpack_tensors);
@@ -984,6 +1107,15 @@ class Subgraph {
         return VisitSubNode(subgraph, logging_context, node_index, node,
                             context->tensors, sub_params, xnnpack_tensors);
       }
+      case kTfLiteBuiltinTransposeConv: {
+        const TfLiteTransposeConvParams* deconv_params =
+            static_cast<const TfLiteTransposeConvParams*>(node->builtin_data);
+
+        return VisitTransposeConvNode(subgraph, logging_context, node_index,
+                                      node, context->tensors, deconv_params,
+                                      quasi_static_tensors, xnnpack_tensors,
+                                      static_data);
+      }
       case kTfLiteBuiltinCustom: {
         if (strcmp(registration->custom_name, "Convolution2DTransposeBias") ==
             0) {
@@ -1168,6 +1300,147 @@ class Subgraph {
     return kTfLiteOk;
   }
 
+  static TfLiteStatus VisitBatchMatMulNode(
+      xnn_subgraph_t subgraph, TfLiteContext* logging_context, int node_index,
+      TfLiteNode* node, const TfLiteTensor* tensors,
+      const TfLiteBatchMatMulParams* batch_matmul_params,
+      const std::vector<uint32_t>& xnnpack_tensors,
+      std::vector<std::vector<float>>* static_data) {
+    TF_LITE_ENSURE_STATUS(
+        CheckNumInputsAndOutputs(logging_context, node, 2, 1, node_index));
+
+    if (batch_matmul_params->adj_x) {
+      TF_LITE_MAYBE_KERNEL_LOG(
+          logging_context,
+          "unsupported adjoint left-hand side in BATCH_MATMUL node #%d",
+          node_index);
+      return kTfLiteError;
+    }
+
+    const TfLiteTensor& input_tensor = tensors[node->inputs->data[0]];
+    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+        logging_context, input_tensor, node->inputs->data[0], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, input_tensor, 2,
+                                           XNN_MAX_TENSOR_DIMS,
+                                           node->inputs->data[0]));
+    TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
+        logging_context, input_tensor, node->inputs->data[0], node_index));
+
+    // Only a static right-hand side is supported, which is then delegated as
+    // the filter of a Fully Connected operator.
+    const TfLiteTensor& rhs_tensor = tensors[node->inputs->data[1]];
+    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+        logging_context, rhs_tensor, node->inputs->data[1], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, rhs_tensor, 2,
+                                           input_tensor.dims->size,
+                                           node->inputs->data[1]));
+    TF_LITE_ENSURE_STATUS(CheckTensorStaticAllocation(
+        logging_context, rhs_tensor, node->inputs->data[1], node_index));
+
+    const int rhs_num_dims = rhs_tensor.dims->size;
+    for (int i = 0; i < rhs_num_dims - 2; i++) {
+      if (rhs_tensor.dims->data[i] != 1) {
+        TF_LITE_MAYBE_KERNEL_LOG(
+            logging_context,
+            "unsupported batch dimension #%d (%d) in right-hand side tensor "
+            "#%d in BATCH_MATMUL node #%d: expected 1",
+            i, rhs_tensor.dims->data[i], node->inputs->data[1], node_index);
+        return kTfLiteError;
+      }
+    }
+    const int rhs_rows = rhs_tensor.dims->data[rhs_num_dims - 2];
+    const int rhs_columns = rhs_tensor.dims->data[rhs_num_dims - 1];
+    const int input_channels =
+        batch_matmul_params->adj_y ? rhs_columns : rhs_rows;
+    const int output_channels =
+        batch_matmul_params->adj_y ? rhs_rows : rhs_columns;
+
+    const int input_num_dims = input_tensor.dims->size;
+    if (input_tensor.dims->data[input_num_dims - 1] != input_channels) {
+      TF_LITE_MAYBE_KERNEL_LOG(
+          logging_context,
+          "number of channels %d in input tensor #%d does not match input "
+          "channels %d in right-hand side tensor #%d",
+          input_tensor.dims->data[input_num_dims - 1], node->inputs->data[0],
+          input_channels, node->inputs->data[1]);
+      return kTfLiteError;
+    }
+
+    const TfLiteTensor& output_tensor = tensors[node->outputs->data[0]];
+    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+        logging_context, output_tensor, node->outputs->data[0], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, output_tensor,
+                                           input_num_dims,
+                                           node->outputs->data[0]));
+    TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
+        logging_context, output_tensor, node->outputs->data[0], node_index));
+
+    for (int i = 0; i < input_num_dims - 1; i++) {
+      if (input_tensor.dims->data[i] != output_tensor.dims->data[i]) {
+        TF_LITE_MAYBE_KERNEL_LOG(
+            logging_context,
+            "mismatch in shape dimension %d (%d != %d) in input and output "
+            "tensors of BATCH_MATMUL operator #%d",
+            i, input_tensor.dims->data[i], output_tensor.dims->data[i],
+            node_index);
+        return kTfLiteError;
+      }
+    }
+    if (output_tensor.dims->data[input_num_dims - 1] != output_channels) {
+      TF_LITE_MAYBE_KERNEL_LOG(
+          logging_context,
+          "number of channels %d in output tensor #%d does not match output "
+          "channels %d in right-hand side tensor #%d",
+          output_tensor.dims->data[input_num_dims - 1],
+          node->outputs->data[0], output_channels, node->inputs->data[1]);
+      return kTfLiteError;
+    }
+
+    if (subgraph != nullptr) {
+      // XNNPACK Fully Connected expects the filter in [output_channels,
+      // input_channels] layout, which is the right-hand side of BATCH_MATMUL
+      // with adj_y, and its transpose otherwise.
+      const float* rhs_data =
+          reinterpret_cast<const float*>(rhs_tensor.data.raw_const);
+      std::vector<float> filter_data(output_channels * input_channels);
+      for (int oc = 0; oc < output_channels; oc++) {
+        for (int ic = 0; ic < input_channels; ic++) {
+          filter_data[oc * input_channels + ic] =
+              batch_matmul_params->adj_y ? rhs_data[oc * input_channels + ic]
+                                         : rhs_data[ic * output_channels + oc];
+        }
+      }
+
+      uint32_t filter_id = XNN_INVALID_VALUE_ID;
+      TF_LITE_ENSURE_STATUS(DefineStaticFloatValue(
+          subgraph, logging_context, node_index,
+          {static_cast<size_t>(output_channels),
+           static_cast<size_t>(input_channels)},
+          std::move(filter_data), static_data, &filter_id));
+      uint32_t bias_id = XNN_INVALID_VALUE_ID;
+      TF_LITE_ENSURE_STATUS(DefineStaticFloatValue(
+          subgraph, logging_context, node_index,
+          {static_cast<size_t>(output_channels)},
+          std::vector<float>(output_channels, 0.0f), static_data, &bias_id));
+
+      const xnn_status status = xnn_define_fully_connected(
+          subgraph,
+          /*output_min=*/-std::numeric_limits<float>::infinity(),
+          /*output_max=*/+std::numeric_limits<float>::infinity(),
+          /*input_id=*/xnnpack_tensors[node->inputs->data[0]], filter_id,
+          bias_id,
+          /*output_id=*/xnnpack_tensors[node->outputs->data[0]], /*flags=*/0);
+      if (status != xnn_status_success) {
+        TF_LITE_KERNEL_LOG(logging_context,
+                           "failed to delegate BATCH_MATMUL node #%d",
+                           node_index);
+        return kTfLiteError;
+      }
+    }
+
+    return kTfLiteOk;
+  }
+
   static TfLiteStatus VisitCeilNode(
       xnn_subgraph_t subgraph, TfLiteContext* logging_context, int node_index,
       TfLiteNode* node, const TfLiteTensor* tensors,
@@ -1321,7 +1594,7 @@ class Subgraph {
 
     const TfLiteTensor& bias_tensor = tensors[node->inputs->data[2]];
     TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
-        logging_context, filter_tensor, node->inputs->data[2], node_index));
+        logging_context, bias_tensor, node->inputs->data[2], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, bias_tensor, 1,
                                            node->inputs->data[2]));
     if (quasi_static_tensors.count(node->inputs->data[2]) == 0) {
@@ -1505,7 +1778,7 @@ class Subgraph {
 
     const TfLiteTensor& bias_tensor = tensors[node->inputs->data[2]];
     TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
-        logging_context, filter_tensor, node->inputs->data[2], node_index));
+        logging_context, bias_tensor, node->inputs->data[2], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, bias_tensor, 1,
                                            node->inputs->data[2]));
     if (quasi_static_tensors.count(node->inputs->data[2]) == 0) {
@@ -1962,7 +2235,7 @@ class Subgraph {
 
     const TfLiteTensor& bias_tensor = tensors[node->inputs->data[2]];
     TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
-        logging_context, filter_tensor, node->inputs->data[2], node_index));
+        logging_context, bias_tensor, node->inputs->data[2], node_index));
     TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, bias_tensor, 1,
                                            node->inputs->data[2]));
     if (quasi_static_tensors.count(node->inputs->data[2]) == 0) {
@@ -2826,6 +3099,209 @@ class Subgraph {
     return kTfLiteOk;
   }
 
+  static TfLiteStatus VisitTransposeConvNode(
+      xnn_subgraph_t subgraph, TfLiteContext* logging_context, int node_index,
+      TfLiteNode* node, const TfLiteTensor* tensors,
+      const TfLiteTransposeConvParams* deconv_params,
+      const std::unordered_set<int>& quasi_static_tensors,
+      const std::vector<uint32_t>& xnnpack_tensors,
+      std::vector<std::vector<float>>* static_data) {
+    switch (node->inputs->size) {
+      case 3:
+      case 4:
+        break;
+      default:
+        TF_LITE_MAYBE_KERNEL_LOG(
+            logging_context,
+            "unexpected number of inputs (%d) in node #%d: "
+            "either three or four inputs expected",
+            node->inputs->size, node_index);
+        return kTfLiteError;
+    }
+    if (node->outputs->size != 1) {
+      TF_LITE_MAYBE_KERNEL_LOG(
+          logging_context,
+          "unexpected number of outputs (%d) in node #%d: one output expected",
+          node->outputs->size, node_index);
+      return kTfLiteError;
+    }
+
+    const TfLiteTensor& output_shape_tensor = tensors[node->inputs->data[0]];
+    TF_LITE_ENSURE_STATUS(CheckTensorType(logging_context, output_shape_tensor,
+                                          kTfLiteInt32, node->inputs->data[0],
+                                          node_index));
+    TF_LITE_ENSURE_STATUS(CheckShapeTensorShape(logging_context,
+                                                output_shape_tensor,
+                                                node->inputs->data[0],
+                                                node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorStaticAllocation(
+        logging_context, output_shape_tensor, node->inputs->data[0],
+        node_index));
+
+    const TfLiteTensor& filter_tensor = tensors[node->inputs->data[1]];
+    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+        logging_context, filter_tensor, node->inputs->data[1], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, filter_tensor, 4,
+                                           node->inputs->data[1]));
+    if (quasi_static_tensors.count(node->inputs->data[1]) == 0) {
+      TF_LITE_ENSURE_STATUS(CheckTensorStaticAllocation(
+          logging_context, filter_tensor, node->inputs->data[1], node_index));
+    }
+
+    const TfLiteTensor& input_tensor = tensors[node->inputs->data[2]];
+    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+        logging_context, input_tensor, node->inputs->data[2], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, input_tensor, 4,
+                                           node->inputs->data[2]));
+    TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
+        logging_context, input_tensor, node->inputs->data[2], node_index));
+
+    const int output_channels = filter_tensor.dims->data[0];
+    const int kernel_height = filter_tensor.dims->data[1];
+    const int kernel_width = filter_tensor.dims->data[2];
+    const int input_channels = filter_tensor.dims->data[3];
+
+    const bool has_bias =
+        node->inputs->size == 4 && node->inputs->data[3] >= 0;
+    if (has_bias) {
+      const TfLiteTensor& bias_tensor = tensors[node->inputs->data[3]];
+      TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+          logging_context, bias_tensor, node->inputs->data[3], node_index));
+      TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, bias_tensor, 1,
+                                             node->inputs->data[3]));
+      if (quasi_static_tensors.count(node->inputs->data[3]) == 0) {
+        TF_LITE_ENSURE_STATUS(CheckTensorStaticAllocation(
+            logging_context, bias_tensor, node->inputs->data[3], node_index));
+      }
+      if (bias_tensor.dims->data[0] != output_channels) {
+        TF_LITE_MAYBE_KERNEL_LOG(
+            logging_context,
+            "number of channels %d in bias tensor #%d does not match output "
+            "channels %d in filter tensor #%d",
+            bias_tensor.dims->data[0], node->inputs->data[3], output_channels,
+            node->inputs->data[1]);
+        return kTfLiteError;
+      }
+    }
+
+    const TfLiteTensor& output_tensor = tensors[node->outputs->data[0]];
+    TF_LITE_ENSURE_STATUS(CheckTensorFloatType(
+        logging_context, output_tensor, node->outputs->data[0], node_index));
+    TF_LITE_ENSURE_STATUS(CheckTensorShape(logging_context, output_tensor, 4,
+                                           node->outputs->data[0]));
+    TF_LITE_ENSURE_STATUS(CheckTensorNonDynamicAllocation(
+        logging_context, output_tensor, node->outputs->data[0], node_index));
+
+    if (output_shape_tensor.dims->data[0] != 4) {
+      TF_LITE_MAYBE_KERNEL_LOG(
+          logging_context,
+          "unexpected number of elements (%d) in output shape tensor #%d in "
+          "node #%d: 4 elements expected",
+          output_shape_tensor.dims->data[0], node->inputs->data[0],
+          node_index);
+      return kTfLiteError;
+    }
+    const int32_t* output_shape_data =
+        reinterpret_cast<const int32_t*>(output_shape_tensor.data.raw_const);
+    for (int i = 0; i < 4; i++) {
+      if (output_shape_data[i] != output_tensor.dims->data[i]) {
+        TF_LITE_MAYBE_KERNEL_LOG(
+            logging_context,
+            "mismatch in dimension %d (%d != %d) of output shape tensor #%d "
+            "and output tensor #%d in node #%d",
+            i, output_shape_data[i], output_tensor.dims->data[i],
+            node->inputs->data[0], node->outputs->data[0], node_index);
+        return kTfLiteError;
+      }
+    }
+
+    if (input_tensor.dims->data[0] != output_tensor.dims->data[0]) {
+      TF_LITE_MAYBE_KERNEL_LOG(
+          logging_context,
+          "mismatch in batch size (%d != %d) in input tensor #%d and output "
+          "tensor #%d in node #%d",
+          input_tensor.dims->data[0], output_tensor.dims->data[0],
+          node->inputs->data[2], node->outputs->data[0], node_index);
+      return kTfLiteError;
+    }
+    if (input_tensor.dims->data[3] != input_channels) {
+      TF_LITE_MAYBE_KERNEL_LOG(
+          logging_context,
+          "number of channels %d in input tensor #%d does not match input "
+          "channels %d in filter tensor #%d",
+          input_tensor.dims->data[3], node->inputs->data[2], input_channels,
+          node->inputs->data[1]);
+      return kTfLiteError;
+    }
+    if (output_tensor.dims->data[3] != output_channels) {
+      TF_LITE_MAYBE_KERNEL_LOG(
+          logging_context,
+          "number of channels %d in output tensor #%d does not match output "
+          "channels %d in filter tensor #%d",
+          output_tensor.dims->data[3], node->outputs->data[0],
+          output_channels, node->inputs->data[1]);
+      return kTfLiteError;
+    }
+
+    TF_LITE_ENSURE_STATUS(CheckTransposeConvolutionParams(
+        logging_context, deconv_params, node_index));
+
+    uint32_t padding_top = 0;
+    uint32_t padding_bottom = 0;
+    uint32_t adjustment_height = 0;
+    TF_LITE_ENSURE_STATUS(CalculateTransposeConvolutionPadding(
+        logging_context, deconv_params->padding, input_tensor.dims->data[1],
+        kernel_height, deconv_params->stride_height,
+        output_tensor.dims->data[1], &padding_top, &padding_bottom,
+        &adjustment_height, node_index));
+    uint32_t padding_left = 0;
+    uint32_t padding_right = 0;
+    uint32_t adjustment_width = 0;
+    TF_LITE_ENSURE_STATUS(CalculateTransposeConvolutionPadding(
+        logging_context, deconv_params->padding, input_tensor.dims->data[2],
+        kernel_width, deconv_params->stride_width, output_tensor.dims->data[2],
+        &padding_left, &padding_right, &adjustment_width, node_index));
+
+    if (subgraph != nullptr) {
+      uint32_t bias_id = XNN_INVALID_VALUE_ID;
+      if (has_bias) {
+        bias_id = xnnpack_tensors[node->inputs->data[3]];
+      } else {
+        TF_LITE_ENSURE_STATUS(DefineStaticFloatValue(
+            subgraph, logging_context, node_index,
+            {static_cast<size_t>(output_channels)},
+            std::vector<float>(output_channels, 0.0f), static_data, &bias_id));
+      }
+
+      const xnn_status status = xnn_define_deconvolution_2d(
+          subgraph, padding_top, padding_right, padding_bottom, padding_left,
+          adjustment_height, adjustment_width,
+          static_cast<uint32_t>(kernel_height),
+          static_cast<uint32_t>(kernel_width),
+          static_cast<uint32_t>(deconv_params->stride_height),
+          static_cast<uint32_t>(deconv_params->stride_width),
+          /*dilation_height=*/1,
+          /*dilation_width=*/1,
+          /*groups=*/1,
+          /*group_input_channels=*/input_channels,
+          /*group_output_channels=*/output_channels,
+          /*output_min=*/-std::numeric_limits<float>::infinity(),
+          /*output_max=*/+std::numeric_limits<float>::infinity(),
+          /*input_id=*/xnnpack_tensors[node->inputs->data[2]],
+          /*filter_id=*/xnnpack_tensors[node->inputs->data[1]], bias_id,
+          /*output_id=*/xnnpack_tensors[node->outputs->data[0]],
+          /*flags=*/0);
+      if (status != xnn_status_success) {
+        TF_LITE_KERNEL_LOG(logging_context,
+                           "failed to delegate TRANSPOSE_CONV node #%d",
+                           node_index);
+        return kTfLiteError;
+      }
+    }
+
+    return kTfLiteOk;
+  }
+
  private:
   Subgraph(xnn_runtime_t runtime, std::unordered_set<int>&& externals)
       : runtime_(runtime, &xnn_delete_runtime), externals_(externals) {}
@@ -2924,7 +3400,8 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
 
     if (Subgraph::VisitNode(/*subgraph=*/nullptr, context, registration, node,
                             node_index, quasi_static_tensors,
-                            std::vector<uint32_t>()) != kTfLiteOk) {
+                            std::vector<uint32_t>(),
+                            /*static_data=*/nullptr) != kTfLiteOk) {
       // If a non-delegated node consumes output of a node that unpacks static
       // data, that node shouldn't be delegated.
       for (int j = 0; j < node->inputs->size; j++) {
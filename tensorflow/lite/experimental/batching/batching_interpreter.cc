@@ -0,0 +1,288 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/batching/batching_interpreter.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/minimal_logging.h"
+#include "tensorflow/lite/profiling/time.h"
+
+namespace tflite {
+namespace batching {
+namespace {
+
+// Resizes dimension 0 of all inputs of `interpreter` to `batch_size` and
+// allocates the tensors for that size.
+TfLiteStatus ResizeToBatchSize(Interpreter* interpreter, int batch_size) {
+  for (int input : interpreter->inputs()) {
+    const TfLiteTensor* tensor = interpreter->tensor(input);
+    if (tensor->dims->size == 0) {
+      TFLITE_LOG(TFLITE_LOG_ERROR, "Input %d has no batch dimension.", input);
+      return kTfLiteError;
+    }
+    std::vector<int> dims(tensor->dims->data,
+                          tensor->dims->data + tensor->dims->size);
+    dims[0] = batch_size;
+    if (interpreter->ResizeInputTensor(input, dims) != kTfLiteOk) {
+      return kTfLiteError;
+    }
+  }
+  return interpreter->AllocateTensors();
+}
+
+// Computes the number of bytes of one example of each of `tensor_indices`,
+// checking that dimension 0 of the tensors is `batch_size`.
+TfLiteStatus GetBytesPerExample(const Interpreter& interpreter,
+                                const std::vector<int>& tensor_indices,
+                                int batch_size,
+                                std::vector<size_t>* bytes_per_example) {
+  bytes_per_example->clear();
+  for (int index : tensor_indices) {
+    const TfLiteTensor* tensor = interpreter.tensor(index);
+    if (tensor->type == kTfLiteString ||
+        tensor->allocation_type == kTfLiteDynamic) {
+      TFLITE_LOG(TFLITE_LOG_ERROR,
+                 "Tensor %d doesn't have a static size and can't be batched.",
+                 index);
+      return kTfLiteError;
+    }
+    if (tensor->dims->size == 0 || tensor->dims->data[0] != batch_size) {
+      TFLITE_LOG(TFLITE_LOG_ERROR,
+                 "Dimension 0 of tensor %d doesn't follow the batch size.",
+                 index);
+      return kTfLiteError;
+    }
+    bytes_per_example->push_back(tensor->bytes / batch_size);
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+std::unique_ptr<BatchingInterpreter> BatchingInterpreter::Create(
+    const SharedModel* shared_model, const BatchingOptions& options) {
+  if (shared_model == nullptr || options.allowed_batch_sizes.empty() ||
+      options.num_batch_threads <= 0 || options.max_enqueued_batches <= 0 ||
+      options.batch_timeout_micros < 0 ||
+      !std::is_sorted(options.allowed_batch_sizes.begin(),
+                      options.allowed_batch_sizes.end()) ||
+      options.allowed_batch_sizes.front() <= 0) {
+    TFLITE_LOG(TFLITE_LOG_ERROR, "Invalid batching options.");
+    return nullptr;
+  }
+
+  std::unique_ptr<BatchingInterpreter> batching_interpreter(
+      new BatchingInterpreter(options));
+  batching_interpreter->batch_interpreters_.resize(options.num_batch_threads);
+  for (auto& interpreters : batching_interpreter->batch_interpreters_) {
+    if (batching_interpreter->CreateBatchInterpreters(
+            shared_model, &interpreters) != kTfLiteOk) {
+      return nullptr;
+    }
+  }
+
+  // Threads are only started once all interpreters exist, so that a failure
+  // above doesn't have to stop them.
+  for (auto& interpreters : batching_interpreter->batch_interpreters_) {
+    BatchingInterpreter* self = batching_interpreter.get();
+    BatchInterpreters* thread_interpreters = &interpreters;
+    batching_interpreter->batch_threads_.emplace_back(
+        [self, thread_interpreters]() {
+          self->BatchThreadLoop(thread_interpreters);
+        });
+  }
+  return batching_interpreter;
+}
+
+BatchingInterpreter::BatchingInterpreter(const BatchingOptions& options)
+    : options_(options), max_batch_size_(options.allowed_batch_sizes.back()) {}
+
+BatchingInterpreter::~BatchingInterpreter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  queue_changed_.notify_all();
+  for (auto& thread : batch_threads_) {
+    thread.join();
+  }
+}
+
+TfLiteStatus BatchingInterpreter::CreateBatchInterpreters(
+    const SharedModel* shared_model, BatchInterpreters* interpreters) {
+  for (int batch_size : options_.allowed_batch_sizes) {
+    std::unique_ptr<Interpreter> interpreter;
+    if (shared_model->NewInterpreter(
+            &interpreter, options_.num_threads_per_interpreter) != kTfLiteOk ||
+        ResizeToBatchSize(interpreter.get(), batch_size) != kTfLiteOk) {
+      return kTfLiteError;
+    }
+
+    std::vector<size_t> input_bytes;
+    std::vector<size_t> output_bytes;
+    TF_LITE_ENSURE_STATUS(GetBytesPerExample(
+        *interpreter, interpreter->inputs(), batch_size, &input_bytes));
+    TF_LITE_ENSURE_STATUS(GetBytesPerExample(
+        *interpreter, interpreter->outputs(), batch_size, &output_bytes));
+    if (input_bytes_per_example_.empty() && output_bytes_per_example_.empty()) {
+      input_bytes_per_example_ = std::move(input_bytes);
+      output_bytes_per_example_ = std::move(output_bytes);
+    } else if (input_bytes != input_bytes_per_example_ ||
+               output_bytes != output_bytes_per_example_) {
+      TFLITE_LOG(TFLITE_LOG_ERROR,
+                 "The size of an example depends on the batch size.");
+      return kTfLiteError;
+    }
+
+    interpreters->push_back(std::move(interpreter));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BatchingInterpreter::Schedule(
+    const std::vector<const void*>& inputs, const std::vector<void*>& outputs,
+    DoneCallback done) {
+  if (inputs.size() != input_bytes_per_example_.size() ||
+      outputs.size() != output_bytes_per_example_.size() || !done) {
+    return kTfLiteError;
+  }
+
+  Request request;
+  request.inputs = inputs;
+  request.outputs = outputs;
+  request.done = std::move(done);
+  request.enqueue_time_us = profiling::time::NowMicros();
+  const size_t max_queued_requests =
+      static_cast<size_t>(options_.max_enqueued_batches) * max_batch_size_;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_ || queue_.size() >= max_queued_requests) {
+      return kTfLiteError;
+    }
+    queue_.push_back(std::move(request));
+  }
+  queue_changed_.notify_all();
+  return kTfLiteOk;
+}
+
+TfLiteStatus BatchingInterpreter::Invoke(
+    const std::vector<const void*>& inputs, const std::vector<void*>& outputs) {
+  std::mutex done_mutex;
+  std::condition_variable done_changed;
+  bool completed = false;
+  TfLiteStatus status = kTfLiteError;
+  TF_LITE_ENSURE_STATUS(
+      Schedule(inputs, outputs, [&](TfLiteStatus request_status) {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        status = request_status;
+        completed = true;
+        done_changed.notify_one();
+      }));
+
+  std::unique_lock<std::mutex> lock(done_mutex);
+  done_changed.wait(lock, [&completed]() { return completed; });
+  return status;
+}
+
+void BatchingInterpreter::BatchThreadLoop(BatchInterpreters* interpreters) {
+  std::vector<Request> batch;
+  while (TakeBatch(&batch)) {
+    RunBatch(interpreters, &batch);
+  }
+}
+
+bool BatchingInterpreter::TakeBatch(std::vector<Request>* batch) {
+  batch->clear();
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (queue_.empty()) {
+      if (stopping_) return false;
+      queue_changed_.wait(lock);
+      continue;
+    }
+    // A full batch, or the remaining requests on shutdown, run right away.
+    if (stopping_ || queue_.size() >= static_cast<size_t>(max_batch_size_)) {
+      break;
+    }
+    const uint64_t now_us = profiling::time::NowMicros();
+    const uint64_t deadline_us =
+        queue_.front().enqueue_time_us + options_.batch_timeout_micros;
+    if (now_us >= deadline_us) break;
+    queue_changed_.wait_for(lock,
+                            std::chrono::microseconds(deadline_us - now_us));
+  }
+
+  const size_t batch_size =
+      std::min(queue_.size(), static_cast<size_t>(max_batch_size_));
+  for (size_t i = 0; i < batch_size; ++i) {
+    batch->push_back(std::move(queue_.front()));
+    queue_.pop_front();
+  }
+  const bool more_requests = !queue_.empty();
+  lock.unlock();
+  if (more_requests) {
+    // Another batch thread may pick up the rest.
+    queue_changed_.notify_all();
+  }
+  return true;
+}
+
+void BatchingInterpreter::RunBatch(BatchInterpreters* interpreters,
+                                   std::vector<Request>* batch) {
+  const int num_requests = batch->size();
+  const auto& sizes = options_.allowed_batch_sizes;
+  const int bucket =
+      std::lower_bound(sizes.begin(), sizes.end(), num_requests) -
+      sizes.begin();
+  const int batch_size = sizes[bucket];
+  Interpreter* interpreter = (*interpreters)[bucket].get();
+
+  // Gather the examples into the rows of the inputs, and zero the padding
+  // rows so that they can't produce spurious floating point exceptions.
+  for (size_t i = 0; i < input_bytes_per_example_.size(); ++i) {
+    const size_t bytes = input_bytes_per_example_[i];
+    char* data = interpreter->tensor(interpreter->inputs()[i])->data.raw;
+    for (int r = 0; r < num_requests; ++r) {
+      std::memcpy(data + r * bytes, (*batch)[r].inputs[i], bytes);
+    }
+    std::memset(data + num_requests * bytes, 0,
+                (batch_size - num_requests) * bytes);
+  }
+
+  const TfLiteStatus status = interpreter->Invoke();
+
+  // Scatter the rows of the outputs back to the requests.
+  if (status == kTfLiteOk) {
+    for (size_t i = 0; i < output_bytes_per_example_.size(); ++i) {
+      const size_t bytes = output_bytes_per_example_[i];
+      const char* data =
+          interpreter->tensor(interpreter->outputs()[i])->data.raw;
+      for (int r = 0; r < num_requests; ++r) {
+        std::memcpy((*batch)[r].outputs[i], data + r * bytes, bytes);
+      }
+    }
+  }
+  for (Request& request : *batch) {
+    request.done(status);
+  }
+}
+
+}  // namespace batching
+}  // namespace tflite
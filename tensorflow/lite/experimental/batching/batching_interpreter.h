@@ -0,0 +1,157 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_BATCHING_BATCHING_INTERPRETER_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_BATCHING_BATCHING_INTERPRETER_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/shared_model.h"
+
+namespace tflite {
+namespace batching {
+
+struct BatchingOptions {
+  // The batch sizes the model is run with, in increasing order. A batch of n
+  // requests runs with the smallest allowed size that is >= n, padding the
+  // remaining rows; the last entry is the maximum batch size. Each size gets
+  // its own pre-allocated interpreter per batch thread, so switching between
+  // sizes never re-plans the tensor allocations.
+  std::vector<int> allowed_batch_sizes = {1, 2, 4, 8, 16, 32};
+
+  // The maximum time a request waits for more requests to join its batch
+  // before the batch is run anyway.
+  int64_t batch_timeout_micros = 1000;
+
+  // The maximum number of full batches that may wait in the queue. Requests
+  // beyond that are rejected right away instead of adding to the latency of
+  // all queued requests.
+  int max_enqueued_batches = 16;
+
+  // The number of threads forming and running batches concurrently.
+  int num_batch_threads = 1;
+
+  // The number of threads each interpreter may use for a single invocation.
+  int num_threads_per_interpreter = 1;
+};
+
+// Runs single-example requests against a TFLite model in batches.
+//
+// Requests are queued and grouped into batches of up to the maximum allowed
+// batch size. Every batch is copied into the inputs of an interpreter whose
+// inputs were resized (along dimension 0) to one of the allowed batch sizes,
+// invoked once, and its outputs are scattered back to the requests. This
+// mirrors the behavior of TensorFlow's SharedBatchScheduler for a single
+// model, and trades a bounded amount of latency for better throughput on
+// models that benefit from larger batches.
+//
+// The interpreters of all batch sizes and batch threads are created from one
+// SharedModel, so they share the weights and the data derived from them.
+//
+// All inputs and outputs of the model must have the batch as dimension 0, and
+// the model must support resizing it.
+//
+// WARNING: This is an experimental API and subject to change.
+class BatchingInterpreter {
+ public:
+  // Called once a scheduled request completes, from one of the batch threads.
+  using DoneCallback = std::function<void(TfLiteStatus)>;
+
+  // Creates the interpreters for every allowed batch size and starts the batch
+  // threads. `shared_model` must outlive the returned object. Returns nullptr
+  // if the options are invalid or the model can't be batched.
+  static std::unique_ptr<BatchingInterpreter> Create(
+      const SharedModel* shared_model, const BatchingOptions& options);
+
+  // Runs the remaining queued requests and joins the batch threads.
+  ~BatchingInterpreter();
+
+  BatchingInterpreter(const BatchingInterpreter&) = delete;
+  BatchingInterpreter& operator=(const BatchingInterpreter&) = delete;
+
+  int num_inputs() const { return input_bytes_per_example_.size(); }
+  int num_outputs() const { return output_bytes_per_example_.size(); }
+
+  // Number of bytes of a single example of the i-th input or output.
+  size_t input_bytes_per_example(int i) const {
+    return input_bytes_per_example_[i];
+  }
+  size_t output_bytes_per_example(int i) const {
+    return output_bytes_per_example_[i];
+  }
+
+  // Queues a request for one example. `inputs[i]` points to one example of the
+  // i-th model input, and the i-th output is written to `outputs[i]`. The
+  // buffers must stay valid until `done` is called. Returns an error without
+  // calling `done` if the queue is full or the arguments are invalid.
+  TfLiteStatus Schedule(const std::vector<const void*>& inputs,
+                        const std::vector<void*>& outputs, DoneCallback done);
+
+  // Like Schedule(), but blocks until the request has completed.
+  TfLiteStatus Invoke(const std::vector<const void*>& inputs,
+                      const std::vector<void*>& outputs);
+
+ private:
+  struct Request {
+    std::vector<const void*> inputs;
+    std::vector<void*> outputs;
+    DoneCallback done;
+    uint64_t enqueue_time_us;
+  };
+
+  // The interpreters owned by one batch thread, one per allowed batch size.
+  using BatchInterpreters = std::vector<std::unique_ptr<Interpreter>>;
+
+  explicit BatchingInterpreter(const BatchingOptions& options);
+
+  TfLiteStatus CreateBatchInterpreters(const SharedModel* shared_model,
+                                       BatchInterpreters* interpreters);
+
+  void BatchThreadLoop(BatchInterpreters* interpreters);
+
+  // Waits for the next batch to form, and moves its requests out of the
+  // queue. Returns false once the object is being destroyed and the queue is
+  // empty.
+  bool TakeBatch(std::vector<Request>* batch);
+
+  void RunBatch(BatchInterpreters* interpreters, std::vector<Request>* batch);
+
+  const BatchingOptions options_;
+  const int max_batch_size_;
+  std::vector<size_t> input_bytes_per_example_;
+  std::vector<size_t> output_bytes_per_example_;
+
+  std::vector<BatchInterpreters> batch_interpreters_;
+  std::vector<std::thread> batch_threads_;
+
+  std::mutex mutex_;
+  std::condition_variable queue_changed_;
+  std::deque<Request> queue_;
+  bool stopping_ = false;
+};
+
+}  // namespace batching
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_BATCHING_BATCHING_INTERPRETER_H_
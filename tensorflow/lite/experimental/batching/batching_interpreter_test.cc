@@ -0,0 +1,153 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/batching/batching_interpreter.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/shared_model.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace batching {
+namespace {
+
+// The model computes output = 3 * input for inputs of shape [batch, 8, 8, 3].
+constexpr char kAddModel[] = "tensorflow/lite/testdata/add.bin";
+constexpr int kExampleSize = 8 * 8 * 3;
+
+class BatchingInterpreterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    model_ = FlatBufferModel::BuildFromFile(kAddModel);
+    ASSERT_NE(model_, nullptr);
+    shared_model_ = SharedModel::Create(model_.get(), resolver_);
+    ASSERT_NE(shared_model_, nullptr);
+  }
+
+  std::unique_ptr<FlatBufferModel> model_;
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver_;
+  std::unique_ptr<SharedModel> shared_model_;
+};
+
+void ExpectTripled(const std::vector<float>& input,
+                   const std::vector<float>& output) {
+  ASSERT_EQ(input.size(), output.size());
+  for (size_t i = 0; i < input.size(); ++i) {
+    EXPECT_FLOAT_EQ(output[i], 3.0f * input[i]);
+  }
+}
+
+TEST_F(BatchingInterpreterTest, SingleRequest) {
+  auto batching_interpreter =
+      BatchingInterpreter::Create(shared_model_.get(), BatchingOptions());
+  ASSERT_NE(batching_interpreter, nullptr);
+  EXPECT_EQ(batching_interpreter->input_bytes_per_example(0),
+            kExampleSize * sizeof(float));
+  EXPECT_EQ(batching_interpreter->output_bytes_per_example(0),
+            kExampleSize * sizeof(float));
+
+  std::vector<float> input(kExampleSize);
+  for (int i = 0; i < kExampleSize; ++i) input[i] = i;
+  std::vector<float> output(kExampleSize);
+  ASSERT_EQ(batching_interpreter->Invoke({input.data()}, {output.data()}),
+            kTfLiteOk);
+  ExpectTripled(input, output);
+}
+
+TEST_F(BatchingInterpreterTest, ConcurrentRequests) {
+  BatchingOptions options;
+  options.allowed_batch_sizes = {1, 2, 4, 8};
+  options.num_batch_threads = 2;
+  auto batching_interpreter =
+      BatchingInterpreter::Create(shared_model_.get(), options);
+  ASSERT_NE(batching_interpreter, nullptr);
+
+  constexpr int kNumClients = 8;
+  constexpr int kNumRequestsPerClient = 20;
+  std::vector<std::thread> clients;
+  for (int c = 0; c < kNumClients; ++c) {
+    clients.emplace_back([&batching_interpreter, c]() {
+      std::vector<float> input(kExampleSize);
+      std::vector<float> output(kExampleSize);
+      for (int r = 0; r < kNumRequestsPerClient; ++r) {
+        for (int i = 0; i < kExampleSize; ++i) input[i] = c * 1000 + r + i;
+        ASSERT_EQ(batching_interpreter->Invoke({input.data()}, {output.data()}),
+                  kTfLiteOk);
+        ExpectTripled(input, output);
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+}
+
+TEST_F(BatchingInterpreterTest, ScheduleCallsDone) {
+  auto batching_interpreter =
+      BatchingInterpreter::Create(shared_model_.get(), BatchingOptions());
+  ASSERT_NE(batching_interpreter, nullptr);
+
+  constexpr int kNumRequests = 5;
+  std::vector<std::vector<float>> inputs(kNumRequests,
+                                         std::vector<float>(kExampleSize, 1));
+  std::vector<std::vector<float>> outputs(kNumRequests,
+                                          std::vector<float>(kExampleSize));
+  std::vector<TfLiteStatus> statuses(kNumRequests, kTfLiteError);
+  for (int r = 0; r < kNumRequests; ++r) {
+    auto done = [&statuses, r](TfLiteStatus status) { statuses[r] = status; };
+    ASSERT_EQ(batching_interpreter->Schedule({inputs[r].data()},
+                                             {outputs[r].data()}, done),
+              kTfLiteOk);
+  }
+  // Destruction runs the queued requests before joining the batch threads.
+  batching_interpreter.reset();
+  for (int r = 0; r < kNumRequests; ++r) {
+    EXPECT_EQ(statuses[r], kTfLiteOk);
+    ExpectTripled(inputs[r], outputs[r]);
+  }
+}
+
+TEST_F(BatchingInterpreterTest, RejectsInvalidArguments) {
+  auto batching_interpreter =
+      BatchingInterpreter::Create(shared_model_.get(), BatchingOptions());
+  ASSERT_NE(batching_interpreter, nullptr);
+  std::vector<float> output(kExampleSize);
+  EXPECT_EQ(batching_interpreter->Invoke({}, {output.data()}), kTfLiteError);
+}
+
+TEST_F(BatchingInterpreterTest, RejectsInvalidOptions) {
+  BatchingOptions options;
+  options.allowed_batch_sizes = {4, 2};
+  EXPECT_EQ(BatchingInterpreter::Create(shared_model_.get(), options),
+            nullptr);
+  options.allowed_batch_sizes = {};
+  EXPECT_EQ(BatchingInterpreter::Create(shared_model_.get(), options),
+            nullptr);
+}
+
+}  // namespace
+}  // namespace batching
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,431 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/graph_fusion.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <vector>
+
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/context_util.h"
+#include "tensorflow/lite/core/subgraph.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kNoProducer = -1;
+
+// Returns the fused activation of a node whose builtin op supports one, or
+// nullptr otherwise.
+TfLiteFusedActivation* GetFusedActivation(int builtin_code, TfLiteNode* node) {
+  if (node->builtin_data == nullptr) return nullptr;
+  switch (builtin_code) {
+    case kTfLiteBuiltinConv2d:
+      return &reinterpret_cast<TfLiteConvParams*>(node->builtin_data)
+                  ->activation;
+    case kTfLiteBuiltinDepthwiseConv2d:
+      return &reinterpret_cast<TfLiteDepthwiseConvParams*>(node->builtin_data)
+                  ->activation;
+    case kTfLiteBuiltinFullyConnected:
+      return &reinterpret_cast<TfLiteFullyConnectedParams*>(node->builtin_data)
+                  ->activation;
+    case kTfLiteBuiltinAdd:
+      return &reinterpret_cast<TfLiteAddParams*>(node->builtin_data)
+                  ->activation;
+    case kTfLiteBuiltinMul:
+      return &reinterpret_cast<TfLiteMulParams*>(node->builtin_data)
+                  ->activation;
+    default:
+      return nullptr;
+  }
+}
+
+// Maps a standalone activation op to the equivalent fused activation.
+bool GetActivationOfBuiltin(int builtin_code,
+                            TfLiteFusedActivation* activation) {
+  switch (builtin_code) {
+    case kTfLiteBuiltinRelu:
+      *activation = kTfLiteActRelu;
+      return true;
+    case kTfLiteBuiltinRelu6:
+      *activation = kTfLiteActRelu6;
+      return true;
+    case kTfLiteBuiltinReluN1To1:
+      *activation = kTfLiteActReluN1To1;
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsPerTensorQuantization(const TfLiteTensor& tensor) {
+  if (tensor.quantization.type != kTfLiteAffineQuantization) return true;
+  const auto* params = reinterpret_cast<const TfLiteAffineQuantization*>(
+      tensor.quantization.params);
+  return params == nullptr || params->scale == nullptr ||
+         params->scale->size <= 1;
+}
+
+// Whether the values stored in `a` and `b` have the same meaning.
+bool HaveSameEncoding(const TfLiteTensor& a, const TfLiteTensor& b) {
+  return a.type == b.type && a.params.scale == b.params.scale &&
+         a.params.zero_point == b.params.zero_point &&
+         IsPerTensorQuantization(a) && IsPerTensorQuantization(b);
+}
+
+bool IsConstantTensor(const TfLiteTensor& tensor) {
+  return tensor.allocation_type == kTfLiteMmapRo && tensor.data.raw != nullptr;
+}
+
+// Reads a constant permutation, as taken by TRANSPOSE.
+bool GetConstantPermutation(const TfLiteTensor& tensor,
+                            std::vector<int>* permutation) {
+  if (!IsConstantTensor(tensor) || tensor.type != kTfLiteInt32 ||
+      tensor.dims->size != 1) {
+    return false;
+  }
+  permutation->assign(tensor.data.i32, tensor.data.i32 + tensor.dims->data[0]);
+  return true;
+}
+
+bool IsIdentityPermutation(const std::vector<int>& permutation) {
+  for (int i = 0; i < permutation.size(); ++i) {
+    if (permutation[i] != i) return false;
+  }
+  return true;
+}
+
+// Rewrites the execution plan of a single subgraph. Every successful rewrite
+// invalidates the producer/consumer view of the graph, which is rebuilt before
+// looking for the next one.
+class GraphFuser {
+ public:
+  explicit GraphFuser(Subgraph* subgraph)
+      : subgraph_(subgraph), plan_(subgraph->execution_plan()) {}
+
+  TfLiteStatus Run(int* num_removed_nodes) {
+    const int original_size = plan_.size();
+    while (RunOnce()) {
+    }
+    *num_removed_nodes = original_size - plan_.size();
+    if (*num_removed_nodes == 0) return kTfLiteOk;
+    return subgraph_->SetExecutionPlan(plan_);
+  }
+
+ private:
+  // Applies the first matching rewrite. Returns false if none matched.
+  bool RunOnce() {
+    BuildGraphView();
+    for (int i = 0; i < plan_.size(); ++i) {
+      const int node_index = plan_[i];
+      if (FuseActivation(node_index) || FuseBiasAdd(node_index) ||
+          FuseReshapes(node_index) || RemoveTransposes(node_index)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void BuildGraphView() {
+    const int num_tensors = subgraph_->tensors_size();
+    producers_.assign(num_tensors, kNoProducer);
+    consumers_.assign(num_tensors, {});
+    for (int node_index : plan_) {
+      const TfLiteNode& node = this->node(node_index);
+      for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+        if (tensor_index == kTfLiteOptionalTensor) continue;
+        consumers_[tensor_index].push_back(node_index);
+      }
+      for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+        producers_[tensor_index] = node_index;
+      }
+    }
+    is_boundary_.assign(num_tensors, false);
+    for (const std::vector<int>* tensors :
+         {&subgraph_->inputs(), &subgraph_->outputs(),
+          &subgraph_->variables()}) {
+      for (int tensor_index : *tensors) {
+        if (tensor_index != kTfLiteOptionalTensor) {
+          is_boundary_[tensor_index] = true;
+        }
+      }
+    }
+  }
+
+  TfLiteNode& node(int node_index) {
+    return subgraph_->nodes_and_registration()[node_index].first;
+  }
+  int builtin_code(int node_index) {
+    const auto& registration =
+        subgraph_->nodes_and_registration()[node_index].second;
+    return registration.builtin_code;
+  }
+  TfLiteTensor& tensor(int tensor_index) {
+    return *subgraph_->tensor(tensor_index);
+  }
+
+  // Whether `tensor_index` only carries data from its producer to a single
+  // consumer, and may be bypassed.
+  bool IsSingleUseIntermediate(int tensor_index) {
+    return producers_[tensor_index] != kNoProducer &&
+           consumers_[tensor_index].size() == 1 &&
+           !is_boundary_[tensor_index] && !tensor(tensor_index).is_variable &&
+           tensor(tensor_index).allocation_type == kTfLiteArenaRw;
+  }
+
+  // Returns the node producing the `input`-th input of `node_index`, if that
+  // input is a single-use intermediate, or kNoProducer otherwise.
+  int GetSingleUseProducer(int node_index, int input) {
+    const TfLiteIntArray* inputs = node(node_index).inputs;
+    if (input >= inputs->size) return kNoProducer;
+    const int tensor_index = inputs->data[input];
+    if (tensor_index == kTfLiteOptionalTensor ||
+        !IsSingleUseIntermediate(tensor_index)) {
+      return kNoProducer;
+    }
+    return producers_[tensor_index];
+  }
+
+  // Makes `node_index` write to `tensor_index` instead of its only output.
+  void RedirectOutput(int node_index, int tensor_index) {
+    node(node_index).outputs->data[0] = tensor_index;
+  }
+
+  void RemoveFromPlan(int node_index) {
+    plan_.erase(std::remove(plan_.begin(), plan_.end(), node_index),
+                plan_.end());
+  }
+
+  // Conv/FC/Add/Mul -> Relu becomes Conv/FC/Add/Mul with a fused activation.
+  bool FuseActivation(int node_index) {
+    TfLiteFusedActivation activation;
+    if (!GetActivationOfBuiltin(builtin_code(node_index), &activation)) {
+      return false;
+    }
+    const TfLiteNode& relu = node(node_index);
+    if (relu.inputs->size != 1 || relu.outputs->size != 1) return false;
+    const int producer = GetSingleUseProducer(node_index, 0);
+    if (producer == kNoProducer || node(producer).outputs->size != 1) {
+      return false;
+    }
+    TfLiteFusedActivation* fused_activation =
+        GetFusedActivation(builtin_code(producer), &node(producer));
+    if (fused_activation == nullptr || *fused_activation != kTfLiteActNone) {
+      return false;
+    }
+    const TfLiteTensor& intermediate = tensor(relu.inputs->data[0]);
+    const TfLiteTensor& output = tensor(relu.outputs->data[0]);
+    if (intermediate.type != kTfLiteFloat32 &&
+        intermediate.type != kTfLiteUInt8 && intermediate.type != kTfLiteInt8) {
+      return false;
+    }
+    // The fused activation clamps to the range representable with the
+    // quantization of the output, so both sides must encode values the same.
+    if (!HaveSameEncoding(intermediate, output)) return false;
+
+    *fused_activation = activation;
+    RedirectOutput(producer, relu.outputs->data[0]);
+    RemoveFromPlan(node_index);
+    return true;
+  }
+
+  // Conv/FC without a bias -> Add of a constant vector becomes Conv/FC with
+  // that vector as a bias.
+  bool FuseBiasAdd(int node_index) {
+    if (builtin_code(node_index) != kTfLiteBuiltinAdd) return false;
+    const TfLiteNode& add = node(node_index);
+    if (add.inputs->size != 2 || add.outputs->size != 1) return false;
+    for (int input = 0; input < 2; ++input) {
+      const int producer = GetSingleUseProducer(node_index, input);
+      if (producer == kNoProducer) continue;
+      const int bias_index = add.inputs->data[1 - input];
+      if (TryFuseBias(producer, node_index, add.inputs->data[input],
+                      bias_index)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool TryFuseBias(int producer, int add_index, int intermediate_index,
+                   int bias_index) {
+    int channels_dimension;
+    switch (builtin_code(producer)) {
+      case kTfLiteBuiltinConv2d:
+      case kTfLiteBuiltinFullyConnected:
+        channels_dimension = 0;
+        break;
+      case kTfLiteBuiltinDepthwiseConv2d:
+        channels_dimension = 3;
+        break;
+      default:
+        return false;
+    }
+    TfLiteNode& producer_node = node(producer);
+    TfLiteIntArray* inputs = producer_node.inputs;
+    if (inputs->size < 2 || producer_node.outputs->size != 1) return false;
+    if (inputs->size >= 3 && inputs->data[2] != kTfLiteOptionalTensor) {
+      return false;
+    }
+    TfLiteFusedActivation* fused_activation =
+        GetFusedActivation(builtin_code(producer), &producer_node);
+    if (fused_activation == nullptr || *fused_activation != kTfLiteActNone) {
+      return false;
+    }
+
+    const TfLiteTensor& filter = tensor(inputs->data[1]);
+    const TfLiteTensor& intermediate = tensor(intermediate_index);
+    const TfLiteTensor& bias = tensor(bias_index);
+    const TfLiteTensor& output = tensor(node(add_index).outputs->data[0]);
+    if (filter.type != kTfLiteFloat32 || intermediate.type != kTfLiteFloat32 ||
+        output.type != kTfLiteFloat32 || !IsConstantTensor(bias) ||
+        bias.type != kTfLiteFloat32) {
+      return false;
+    }
+    if (filter.dims->size <= channels_dimension) return false;
+    const int channels = filter.dims->data[channels_dimension];
+
+    // The constant must only vary along the channels, which are the innermost
+    // dimension of the output, so that the addition doesn't broadcast the
+    // output to a larger shape.
+    const TfLiteIntArray* dims = intermediate.dims;
+    if (dims->size == 0 || dims->data[dims->size - 1] != channels ||
+        bias.dims->size == 0 || bias.dims->size > dims->size ||
+        bias.dims->data[bias.dims->size - 1] != channels ||
+        !TfLiteIntArrayEqual(dims, output.dims)) {
+      return false;
+    }
+    for (int i = 0; i < bias.dims->size - 1; ++i) {
+      if (bias.dims->data[i] != 1) return false;
+    }
+
+    if (inputs->size < 3) {
+      TfLiteIntArray* new_inputs = TfLiteIntArrayCreate(3);
+      new_inputs->data[0] = inputs->data[0];
+      new_inputs->data[1] = inputs->data[1];
+      TfLiteIntArrayFree(inputs);
+      producer_node.inputs = inputs = new_inputs;
+    }
+    inputs->data[2] = bias_index;
+    *fused_activation =
+        reinterpret_cast<TfLiteAddParams*>(node(add_index).builtin_data)
+            ->activation;
+    RedirectOutput(producer, node(add_index).outputs->data[0]);
+    RemoveFromPlan(add_index);
+    return true;
+  }
+
+  // Reshape/Squeeze/ExpandDims -> Reshape becomes a single Reshape. All of
+  // them only change the shape, and Reshape computes its output shape from the
+  // number of input elements alone.
+  bool FuseReshapes(int node_index) {
+    if (builtin_code(node_index) != kTfLiteBuiltinReshape) return false;
+    const int producer = GetSingleUseProducer(node_index, 0);
+    if (producer == kNoProducer) return false;
+    switch (builtin_code(producer)) {
+      case kTfLiteBuiltinReshape:
+      case kTfLiteBuiltinSqueeze:
+      case kTfLiteBuiltinExpandDims:
+        break;
+      default:
+        return false;
+    }
+    const TfLiteNode& producer_node = node(producer);
+    if (producer_node.inputs->size < 1 || producer_node.outputs->size != 1) {
+      return false;
+    }
+    const int input_index = producer_node.inputs->data[0];
+    if (tensor(input_index).type !=
+        tensor(node(node_index).outputs->data[0]).type) {
+      return false;
+    }
+    node(node_index).inputs->data[0] = input_index;
+    RemoveFromPlan(producer);
+    return true;
+  }
+
+  // Transpose with an identity permutation, and Transpose -> Transpose whose
+  // permutations cancel out, are removed, and the consumers of their output
+  // read their input instead.
+  bool RemoveTransposes(int node_index) {
+    std::vector<int> permutation;
+    if (!GetTransposePermutation(node_index, &permutation)) return false;
+    const int output_index = node(node_index).outputs->data[0];
+    if (is_boundary_[output_index] || tensor(output_index).is_variable) {
+      return false;
+    }
+
+    std::vector<int> removed_nodes = {node_index};
+    int input_index = node(node_index).inputs->data[0];
+    if (!IsIdentityPermutation(permutation)) {
+      // Transposing with `first` then with `permutation` moves the dimension
+      // first[permutation[j]] of the input to the position j.
+      const int producer = GetSingleUseProducer(node_index, 0);
+      std::vector<int> first;
+      if (producer == kNoProducer ||
+          !GetTransposePermutation(producer, &first) ||
+          first.size() != permutation.size()) {
+        return false;
+      }
+      for (int j = 0; j < permutation.size(); ++j) {
+        if (permutation[j] < 0 || permutation[j] >= first.size() ||
+            first[permutation[j]] != j) {
+          return false;
+        }
+      }
+      removed_nodes.push_back(producer);
+      input_index = node(producer).inputs->data[0];
+    }
+    if (!HaveSameEncoding(tensor(input_index), tensor(output_index))) {
+      return false;
+    }
+
+    for (int consumer : consumers_[output_index]) {
+      TfLiteIntArray* inputs = node(consumer).inputs;
+      for (int i = 0; i < inputs->size; ++i) {
+        if (inputs->data[i] == output_index) inputs->data[i] = input_index;
+      }
+    }
+    for (int removed_node : removed_nodes) RemoveFromPlan(removed_node);
+    return true;
+  }
+
+  bool GetTransposePermutation(int node_index, std::vector<int>* permutation) {
+    if (builtin_code(node_index) != kTfLiteBuiltinTranspose) return false;
+    const TfLiteNode& transpose = node(node_index);
+    return transpose.inputs->size == 2 && transpose.outputs->size == 1 &&
+           GetConstantPermutation(tensor(transpose.inputs->data[1]),
+                                  permutation);
+  }
+
+  Subgraph* const subgraph_;
+  std::vector<int> plan_;
+
+  // Indexed by tensor, over the nodes of `plan_`.
+  std::vector<int> producers_;
+  std::vector<std::vector<int>> consumers_;
+  // Whether the tensor is an input, output or variable of the subgraph.
+  std::vector<bool> is_boundary_;
+};
+
+}  // namespace
+
+TfLiteStatus FuseOperators(Subgraph* subgraph, int* num_removed_nodes) {
+  return GraphFuser(subgraph).Run(num_removed_nodes);
+}
+
+}  // namespace tflite
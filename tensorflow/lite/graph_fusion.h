@@ -0,0 +1,52 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_GRAPH_FUSION_H_
+#define TENSORFLOW_LITE_GRAPH_FUSION_H_
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/subgraph.h"
+
+namespace tflite {
+
+// Rewrites the execution plan of `subgraph` to run fewer nodes, without
+// changing the values of its outputs. The following rewrites are applied until
+// none of them matches anymore:
+//
+// * A RELU, RELU6 or RELU_N1_TO_1 reading the output of a CONV_2D,
+//   DEPTHWISE_CONV_2D, FULLY_CONNECTED, ADD or MUL without a fused activation
+//   is folded into the fused activation of that node.
+// * An ADD of a constant float per-channel vector to the output of a float
+//   CONV_2D, DEPTHWISE_CONV_2D or FULLY_CONNECTED without a bias becomes the
+//   bias of that node.
+// * A RESHAPE of the output of a RESHAPE, SQUEEZE or EXPAND_DIMS reshapes the
+//   input of the latter directly.
+// * A TRANSPOSE with a constant identity permutation, or two TRANSPOSEs whose
+//   constant permutations cancel out, are removed.
+//
+// Only tensors that are read by a single node, and that are neither inputs,
+// outputs nor variables of the subgraph, are ever bypassed. Removed nodes are
+// only dropped from the execution plan; the nodes and tensors they no longer
+// use stay in the subgraph, but are never prepared nor allocated.
+//
+// Must be called before the tensors of `subgraph` are allocated and before
+// any delegate is applied. Sets `num_removed_nodes` to the number of nodes
+// dropped from the execution plan.
+//
+// WARNING: This is an experimental API and subject to change.
+TfLiteStatus FuseOperators(Subgraph* subgraph, int* num_removed_nodes);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_GRAPH_FUSION_H_
@@ -0,0 +1,388 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/graph_fusion.h"
+
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+#include "tensorflow/lite/kernels/builtin_op_kernels.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAreArray;
+using ::testing::FloatNear;
+using ::testing::Pointwise;
+
+template <typename T>
+T* NewParams() {
+  return reinterpret_cast<T*>(calloc(1, sizeof(T)));
+}
+
+// Describes a graph of builtin ops to an interpreter.
+class GraphBuilder {
+ public:
+  // Constant buffers are added to `constants` and `permutations`, which must
+  // outlive `interpreter`.
+  GraphBuilder(Interpreter* interpreter,
+               std::deque<std::vector<float>>* constants,
+               std::deque<std::vector<int>>* permutations)
+      : interpreter_(interpreter),
+        constants_(constants),
+        permutations_(permutations) {}
+
+  int AddTensor(const std::vector<int>& dims) {
+    int tensor_index;
+    interpreter_->AddTensors(1, &tensor_index);
+    interpreter_->SetTensorParametersReadWrite(
+        tensor_index, kTfLiteFloat32, "", dims, TfLiteQuantizationParams());
+    return tensor_index;
+  }
+
+  int AddConstant(const std::vector<int>& dims,
+                  const std::vector<float>& data) {
+    constants_->push_back(data);
+    int tensor_index;
+    interpreter_->AddTensors(1, &tensor_index);
+    interpreter_->SetTensorParametersReadOnly(
+        tensor_index, kTfLiteFloat32, "", dims, TfLiteQuantizationParams(),
+        reinterpret_cast<const char*>(constants_->back().data()),
+        data.size() * sizeof(float));
+    return tensor_index;
+  }
+
+  int AddPermutation(const std::vector<int>& permutation) {
+    permutations_->push_back(permutation);
+    int tensor_index;
+    interpreter_->AddTensors(1, &tensor_index);
+    interpreter_->SetTensorParametersReadOnly(
+        tensor_index, kTfLiteInt32, "", {static_cast<int>(permutation.size())},
+        TfLiteQuantizationParams(),
+        reinterpret_cast<const char*>(permutations_->back().data()),
+        permutation.size() * sizeof(int));
+    return tensor_index;
+  }
+
+  // `params` must be allocated with malloc, and is owned by the interpreter.
+  void AddNode(int builtin_code, TfLiteRegistration* registration,
+               const std::vector<int>& inputs, const std::vector<int>& outputs,
+               void* params = nullptr) {
+    TfLiteRegistration builtin = *registration;
+    builtin.builtin_code = builtin_code;
+    interpreter_->AddNodeWithParameters(inputs, outputs, nullptr, 0, params,
+                                        &builtin);
+  }
+
+  void SetInputs(const std::vector<int>& inputs) {
+    interpreter_->SetInputs(inputs);
+  }
+  void SetOutputs(const std::vector<int>& outputs) {
+    interpreter_->SetOutputs(outputs);
+  }
+
+ private:
+  Interpreter* interpreter_;
+  std::deque<std::vector<float>>* constants_;
+  std::deque<std::vector<int>>* permutations_;
+};
+
+class GraphFusionTest : public ::testing::Test {
+ protected:
+  // Builds the graph described by `build` twice, fuses the operators of the
+  // second copy, and checks that both copies compute the same outputs.
+  void BuildAndCompare(const std::function<void(GraphBuilder*)>& build,
+                       int expected_num_removed_nodes) {
+    for (auto* interpreter : {&reference_, &fused_}) {
+      interpreter->reset(new Interpreter);
+      GraphBuilder builder(interpreter->get(), &constants_, &permutations_);
+      build(&builder);
+    }
+    int num_removed_nodes = -1;
+    ASSERT_EQ(FuseOperators(&fused_->primary_subgraph(), &num_removed_nodes),
+              kTfLiteOk);
+    EXPECT_EQ(num_removed_nodes, expected_num_removed_nodes);
+    EXPECT_EQ(fused_->execution_plan().size(),
+              reference_->execution_plan().size() - expected_num_removed_nodes);
+
+    for (auto* interpreter : {reference_.get(), fused_.get()}) {
+      ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+      for (int input : interpreter->inputs()) {
+        TfLiteTensor* tensor = interpreter->tensor(input);
+        const int size = tensor->bytes / sizeof(float);
+        for (int i = 0; i < size; ++i) {
+          // Spans negative and large values, so that activations clamp.
+          tensor->data.f[i] = (i % 17 - 8) * 0.75f;
+        }
+      }
+      ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+    }
+    ASSERT_EQ(reference_->outputs().size(), fused_->outputs().size());
+    for (int i = 0; i < reference_->outputs().size(); ++i) {
+      const TfLiteTensor* expected = reference_->output_tensor(i);
+      const TfLiteTensor* actual = fused_->output_tensor(i);
+      ASSERT_TRUE(TfLiteIntArrayEqual(expected->dims, actual->dims));
+      const int size = expected->bytes / sizeof(float);
+      EXPECT_THAT(std::vector<float>(actual->data.f, actual->data.f + size),
+                  Pointwise(FloatNear(1e-5), std::vector<float>(
+                                                 expected->data.f,
+                                                 expected->data.f + size)));
+    }
+  }
+
+  // Returns the builtin codes of the nodes in the execution plan of `fused_`.
+  std::vector<int> FusedBuiltinCodes() {
+    std::vector<int> builtin_codes;
+    for (int node_index : fused_->execution_plan()) {
+      builtin_codes.push_back(
+          fused_->node_and_registration(node_index)->second.builtin_code);
+    }
+    return builtin_codes;
+  }
+
+  std::deque<std::vector<float>> constants_;
+  std::deque<std::vector<int>> permutations_;
+  std::unique_ptr<Interpreter> reference_;
+  std::unique_ptr<Interpreter> fused_;
+};
+
+// input [1, 4, 4, 2] -> CONV_2D (3 filters of 1x1) -> RELU6
+void BuildConvRelu6(GraphBuilder* builder, bool conv_output_is_graph_output) {
+  const int input = builder->AddTensor({1, 4, 4, 2});
+  const int filter = builder->AddConstant({3, 1, 1, 2}, {1, -1, 2, 0.5, -3, 1});
+  const int bias = builder->AddConstant({3}, {0.5, -1, 2});
+  const int conv_output = builder->AddTensor({1, 4, 4, 3});
+  const int output = builder->AddTensor({1, 4, 4, 3});
+  auto* params = NewParams<TfLiteConvParams>();
+  params->padding = kTfLitePaddingValid;
+  params->stride_width = params->stride_height = 1;
+  params->dilation_width_factor = params->dilation_height_factor = 1;
+  params->activation = kTfLiteActNone;
+  builder->AddNode(kTfLiteBuiltinConv2d, ops::builtin::Register_CONV_2D(),
+                   {input, filter, bias}, {conv_output}, params);
+  builder->AddNode(kTfLiteBuiltinRelu6, ops::builtin::Register_RELU6(),
+                   {conv_output}, {output});
+  builder->SetInputs({input});
+  if (conv_output_is_graph_output) {
+    builder->SetOutputs({conv_output, output});
+  } else {
+    builder->SetOutputs({output});
+  }
+}
+
+TEST_F(GraphFusionTest, FusesActivationIntoConv) {
+  BuildAndCompare(
+      [](GraphBuilder* builder) {
+        BuildConvRelu6(builder, /*conv_output_is_graph_output=*/false);
+      },
+      /*expected_num_removed_nodes=*/1);
+  EXPECT_THAT(FusedBuiltinCodes(), ElementsAreArray({kTfLiteBuiltinConv2d}));
+  const TfLiteNode& conv =
+      fused_->node_and_registration(fused_->execution_plan()[0])->first;
+  EXPECT_EQ(reinterpret_cast<TfLiteConvParams*>(conv.builtin_data)->activation,
+            kTfLiteActRelu6);
+}
+
+TEST_F(GraphFusionTest, KeepsIntermediatesThatAreGraphOutputs) {
+  BuildAndCompare(
+      [](GraphBuilder* builder) {
+        BuildConvRelu6(builder, /*conv_output_is_graph_output=*/true);
+      },
+      /*expected_num_removed_nodes=*/0);
+}
+
+// input [2, 3] -> FULLY_CONNECTED (no bias) -> ADD [1, 4] -> RELU
+TEST_F(GraphFusionTest, FusesBiasAddAndActivationIntoFullyConnected) {
+  BuildAndCompare(
+      [](GraphBuilder* builder) {
+        const int input = builder->AddTensor({2, 3});
+        const int weights = builder->AddConstant(
+            {4, 3}, {1, 2, 3, -1, -2, -3, 0.5, 0, -0.5, 2, -1, 1});
+        const int fc_output = builder->AddTensor({2, 4});
+        const int bias = builder->AddConstant({1, 4}, {1, -2, 3, -4});
+        const int add_output = builder->AddTensor({2, 4});
+        const int output = builder->AddTensor({2, 4});
+        auto* fc_params = NewParams<TfLiteFullyConnectedParams>();
+        fc_params->activation = kTfLiteActNone;
+        builder->AddNode(kTfLiteBuiltinFullyConnected,
+                         ops::builtin::Register_FULLY_CONNECTED(),
+                         {input, weights, kTfLiteOptionalTensor}, {fc_output},
+                         fc_params);
+        auto* add_params = NewParams<TfLiteAddParams>();
+        add_params->activation = kTfLiteActNone;
+        builder->AddNode(kTfLiteBuiltinAdd, ops::builtin::Register_ADD(),
+                         {bias, fc_output}, {add_output}, add_params);
+        builder->AddNode(kTfLiteBuiltinRelu, ops::builtin::Register_RELU(),
+                         {add_output}, {output});
+        builder->SetInputs({input});
+        builder->SetOutputs({output});
+      },
+      /*expected_num_removed_nodes=*/2);
+  EXPECT_THAT(FusedBuiltinCodes(),
+              ElementsAreArray({kTfLiteBuiltinFullyConnected}));
+}
+
+// input [2, 3] -> FULLY_CONNECTED (no bias) -> ADD [4] -> ADD [4], where the
+// second ADD can't be fused anymore since the first one provides the bias.
+TEST_F(GraphFusionTest, FusesOnlyFirstBiasAdd) {
+  BuildAndCompare(
+      [](GraphBuilder* builder) {
+        const int input = builder->AddTensor({2, 3});
+        const int weights = builder->AddConstant(
+            {4, 3}, {1, 2, 3, -1, -2, -3, 0.5, 0, -0.5, 2, -1, 1});
+        const int fc_output = builder->AddTensor({2, 4});
+        const int bias = builder->AddConstant({4}, {0.5, 1.5, -2, 4});
+        const int add_output = builder->AddTensor({2, 4});
+        const int output = builder->AddTensor({2, 4});
+        auto* fc_params = NewParams<TfLiteFullyConnectedParams>();
+        fc_params->activation = kTfLiteActNone;
+        builder->AddNode(kTfLiteBuiltinFullyConnected,
+                         ops::builtin::Register_FULLY_CONNECTED(),
+                         {input, weights}, {fc_output}, fc_params);
+        for (int add_input : {fc_output, add_output}) {
+          auto* add_params = NewParams<TfLiteAddParams>();
+          add_params->activation = kTfLiteActNone;
+          builder->AddNode(kTfLiteBuiltinAdd, ops::builtin::Register_ADD(),
+                           {add_input, bias},
+                           {add_input == fc_output ? add_output : output},
+                           add_params);
+        }
+        builder->SetInputs({input});
+        builder->SetOutputs({output});
+      },
+      /*expected_num_removed_nodes=*/1);
+  EXPECT_THAT(FusedBuiltinCodes(),
+              ElementsAreArray({kTfLiteBuiltinFullyConnected,
+                                kTfLiteBuiltinAdd}));
+}
+
+// input [1, 6, 1] -> SQUEEZE -> RESHAPE [2, 3] -> RESHAPE [3, 2]
+TEST_F(GraphFusionTest, FusesReshapes) {
+  BuildAndCompare(
+      [](GraphBuilder* builder) {
+        const int input = builder->AddTensor({1, 6, 1});
+        const int squeezed = builder->AddTensor({6});
+        const int reshaped = builder->AddTensor({2, 3});
+        const int output = builder->AddTensor({3, 2});
+        builder->AddNode(kTfLiteBuiltinSqueeze,
+                         ops::builtin::Register_SQUEEZE(), {input}, {squeezed},
+                         NewParams<TfLiteSqueezeParams>());
+        for (const auto& shape : {std::vector<int>{2, 3}, {3, 2}}) {
+          auto* params = NewParams<TfLiteReshapeParams>();
+          params->num_dimensions = shape.size();
+          std::copy(shape.begin(), shape.end(), params->shape);
+          const bool first = shape[0] == 2;
+          builder->AddNode(kTfLiteBuiltinReshape,
+                           ops::builtin::Register_RESHAPE(),
+                           {first ? squeezed : reshaped},
+                           {first ? reshaped : output}, params);
+        }
+        builder->SetInputs({input});
+        builder->SetOutputs({output});
+      },
+      /*expected_num_removed_nodes=*/2);
+  EXPECT_THAT(FusedBuiltinCodes(), ElementsAreArray({kTfLiteBuiltinReshape}));
+}
+
+// input [2, 3, 4] -> TRANSPOSE [1, 2, 0] -> TRANSPOSE [2, 0, 1] -> ADD
+TEST_F(GraphFusionTest, RemovesTransposesThatCancelOut) {
+  BuildAndCompare(
+      [](GraphBuilder* builder) {
+        const int input = builder->AddTensor({2, 3, 4});
+        const int transposed = builder->AddTensor({3, 4, 2});
+        const int restored = builder->AddTensor({2, 3, 4});
+        const int output = builder->AddTensor({2, 3, 4});
+        builder->AddNode(kTfLiteBuiltinTranspose,
+                         ops::builtin::Register_TRANSPOSE(),
+                         {input, builder->AddPermutation({1, 2, 0})},
+                         {transposed});
+        builder->AddNode(kTfLiteBuiltinTranspose,
+                         ops::builtin::Register_TRANSPOSE(),
+                         {transposed, builder->AddPermutation({2, 0, 1})},
+                         {restored});
+        auto* add_params = NewParams<TfLiteAddParams>();
+        add_params->activation = kTfLiteActNone;
+        builder->AddNode(kTfLiteBuiltinAdd, ops::builtin::Register_ADD(),
+                         {restored, restored}, {output}, add_params);
+        builder->SetInputs({input});
+        builder->SetOutputs({output});
+      },
+      /*expected_num_removed_nodes=*/2);
+  EXPECT_THAT(FusedBuiltinCodes(), ElementsAreArray({kTfLiteBuiltinAdd}));
+}
+
+TEST_F(GraphFusionTest, KeepsTransposesThatDontCancelOut) {
+  BuildAndCompare(
+      [](GraphBuilder* builder) {
+        const int input = builder->AddTensor({2, 3, 4});
+        const int transposed = builder->AddTensor({3, 4, 2});
+        const int restored = builder->AddTensor({4, 2, 3});
+        const int output = builder->AddTensor({4, 2, 3});
+        for (int i = 0; i < 2; ++i) {
+          builder->AddNode(kTfLiteBuiltinTranspose,
+                           ops::builtin::Register_TRANSPOSE(),
+                           {i == 0 ? input : transposed,
+                            builder->AddPermutation({1, 2, 0})},
+                           {i == 0 ? transposed : restored});
+        }
+        builder->AddNode(kTfLiteBuiltinRelu, ops::builtin::Register_RELU(),
+                         {restored}, {output});
+        builder->SetInputs({input});
+        builder->SetOutputs({output});
+      },
+      /*expected_num_removed_nodes=*/0);
+}
+
+TEST(GraphFusionBuilderTest, FusesOperatorsWhenEnabled) {
+  // The model computes output = 3 * input with two ADDs, which can't be fused.
+  auto model =
+      FlatBufferModel::BuildFromFile("tensorflow/lite/testdata/add.bin");
+  ASSERT_NE(model, nullptr);
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
+  InterpreterBuilder builder(*model, resolver);
+  builder.SetFuseOperators(true);
+  std::unique_ptr<Interpreter> interpreter;
+  ASSERT_EQ(builder(&interpreter), kTfLiteOk);
+  ASSERT_NE(interpreter, nullptr);
+  EXPECT_EQ(interpreter->execution_plan().size(), 2);
+  ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  TfLiteTensor* input = interpreter->input_tensor(0);
+  const int size = input->bytes / sizeof(float);
+  for (int i = 0; i < size; ++i) input->data.f[i] = i;
+  ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+  const TfLiteTensor* output = interpreter->output_tensor(0);
+  for (int i = 0; i < size; ++i) EXPECT_FLOAT_EQ(output->data.f[i], 3.0f * i);
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -29,7 +29,9 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/graph_fusion.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/minimal_logging.h"
 #include "tensorflow/lite/profiling/platform_profiler.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/schema/schema_utils.h"
@@ -748,6 +750,18 @@ TfLiteStatus InterpreterBuilder::operator()(
       }
     }
     modified_subgraph->SetVariables(std::move(variables));
+
+    if (fuse_operators_) {
+      int num_removed_nodes = 0;
+      if (FuseOperators(modified_subgraph, &num_removed_nodes) != kTfLiteOk) {
+        return cleanup_and_error();
+      }
+      if (num_removed_nodes > 0) {
+        TFLITE_LOG(TFLITE_LOG_INFO,
+                   "Operator fusion removed %d node(s) from subgraph %d.",
+                   num_removed_nodes, subgraph_index);
+      }
+    }
   }
 
   if (ParseSignatureDefs(model_->signature_defs(), interpreter->get()) !=
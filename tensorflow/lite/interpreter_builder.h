@@ -65,6 +65,14 @@ class InterpreterBuilder {
   TfLiteStatus operator()(std::unique_ptr<Interpreter>* interpreter,
                           int num_threads);
 
+  /// WARNING: Experimental interface, subject to change.
+  /// If enabled, the execution plan of every subgraph is rewritten with
+  /// `FuseOperators()` (see graph_fusion.h) before any delegate is applied, so
+  /// that fewer nodes are prepared and invoked. Disabled by default.
+  void SetFuseOperators(bool fuse_operators) {
+    fuse_operators_ = fuse_operators;
+  }
+
  private:
   TfLiteStatus BuildLocalIndexToRegistrationMapping();
   TfLiteStatus ParseNodes(
@@ -96,6 +104,7 @@ class InterpreterBuilder {
 
   bool has_flex_op_ = false;
   int num_fp32_tensors_ = 0;
+  bool fuse_operators_ = false;
 };
 
 }  // namespace tflite
@@ -20,6 +20,7 @@ limitations under the License.
 #include <algorithm>
 #include <cstdint>
 #include <limits>
+#include <vector>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
@@ -27,6 +28,8 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/optimized/batch_matmul.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/batch_matmul.h"
+#include "tensorflow/lite/kernels/internal/reference/densify.h"
 #include "tensorflow/lite/kernels/internal/reference/reference_ops.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
@@ -45,6 +48,7 @@ static const int kOutputTensor = 0;
 
 static const int kNumTempTensorsForAdjoints = 2;
 static const int kNumTempTensorsForHybrid = 5;
+static const int kNumTempTensorsForSparse = 1;
 
 // This file has two implementations of Transpose.
 enum KernelType {
@@ -65,6 +69,15 @@ struct OpData {
   int scratch_tensor_index;
   bool rhs_transposed;
   bool compute_row_sums = false;
+  // Sparse float RHS are either used as is by the sparse kernel, or densified
+  // once into the temporary at `dense_rhs_index`.
+  bool use_sparse_rhs_kernel = false;
+  // The constant RHS as parsed at Prepare, when `use_sparse_rhs_kernel`.
+  optimized_ops::RowSparseMatrix sparse_rhs;
+  std::vector<optimized_ops::RowSparseMatMulTask> sparse_tasks;
+  bool need_dense_rhs = false;
+  bool has_rhs_been_densified = false;
+  int dense_rhs_index;
 };
 
 struct OpContext {
@@ -85,9 +98,10 @@ void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   // If the RHS is constant, we only transpose once.
   op_data->rhs_transposed = false;
   // Creates the temp tensors to store the transposed LHS and/or RHS, and
-  // extra buffers for the quantized case.
+  // extra buffers for the quantized and sparse cases.
   context->AddTensors(context,
-                      kNumTempTensorsForAdjoints + kNumTempTensorsForHybrid,
+                      kNumTempTensorsForAdjoints + kNumTempTensorsForHybrid +
+                          kNumTempTensorsForSparse,
                       &op_data->scratch_tensor_index);
   return op_data;
 }
@@ -135,12 +149,15 @@ TfLiteStatus InitializeTemporaries(TfLiteContext* context, TfLiteNode* node,
   // is quantized int8.
   bool is_hybrid =
       (op_context->lhs->type == kTfLiteFloat32 && rhs->type == kTfLiteInt8);
+  int num_temporaries = kNumTempTensorsForAdjoints;
   if (is_hybrid) {
-    node->temporaries = TfLiteIntArrayCreate(kNumTempTensorsForAdjoints +
-                                             kNumTempTensorsForHybrid);
-  } else {
-    node->temporaries = TfLiteIntArrayCreate(kNumTempTensorsForAdjoints);
+    num_temporaries += kNumTempTensorsForHybrid;
+  }
+  if (op_data->need_dense_rhs) {
+    op_data->dense_rhs_index = num_temporaries;
+    num_temporaries += kNumTempTensorsForSparse;
   }
+  node->temporaries = TfLiteIntArrayCreate(num_temporaries);
 
   const int lhs_rank = NumDimensions(lhs);
   const int rhs_rank = NumDimensions(rhs);
@@ -288,16 +305,63 @@ TfLiteStatus InitializeTemporaries(TfLiteContext* context, TfLiteNode* node,
     }
   }
 
+  if (op_data->need_dense_rhs) {
+    node->temporaries->data[op_data->dense_rhs_index] =
+        op_data->scratch_tensor_index + kNumTempTensorsForAdjoints +
+        kNumTempTensorsForHybrid;
+    TfLiteTensor* dense_rhs;
+    TF_LITE_ENSURE_OK(context,
+                      GetTemporarySafe(context, node, op_data->dense_rhs_index,
+                                       &dense_rhs));
+    dense_rhs->type = rhs->type;
+    dense_rhs->allocation_type = kTfLiteArenaRwPersistent;
+    TF_LITE_ENSURE_OK(context,
+                      context->ResizeTensor(context, dense_rhs,
+                                            TfLiteIntArrayCopy(rhs->dims)));
+    op_data->has_rhs_been_densified = false;
+  }
+
+  return kTfLiteOk;
+}
+
+// A sparse float RHS is multiplied without densifying it if it is sparse
+// enough and shared by all the batches of the LHS, and densified once
+// otherwise.
+TfLiteStatus PrepareSparseRhs(TfLiteContext* context, KernelType kernel_type,
+                              OpContext* op_context, OpData* op_data) {
+  const TfLiteTensor* rhs = op_context->rhs;
+  op_data->use_sparse_rhs_kernel = false;
+  op_data->need_dense_rhs = false;
+  if (rhs->sparsity == nullptr) return kTfLiteOk;
+
+  TF_LITE_ENSURE_MSG(context,
+                     op_context->lhs->type == kTfLiteFloat32 &&
+                         rhs->type == kTfLiteFloat32,
+                     "Sparse RHS are only supported for float32.");
+  TF_LITE_ENSURE(context, IsConstantTensor(rhs));
+  const int rhs_rank = NumDimensions(rhs);
+  optimized_ops::RowSparseMatrix& sparse_rhs = op_data->sparse_rhs;
+  op_data->use_sparse_rhs_kernel =
+      kernel_type != kReference && !op_context->params->adj_x &&
+      optimized_ops::GetRowSparseMatrix(*rhs->sparsity, GetTensorShape(rhs),
+                                        GetTensorData<float>(rhs),
+                                        &sparse_rhs) &&
+      sparse_rhs.rows == SizeOfDimension(rhs, rhs_rank - 2) &&
+      sparse_rhs.Sparsity() >= optimized_ops::kMinSparsityForSparseMatMul;
+  op_data->need_dense_rhs = !op_data->use_sparse_rhs_kernel;
   return kTfLiteOk;
 }
 
+template <KernelType kernel_type>
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 2);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
 
   OpContext op_context(context, node);
-  TF_LITE_ENSURE_OK(context, InitializeTemporaries(context, node, &op_context));
   OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  TF_LITE_ENSURE_OK(context, PrepareSparseRhs(context, kernel_type,
+                                              &op_context, op_data));
+  TF_LITE_ENSURE_OK(context, InitializeTemporaries(context, node, &op_context));
 
   bool adj_x = op_context.params->adj_x;
   bool adj_y = op_context.params->adj_y;
@@ -665,12 +729,34 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   bool adj_y = op_context.params->adj_y;
   bool adj_x = op_context.params->adj_x;
 
+  if (op_data->use_sparse_rhs_kernel) {
+    optimized_ops::BatchMatMulSparseRhs(
+        orig_lhs_shape, GetTensorData<float>(lhs), op_data->sparse_rhs, adj_y,
+        GetTensorShape(output), GetTensorData<float>(output),
+        &op_data->sparse_tasks, CpuBackendContext::GetFromContext(context));
+    return kTfLiteOk;
+  }
+  const bool is_rhs_constant = IsConstantTensor(rhs);
+  if (op_data->need_dense_rhs) {
+    TfLiteTensor* dense_rhs;
+    TF_LITE_ENSURE_OK(context,
+                      GetTemporarySafe(context, node, op_data->dense_rhs_index,
+                                       &dense_rhs));
+    if (!op_data->has_rhs_been_densified) {
+      reference_ops::Densify(rhs->sparsity, orig_rhs_shape,
+                             GetTensorData<float>(rhs), orig_rhs_shape,
+                             GetTensorData<float>(dense_rhs));
+      op_data->has_rhs_been_densified = true;
+    }
+    rhs = dense_rhs;
+  }
+
   const TfLiteTensor* rhs_tensor = adj_y ? rhs : GetTempRhs(context, node, rhs);
   const TfLiteTensor* lhs_tensor = adj_x ? GetTempLhs(context, node, lhs) : lhs;
   if (!adj_y) {
     // TODO(b/154760341) Constant tensors should already be transposed, but
     // we transpose once if necessary for now.
-    if (!(IsConstantTensor(rhs) && op_data->rhs_transposed)) {
+    if (!(is_rhs_constant && op_data->rhs_transposed)) {
       TransposeRowsColumns(context, rhs, GetTemporary(context, node, 1));
       op_data->rhs_transposed = true;
     }
@@ -716,15 +802,17 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace batch_matmul
 
 TfLiteRegistration* Register_BATCH_MATMUL_REF() {
-  static TfLiteRegistration r = {batch_matmul::Init, batch_matmul::Free,
-                                 batch_matmul::Prepare,
-                                 batch_matmul::Eval<batch_matmul::kReference>};
+  static TfLiteRegistration r = {
+      batch_matmul::Init, batch_matmul::Free,
+      batch_matmul::Prepare<batch_matmul::kReference>,
+      batch_matmul::Eval<batch_matmul::kReference>};
   return &r;
 }
 
 TfLiteRegistration* Register_BATCH_MATMUL_GENERIC_OPTIMIZED() {
   static TfLiteRegistration r = {
-      batch_matmul::Init, batch_matmul::Free, batch_matmul::Prepare,
+      batch_matmul::Init, batch_matmul::Free,
+      batch_matmul::Prepare<batch_matmul::kGenericOptimized>,
       batch_matmul::Eval<batch_matmul::kGenericOptimized>};
   return &r;
 }
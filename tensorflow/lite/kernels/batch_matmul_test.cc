@@ -19,6 +19,7 @@ limitations under the License.
 #include <vector>
 
 #include <gtest/gtest.h>
+#include "absl/memory/memory.h"
 #include "flatbuffers/flatbuffers.h"  // from @flatbuffers
 #include "tensorflow/lite/kernels/test_util.h"
 #include "tensorflow/lite/schema/schema_generated.h"
@@ -279,6 +280,102 @@ INSTANTIATE_TEST_SUITE_P(
     BatchMatMulOpTest, BatchMatMulOpTest,
     ::testing::ValuesIn(SingleOpTest::GetKernelTags(*kKernelMap)));
 
+// The RHS is a constant in the TFLite sparse format.
+class SparseBatchMatMulOpModel : public SingleOpModel {
+ public:
+  SparseBatchMatMulOpModel(TfLiteRegistration* registration,
+                           const TensorData& lhs, const TensorData& rhs,
+                           const std::vector<float>& rhs_data,
+                           bool adj_x = false, bool adj_y = false) {
+    lhs_id_ = AddInput(lhs);
+    rhs_id_ = AddConstSparseInput(rhs, rhs_data);
+    output_id_ = AddOutput(lhs.type);
+    SetBuiltinOp(BuiltinOperator_BATCH_MATMUL,
+                 BuiltinOptions_BatchMatMulOptions,
+                 CreateBatchMatMulOptions(builder_, adj_x, adj_y).Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_BATCH_MATMUL, registration);
+    BuildInterpreter({GetShape(lhs_id_), GetShape(rhs_id_)});
+  }
+
+  int lhs() const { return lhs_id_; }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_id_); }
+  std::vector<int32_t> GetOutputShape() { return GetTensorShape(output_id_); }
+
+ protected:
+  int lhs_id_;
+  int rhs_id_;
+  int output_id_;
+};
+
+class SparseBatchMatMulOpTest : public SingleOpTest {
+ protected:
+  const std::map<string, TfLiteRegistration*>& GetKernelMap() override {
+    return *kKernelMap;
+  }
+};
+
+TEST_P(SparseBatchMatMulOpTest, RandomSparseRHS) {
+  TensorData rhs = {TensorType_FLOAT32, {3, 12}};
+  rhs.traversal_order = {0, 1};
+  rhs.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  SparseBatchMatMulOpModel model(
+      GetRegistration(), {TensorType_FLOAT32, {2, 2, 3}}, rhs,
+      {0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //
+       1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //
+       0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1});
+  model.PopulateTensor<float>(model.lhs(),
+                              {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+  model.Invoke();
+  EXPECT_THAT(model.GetOutput(),
+              ElementsAreArray({2,  0, 2,  0, 0, 0, 0, 0, 0, 0, 0, -3,   //
+                                5,  0, 8,  0, 0, 0, 0, 0, 0, 0, 0, -6,   //
+                                8,  0, 14, 0, 0, 0, 0, 0, 0, 0, 0, -9,   //
+                                11, 0, 20, 0, 0, 0, 0, 0, 0, 0, 0, -12}));
+  EXPECT_THAT(model.GetOutputShape(), ElementsAreArray({2, 2, 12}));
+}
+
+TEST_P(SparseBatchMatMulOpTest, BlockSparseRHSAdjoint) {
+  TensorData rhs = {TensorType_FLOAT32, {2, 24}};
+  rhs.traversal_order = {0, 1, 2};
+  rhs.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  rhs.block_map = {1};
+  rhs.block_size = {4};
+  std::vector<float> rhs_data(2 * 24, 0.f);
+  rhs_data[0] = 1;
+  rhs_data[1] = 2;
+  rhs_data[2] = 3;
+  rhs_data[3] = 4;
+  SparseBatchMatMulOpModel model(GetRegistration(),
+                                 {TensorType_FLOAT32, {1, 2, 24}}, rhs,
+                                 rhs_data, /*adj_x=*/false, /*adj_y=*/true);
+  std::vector<float> lhs_data(2 * 24, 1.f);
+  for (int i = 0; i < 24; ++i) lhs_data[i] = i < 8 ? i + 1 : 0;
+  model.PopulateTensor<float>(model.lhs(), lhs_data);
+  model.Invoke();
+  EXPECT_THAT(model.GetOutput(), ElementsAreArray({30, 0, 10, 0}));
+  EXPECT_THAT(model.GetOutputShape(), ElementsAreArray({1, 2, 2}));
+}
+
+// Not sparse enough for the sparse kernel, so the RHS is densified.
+TEST_P(SparseBatchMatMulOpTest, DenseRHSInSparseFormat) {
+  TensorData rhs = {TensorType_FLOAT32, {3, 4}};
+  rhs.traversal_order = {0, 1};
+  rhs.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  SparseBatchMatMulOpModel model(
+      GetRegistration(), {TensorType_FLOAT32, {1, 2, 3}}, rhs,
+      {7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18});
+  model.PopulateTensor<float>(model.lhs(), {1, 2, 3, 4, 5, 6});
+  model.Invoke();
+  EXPECT_THAT(model.GetOutput(),
+              ElementsAreArray({74., 80., 86., 92., 173., 188., 203., 218.}));
+  EXPECT_THAT(model.GetOutputShape(), ElementsAreArray({1, 2, 4}));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    SparseBatchMatMulOpTest, SparseBatchMatMulOpTest,
+    ::testing::ValuesIn(SingleOpTest::GetKernelTags(*kKernelMap)));
+
 // In the hybrid model the weights are quantized int8. But the input
 // and output are expected to be in float precision.
 class HybridAsymmetricBatchMatMulOpModel : public SingleOpModel {
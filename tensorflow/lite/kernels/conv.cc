@@ -16,6 +16,7 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 
@@ -37,14 +38,17 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/optimized/multithreaded_conv.h"
 #endif
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/conv.h"
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
 #include "tensorflow/lite/kernels/internal/reference/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/densify.h"
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/kernels/shared_weight_cache.h"
 
 namespace tflite {
 namespace ops {
@@ -78,6 +82,7 @@ struct OpData {
   int accum_scratch_id = kTensorNotAllocated;
   // Row sums are used to cache filter sums for hybrid zero-point calculations.
   int row_sums_id = kTensorNotAllocated;
+  int dense_filter_id = kTensorNotAllocated;
 
   TfLitePaddingValues padding;
   // The scaling factor from input to output (aka the 'real multiplier') can
@@ -102,6 +107,16 @@ struct OpData {
   int32_t accum_scratch_index;
   int32_t input_offset_index;
   int32_t row_sums_index;
+  int32_t dense_filter_index;
+
+  // Sparse float filters are either used as is by the sparse 1x1 kernel, or
+  // densified once into the `dense_filter` temporary.
+  bool use_sparse_filter_kernel = false;
+  // The constant filter as parsed at Prepare, when `use_sparse_filter_kernel`.
+  optimized_ops::RowSparseMatrix sparse_filter;
+  std::vector<optimized_ops::RowSparseMatMulTask> sparse_tasks;
+  bool need_dense_filter = false;
+  bool has_filter_been_densified = false;
 
   bool need_hwcn_weights = false;
   bool have_weights_been_transposed = false;
@@ -145,11 +160,11 @@ void Free(TfLiteContext* context, void* buffer) {
 // Naive implementation of transpose for floats. Could be optimized to be more
 // cache friendly, but for now it's a one-time cost on first run, and we would
 // prefer to remove the need to do this at all eventually.
-void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
-  const int rows = output->dims->data[1];
-  const int cols = output->dims->data[0];
+void TransposeFloatTensor(const TfLiteTensor* input, const TfLiteIntArray* dims,
+                          float* output_data) {
+  const int rows = dims->data[1];
+  const int cols = dims->data[0];
   const float* input_data = GetTensorData<float>(input);
-  float* output_data = GetTensorData<float>(output);
   for (int i = 0; i < rows; ++i) {
     for (int j = 0; j < cols; ++j) {
       const float in_value = input_data[i * cols + j];
@@ -246,6 +261,14 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
       IsIm2ColRequired(input, params, filter, data, is_hybrid, kernel_type);
 
   int temporaries_count = 0;
+  if (data->need_dense_filter) {
+    data->dense_filter_index = temporaries_count;
+    if (data->dense_filter_id == kTensorNotAllocated) {
+      TF_LITE_ENSURE_OK(
+          context, context->AddTensors(context, 1, &data->dense_filter_id));
+    }
+    ++temporaries_count;
+  }
   if (data->need_im2col) {
     data->im2col_index = temporaries_count;
     if (data->im2col_id == kTensorNotAllocated) {
@@ -386,11 +409,34 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     }
   }
 
+  // Sparse filters of 1x1 convolutions are multiplied without densifying them
+  // if they are sparse enough, and densified once otherwise.
+  data->use_sparse_filter_kernel = false;
+  data->need_dense_filter = false;
+  if (filter->sparsity != nullptr) {
+    TF_LITE_ENSURE_MSG(context,
+                       input_type == kTfLiteFloat32 &&
+                           filter->type == kTfLiteFloat32,
+                       "Sparse filters are only supported for float32.");
+    TF_LITE_ENSURE(context, IsConstantTensor(filter));
+    optimized_ops::RowSparseMatrix& sparse_filter = data->sparse_filter;
+    data->use_sparse_filter_kernel =
+        kernel_type != kReference && filter->dims->data[1] == 1 &&
+        filter->dims->data[2] == 1 && params->stride_width == 1 &&
+        params->stride_height == 1 &&
+        optimized_ops::GetRowSparseMatrix(
+            *filter->sparsity, GetTensorShape(filter),
+            GetTensorData<float>(filter), &sparse_filter) &&
+        sparse_filter.Sparsity() >= optimized_ops::kMinSparsityForSparseMatMul;
+    data->need_dense_filter = !data->use_sparse_filter_kernel;
+  }
+
   // The multi-threaded kernel supports neither dilation nor hybrid kernels, and
   // is incompatible with mutable input filters that might change between evals.
   data->supports_multithreaded_kernel =
       (kernel_type == kMultithreadOptimized) &&
       (context->recommended_num_threads != 1) && !is_hybrid &&
+      !data->use_sparse_filter_kernel &&
       (params->dilation_width_factor == 1) &&
       (params->dilation_height_factor == 1) &&
       (filter->allocation_type != kTfLiteArenaRw) &&
@@ -450,6 +496,18 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
 
   if (output_status != kTfLiteOk) return output_status;
 
+  if (data->need_dense_filter) {
+    node->temporaries->data[data->dense_filter_index] = data->dense_filter_id;
+    TfLiteTensor* dense_filter =
+        &context->tensors[node->temporaries->data[data->dense_filter_index]];
+    dense_filter->type = filter->type;
+    dense_filter->allocation_type = kTfLiteArenaRwPersistent;
+    TF_LITE_ENSURE_OK(context,
+                      context->ResizeTensor(context, dense_filter,
+                                            TfLiteIntArrayCopy(filter->dims)));
+    data->has_filter_been_densified = false;
+  }
+
   if (data->need_im2col) {
     node->temporaries->data[data->im2col_index] = data->im2col_id;
 
@@ -496,6 +554,22 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     // TODO(petewarden): If Resize() is called when the size hasn't actually
     // changed, this will do extra redundant work.
     data->have_weights_been_transposed = false;
+
+    // Interpreters sharing a weight cache transpose constant filters once and
+    // all reference the same buffer.
+    SharedWeightCache* shared_weight_cache =
+        CpuBackendContext::GetFromContext(context)->shared_weight_cache();
+    if (shared_weight_cache != nullptr && filter->sparsity == nullptr) {
+      const auto init_hwcn_weights = [filter, hwcn_weights](void* data) {
+        TransposeFloatTensor(filter, hwcn_weights->dims,
+                             static_cast<float*>(data));
+      };
+      if (shared_weight_cache->MapDerivedTensor(
+              *filter, SharedWeightCache::Kind::kTransposedFloatWeights,
+              hwcn_weights, init_hwcn_weights)) {
+        data->have_weights_been_transposed = true;
+      }
+    }
   }
 
   if (is_hybrid) {
@@ -590,6 +664,25 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
         TF_LITE_ENSURE_OK(
             context, context->ResizeTensor(context, row_sums, row_sums_size));
       }
+
+      SharedWeightCache* shared_weight_cache =
+          CpuBackendContext::GetFromContext(context)->shared_weight_cache();
+      if (shared_weight_cache != nullptr) {
+        const int filter_cols = NumElements(filter) / channels_out;
+        const auto init_row_sums = [filter, channels_out,
+                                    filter_cols](void* data) {
+          int32_t* row_sums_data = static_cast<int32_t*>(data);
+          std::fill_n(row_sums_data, channels_out, 0);
+          tensor_utils::ReductionSumVector(GetTensorData<int8_t>(filter),
+                                           row_sums_data, channels_out,
+                                           filter_cols);
+        };
+        if (shared_weight_cache->MapDerivedTensor(
+                *filter, SharedWeightCache::Kind::kInt8RowSums, row_sums,
+                init_row_sums)) {
+          data->compute_hybrid_row_sums = false;
+        }
+      }
     }
   }
   return kTfLiteOk;
@@ -772,6 +865,14 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
   op_params.dilation_height_factor = params->dilation_height_factor;
   op_params.float_activation_min = output_activation_min;
   op_params.float_activation_max = output_activation_max;
+  if (data->use_sparse_filter_kernel) {
+    optimized_ops::Conv1x1SparseWeight(
+        op_params, GetTensorShape(input), GetTensorData<float>(input),
+        data->sparse_filter, GetTensorShape(bias), GetTensorData<float>(bias),
+        GetTensorShape(output), GetTensorData<float>(output),
+        &data->sparse_tasks, CpuBackendContext::GetFromContext(context));
+    return;
+  }
   switch (effective_kernel_type) {
     case kReference: {
       reference_ops::Conv(op_params, GetTensorShape(input),
@@ -1007,8 +1108,22 @@ TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node) {
           ? &context->tensors[node->temporaries->data[data->hwcn_weights_index]]
           : nullptr;
 
+  if (data->need_dense_filter) {
+    TfLiteTensor* dense_filter =
+        &context->tensors[node->temporaries->data[data->dense_filter_index]];
+    if (!data->has_filter_been_densified) {
+      reference_ops::Densify(filter->sparsity, GetTensorShape(filter),
+                             GetTensorData<float>(filter),
+                             GetTensorShape(dense_filter),
+                             GetTensorData<float>(dense_filter));
+      data->has_filter_been_densified = true;
+    }
+    filter = dense_filter;
+  }
+
   if (data->need_hwcn_weights && !data->have_weights_been_transposed) {
-    TransposeFloatTensor(filter, hwcn_weights);
+    TransposeFloatTensor(filter, hwcn_weights->dims,
+                         GetTensorData<float>(hwcn_weights));
     data->have_weights_been_transposed = true;
   }
 
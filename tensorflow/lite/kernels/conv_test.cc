@@ -1742,10 +1742,145 @@ TEST_P(QuantizedConvolutionOpTest, SimpleTestExplicitQuantizedOp) {
                              }));
 }
 
+// The filter is a constant in the TFLite sparse format.
+class SparseConvolutionOpModel : public SingleOpModel {
+ public:
+  SparseConvolutionOpModel(TfLiteRegistration* registration,
+                           const TensorData& input, const TensorData& filter,
+                           const std::vector<float>& filter_data,
+                           int stride_width = 1, int stride_height = 1,
+                           enum Padding padding = Padding_VALID) {
+    input_ = AddInput(input);
+    filter_ = AddConstSparseInput(filter, filter_data);
+    bias_ = AddInput({TensorType_FLOAT32, {filter.shape[0]}});
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+    SetBuiltinOp(BuiltinOperator_CONV_2D, BuiltinOptions_Conv2DOptions,
+                 CreateConv2DOptions(builder_, padding, stride_width,
+                                     stride_height, ActivationFunctionType_NONE)
+                     .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(BuiltinOperator_CONV_2D,
+                                                    registration);
+    BuildInterpreter({GetShape(input_), GetShape(filter_), GetShape(bias_)});
+  }
+
+  void SetBias(std::initializer_list<float> f) { PopulateTensor(bias_, f); }
+  void SetInput(std::initializer_list<float> data) {
+    PopulateTensor(input_, data);
+  }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ private:
+  int input_;
+  int filter_;
+  int bias_;
+  int output_;
+};
+
+class SparseConvolutionOpTest : public SingleOpTest {
+ protected:
+  const std::map<string, TfLiteRegistration*>& GetKernelMap() override {
+    return *kKernelMap;
+  }
+};
+
+// Sparse enough (more than kMinSparsityForSparseMatMul zeros, whether they are
+// counted one by one or in 1x4 blocks) for the sparse kernel.
+const std::vector<float> kSparse1x1FilterData = {
+    // first 1x1 filter
+    1, 2, 3, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    // second 1x1 filter
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    // third 1x1 filter
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, 1, -1, 1,
+    // fourth 1x1 filter
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+TEST_P(SparseConvolutionOpTest, RandomSparse1x1Filter) {
+  TensorData filter = {TensorType_FLOAT32, {4, 1, 1, 24}};
+  filter.traversal_order = {0, 1, 2, 3};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  SparseConvolutionOpModel m(GetRegistration(),
+                             {TensorType_FLOAT32, {1, 1, 2, 24}}, filter,
+                             kSparse1x1FilterData);
+  m.SetInput({
+      // left
+      1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+      // right
+      1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+      21, 22, 23, 24,
+  });
+  m.SetBias({1, 2, 3, 4});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({11, 2, 3, 4, 31, 2, 5, 4}));
+  EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({1, 1, 2, 4}));
+}
+
+TEST_P(SparseConvolutionOpTest, BlockSparse1x1Filter) {
+  TensorData filter = {TensorType_FLOAT32, {4, 1, 1, 24}};
+  filter.traversal_order = {0, 1, 2, 3, 4};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  filter.block_map = {3};
+  filter.block_size = {4};
+  SparseConvolutionOpModel m(GetRegistration(),
+                             {TensorType_FLOAT32, {1, 1, 2, 24}}, filter,
+                             kSparse1x1FilterData);
+  m.SetInput({
+      // left
+      1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+      // right
+      1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+      21, 22, 23, 24,
+  });
+  m.SetBias({1, 2, 3, 4});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({11, 2, 3, 4, 31, 2, 5, 4}));
+  EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({1, 1, 2, 4}));
+}
+
+// Filters that the sparse kernel doesn't support are densified.
+TEST_P(SparseConvolutionOpTest, DensifiedFilter) {
+  TensorData filter = {TensorType_FLOAT32, {3, 2, 2, 1}};
+  filter.traversal_order = {0, 1, 2, 3};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  SparseConvolutionOpModel m(GetRegistration(),
+                             {TensorType_FLOAT32, {2, 2, 4, 1}}, filter,
+                             {
+                                 1, 2, 3, 4,    // first 2x2 filter
+                                 -1, 1, -1, 1,  // second 2x2 filter
+                                 -1, -1, 1, 1,  // third 2x2 filter
+                             },
+                             /*stride_width=*/2, /*stride_height=*/2);
+  m.SetInput({
+      // First batch
+      1, 1, 1, 1,  // row = 1
+      2, 2, 2, 2,  // row = 2
+      // Second batch
+      1, 2, 3, 4,  // row = 1
+      1, 2, 3, 4,  // row = 2
+  });
+  m.SetBias({1, 2, 3});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({
+                                 18, 2, 5,  // first batch, left
+                                 18, 2, 5,  // first batch, right
+                                 17, 4, 3,  // second batch, left
+                                 37, 4, 3,  // second batch, right
+                             }));
+}
+
 INSTANTIATE_TEST_SUITE_P(
     ConvolutionOpTest, ConvolutionOpTest,
     ::testing::ValuesIn(SingleOpTest::GetKernelTags(*kKernelMap)));
 
+INSTANTIATE_TEST_SUITE_P(
+    SparseConvolutionOpTest, SparseConvolutionOpTest,
+    ::testing::ValuesIn(SingleOpTest::GetKernelTags(*kKernelMap)));
+
 INSTANTIATE_TEST_SUITE_P(
     QuantizedConvolutionOpTest, QuantizedConvolutionOpTest,
     ::testing::ValuesIn(SingleOpTest::GetKernelTags(*kQuantizedKernelMap)));
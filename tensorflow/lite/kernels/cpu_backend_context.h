@@ -22,6 +22,7 @@ limitations under the License.
 #include "ruy/context.h"  // from @ruy
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/external_cpu_backend_context.h"
+#include "tensorflow/lite/kernels/shared_weight_cache.h"
 
 namespace tflite {
 
@@ -50,6 +51,18 @@ class CpuBackendContext final : public TfLiteInternalBackendContext {
 
   void ClearCaches() override { ruy_context_->ClearPrepackedCache(); }
 
+  // Sets a cache of weight-derived buffers shared with other interpreters
+  // built from the same model. Kernels that find a shared cache reference its
+  // read-only buffers instead of computing private copies. The cache isn't
+  // owned and must outlive this context; nullptr disables sharing.
+  void SetSharedWeightCache(SharedWeightCache* shared_weight_cache) {
+    shared_weight_cache_ = shared_weight_cache;
+  }
+
+  SharedWeightCache* shared_weight_cache() const {
+    return shared_weight_cache_;
+  }
+
   bool HasAvxOrAbove();
 
  private:
@@ -105,6 +118,10 @@ class CpuBackendContext final : public TfLiteInternalBackendContext {
   // CpuBackendGem operations to a library that permits such an optimization
   // (currently the Ruy library only).
   bool use_caching_;
+  // Not owned. Unlike the ruy prepacked cache above, which belongs to a
+  // single ruy context and so to a single thread of execution, this cache is
+  // thread-safe and may be shared by concurrently running interpreters.
+  SharedWeightCache* shared_weight_cache_ = nullptr;
 
   CpuBackendContext(const CpuBackendContext&) = delete;
 };
@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/shared_weight_cache.h"
 
 namespace tflite {
 namespace ops {
@@ -285,6 +286,25 @@ TfLiteStatus PrepareImpl(TfLiteContext* context, TfLiteNode* node) {
       TF_LITE_ENSURE_OK(
           context, context->ResizeTensor(context, row_sums, row_sums_size));
     }
+
+    // The row sums only depend on the weights, so interpreters sharing a
+    // weight cache compute them once and all reference the same buffer.
+    SharedWeightCache* shared_weight_cache =
+        CpuBackendContext::GetFromContext(context)->shared_weight_cache();
+    if (shared_weight_cache != nullptr && filter->sparsity == nullptr) {
+      const int filter_cols = filter->dims->data[1];
+      const auto init_row_sums = [filter, num_units, filter_cols](void* data) {
+        int32_t* row_sums_data = static_cast<int32_t*>(data);
+        std::fill_n(row_sums_data, num_units, 0);
+        tensor_utils::ReductionSumVector(GetTensorData<int8_t>(filter),
+                                         row_sums_data, num_units, filter_cols);
+      };
+      if (shared_weight_cache->MapDerivedTensor(
+              *filter, SharedWeightCache::Kind::kInt8RowSums, row_sums,
+              init_row_sums)) {
+        data->compute_row_sums = false;
+      }
+    }
   }
 
   // Resize output.
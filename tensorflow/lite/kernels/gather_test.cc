@@ -15,6 +15,7 @@ limitations under the License.
 #include <stdint.h>
 
 #include <initializer_list>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -47,6 +48,11 @@ class GatherOpModel : public SingleOpModel {
     PopulateTensor<T>(input_, data);
   }
 
+  template <typename T>
+  void SetInput(const std::vector<T>& data) {
+    PopulateTensor<T>(input_, data);
+  }
+
   void SetStringInput(std::initializer_list<string> data) {
     PopulateStringTensor(input_, data);
   }
@@ -56,6 +62,11 @@ class GatherOpModel : public SingleOpModel {
     PopulateTensor<T>(positions_, data);
   }
 
+  template <typename T>
+  void SetPositions(const std::vector<T>& data) {
+    PopulateTensor<T>(positions_, data);
+  }
+
   template <typename T>
   std::vector<T> GetOutput() {
     return ExtractVector<T>(output_);
@@ -331,5 +342,32 @@ TEST(GatherOpTest, 2DIndexString) {
               ElementsAreArray({"A", "C", "B", "B", "A", "C"}));
 }
 
+TEST(GatherOpTest, LargeInputMultithreaded) {
+  // Large enough for the slices to be copied by different threads.
+  constexpr int kNumSlices = 256;
+  constexpr int kSliceSize = 1024;
+  GatherOpModel m({TensorType_FLOAT32, {kNumSlices, kSliceSize}},
+                  {TensorType_INT32, {kNumSlices}});
+  m.SetNumThreads(4);
+  std::vector<float> input(kNumSlices * kSliceSize);
+  std::iota(input.begin(), input.end(), 0.0f);
+  m.SetInput(input);
+  std::vector<int32_t> positions(kNumSlices);
+  for (int i = 0; i < kNumSlices; ++i) {
+    positions[i] = kNumSlices - 1 - i;
+  }
+  m.SetPositions(positions);
+  m.Invoke();
+
+  std::vector<float> expected;
+  for (int i = 0; i < kNumSlices; ++i) {
+    expected.insert(expected.end(),
+                    input.begin() + positions[i] * kSliceSize,
+                    input.begin() + (positions[i] + 1) * kSliceSize);
+  }
+  ASSERT_THAT(m.GetOutputShape(), ElementsAreArray({kNumSlices, kSliceSize}));
+  EXPECT_THAT(m.GetOutput<float>(), ElementsAreArray(expected));
+}
+
 }  // namespace
 }  // namespace tflite
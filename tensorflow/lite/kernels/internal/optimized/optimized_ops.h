@@ -4951,127 +4951,269 @@ inline void ResizeBilinearKernel2x2(int32 x0, int32 x1, int32 y0, int32 y1,
 #endif
 }
 
-inline void ResizeBilinear2x2(int32 batches, int32 input_height,
-                              int32 input_width, int32 depth,
-                              int32 output_height, int32 output_width,
+// The ResizeBilinear helpers below compute a range of rows of the output,
+// flattened to batches * output_height rows, so that the rows can be split
+// between threads.
+inline void ResizeBilinear2x2(int32 input_height, int32 input_width,
+                              int32 depth, int32 output_height,
+                              int32 output_width,
                               const RuntimeShape& input_shape,
                               const float* input_data,
                               const RuntimeShape& output_shape,
-                              float* output_data) {
-  for (int b = 0; b < batches; b++) {
-    for (int y0 = 0, y = 0; y <= output_height - 2; y += 2, y0++) {
-      for (int x0 = 0, x = 0; x <= output_width - 2; x += 2, x0++) {
-        int32 x1 = std::min(x0 + 1, input_width - 1);
-        int32 y1 = std::min(y0 + 1, input_height - 1);
-        ResizeBilinearKernel2x2(x0, x1, y0, y1, x, y, depth, b, input_shape,
-                                input_data, output_shape, output_data);
-      }
+                              float* output_data, int row_start, int row_end) {
+  // Every kernel invocation writes two output rows.
+  TFLITE_DCHECK_EQ(row_start % 2, 0);
+  TFLITE_DCHECK_EQ(row_end % 2, 0);
+  for (int row = row_start; row < row_end; row += 2) {
+    const int b = row / output_height;
+    const int y = row % output_height;
+    const int32 y0 = y / 2;
+    const int32 y1 = std::min(y0 + 1, input_height - 1);
+    for (int x0 = 0, x = 0; x <= output_width - 2; x += 2, x0++) {
+      int32 x1 = std::min(x0 + 1, input_width - 1);
+      ResizeBilinearKernel2x2(x0, x1, y0, y1, x, y, depth, b, input_shape,
+                              input_data, output_shape, output_data);
     }
   }
 }
 
 inline void ResizeBilinearGeneric(
-    int32 batches, int32 input_height, int32 input_width, int32 depth,
-    int32 output_height, int32 output_width, float height_scale,
-    float width_scale, const RuntimeShape& input_shape, const float* input_data,
+    int32 input_height, int32 input_width, int32 depth, int32 output_height,
+    int32 output_width, float height_scale, float width_scale,
+    const RuntimeShape& input_shape, const float* input_data,
     const RuntimeShape& output_shape, float* output_data,
-    const bool half_pixel_centers) {
-  memset(output_data, 0,
-         batches * output_height * output_width * depth * sizeof(float));
-
-  int32 output_offset = 0;
-  for (int b = 0; b < batches; ++b) {
-    for (int y = 0; y < output_height; ++y) {
-      float input_y;
-      int32 y0, y1;
+    const bool half_pixel_centers, int row_start, int row_end) {
+  int32 output_offset = row_start * output_width * depth;
+  memset(output_data + output_offset, 0,
+         (row_end - row_start) * output_width * depth * sizeof(float));
+
+  for (int row = row_start; row < row_end; ++row) {
+    const int b = row / output_height;
+    const int y = row % output_height;
+    float input_y;
+    int32 y0, y1;
+    reference_ops::ComputeInterpolationValues(
+        y, height_scale, half_pixel_centers, input_height, &input_y, &y0, &y1);
+    for (int x = 0; x < output_width; ++x) {
+      float input_x;
+      int32 x0, x1;
       reference_ops::ComputeInterpolationValues(
-          y, height_scale, half_pixel_centers, input_height, &input_y, &y0,
-          &y1);
-      for (int x = 0; x < output_width; ++x) {
-        float input_x;
-        int32 x0, x1;
-        reference_ops::ComputeInterpolationValues(
-            x, width_scale, half_pixel_centers, input_width, &input_x, &x0,
-            &x1);
-        float* output_ptr = &output_data[output_offset];
-
-        // Run kernel on the 4 corners of the bilinear resize algorithm.
-        int32 input_offset = Offset(input_shape, b, y0, x0, 0);
-        float scale = (1 - (input_y - y0)) * (1 - (input_x - x0));
-        const float* input_ptr = &input_data[input_offset];
-        ResizeBilinearKernel(input_ptr, depth, scale, output_ptr);
-
-        input_offset = Offset(input_shape, b, y0, x1, 0);
-        scale = (1 - (input_y - y0)) * (input_x - x0);
-        input_ptr = &input_data[input_offset];
-        ResizeBilinearKernel(input_ptr, depth, scale, output_ptr);
-
-        input_offset = Offset(input_shape, b, y1, x0, 0);
-        scale = (input_y - y0) * (1 - (input_x - x0));
-        input_ptr = &input_data[input_offset];
-        ResizeBilinearKernel(input_ptr, depth, scale, output_ptr);
-
-        input_offset = Offset(input_shape, b, y1, x1, 0);
-        scale = (input_y - y0) * (input_x - x0);
-        input_ptr = &input_data[input_offset];
-        ResizeBilinearKernel(input_ptr, depth, scale, output_ptr);
-
-        output_offset += depth;
-      }
+          x, width_scale, half_pixel_centers, input_width, &input_x, &x0, &x1);
+      float* output_ptr = &output_data[output_offset];
+
+      // Run kernel on the 4 corners of the bilinear resize algorithm.
+      int32 input_offset = Offset(input_shape, b, y0, x0, 0);
+      float scale = (1 - (input_y - y0)) * (1 - (input_x - x0));
+      const float* input_ptr = &input_data[input_offset];
+      ResizeBilinearKernel(input_ptr, depth, scale, output_ptr);
+
+      input_offset = Offset(input_shape, b, y0, x1, 0);
+      scale = (1 - (input_y - y0)) * (input_x - x0);
+      input_ptr = &input_data[input_offset];
+      ResizeBilinearKernel(input_ptr, depth, scale, output_ptr);
+
+      input_offset = Offset(input_shape, b, y1, x0, 0);
+      scale = (input_y - y0) * (1 - (input_x - x0));
+      input_ptr = &input_data[input_offset];
+      ResizeBilinearKernel(input_ptr, depth, scale, output_ptr);
+
+      input_offset = Offset(input_shape, b, y1, x1, 0);
+      scale = (input_y - y0) * (input_x - x0);
+      input_ptr = &input_data[input_offset];
+      ResizeBilinearKernel(input_ptr, depth, scale, output_ptr);
+
+      output_offset += depth;
     }
   }
 }
 
 template <typename T>
 inline void ResizeBilinearGenericSmallChannel(
-    int32 batches, int32 input_height, int32 input_width, int32 depth,
-    int32 output_height, int32 output_width, float height_scale,
-    float width_scale, const RuntimeShape& input_shape, const T* input_data,
+    int32 input_height, int32 input_width, int32 depth, int32 output_height,
+    int32 output_width, float height_scale, float width_scale,
+    const RuntimeShape& input_shape, const T* input_data,
     const RuntimeShape& output_shape, T* output_data,
-    const bool half_pixel_centers) {
-  T* output_ptr = &output_data[0];
-  for (int b = 0; b < batches; ++b) {
-    for (int y = 0; y < output_height; ++y) {
-      float input_y;
-      int32 y0, y1;
+    const bool half_pixel_centers, int row_start, int row_end) {
+  T* output_ptr = &output_data[row_start * output_width * depth];
+  for (int row = row_start; row < row_end; ++row) {
+    const int b = row / output_height;
+    const int y = row % output_height;
+    float input_y;
+    int32 y0, y1;
+    reference_ops::ComputeInterpolationValues(
+        y, height_scale, half_pixel_centers, input_height, &input_y, &y0, &y1);
+    for (int x = 0; x < output_width; ++x) {
+      float input_x;
+      int32 x0, x1;
       reference_ops::ComputeInterpolationValues(
-          y, height_scale, half_pixel_centers, input_height, &input_y, &y0,
-          &y1);
-      for (int x = 0; x < output_width; ++x) {
-        float input_x;
-        int32 x0, x1;
-        reference_ops::ComputeInterpolationValues(
-            x, width_scale, half_pixel_centers, input_width, &input_x, &x0,
-            &x1);
-
-        int32 input_offset[4] = {Offset(input_shape, b, y0, x0, 0),
-                                 Offset(input_shape, b, y0, x1, 0),
-                                 Offset(input_shape, b, y1, x0, 0),
-                                 Offset(input_shape, b, y1, x1, 0)};
-        float scale[4] = {(1 - (input_y - y0)) * (1 - (input_x - x0)),
-                          (1 - (input_y - y0)) * (input_x - x0),
-                          (input_y - y0) * (1 - (input_x - x0)),
-                          (input_y - y0) * (input_x - x0)};
-
-        for (int d = 0; d < depth; d++) {
-          const T* input_ptr = &input_data[d];
-          *output_ptr++ = static_cast<T>(input_ptr[input_offset[0]] * scale[0] +
-                                         input_ptr[input_offset[1]] * scale[1] +
-                                         input_ptr[input_offset[2]] * scale[2] +
-                                         input_ptr[input_offset[3]] * scale[3]);
-        }
+          x, width_scale, half_pixel_centers, input_width, &input_x, &x0, &x1);
+
+      int32 input_offset[4] = {Offset(input_shape, b, y0, x0, 0),
+                               Offset(input_shape, b, y0, x1, 0),
+                               Offset(input_shape, b, y1, x0, 0),
+                               Offset(input_shape, b, y1, x1, 0)};
+      float scale[4] = {(1 - (input_y - y0)) * (1 - (input_x - x0)),
+                        (1 - (input_y - y0)) * (input_x - x0),
+                        (input_y - y0) * (1 - (input_x - x0)),
+                        (input_y - y0) * (input_x - x0)};
+
+      for (int d = 0; d < depth; d++) {
+        const T* input_ptr = &input_data[d];
+        *output_ptr++ = static_cast<T>(input_ptr[input_offset[0]] * scale[0] +
+                                       input_ptr[input_offset[1]] * scale[1] +
+                                       input_ptr[input_offset[2]] * scale[2] +
+                                       input_ptr[input_offset[3]] * scale[3]);
       }
     }
   }
 }
 
+inline float ResizeBilinearScale(bool align_corners, int32 input_size,
+                                 int32 output_size) {
+  return (align_corners && output_size > 1)
+             ? (static_cast<float>(input_size - 1) / (output_size - 1))
+             : (static_cast<float>(input_size) / output_size);
+}
+
+inline bool IsResizeBilinear2x2(const tflite::ResizeBilinearParams& op_params,
+                                const RuntimeShape& input_shape,
+                                const RuntimeShape& output_shape) {
+  return !op_params.align_corners && !op_params.half_pixel_centers &&
+         output_shape.Dims(1) == 2 * input_shape.Dims(1) &&
+         output_shape.Dims(2) == 2 * input_shape.Dims(2);
+}
+
+// Computes the output rows [row_start, row_end) for 4D `input_shape` and
+// `output_shape`.
+inline void ResizeBilinearImpl(const tflite::ResizeBilinearParams& op_params,
+                               const RuntimeShape& input_shape,
+                               const float* input_data,
+                               const RuntimeShape& output_shape,
+                               float* output_data, int row_start,
+                               int row_end) {
+  const int32 input_height = input_shape.Dims(1);
+  const int32 input_width = input_shape.Dims(2);
+  const int32 depth = MatchingDim(input_shape, 3, output_shape, 3);
+  const int32 output_height = output_shape.Dims(1);
+  const int32 output_width = output_shape.Dims(2);
+
+  // Specialize for 2x2 upsample.
+  if (IsResizeBilinear2x2(op_params, input_shape, output_shape)) {
+    ResizeBilinear2x2(input_height, input_width, depth, output_height,
+                      output_width, input_shape, input_data, output_shape,
+                      output_data, row_start, row_end);
+  } else {
+    const float height_scale = ResizeBilinearScale(
+        op_params.align_corners, input_height, output_height);
+    const float width_scale = ResizeBilinearScale(op_params.align_corners,
+                                                  input_width, output_width);
+    ResizeBilinearGeneric(input_height, input_width, depth, output_height,
+                          output_width, height_scale, width_scale, input_shape,
+                          input_data, output_shape, output_data,
+                          op_params.half_pixel_centers, row_start, row_end);
+  }
+}
+
+inline void ResizeBilinearImpl(const tflite::ResizeBilinearParams& op_params,
+                               const RuntimeShape& input_shape,
+                               const uint8* input_data,
+                               const RuntimeShape& output_shape,
+                               uint8* output_data, int row_start,
+                               int row_end) {
+  const int32 input_height = input_shape.Dims(1);
+  const int32 input_width = input_shape.Dims(2);
+  const int32 depth = MatchingDim(input_shape, 3, output_shape, 3);
+  const int32 output_height = output_shape.Dims(1);
+  const int32 output_width = output_shape.Dims(2);
+
+  const float height_scale = ResizeBilinearScale(
+      op_params.align_corners, input_height, output_height);
+  const float width_scale = ResizeBilinearScale(op_params.align_corners,
+                                                input_width, output_width);
+  ResizeBilinearGenericSmallChannel<uint8>(
+      input_height, input_width, depth, output_height, output_width,
+      height_scale, width_scale, input_shape, input_data, output_shape,
+      output_data, op_params.half_pixel_centers, row_start, row_end);
+}
+
+template <typename T>
+struct ResizeBilinearWorkerTask : cpu_backend_threadpool::Task {
+  ResizeBilinearWorkerTask(const tflite::ResizeBilinearParams& op_params,
+                           const RuntimeShape& input_shape, const T* input_data,
+                           const RuntimeShape& output_shape, T* output_data,
+                           int row_start, int row_end)
+      : op_params(op_params),
+        input_shape(input_shape),
+        input_data(input_data),
+        output_shape(output_shape),
+        output_data(output_data),
+        row_start(row_start),
+        row_end(row_end) {}
+
+  void Run() override {
+    ResizeBilinearImpl(op_params, input_shape, input_data, output_shape,
+                       output_data, row_start, row_end);
+  }
+
+ private:
+  const tflite::ResizeBilinearParams& op_params;
+  const RuntimeShape& input_shape;
+  const T* input_data;
+  const RuntimeShape& output_shape;
+  T* output_data;
+  int row_start;
+  int row_end;
+};
+
+// Splits the output rows between the threads of `cpu_backend_context`, in
+// multiples of `row_alignment` rows.
+template <typename T>
+inline void ResizeBilinearMultithreaded(
+    const tflite::ResizeBilinearParams& op_params,
+    const RuntimeShape& input_shape, const T* input_data,
+    const RuntimeShape& output_shape, T* output_data, int row_alignment,
+    CpuBackendContext* cpu_backend_context) {
+  const int num_rows = output_shape.Dims(0) * output_shape.Dims(1);
+  const int num_row_blocks = num_rows / row_alignment;
+  // Each thread should at least produce this many output values, so that
+  // the work outweighs the cost of waking up the thread.
+  constexpr int kMinOutputSizePerThread = 16 * 1024;
+  int thread_count = std::min(
+      num_row_blocks, output_shape.FlatSize() / kMinOutputSizePerThread);
+  thread_count = thread_count > 0 ? thread_count : 1;
+  const int capped_thread_count =
+      cpu_backend_context == nullptr
+          ? 1
+          : std::min(thread_count, cpu_backend_context->max_num_threads());
+  if (capped_thread_count == 1) {
+    ResizeBilinearImpl(op_params, input_shape, input_data, output_shape,
+                       output_data, 0, num_rows);
+  } else {
+    std::vector<ResizeBilinearWorkerTask<T>> tasks;
+    tasks.reserve(capped_thread_count);
+    int block_start = 0;
+    for (int i = 0; i < capped_thread_count; ++i) {
+      // Try to distribute the tasks as even as possible.
+      int block_end = block_start + (num_row_blocks - block_start) /
+                                        (capped_thread_count - i);
+      tasks.emplace_back(op_params, input_shape, input_data, output_shape,
+                         output_data, block_start * row_alignment,
+                         block_end * row_alignment);
+      block_start = block_end;
+    }
+    cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                    cpu_backend_context);
+  }
+}
+
 inline void ResizeBilinear(const tflite::ResizeBilinearParams& op_params,
                            const RuntimeShape& unextended_input_shape,
                            const float* input_data,
                            const RuntimeShape& output_size_shape,
                            const int32* output_size_data,
                            const RuntimeShape& unextended_output_shape,
-                           float* output_data) {
+                           float* output_data,
+                           CpuBackendContext* cpu_backend_context = nullptr) {
   ruy::profiler::ScopeLabel label("ResizeBilinear");
   // If half_pixel_centers is True, align_corners must be False.
   TFLITE_DCHECK(!op_params.half_pixel_centers || !op_params.align_corners);
@@ -5082,36 +5224,15 @@ inline void ResizeBilinear(const tflite::ResizeBilinearParams& op_params,
   const RuntimeShape output_shape =
       RuntimeShape::ExtendedShape(4, unextended_output_shape);
 
-  int32 batches = MatchingDim(input_shape, 0, output_shape, 0);
-  int32 input_height = input_shape.Dims(1);
-  int32 input_width = input_shape.Dims(2);
-  int32 depth = MatchingDim(input_shape, 3, output_shape, 3);
-
+  TFLITE_DCHECK_EQ(input_shape.Dims(0), output_shape.Dims(0));
   TFLITE_DCHECK_EQ(output_size_shape.FlatSize(), 2);
-  int32 output_height = output_size_data[0];
-  int32 output_width = output_size_data[1];
-
-  // Specialize for 2x2 upsample.
-  if (!op_params.align_corners && !op_params.half_pixel_centers &&
-      output_height == 2 * input_height && output_width == 2 * input_width) {
-    ResizeBilinear2x2(batches, input_height, input_width, depth, output_height,
-                      output_width, input_shape, input_data, output_shape,
-                      output_data);
-  } else {
-    float height_scale = static_cast<float>(input_height) / output_height;
-    float width_scale = static_cast<float>(input_width) / output_width;
-    if (op_params.align_corners && output_height > 1) {
-      height_scale = static_cast<float>(input_height - 1) / (output_height - 1);
-    }
-    if (op_params.align_corners && output_width > 1) {
-      width_scale = static_cast<float>(input_width - 1) / (output_width - 1);
-    }
+  TFLITE_DCHECK_EQ(output_size_data[0], output_shape.Dims(1));
+  TFLITE_DCHECK_EQ(output_size_data[1], output_shape.Dims(2));
 
-    ResizeBilinearGeneric(batches, input_height, input_width, depth,
-                          output_height, output_width, height_scale,
-                          width_scale, input_shape, input_data, output_shape,
-                          output_data, op_params.half_pixel_centers);
-  }
+  const int row_alignment =
+      IsResizeBilinear2x2(op_params, input_shape, output_shape) ? 2 : 1;
+  ResizeBilinearMultithreaded(op_params, input_shape, input_data, output_shape,
+                              output_data, row_alignment, cpu_backend_context);
 }
 
 // TODO(prabhumk): This is not a real quantized bilinear. It does not use int8
@@ -5122,7 +5243,8 @@ inline void ResizeBilinear(const tflite::ResizeBilinearParams& op_params,
                            const RuntimeShape& output_size_shape,
                            const int32* output_size_data,
                            const RuntimeShape& unextended_output_shape,
-                           uint8* output_data) {
+                           uint8* output_data,
+                           CpuBackendContext* cpu_backend_context = nullptr) {
   ruy::profiler::ScopeLabel label("ResizeBilinear");
   // If half_pixel_centers is True, align_corners must be False.
   TFLITE_DCHECK(!op_params.half_pixel_centers || !op_params.align_corners);
@@ -5133,29 +5255,117 @@ inline void ResizeBilinear(const tflite::ResizeBilinearParams& op_params,
   const RuntimeShape output_shape =
       RuntimeShape::ExtendedShape(4, unextended_output_shape);
 
-  int32 batches = MatchingDim(input_shape, 0, output_shape, 0);
-  int32 input_height = input_shape.Dims(1);
-  int32 input_width = input_shape.Dims(2);
-  int32 depth = MatchingDim(input_shape, 3, output_shape, 3);
-
+  TFLITE_DCHECK_EQ(input_shape.Dims(0), output_shape.Dims(0));
   TFLITE_DCHECK_EQ(output_size_shape.FlatSize(), 2);
-  int32 output_height = output_size_data[0];
-  int32 output_width = output_size_data[1];
+  TFLITE_DCHECK_EQ(output_size_data[0], output_shape.Dims(1));
+  TFLITE_DCHECK_EQ(output_size_data[1], output_shape.Dims(2));
+
+  ResizeBilinearMultithreaded(op_params, input_shape, input_data, output_shape,
+                              output_data, /*row_alignment=*/1,
+                              cpu_backend_context);
+}
+
+// Copies the output slices [slice_start, slice_end) of Gather, where slice
+// `outer * coords_count + i` is input slice `outer * axis_size + coords[i]`.
+template <typename T, typename CoordsT>
+inline void GatherImpl(int axis_size, int coords_count, int inner_size,
+                       const T* input_data, const CoordsT* coords_data,
+                       T* output_data, int slice_start, int slice_end) {
+  for (int slice = slice_start; slice < slice_end; ++slice) {
+    const int outer = slice / coords_count;
+    const CoordsT coord = coords_data[slice % coords_count];
+    TFLITE_DCHECK_GE(coord, 0);
+    TFLITE_DCHECK_LT(coord, axis_size);
+    memcpy(output_data + slice * inner_size,
+           input_data + (outer * axis_size + coord) * inner_size,
+           sizeof(T) * inner_size);
+  }
+}
+
+template <typename T, typename CoordsT>
+struct GatherWorkerTask : cpu_backend_threadpool::Task {
+  GatherWorkerTask(int axis_size, int coords_count, int inner_size,
+                   const T* input_data, const CoordsT* coords_data,
+                   T* output_data, int slice_start, int slice_end)
+      : axis_size(axis_size),
+        coords_count(coords_count),
+        inner_size(inner_size),
+        input_data(input_data),
+        coords_data(coords_data),
+        output_data(output_data),
+        slice_start(slice_start),
+        slice_end(slice_end) {}
+
+  void Run() override {
+    GatherImpl(axis_size, coords_count, inner_size, input_data, coords_data,
+               output_data, slice_start, slice_end);
+  }
 
-  float height_scale =
-      (op_params.align_corners && output_height > 1)
-          ? (static_cast<float>(input_height - 1) / (output_height - 1))
-          : (static_cast<float>(input_height) / output_height);
+ private:
+  int axis_size;
+  int coords_count;
+  int inner_size;
+  const T* input_data;
+  const CoordsT* coords_data;
+  T* output_data;
+  int slice_start;
+  int slice_end;
+};
 
-  float width_scale =
-      (op_params.align_corners && output_width > 1)
-          ? (static_cast<float>(input_width - 1) / (output_width - 1))
-          : (static_cast<float>(input_width) / output_width);
+template <typename T, typename CoordsT = int32>
+inline void Gather(const tflite::GatherParams& op_params,
+                   const RuntimeShape& input_shape, const T* input_data,
+                   const RuntimeShape& coords_shape, const CoordsT* coords_data,
+                   const RuntimeShape& output_shape, T* output_data,
+                   CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("Gather");
+  int axis = op_params.axis;
+  if (axis < 0) {
+    axis += input_shape.DimensionsCount();
+  }
+  TFLITE_DCHECK_GE(axis, 0);
+  TFLITE_DCHECK_LT(axis, input_shape.DimensionsCount());
+  const int axis_size = input_shape.Dims(axis);
+  const int coords_count = coords_shape.FlatSize();
+
+  int outer_size = 1;
+  for (int i = 0; i < axis; ++i) {
+    outer_size *= input_shape.Dims(i);
+  }
 
-  ResizeBilinearGenericSmallChannel<uint8>(
-      batches, input_height, input_width, depth, output_height, output_width,
-      height_scale, width_scale, input_shape, input_data, output_shape,
-      output_data, op_params.half_pixel_centers);
+  int inner_size = 1;
+  for (int i = axis + 1; i < input_shape.DimensionsCount(); ++i) {
+    inner_size *= input_shape.Dims(i);
+  }
+
+  const int num_slices = outer_size * coords_count;
+  // Gather only copies memory, so each thread should copy at least this many
+  // bytes for the threads to pay off.
+  constexpr int kMinBytesPerThread = 64 * 1024;
+  int thread_count = std::min<int64_t>(
+      num_slices, static_cast<int64_t>(num_slices) * inner_size * sizeof(T) /
+                      kMinBytesPerThread);
+  thread_count = thread_count > 0 ? thread_count : 1;
+  const int capped_thread_count =
+      std::min(thread_count, cpu_backend_context->max_num_threads());
+  if (capped_thread_count == 1) {
+    GatherImpl(axis_size, coords_count, inner_size, input_data, coords_data,
+               output_data, 0, num_slices);
+  } else {
+    std::vector<GatherWorkerTask<T, CoordsT>> tasks;
+    tasks.reserve(capped_thread_count);
+    int slice_start = 0;
+    for (int i = 0; i < capped_thread_count; ++i) {
+      // Try to distribute the tasks as even as possible.
+      int slice_end = slice_start +
+                      (num_slices - slice_start) / (capped_thread_count - i);
+      tasks.emplace_back(axis_size, coords_count, inner_size, input_data,
+                         coords_data, output_data, slice_start, slice_end);
+      slice_start = slice_end;
+    }
+    cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                    cpu_backend_context);
+  }
 }
 
 // Helper methods for BatchToSpaceND.
@@ -7954,10 +8164,55 @@ void TransposeImpl(const TransposeParams& params,
                                  output_data);
 }
 
+// Transposes the blocks [block_start, block_end) of `block_size` elements
+// each, which all have the same `params`.
+template <typename T, int N>
+void TransposeBlocks(const TransposeParams& params,
+                     const RuntimeShape& input_shape, const T* input_data,
+                     const RuntimeShape& output_shape, T* output_data,
+                     int block_size, int block_start, int block_end) {
+  for (int block = block_start; block < block_end; ++block) {
+    TransposeImpl<T, N>(params, input_shape, input_data + block * block_size,
+                        output_shape, output_data + block * block_size);
+  }
+}
+
+template <typename T, int N>
+struct TransposeWorkerTask : cpu_backend_threadpool::Task {
+  TransposeWorkerTask(const TransposeParams& params,
+                      const RuntimeShape& input_shape, const T* input_data,
+                      const RuntimeShape& output_shape, T* output_data,
+                      int block_size, int block_start, int block_end)
+      : params(params),
+        input_shape(input_shape),
+        input_data(input_data),
+        output_shape(output_shape),
+        output_data(output_data),
+        block_size(block_size),
+        block_start(block_start),
+        block_end(block_end) {}
+
+  void Run() override {
+    TransposeBlocks<T, N>(params, input_shape, input_data, output_shape,
+                          output_data, block_size, block_start, block_end);
+  }
+
+ private:
+  const TransposeParams& params;
+  const RuntimeShape& input_shape;
+  const T* input_data;
+  const RuntimeShape& output_shape;
+  T* output_data;
+  int block_size;
+  int block_start;
+  int block_end;
+};
+
 template <typename T, int N = 5>
 void Transpose(const TransposeParams& unshrinked_params,
                const RuntimeShape& unshrinked_input_shape, const T* input_data,
-               const RuntimeShape& unshrinked_output_shape, T* output_data) {
+               const RuntimeShape& unshrinked_output_shape, T* output_data,
+               CpuBackendContext* cpu_backend_context = nullptr) {
   ruy::profiler::ScopeLabel label("Transpose");
 
   const int output_size = unshrinked_output_shape.DimensionsCount();
@@ -8002,10 +8257,36 @@ void Transpose(const TransposeParams& unshrinked_params,
         &non_flatten_params);
     TFLITE_DCHECK_NE(non_flatten_params.perm[0], 0);
 
-    for (int i = 0; i < total_size; i += non_flatten_size) {
-      TransposeImpl<T, N>(non_flatten_params, non_flatten_input_shape,
-                          input_data + i, non_flatten_output_shape,
-                          output_data + i);
+    // The flattened outer dimensions are independent transposes, which are
+    // split between the threads once each thread gets enough elements.
+    const int num_blocks = total_size / non_flatten_size;
+    constexpr int kMinElementsPerThread = 16 * 1024;
+    int thread_count =
+        std::min(num_blocks, total_size / kMinElementsPerThread);
+    thread_count = thread_count > 0 ? thread_count : 1;
+    const int capped_thread_count =
+        cpu_backend_context == nullptr
+            ? 1
+            : std::min(thread_count, cpu_backend_context->max_num_threads());
+    if (capped_thread_count == 1) {
+      TransposeBlocks<T, N>(non_flatten_params, non_flatten_input_shape,
+                            input_data, non_flatten_output_shape, output_data,
+                            non_flatten_size, 0, num_blocks);
+    } else {
+      std::vector<TransposeWorkerTask<T, N>> tasks;
+      tasks.reserve(capped_thread_count);
+      int block_start = 0;
+      for (int i = 0; i < capped_thread_count; ++i) {
+        // Try to distribute the tasks as even as possible.
+        int block_end = block_start +
+                        (num_blocks - block_start) / (capped_thread_count - i);
+        tasks.emplace_back(non_flatten_params, non_flatten_input_shape,
+                           input_data, non_flatten_output_shape, output_data,
+                           non_flatten_size, block_start, block_end);
+        block_start = block_end;
+      }
+      cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                      cpu_backend_context);
     }
     return;
   }
@@ -0,0 +1,58 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_BATCH_MATMUL_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_BATCH_MATMUL_H_
+
+#include <vector>
+
+#include "ruy/profiler/instrumentation.h"  // from @ruy
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/sparse_matmul.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+namespace optimized_ops {
+
+// Batch matrix multiplication of LHS <..., M, K> with a sparse RHS matrix
+// shared by all the batches, which is <K, N> if `adj_y` is false and <N, K>
+// otherwise. All the rows of the LHS batches are multiplied at once.
+inline void BatchMatMulSparseRhs(const RuntimeShape& lhs_shape,
+                                 const float* lhs_data,
+                                 const RowSparseMatrix& rhs, bool adj_y,
+                                 const RuntimeShape& output_shape,
+                                 float* output_data,
+                                 std::vector<RowSparseMatMulTask>* tasks,
+                                 CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("BatchMatMul/Sparse RHS");
+  const int accum_depth = lhs_shape.Dims(lhs_shape.DimensionsCount() - 1);
+  const int output_depth =
+      output_shape.Dims(output_shape.DimensionsCount() - 1);
+  TFLITE_DCHECK_EQ(adj_y ? rhs.cols : rhs.rows, accum_depth);
+  TFLITE_DCHECK_EQ(adj_y ? rhs.rows : rhs.cols, output_depth);
+  const int batches = lhs_shape.FlatSize() / accum_depth;
+  TFLITE_DCHECK_EQ(output_shape.FlatSize(), batches * output_depth);
+  (void)output_depth;
+
+  // With adj_y, RHS rows are the output columns and the product is the one of
+  // a fully-connected layer. Otherwise, every LHS row scales the rows of RHS.
+  RowSparseMatMul(rhs, /*transposed=*/!adj_y, lhs_data, batches, output_data,
+                  tasks, cpu_backend_context);
+}
+
+}  // namespace optimized_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_BATCH_MATMUL_H_
@@ -0,0 +1,71 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_CONV_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_CONV_H_
+
+#include <vector>
+
+#include "ruy/profiler/instrumentation.h"  // from @ruy
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/sparse_matmul.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+namespace optimized_ops {
+
+// 1x1 convolution with stride 1 and sparse [output_depth, 1, 1, input_depth]
+// filter, which is a product of the [batches * height * width, input_depth]
+// input matrix with the transposed filter matrix.
+inline void Conv1x1SparseWeight(const ConvParams& params,
+                                const RuntimeShape& input_shape,
+                                const float* input_data,
+                                const RowSparseMatrix& filter,
+                                const RuntimeShape& bias_shape,
+                                const float* bias_data,
+                                const RuntimeShape& output_shape,
+                                float* output_data,
+                                std::vector<RowSparseMatMulTask>* tasks,
+                                CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("Conv/1x1 Sparse");
+  TFLITE_DCHECK_EQ(params.stride_width, 1);
+  TFLITE_DCHECK_EQ(params.stride_height, 1);
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter.cols, input_shape.Dims(3));
+  TFLITE_DCHECK_EQ(filter.rows, output_shape.Dims(3));
+  const int output_depth = output_shape.Dims(3);
+  const int pixels = MatchingFlatSizeSkipDim(input_shape, 3, output_shape);
+
+  RowSparseMatMul(filter, /*transposed=*/false, input_data, pixels,
+                  output_data, tasks, cpu_backend_context);
+
+  const float output_activation_min = params.float_activation_min;
+  const float output_activation_max = params.float_activation_max;
+  for (int p = 0; p < pixels; ++p) {
+    float* output_pixel = output_data + p * output_depth;
+    for (int c = 0; c < output_depth; ++c) {
+      const float bias_value = bias_data == nullptr ? 0.f : bias_data[c];
+      output_pixel[c] = ActivationFunctionWithMinMax(
+          output_pixel[c] + bias_value, output_activation_min,
+          output_activation_max);
+    }
+  }
+}
+
+}  // namespace optimized_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_CONV_H_
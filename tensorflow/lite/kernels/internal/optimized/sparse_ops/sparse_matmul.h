@@ -0,0 +1,243 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_SPARSE_MATMUL_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_SPARSE_MATMUL_H_
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "ruy/profiler/instrumentation.h"  // from @ruy
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/internal/tensor_utils.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+namespace optimized_ops {
+
+// Kernels choose the sparse matrix multiplications below over densifying the
+// weights once and using the dense GEMM kernels from this sparsity on. Below
+// it, skipping the zeros doesn't make up for the much lower arithmetic
+// intensity of the sparse kernels: with sparse_kernels_benchmark on x86, the
+// sparse kernels only catch up with the dense ones between 80% (1x4 blocks)
+// and 90% (random) of zeros for Conv1x1, and around 90% for BatchMatMul.
+constexpr float kMinSparsityForSparseMatMul = 0.9f;
+
+// A float weight matrix of shape [rows, cols], stored with the TFLite
+// sparsity format: each row lists its non-zero values in CSR format, either
+// one by one (block_size = 1) or in 1x4 blocks along the columns
+// (block_size = 4).
+struct RowSparseMatrix {
+  int rows = 0;
+  int cols = 0;
+  int block_size = 1;
+  // For every row r, the values of the row are the ones at positions
+  // [segments[r], segments[r + 1]) of `indices` (column or block column
+  // indices) and of `values` (in units of blocks).
+  const int* segments = nullptr;
+  const int* indices = nullptr;
+  const float* values = nullptr;
+
+  int NumStoredValues() const { return segments[rows] * block_size; }
+  // Fraction of the values of the dense matrix which are not stored.
+  float Sparsity() const {
+    return 1.f - static_cast<float>(NumStoredValues()) /
+                     (static_cast<float>(rows) * cols);
+  }
+};
+
+// Interprets the sparse tensor of shape `shape` as a row sparse matrix, whose
+// columns are the innermost dimension and whose rows are all the other
+// dimensions. This covers fully-connected weights [rows, cols] as well as 1x1
+// convolution filters [rows, 1, 1, cols].
+// Returns false if the sparsity parameters don't use that layout: all the
+// dimensions must be traversed in order, all of them dense except the
+// innermost one which is compressed, and optionally a 1x4 block of that
+// innermost dimension.
+inline bool GetRowSparseMatrix(const TfLiteSparsity& sparsity,
+                               const RuntimeShape& shape, const float* data,
+                               RowSparseMatrix* matrix) {
+  const int rank = shape.DimensionsCount();
+  if (rank < 2 || sparsity.traversal_order == nullptr) return false;
+  const int num_dims = sparsity.traversal_order->size;
+  const bool is_block_sparse = num_dims == rank + 1;
+  if ((num_dims != rank && !is_block_sparse) ||
+      sparsity.dim_metadata_size != num_dims) {
+    return false;
+  }
+  for (int i = 0; i < num_dims; ++i) {
+    if (sparsity.traversal_order->data[i] != i) return false;
+    const TfLiteDimensionMetadata& metadata = sparsity.dim_metadata[i];
+    const bool is_compressed = i == rank - 1;
+    if (metadata.format !=
+        (is_compressed ? kTfLiteDimSparseCSR : kTfLiteDimDense)) {
+      return false;
+    }
+    if (is_compressed &&
+        (metadata.array_segments == nullptr ||
+         metadata.array_indices == nullptr)) {
+      return false;
+    }
+  }
+
+  matrix->rows = shape.FlatSize() / shape.Dims(rank - 1);
+  matrix->cols = shape.Dims(rank - 1);
+  matrix->block_size = 1;
+  if (is_block_sparse) {
+    if (sparsity.block_map == nullptr || sparsity.block_map->size != 1 ||
+        sparsity.block_map->data[0] != rank - 1 ||
+        sparsity.dim_metadata[rank].dense_size != 4 || matrix->cols % 4 != 0) {
+      return false;
+    }
+    matrix->block_size = 4;
+  }
+  const TfLiteDimensionMetadata& compressed = sparsity.dim_metadata[rank - 1];
+  if (compressed.array_segments->size != matrix->rows + 1) return false;
+  matrix->segments = compressed.array_segments->data;
+  matrix->indices = compressed.array_indices->data;
+  matrix->values = data;
+  return true;
+}
+
+// Computes output[b, r] = sum_c matrix[r, c] * input[b, c] for the batches
+// [batch_start, batch_end).
+inline void RowSparseMatMulImpl(const RowSparseMatrix& matrix,
+                                const float* input_data, float* output_data,
+                                int batch_start, int batch_end) {
+  const int batches = batch_end - batch_start;
+  const float* input = input_data + batch_start * matrix.cols;
+  float* output = output_data + batch_start * matrix.rows;
+  std::memset(output, 0, sizeof(float) * batches * matrix.rows);
+  if (matrix.block_size == 4) {
+    tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate1x4(
+        matrix.values, matrix.segments, matrix.indices, matrix.rows,
+        matrix.cols, input, batches, output);
+    return;
+  }
+  for (int b = 0; b < batches; ++b) {
+    const float* input_row = input + b * matrix.cols;
+    float* output_row = output + b * matrix.rows;
+    for (int r = 0; r < matrix.rows; ++r) {
+      float total = 0.f;
+      for (int i = matrix.segments[r]; i < matrix.segments[r + 1]; ++i) {
+        total += matrix.values[i] * input_row[matrix.indices[i]];
+      }
+      output_row[r] = total;
+    }
+  }
+}
+
+// Computes output[b, c] = sum_r input[b, r] * matrix[r, c] for the batches
+// [batch_start, batch_end).
+inline void RowSparseTransposedMatMulImpl(const RowSparseMatrix& matrix,
+                                          const float* input_data,
+                                          float* output_data, int batch_start,
+                                          int batch_end) {
+  for (int b = batch_start; b < batch_end; ++b) {
+    const float* input_row = input_data + b * matrix.rows;
+    float* output_row = output_data + b * matrix.cols;
+    std::memset(output_row, 0, sizeof(float) * matrix.cols);
+    for (int r = 0; r < matrix.rows; ++r) {
+      const float input_value = input_row[r];
+      if (matrix.block_size == 4) {
+        for (int i = matrix.segments[r]; i < matrix.segments[r + 1]; ++i) {
+          const float* block = matrix.values + i * 4;
+          float* output_block = output_row + matrix.indices[i] * 4;
+          for (int j = 0; j < 4; ++j) output_block[j] += input_value * block[j];
+        }
+      } else {
+        for (int i = matrix.segments[r]; i < matrix.segments[r + 1]; ++i) {
+          output_row[matrix.indices[i]] += input_value * matrix.values[i];
+        }
+      }
+    }
+  }
+}
+
+struct RowSparseMatMulTask : cpu_backend_threadpool::Task {
+  RowSparseMatMulTask(const RowSparseMatrix& matrix, bool transposed,
+                      const float* input_data, float* output_data,
+                      int batch_start, int batch_end)
+      : matrix(matrix),
+        transposed(transposed),
+        input_data(input_data),
+        output_data(output_data),
+        batch_start(batch_start),
+        batch_end(batch_end) {}
+
+  void Run() override {
+    if (transposed) {
+      RowSparseTransposedMatMulImpl(matrix, input_data, output_data,
+                                    batch_start, batch_end);
+    } else {
+      RowSparseMatMulImpl(matrix, input_data, output_data, batch_start,
+                          batch_end);
+    }
+  }
+
+ private:
+  const RowSparseMatrix& matrix;
+  bool transposed;
+  const float* input_data;
+  float* output_data;
+  int batch_start;
+  int batch_end;
+};
+
+// Multiplies every one of the `batches` rows of `input_data` with the sparse
+// `matrix`: if `transposed` is false, the input rows have matrix.cols values
+// and output[b, r] = sum_c matrix[r, c] * input[b, c]; otherwise the input
+// rows have matrix.rows values and output[b, c] = sum_r input[b, r] *
+// matrix[r, c]. The batches are split between the threads of
+// `cpu_backend_context`. The tasks are built in `tasks`, which callers keep
+// across invocations so that it is only allocated once.
+inline void RowSparseMatMul(const RowSparseMatrix& matrix, bool transposed,
+                            const float* input_data, int batches,
+                            float* output_data,
+                            std::vector<RowSparseMatMulTask>* tasks,
+                            CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label(matrix.block_size == 4
+                                      ? "RowSparseMatMul/1x4 Block Sparse"
+                                      : "RowSparseMatMul/Random Sparse");
+  const int thread_count =
+      std::max(1, std::min(batches, cpu_backend_context->max_num_threads()));
+  if (thread_count == 1) {
+    RowSparseMatMulTask(matrix, transposed, input_data, output_data, 0,
+                        batches)
+        .Run();
+    return;
+  }
+  tasks->clear();
+  tasks->reserve(thread_count);
+  int batch_start = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    // The first mod(batches, thread_count) tasks process one more batch than
+    // the rest.
+    int batch_end = batch_start + batches / thread_count;
+    if (i < batches % thread_count) batch_end++;
+    tasks->emplace_back(matrix, transposed, input_data, output_data,
+                        batch_start, batch_end);
+    batch_start = batch_end;
+  }
+  cpu_backend_threadpool::Execute(tasks->size(), tasks->data(),
+                                  cpu_backend_context);
+}
+
+}  // namespace optimized_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_SPARSE_MATMUL_H_
@@ -18,6 +18,7 @@ limitations under the License.
 #include <vector>
 
 #include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
 #include "tensorflow/lite/kernels/internal/reference/reference_ops.h"
 #include "tensorflow/lite/kernels/internal/test_util.h"
@@ -29,7 +30,8 @@ template <typename T>
 void TestOneResizeBilinear(const tflite::ResizeBilinearParams& op_params,
                            int batch, int depth, int input_width,
                            int input_height, int output_width,
-                           int output_height, float error_threshold) {
+                           int output_height, float error_threshold,
+                           CpuBackendContext* cpu_backend_context = nullptr) {
   RuntimeShape input_dims_inference({batch, input_height, input_width, depth});
   RuntimeShape output_dims_inference(
       {batch, output_height, output_width, depth});
@@ -54,9 +56,10 @@ void TestOneResizeBilinear(const tflite::ResizeBilinearParams& op_params,
                                 input_data.data(), output_size_dims,
                                 output_size_data.data(), output_dims_inference,
                                 reference_output_data.data());
-  optimized_ops::ResizeBilinear(
-      op_params, input_dims_inference, input_data.data(), output_size_dims,
-      output_size_data.data(), output_dims_inference, output_data.data());
+  optimized_ops::ResizeBilinear(op_params, input_dims_inference,
+                                input_data.data(), output_size_dims,
+                                output_size_data.data(), output_dims_inference,
+                                output_data.data(), cpu_backend_context);
 
   double sum_diff = 0;
   float max_abs_val = 0;
@@ -172,6 +175,35 @@ TEST_P(ResizeBilinearImplTest, TestResizeBilinear_2x2) {
   }
 }
 
+TEST_P(ResizeBilinearImplTest, TestResizeBilinearMultithreaded) {
+  RandomEngine().seed(38291);
+  const int kTestsToRun = 20;
+  const tflite::ResizeBilinearParams op_params = GetParam();
+  CpuBackendContext cpu_backend_context;
+  cpu_backend_context.SetMaxNumThreads(4);
+
+  for (int i = 0; i < kTestsToRun; i++) {
+    // The outputs are large enough to be split between the threads.
+    const int batch = UniformRandomInt(1, 3);
+    const int depth = ExponentialRandomPositiveInt(0.9f, 16, 50);
+    const int input_width = ExponentialRandomPositiveInt(0.9f, 64, 200);
+    const int input_height = ExponentialRandomPositiveInt(0.9f, 64, 200);
+    // Every other test upsamples by 2x2, which splits pairs of rows.
+    const int output_width =
+        i % 2 ? input_width * 2 : ExponentialRandomPositiveInt(0.9f, 64, 200);
+    const int output_height =
+        i % 2 ? input_height * 2 : ExponentialRandomPositiveInt(0.9f, 64, 200);
+
+    TestOneResizeBilinear<float>(op_params, batch, depth, input_width,
+                                 input_height, output_width, output_height,
+                                 op_params.align_corners ? 1e-4 : 1e-5,
+                                 &cpu_backend_context);
+    TestOneResizeBilinear<uint8>(op_params, batch, depth, input_width,
+                                 input_height, output_width, output_height,
+                                 0.025, &cpu_backend_context);
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(
     ResizeBilinear, ResizeBilinearImplTest,
     ::testing::ValuesIn(std::list<tflite::ResizeBilinearParams>({
@@ -0,0 +1,169 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures how the kernels that split their work with cpu_backend_threadpool
+// scale with the number of threads. For every op, prints the average latency
+// of one invocation with 1, 2, 4 and 8 threads.
+//
+// Example:
+//   bazel run -c opt //tensorflow/lite/kernels:intra_op_parallelism_benchmark
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/profiling/time.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kNumRuns = 50;
+
+class BenchmarkOpModel : public SingleOpModel {
+ public:
+  // Fills all float inputs with a ramp, and returns the average latency of
+  // one invocation in microseconds.
+  double Run() {
+    for (int input : inputs_to_fill_) {
+      const int size = GetTensorSize(input);
+      std::vector<float> data(size);
+      for (int i = 0; i < size; ++i) data[i] = i % 256;
+      PopulateTensor(input, data);
+    }
+    // Warm up, so that the thread pool is started.
+    if (InvokeUnchecked() != kTfLiteOk) return -1;
+    const uint64_t start_us = profiling::time::NowMicros();
+    for (int i = 0; i < kNumRuns; ++i) {
+      if (InvokeUnchecked() != kTfLiteOk) return -1;
+    }
+    return static_cast<double>(profiling::time::NowMicros() - start_us) /
+           kNumRuns;
+  }
+
+ protected:
+  void Build(const std::vector<std::vector<int>>& input_shapes,
+             int num_threads) {
+    BuildInterpreter(input_shapes, num_threads,
+                     /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+  }
+
+  std::vector<int> inputs_to_fill_;
+};
+
+class GatherModel : public BenchmarkOpModel {
+ public:
+  GatherModel(int num_threads, const std::vector<int>& input_shape,
+              int num_positions) {
+    const int input = AddInput({TensorType_FLOAT32, input_shape});
+    std::vector<int32_t> positions(num_positions);
+    for (int i = 0; i < num_positions; ++i) {
+      positions[i] = (i * 7) % input_shape[0];
+    }
+    const int positions_tensor = AddInput({TensorType_INT32, {num_positions}});
+    AddOutput({TensorType_FLOAT32, {}});
+    SetBuiltinOp(BuiltinOperator_GATHER, BuiltinOptions_GatherOptions,
+                 CreateGatherOptions(builder_, /*axis=*/0).Union());
+    Build({input_shape, {num_positions}}, num_threads);
+    PopulateTensor(positions_tensor, positions);
+    inputs_to_fill_ = {input};
+  }
+};
+
+class TransposeModel : public BenchmarkOpModel {
+ public:
+  TransposeModel(int num_threads, const std::vector<int>& input_shape,
+                 std::initializer_list<int> perm) {
+    const int input = AddInput({TensorType_FLOAT32, input_shape});
+    AddConstInput(TensorType_INT32, perm, {static_cast<int>(perm.size())});
+    AddOutput({TensorType_FLOAT32, {}});
+    SetBuiltinOp(BuiltinOperator_TRANSPOSE, BuiltinOptions_TransposeOptions,
+                 CreateTransposeOptions(builder_).Union());
+    Build({input_shape}, num_threads);
+    inputs_to_fill_ = {input};
+  }
+};
+
+class ResizeBilinearModel : public BenchmarkOpModel {
+ public:
+  ResizeBilinearModel(int num_threads, const std::vector<int>& input_shape,
+                      int output_height, int output_width) {
+    const int input = AddInput({TensorType_FLOAT32, input_shape});
+    AddConstInput(TensorType_INT32, {output_height, output_width}, {2});
+    AddOutput({TensorType_FLOAT32, {}});
+    SetBuiltinOp(BuiltinOperator_RESIZE_BILINEAR,
+                 BuiltinOptions_ResizeBilinearOptions,
+                 CreateResizeBilinearOptions(builder_).Union());
+    Build({input_shape}, num_threads);
+    inputs_to_fill_ = {input};
+  }
+};
+
+struct Benchmark {
+  std::string name;
+  std::function<std::unique_ptr<BenchmarkOpModel>(int num_threads)> create;
+};
+
+int Main() {
+  const std::vector<Benchmark> benchmarks = {
+      {"Gather [4096,1024] x 2048",
+       [](int num_threads) {
+         return std::unique_ptr<BenchmarkOpModel>(
+             new GatherModel(num_threads, {4096, 1024}, 2048));
+       }},
+      {"Transpose [8,64,64,64] perm [0,3,1,2]",
+       [](int num_threads) {
+         return std::unique_ptr<BenchmarkOpModel>(
+             new TransposeModel(num_threads, {8, 64, 64, 64}, {0, 3, 1, 2}));
+       }},
+      {"ResizeBilinear [1,128,128,32] to 256x256",
+       [](int num_threads) {
+         return std::unique_ptr<BenchmarkOpModel>(
+             new ResizeBilinearModel(num_threads, {1, 128, 128, 32}, 256, 256));
+       }},
+      {"ResizeBilinear [1,128,128,32] to 300x300",
+       [](int num_threads) {
+         return std::unique_ptr<BenchmarkOpModel>(
+             new ResizeBilinearModel(num_threads, {1, 128, 128, 32}, 300, 300));
+       }},
+  };
+
+  for (const Benchmark& benchmark : benchmarks) {
+    double single_thread_us = 0;
+    for (int num_threads : {1, 2, 4, 8}) {
+      const double latency_us = benchmark.create(num_threads)->Run();
+      if (latency_us < 0) {
+        fprintf(stderr, "Failed to invoke %s.\n", benchmark.name.c_str());
+        return 1;
+      }
+      if (num_threads == 1) single_thread_us = latency_us;
+      printf("%-45s threads=%d  %10.1f us  speedup=%.2fx\n",
+             benchmark.name.c_str(), num_threads, latency_us,
+             single_thread_us / latency_us);
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) { return tflite::Main(); }
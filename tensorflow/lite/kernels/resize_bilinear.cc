@@ -16,6 +16,7 @@ limitations under the License.
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/optimized/neon_check.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
@@ -122,22 +123,32 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                        GetTensorData<datatype>(input), GetTensorShape(size), \
                        GetTensorData<int32>(size), GetTensorShape(output),   \
                        GetTensorData<datatype>(output))
+#define TF_LITE_OPTIMIZED_RESIZE_BILINEAR(datatype)                          \
+  tflite::ResizeBilinearParams op_params;                                    \
+  op_params.align_corners = params->align_corners;                           \
+  op_params.half_pixel_centers = params->half_pixel_centers;                 \
+  optimized_ops::ResizeBilinear(                                             \
+      op_params, GetTensorShape(input), GetTensorData<datatype>(input),      \
+      GetTensorShape(size), GetTensorData<int32>(size),                      \
+      GetTensorShape(output), GetTensorData<datatype>(output),               \
+      CpuBackendContext::GetFromContext(context))
 
     if (kernel_type == kReference) {
       TF_LITE_RESIZE_BILINEAR(reference_ops, float);
     }
     if (kernel_type == kGenericOptimized || kernel_type == kNeonOptimized) {
-      TF_LITE_RESIZE_BILINEAR(optimized_ops, float);
+      TF_LITE_OPTIMIZED_RESIZE_BILINEAR(float);
     }
   } else if (output->type == kTfLiteUInt8) {
     if (kernel_type == kReference) {
       TF_LITE_RESIZE_BILINEAR(reference_ops, uint8_t);
     }
     if (kernel_type == kGenericOptimized || kernel_type == kNeonOptimized) {
-      TF_LITE_RESIZE_BILINEAR(optimized_ops, uint8_t);
+      TF_LITE_OPTIMIZED_RESIZE_BILINEAR(uint8_t);
     }
   } else if (output->type == kTfLiteInt8) {
     TF_LITE_RESIZE_BILINEAR(reference_ops, int8_t);
+#undef TF_LITE_OPTIMIZED_RESIZE_BILINEAR
 #undef TF_LITE_RESIZE_BILINEAR
   } else {
     context->ReportError(context, "Output type is %d, requires float.",
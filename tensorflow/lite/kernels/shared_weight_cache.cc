@@ -0,0 +1,129 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/kernels/shared_weight_cache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+namespace {
+
+// Same alignment as the buffers handed out by the memory arena, so that the
+// kernels can't tell a cached buffer from an arena-allocated one.
+constexpr size_t kBufferAlignment = 64;
+
+}  // namespace
+
+constexpr uint32_t SharedWeightCache::kDerivedDataVersion;
+
+const void* SharedWeightCache::GetOrCreate(const void* weights, Kind kind,
+                                           size_t bytes, const InitFn& init) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto key = std::make_pair(weights, kind);
+  auto it = entries_.find(key);
+  if (it != entries_.end() && it->second.validate) {
+    const bool valid = it->second.bytes == bytes &&
+                       it->second.validate(it->second.data);
+    it->second.validate = nullptr;
+    if (!valid) {
+      size_in_bytes_ -= it->second.bytes;
+      entries_.erase(it);
+      it = entries_.end();
+    }
+  }
+  if (it != entries_.end()) {
+    return it->second.bytes == bytes ? it->second.data : nullptr;
+  }
+
+  // Initialization happens under the lock: it is a one-time cost per weight
+  // tensor, and it guarantees that no reader ever sees a partially filled
+  // buffer.
+  Entry entry;
+  entry.bytes = bytes;
+  entry.storage.reset(new char[bytes + kBufferAlignment - 1]);
+  const uintptr_t base = reinterpret_cast<uintptr_t>(entry.storage.get());
+  entry.data = reinterpret_cast<void*>(
+      (base + kBufferAlignment - 1) / kBufferAlignment * kBufferAlignment);
+  init(entry.data);
+
+  const void* data = entry.data;
+  size_in_bytes_ += bytes + kBufferAlignment - 1;
+  entries_.emplace(key, std::move(entry));
+  return data;
+}
+
+bool SharedWeightCache::MapDerivedTensor(const TfLiteTensor& weights,
+                                         Kind kind, TfLiteTensor* derived,
+                                         const InitFn& init) {
+  if (weights.allocation_type != kTfLiteMmapRo ||
+      weights.data.raw == nullptr) {
+    return false;
+  }
+  const void* data = GetOrCreate(weights.data.raw, kind, derived->bytes, init);
+  if (data == nullptr) {
+    return false;
+  }
+  derived->allocation_type = kTfLiteMmapRo;
+  derived->data.raw = const_cast<char*>(static_cast<const char*>(data));
+  return true;
+}
+
+bool SharedWeightCache::AddExternalBuffer(const void* weights, Kind kind,
+                                          size_t bytes, const void* data,
+                                          ValidateFn validate) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry entry;
+  entry.bytes = bytes;
+  entry.data = const_cast<void*>(data);
+  entry.validate = std::move(validate);
+  if (!entries_.emplace(std::make_pair(weights, kind), std::move(entry))
+           .second) {
+    return false;
+  }
+  size_in_bytes_ += bytes;
+  return true;
+}
+
+std::vector<SharedWeightCache::BufferInfo> SharedWeightCache::GetBuffers()
+    const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<BufferInfo> buffers;
+  buffers.reserve(entries_.size());
+  for (const auto& entry : entries_) {
+    if (entry.second.validate) continue;
+    buffers.push_back({entry.first.first, entry.first.second,
+                       entry.second.bytes, entry.second.data});
+  }
+  return buffers;
+}
+
+int SharedWeightCache::num_entries() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+size_t SharedWeightCache::size_in_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_in_bytes_;
+}
+
+}  // namespace tflite
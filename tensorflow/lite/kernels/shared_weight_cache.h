@@ -0,0 +1,138 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_SHARED_WEIGHT_CACHE_H_
+#define TENSORFLOW_LITE_KERNELS_SHARED_WEIGHT_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+
+// A thread-safe store for buffers that kernels derive from constant weight
+// tensors, e.g. transposed filters or the row sums used by hybrid kernels.
+//
+// Several interpreters built from the same FlatBufferModel see the same
+// read-only weight buffers, so the data derived from them is identical too.
+// When these interpreters share one SharedWeightCache (see
+// CpuBackendContext::SetSharedWeightCache), each derived buffer is computed
+// once and then referenced read-only by all of them, instead of living in the
+// persistent arena of every interpreter.
+//
+// Buffers are never modified or released once created; they live as long as
+// the cache, which must outlive every interpreter that uses it.
+class SharedWeightCache {
+ public:
+  // Identifies the kind of data derived from a weight tensor, so that the same
+  // weights can back several derived buffers.
+  enum class Kind {
+    // Float weights transposed from [filter_count, filter_height,
+    // filter_width, input_depth] to [filter_height, filter_width, input_depth,
+    // filter_count].
+    kTransposedFloatWeights,
+    // Sums of the rows of 8-bit weights, stored as int32.
+    kInt8RowSums,
+  };
+
+  // Version of the layout of the data of every Kind. Kernels changing how
+  // they derive a Kind must bump it, so that derived data persisted by an
+  // older build (see PreparedModelCache) isn't used.
+  static constexpr uint32_t kDerivedDataVersion = 1;
+
+  // Fills a newly created buffer of the requested size.
+  using InitFn = std::function<void(void* data)>;
+
+  // Checks that an external buffer holds the expected data.
+  using ValidateFn = std::function<bool(const void* data)>;
+
+  SharedWeightCache() = default;
+
+  // Returns the buffer of `bytes` bytes derived from `weights` as `kind`. On
+  // the first request for a given (`weights`, `kind`) pair the buffer is
+  // allocated and filled by calling `init`; later requests return the same
+  // buffer. Returns nullptr if the pair was previously requested with a
+  // different size.
+  const void* GetOrCreate(const void* weights, Kind kind, size_t bytes,
+                          const InitFn& init);
+
+  // Points `derived` at the cached buffer holding data derived from `weights`
+  // as `kind`, creating it with `init` if needed. `derived` must already be
+  // resized, and afterwards is a read-only (kTfLiteMmapRo) tensor that the
+  // memory planner leaves alone.
+  //
+  // Returns false and leaves `derived` untouched if `weights` isn't a
+  // read-only constant tensor backed by the model, since only such data is
+  // guaranteed to be the same across interpreters.
+  bool MapDerivedTensor(const TfLiteTensor& weights, Kind kind,
+                        TfLiteTensor* derived, const InitFn& init);
+
+  // Adds the buffer of `bytes` bytes at `data`, which holds the data derived
+  // from `weights` as `kind` and was computed beforehand, e.g. loaded from a
+  // PreparedModelCache file. The cache doesn't own `data`, which must outlive
+  // it. Returns false if the pair is already in the cache.
+  //
+  // If `validate` is set, it is called on the first request for the pair
+  // rather than here, so that buffers which are never requested are never
+  // read. If it returns false, the buffer is dropped and the request creates
+  // a new one as if the pair wasn't in the cache.
+  bool AddExternalBuffer(const void* weights, Kind kind, size_t bytes,
+                         const void* data, ValidateFn validate = nullptr);
+
+  // Describes one buffer of the cache.
+  struct BufferInfo {
+    const void* weights;
+    Kind kind;
+    size_t bytes;
+    const void* data;
+  };
+
+  // Returns all the buffers held by the cache, in an unspecified order.
+  // External buffers that are still to be validated aren't returned.
+  std::vector<BufferInfo> GetBuffers() const;
+
+  // Number of buffers held by the cache.
+  int num_entries() const;
+
+  // Total number of bytes held by the cache.
+  size_t size_in_bytes() const;
+
+ private:
+  struct Entry {
+    size_t bytes;
+    // Null for external buffers.
+    std::unique_ptr<char[]> storage;
+    void* data;
+    // Set for external buffers until their first request.
+    ValidateFn validate;
+  };
+
+  mutable std::mutex mutex_;
+  std::map<std::pair<const void*, Kind>, Entry> entries_;
+  size_t size_in_bytes_ = 0;
+
+  SharedWeightCache(const SharedWeightCache&) = delete;
+  SharedWeightCache& operator=(const SharedWeightCache&) = delete;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_SHARED_WEIGHT_CACHE_H_
@@ -0,0 +1,198 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/shared_weight_cache.h"
+
+#include <cstdint>
+#include <cstring>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+namespace {
+
+using Kind = SharedWeightCache::Kind;
+
+TEST(SharedWeightCacheTest, InitializesOnce) {
+  SharedWeightCache cache;
+  const int32_t weights[4] = {1, 2, 3, 4};
+  int num_inits = 0;
+  const auto init = [&num_inits, &weights](void* data) {
+    ++num_inits;
+    std::memcpy(data, weights, sizeof(weights));
+  };
+
+  const void* first =
+      cache.GetOrCreate(weights, Kind::kInt8RowSums, sizeof(weights), init);
+  const void* second =
+      cache.GetOrCreate(weights, Kind::kInt8RowSums, sizeof(weights), init);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(num_inits, 1);
+  EXPECT_EQ(std::memcmp(first, weights, sizeof(weights)), 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(first) % 64, 0);
+  EXPECT_EQ(cache.num_entries(), 1);
+  EXPECT_GE(cache.size_in_bytes(), sizeof(weights));
+}
+
+TEST(SharedWeightCacheTest, KindsAreCachedSeparately) {
+  SharedWeightCache cache;
+  const float weights[2] = {1.0f, 2.0f};
+  const auto init = [](void* data) {};
+
+  const void* row_sums =
+      cache.GetOrCreate(weights, Kind::kInt8RowSums, 8, init);
+  const void* transposed =
+      cache.GetOrCreate(weights, Kind::kTransposedFloatWeights, 8, init);
+  EXPECT_NE(row_sums, transposed);
+  EXPECT_EQ(cache.num_entries(), 2);
+}
+
+TEST(SharedWeightCacheTest, RejectsSizeMismatch) {
+  SharedWeightCache cache;
+  const float weights[2] = {1.0f, 2.0f};
+  const auto init = [](void* data) {};
+
+  EXPECT_NE(cache.GetOrCreate(weights, Kind::kInt8RowSums, 8, init), nullptr);
+  EXPECT_EQ(cache.GetOrCreate(weights, Kind::kInt8RowSums, 16, init), nullptr);
+  EXPECT_EQ(cache.num_entries(), 1);
+}
+
+TEST(SharedWeightCacheTest, MapsOnlyReadOnlyWeights) {
+  SharedWeightCache cache;
+  int8_t weights_data[4] = {1, -2, 3, -4};
+  TfLiteTensor weights = {};
+  weights.data.raw = reinterpret_cast<char*>(weights_data);
+  weights.bytes = sizeof(weights_data);
+
+  int32_t derived_data[1] = {0};
+  TfLiteTensor derived = {};
+  derived.data.raw = reinterpret_cast<char*>(derived_data);
+  derived.bytes = sizeof(derived_data);
+  derived.allocation_type = kTfLiteArenaRwPersistent;
+
+  const auto init = [](void* data) { static_cast<int32_t*>(data)[0] = -2; };
+
+  weights.allocation_type = kTfLiteArenaRw;
+  EXPECT_FALSE(
+      cache.MapDerivedTensor(weights, Kind::kInt8RowSums, &derived, init));
+  EXPECT_EQ(derived.data.raw, reinterpret_cast<char*>(derived_data));
+  EXPECT_EQ(derived.allocation_type, kTfLiteArenaRwPersistent);
+
+  weights.allocation_type = kTfLiteMmapRo;
+  EXPECT_TRUE(
+      cache.MapDerivedTensor(weights, Kind::kInt8RowSums, &derived, init));
+  EXPECT_EQ(derived.allocation_type, kTfLiteMmapRo);
+  EXPECT_EQ(derived.data.i32[0], -2);
+}
+
+TEST(SharedWeightCacheTest, UsesExternalBuffers) {
+  SharedWeightCache cache;
+  const float weights[2] = {1.0f, 2.0f};
+  const float precomputed[2] = {2.0f, 1.0f};
+  ASSERT_TRUE(cache.AddExternalBuffer(weights, Kind::kTransposedFloatWeights,
+                                      sizeof(precomputed), precomputed));
+  EXPECT_FALSE(cache.AddExternalBuffer(weights, Kind::kTransposedFloatWeights,
+                                       sizeof(precomputed), precomputed));
+
+  int num_inits = 0;
+  const auto init = [&num_inits](void* data) { ++num_inits; };
+  EXPECT_EQ(cache.GetOrCreate(weights, Kind::kTransposedFloatWeights,
+                              sizeof(precomputed), init),
+            precomputed);
+  EXPECT_EQ(num_inits, 0);
+  EXPECT_EQ(cache.size_in_bytes(), sizeof(precomputed));
+
+  const void* row_sums =
+      cache.GetOrCreate(weights, Kind::kInt8RowSums, 8, init);
+  EXPECT_EQ(num_inits, 1);
+  const std::vector<SharedWeightCache::BufferInfo> buffers =
+      cache.GetBuffers();
+  ASSERT_EQ(buffers.size(), 2);
+  for (const SharedWeightCache::BufferInfo& buffer : buffers) {
+    EXPECT_EQ(buffer.weights, weights);
+    if (buffer.kind == Kind::kTransposedFloatWeights) {
+      EXPECT_EQ(buffer.data, precomputed);
+      EXPECT_EQ(buffer.bytes, sizeof(precomputed));
+    } else {
+      EXPECT_EQ(buffer.data, row_sums);
+      EXPECT_EQ(buffer.bytes, 8);
+    }
+  }
+}
+
+TEST(SharedWeightCacheTest, ValidatesExternalBuffersOnFirstRequest) {
+  SharedWeightCache cache;
+  const float weights[2] = {1.0f, 2.0f};
+  const float valid[2] = {2.0f, 1.0f};
+  const float invalid[2] = {0.0f, 0.0f};
+  int num_validations = 0;
+  const auto validate = [&num_validations, &valid](const void* data) {
+    ++num_validations;
+    return data == valid;
+  };
+  ASSERT_TRUE(cache.AddExternalBuffer(weights, Kind::kTransposedFloatWeights,
+                                      sizeof(valid), valid, validate));
+  ASSERT_TRUE(cache.AddExternalBuffer(weights, Kind::kInt8RowSums,
+                                      sizeof(invalid), invalid, validate));
+  EXPECT_EQ(num_validations, 0);
+  EXPECT_TRUE(cache.GetBuffers().empty());
+
+  int num_inits = 0;
+  const auto init = [&num_inits](void* data) { ++num_inits; };
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(cache.GetOrCreate(weights, Kind::kTransposedFloatWeights,
+                                sizeof(valid), init),
+              valid);
+  }
+  EXPECT_EQ(num_validations, 1);
+  EXPECT_EQ(num_inits, 0);
+
+  // The invalid buffer is replaced with a new one.
+  const void* row_sums =
+      cache.GetOrCreate(weights, Kind::kInt8RowSums, sizeof(invalid), init);
+  EXPECT_NE(row_sums, nullptr);
+  EXPECT_NE(row_sums, invalid);
+  EXPECT_EQ(num_validations, 2);
+  EXPECT_EQ(num_inits, 1);
+  EXPECT_EQ(cache.GetBuffers().size(), 2);
+}
+
+TEST(SharedWeightCacheTest, ConcurrentRequestsShareOneBuffer) {
+  SharedWeightCache cache;
+  const int32_t weights[16] = {};
+  constexpr int kNumThreads = 8;
+  std::vector<const void*> results(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&cache, &weights, &results, i]() {
+      results[i] =
+          cache.GetOrCreate(weights, Kind::kInt8RowSums, sizeof(weights),
+                            [](void* data) {});
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    EXPECT_EQ(results[i], results[0]);
+  }
+  EXPECT_EQ(cache.num_entries(), 1);
+}
+
+}  // namespace
+}  // namespace tflite
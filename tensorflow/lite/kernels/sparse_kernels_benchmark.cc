@@ -0,0 +1,243 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Compares the sparse 1x1 Conv2D and BatchMatMul kernels with the dense ones
+// for weights with 50% to 95% of zeros. For every sparsity, prints the
+// average latency of one invocation of the op with dense weights, of the op
+// with the same weights in the TFLite sparse format (which only uses the
+// sparse kernel from kMinSparsityForSparseMatMul on), and of the sparse
+// matrix multiplication alone.
+//
+// Example:
+//   bazel run -c opt //tensorflow/lite/kernels:sparse_kernels_benchmark
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/sparse_matmul.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/profiling/time.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/tools/optimize/sparsity/format_converter.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kNumRuns = 50;
+
+// Returns a [rows, cols] weight matrix in which about `sparsity` of the values
+// are zeros. With `block_size` 4, the zeros come in 1x4 blocks.
+std::vector<float> SparseWeights(int rows, int cols, float sparsity,
+                                 int block_size) {
+  std::vector<float> weights(rows * cols);
+  const uint32_t threshold = static_cast<uint32_t>(sparsity * 1000);
+  for (int i = 0; i < rows * cols; ++i) {
+    const uint32_t block = static_cast<uint32_t>(i / block_size);
+    const bool is_zero = (block * 2654435761u) % 1000 < threshold;
+    weights[i] = is_zero ? 0.f : static_cast<float>(i % 7) - 3.f;
+  }
+  return weights;
+}
+
+// Returns the TensorData of [..., cols] weights in the TFLite sparse format.
+// The innermost dimension is compressed if `sparse` is true, optionally in
+// blocks of `block_size`. Otherwise all the dimensions are dense, so that the
+// kernels densify the weights once and then use the dense kernels.
+TensorData WeightsTensor(const std::vector<int>& shape, bool sparse,
+                         int block_size) {
+  TensorData weights = {TensorType_FLOAT32, shape};
+  const int rank = shape.size();
+  for (int i = 0; i < rank; ++i) weights.traversal_order.push_back(i);
+  weights.format.assign(rank, kTfLiteDimDense);
+  if (!sparse) return weights;
+  weights.format.back() = kTfLiteDimSparseCSR;
+  if (block_size > 1) {
+    weights.traversal_order.push_back(rank);
+    weights.block_map = {rank - 1};
+    weights.block_size = {block_size};
+  }
+  return weights;
+}
+
+class BenchmarkOpModel : public SingleOpModel {
+ public:
+  // Fills the input with a ramp, and returns the average latency of one
+  // invocation in microseconds.
+  double Run() {
+    const int size = GetTensorSize(input_);
+    std::vector<float> data(size);
+    for (int i = 0; i < size; ++i) data[i] = (i % 256) / 256.f;
+    PopulateTensor(input_, data);
+    if (InvokeUnchecked() != kTfLiteOk) return -1;
+    const uint64_t start_us = profiling::time::NowMicros();
+    for (int i = 0; i < kNumRuns; ++i) {
+      if (InvokeUnchecked() != kTfLiteOk) return -1;
+    }
+    return static_cast<double>(profiling::time::NowMicros() - start_us) /
+           kNumRuns;
+  }
+
+ protected:
+  int input_;
+};
+
+// 1x1 convolution of a [1, size, size, depth] input with
+// [depth, 1, 1, depth] weights.
+class Conv1x1Model : public BenchmarkOpModel {
+ public:
+  Conv1x1Model(int size, int depth, const TensorData& filter,
+               const std::vector<float>& filter_data) {
+    input_ = AddInput({TensorType_FLOAT32, {1, size, size, depth}});
+    AddConstSparseInput(filter, filter_data);
+    const int bias = AddInput({TensorType_FLOAT32, {depth}});
+    AddOutput({TensorType_FLOAT32, {}});
+    SetBuiltinOp(BuiltinOperator_CONV_2D, BuiltinOptions_Conv2DOptions,
+                 CreateConv2DOptions(builder_, Padding_VALID, 1, 1,
+                                     ActivationFunctionType_NONE)
+                     .Union());
+    BuildInterpreter({GetShape(input_), filter.shape, {depth}},
+                     /*num_threads=*/1, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+    PopulateTensor(bias, std::vector<float>(depth, 0.f));
+  }
+};
+
+// Batch matrix multiplication of a [batches, depth] input with [depth, depth]
+// weights.
+class BatchMatMulModel : public BenchmarkOpModel {
+ public:
+  BatchMatMulModel(int batches, int depth, const TensorData& rhs,
+                   const std::vector<float>& rhs_data) {
+    input_ = AddInput({TensorType_FLOAT32, {batches, depth}});
+    AddConstSparseInput(rhs, rhs_data);
+    AddOutput({TensorType_FLOAT32, {}});
+    SetBuiltinOp(BuiltinOperator_BATCH_MATMUL,
+                 BuiltinOptions_BatchMatMulOptions,
+                 CreateBatchMatMulOptions(builder_).Union());
+    BuildInterpreter({GetShape(input_), rhs.shape}, /*num_threads=*/1,
+                     /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+  }
+};
+
+// Returns the average latency in microseconds of RowSparseMatMul of
+// `batches` input rows with the [depth, depth] `weights`, whatever their
+// sparsity is.
+double RunRowSparseMatMul(int batches, int depth, float sparsity,
+                          int block_size, bool transposed) {
+  const std::vector<float> weights =
+      SparseWeights(depth, depth, sparsity, block_size);
+  const TensorData format = WeightsTensor({depth, depth}, true, block_size);
+  optimize::sparsity::FormatConverter<float> converter(
+      format.shape, format.traversal_order, format.format, format.block_size,
+      format.block_map);
+  converter.DenseToSparse(weights.data());
+  const std::vector<float> values = converter.GetData();
+  const std::vector<std::vector<int>> dim_metadata =
+      converter.GetDimMetadata();
+
+  optimized_ops::RowSparseMatrix matrix;
+  matrix.rows = depth;
+  matrix.cols = depth;
+  matrix.block_size = block_size;
+  matrix.segments = dim_metadata[2].data();
+  matrix.indices = dim_metadata[3].data();
+  matrix.values = values.data();
+
+  std::vector<float> input(batches * depth);
+  for (int i = 0; i < batches * depth; ++i) input[i] = (i % 256) / 256.f;
+  std::vector<float> output(batches * depth);
+  CpuBackendContext context;
+  context.SetMaxNumThreads(1);
+  std::vector<optimized_ops::RowSparseMatMulTask> tasks;
+  optimized_ops::RowSparseMatMul(matrix, transposed, input.data(), batches,
+                                 output.data(), &tasks, &context);
+  const uint64_t start_us = profiling::time::NowMicros();
+  for (int i = 0; i < kNumRuns; ++i) {
+    optimized_ops::RowSparseMatMul(matrix, transposed, input.data(), batches,
+                                   output.data(), &tasks, &context);
+  }
+  return static_cast<double>(profiling::time::NowMicros() - start_us) /
+         kNumRuns;
+}
+
+void PrintResult(const std::string& name, float sparsity, double dense_us,
+                 double sparse_op_us, double sparse_kernel_us) {
+  printf("%-36s sparsity=%.1f  dense=%9.1f us  sparse op=%9.1f us  "
+         "sparse kernel=%9.1f us  speedup=%.2fx\n",
+         name.c_str(), sparsity, dense_us, sparse_op_us, sparse_kernel_us,
+         dense_us / sparse_kernel_us);
+}
+
+int Main() {
+  constexpr int kSize = 28;
+  constexpr int kBatches = 128;
+  constexpr int kDepth = 256;
+  for (int block_size : {1, 4}) {
+    for (float sparsity : {0.5f, 0.6f, 0.7f, 0.8f, 0.85f, 0.9f, 0.95f}) {
+      const std::vector<float> weights =
+          SparseWeights(kDepth, kDepth, sparsity, block_size);
+      const std::vector<int> filter_shape = {kDepth, 1, 1, kDepth};
+      const std::string suffix = block_size == 1 ? " random" : " 1x4 blocks";
+
+      const double conv_dense_us =
+          Conv1x1Model(kSize, kDepth, WeightsTensor(filter_shape, false, 1),
+                       weights)
+              .Run();
+      const double conv_sparse_us =
+          Conv1x1Model(kSize, kDepth,
+                       WeightsTensor(filter_shape, true, block_size), weights)
+              .Run();
+      const double conv_kernel_us =
+          RunRowSparseMatMul(kSize * kSize, kDepth, sparsity, block_size,
+                             /*transposed=*/false);
+      if (conv_dense_us < 0 || conv_sparse_us < 0) {
+        fprintf(stderr, "Failed to invoke CONV_2D.\n");
+        return 1;
+      }
+      PrintResult("Conv1x1 [1,28,28,256]" + suffix, sparsity, conv_dense_us,
+                  conv_sparse_us, conv_kernel_us);
+
+      const double matmul_dense_us =
+          BatchMatMulModel(kBatches, kDepth,
+                           WeightsTensor({kDepth, kDepth}, false, 1), weights)
+              .Run();
+      const double matmul_sparse_us =
+          BatchMatMulModel(kBatches, kDepth,
+                           WeightsTensor({kDepth, kDepth}, true, block_size),
+                           weights)
+              .Run();
+      const double matmul_kernel_us =
+          RunRowSparseMatMul(kBatches, kDepth, sparsity, block_size,
+                             /*transposed=*/true);
+      if (matmul_dense_us < 0 || matmul_sparse_us < 0) {
+        fprintf(stderr, "Failed to invoke BATCH_MATMUL.\n");
+        return 1;
+      }
+      PrintResult("BatchMatMul [128,256]x[256,256]" + suffix, sparsity,
+                  matmul_dense_us, matmul_sparse_us, matmul_kernel_us);
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) { return tflite::Main(); }
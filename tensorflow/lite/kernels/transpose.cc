@@ -15,6 +15,7 @@ limitations under the License.
 #include <stdint.h>
 
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
 #include "tensorflow/lite/kernels/internal/reference/reference_ops.h"
@@ -109,6 +110,12 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                   GetTensorData<scalar>(op_context.input),  \
                   GetTensorShape(op_context.output),        \
                   GetTensorData<scalar>(op_context.output))
+#define TF_LITE_OPTIMIZED_TRANSPOSE(scalar)                          \
+  optimized_ops::Transpose(params, GetTensorShape(op_context.input), \
+                           GetTensorData<scalar>(op_context.input),  \
+                           GetTensorShape(op_context.output),        \
+                           GetTensorData<scalar>(op_context.output), \
+                           CpuBackendContext::GetFromContext(context))
 
   // Transpose kernel only does rearranging values not numeric evaluations on
   // each cell. It's safe to implement per size of scalar type and this trick
@@ -117,7 +124,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     case kTfLiteFloat32:
     case kTfLiteInt32:
       if (kernel_type == kGenericOptimized) {
-        TF_LITE_TRANSPOSE(optimized_ops, int32_t);
+        TF_LITE_OPTIMIZED_TRANSPOSE(int32_t);
       } else {
         TF_LITE_TRANSPOSE(reference_ops, int32_t);
       }
@@ -125,7 +132,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     case kTfLiteUInt8:
     case kTfLiteInt8:
       if (kernel_type == kGenericOptimized) {
-        TF_LITE_TRANSPOSE(optimized_ops, int8_t);
+        TF_LITE_OPTIMIZED_TRANSPOSE(int8_t);
       } else {
         TF_LITE_TRANSPOSE(reference_ops, int8_t);
       }
@@ -139,7 +146,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     case kTfLiteBool:
       if (sizeof(bool) == 1) {
         if (kernel_type == kGenericOptimized) {
-          TF_LITE_TRANSPOSE(optimized_ops, int8_t);
+          TF_LITE_OPTIMIZED_TRANSPOSE(int8_t);
         } else {
           TF_LITE_TRANSPOSE(reference_ops, int8_t);
         }
@@ -153,6 +160,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                          TfLiteTypeGetName(op_context.input->type));
       return kTfLiteError;
   }
+#undef TF_LITE_OPTIMIZED_TRANSPOSE
 #undef TF_LITE_TRANSPOSE
 
   return kTfLiteOk;
@@ -15,6 +15,7 @@ limitations under the License.
 #include <stdint.h>
 
 #include <initializer_list>
+#include <numeric>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -213,6 +214,10 @@ class TransposeOpModel : public SingleOpModel {
     PopulateTensor<float>(input_, data);
   }
 
+  void SetInput(const std::vector<float>& data) {
+    PopulateTensor<float>(input_, data);
+  }
+
   void SetPerm(std::initializer_list<int> data) {
     PopulateTensor<int>(perm_, data);
   }
@@ -694,5 +699,35 @@ TEST(TransposeTest, Complex5DTestWithReorderDynamicTensor) {
   EXPECT_THAT(m.GetOutput(), result);
 }
 
+TEST(TransposeTest, LargeBatchMultithreaded) {
+  // Large enough for the batches to be transposed by different threads.
+  constexpr int kBatches = 8;
+  constexpr int kHeight = 32;
+  constexpr int kWidth = 32;
+  constexpr int kDepth = 16;
+  TransposeOpConstModel m({kBatches, kHeight, kWidth, kDepth}, {4},
+                          {0, 3, 1, 2});
+  m.SetNumThreads(4);
+  std::vector<float> input(kBatches * kHeight * kWidth * kDepth);
+  std::iota(input.begin(), input.end(), 0.0f);
+  m.SetInput(input);
+  m.Invoke();
+
+  std::vector<float> expected;
+  for (int b = 0; b < kBatches; ++b) {
+    for (int d = 0; d < kDepth; ++d) {
+      for (int h = 0; h < kHeight; ++h) {
+        for (int w = 0; w < kWidth; ++w) {
+          const int input_index = ((b * kHeight + h) * kWidth + w) * kDepth + d;
+          expected.push_back(input[input_index]);
+        }
+      }
+    }
+  }
+  EXPECT_THAT(m.GetOutputShape(),
+              ElementsAreArray({kBatches, kDepth, kHeight, kWidth}));
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(expected));
+}
+
 }  // namespace
 }  // namespace tflite
@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_MEMORY_PLANNER_H_
 #define TENSORFLOW_LITE_MEMORY_PLANNER_H_
 
+#include <cstddef>
+
 #include "tensorflow/lite/c/common.h"
 
 namespace tflite {
@@ -59,6 +61,25 @@ class MemoryPlanner {
 
   // Returns true if the non-persistent memory is available.
   virtual bool HasNonPersistentMemory() = 0;
+
+  // NOTE: The following methods let the planner own the memory of
+  // kTfLiteDynamic tensors, which would otherwise be (re)allocated on the heap
+  // during Invoke().
+
+  // Called whenever a non-string kTfLiteDynamic tensor is resized to
+  // 'num_bytes'. Returns true if the planner provided the memory, keeping the
+  // tensor's contents, and false if the tensor must be (re)allocated on the
+  // heap with TfLiteTensorRealloc().
+  virtual bool ReallocDynamicTensor(int tensor_index, size_t num_bytes) = 0;
+
+  // Moves dynamic tensors into planner-owned memory, based on the sizes they
+  // have been resized to so far. This must only be called between invocations.
+  virtual TfLiteStatus PlanDynamicAllocations() = 0;
+
+  // Moves all dynamic tensors in planner-owned memory back to the heap,
+  // keeping their contents. This must be called before the data of a dynamic
+  // tensor is freed or replaced outside of Invoke().
+  virtual TfLiteStatus ReleaseDynamicAllocations() = 0;
 };
 
 }  // namespace tflite
@@ -0,0 +1,377 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/prepared_model_cache.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/allocation.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/shared_weight_cache.h"
+#include "tensorflow/lite/minimal_logging.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace tflite {
+namespace {
+
+// File layout: a Header, `num_buffers` BufferEntry, then the buffers, each
+// starting at a multiple of kBufferAlignment from the start of the file. The
+// mapping of the file is page-aligned, so the buffers have the same alignment
+// as the ones allocated by SharedWeightCache.
+//
+// Load only reads the header and the entries, whose fingerprint is in the
+// header. Every entry holds the fingerprints of its buffer and of the weights
+// it was derived from, which are only checked when a kernel first requests
+// the buffer, so that loading doesn't fault in the whole file and model.
+constexpr char kMagic[8] = {'T', 'F', 'L', 'P', 'R', 'E', 'P', '\0'};
+constexpr uint32_t kFormatVersion = 3;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr uint64_t kBufferAlignment = 64;
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+constexpr char kArchitecture[] = "aarch64";
+#elif defined(__arm__) || defined(_M_ARM)
+constexpr char kArchitecture[] = "arm";
+#elif defined(__x86_64__) || defined(_M_X64)
+constexpr char kArchitecture[] = "x86_64";
+#elif defined(__i386__) || defined(_M_IX86)
+constexpr char kArchitecture[] = "x86";
+#else
+constexpr char kArchitecture[] = "unknown";
+#endif
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order_mark;
+  // NUL-padded, and truncated if need be.
+  char tflite_version[32];
+  char architecture[16];
+  uint32_t derived_data_version;
+  uint32_t num_buffers;
+  uint64_t model_fingerprint;
+  uint64_t model_size;
+  uint64_t entries_fingerprint;
+};
+
+struct BufferEntry {
+  uint64_t weights_offset;
+  uint64_t weights_bytes;
+  uint64_t weights_fingerprint;
+  uint32_t kind;
+  uint32_t reserved;
+  uint64_t data_offset;
+  uint64_t bytes;
+  uint64_t data_fingerprint;
+};
+
+bool IsValidKind(uint32_t kind) {
+  switch (static_cast<SharedWeightCache::Kind>(kind)) {
+    case SharedWeightCache::Kind::kTransposedFloatWeights:
+    case SharedWeightCache::Kind::kInt8RowSums:
+      return true;
+  }
+  return false;
+}
+
+// Returns the 64-bit FNV-1a hash, over 8-byte words, of the `size` bytes at
+// `data` following a sequence whose hash is `hash`.
+uint64_t Fingerprint(uint64_t hash, const void* data, size_t size) {
+  constexpr uint64_t kPrime = 1099511628211ull;
+  const char* bytes = static_cast<const char*>(data);
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    hash = (hash ^ word) * kPrime;
+  }
+  for (; i < size; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(bytes[i])) * kPrime;
+  }
+  return hash;
+}
+
+uint64_t Fingerprint(const void* data, size_t size) {
+  return Fingerprint(14695981039346656037ull ^ size, data, size);
+}
+
+// Copies `value` to the NUL-padded `size` bytes at `field`.
+void SetStringField(const char* value, char* field, size_t size) {
+  std::memset(field, 0, size);
+  std::strncpy(field, value, size - 1);
+}
+
+// Sets all the fields of `header` which only depend on the build.
+void SetBuildFields(Header* header) {
+  std::memcpy(header->magic, kMagic, sizeof(kMagic));
+  header->version = kFormatVersion;
+  header->byte_order_mark = kByteOrderMark;
+  SetStringField(TFLITE_VERSION_STRING, header->tflite_version,
+                 sizeof(header->tflite_version));
+  SetStringField(kArchitecture, header->architecture,
+                 sizeof(header->architecture));
+  header->derived_data_version = SharedWeightCache::kDerivedDataVersion;
+}
+
+// Returns the number of bytes from `weights` to the end of the buffer of
+// `model` holding them, or 0 if they aren't in one.
+uint64_t WeightsBytes(const FlatBufferModel& model, uintptr_t weights) {
+  const auto* buffers = model->buffers();
+  if (buffers == nullptr) return 0;
+  for (const Buffer* buffer : *buffers) {
+    if (buffer == nullptr || buffer->data() == nullptr) continue;
+    const uintptr_t start =
+        reinterpret_cast<uintptr_t>(buffer->data()->data());
+    if (weights >= start && weights - start < buffer->data()->size()) {
+      return buffer->data()->size() - (weights - start);
+    }
+  }
+  return 0;
+}
+
+uint64_t AlignUp(uint64_t offset) {
+  return (offset + kBufferAlignment - 1) / kBufferAlignment * kBufferAlignment;
+}
+
+bool FileExists(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) return false;
+  fclose(file);
+  return true;
+}
+
+}  // namespace
+
+std::string PreparedModelCache::DefaultPath(const std::string& model_path) {
+  return model_path + "." + kArchitecture + ".prepared";
+}
+
+uint64_t PreparedModelCache::ModelFingerprint(const FlatBufferModel& model) {
+  const Allocation* allocation = model.allocation();
+  if (allocation == nullptr || !allocation->valid()) return 0;
+  const char* data = static_cast<const char*>(allocation->base());
+  const size_t size = allocation->bytes();
+
+  // Small buffers are hashed whole, larger ones through kNumSamples evenly
+  // spaced windows, which bounds the number of pages read to start a model.
+  // Entries are checked against the weights they derive from anyway.
+  constexpr size_t kNumSamples = 64;
+  constexpr size_t kSampleBytes = 64;
+  uint64_t hash;
+  if (size <= kNumSamples * kSampleBytes) {
+    hash = Fingerprint(data, size);
+  } else {
+    hash = 14695981039346656037ull ^ size;
+    const size_t stride = (size - kSampleBytes) / (kNumSamples - 1);
+    for (size_t i = 0; i < kNumSamples; ++i) {
+      hash = Fingerprint(hash, data + i * stride, kSampleBytes);
+    }
+  }
+  // 0 means "no fingerprint".
+  return hash == 0 ? 1 : hash;
+}
+
+std::unique_ptr<PreparedModelCache> PreparedModelCache::Load(
+    const std::string& path, const FlatBufferModel& model,
+    SharedWeightCache* cache) {
+  const Allocation* model_allocation = model.allocation();
+  if (cache == nullptr || model_allocation == nullptr || !FileExists(path)) {
+    return nullptr;
+  }
+
+  std::unique_ptr<Allocation> allocation;
+  if (MMAPAllocation::IsSupported()) {
+    allocation.reset(new MMAPAllocation(path.c_str(), model.error_reporter()));
+  } else {
+    allocation.reset(
+        new FileCopyAllocation(path.c_str(), model.error_reporter()));
+  }
+  if (!allocation->valid() || allocation->bytes() < sizeof(Header)) {
+    return nullptr;
+  }
+
+  const char* file = static_cast<const char*>(allocation->base());
+  const uint64_t file_size = allocation->bytes();
+  Header header;
+  std::memcpy(&header, file, sizeof(header));
+  Header expected;
+  SetBuildFields(&expected);
+  // Compares everything up to num_buffers, which is the first field that
+  // doesn't only depend on the build.
+  if (std::memcmp(&header, &expected, offsetof(Header, num_buffers)) != 0) {
+    TFLITE_LOG(TFLITE_LOG_INFO,
+               "Ignoring prepared model cache '%s' written by another build.",
+               path.c_str());
+    return nullptr;
+  }
+  if (header.model_size != model_allocation->bytes() ||
+      header.model_fingerprint != ModelFingerprint(model) ||
+      sizeof(Header) + static_cast<uint64_t>(header.num_buffers) *
+                           sizeof(BufferEntry) >
+          file_size) {
+    TFLITE_LOG(TFLITE_LOG_INFO,
+               "Ignoring prepared model cache '%s' written for another model.",
+               path.c_str());
+    return nullptr;
+  }
+
+  // Validates all the entries before adding any of them to the cache.
+  std::vector<BufferEntry> entries(header.num_buffers);
+  if (!entries.empty()) {
+    std::memcpy(entries.data(), file + sizeof(Header),
+                entries.size() * sizeof(BufferEntry));
+  }
+  bool valid = Fingerprint(entries.data(),
+                           entries.size() * sizeof(BufferEntry)) ==
+               header.entries_fingerprint;
+  for (const BufferEntry& entry : entries) {
+    valid = valid && entry.weights_offset < header.model_size &&
+            entry.weights_bytes <= header.model_size - entry.weights_offset &&
+            IsValidKind(entry.kind) &&
+            entry.data_offset % kBufferAlignment == 0 &&
+            entry.data_offset <= file_size &&
+            entry.bytes <= file_size - entry.data_offset;
+  }
+  if (!valid) {
+    TFLITE_LOG(TFLITE_LOG_WARNING,
+               "Ignoring corrupted prepared model cache '%s'.", path.c_str());
+    return nullptr;
+  }
+
+  std::unique_ptr<PreparedModelCache> prepared_cache(
+      new PreparedModelCache(std::move(allocation)));
+  std::atomic<int>* num_invalid_buffers = &prepared_cache->num_invalid_buffers_;
+  const char* model_base = static_cast<const char*>(model_allocation->base());
+  for (const BufferEntry& entry : entries) {
+    const char* weights = model_base + entry.weights_offset;
+    auto validate = [entry, weights, num_invalid_buffers](const void* data) {
+      if (Fingerprint(weights, entry.weights_bytes) ==
+              entry.weights_fingerprint &&
+          Fingerprint(data, entry.bytes) == entry.data_fingerprint) {
+        return true;
+      }
+      ++*num_invalid_buffers;
+      return false;
+    };
+    if (cache->AddExternalBuffer(
+            weights, static_cast<SharedWeightCache::Kind>(entry.kind),
+            entry.bytes, file + entry.data_offset, validate)) {
+      ++prepared_cache->num_buffers_;
+    }
+  }
+  return prepared_cache;
+}
+
+TfLiteStatus PreparedModelCache::Save(const std::string& path,
+                                      const FlatBufferModel& model,
+                                      const SharedWeightCache& cache) {
+  const Allocation* model_allocation = model.allocation();
+  if (model_allocation == nullptr || !model_allocation->valid()) {
+    model.error_reporter()->Report(
+        "Only models backed by a buffer can have a prepared model cache.");
+    return kTfLiteError;
+  }
+  const uintptr_t model_base =
+      reinterpret_cast<uintptr_t>(model_allocation->base());
+  const uint64_t model_size = model_allocation->bytes();
+
+  // Only data derived from weights in a buffer of the model can be found
+  // again by another process.
+  std::vector<SharedWeightCache::BufferInfo> buffers;
+  std::vector<uint64_t> weights_bytes;
+  for (const auto& buffer : cache.GetBuffers()) {
+    const uintptr_t weights = reinterpret_cast<uintptr_t>(buffer.weights);
+    if (weights >= model_base && weights - model_base < model_size) {
+      const uint64_t bytes = WeightsBytes(model, weights);
+      if (bytes > 0) {
+        buffers.push_back(buffer);
+        weights_bytes.push_back(bytes);
+      }
+    }
+  }
+
+  std::vector<BufferEntry> entries(buffers.size());
+  uint64_t offset = AlignUp(sizeof(Header) + entries.size() *
+                                                  sizeof(BufferEntry));
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    entries[i].weights_offset =
+        reinterpret_cast<uintptr_t>(buffers[i].weights) - model_base;
+    entries[i].weights_bytes = weights_bytes[i];
+    entries[i].weights_fingerprint =
+        Fingerprint(buffers[i].weights, weights_bytes[i]);
+    entries[i].kind = static_cast<uint32_t>(buffers[i].kind);
+    entries[i].reserved = 0;
+    entries[i].data_offset = offset;
+    entries[i].bytes = buffers[i].bytes;
+    entries[i].data_fingerprint =
+        Fingerprint(buffers[i].data, buffers[i].bytes);
+    offset = AlignUp(offset + buffers[i].bytes);
+  }
+
+  Header header;
+  SetBuildFields(&header);
+  header.num_buffers = buffers.size();
+  header.model_fingerprint = ModelFingerprint(model);
+  header.model_size = model_size;
+  header.entries_fingerprint =
+      Fingerprint(entries.data(), entries.size() * sizeof(BufferEntry));
+
+  // Each writer has a temporary file of its own, so that processes saving the
+  // cache concurrently don't write to the same file.
+  std::random_device random_device;
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".tmp%08x%08x", random_device(),
+           random_device());
+  const std::string temp_path = path + suffix;
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (file == nullptr) {
+    model.error_reporter()->Report("Could not open '%s' for writing.",
+                                   temp_path.c_str());
+    return kTfLiteError;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  if (ok && !entries.empty()) {
+    ok = fwrite(entries.data(), sizeof(BufferEntry), entries.size(), file) ==
+         entries.size();
+  }
+  uint64_t written = sizeof(Header) + entries.size() * sizeof(BufferEntry);
+  const char padding[kBufferAlignment] = {};
+  for (size_t i = 0; ok && i < buffers.size(); ++i) {
+    const uint64_t padding_bytes = entries[i].data_offset - written;
+    ok = fwrite(padding, 1, padding_bytes, file) == padding_bytes &&
+         fwrite(buffers[i].data, 1, buffers[i].bytes, file) == buffers[i].bytes;
+    written = entries[i].data_offset + buffers[i].bytes;
+  }
+  ok = fclose(file) == 0 && ok;
+  if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    model.error_reporter()->Report("Failed to write the prepared model cache "
+                                   "'%s'.",
+                                   path.c_str());
+    std::remove(temp_path.c_str());
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
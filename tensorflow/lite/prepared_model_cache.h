@@ -0,0 +1,101 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/// \file
+/// Persists the weight-derived data of a prepared model across processes.
+///
+#ifndef TENSORFLOW_LITE_PREPARED_MODEL_CACHE_H_
+#define TENSORFLOW_LITE_PREPARED_MODEL_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "tensorflow/lite/allocation.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/shared_weight_cache.h"
+#include "tensorflow/lite/model_builder.h"
+
+namespace tflite {
+
+/// A file holding the buffers that kernels derive from the weights of a model
+/// while preparing it (see SharedWeightCache), so that a new process serving
+/// the same model maps them instead of computing them again.
+///
+/// Buffers are identified by the offset of their weights in the model buffer.
+/// Loading a file only reads its header and buffer table, and a sample of the
+/// model buffer: files written for a model of another size or fingerprint, by
+/// another version of TensorFlow Lite, of this format or of the kernels'
+/// derived data, or on another architecture, are ignored. Each buffer is then
+/// checked against a fingerprint of its contents and of the weights it was
+/// derived from the first time a kernel requests it, and computed again if
+/// either doesn't match.
+///
+/// The file is in the native byte order and is only meant to be read on the
+/// kind of machine that wrote it.
+///
+/// WARNING: This is an experimental API and subject to change.
+class PreparedModelCache {
+ public:
+  /// Returns the default location of the cache of the model at `model_path`,
+  /// i.e. next to the model, with a name that depends on the architecture so
+  /// that machines of different kinds sharing the model don't overwrite each
+  /// other's file.
+  static std::string DefaultPath(const std::string& model_path);
+
+  /// Returns a fingerprint of the buffer of `model`, or 0 if the model isn't
+  /// backed by a buffer. Only a bounded sample of large buffers is read, so it
+  /// tells models apart cheaply but doesn't prove that two buffers are equal.
+  static uint64_t ModelFingerprint(const FlatBufferModel& model);
+
+  /// Memory-maps the cache file at `path` and adds its buffers to `cache`.
+  /// Returns nullptr and leaves `cache` untouched if the file doesn't exist
+  /// or doesn't match `model`. Otherwise, the returned object owns the
+  /// mapping and must outlive `cache`.
+  static std::unique_ptr<PreparedModelCache> Load(const std::string& path,
+                                                  const FlatBufferModel& model,
+                                                  SharedWeightCache* cache);
+
+  /// Writes the buffers of `cache` derived from the weights of `model` to
+  /// `path`. The file is written to a uniquely named file next to `path` then
+  /// renamed, so processes loading or saving it concurrently see either the
+  /// old or a complete new file.
+  static TfLiteStatus Save(const std::string& path,
+                           const FlatBufferModel& model,
+                           const SharedWeightCache& cache);
+
+  /// Number of buffers loaded from the file.
+  int num_buffers() const { return num_buffers_; }
+
+  /// Number of loaded buffers which didn't match their fingerprints when
+  /// first requested, and were computed again.
+  int num_invalid_buffers() const { return num_invalid_buffers_; }
+
+  PreparedModelCache(const PreparedModelCache&) = delete;
+  PreparedModelCache& operator=(const PreparedModelCache&) = delete;
+
+ private:
+  explicit PreparedModelCache(std::unique_ptr<Allocation> allocation)
+      : allocation_(std::move(allocation)) {}
+
+  std::unique_ptr<Allocation> allocation_;
+  int num_buffers_ = 0;
+  std::atomic<int> num_invalid_buffers_{0};
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PREPARED_MODEL_CACHE_H_
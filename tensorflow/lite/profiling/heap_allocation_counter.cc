@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Counts the heap allocations of the process by wrapping the glibc allocation
+// functions, which operator new is implemented with as well. Linking this file
+// into a binary makes tflite::profiling::memory::GetNumHeapAllocations() return
+// the count.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/profiling/memory_info.h"
+
+#if defined(__GLIBC__)
+
+#include <errno.h>
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+}  // extern "C"
+
+namespace {
+
+std::atomic<int64_t> num_heap_allocations(0);
+
+inline void CountAllocation() {
+  num_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+extern "C" {
+
+void* malloc(size_t size) {
+  CountAllocation();
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size) {
+  CountAllocation();
+  return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  CountAllocation();
+  return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+  CountAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  CountAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+  if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+  CountAllocation();
+  void* result = __libc_memalign(alignment, size);
+  if (result == nullptr) return ENOMEM;
+  *ptr = result;
+  return 0;
+}
+
+}  // extern "C"
+
+namespace tflite {
+namespace profiling {
+namespace memory {
+
+int64_t GetNumHeapAllocations() {
+  return num_heap_allocations.load(std::memory_order_relaxed);
+}
+
+}  // namespace memory
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // defined(__GLIBC__)
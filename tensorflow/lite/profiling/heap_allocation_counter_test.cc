@@ -0,0 +1,59 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/profiling/memory_info.h"
+
+namespace tflite {
+namespace profiling {
+namespace memory {
+
+#ifdef __GLIBC__
+
+TEST(HeapAllocationCounter, CountsAllocations) {
+  ASSERT_TRUE(MemoryUsage::IsHeapAllocationCountSupported());
+
+  const MemoryUsage start = GetMemoryUsage();
+  std::vector<void*> buffers;
+  buffers.push_back(std::malloc(16));
+  buffers.push_back(std::calloc(4, 16));
+  buffers.back() = std::realloc(buffers.back(), 1024);
+  void* aligned;
+  ASSERT_EQ(0, posix_memalign(&aligned, 64, 128));
+  buffers.push_back(aligned);
+  std::unique_ptr<int[]> int_array(new int[256]);
+  const MemoryUsage end = GetMemoryUsage();
+  for (void* buffer : buffers) std::free(buffer);
+
+  // The vector allocates too, so this is a lower bound.
+  EXPECT_GE((end - start).num_heap_allocations, 5);
+}
+
+TEST(HeapAllocationCounter, NoAllocationsCounted) {
+  const int64_t start = GetNumHeapAllocations();
+  int sum = 0;
+  for (int i = 0; i < 100; ++i) sum += i;
+  EXPECT_EQ(4950, sum);
+  EXPECT_EQ(start, GetNumHeapAllocations());
+}
+
+#endif  // __GLIBC__
+
+}  // namespace memory
+}  // namespace profiling
+}  // namespace tflite
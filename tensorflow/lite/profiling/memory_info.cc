@@ -20,6 +20,8 @@ limitations under the License.
 #include <sys/time.h>
 #endif
 
+#include "tensorflow/lite/core/macros.h"
+
 namespace tflite {
 namespace profiling {
 namespace memory {
@@ -33,6 +35,13 @@ bool MemoryUsage::IsSupported() {
   return false;
 }
 
+bool MemoryUsage::IsHeapAllocationCountSupported() {
+  return GetNumHeapAllocations() >= 0;
+}
+
+// Overridden by the strong definition in heap_allocation_counter.cc.
+TFLITE_ATTRIBUTE_WEAK int64_t GetNumHeapAllocations() { return -1; }
+
 MemoryUsage GetMemoryUsage() {
   MemoryUsage result;
 #ifdef __linux__
@@ -44,6 +53,10 @@ MemoryUsage GetMemoryUsage() {
   result.total_allocated_bytes = mem.arena;
   result.in_use_allocated_bytes = mem.uordblks;
 #endif
+  const int64_t num_heap_allocations = GetNumHeapAllocations();
+  if (num_heap_allocations >= 0) {
+    result.num_heap_allocations = num_heap_allocations;
+  }
   return result;
 }
 
@@ -53,6 +66,9 @@ void MemoryUsage::AllStatsToStream(std::ostream* stream) const {
           << total_allocated_bytes / 1024.0 / 1024.0
           << " MB, in-use allocated/mmapped size = "
           << in_use_allocated_bytes / 1024.0 / 1024.0 << " MB";
+  if (IsHeapAllocationCountSupported()) {
+    *stream << ", heap allocations = " << num_heap_allocations;
+  }
 }
 
 }  // namespace memory
@@ -29,10 +29,15 @@ struct MemoryUsage {
   // indicating whether the values defined in this struct make sense or not.
   static bool IsSupported();
 
+  // Indicates whether heap allocations are counted, i.e. whether
+  // num_heap_allocations makes sense.
+  static bool IsHeapAllocationCountSupported();
+
   MemoryUsage()
       : max_rss_kb(kValueNotSet),
         total_allocated_bytes(kValueNotSet),
-        in_use_allocated_bytes(kValueNotSet) {}
+        in_use_allocated_bytes(kValueNotSet),
+        num_heap_allocations(kValueNotSet) {}
 
   // The maximum memory size (in kilobytes) occupied by an OS process that is
   // held in main memory (RAM). Such memory usage information is generally
@@ -47,6 +52,12 @@ struct MemoryUsage {
   // those are freed). This is an alias to mallinfo::uordblks.
   int in_use_allocated_bytes;
 
+  // The number of heap allocations (malloc, calloc, realloc and aligned
+  // allocations, and so operator new) made by the process. The difference
+  // between two readings around an inference gives the number of heap
+  // allocations per inference. See GetNumHeapAllocations().
+  int64_t num_heap_allocations;
+
   MemoryUsage operator+(MemoryUsage const& obj) const {
     MemoryUsage res;
     res.max_rss_kb = max_rss_kb + obj.max_rss_kb;
@@ -54,6 +65,7 @@ struct MemoryUsage {
         total_allocated_bytes + obj.total_allocated_bytes;
     res.in_use_allocated_bytes =
         in_use_allocated_bytes + obj.in_use_allocated_bytes;
+    res.num_heap_allocations = num_heap_allocations + obj.num_heap_allocations;
     return res;
   }
 
@@ -64,6 +76,7 @@ struct MemoryUsage {
         total_allocated_bytes - obj.total_allocated_bytes;
     res.in_use_allocated_bytes =
         in_use_allocated_bytes - obj.in_use_allocated_bytes;
+    res.num_heap_allocations = num_heap_allocations - obj.num_heap_allocations;
     return res;
   }
 
@@ -81,6 +94,13 @@ struct MemoryUsage {
 // systems will be added later.
 MemoryUsage GetMemoryUsage();
 
+// Returns the number of heap allocations made by the process so far, or -1 if
+// they aren't counted. Counting is enabled by linking
+// //tensorflow/lite/profiling:heap_allocation_counter into the binary, which
+// overrides this function. It is only available with glibc, and must not be
+// combined with sanitizers that replace the allocator themselves.
+int64_t GetNumHeapAllocations();
+
 }  // namespace memory
 }  // namespace profiling
 }  // namespace tflite
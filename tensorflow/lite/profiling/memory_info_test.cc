@@ -25,20 +25,24 @@ TEST(MemoryUsage, AddAndSub) {
   mem1.max_rss_kb = 5;
   mem1.total_allocated_bytes = 7000;
   mem1.in_use_allocated_bytes = 2000;
+  mem1.num_heap_allocations = 10;
 
   mem2.max_rss_kb = 3;
   mem2.total_allocated_bytes = 7000;
   mem2.in_use_allocated_bytes = 4000;
+  mem2.num_heap_allocations = 4;
 
   const auto add_mem = mem1 + mem2;
   EXPECT_EQ(8, add_mem.max_rss_kb);
   EXPECT_EQ(14000, add_mem.total_allocated_bytes);
   EXPECT_EQ(6000, add_mem.in_use_allocated_bytes);
+  EXPECT_EQ(14, add_mem.num_heap_allocations);
 
   const auto sub_mem = mem1 - mem2;
   EXPECT_EQ(2, sub_mem.max_rss_kb);
   EXPECT_EQ(0, sub_mem.total_allocated_bytes);
   EXPECT_EQ(-2000, sub_mem.in_use_allocated_bytes);
+  EXPECT_EQ(6, sub_mem.num_heap_allocations);
 }
 
 TEST(MemoryUsage, GetMemoryUsage) {
@@ -46,6 +50,7 @@ TEST(MemoryUsage, GetMemoryUsage) {
   EXPECT_EQ(MemoryUsage::kValueNotSet, result.max_rss_kb);
   EXPECT_EQ(MemoryUsage::kValueNotSet, result.total_allocated_bytes);
   EXPECT_EQ(MemoryUsage::kValueNotSet, result.in_use_allocated_bytes);
+  EXPECT_EQ(MemoryUsage::kValueNotSet, result.num_heap_allocations);
 
 #ifdef __linux__
   // Just allocate some space in heap so that we could meaningful memory usage
@@ -59,6 +64,12 @@ TEST(MemoryUsage, GetMemoryUsage) {
 #endif
 }
 
+TEST(MemoryUsage, HeapAllocationsAreNotCountedByDefault) {
+  EXPECT_FALSE(MemoryUsage::IsHeapAllocationCountSupported());
+  EXPECT_EQ(-1, GetNumHeapAllocations());
+  EXPECT_EQ(MemoryUsage::kValueNotSet, GetMemoryUsage().num_heap_allocations);
+}
+
 TEST(MemoryUsage, IsSupported) {
 #ifdef __linux__
   EXPECT_TRUE(MemoryUsage::IsSupported());
@@ -0,0 +1,327 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/profiling/perf_event_profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // defined(__linux__)
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+// Size of a cache line, used to convert last-level cache misses to the number
+// of bytes read from memory.
+constexpr uint64_t kCacheLineSize = 64;
+
+bool IsOperatorEvent(Profiler::EventType event_type) {
+  return event_type == Profiler::EventType::OPERATOR_INVOKE_EVENT ||
+         event_type == Profiler::EventType::DELEGATE_OPERATOR_INVOKE_EVENT;
+}
+
+#if defined(__linux__)
+int OpenCounter(PerfEventProfiler::Counter counter, int group_fd) {
+  struct perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  switch (counter) {
+    case PerfEventProfiler::Counter::kCpuCycles:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case PerfEventProfiler::Counter::kInstructions:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case PerfEventProfiler::Counter::kCacheMisses:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CACHE_MISSES;
+      break;
+    case PerfEventProfiler::Counter::kTaskClock:
+      attr.type = PERF_TYPE_SOFTWARE;
+      attr.config = PERF_COUNT_SW_TASK_CLOCK;
+      break;
+  }
+  // Only count user space, which is also allowed for unprivileged processes
+  // with the default perf_event_paranoid level.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  // Counts the calling thread on any CPU.
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, /*pid=*/0,
+                                  /*cpu=*/-1, group_fd, /*flags=*/0));
+}
+#endif  // defined(__linux__)
+
+}  // namespace
+
+std::vector<PerfEventProfiler::Counter> PerfEventProfiler::DefaultCounters() {
+  return {Counter::kCpuCycles, Counter::kInstructions, Counter::kCacheMisses};
+}
+
+const char* PerfEventProfiler::GetCounterName(Counter counter) {
+  switch (counter) {
+    case Counter::kCpuCycles:
+      return "cycles";
+    case Counter::kInstructions:
+      return "instructions";
+    case Counter::kCacheMisses:
+      return "LLC misses";
+    case Counter::kTaskClock:
+      return "task clock (ns)";
+  }
+  return "unknown";
+}
+
+PerfEventProfiler::PerfEventProfiler(tflite::Profiler* wrapped_profiler,
+                                     const std::vector<Counter>& counters)
+    : wrapped_profiler_(wrapped_profiler), counters_(counters) {
+#if defined(__linux__)
+  if (counters_.empty() || counters_.size() > kMaxNumCounters) return;
+  for (Counter counter : counters_) {
+    const int fd =
+        OpenCounter(counter, /*group_fd=*/fds_.empty() ? -1 : fds_[0]);
+    if (fd < 0) {
+      for (int opened_fd : fds_) close(opened_fd);
+      fds_.clear();
+      return;
+    }
+    fds_.push_back(fd);
+  }
+  group_fd_ = fds_[0];
+#endif  // defined(__linux__)
+}
+
+PerfEventProfiler::~PerfEventProfiler() {
+#if defined(__linux__)
+  // Close the group leader last.
+  for (auto it = fds_.rbegin(); it != fds_.rend(); ++it) close(*it);
+#endif  // defined(__linux__)
+}
+
+void PerfEventProfiler::Reset() {
+  operator_counters_.clear();
+  operator_indices_.clear();
+  // Events which are still open are no longer counted.
+  for (OpenEvent& event : open_events_) event.operator_index = -1;
+}
+
+bool PerfEventProfiler::ReadCounters(
+    std::array<uint64_t, kMaxNumCounters>* values) const {
+#if defined(__linux__)
+  // With PERF_FORMAT_GROUP, the number of counters is followed by the value of
+  // every counter of the group.
+  uint64_t data[1 + kMaxNumCounters];
+  const size_t size = sizeof(uint64_t) * (1 + counters_.size());
+  if (read(group_fd_, data, size) != static_cast<ssize_t>(size) ||
+      data[0] != counters_.size()) {
+    return false;
+  }
+  std::copy(data + 1, data + 1 + counters_.size(), values->begin());
+  return true;
+#else
+  return false;
+#endif  // defined(__linux__)
+}
+
+uint32_t PerfEventProfiler::BeginEvent(const char* tag, EventType event_type,
+                                       int64_t event_metadata1,
+                                       int64_t event_metadata2) {
+  OpenEvent event;
+  event.wrapped_handle =
+      wrapped_profiler_ == nullptr
+          ? 0
+          : wrapped_profiler_->BeginEvent(tag, event_type, event_metadata1,
+                                          event_metadata2);
+  event.operator_index = -1;
+  event.ended = false;
+  if (enabled_ && IsAvailable() && IsOperatorEvent(event_type) &&
+      ReadCounters(&event.begin_values)) {
+    const auto key = std::make_tuple(static_cast<int>(event_type),
+                                     event_metadata2, event_metadata1, tag);
+    auto it = operator_indices_.find(key);
+    if (it == operator_indices_.end()) {
+      OperatorCounters op;
+      op.tag = tag == nullptr ? "" : tag;
+      op.event_type = event_type;
+      op.node_index = event_metadata1;
+      op.subgraph_index = event_metadata2;
+      it = operator_indices_
+               .emplace(key, static_cast<int>(operator_counters_.size()))
+               .first;
+      operator_counters_.push_back(std::move(op));
+    }
+    event.operator_index = it->second;
+  }
+  open_events_.push_back(event);
+  return static_cast<uint32_t>(open_events_.size() - 1);
+}
+
+void PerfEventProfiler::EndOpenEvent(uint32_t event_handle) {
+  OpenEvent& event = open_events_[event_handle];
+  std::array<uint64_t, kMaxNumCounters> end_values;
+  if (event.operator_index >= 0 && ReadCounters(&end_values)) {
+    OperatorCounters& op = operator_counters_[event.operator_index];
+    for (size_t i = 0; i < counters_.size(); ++i) {
+      op.values[i] += end_values[i] - event.begin_values[i];
+    }
+    op.count++;
+  }
+  event.ended = true;
+  // Events usually end in the reverse order of their beginning, which keeps
+  // the handles of the events that are still open valid.
+  while (!open_events_.empty() && open_events_.back().ended) {
+    open_events_.pop_back();
+  }
+}
+
+void PerfEventProfiler::EndEvent(uint32_t event_handle) {
+  if (event_handle >= open_events_.size()) return;
+  if (wrapped_profiler_ != nullptr) {
+    wrapped_profiler_->EndEvent(open_events_[event_handle].wrapped_handle);
+  }
+  EndOpenEvent(event_handle);
+}
+
+void PerfEventProfiler::EndEvent(uint32_t event_handle,
+                                 int64_t event_metadata1,
+                                 int64_t event_metadata2) {
+  if (event_handle >= open_events_.size()) return;
+  if (wrapped_profiler_ != nullptr) {
+    wrapped_profiler_->EndEvent(open_events_[event_handle].wrapped_handle,
+                                event_metadata1, event_metadata2);
+  }
+  EndOpenEvent(event_handle);
+}
+
+void PerfEventProfiler::AddEvent(const char* tag, EventType event_type,
+                                 uint64_t start, uint64_t end,
+                                 int64_t event_metadata1,
+                                 int64_t event_metadata2) {
+  if (wrapped_profiler_ != nullptr) {
+    wrapped_profiler_->AddEvent(tag, event_type, start, end, event_metadata1,
+                                event_metadata2);
+  }
+}
+
+std::string PerfEventProfiler::GetOutputString(bool csv_format) const {
+  const auto counter_index = [this](Counter counter) {
+    return std::find(counters_.begin(), counters_.end(), counter) -
+           counters_.begin();
+  };
+  const size_t cycles_index = counter_index(Counter::kCpuCycles);
+  const size_t instructions_index = counter_index(Counter::kInstructions);
+  const size_t cache_misses_index = counter_index(Counter::kCacheMisses);
+  const bool has_ipc = cycles_index < counters_.size() &&
+                       instructions_index < counters_.size();
+  const bool has_miss_bytes = cache_misses_index < counters_.size();
+
+  // The share of every operator is computed from the first counter.
+  uint64_t first_counter_total = 0;
+  for (const OperatorCounters& op : operator_counters_) {
+    first_counter_total += op.values[0];
+  }
+
+  std::vector<std::string> header = {"node type", "subgraph", "node",
+                                     "count"};
+  for (Counter counter : counters_) {
+    header.push_back(std::string("avg ") + GetCounterName(counter));
+  }
+  if (has_ipc) header.push_back("IPC");
+  if (has_miss_bytes) header.push_back("avg LLC miss bytes");
+  if (!counters_.empty()) {
+    header.push_back(std::string("% ") + GetCounterName(counters_[0]));
+  }
+
+  std::vector<std::vector<std::string>> rows;
+  for (const OperatorCounters& op : operator_counters_) {
+    if (op.count == 0) continue;
+    std::vector<std::string> row = {
+        op.event_type == EventType::DELEGATE_OPERATOR_INVOKE_EVENT
+            ? op.tag + " (delegate internal)"
+            : op.tag,
+        std::to_string(op.subgraph_index), std::to_string(op.node_index),
+        std::to_string(op.count)};
+    for (size_t i = 0; i < counters_.size(); ++i) {
+      row.push_back(std::to_string(op.values[i] / op.count));
+    }
+    std::ostringstream value;
+    value << std::fixed << std::setprecision(2);
+    if (has_ipc) {
+      value << (op.values[cycles_index] == 0
+                    ? 0.0
+                    : static_cast<double>(op.values[instructions_index]) /
+                          op.values[cycles_index]);
+      row.push_back(value.str());
+      value.str("");
+    }
+    if (has_miss_bytes) {
+      row.push_back(std::to_string(op.values[cache_misses_index] *
+                                   kCacheLineSize / op.count));
+    }
+    if (!counters_.empty()) {
+      value << (first_counter_total == 0
+                    ? 0.0
+                    : 100.0 * op.values[0] / first_counter_total);
+      row.push_back(value.str());
+    }
+    rows.push_back(std::move(row));
+  }
+
+  std::ostringstream stream;
+  if (csv_format) {
+    const auto write_row = [&stream](const std::vector<std::string>& row) {
+      for (size_t i = 0; i < row.size(); ++i) {
+        stream << (i == 0 ? "" : ",") << row[i];
+      }
+      stream << std::endl;
+    };
+    write_row(header);
+    for (const auto& row : rows) write_row(row);
+    return stream.str();
+  }
+
+  std::vector<size_t> widths(header.size());
+  for (size_t i = 0; i < header.size(); ++i) {
+    widths[i] = header[i].size() + 2;
+    for (const auto& row : rows) {
+      widths[i] = std::max(widths[i], row[i].size());
+    }
+  }
+  const auto write_row = [&stream, &widths](
+                             const std::vector<std::string>& row,
+                             bool brackets) {
+    for (size_t i = 0; i < row.size(); ++i) {
+      const std::string cell = brackets ? "[" + row[i] + "]" : row[i];
+      stream << (i == 0 ? std::left : std::right) << std::setw(widths[i])
+             << cell << "  ";
+    }
+    stream << std::endl;
+  };
+  write_row(header, /*brackets=*/true);
+  for (const auto& row : rows) write_row(row, /*brackets=*/false);
+  return stream.str();
+}
+
+}  // namespace profiling
+}  // namespace tflite
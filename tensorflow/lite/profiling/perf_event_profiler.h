@@ -0,0 +1,154 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_PERF_EVENT_PROFILER_H_
+#define TENSORFLOW_LITE_PROFILING_PERF_EVENT_PROFILER_H_
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "tensorflow/lite/core/api/profiler.h"
+
+namespace tflite {
+namespace profiling {
+
+// Attributes hardware performance counters, read with the Linux
+// perf_event_open(2) interface, to the operators of a TFLite interpreter.
+//
+// The counters are read when an OPERATOR_INVOKE_EVENT or a
+// DELEGATE_OPERATOR_INVOKE_EVENT begins and ends, and the difference is
+// accumulated per (subgraph, node). All events, including the operator events,
+// are also forwarded to `wrapped_profiler` (if not null), so this profiler can
+// be installed on top of e.g. a BufferedProfiler.
+//
+// Counters are only collected for the thread which invokes the interpreter:
+// work done by the worker threads of multi-threaded kernels is not counted.
+// This class is not thread safe.
+//
+// On platforms other than Linux, or when perf_event_open(2) is not permitted
+// (see /proc/sys/kernel/perf_event_paranoid), IsAvailable() returns false and
+// no counters are collected.
+class PerfEventProfiler : public tflite::Profiler {
+ public:
+  enum class Counter {
+    // CPU cycles spent in user space.
+    kCpuCycles,
+    // Instructions retired in user space.
+    kInstructions,
+    // Last-level cache misses.
+    kCacheMisses,
+    // Time the thread spent on a CPU, in nanoseconds. This is a software
+    // counter which is available even when the hardware counters are not.
+    kTaskClock,
+  };
+  static constexpr int kMaxNumCounters = 4;
+
+  // CPU cycles, instructions and last-level cache misses.
+  static std::vector<Counter> DefaultCounters();
+
+  // Returns a short name for `counter`, e.g. "cycles".
+  static const char* GetCounterName(Counter counter);
+
+  // Per-operator totals of the counters, in the same order as counters().
+  struct OperatorCounters {
+    std::string tag;
+    EventType event_type;
+    // Index of the node, or of the delegate-internal operator for
+    // DELEGATE_OPERATOR_INVOKE_EVENTs.
+    int64_t node_index;
+    int64_t subgraph_index;
+    // Number of completed invocations.
+    int64_t count = 0;
+    std::array<uint64_t, kMaxNumCounters> values = {};
+  };
+
+  explicit PerfEventProfiler(
+      tflite::Profiler* wrapped_profiler = nullptr,
+      const std::vector<Counter>& counters = DefaultCounters());
+  ~PerfEventProfiler() override;
+
+  PerfEventProfiler(const PerfEventProfiler&) = delete;
+  PerfEventProfiler& operator=(const PerfEventProfiler&) = delete;
+
+  // Returns true if all the requested counters could be opened.
+  bool IsAvailable() const { return group_fd_ >= 0; }
+
+  const std::vector<Counter>& counters() const { return counters_; }
+
+  // Starts or stops collecting counters. Events are forwarded to the wrapped
+  // profiler regardless.
+  void StartProfiling() { enabled_ = true; }
+  void StopProfiling() { enabled_ = false; }
+  // Clears the collected counters.
+  void Reset();
+
+  // Returns the collected counters, ordered by the first invocation of each
+  // operator.
+  const std::vector<OperatorCounters>& GetOperatorCounters() const {
+    return operator_counters_;
+  }
+
+  // Returns a table of the average counters per invocation of each operator,
+  // either human-readable or in CSV format.
+  std::string GetOutputString(bool csv_format) const;
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override;
+  void EndEvent(uint32_t event_handle) override;
+  void EndEvent(uint32_t event_handle, int64_t event_metadata1,
+                int64_t event_metadata2) override;
+  void AddEvent(const char* tag, EventType event_type, uint64_t start,
+                uint64_t end, int64_t event_metadata1,
+                int64_t event_metadata2) override;
+
+ private:
+  // An event which began, but may not have ended yet.
+  struct OpenEvent {
+    uint32_t wrapped_handle;
+    // Index in operator_counters_, or -1 if the event is not counted.
+    int operator_index;
+    bool ended;
+    std::array<uint64_t, kMaxNumCounters> begin_values;
+  };
+
+  // Reads the current values of all counters. Returns false on failure.
+  bool ReadCounters(std::array<uint64_t, kMaxNumCounters>* values) const;
+
+  void EndOpenEvent(uint32_t event_handle);
+
+  tflite::Profiler* const wrapped_profiler_;
+  const std::vector<Counter> counters_;
+  // File descriptors of the counters. The first one is the group leader.
+  std::vector<int> fds_;
+  int group_fd_ = -1;
+  bool enabled_ = false;
+
+  std::vector<OpenEvent> open_events_;
+  std::vector<OperatorCounters> operator_counters_;
+  // Maps (event type, subgraph index, node index, tag) to the index in
+  // operator_counters_. Operator tags are static strings, so comparing
+  // pointers is enough.
+  std::map<std::tuple<int, int64_t, int64_t, const char*>, int>
+      operator_indices_;
+};
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_PERF_EVENT_PROFILER_H_
@@ -0,0 +1,152 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/perf_event_profiler.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/profiling/buffered_profiler.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+using EventType = Profiler::EventType;
+
+// Keeps the CPU busy, so that the task clock of the thread advances.
+void SpinForMilliseconds(int milliseconds) {
+  const auto end = std::chrono::steady_clock::now() +
+                   std::chrono::milliseconds(milliseconds);
+  volatile int counter = 0;
+  while (std::chrono::steady_clock::now() < end) counter = counter + 1;
+}
+
+void InvokeOperator(Profiler* profiler, const char* tag, int node_index,
+                    int subgraph_index) {
+  const uint32_t handle = profiler->BeginEvent(
+      tag, EventType::OPERATOR_INVOKE_EVENT, node_index, subgraph_index);
+  SpinForMilliseconds(2);
+  profiler->EndEvent(handle);
+}
+
+TEST(PerfEventProfilerTest, ForwardsEventsToWrappedProfiler) {
+  BufferedProfiler buffered_profiler(1024);
+  buffered_profiler.StartProfiling();
+  PerfEventProfiler profiler(&buffered_profiler);
+  profiler.StartProfiling();
+
+  const uint32_t invoke =
+      profiler.BeginEvent("Invoke", EventType::DEFAULT, 0, 0);
+  InvokeOperator(&profiler, "ADD", /*node_index=*/3, /*subgraph_index=*/1);
+  profiler.EndEvent(invoke);
+
+  const auto events = buffered_profiler.GetProfileEvents();
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_EQ(events[0]->tag, "Invoke");
+  EXPECT_NE(events[0]->end_timestamp_us, 0);
+  EXPECT_EQ(events[1]->tag, "ADD");
+  EXPECT_EQ(events[1]->event_type, EventType::OPERATOR_INVOKE_EVENT);
+  EXPECT_EQ(events[1]->event_metadata, 3);
+  EXPECT_EQ(events[1]->extra_event_metadata, 1);
+  EXPECT_NE(events[1]->end_timestamp_us, 0);
+}
+
+TEST(PerfEventProfilerTest, AccumulatesCountersPerOperator) {
+  PerfEventProfiler profiler(nullptr,
+                             {PerfEventProfiler::Counter::kTaskClock});
+  if (!profiler.IsAvailable()) {
+    GTEST_SKIP() << "perf_event_open is not available";
+  }
+  profiler.StartProfiling();
+
+  const uint32_t invoke =
+      profiler.BeginEvent("Invoke", EventType::DEFAULT, 0, 0);
+  InvokeOperator(&profiler, "CONV_2D", /*node_index=*/0, /*subgraph_index=*/0);
+  InvokeOperator(&profiler, "ADD", /*node_index=*/1, /*subgraph_index=*/0);
+  profiler.EndEvent(invoke);
+  InvokeOperator(&profiler, "ADD", /*node_index=*/1, /*subgraph_index=*/0);
+
+  const auto& counters = profiler.GetOperatorCounters();
+  ASSERT_EQ(counters.size(), 2);
+  EXPECT_EQ(counters[0].tag, "CONV_2D");
+  EXPECT_EQ(counters[0].node_index, 0);
+  EXPECT_EQ(counters[0].count, 1);
+  EXPECT_GT(counters[0].values[0], 0);
+  EXPECT_EQ(counters[1].tag, "ADD");
+  EXPECT_EQ(counters[1].node_index, 1);
+  EXPECT_EQ(counters[1].count, 2);
+  EXPECT_GT(counters[1].values[0], counters[0].values[0]);
+}
+
+TEST(PerfEventProfilerTest, NoCountersAreCollectedWhenStopped) {
+  PerfEventProfiler profiler(nullptr,
+                             {PerfEventProfiler::Counter::kTaskClock});
+  if (!profiler.IsAvailable()) {
+    GTEST_SKIP() << "perf_event_open is not available";
+  }
+  InvokeOperator(&profiler, "ADD", /*node_index=*/0, /*subgraph_index=*/0);
+  EXPECT_TRUE(profiler.GetOperatorCounters().empty());
+
+  profiler.StartProfiling();
+  InvokeOperator(&profiler, "ADD", /*node_index=*/0, /*subgraph_index=*/0);
+  profiler.StopProfiling();
+  InvokeOperator(&profiler, "ADD", /*node_index=*/0, /*subgraph_index=*/0);
+  ASSERT_EQ(profiler.GetOperatorCounters().size(), 1);
+  EXPECT_EQ(profiler.GetOperatorCounters()[0].count, 1);
+
+  profiler.Reset();
+  EXPECT_TRUE(profiler.GetOperatorCounters().empty());
+}
+
+TEST(PerfEventProfilerTest, OutputString) {
+  PerfEventProfiler profiler(nullptr,
+                             {PerfEventProfiler::Counter::kTaskClock});
+  if (!profiler.IsAvailable()) {
+    GTEST_SKIP() << "perf_event_open is not available";
+  }
+  profiler.StartProfiling();
+  InvokeOperator(&profiler, "CONV_2D", /*node_index=*/0, /*subgraph_index=*/0);
+  InvokeOperator(&profiler, "ADD", /*node_index=*/1, /*subgraph_index=*/0);
+
+  const std::string csv = profiler.GetOutputString(/*csv_format=*/true);
+  EXPECT_THAT(csv, ::testing::StartsWith(
+                       "node type,subgraph,node,count,avg task clock (ns),"
+                       "% task clock (ns)\n"));
+  EXPECT_THAT(csv, ::testing::HasSubstr("\nCONV_2D,0,0,1,"));
+  EXPECT_THAT(csv, ::testing::HasSubstr("\nADD,0,1,1,"));
+
+  const std::string table = profiler.GetOutputString(/*csv_format=*/false);
+  EXPECT_THAT(table, ::testing::HasSubstr("[node type]"));
+  EXPECT_THAT(table, ::testing::HasSubstr("[avg task clock (ns)]"));
+  EXPECT_THAT(table, ::testing::HasSubstr("CONV_2D"));
+}
+
+TEST(PerfEventProfilerTest, UnavailableCountersAreReported) {
+  // More counters than supported can never be opened.
+  PerfEventProfiler profiler(
+      nullptr, std::vector<PerfEventProfiler::Counter>(
+                   PerfEventProfiler::kMaxNumCounters + 1,
+                   PerfEventProfiler::Counter::kTaskClock));
+  EXPECT_FALSE(profiler.IsAvailable());
+  profiler.StartProfiling();
+  InvokeOperator(&profiler, "ADD", /*node_index=*/0, /*subgraph_index=*/0);
+  EXPECT_TRUE(profiler.GetOperatorCounters().empty());
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
@@ -0,0 +1,96 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/shared_model.h"
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/shared_weight_cache.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/prepared_model_cache.h"
+
+namespace tflite {
+
+std::unique_ptr<SharedModel> SharedModel::Create(
+    const FlatBufferModel* model, const OpResolver& op_resolver,
+    const std::string& prepared_cache_path) {
+  if (model == nullptr) {
+    return nullptr;
+  }
+  std::unique_ptr<SharedModel> shared_model(
+      new SharedModel(model, op_resolver));
+  if (!prepared_cache_path.empty()) {
+    shared_model->prepared_cache_ = PreparedModelCache::Load(
+        prepared_cache_path, *model, shared_model->weight_cache_.get());
+  }
+
+  // Preparing a first interpreter validates the model and fills the weight
+  // cache, so that later interpreters only pay for their own activations.
+  std::unique_ptr<Interpreter> interpreter;
+  if (shared_model->NewInterpreter(&interpreter) != kTfLiteOk) {
+    model->error_reporter()->Report(
+        "Failed to prepare the model for sharing between interpreters.");
+    return nullptr;
+  }
+
+  // Kernels only compute the data missing from a loaded cache or failing its
+  // checks, so the file is only written when it was missing, stale,
+  // incomplete or partly invalid.
+  const PreparedModelCache* prepared_cache = shared_model->prepared_cache();
+  if (!prepared_cache_path.empty() &&
+      (prepared_cache == nullptr ||
+       prepared_cache->num_invalid_buffers() > 0 ||
+       shared_model->weight_cache_->num_entries() >
+           prepared_cache->num_buffers())) {
+    PreparedModelCache::Save(prepared_cache_path, *model,
+                             *shared_model->weight_cache_);
+  }
+  return shared_model;
+}
+
+SharedModel::SharedModel(const FlatBufferModel* model,
+                         const OpResolver& op_resolver)
+    : model_(model),
+      op_resolver_(op_resolver),
+      weight_cache_(new SharedWeightCache) {}
+
+SharedModel::~SharedModel() {}
+
+TfLiteStatus SharedModel::NewInterpreter(
+    std::unique_ptr<Interpreter>* interpreter, int num_threads) const {
+  if (InterpreterBuilder(*model_, op_resolver_)(interpreter, num_threads) !=
+      kTfLiteOk) {
+    return kTfLiteError;
+  }
+
+  // All subgraphs of an interpreter use the external contexts of the
+  // interpreter, so this makes the cache visible to every kernel of the model.
+  TfLiteContext* context = (*interpreter)->primary_subgraph().context();
+  CpuBackendContext::GetFromContext(context)->SetSharedWeightCache(
+      weight_cache_.get());
+
+  if ((*interpreter)->AllocateTensors() != kTfLiteOk) {
+    interpreter->reset();
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
@@ -0,0 +1,115 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/// \file
+/// Provides lightweight interpreters that share the weights of one model.
+///
+#ifndef TENSORFLOW_LITE_SHARED_MODEL_H_
+#define TENSORFLOW_LITE_SHARED_MODEL_H_
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/shared_weight_cache.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/prepared_model_cache.h"
+
+namespace tflite {
+
+/// An immutable, prepared model from which any number of interpreters
+/// ("execution contexts") can be created, e.g. one per serving thread.
+///
+/// All interpreters created from a SharedModel reference the same read-only
+/// constant tensors (those live in the FlatBufferModel buffer), and the
+/// builtin kernels reference the same buffers for data they derive from these
+/// constants, such as transposed convolution filters or the row sums of hybrid
+/// kernels. Each interpreter only owns its activation arena and the per-thread
+/// backend state, so it can be invoked concurrently with the others.
+///
+/// Example:
+///
+/// <pre><code>
+/// auto model = tflite::FlatBufferModel::BuildFromFile(filename);
+/// tflite::ops::builtin::BuiltinOpResolver resolver;
+/// auto shared_model = tflite::SharedModel::Create(model.get(), resolver);
+/// // On each serving thread:
+/// std::unique_ptr<tflite::Interpreter> interpreter;
+/// shared_model->NewInterpreter(&interpreter, /*num_threads=*/1);
+/// </code></pre>
+///
+/// Notes:
+///   - `model`, `op_resolver` and the SharedModel itself must outlive every
+///     interpreter created from it.
+///   - The ruy prepacked-weights cache (CpuBackendContext::SetUseCaching)
+///     belongs to the per-interpreter ruy context and is not shared, as it is
+///     not safe to use from concurrent threads.
+///   - Nodes handled by delegates keep whatever per-instance state the
+///     delegate creates.
+///
+/// WARNING: This is an experimental API and subject to change.
+class SharedModel {
+ public:
+  /// Prepares `model` for sharing. Builds and allocates a first interpreter to
+  /// validate the model and compute the shared weight-derived data up front.
+  /// Returns nullptr on failure, after reporting the error to the error
+  /// reporter of `model`.
+  ///
+  /// If `prepared_cache_path` isn't empty, the weight-derived data is mapped
+  /// from that PreparedModelCache file instead of being computed, provided
+  /// the file was written for this model. Otherwise, the file is (re)written
+  /// once the model is prepared, so that the next process starts faster; a
+  /// failure to write it is reported but doesn't fail the creation.
+  static std::unique_ptr<SharedModel> Create(
+      const FlatBufferModel* model, const OpResolver& op_resolver,
+      const std::string& prepared_cache_path = "");
+
+  ~SharedModel();
+  SharedModel(const SharedModel&) = delete;
+  SharedModel& operator=(const SharedModel&) = delete;
+
+  /// Creates a new interpreter for the model whose tensors are already
+  /// allocated. `num_threads` has the same meaning as in InterpreterBuilder.
+  /// Safe to call from several threads at once.
+  TfLiteStatus NewInterpreter(std::unique_ptr<Interpreter>* interpreter,
+                              int num_threads = -1) const;
+
+  /// Returns the cache holding the weight-derived data shared by the
+  /// interpreters.
+  const SharedWeightCache& weight_cache() const { return *weight_cache_; }
+
+  /// Returns the prepared model cache the weight-derived data was loaded
+  /// from, or nullptr if it was computed.
+  const PreparedModelCache* prepared_cache() const {
+    return prepared_cache_.get();
+  }
+
+ private:
+  SharedModel(const FlatBufferModel* model, const OpResolver& op_resolver);
+
+  const FlatBufferModel* model_;
+  const OpResolver& op_resolver_;
+  // Owns the mapped buffers referenced by weight_cache_, so it is destroyed
+  // after it.
+  std::unique_ptr<PreparedModelCache> prepared_cache_;
+  // Kernels receive a mutable pointer, so that they can add entries; the
+  // entries themselves are never modified once created.
+  std::unique_ptr<SharedWeightCache> weight_cache_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_SHARED_MODEL_H_
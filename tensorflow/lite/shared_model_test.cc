@@ -0,0 +1,374 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/shared_model.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/prepared_model_cache.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/testing/util.h"
+#include "tensorflow/lite/version.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kBatches = 2;
+constexpr int kInputSize = 8;
+constexpr int kNumUnits = 4;
+
+// Builds a model with a single hybrid FULLY_CONNECTED operator, i.e. float
+// activations and int8 weights, whose kernel derives row sums from the
+// weights. `weights_multiplier` generates different weights.
+std::vector<char> CreateHybridFullyConnectedModel(int weights_multiplier = 7) {
+  flatbuffers::FlatBufferBuilder builder;
+  const std::array<flatbuffers::Offset<OperatorCode>, 1> operator_codes{
+      {CreateOperatorCode(builder, BuiltinOperator_FULLY_CONNECTED,
+                          /*custom_code=*/0, /*version=*/7)}};
+
+  std::vector<int8_t> weights(kNumUnits * kInputSize);
+  for (int i = 0; i < kNumUnits * kInputSize; ++i) {
+    weights[i] = static_cast<int8_t>(i * weights_multiplier % 255 - 127);
+  }
+  const std::array<flatbuffers::Offset<Buffer>, 2> buffers{{
+      CreateBuffer(builder, builder.CreateVector({})),
+      CreateBuffer(builder, builder.CreateVector(
+                                reinterpret_cast<const uint8_t*>(
+                                    weights.data()),
+                                weights.size())),
+  }};
+
+  const std::array<int32_t, 2> input_shape{{kBatches, kInputSize}};
+  const std::array<int32_t, 2> weights_shape{{kNumUnits, kInputSize}};
+  const std::array<int32_t, 2> output_shape{{kBatches, kNumUnits}};
+  const std::array<flatbuffers::Offset<Tensor>, 3> tensors{{
+      CreateTensor(builder,
+                   builder.CreateVector<int32_t>(input_shape.data(),
+                                                 input_shape.size()),
+                   TensorType_FLOAT32),
+      CreateTensor(
+          builder,
+          builder.CreateVector<int32_t>(weights_shape.data(),
+                                        weights_shape.size()),
+          TensorType_INT8, /*buffer=*/1, /*name=*/0,
+          CreateQuantizationParameters(
+              builder, /*min=*/0, /*max=*/0,
+              builder.CreateVector<float>({0.05f}),
+              builder.CreateVector<int64_t>({0}))),
+      CreateTensor(builder,
+                   builder.CreateVector<int32_t>(output_shape.data(),
+                                                 output_shape.size()),
+                   TensorType_FLOAT32),
+  }};
+
+  const std::array<int32_t, 2> op_inputs{{0, 1}};
+  const std::array<int32_t, 1> op_outputs{{2}};
+  const flatbuffers::Offset<Operator> op = CreateOperator(
+      builder, /*opcode_index=*/0,
+      builder.CreateVector<int32_t>(op_inputs.data(), op_inputs.size()),
+      builder.CreateVector<int32_t>(op_outputs.data(), op_outputs.size()),
+      BuiltinOptions_FullyConnectedOptions,
+      CreateFullyConnectedOptions(builder, ActivationFunctionType_NONE,
+                                  FullyConnectedOptionsWeightsFormat_DEFAULT,
+                                  /*keep_num_dims=*/false,
+                                  /*asymmetric_quantize_inputs=*/true)
+          .Union());
+
+  const std::array<int32_t, 1> subgraph_inputs{{0}};
+  const std::array<int32_t, 1> subgraph_outputs{{2}};
+  const flatbuffers::Offset<SubGraph> subgraph = CreateSubGraph(
+      builder, builder.CreateVector(tensors.data(), tensors.size()),
+      builder.CreateVector<int32_t>(subgraph_inputs.data(),
+                                    subgraph_inputs.size()),
+      builder.CreateVector<int32_t>(subgraph_outputs.data(),
+                                    subgraph_outputs.size()),
+      builder.CreateVector(&op, 1));
+
+  const flatbuffers::Offset<Model> model_buffer = CreateModel(
+      builder, TFLITE_SCHEMA_VERSION,
+      builder.CreateVector(operator_codes.data(), operator_codes.size()),
+      builder.CreateVector(&subgraph, 1),
+      builder.CreateString("Hybrid fully connected model"),
+      builder.CreateVector(buffers.data(), buffers.size()));
+  builder.Finish(model_buffer);
+
+  return std::vector<char>(builder.GetBufferPointer(),
+                           builder.GetBufferPointer() + builder.GetSize());
+}
+
+void FillInput(Interpreter* interpreter, float offset) {
+  float* input = interpreter->typed_input_tensor<float>(0);
+  for (int i = 0; i < kBatches * kInputSize; ++i) {
+    input[i] = offset + 0.25f * (i % 5) - 0.5f;
+  }
+}
+
+std::vector<float> GetOutput(Interpreter* interpreter) {
+  const float* output = interpreter->typed_output_tensor<float>(0);
+  return std::vector<float>(output, output + kBatches * kNumUnits);
+}
+
+class SharedModelTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    buffer_ = CreateHybridFullyConnectedModel();
+    model_ = FlatBufferModel::BuildFromBuffer(buffer_.data(), buffer_.size());
+    ASSERT_NE(model_, nullptr);
+  }
+
+  std::vector<char> buffer_;
+  std::unique_ptr<FlatBufferModel> model_;
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver_;
+};
+
+TEST_F(SharedModelTest, MatchesStandaloneInterpreter) {
+  std::unique_ptr<Interpreter> standalone;
+  ASSERT_EQ(InterpreterBuilder(*model_, resolver_)(&standalone), kTfLiteOk);
+  ASSERT_EQ(standalone->AllocateTensors(), kTfLiteOk);
+  FillInput(standalone.get(), 0.0f);
+  ASSERT_EQ(standalone->Invoke(), kTfLiteOk);
+
+  auto shared_model = SharedModel::Create(model_.get(), resolver_);
+  ASSERT_NE(shared_model, nullptr);
+  std::unique_ptr<Interpreter> interpreter;
+  ASSERT_EQ(shared_model->NewInterpreter(&interpreter), kTfLiteOk);
+  FillInput(interpreter.get(), 0.0f);
+  ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+
+  EXPECT_EQ(GetOutput(interpreter.get()), GetOutput(standalone.get()));
+}
+
+TEST_F(SharedModelTest, InterpretersShareDerivedWeights) {
+  auto shared_model = SharedModel::Create(model_.get(), resolver_);
+  ASSERT_NE(shared_model, nullptr);
+  EXPECT_EQ(shared_model->weight_cache().num_entries(), 1);
+
+  std::unique_ptr<Interpreter> first;
+  std::unique_ptr<Interpreter> second;
+  ASSERT_EQ(shared_model->NewInterpreter(&first), kTfLiteOk);
+  ASSERT_EQ(shared_model->NewInterpreter(&second), kTfLiteOk);
+  EXPECT_EQ(shared_model->weight_cache().num_entries(), 1);
+
+  // Apart from the constant weights, the only read-only tensors are the ones
+  // mapped into the shared cache, and both interpreters must reference the
+  // same buffers.
+  int num_shared_tensors = 0;
+  ASSERT_EQ(first->tensors_size(), second->tensors_size());
+  for (size_t i = 0; i < first->tensors_size(); ++i) {
+    const TfLiteTensor* tensor = first->tensor(i);
+    if (tensor->allocation_type != kTfLiteMmapRo || i == 1) continue;
+    EXPECT_EQ(tensor->data.raw, second->tensor(i)->data.raw);
+    ++num_shared_tensors;
+  }
+  EXPECT_EQ(num_shared_tensors, 1);
+  EXPECT_NE(first->typed_input_tensor<float>(0),
+            second->typed_input_tensor<float>(0));
+}
+
+TEST_F(SharedModelTest, ConcurrentInvocations) {
+  auto shared_model = SharedModel::Create(model_.get(), resolver_);
+  ASSERT_NE(shared_model, nullptr);
+
+  constexpr int kNumInterpreters = 4;
+  std::vector<std::unique_ptr<Interpreter>> interpreters(kNumInterpreters);
+  std::vector<std::vector<float>> expected(kNumInterpreters);
+  for (int i = 0; i < kNumInterpreters; ++i) {
+    std::unique_ptr<Interpreter> standalone;
+    ASSERT_EQ(InterpreterBuilder(*model_, resolver_)(&standalone), kTfLiteOk);
+    ASSERT_EQ(standalone->AllocateTensors(), kTfLiteOk);
+    FillInput(standalone.get(), i);
+    ASSERT_EQ(standalone->Invoke(), kTfLiteOk);
+    expected[i] = GetOutput(standalone.get());
+
+    ASSERT_EQ(shared_model->NewInterpreter(&interpreters[i], 1), kTfLiteOk);
+  }
+
+  std::vector<TfLiteStatus> statuses(kNumInterpreters, kTfLiteError);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumInterpreters; ++i) {
+    threads.emplace_back([&interpreters, &statuses, i]() {
+      Interpreter* interpreter = interpreters[i].get();
+      for (int run = 0; run < 10; ++run) {
+        FillInput(interpreter, i);
+        statuses[i] = interpreter->Invoke();
+        if (statuses[i] != kTfLiteOk) return;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < kNumInterpreters; ++i) {
+    ASSERT_EQ(statuses[i], kTfLiteOk);
+    EXPECT_EQ(GetOutput(interpreters[i].get()), expected[i]);
+  }
+}
+
+class SharedModelPreparedCacheTest : public SharedModelTest {
+ protected:
+  void SetUp() override {
+    SharedModelTest::SetUp();
+    path_ = ::testing::TempDir() + "/shared_model_test.prepared";
+    std::remove(path_.c_str());
+  }
+  void TearDown() override { std::remove(path_.c_str()); }
+
+  bool FileExists() {
+    FILE* file = fopen(path_.c_str(), "rb");
+    if (file == nullptr) return false;
+    fclose(file);
+    return true;
+  }
+
+  std::string path_;
+};
+
+TEST_F(SharedModelPreparedCacheTest, WritesThenLoadsCache) {
+  auto cold = SharedModel::Create(model_.get(), resolver_, path_);
+  ASSERT_NE(cold, nullptr);
+  EXPECT_EQ(cold->prepared_cache(), nullptr);
+  ASSERT_TRUE(FileExists());
+
+  auto warm = SharedModel::Create(model_.get(), resolver_, path_);
+  ASSERT_NE(warm, nullptr);
+  ASSERT_NE(warm->prepared_cache(), nullptr);
+  EXPECT_EQ(warm->prepared_cache()->num_buffers(), 1);
+  EXPECT_EQ(warm->weight_cache().num_entries(), 1);
+
+  std::unique_ptr<Interpreter> cold_interpreter;
+  std::unique_ptr<Interpreter> warm_interpreter;
+  ASSERT_EQ(cold->NewInterpreter(&cold_interpreter), kTfLiteOk);
+  ASSERT_EQ(warm->NewInterpreter(&warm_interpreter), kTfLiteOk);
+  FillInput(cold_interpreter.get(), 1.0f);
+  FillInput(warm_interpreter.get(), 1.0f);
+  ASSERT_EQ(cold_interpreter->Invoke(), kTfLiteOk);
+  ASSERT_EQ(warm_interpreter->Invoke(), kTfLiteOk);
+  EXPECT_EQ(GetOutput(warm_interpreter.get()),
+            GetOutput(cold_interpreter.get()));
+}
+
+TEST_F(SharedModelPreparedCacheTest, IgnoresCacheOfAnotherModel) {
+  ASSERT_NE(SharedModel::Create(model_.get(), resolver_, path_), nullptr);
+  const std::vector<char> other_buffer =
+      CreateHybridFullyConnectedModel(/*weights_multiplier=*/3);
+  auto other_model =
+      FlatBufferModel::BuildFromBuffer(other_buffer.data(), other_buffer.size());
+  ASSERT_NE(other_model, nullptr);
+  EXPECT_NE(PreparedModelCache::ModelFingerprint(*other_model),
+            PreparedModelCache::ModelFingerprint(*model_));
+
+  auto other = SharedModel::Create(other_model.get(), resolver_, path_);
+  ASSERT_NE(other, nullptr);
+  EXPECT_EQ(other->prepared_cache(), nullptr);
+
+  // The file now belongs to the other model.
+  auto reloaded = SharedModel::Create(other_model.get(), resolver_, path_);
+  ASSERT_NE(reloaded, nullptr);
+  EXPECT_NE(reloaded->prepared_cache(), nullptr);
+}
+
+TEST_F(SharedModelPreparedCacheTest, IgnoresCorruptedCache) {
+  FILE* file = fopen(path_.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  const char garbage[] = "TFLPREP but not really a prepared model cache";
+  fwrite(garbage, 1, sizeof(garbage), file);
+  fclose(file);
+
+  auto shared_model = SharedModel::Create(model_.get(), resolver_, path_);
+  ASSERT_NE(shared_model, nullptr);
+  EXPECT_EQ(shared_model->prepared_cache(), nullptr);
+  EXPECT_EQ(shared_model->weight_cache().num_entries(), 1);
+}
+
+TEST_F(SharedModelPreparedCacheTest, IgnoresCacheOfAnotherBuild) {
+  ASSERT_NE(SharedModel::Create(model_.get(), resolver_, path_), nullptr);
+
+  // Change the first byte of the TensorFlow Lite version in the header, which
+  // follows the magic, the format version and the byte order mark.
+  FILE* file = fopen(path_.c_str(), "r+b");
+  ASSERT_NE(file, nullptr);
+  ASSERT_EQ(fseek(file, 16, SEEK_SET), 0);
+  ASSERT_NE(fputc('x', file), EOF);
+  ASSERT_EQ(fclose(file), 0);
+
+  auto shared_model = SharedModel::Create(model_.get(), resolver_, path_);
+  ASSERT_NE(shared_model, nullptr);
+  EXPECT_EQ(shared_model->prepared_cache(), nullptr);
+  EXPECT_EQ(shared_model->weight_cache().num_entries(), 1);
+}
+
+TEST_F(SharedModelPreparedCacheTest, RecomputesBufferWithFingerprintMismatch) {
+  auto cold = SharedModel::Create(model_.get(), resolver_, path_);
+  ASSERT_NE(cold, nullptr);
+
+  // Flip the bits of the last byte of the file, which belongs to a buffer.
+  FILE* file = fopen(path_.c_str(), "r+b");
+  ASSERT_NE(file, nullptr);
+  ASSERT_EQ(fseek(file, -1, SEEK_END), 0);
+  const int byte = fgetc(file);
+  ASSERT_NE(byte, EOF);
+  ASSERT_EQ(fseek(file, -1, SEEK_END), 0);
+  ASSERT_NE(fputc(byte ^ 0xFF, file), EOF);
+  ASSERT_EQ(fclose(file), 0);
+
+  // The buffer is only checked, and computed again, when first requested.
+  auto shared_model = SharedModel::Create(model_.get(), resolver_, path_);
+  ASSERT_NE(shared_model, nullptr);
+  ASSERT_NE(shared_model->prepared_cache(), nullptr);
+  EXPECT_EQ(shared_model->prepared_cache()->num_buffers(), 1);
+  EXPECT_EQ(shared_model->prepared_cache()->num_invalid_buffers(), 1);
+  EXPECT_EQ(shared_model->weight_cache().num_entries(), 1);
+
+  std::unique_ptr<Interpreter> cold_interpreter;
+  std::unique_ptr<Interpreter> interpreter;
+  ASSERT_EQ(cold->NewInterpreter(&cold_interpreter), kTfLiteOk);
+  ASSERT_EQ(shared_model->NewInterpreter(&interpreter), kTfLiteOk);
+  FillInput(cold_interpreter.get(), 1.0f);
+  FillInput(interpreter.get(), 1.0f);
+  ASSERT_EQ(cold_interpreter->Invoke(), kTfLiteOk);
+  ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+  EXPECT_EQ(GetOutput(interpreter.get()), GetOutput(cold_interpreter.get()));
+
+  // The file was written again with the recomputed buffer.
+  auto reloaded = SharedModel::Create(model_.get(), resolver_, path_);
+  ASSERT_NE(reloaded, nullptr);
+  ASSERT_NE(reloaded->prepared_cache(), nullptr);
+  EXPECT_EQ(reloaded->prepared_cache()->num_invalid_buffers(), 0);
+}
+
+TEST_F(SharedModelTest, NullModel) {
+  EXPECT_EQ(SharedModel::Create(nullptr, resolver_), nullptr);
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
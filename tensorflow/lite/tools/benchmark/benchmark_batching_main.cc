@@ -0,0 +1,228 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures the latency/throughput curve of serving single-example requests
+// through a tflite::batching::BatchingInterpreter. The number of concurrent
+// clients, each issuing blocking requests back to back, is doubled from 1 up
+// to --max_clients, and one line is printed per load level.
+//
+// Example:
+//   benchmark_batching --graph=/data/local/tmp/model.tflite
+//       --allowed_batch_sizes=1,2,4,8,16 --batch_timeout_us=2000
+//       --max_clients=64 --num_requests_per_client=100
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/experimental/batching/batching_interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/profiling/time.h"
+#include "tensorflow/lite/shared_model.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+#include "tensorflow/lite/tools/logging.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+struct Options {
+  std::string graph;
+  std::string allowed_batch_sizes = "1,2,4,8,16,32";
+  int32_t batch_timeout_us = 1000;
+  int32_t num_batch_threads = 1;
+  int32_t num_threads = 1;
+  int32_t max_clients = 32;
+  int32_t num_requests_per_client = 50;
+};
+
+bool ParseBatchSizes(const std::string& list, std::vector<int>* sizes) {
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    const int size = std::atoi(item.c_str());
+    if (size <= 0) return false;
+    sizes->push_back(size);
+  }
+  return !sizes->empty();
+}
+
+// Returns the given percentile of the sorted `values`.
+int64_t Percentile(const std::vector<int64_t>& values, double percentile) {
+  const size_t index = std::min(
+      values.size() - 1, static_cast<size_t>(percentile / 100 * values.size()));
+  return values[index];
+}
+
+// A single example of every input and output, owned by one client.
+struct ClientBuffers {
+  std::vector<std::vector<char>> inputs;
+  std::vector<std::vector<char>> outputs;
+  std::vector<const void*> input_ptrs;
+  std::vector<void*> output_ptrs;
+};
+
+ClientBuffers CreateClientBuffers(
+    const batching::BatchingInterpreter& batching_interpreter, int seed) {
+  ClientBuffers buffers;
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> distribution(0, 63);
+  for (int i = 0; i < batching_interpreter.num_inputs(); ++i) {
+    // Small non-negative bytes are valid finite values for all numeric types.
+    std::vector<char> input(batching_interpreter.input_bytes_per_example(i));
+    for (char& byte : input) byte = static_cast<char>(distribution(rng));
+    buffers.inputs.push_back(std::move(input));
+  }
+  for (int i = 0; i < batching_interpreter.num_outputs(); ++i) {
+    buffers.outputs.emplace_back(
+        batching_interpreter.output_bytes_per_example(i));
+  }
+  for (auto& input : buffers.inputs) buffers.input_ptrs.push_back(input.data());
+  for (auto& output : buffers.outputs) {
+    buffers.output_ptrs.push_back(output.data());
+  }
+  return buffers;
+}
+
+int Run(const Options& options) {
+  auto model = FlatBufferModel::BuildFromFile(options.graph.c_str());
+  if (!model) {
+    TFLITE_LOG(ERROR) << "Failed to load model " << options.graph;
+    return EXIT_FAILURE;
+  }
+  ops::builtin::BuiltinOpResolver resolver;
+  auto shared_model = SharedModel::Create(model.get(), resolver);
+  if (!shared_model) {
+    TFLITE_LOG(ERROR) << "Failed to create the shared model.";
+    return EXIT_FAILURE;
+  }
+
+  batching::BatchingOptions batching_options;
+  batching_options.allowed_batch_sizes.clear();
+  if (!ParseBatchSizes(options.allowed_batch_sizes,
+                       &batching_options.allowed_batch_sizes)) {
+    TFLITE_LOG(ERROR) << "Invalid --allowed_batch_sizes: "
+                      << options.allowed_batch_sizes;
+    return EXIT_FAILURE;
+  }
+  batching_options.batch_timeout_micros = options.batch_timeout_us;
+  batching_options.num_batch_threads = options.num_batch_threads;
+  batching_options.num_threads_per_interpreter = options.num_threads;
+  // Every client has at most one request in flight, so the queue never has to
+  // reject any.
+  batching_options.max_enqueued_batches =
+      options.max_clients / batching_options.allowed_batch_sizes.back() + 1;
+  auto batching_interpreter =
+      batching::BatchingInterpreter::Create(shared_model.get(),
+                                            batching_options);
+  if (!batching_interpreter) {
+    TFLITE_LOG(ERROR) << "Failed to create the batching interpreter.";
+    return EXIT_FAILURE;
+  }
+
+  TFLITE_LOG(INFO) << "Allowed batch sizes: " << options.allowed_batch_sizes
+                   << ", batch timeout (us): " << options.batch_timeout_us
+                   << ", batch threads: " << options.num_batch_threads;
+  for (int num_clients = 1; num_clients <= options.max_clients;
+       num_clients *= 2) {
+    std::vector<std::vector<int64_t>> latencies(num_clients);
+    std::vector<TfLiteStatus> statuses(num_clients, kTfLiteOk);
+    std::vector<std::thread> clients;
+    const uint64_t start_us = profiling::time::NowMicros();
+    for (int c = 0; c < num_clients; ++c) {
+      clients.emplace_back([&, c]() {
+        ClientBuffers buffers = CreateClientBuffers(*batching_interpreter, c);
+        for (int r = 0; r < options.num_requests_per_client; ++r) {
+          const uint64_t request_start_us = profiling::time::NowMicros();
+          statuses[c] = batching_interpreter->Invoke(buffers.input_ptrs,
+                                                     buffers.output_ptrs);
+          if (statuses[c] != kTfLiteOk) return;
+          latencies[c].push_back(profiling::time::NowMicros() -
+                                 request_start_us);
+        }
+      });
+    }
+    for (auto& client : clients) {
+      client.join();
+    }
+    const uint64_t elapsed_us = profiling::time::NowMicros() - start_us;
+    if (std::count(statuses.begin(), statuses.end(), kTfLiteOk) !=
+        num_clients) {
+      TFLITE_LOG(ERROR) << "Failed to run a request with " << num_clients
+                        << " clients.";
+      return EXIT_FAILURE;
+    }
+
+    std::vector<int64_t> all_latencies;
+    for (const auto& client_latencies : latencies) {
+      all_latencies.insert(all_latencies.end(), client_latencies.begin(),
+                           client_latencies.end());
+    }
+    std::sort(all_latencies.begin(), all_latencies.end());
+    TFLITE_LOG(INFO) << "Clients: " << num_clients
+                     << ", throughput (requests/s): "
+                     << all_latencies.size() * 1e6 / elapsed_us
+                     << ", latency (us): p50=" << Percentile(all_latencies, 50)
+                     << " p90=" << Percentile(all_latencies, 90)
+                     << " p99=" << Percentile(all_latencies, 99);
+  }
+  return EXIT_SUCCESS;
+}
+
+}  // namespace
+
+int Main(int argc, char** argv) {
+  Options options;
+  std::vector<Flag> flags = {
+      Flag::CreateFlag("graph", &options.graph, "path to the .tflite model",
+                       Flag::kRequired),
+      Flag::CreateFlag("allowed_batch_sizes", &options.allowed_batch_sizes,
+                       "comma-separated, increasing batch sizes the model is "
+                       "run with"),
+      Flag::CreateFlag("batch_timeout_us", &options.batch_timeout_us,
+                       "maximum time a request waits for its batch to fill"),
+      Flag::CreateFlag("num_batch_threads", &options.num_batch_threads,
+                       "number of threads running batches concurrently"),
+      Flag::CreateFlag("num_threads", &options.num_threads,
+                       "number of threads used by each batch invocation"),
+      Flag::CreateFlag("max_clients", &options.max_clients,
+                       "the largest number of concurrent clients measured"),
+      Flag::CreateFlag("num_requests_per_client",
+                       &options.num_requests_per_client,
+                       "number of requests issued by each client"),
+  };
+  const bool parse_result =
+      Flags::Parse(&argc, const_cast<const char**>(argv), flags);
+  if (!parse_result || options.max_clients <= 0 ||
+      options.num_requests_per_client <= 0) {
+    TFLITE_LOG(ERROR) << Flags::Usage(argv[0], flags);
+    return EXIT_FAILURE;
+  }
+  return Run(options);
+}
+
+}  // namespace benchmark
+}  // namespace tflite
+
+int main(int argc, char** argv) { return tflite::benchmark::Main(argc, argv); }
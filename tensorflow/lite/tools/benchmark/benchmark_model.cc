@@ -209,11 +209,20 @@ TfLiteStatus BenchmarkModel::Run() {
     return status;
   }
 
+  const auto inference_start_mem_usage = profiling::memory::GetMemoryUsage();
   Stat<int64_t> inference_time_us =
       Run(params_.Get<int32_t>("num_runs"), params_.Get<float>("min_secs"),
           params_.Get<float>("max_secs"), REGULAR, &status);
-  const auto overall_mem_usage =
-      profiling::memory::GetMemoryUsage() - start_mem_usage;
+  const auto inference_end_mem_usage = profiling::memory::GetMemoryUsage();
+  const auto overall_mem_usage = inference_end_mem_usage - start_mem_usage;
+  if (profiling::memory::MemoryUsage::IsHeapAllocationCountSupported() &&
+      inference_time_us.count() > 0) {
+    TFLITE_LOG(INFO) << "Heap allocations per inference: "
+                     << static_cast<double>(
+                            inference_end_mem_usage.num_heap_allocations -
+                            inference_start_mem_usage.num_heap_allocations) /
+                            inference_time_us.count();
+  }
 
   listeners_.OnBenchmarkEnd({model_size_mb, startup_latency_us, input_bytes,
                              warmup_time_us, inference_time_us, init_mem_usage,
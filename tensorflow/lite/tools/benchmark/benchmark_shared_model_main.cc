@@ -0,0 +1,242 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures the throughput and memory footprint of serving one model from
+// several concurrently invoked interpreters, either sharing the weights and
+// the data derived from them through a tflite::SharedModel
+// (--share_weights=true) or as fully independent interpreters
+// (--share_weights=false).
+//
+// Example:
+//   benchmark_shared_model --graph=/data/local/tmp/model.tflite \
+//       --num_interpreters=32 --num_threads=1 --num_runs=100
+//
+// With --use_prepared_cache=true, the shared model maps the weight-derived
+// data from a PreparedModelCache file next to the model, writing the file if
+// needed. Running the benchmark twice compares the cold and warm start-up
+// latencies.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/prepared_model_cache.h"
+#include "tensorflow/lite/profiling/memory_info.h"
+#include "tensorflow/lite/profiling/time.h"
+#include "tensorflow/lite/shared_model.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+#include "tensorflow/lite/tools/logging.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+struct Options {
+  std::string graph;
+  int32_t num_interpreters = 4;
+  int32_t num_threads = 1;
+  int32_t num_runs = 50;
+  bool share_weights = true;
+  bool use_prepared_cache = false;
+};
+
+// Fills the float inputs with random values and all other inputs with zeros.
+void FillInputs(Interpreter* interpreter, int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  for (int input : interpreter->inputs()) {
+    TfLiteTensor* tensor = interpreter->tensor(input);
+    if (tensor->type == kTfLiteFloat32) {
+      const size_t num_elements = tensor->bytes / sizeof(float);
+      for (size_t i = 0; i < num_elements; ++i) {
+        tensor->data.f[i] = distribution(rng);
+      }
+    } else if (tensor->type != kTfLiteString) {
+      std::fill_n(tensor->data.raw, tensor->bytes, 0);
+    }
+  }
+}
+
+int Run(const Options& options) {
+  auto model = FlatBufferModel::BuildFromFile(options.graph.c_str());
+  if (!model) {
+    TFLITE_LOG(ERROR) << "Failed to load model " << options.graph;
+    return EXIT_FAILURE;
+  }
+  ops::builtin::BuiltinOpResolver resolver;
+
+  const auto start_mem_usage = profiling::memory::GetMemoryUsage();
+  const uint64_t init_start_us = profiling::time::NowMicros();
+
+  std::unique_ptr<SharedModel> shared_model;
+  uint64_t prepare_us = 0;
+  if (options.share_weights) {
+    shared_model = SharedModel::Create(
+        model.get(), resolver,
+        options.use_prepared_cache
+            ? PreparedModelCache::DefaultPath(options.graph)
+            : "");
+    if (!shared_model) {
+      TFLITE_LOG(ERROR) << "Failed to create the shared model.";
+      return EXIT_FAILURE;
+    }
+    prepare_us = profiling::time::NowMicros() - init_start_us;
+  }
+
+  std::vector<std::unique_ptr<Interpreter>> interpreters(
+      options.num_interpreters);
+  for (auto& interpreter : interpreters) {
+    TfLiteStatus status;
+    if (shared_model) {
+      status = shared_model->NewInterpreter(&interpreter, options.num_threads);
+    } else {
+      InterpreterBuilder builder(*model, resolver);
+      status = builder(&interpreter, options.num_threads);
+      if (status == kTfLiteOk) status = interpreter->AllocateTensors();
+    }
+    if (status != kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Failed to create an interpreter.";
+      return EXIT_FAILURE;
+    }
+  }
+
+  const uint64_t init_us = profiling::time::NowMicros() - init_start_us;
+  const auto init_mem_usage =
+      profiling::memory::GetMemoryUsage() - start_mem_usage;
+
+  for (int i = 0; i < options.num_interpreters; ++i) {
+    FillInputs(interpreters[i].get(), i);
+    // Warm up once, which also triggers any lazily computed weight data.
+    if (interpreters[i]->Invoke() != kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Failed to invoke interpreter " << i;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<TfLiteStatus> statuses(options.num_interpreters, kTfLiteOk);
+  std::vector<std::thread> threads;
+  const uint64_t run_start_us = profiling::time::NowMicros();
+  for (int i = 0; i < options.num_interpreters; ++i) {
+    threads.emplace_back([&interpreters, &statuses, &options, i]() {
+      for (int run = 0; run < options.num_runs; ++run) {
+        statuses[i] = interpreters[i]->Invoke();
+        if (statuses[i] != kTfLiteOk) return;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const uint64_t run_us = profiling::time::NowMicros() - run_start_us;
+  const auto overall_mem_usage =
+      profiling::memory::GetMemoryUsage() - start_mem_usage;
+
+  for (int i = 0; i < options.num_interpreters; ++i) {
+    if (statuses[i] != kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Failed to invoke interpreter " << i;
+      return EXIT_FAILURE;
+    }
+  }
+
+  const int64_t total_runs =
+      static_cast<int64_t>(options.num_interpreters) * options.num_runs;
+  TFLITE_LOG(INFO) << "Interpreters: " << options.num_interpreters
+                   << ", threads per interpreter: " << options.num_threads
+                   << ", shared weights: "
+                   << (options.share_weights ? "yes" : "no");
+  TFLITE_LOG(INFO) << "Init (us): " << init_us;
+  if (shared_model) {
+    TFLITE_LOG(INFO) << "Shared model preparation (us): " << prepare_us;
+  }
+  if (options.use_prepared_cache && shared_model) {
+    const PreparedModelCache* prepared_cache = shared_model->prepared_cache();
+    if (prepared_cache != nullptr) {
+      TFLITE_LOG(INFO) << "Prepared model cache: loaded "
+                       << prepared_cache->num_buffers() << " buffers, "
+                       << prepared_cache->num_invalid_buffers()
+                       << " of which were invalid";
+    } else {
+      TFLITE_LOG(INFO) << "Prepared model cache: written to "
+                       << PreparedModelCache::DefaultPath(options.graph);
+    }
+  }
+  TFLITE_LOG(INFO) << "Throughput (inferences/s): "
+                   << total_runs * 1e6 / run_us;
+  TFLITE_LOG(INFO) << "Latency (avg us): "
+                   << static_cast<double>(run_us) * options.num_interpreters /
+                          total_runs;
+  if (shared_model) {
+    TFLITE_LOG(INFO) << "Shared weight cache: "
+                     << shared_model->weight_cache().num_entries()
+                     << " buffers, "
+                     << shared_model->weight_cache().size_in_bytes() / 1024.0
+                     << " KB";
+  }
+  if (profiling::memory::MemoryUsage::IsSupported()) {
+    TFLITE_LOG(INFO) << "Memory (MB): init="
+                     << init_mem_usage.max_rss_kb / 1024.0
+                     << " overall=" << overall_mem_usage.max_rss_kb / 1024.0
+                     << " heap in use after init="
+                     << init_mem_usage.in_use_allocated_bytes / 1048576.0;
+  }
+  return EXIT_SUCCESS;
+}
+
+}  // namespace
+
+int Main(int argc, char** argv) {
+  Options options;
+  std::vector<Flag> flags = {
+      Flag::CreateFlag("graph", &options.graph, "path to the .tflite model",
+                       Flag::kRequired),
+      Flag::CreateFlag("num_interpreters", &options.num_interpreters,
+                       "number of interpreters invoked concurrently, each on "
+                       "its own thread"),
+      Flag::CreateFlag("num_threads", &options.num_threads,
+                       "number of threads used by each interpreter"),
+      Flag::CreateFlag("num_runs", &options.num_runs,
+                       "number of invocations of each interpreter"),
+      Flag::CreateFlag("share_weights", &options.share_weights,
+                       "create the interpreters from one tflite::SharedModel "
+                       "instead of independently"),
+      Flag::CreateFlag("use_prepared_cache", &options.use_prepared_cache,
+                       "load the weight-derived data of the shared model from "
+                       "<graph>.<arch>.prepared, writing that file if it is "
+                       "missing or stale"),
+  };
+  const bool parse_result =
+      Flags::Parse(&argc, const_cast<const char**>(argv), flags);
+  if (!parse_result || options.num_interpreters <= 0 ||
+      options.num_runs <= 0) {
+    TFLITE_LOG(ERROR) << Flags::Usage(argv[0], flags);
+    return EXIT_FAILURE;
+  }
+  return Run(options);
+}
+
+}  // namespace benchmark
+}  // namespace tflite
+
+int main(int argc, char** argv) { return tflite::benchmark::Main(argc, argv); }
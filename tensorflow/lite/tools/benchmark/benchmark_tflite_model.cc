@@ -20,6 +20,7 @@ limitations under the License.
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <random>
 #include <string>
@@ -40,6 +41,7 @@ limitations under the License.
 #include "tensorflow/lite/tools/benchmark/profiling_listener.h"
 #include "tensorflow/lite/tools/delegates/delegate_provider.h"
 #include "tensorflow/lite/tools/logging.h"
+#include "tensorflow/lite/util.h"
 
 void RegisterSelectedOps(::tflite::MutableOpResolver* resolver);
 
@@ -247,6 +249,8 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
   default_params.AddParam("allow_fp16", BenchmarkParam::Create<bool>(false));
   default_params.AddParam("require_full_delegation",
                           BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("fuse_operators",
+                          BenchmarkParam::Create<bool>(false));
   default_params.AddParam(
       "enable_op_profiling",
       BenchmarkParam::Create<bool>(kOpProfilingEnabledDefault));
@@ -254,6 +258,8 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<int32_t>(1024));
   default_params.AddParam("profiling_output_csv_file",
                           BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("enable_perf_event_profiling",
+                          BenchmarkParam::Create<bool>(false));
 
   for (const auto& delegate_provider :
        tools::GetRegisteredDelegateProviders()) {
@@ -308,13 +314,21 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
       CreateFlag<bool>("allow_fp16", &params_, "allow fp16"),
       CreateFlag<bool>("require_full_delegation", &params_,
                        "require delegate to run the entire graph"),
+      CreateFlag<bool>("fuse_operators", &params_,
+                       "fuse operators and remove no-op nodes of the graph "
+                       "when building the interpreter"),
       CreateFlag<bool>("enable_op_profiling", &params_, "enable op profiling"),
       CreateFlag<int32_t>("max_profiling_buffer_entries", &params_,
                           "max profiling buffer entries"),
       CreateFlag<std::string>(
           "profiling_output_csv_file", &params_,
           "File path to export profile data as CSV, if not set "
-          "prints to stdout.")};
+          "prints to stdout."),
+      CreateFlag<bool>(
+          "enable_perf_event_profiling", &params_,
+          "collect per-op CPU cycles, instructions and last-level cache "
+          "misses with perf_event_open (Linux only), implies "
+          "--enable_op_profiling")};
 
   flags.insert(flags.end(), specific_flags.begin(), specific_flags.end());
 
@@ -343,12 +357,15 @@ void BenchmarkTfLiteModel::LogParams() {
   LOG_BENCHMARK_PARAM(bool, "allow_fp16", "Allow fp16", verbose);
   LOG_BENCHMARK_PARAM(bool, "require_full_delegation",
                       "Require full delegation", verbose);
+  LOG_BENCHMARK_PARAM(bool, "fuse_operators", "Fuse operators", verbose);
   LOG_BENCHMARK_PARAM(bool, "enable_op_profiling", "Enable op profiling",
                       verbose);
   LOG_BENCHMARK_PARAM(int32_t, "max_profiling_buffer_entries",
                       "Max profiling buffer entries", verbose);
   LOG_BENCHMARK_PARAM(std::string, "profiling_output_csv_file",
                       "CSV File to export profiling data to", verbose);
+  LOG_BENCHMARK_PARAM(bool, "enable_perf_event_profiling",
+                      "Enable perf event profiling", verbose);
 
   for (const auto& delegate_provider :
        tools::GetRegisteredDelegateProviders()) {
@@ -576,7 +593,9 @@ TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
   auto resolver = GetOpResolver();
   const int32_t num_threads = params_.Get<int32_t>("num_threads");
   const bool use_caching = params_.Get<bool>("use_caching");
-  tflite::InterpreterBuilder(*model_, *resolver)(&interpreter_, num_threads);
+  tflite::InterpreterBuilder builder(*model_, *resolver);
+  builder.SetFuseOperators(params_.Get<bool>("fuse_operators"));
+  builder(&interpreter_, num_threads);
   if (!interpreter_) {
     TFLITE_LOG(ERROR) << "Failed to initialize the interpreter";
     return kTfLiteError;
@@ -616,6 +635,7 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
     // It's possible that a delegate of certain type won't be created as
     // user-specified benchmark params tells not to.
     if (delegate == nullptr) continue;
+    const int num_nodes_before = interpreter_->execution_plan().size();
     if (interpreter_->ModifyGraphWithDelegate(delegate.get()) != kTfLiteOk) {
       TFLITE_LOG(ERROR) << "Failed to apply " << delegate_provider->GetName()
                         << " delegate.";
@@ -624,14 +644,21 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
       // Ideally, such delegate info should already be computed when the
       // delegate is being applied to the model graph.
       int num_delegated_kernels = 0;
+      // Operators left outside of this delegate, and how often they occur.
+      std::map<std::string, int> remaining_ops;
       for (int i = 0; i < interpreter_->execution_plan().size(); ++i) {
         int node_id = interpreter_->execution_plan()[i];
-        const TfLiteNode& node =
-            interpreter_->node_and_registration(node_id)->first;
-        if (delegate.get() == node.delegate) {
+        const auto* node_and_registration =
+            interpreter_->node_and_registration(node_id);
+        if (delegate.get() == node_and_registration->first.delegate) {
           num_delegated_kernels++;
+        } else {
+          remaining_ops[GetOpNameByRegistration(
+              node_and_registration->second)]++;
         }
       }
+      const int num_remaining_nodes =
+          interpreter_->execution_plan().size() - num_delegated_kernels;
       bool fully_delegated = (num_delegated_kernels == 1 &&
                               interpreter_->execution_plan().size() == 1);
 
@@ -650,6 +677,18 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
                          << " delegate, and the model graph will be partially"
                          << " executed by the delegate w/ "
                          << num_delegated_kernels << " delegate kernels.";
+        std::string remaining_ops_summary;
+        for (const auto& op : remaining_ops) {
+          if (!remaining_ops_summary.empty()) remaining_ops_summary += ", ";
+          remaining_ops_summary +=
+              op.first + " (" + std::to_string(op.second) + ")";
+        }
+        TFLITE_LOG(INFO) << "The delegate kernels replace "
+                         << num_nodes_before - num_remaining_nodes << " of "
+                         << num_nodes_before << " nodes. "
+                         << num_remaining_nodes
+                         << " nodes are executed outside of the delegate: "
+                         << remaining_ops_summary;
       } else {
         TFLITE_LOG(INFO)
             << "Though " << delegate_provider->GetName()
@@ -722,13 +761,19 @@ std::unique_ptr<tflite::OpResolver> BenchmarkTfLiteModel::GetOpResolver()
 
 std::unique_ptr<BenchmarkListener>
 BenchmarkTfLiteModel::MayCreateProfilingListener() const {
-  if (!params_.Get<bool>("enable_op_profiling")) return nullptr;
+  const bool enable_perf_event_profiling =
+      params_.Get<bool>("enable_perf_event_profiling");
+  if (!params_.Get<bool>("enable_op_profiling") &&
+      !enable_perf_event_profiling) {
+    return nullptr;
+  }
 
   return std::unique_ptr<BenchmarkListener>(new ProfilingListener(
       interpreter_.get(), params_.Get<int32_t>("max_profiling_buffer_entries"),
       params_.Get<std::string>("profiling_output_csv_file"),
       CreateProfileSummaryFormatter(
-          !params_.Get<std::string>("profiling_output_csv_file").empty())));
+          !params_.Get<std::string>("profiling_output_csv_file").empty()),
+      enable_perf_event_profiling));
 }
 
 TfLiteStatus BenchmarkTfLiteModel::RunImpl() { return interpreter_->Invoke(); }
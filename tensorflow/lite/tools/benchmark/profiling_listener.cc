@@ -25,14 +25,28 @@ namespace benchmark {
 ProfilingListener::ProfilingListener(
     Interpreter* interpreter, uint32_t max_num_entries,
     const std::string& csv_file_path,
-    std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter)
+    std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter,
+    bool enable_perf_event_profiling)
     : run_summarizer_(summarizer_formatter),
       init_summarizer_(summarizer_formatter),
       csv_file_path_(csv_file_path),
       interpreter_(interpreter),
       profiler_(max_num_entries) {
   TFLITE_TOOLS_CHECK(interpreter);
-  interpreter_->SetProfiler(&profiler_);
+  if (enable_perf_event_profiling) {
+    perf_event_profiler_.reset(new profiling::PerfEventProfiler(&profiler_));
+    if (!perf_event_profiler_->IsAvailable()) {
+      TFLITE_LOG(WARN) << "Hardware performance counters are not available, "
+                          "check /proc/sys/kernel/perf_event_paranoid. Perf "
+                          "event profiling is disabled.";
+      perf_event_profiler_.reset();
+    }
+  }
+  if (perf_event_profiler_) {
+    interpreter_->SetProfiler(perf_event_profiler_.get());
+  } else {
+    interpreter_->SetProfiler(&profiler_);
+  }
 
   // We start profiling here in order to catch events that are recorded during
   // the benchmark run preparation stage where TFLite interpreter is
@@ -49,17 +63,28 @@ void ProfilingListener::OnBenchmarkStart(const BenchmarkParams& params) {
   auto profile_events = profiler_.GetProfileEvents();
   init_summarizer_.ProcessProfiles(profile_events, *interpreter_);
   profiler_.Reset();
+
+  if (perf_event_profiler_) {
+    perf_event_profiler_->Reset();
+    if (params.Get<int32_t>("num_threads") != 1) {
+      TFLITE_LOG(WARN) << "Hardware counters only cover the thread invoking "
+                          "the interpreter, use --num_threads=1 to count all "
+                          "the work of the operators.";
+    }
+  }
 }
 
 void ProfilingListener::OnSingleRunStart(RunType run_type) {
   if (run_type == REGULAR) {
     profiler_.Reset();
     profiler_.StartProfiling();
+    if (perf_event_profiler_) perf_event_profiler_->StartProfiling();
   }
 }
 
 void ProfilingListener::OnSingleRunEnd() {
   profiler_.StopProfiling();
+  if (perf_event_profiler_) perf_event_profiler_->StopProfiling();
   auto profile_events = profiler_.GetProfileEvents();
   run_summarizer_.ProcessProfiles(profile_events, *interpreter_);
 }
@@ -80,6 +105,13 @@ void ProfilingListener::OnBenchmarkEnd(const BenchmarkResults& results) {
                 run_summarizer_.GetOutputString(),
                 output_stream == nullptr ? &TFLITE_LOG(INFO) : output_stream);
   }
+  if (perf_event_profiler_ &&
+      !perf_event_profiler_->GetOperatorCounters().empty()) {
+    WriteOutput("Hardware Counters per Operator for Regular Benchmark Runs:",
+                perf_event_profiler_->GetOutputString(
+                    /*csv_format=*/!csv_file_path_.empty()),
+                output_stream == nullptr ? &TFLITE_LOG(INFO) : output_stream);
+  }
 }
 
 void ProfilingListener::WriteOutput(const std::string& header,
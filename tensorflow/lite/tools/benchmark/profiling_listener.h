@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 
 #include "tensorflow/lite/profiling/buffered_profiler.h"
+#include "tensorflow/lite/profiling/perf_event_profiler.h"
 #include "tensorflow/lite/profiling/profile_summarizer.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_model.h"
@@ -27,13 +28,16 @@ namespace tflite {
 namespace benchmark {
 
 // Dumps profiling events if profiling is enabled.
+// If `enable_perf_event_profiling` is true, the hardware counters of every
+// operator are also collected during the regular runs, see PerfEventProfiler.
 class ProfilingListener : public BenchmarkListener {
  public:
   ProfilingListener(
       Interpreter* interpreter, uint32_t max_num_entries,
       const std::string& csv_file_path = "",
       std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter =
-          std::make_shared<profiling::ProfileSummaryDefaultFormatter>());
+          std::make_shared<profiling::ProfileSummaryDefaultFormatter>(),
+      bool enable_perf_event_profiling = false);
 
   void OnBenchmarkStart(const BenchmarkParams& params) override;
 
@@ -53,6 +57,8 @@ class ProfilingListener : public BenchmarkListener {
                    std::ostream* stream);
   Interpreter* interpreter_;
   profiling::BufferedProfiler profiler_;
+  // Wraps profiler_ if perf event profiling is enabled and available.
+  std::unique_ptr<profiling::PerfEventProfiler> perf_event_profiler_;
 };
 
 }  // namespace benchmark